@@ -0,0 +1,116 @@
+#ifndef RXREVOLTCHAIN_BENCH_BENCH_HPP
+#define RXREVOLTCHAIN_BENCH_BENCH_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @file bench.hpp
+ * @brief Minimal microbenchmark registry used by the rxrevolt_bench executable.
+ *
+ * DESIGN:
+ *   - Each benchmark is a callable taking a State. It runs its measured operation
+ *     state.iterations times and may set state.bytesPerIteration for throughput output.
+ *   - The runner (bench_main.cpp) doubles the iteration count until one run takes at least
+ *     the minimum measuring time, then reports ns/op and MB/s for that run.
+ *   - The runner replaces global operator new, so benchmarks can read allocationCount() /
+ *     allocatedBytes() around their loop and report per-item figures via state.counters.
+ *   - Benchmarks register themselves from static initializers, either with
+ *     RXREVOLT_BENCHMARK(name) or with registerBenchmark() when the set of cases is only
+ *     known at runtime (e.g. one case per available hashing backend).
+ *   - A benchmark that needs untimed setup inside its loop (queueing documents before a
+ *     merge, collecting responses before a validation) times the measured part itself and
+ *     stores it in state.measuredSeconds; the runner then uses that instead of wall time.
+ *   - Benchmarks that work on synthetic data size it from dataset() (set by --dataset, see
+ *     datasets.hpp), so one binary covers the quick default and the release-sized runs.
+ *
+ * USAGE:
+ *   @code
+ *   RXREVOLT_BENCHMARK(Sha256_64B) {
+ *       state.bytesPerIteration = 64;
+ *       for (size_t i = 0; i < state.iterations; ++i) { ... }
+ *   }
+ *   @endcode
+ */
+
+namespace rxrevoltchain {
+namespace bench {
+
+/** Per-run parameters and results shared between the runner and a benchmark. */
+struct State {
+    size_t iterations = 1;         ///< Number of operations to run
+    uint64_t bytesPerIteration = 0; ///< Bytes processed per operation (0 = no throughput)
+    std::vector<std::pair<std::string, double>> counters; ///< Extra columns, e.g. allocs/doc
+    double measuredSeconds = 0.0; ///< Self-timed part of the run (0 = the whole run)
+};
+
+/** Size of the synthetic datasets, chosen on the command line (--dataset, --seed). */
+struct Dataset {
+    std::string name = "10k";           ///< Preset name, reported with the results
+    size_t documents = 10000;           ///< Documents in the generated snapshot database
+    uint64_t snapshotBytes = 100000000; ///< Size of the generated snapshot file
+    uint64_t seed = 1;                  ///< Seed of every generator, for reproducible data
+    std::string dataDir = "/tmp";       ///< Where generated files are written
+};
+
+/** The dataset of this run. */
+inline Dataset& dataset() {
+    static Dataset current;
+    return current;
+}
+
+/** One registered benchmark. */
+struct Benchmark {
+    std::string name;
+    std::function<void(State&)> fn;
+};
+
+/** All registered benchmarks, in registration order. */
+inline std::vector<Benchmark>& registry() {
+    static std::vector<Benchmark> benchmarks;
+    return benchmarks;
+}
+
+/** Adds a benchmark to the registry. */
+inline void registerBenchmark(std::string name, std::function<void(State&)> fn) {
+    registry().push_back(Benchmark{std::move(name), std::move(fn)});
+}
+
+/** Registers a benchmark from a static initializer. */
+struct Registrar {
+    Registrar(const char* name, void (*fn)(State&)) { registerBenchmark(name, fn); }
+};
+
+/** Global operator new calls since program start (counted by bench_main.cpp). */
+inline std::atomic<uint64_t>& allocationCount() {
+    static std::atomic<uint64_t> count{0};
+    return count;
+}
+
+/** Bytes requested from global operator new since program start. */
+inline std::atomic<uint64_t>& allocatedBytes() {
+    static std::atomic<uint64_t> bytes{0};
+    return bytes;
+}
+
+/**
+ * Keeps the compiler from discarding a computed value in a benchmark loop.
+ */
+template <typename T> inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+} // namespace bench
+} // namespace rxrevoltchain
+
+#define RXREVOLT_BENCHMARK(name)                                                                 \
+    static void name(::rxrevoltchain::bench::State& state);                                      \
+    static ::rxrevoltchain::bench::Registrar name##_registrar(#name, name);                      \
+    static void name(::rxrevoltchain::bench::State& state)
+
+#endif // RXREVOLTCHAIN_BENCH_BENCH_HPP
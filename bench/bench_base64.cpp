@@ -0,0 +1,51 @@
+// bench/bench_base64.cpp
+// -----------------------------------------------------------
+// Base64 encoding of record payloads (HttpQueryServer /record and /records): the SSSE3
+// kernel against the scalar table loop, on a small document and a large export buffer.
+
+#include "bench.hpp"
+
+#include "util/base64.hpp"
+
+#include <string>
+#include <vector>
+
+namespace {
+
+namespace base64 = rxrevoltchain::util::base64;
+using rxrevoltchain::bench::State;
+using rxrevoltchain::bench::doNotOptimize;
+
+void encodeBenchmark(State& state, base64::Backend backend, size_t size) {
+    std::vector<uint8_t> input(size);
+    for (size_t i = 0; i < size; ++i) {
+        input[i] = static_cast<uint8_t>(i * 131 + (i >> 7));
+    }
+    std::string out(base64::encodedSize(size), '\0');
+    const base64::Backend previous = base64::backend();
+    base64::setBackend(backend);
+    for (size_t i = 0; i < state.iterations; ++i) {
+        base64::encode(input.data(), size, &out[0]);
+        doNotOptimize(out[0]);
+    }
+    base64::setBackend(previous);
+    state.bytesPerIteration = size;
+}
+
+const bool registered = [] {
+    for (auto backend : {base64::Backend::Scalar, base64::Backend::Ssse3}) {
+        if (!base64::backendAvailable(backend)) {
+            continue;
+        }
+        const std::string suffix = backend == base64::Backend::Ssse3 ? "/ssse3" : "/scalar";
+        rxrevoltchain::bench::registerBenchmark(
+            "Base64Encode/1KiB" + suffix,
+            [backend](State& s) { encodeBenchmark(s, backend, 1024); });
+        rxrevoltchain::bench::registerBenchmark(
+            "Base64Encode/1MiB" + suffix,
+            [backend](State& s) { encodeBenchmark(s, backend, 1 << 20); });
+    }
+    return true;
+}();
+
+} // namespace
@@ -0,0 +1,141 @@
+// bench/bench_document_path.cpp
+// -----------------------------------------------------------
+// Follows a document from submission to SQLite: Transaction -> DocumentQueue (WAL with
+// fsync disabled) -> FetchAll -> in-place PII redaction -> DailySnapshot insert.
+// Reports heap allocations and allocated bytes per document, so extra payload copies show
+// up directly as multiples of the payload size in bytes/doc. SnapshotMerge measures the
+// queue -> SQLite merge throughput on its own, for the documents of the --dataset, into
+// one database or into a ShardedSnapshot of four shards merged in parallel.
+
+#include "bench.hpp"
+#include "datasets.hpp"
+
+#include "core/daily_snapshot.hpp"
+#include "core/document_queue.hpp"
+#include "core/privacy_manager.hpp"
+#include "core/sharded_snapshot.hpp"
+#include "core/transaction.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using namespace rxrevoltchain;
+using bench::State;
+
+constexpr size_t kDocsPerIteration = 64;
+
+void documentPathBenchmark(State& state, size_t payloadSize) {
+    const std::string base = "/tmp/rxrevolt_bench_docpath_" + std::to_string(::getpid());
+    const std::string walFile = base + ".wal";
+    const std::string dbFile = base + ".sqlite";
+    std::remove(walFile.c_str());
+    std::remove(dbFile.c_str());
+
+    uint64_t allocs = 0;
+    uint64_t bytes = 0;
+    {
+        core::DocumentQueue queue(walFile);
+        core::WriteAheadLog::Options options;
+        options.policy = core::WriteAheadLog::FsyncPolicy::None;
+        queue.SetWalOptions(options);
+        core::PrivacyManager privacy;
+        core::DailySnapshot snapshot(dbFile);
+        snapshot.SetDocumentQueue(&queue);
+        snapshot.SetPrivacyManager(&privacy);
+
+        const std::vector<uint8_t> source(payloadSize, 'a');
+        for (size_t i = 0; i < state.iterations; ++i) {
+            const uint64_t allocsBefore = bench::allocationCount().load();
+            const uint64_t bytesBefore = bench::allocatedBytes().load();
+            for (size_t d = 0; d < kDocsPerIteration; ++d) {
+                core::Transaction tx;
+                tx.SetType("document_submission");
+                tx.SetMetadata("{\"doc\":" + std::to_string(d) + "}");
+                tx.SetPayload(std::vector<uint8_t>(source)); // the one intended payload copy
+                queue.AddTransaction(std::move(tx));
+            }
+            snapshot.MergePendingDocuments();
+            allocs += bench::allocationCount().load() - allocsBefore;
+            bytes += bench::allocatedBytes().load() - bytesBefore;
+        }
+    } // closes the database before its files are removed
+
+    const double docs = static_cast<double>(state.iterations * kDocsPerIteration);
+    state.bytesPerIteration = payloadSize * kDocsPerIteration;
+    state.counters = {{"allocs/doc", allocs / docs},
+                      {"bytes/doc", bytes / docs},
+                      {"payload_copies/doc", bytes / docs / static_cast<double>(payloadSize)}};
+    std::remove(walFile.c_str());
+    std::remove(dbFile.c_str());
+}
+
+// Merge throughput without redaction: the dataset's documents (10k by default) are queued
+// and merged per iteration into one growing database, in batches of at most kMergeBatch
+// so the queue stays bounded at the larger presets. Only MergePendingDocuments is timed.
+// With 'shards' > 1 the documents go to a ShardedSnapshot in a directory of their own.
+void mergeBenchmark(State& state, size_t payloadSize, size_t shards) {
+    constexpr size_t kMergeBatch = 50000;
+    const std::string base = bench::dataPath("merge");
+    const std::string walFile = base + ".wal";
+    const std::string dbFile = base + ".sqlite";
+    const std::string shardDir = base + ".shards";
+    std::remove(walFile.c_str());
+    std::remove(dbFile.c_str());
+    std::filesystem::remove_all(shardDir);
+
+    const size_t docs = bench::dataset().documents;
+    std::chrono::steady_clock::duration mergeTime{};
+    {
+        core::DocumentQueue queue(walFile);
+        core::WriteAheadLog::Options options;
+        options.policy = core::WriteAheadLog::FsyncPolicy::None;
+        queue.SetWalOptions(options);
+        std::unique_ptr<core::DailySnapshot> single;
+        std::unique_ptr<core::ShardedSnapshot> sharded;
+        if (shards > 1) {
+            std::filesystem::create_directories(shardDir);
+            sharded.reset(new core::ShardedSnapshot(shardDir, shards));
+            sharded->SetDocumentQueue(&queue);
+        } else {
+            single.reset(new core::DailySnapshot(dbFile));
+            single->SetDocumentQueue(&queue);
+        }
+
+        bench::Rng rng(bench::dataset().seed);
+        for (size_t i = 0; i < state.iterations; ++i) {
+            for (size_t done = 0; done < docs;) {
+                const size_t n = std::min(kMergeBatch, docs - done);
+                for (size_t d = 0; d < n; ++d) {
+                    queue.AddTransaction(bench::makeDocument(rng, done + d, payloadSize));
+                }
+                auto start = std::chrono::steady_clock::now();
+                sharded ? sharded->MergePendingDocuments() : single->MergePendingDocuments();
+                mergeTime += std::chrono::steady_clock::now() - start;
+                done += n;
+            }
+        }
+    }
+    state.bytesPerIteration = docs * payloadSize;
+    state.measuredSeconds = std::chrono::duration<double>(mergeTime).count();
+    state.counters = {{"merged_docs/s", docs * state.iterations / state.measuredSeconds}};
+    std::remove(walFile.c_str());
+    std::remove(dbFile.c_str());
+    std::filesystem::remove_all(shardDir);
+}
+
+} // namespace
+
+RXREVOLT_BENCHMARK(DocumentPath_16KiB) { documentPathBenchmark(state, 16 * 1024); }
+
+RXREVOLT_BENCHMARK(SnapshotMerge_256B) { mergeBenchmark(state, 256, 1); }
+
+RXREVOLT_BENCHMARK(SnapshotMerge_256B_4Shards) { mergeBenchmark(state, 256, 4); }
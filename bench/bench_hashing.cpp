@@ -0,0 +1,89 @@
+// bench/bench_hashing.cpp
+// -----------------------------------------------------------
+// SHA-256 microbenchmarks: compares the sha256Batch / sha256Raw backends with each other
+// and with the hex-string hashing::sha256 path the merkle code used to run per node.
+
+#include "bench.hpp"
+
+#include "util/hashing.hpp"
+
+#include <string>
+#include <vector>
+
+namespace {
+
+namespace hashing = rxrevoltchain::util::hashing;
+using rxrevoltchain::bench::State;
+using rxrevoltchain::bench::doNotOptimize;
+
+std::vector<uint8_t> makeInput(size_t size) {
+    std::vector<uint8_t> data(size);
+    for (size_t i = 0; i < size; ++i) {
+        data[i] = static_cast<uint8_t>(i * 131 + (i >> 9));
+    }
+    return data;
+}
+
+// Hashes 'count' chunks of 'chunkSize' bytes per iteration with the given backend.
+void batchBenchmark(State& state, hashing::Sha256Backend backend, size_t chunkSize,
+                    size_t count) {
+    static const std::vector<uint8_t> input = makeInput(1 << 21);
+    std::vector<uint8_t> out(count * 32);
+    hashing::Sha256Backend previous = hashing::sha256Backend();
+    hashing::setSha256Backend(backend);
+    for (size_t i = 0; i < state.iterations; ++i) {
+        hashing::sha256Batch(input.data(), chunkSize, count, out.data());
+        doNotOptimize(out[0]);
+    }
+    hashing::setSha256Backend(previous);
+    state.bytesPerIteration = chunkSize * count;
+}
+
+// Hashes one 'size'-byte message per iteration into a raw digest.
+void rawBenchmark(State& state, hashing::Sha256Backend backend, size_t size) {
+    static const std::vector<uint8_t> input = makeInput(1 << 16);
+    hashing::Sha256Backend previous = hashing::sha256Backend();
+    hashing::setSha256Backend(backend);
+    for (size_t i = 0; i < state.iterations; ++i) {
+        hashing::Digest d = hashing::sha256Raw(input.data(), size);
+        doNotOptimize(d);
+    }
+    hashing::setSha256Backend(previous);
+    state.bytesPerIteration = size;
+}
+
+// One case per available backend: 4 KiB merkle leaves, 64-byte v2 parents and
+// 128-byte v1 (hex text) parents.
+const bool registered = [] {
+    for (auto backend : {hashing::Sha256Backend::OpenSSL, hashing::Sha256Backend::ShaNi,
+                         hashing::Sha256Backend::Avx2}) {
+        if (!hashing::sha256BackendAvailable(backend)) {
+            continue;
+        }
+        std::string suffix = std::string("/") + hashing::sha256BackendName(backend);
+        rxrevoltchain::bench::registerBenchmark(
+            "Sha256Batch/4KiB_x256" + suffix,
+            [backend](State& s) { batchBenchmark(s, backend, 4096, 256); });
+        rxrevoltchain::bench::registerBenchmark(
+            "Sha256Batch/64B_x4096" + suffix,
+            [backend](State& s) { batchBenchmark(s, backend, 64, 4096); });
+        rxrevoltchain::bench::registerBenchmark(
+            "Sha256Batch/128B_x4096" + suffix,
+            [backend](State& s) { batchBenchmark(s, backend, 128, 4096); });
+        rxrevoltchain::bench::registerBenchmark(
+            "Sha256Raw/64B" + suffix, [backend](State& s) { rawBenchmark(s, backend, 64); });
+    }
+    return true;
+}();
+
+} // namespace
+
+// Baseline: the hex-string API, which allocates a string per digest.
+RXREVOLT_BENCHMARK(Sha256Hex_64B) {
+    std::vector<uint8_t> input = makeInput(64);
+    for (size_t i = 0; i < state.iterations; ++i) {
+        std::string hex = hashing::sha256(input);
+        doNotOptimize(hex);
+    }
+    state.bytesPerIteration = 64;
+}
@@ -0,0 +1,126 @@
+// bench/bench_http.cpp
+// -----------------------------------------------------------
+// HttpQueryServer requests per second over the dataset's document database (10k
+// documents by default): C client threads, each on its own keep-alive connection, send one
+// request at a time for records with seeded random ids (served from the record cache once
+// warm) or a full-text search for one of the procedure words. Building the database and
+// starting the server are not timed.
+
+#include "bench.hpp"
+#include "datasets.hpp"
+
+#include "network/http_query_server.hpp"
+
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+using rxrevoltchain::bench::State;
+
+enum class Query { Record, Search };
+
+// Reads one response with a Content-Length body from 'fd'; false on EOF or a non-200
+bool readResponse(int fd, std::string& buffer) {
+    char chunk[16384];
+    for (;;) {
+        const size_t headerEnd = buffer.find("\r\n\r\n");
+        const size_t lengthPos = buffer.find("Content-Length: ");
+        if (headerEnd != std::string::npos && lengthPos < headerEnd) {
+            const size_t total = headerEnd + 4 + std::stoul(buffer.substr(lengthPos + 16));
+            if (buffer.size() >= total) {
+                const bool ok = buffer.rfind("HTTP/1.1 200", 0) == 0;
+                buffer.erase(0, total);
+                return ok;
+            }
+        }
+        const ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) {
+            return false;
+        }
+        buffer.append(chunk, static_cast<size_t>(n));
+    }
+}
+
+void clientLoop(int port, Query query, size_t requests, uint64_t seed,
+                std::atomic<size_t>& errors) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        errors += requests;
+        ::close(fd);
+        return;
+    }
+    const auto& words = rxrevoltchain::bench::procedureWords();
+    const size_t documents = rxrevoltchain::bench::dataset().documents;
+    rxrevoltchain::bench::Rng rng(seed);
+    std::string buffer;
+    for (size_t i = 0; i < requests; ++i) {
+        const std::string target =
+            query == Query::Record
+                ? "/record/" + std::to_string(1 + rng.uniform(documents))
+                : "/search?q=" + words[rng.uniform(words.size())] + "&limit=20";
+        const std::string request =
+            "GET " + target + " HTTP/1.1\r\nHost: bench\r\nConnection: keep-alive\r\n\r\n";
+        if (::send(fd, request.data(), request.size(), MSG_NOSIGNAL) !=
+                static_cast<ssize_t>(request.size()) ||
+            !readResponse(fd, buffer)) {
+            errors += requests - i;
+            break;
+        }
+    }
+    ::close(fd);
+}
+
+void httpBenchmark(State& state, Query query, size_t clients) {
+    rxrevoltchain::network::HttpQueryServer server(rxrevoltchain::bench::documentDatabase(), 0);
+    server.SetWorkerThreads(clients);
+    server.SetKeepAliveTimeout(60000);
+    if (!server.Start()) {
+        std::fprintf(stderr, "HttpQueryServer: cannot start\n");
+        return;
+    }
+
+    std::atomic<size_t> errors{0};
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t c = 0; c < clients; ++c) {
+        const size_t share = state.iterations / clients + (c < state.iterations % clients);
+        threads.emplace_back(clientLoop, server.Port(), query, share,
+                             rxrevoltchain::bench::dataset().seed + c, std::ref(errors));
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    state.measuredSeconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    state.counters = {{"requests/s", state.iterations / state.measuredSeconds},
+                      {"errors", static_cast<double>(errors.load())}};
+    server.Stop();
+}
+
+const bool registered = [] {
+    for (size_t clients : {size_t(1), size_t(4)}) {
+        const std::string suffix = "/" + std::to_string(clients) + "-clients";
+        rxrevoltchain::bench::registerBenchmark(
+            "HttpQueryServer/record" + suffix,
+            [clients](State& s) { httpBenchmark(s, Query::Record, clients); });
+        rxrevoltchain::bench::registerBenchmark(
+            "HttpQueryServer/search" + suffix,
+            [clients](State& s) { httpBenchmark(s, Query::Search, clients); });
+    }
+    return true;
+}();
+
+} // namespace
@@ -0,0 +1,212 @@
+// bench/bench_main.cpp
+// -----------------------------------------------------------
+// Runs the microbenchmarks registered through bench.hpp.
+//
+// Usage: rxrevolt_bench [--min-time=SECONDS] [--dataset=10k|1m|10m] [--seed=N]
+//                       [--data-dir=DIR] [--json=FILE] [FILTER...]
+//   --dataset   Size of the synthetic data (see datasets.hpp); default 10k.
+//   --seed      Seed of the data generators; default 1.
+//   --data-dir  Where generated snapshots and databases go; default /tmp.
+//   --json      Also write the results to FILE as JSON, for tracking across releases.
+//   FILTER      Run only benchmarks whose name contains one of the given substrings.
+
+#include "bench.hpp"
+#include "datasets.hpp"
+
+#include "util/logger.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <new>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#ifndef RXREVOLT_VERSION
+#define RXREVOLT_VERSION "unknown"
+#endif
+#ifndef RXREVOLT_BUILD_TYPE
+#define RXREVOLT_BUILD_TYPE "unknown"
+#endif
+
+// Counting allocator behind bench::allocationCount(); aligned and nothrow forms fall back
+// to these through the standard library's default implementations.
+void* operator new(std::size_t size) {
+    rxrevoltchain::bench::allocationCount().fetch_add(1, std::memory_order_relaxed);
+    rxrevoltchain::bench::allocatedBytes().fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+
+using rxrevoltchain::bench::Benchmark;
+using rxrevoltchain::bench::State;
+
+/** Outcome of one benchmark, as printed and written to the JSON report. */
+struct Result {
+    std::string name;
+    State state;
+    double seconds = 0.0;
+};
+
+// Runs one benchmark, doubling the iteration count until a run lasts at least minSeconds.
+Result runBenchmark(const Benchmark& bench, double minSeconds) {
+    State state;
+    double seconds = 0.0;
+    for (;;) {
+        State run;
+        run.iterations = state.iterations;
+        auto start = std::chrono::steady_clock::now();
+        bench.fn(run);
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (run.measuredSeconds > 0.0) {
+            seconds = run.measuredSeconds;
+        }
+        state.bytesPerIteration = run.bytesPerIteration;
+        state.counters = run.counters;
+        if (seconds >= minSeconds || state.iterations >= (size_t(1) << 40)) {
+            break;
+        }
+        state.iterations *= 2;
+    }
+
+    double nsPerOp = seconds * 1e9 / static_cast<double>(state.iterations);
+    std::printf("%-48s %12zu %14.1f", bench.name.c_str(), state.iterations, nsPerOp);
+    if (state.bytesPerIteration) {
+        double mbPerSec =
+            static_cast<double>(state.bytesPerIteration) * state.iterations / seconds / 1e6;
+        std::printf(" %12.1f", mbPerSec);
+    }
+    for (const auto& counter : state.counters) {
+        std::printf("  %s=%.2f", counter.first.c_str(), counter.second);
+    }
+    std::printf("\n");
+    std::fflush(stdout);
+    return Result{bench.name, state, seconds};
+}
+
+std::string jsonString(const std::string& text) {
+    std::string out = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out += escaped;
+        } else {
+            out += c;
+        }
+    }
+    return out + "\"";
+}
+
+std::string jsonNumber(double value) {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.6g", value);
+    return text;
+}
+
+// Writes the run's context (version, machine, dataset) and every result to 'path'
+bool writeJson(const std::string& path, const std::vector<Result>& results, double minSeconds) {
+    const auto& data = rxrevoltchain::bench::dataset();
+    char host[256] = {};
+    ::gethostname(host, sizeof(host) - 1);
+    char date[32];
+    const std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+    std::ofstream out(path, std::ios::trunc);
+    out << "{\n  \"context\": {\n"
+        << "    \"date\": " << jsonString(date) << ",\n"
+        << "    \"version\": " << jsonString(RXREVOLT_VERSION) << ",\n"
+        << "    \"build_type\": " << jsonString(RXREVOLT_BUILD_TYPE) << ",\n"
+        << "    \"host\": " << jsonString(host) << ",\n"
+        << "    \"cpus\": " << std::thread::hardware_concurrency() << ",\n"
+        << "    \"min_time\": " << jsonNumber(minSeconds) << ",\n"
+        << "    \"dataset\": " << jsonString(data.name) << ",\n"
+        << "    \"documents\": " << data.documents << ",\n"
+        << "    \"snapshot_bytes\": " << data.snapshotBytes << ",\n"
+        << "    \"seed\": " << data.seed << "\n  },\n  \"benchmarks\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        const double iterations = static_cast<double>(r.state.iterations);
+        out << (i ? "," : "") << "\n    {\"name\": " << jsonString(r.name)
+            << ", \"iterations\": " << r.state.iterations
+            << ", \"ns_per_op\": " << jsonNumber(r.seconds * 1e9 / iterations);
+        if (r.state.bytesPerIteration) {
+            out << ", \"mb_per_s\": "
+                << jsonNumber(static_cast<double>(r.state.bytesPerIteration) * iterations /
+                              r.seconds / 1e6);
+        }
+        out << ", \"counters\": {";
+        for (size_t c = 0; c < r.state.counters.size(); ++c) {
+            out << (c ? ", " : "") << jsonString(r.state.counters[c].first) << ": "
+                << jsonNumber(r.state.counters[c].second);
+        }
+        out << "}}";
+    }
+    out << "\n  ]\n}\n";
+    return static_cast<bool>(out);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    double minSeconds = 0.25;
+    std::string jsonPath;
+    std::vector<std::string> filters;
+    auto& data = rxrevoltchain::bench::dataset();
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--min-time=", 0) == 0) {
+            minSeconds = std::atof(arg.c_str() + 11);
+        } else if (arg.rfind("--dataset=", 0) == 0) {
+            if (!rxrevoltchain::bench::applyPreset(arg.substr(10))) {
+                std::fprintf(stderr, "unknown dataset '%s' (10k, 1m or 10m)\n", arg.c_str() + 10);
+                return 1;
+            }
+        } else if (arg.rfind("--seed=", 0) == 0) {
+            data.seed = std::strtoull(arg.c_str() + 7, nullptr, 10);
+        } else if (arg.rfind("--data-dir=", 0) == 0) {
+            data.dataDir = arg.substr(11);
+        } else if (arg.rfind("--json=", 0) == 0) {
+            jsonPath = arg.substr(7);
+        } else {
+            filters.push_back(arg);
+        }
+    }
+
+    // Log lines would interleave with the table and dominate the timed paths
+    rxrevoltchain::util::logger::Logger::getInstance().setLogLevel(
+        rxrevoltchain::util::logger::LogLevel::WARN);
+
+    std::printf("%-48s %12s %14s %12s\n", "benchmark", "iterations", "ns/op", "MB/s");
+    std::vector<Result> results;
+    for (const auto& bench : rxrevoltchain::bench::registry()) {
+        bool selected = filters.empty();
+        for (const auto& f : filters) {
+            selected = selected || bench.name.find(f) != std::string::npos;
+        }
+        if (selected) {
+            results.push_back(runBenchmark(bench, minSeconds));
+        }
+    }
+    if (!jsonPath.empty() && !writeJson(jsonPath, results, minSeconds)) {
+        std::fprintf(stderr, "cannot write %s\n", jsonPath.c_str());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,96 @@
+// bench/bench_merkle.cpp
+// -----------------------------------------------------------
+// MerkleProof latency on the dataset's snapshot file (100 MB by default): a 6-leaf
+// GenerateProof that streams and hashes the whole file, the same proof from a pre-built
+// tree (what a node answering challenges does), and VerifyProof of such a proof, in both
+// tree formats. Leaf choices come from the dataset seed, so runs are comparable.
+
+#include "bench.hpp"
+#include "datasets.hpp"
+
+#include "ipfs_integration/merkle_proof.hpp"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace {
+
+using rxrevoltchain::bench::State;
+using rxrevoltchain::bench::doNotOptimize;
+using rxrevoltchain::ipfs_integration::MerkleFormat;
+using rxrevoltchain::ipfs_integration::MerkleProof;
+
+constexpr size_t kLeaves = 6; // the largest PoP challenge
+constexpr size_t kChallenges = 64;
+
+std::vector<std::vector<size_t>> makeChallenges(size_t leafCount) {
+    rxrevoltchain::bench::Rng rng(rxrevoltchain::bench::dataset().seed);
+    std::vector<std::vector<size_t>> challenges;
+    for (size_t i = 0; i < kChallenges; ++i) {
+        challenges.push_back(rxrevoltchain::bench::challengeLeaves(rng, leafCount, kLeaves));
+    }
+    return challenges;
+}
+
+// The loops below are timed on their own: the first run generates the snapshot and its
+// tree, which would otherwise count as that run's first iteration
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void streamingBenchmark(State& state, MerkleFormat format) {
+    const std::string& file = rxrevoltchain::bench::snapshotFile();
+    const uint64_t bytes = rxrevoltchain::bench::dataset().snapshotBytes;
+    const auto challenges = makeChallenges(bytes / MerkleProof::DEFAULT_CHUNK_SIZE);
+    MerkleProof merkle;
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < state.iterations; ++i) {
+        auto proof = merkle.GenerateProof(file, challenges[i % kChallenges], format);
+        doNotOptimize(proof.data());
+    }
+    state.measuredSeconds = secondsSince(start);
+    state.bytesPerIteration = bytes;
+}
+
+void cachedTreeBenchmark(State& state, MerkleFormat format, bool verify) {
+    const std::string& file = rxrevoltchain::bench::snapshotFile();
+    MerkleProof merkle;
+    const auto tree = rxrevoltchain::bench::snapshotTree(format);
+    const auto challenges = makeChallenges(tree->LeafCount());
+    std::vector<std::vector<uint8_t>> proofs;
+    if (verify) {
+        for (const auto& leaves : challenges) {
+            proofs.push_back(merkle.GenerateProof(file, leaves, *tree));
+        }
+    }
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < state.iterations; ++i) {
+        if (verify) {
+            doNotOptimize(merkle.VerifyProof(proofs[i % kChallenges]));
+        } else {
+            auto proof = merkle.GenerateProof(file, challenges[i % kChallenges], *tree);
+            doNotOptimize(proof.data());
+        }
+    }
+    state.measuredSeconds = secondsSince(start);
+    state.bytesPerIteration = kLeaves * MerkleProof::DEFAULT_CHUNK_SIZE;
+}
+
+const bool registered = [] {
+    for (auto format : {MerkleFormat::LegacyHex, MerkleFormat::Binary}) {
+        const std::string suffix = format == MerkleFormat::LegacyHex ? "/v1" : "/v2";
+        rxrevoltchain::bench::registerBenchmark(
+            "MerkleProof/GenerateProof/streaming" + suffix,
+            [format](State& s) { streamingBenchmark(s, format); });
+        rxrevoltchain::bench::registerBenchmark(
+            "MerkleProof/GenerateProof/cached-tree" + suffix,
+            [format](State& s) { cachedTreeBenchmark(s, format, false); });
+        rxrevoltchain::bench::registerBenchmark(
+            "MerkleProof/VerifyProof" + suffix,
+            [format](State& s) { cachedTreeBenchmark(s, format, true); });
+    }
+    return true;
+}();
+
+} // namespace
@@ -0,0 +1,122 @@
+// bench/bench_p2p.cpp
+// -----------------------------------------------------------
+// Message throughput among N P2PNodes on loopback, fully meshed: per iteration every node
+// broadcasts one 1 KiB SNAPSHOT_CHUNK_RESPONSE frame (snapshot sync traffic, the bulk of
+// what nodes exchange). Senders keep at most kWindow frames per peer in flight, well
+// below the outbound queue limit, so no peer is dropped as slow; the run ends once every
+// frame arrived. Setting up the mesh is not timed.
+
+#include "bench.hpp"
+
+#include "network/p2p_node.hpp"
+#include "network/protocol_messages.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using rxrevoltchain::bench::State;
+using rxrevoltchain::network::P2PNode;
+using rxrevoltchain::network::ProtocolMessage;
+
+constexpr uint16_t kBasePort = 39600;
+constexpr uint64_t kWindow = 256;
+constexpr size_t kPayload = 1024;
+
+bool waitUntil(const std::function<bool()>& done, std::chrono::seconds timeout) {
+    const auto until = std::chrono::steady_clock::now() + timeout;
+    while (!done()) {
+        if (std::chrono::steady_clock::now() > until) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+void meshBenchmark(State& state, size_t nodeCount) {
+    std::mutex mutex;
+    std::condition_variable delivered;
+    std::atomic<uint64_t> received{0};
+    std::vector<std::unique_ptr<P2PNode>> nodes;
+    for (size_t n = 0; n < nodeCount; ++n) {
+        nodes.emplace_back(new P2PNode());
+        nodes.back()->SetMessageCallback([&](const ProtocolMessage&) {
+            received.fetch_add(1);
+            { std::lock_guard<std::mutex> lock(mutex); }
+            delivered.notify_one();
+        });
+        if (!nodes.back()->StartNetwork("127.0.0.1", static_cast<uint16_t>(kBasePort + n))) {
+            std::fprintf(stderr, "P2PNode mesh: cannot listen on port %zu\n", kBasePort + n);
+            return;
+        }
+    }
+    for (size_t a = 0; a < nodeCount; ++a) {
+        for (size_t b = a + 1; b < nodeCount; ++b) {
+            nodes[a]->ConnectToPeer("127.0.0.1", static_cast<uint16_t>(kBasePort + b));
+        }
+    }
+    const bool meshed = waitUntil(
+        [&] {
+            for (const auto& node : nodes) {
+                if (node->PeerCount() != nodeCount - 1) {
+                    return false;
+                }
+            }
+            return true;
+        },
+        std::chrono::seconds(10));
+
+    ProtocolMessage msg;
+    msg.type = rxrevoltchain::network::SNAPSHOT_CHUNK_RESPONSE;
+    msg.payload.assign(kPayload, 0x5A);
+    const uint64_t perIteration = nodeCount * (nodeCount - 1);
+    auto arrived = [&](uint64_t target) {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (delivered.wait_for(lock, std::chrono::seconds(10),
+                               [&] { return received.load() >= target; })) {
+            return true;
+        }
+        std::fprintf(stderr, "P2PNode mesh: messages lost, stopping\n");
+        return false;
+    };
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; meshed && i < state.iterations; ++i) {
+        if (i >= kWindow && !arrived(perIteration * (i - kWindow / 2))) {
+            break;
+        }
+        for (const auto& node : nodes) {
+            node->BroadcastMessage(msg);
+        }
+        if (i + 1 == state.iterations && !arrived(perIteration * state.iterations)) {
+            break;
+        }
+    }
+    state.measuredSeconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    state.bytesPerIteration = perIteration * kPayload;
+    state.counters = {{"msgs/s", received.load() / state.measuredSeconds}};
+    for (const auto& node : nodes) {
+        node->StopNetwork();
+    }
+}
+
+const bool registered = [] {
+    for (size_t nodes : {size_t(2), size_t(4), size_t(8)}) {
+        rxrevoltchain::bench::registerBenchmark(
+            "P2PNode/MeshBroadcast/" + std::to_string(nodes) + "-nodes/1KiB",
+            [nodes](State& s) { meshBenchmark(s, nodes); });
+    }
+    return true;
+}();
+
+} // namespace
@@ -0,0 +1,63 @@
+// bench/bench_pop.cpp
+// -----------------------------------------------------------
+// One PoPConsensus round on the dataset's snapshot with N responding nodes: challenges
+// are issued and every node's proof is collected untimed, then ValidateResponses checks
+// them. One node in eight answers with a corrupted chunk, so the failing path is
+// exercised too.
+
+#include "bench.hpp"
+#include "datasets.hpp"
+
+#include "consensus/pop_consensus.hpp"
+#include "ipfs_integration/merkle_proof.hpp"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace {
+
+using rxrevoltchain::bench::State;
+using rxrevoltchain::bench::doNotOptimize;
+using rxrevoltchain::ipfs_integration::MerkleFormat;
+
+void validateBenchmark(State& state, size_t nodes) {
+    const std::string& file = rxrevoltchain::bench::snapshotFile();
+    const auto tree = rxrevoltchain::bench::snapshotTree(MerkleFormat::LegacyHex);
+    std::vector<std::string> nodeIDs;
+    for (size_t n = 0; n < nodes; ++n) {
+        nodeIDs.push_back("node" + std::to_string(n));
+    }
+
+    rxrevoltchain::consensus::PoPConsensus pop;
+    rxrevoltchain::ipfs_integration::MerkleProof merkle;
+    std::chrono::steady_clock::duration validateTime{};
+    size_t passed = 0;
+    for (size_t i = 0; i < state.iterations; ++i) {
+        pop.IssueChallenges("bench-snapshot", file);
+        const auto proof = merkle.GenerateProof(file, pop.GetCurrentOffsets(), *tree);
+        std::vector<uint8_t> corrupt = proof;
+        corrupt[corrupt.size() / 2] ^= 0x01;
+        for (size_t n = 0; n < nodes; ++n) {
+            pop.CollectResponse(nodeIDs[n], n % 8 == 7 ? corrupt : proof);
+        }
+        auto start = std::chrono::steady_clock::now();
+        doNotOptimize(pop.ValidateResponses());
+        validateTime += std::chrono::steady_clock::now() - start;
+        passed += pop.GetPassingNodes().size();
+    }
+    state.measuredSeconds = std::chrono::duration<double>(validateTime).count();
+    state.counters = {{"responses/s", nodes * state.iterations / state.measuredSeconds},
+                      {"passed/round", static_cast<double>(passed) / state.iterations}};
+}
+
+const bool registered = [] {
+    for (size_t nodes : {size_t(16), size_t(128), size_t(1024)}) {
+        rxrevoltchain::bench::registerBenchmark(
+            "PoPConsensus/ValidateResponses/" + std::to_string(nodes) + "-nodes",
+            [nodes](State& s) { validateBenchmark(s, nodes); });
+    }
+    return true;
+}();
+
+} // namespace
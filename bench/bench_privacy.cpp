@@ -0,0 +1,97 @@
+// bench/bench_privacy.cpp
+// -----------------------------------------------------------
+// PII redaction plus the suspicious-keyword check, as DailySnapshot runs them on every
+// submission: the two std::regex passes PrivacyManager used to make against the
+// single-pass scanner (scalar and AVX2 prefilter), on a JSON cost document with a few
+// phone numbers and SSNs and on one without any PII.
+
+#include "bench.hpp"
+
+#include "core/privacy_manager.hpp"
+#include "util/pii_scanner.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <regex>
+#include <string>
+#include <vector>
+
+namespace {
+
+namespace pii = rxrevoltchain::util::pii;
+using rxrevoltchain::bench::State;
+using rxrevoltchain::bench::doNotOptimize;
+
+// The previous PrivacyManager::RedactPII + IsSuspicious, kept as the baseline
+bool legacyRedact(std::vector<uint8_t>& data) {
+    static const std::regex ssnPattern(R"((\b\d{3}-\d{2}-\d{4}\b))");
+    static const std::regex phonePattern(R"((\(\d{3}\)\s?\d{3}-\d{4}|\b\d{3}-\d{3}-\d{4}\b))");
+    const char* begin = reinterpret_cast<const char*>(data.data());
+    const char* end = begin + data.size();
+    bool suspicious = false;
+    for (const std::string keyword : {"virus", "malware"}) {
+        suspicious = suspicious ||
+                     std::search(data.begin(), data.end(), keyword.begin(), keyword.end(),
+                                 [](uint8_t c, char k) { return std::tolower(c) == k; }) !=
+                         data.end();
+    }
+    if (!std::regex_search(begin, end, ssnPattern) &&
+        !std::regex_search(begin, end, phonePattern)) {
+        return suspicious;
+    }
+    std::string content(begin, end);
+    content = std::regex_replace(content, ssnPattern, "[REDACTED]");
+    content = std::regex_replace(content, phonePattern, "[REDACTED]");
+    data.assign(content.begin(), content.end());
+    return suspicious;
+}
+
+std::vector<uint8_t> costDocument(size_t size, bool withPii) {
+    std::string doc = "{\"provider\":\"St. Mary Regional\",\"region\":\"OH\",\"items\":[";
+    for (int i = 0; doc.size() < size; ++i) {
+        doc += "{\"cpt\":\"" + std::to_string(70000 + i % 900) +
+               "\",\"description\":\"Imaging study, contrast as documented\",\"price\":" +
+               std::to_string(100 + i * 37 % 5000) + ".00";
+        if (withPii && i % 40 == 7) {
+            doc += i % 80 == 7 ? ",\"contact\":\"(555) 123-4567\"" : ",\"ssn\":\"123-45-6789\"";
+        }
+        doc += "},";
+    }
+    doc += "{}]}";
+    return std::vector<uint8_t>(doc.begin(), doc.end());
+}
+
+void redactBenchmark(State& state, int variant, bool withPii) {
+    const std::vector<uint8_t> input = costDocument(64 * 1024, withPii);
+    rxrevoltchain::core::PrivacyManager privacy;
+    const pii::Backend previous = pii::backend();
+    if (variant > 0) {
+        pii::setBackend(variant == 2 ? pii::Backend::Avx2 : pii::Backend::Scalar);
+    }
+    std::vector<uint8_t> doc;
+    for (size_t i = 0; i < state.iterations; ++i) {
+        doc = input;
+        const bool suspicious = variant == 0 ? legacyRedact(doc) : privacy.Scan(doc).suspicious;
+        doNotOptimize(suspicious);
+        doNotOptimize(doc[0]);
+    }
+    pii::setBackend(previous);
+    state.bytesPerIteration = input.size();
+}
+
+const bool registered = [] {
+    for (bool withPii : {true, false}) {
+        const std::string name = withPii ? "PiiRedact/64KiB" : "PiiRedact/64KiB-clean";
+        rxrevoltchain::bench::registerBenchmark(
+            name + "/regex", [withPii](State& s) { redactBenchmark(s, 0, withPii); });
+        rxrevoltchain::bench::registerBenchmark(
+            name + "/scalar", [withPii](State& s) { redactBenchmark(s, 1, withPii); });
+        if (pii::backendAvailable(pii::Backend::Avx2)) {
+            rxrevoltchain::bench::registerBenchmark(
+                name + "/avx2", [withPii](State& s) { redactBenchmark(s, 2, withPii); });
+        }
+    }
+    return true;
+}();
+
+} // namespace
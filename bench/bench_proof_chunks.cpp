@@ -0,0 +1,89 @@
+// bench/bench_proof_chunks.cpp
+// -----------------------------------------------------------
+// Reading the challenged leaves of a 32 MiB snapshot, as a node does for every PoP
+// challenge it answers: the previous ProofGenerator::ExtractChunks (a new ifstream per
+// call, one seek and read per chunk) against reads from the shared ChunkReader mapping,
+// for a typical 6-leaf challenge and a 256-leaf batch.
+
+#include "bench.hpp"
+
+#include "ipfs_integration/chunk_reader.hpp"
+#include "pinner/proof_generator.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+using rxrevoltchain::bench::State;
+using rxrevoltchain::bench::doNotOptimize;
+
+constexpr size_t kLeaf = 4096;
+constexpr size_t kFileSize = 32u << 20;
+
+// The previous ProofGenerator::ExtractChunks, kept as the baseline
+std::vector<uint8_t> legacyExtract(const std::string& filePath, const std::vector<size_t>& offsets,
+                                   size_t chunkSize) {
+    std::vector<uint8_t> allChunks;
+    std::ifstream ifs(filePath, std::ios::binary);
+    for (auto off : offsets) {
+        ifs.seekg(static_cast<std::streamoff>(off), std::ios::beg);
+        if (!ifs.good()) {
+            continue;
+        }
+        std::vector<uint8_t> chunk(chunkSize, 0);
+        ifs.read(reinterpret_cast<char*>(chunk.data()), chunkSize);
+        chunk.resize(static_cast<size_t>(ifs.gcount()));
+        allChunks.insert(allChunks.end(), chunk.begin(), chunk.end());
+    }
+    return allChunks;
+}
+
+const std::string& snapshotFile() {
+    static const std::string path = [] {
+        const std::string p = "/tmp/rxrevolt_bench_chunks_" + std::to_string(::getpid());
+        std::ofstream ofs(p, std::ios::binary);
+        std::vector<char> block(1 << 20);
+        for (size_t i = 0; i < kFileSize / block.size(); ++i) {
+            for (size_t j = 0; j < block.size(); ++j) {
+                block[j] = static_cast<char>((i * 31 + j) % 251);
+            }
+            ofs.write(block.data(), static_cast<std::streamsize>(block.size()));
+        }
+        std::atexit([] { std::remove(snapshotFile().c_str()); });
+        return p;
+    }();
+    return path;
+}
+
+void chunkBenchmark(State& state, size_t leaves, bool mapped) {
+    const std::string& file = snapshotFile();
+    rxrevoltchain::pinner::ProofGenerator generator;
+    std::vector<size_t> offsets;
+    for (size_t leaf : generator.GenerateLeafIndices(kFileSize, leaves)) {
+        offsets.push_back(leaf * kLeaf);
+    }
+    for (size_t i = 0; i < state.iterations; ++i) {
+        auto chunks = mapped ? generator.ExtractChunks(file, offsets, kLeaf)
+                             : legacyExtract(file, offsets, kLeaf);
+        doNotOptimize(chunks.data());
+    }
+    state.bytesPerIteration = leaves * kLeaf;
+}
+
+const bool registered = [] {
+    for (size_t leaves : {size_t(6), size_t(256)}) {
+        const std::string name = "ProofChunks/" + std::to_string(leaves) + "x4KiB";
+        rxrevoltchain::bench::registerBenchmark(
+            name + "/ifstream", [leaves](State& s) { chunkBenchmark(s, leaves, false); });
+        rxrevoltchain::bench::registerBenchmark(
+            name + "/mapped", [leaves](State& s) { chunkBenchmark(s, leaves, true); });
+    }
+    return true;
+}();
+
+} // namespace
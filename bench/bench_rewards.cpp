@@ -0,0 +1,117 @@
+// bench/bench_rewards.cpp
+// -----------------------------------------------------------
+// One reward round (RecordPassingNodes + DistributeRewards, persisted) with 20000 known
+// pinner identities of which 500 pass: the previous RewardScheduler, which walked every
+// node and rewrote its text file each round, against the lazy-decay scheduler with its
+// checkpoint and append log.
+
+#include "bench.hpp"
+
+#include "consensus/reward_scheduler.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+using rxrevoltchain::bench::State;
+using rxrevoltchain::bench::doNotOptimize;
+
+constexpr size_t kNodes = 20000;
+constexpr size_t kPassing = 500;
+
+// The previous RewardScheduler round, kept as the baseline
+struct LegacyRewards {
+    std::unordered_map<std::string, uint64_t> streaks;
+    std::unordered_map<std::string, uint64_t> balances;
+    uint64_t pool = 0;
+    std::string file;
+
+    void round(const std::vector<std::string>& nodeIDs, uint64_t reward) {
+        pool += reward;
+        std::unordered_set<std::string> passing(nodeIDs.begin(), nodeIDs.end());
+        for (const auto& node : nodeIDs) {
+            streaks[node] += 1;
+        }
+        for (auto& pair : streaks) {
+            if (passing.count(pair.first) == 0 && pair.second > 0) {
+                pair.second -= 1;
+            }
+        }
+        uint64_t total = 0;
+        for (const auto& pair : streaks) {
+            total += pair.second;
+        }
+        for (const auto& pair : streaks) {
+            balances[pair.first] += static_cast<uint64_t>(
+                static_cast<double>(pool) * static_cast<double>(pair.second) / total);
+        }
+        pool = 0;
+        std::ofstream out(file, std::ios::trunc);
+        for (const auto& pair : streaks) {
+            out << pair.first << ' ' << pair.second << ' ' << balances[pair.first] << '\n';
+        }
+    }
+};
+
+std::vector<std::vector<std::string>> makeRounds(size_t count) {
+    std::vector<std::vector<std::string>> rounds(count);
+    for (size_t r = 0; r < count; ++r) {
+        for (size_t i = 0; i < kPassing; ++i) {
+            rounds[r].push_back("node" + std::to_string((r * 7919 + i * 40) % kNodes));
+        }
+    }
+    return rounds;
+}
+
+void rewardBenchmark(State& state, bool legacy) {
+    const std::string base = "/tmp/rxrevolt_bench_rewards_" + std::to_string(::getpid());
+    std::remove(base.c_str());
+    std::remove((base + ".log").c_str());
+    const auto rounds = makeRounds(64);
+
+    // Every identity has passed once before the timed rounds
+    std::vector<std::string> everyone;
+    for (size_t i = 0; i < kNodes; ++i) {
+        everyone.push_back("node" + std::to_string(i));
+    }
+    LegacyRewards old;
+    old.file = base;
+    rxrevoltchain::consensus::RewardScheduler scheduler(legacy ? "" : base);
+    scheduler.SetBaseDailyReward(1000000);
+    if (legacy) {
+        old.round(everyone, 1000000);
+    } else {
+        scheduler.RecordPassingNodes(everyone);
+        scheduler.DistributeRewards();
+    }
+
+    for (size_t i = 0; i < state.iterations; ++i) {
+        const auto& passing = rounds[i % rounds.size()];
+        if (legacy) {
+            old.round(passing, 1000000);
+        } else {
+            scheduler.RecordPassingNodes(passing);
+            doNotOptimize(scheduler.DistributeRewards());
+        }
+    }
+    doNotOptimize(legacy ? old.balances.size() : scheduler.NodeCount());
+    state.bytesPerIteration = 0;
+    std::remove(base.c_str());
+    std::remove((base + ".log").c_str());
+}
+
+const bool registered = [] {
+    rxrevoltchain::bench::registerBenchmark("RewardRound/20000-nodes/text-rewrite",
+                                            [](State& s) { rewardBenchmark(s, true); });
+    rxrevoltchain::bench::registerBenchmark("RewardRound/20000-nodes/lazy-log",
+                                            [](State& s) { rewardBenchmark(s, false); });
+    return true;
+}();
+
+} // namespace
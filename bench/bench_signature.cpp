@@ -0,0 +1,101 @@
+// bench/bench_signature.cpp
+// -----------------------------------------------------------
+// Signature checks over a merge-sized batch of submissions signed by a few keys: one-shot
+// Transaction::VerifySignature (key parsed and context allocated per call) against
+// SignatureVerifier with cached keys, serially and through VerifyBatch on the ThreadPool.
+
+#include "bench.hpp"
+
+#include "core/signature_verifier.hpp"
+#include "core/transaction.hpp"
+#include "util/hashing.hpp"
+
+#include <openssl/evp.h>
+#include <openssl/x509.h>
+#include <string>
+#include <vector>
+
+namespace {
+
+using rxrevoltchain::bench::State;
+using rxrevoltchain::bench::doNotOptimize;
+using rxrevoltchain::core::Transaction;
+
+struct SignedBatch {
+    std::vector<Transaction> transactions;
+    std::vector<std::vector<uint8_t>> publicKeys; // per transaction
+    size_t payloadBytes = 0;
+};
+
+// 'count' 1 KiB submissions, signed round-robin by 'signers' secp256k1 keys
+SignedBatch makeBatch(size_t count, size_t signers) {
+    SignedBatch batch;
+    std::vector<EVP_PKEY*> keys;
+    std::vector<std::vector<uint8_t>> points;
+    for (size_t k = 0; k < signers; ++k) {
+        EVP_PKEY* key = EVP_EC_gen("secp256k1");
+        unsigned char* der = nullptr;
+        const int len = i2d_PUBKEY(key, &der);
+        points.emplace_back(der + len - 65, der + len);
+        OPENSSL_free(der);
+        keys.push_back(key);
+    }
+    EVP_MD_CTX* ctx = EVP_MD_CTX_new();
+    for (size_t i = 0; i < count; ++i) {
+        const std::vector<uint8_t>& point = points[i % signers];
+        std::vector<uint8_t> payload(1024, static_cast<uint8_t>(i));
+        std::vector<uint8_t> signature(80);
+        size_t len = signature.size();
+        EVP_DigestSignInit(ctx, nullptr, EVP_sha256(), nullptr, keys[i % signers]);
+        EVP_DigestSign(ctx, signature.data(), &len, payload.data(), payload.size());
+        signature.resize(len);
+
+        Transaction tx;
+        tx.SetType("document_submission");
+        tx.SetMetadata("{\"public_key\":\"" +
+                       rxrevoltchain::util::hashing::toHex(point.data(), point.size()) + "\"}");
+        tx.SetSignature(std::move(signature));
+        tx.SetPayload(std::move(payload));
+        batch.payloadBytes += tx.GetPayload().size();
+        batch.transactions.push_back(std::move(tx));
+        batch.publicKeys.push_back(point);
+    }
+    EVP_MD_CTX_free(ctx);
+    for (EVP_PKEY* key : keys) {
+        EVP_PKEY_free(key);
+    }
+    return batch;
+}
+
+void verifyBenchmark(State& state, int variant) {
+    static const SignedBatch batch = makeBatch(256, 8);
+    rxrevoltchain::core::SignatureVerifier verifier;
+    for (size_t i = 0; i < state.iterations; ++i) {
+        size_t valid = 0;
+        if (variant == 2) {
+            for (char ok : verifier.VerifyBatch(batch.transactions)) {
+                valid += ok;
+            }
+        } else {
+            for (size_t t = 0; t < batch.transactions.size(); ++t) {
+                const Transaction& tx = batch.transactions[t];
+                valid += variant == 0 ? tx.VerifySignature(batch.publicKeys[t])
+                                      : verifier.Verify(tx, batch.publicKeys[t]);
+            }
+        }
+        doNotOptimize(valid);
+    }
+    state.bytesPerIteration = batch.payloadBytes;
+}
+
+const bool registered = [] {
+    rxrevoltchain::bench::registerBenchmark("VerifySignature/256x1KiB/per-call",
+                                            [](State& s) { verifyBenchmark(s, 0); });
+    rxrevoltchain::bench::registerBenchmark("VerifySignature/256x1KiB/cached-keys",
+                                            [](State& s) { verifyBenchmark(s, 1); });
+    rxrevoltchain::bench::registerBenchmark("VerifySignature/256x1KiB/batch",
+                                            [](State& s) { verifyBenchmark(s, 2); });
+    return true;
+}();
+
+} // namespace
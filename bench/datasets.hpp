@@ -0,0 +1,217 @@
+#ifndef RXREVOLTCHAIN_BENCH_DATASETS_HPP
+#define RXREVOLTCHAIN_BENCH_DATASETS_HPP
+
+#include "bench.hpp"
+
+#include "core/daily_snapshot.hpp"
+#include "core/document_queue.hpp"
+#include "core/transaction.hpp"
+#include "ipfs_integration/merkle_tree_cache.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <set>
+#include <string>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+/**
+ * @file datasets.hpp
+ * @brief Reproducible synthetic data for the rxrevolt_bench benchmarks.
+ *
+ * DESIGN:
+ *   - Everything is derived from dataset().seed through SplitMix64, so two runs with the
+ *     same --dataset and --seed work on byte-identical files and documents.
+ *   - snapshotFile() and documentDatabase() are generated on first use, shared by every
+ *     benchmark of the run and removed at exit. Only the benchmarks that need them pay for
+ *     them, so filtering to e.g. Sha256 never writes a 10 GB file.
+ *   - Presets (see applyPreset) follow the sizes tracked across releases: 10k documents
+ *     with a 100 MB snapshot (the default), 1m with 1 GB and 10m with 10 GB.
+ */
+
+namespace rxrevoltchain {
+namespace bench {
+
+/** SplitMix64: tiny, fast and fully determined by its seed. */
+class Rng {
+  public:
+    explicit Rng(uint64_t seed) : m_state(seed) {}
+
+    uint64_t next() {
+        uint64_t z = (m_state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    /** Uniform value in [0, bound). */
+    uint64_t uniform(uint64_t bound) { return bound ? next() % bound : 0; }
+
+  private:
+    uint64_t m_state;
+};
+
+/**
+ * Selects one of the dataset presets ("10k", "1m", "10m").
+ * @return false for an unknown name (the dataset is left unchanged).
+ */
+inline bool applyPreset(const std::string& name) {
+    struct Preset {
+        const char* name;
+        size_t documents;
+        uint64_t snapshotBytes;
+    };
+    static const Preset presets[] = {{"10k", 10000, 100000000ull},
+                                     {"1m", 1000000, 1000000000ull},
+                                     {"10m", 10000000, 10000000000ull}};
+    for (const Preset& p : presets) {
+        if (name == p.name) {
+            dataset().name = p.name;
+            dataset().documents = p.documents;
+            dataset().snapshotBytes = p.snapshotBytes;
+            return true;
+        }
+    }
+    return false;
+}
+
+/** Path of a generated file: '<dataDir>/rxrevolt_bench_<stem>_<pid>'. */
+inline std::string dataPath(const std::string& stem) {
+    return dataset().dataDir + "/rxrevolt_bench_" + stem + "_" + std::to_string(::getpid());
+}
+
+/** Removes a generated file and its side files when the program exits. */
+struct GeneratedFile {
+    std::string path;
+    std::vector<std::string> suffixes;
+
+    GeneratedFile(std::string p, std::vector<std::string> s)
+        : path(std::move(p)), suffixes(std::move(s)) {}
+    GeneratedFile(const GeneratedFile&) = delete;
+    GeneratedFile& operator=(const GeneratedFile&) = delete;
+    ~GeneratedFile() {
+        std::remove(path.c_str());
+        for (const auto& suffix : suffixes) {
+            std::remove((path + suffix).c_str());
+        }
+    }
+};
+
+/** Words the document metadata is built from; HttpQuery benchmarks search for them. */
+inline const std::vector<std::string>& procedureWords() {
+    static const std::vector<std::string> words = {"mri",     "xray",    "ct",      "lab",
+                                                   "visit",   "surgery", "therapy", "vaccine"};
+    return words;
+}
+
+/**
+ * A document_submission with JSON metadata (procedure, cost, document index) and
+ * 'payloadSize' pseudo-random payload bytes.
+ */
+inline core::Transaction makeDocument(Rng& rng, size_t index, size_t payloadSize) {
+    const auto& words = procedureWords();
+    core::Transaction tx;
+    tx.SetType("document_submission");
+    tx.SetMetadata("{\"procedure\":\"" + words[rng.uniform(words.size())] +
+                   "\",\"cost\":" + std::to_string(100 + rng.uniform(100000)) +
+                   ",\"doc\":" + std::to_string(index) + "}");
+    std::vector<uint8_t> payload(payloadSize);
+    for (size_t i = 0; i < payloadSize; i += 8) {
+        const uint64_t word = rng.next();
+        for (size_t b = 0; b < 8 && i + b < payloadSize; ++b) {
+            payload[i + b] = static_cast<uint8_t>(word >> (8 * b));
+        }
+    }
+    tx.SetPayload(std::move(payload));
+    return tx;
+}
+
+/** Writes 'bytes' pseudo-random bytes from 'seed' to 'path'. */
+inline void writeRandomFile(const std::string& path, uint64_t bytes, uint64_t seed) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    Rng rng(seed);
+    std::vector<uint64_t> block((1u << 20) / sizeof(uint64_t));
+    for (uint64_t left = bytes; left > 0 && out;) {
+        for (auto& word : block) {
+            word = rng.next();
+        }
+        const size_t n = static_cast<size_t>(std::min<uint64_t>(left, 1u << 20));
+        out.write(reinterpret_cast<const char*>(block.data()), static_cast<std::streamsize>(n));
+        left -= n;
+    }
+}
+
+/**
+ * Merges 'documents' documents from makeDocument() (256-byte payloads) into a new
+ * DailySnapshot database at 'path', through a DocumentQueue in batches.
+ */
+inline void writeDocumentDatabase(const std::string& path, size_t documents, uint64_t seed) {
+    constexpr size_t kBatch = 50000;
+    const std::string walFile = path + ".queue";
+    std::remove(path.c_str());
+    std::remove(walFile.c_str());
+    {
+        core::DocumentQueue queue(walFile);
+        core::WriteAheadLog::Options options;
+        options.policy = core::WriteAheadLog::FsyncPolicy::None;
+        queue.SetWalOptions(options);
+        core::DailySnapshot snapshot(path);
+        snapshot.SetDocumentQueue(&queue);
+        Rng rng(seed);
+        for (size_t done = 0; done < documents;) {
+            const size_t n = std::min(kBatch, documents - done);
+            for (size_t i = 0; i < n; ++i) {
+                queue.AddTransaction(makeDocument(rng, done + i, 256));
+            }
+            snapshot.MergePendingDocuments();
+            done += n;
+        }
+    }
+    std::remove(walFile.c_str());
+}
+
+/** The dataset's snapshot file (dataset().snapshotBytes bytes), written on first use. */
+inline const std::string& snapshotFile() {
+    static const GeneratedFile file{dataPath("snapshot"), {".merkle"}};
+    static const bool written =
+        (writeRandomFile(file.path, dataset().snapshotBytes, dataset().seed), true);
+    (void)written;
+    return file.path;
+}
+
+/** The dataset's document database (dataset().documents documents), built on first use. */
+inline const std::string& documentDatabase() {
+    static const GeneratedFile file{dataPath("documents") + ".sqlite", {"-wal", "-shm"}};
+    static const bool written =
+        (writeDocumentDatabase(file.path, dataset().documents, dataset().seed + 1), true);
+    (void)written;
+    return file.path;
+}
+
+/**
+ * Merkle tree of snapshotFile() in 'format', built once per format (and persisted next to
+ * the file, so a PoPConsensus issuing challenges on it loads instead of rebuilding it).
+ */
+inline std::shared_ptr<const ipfs_integration::MerkleTree>
+snapshotTree(ipfs_integration::MerkleFormat format) {
+    static ipfs_integration::MerkleTreeCache cache;
+    return cache.GetOrBuild(snapshotFile(), "bench-snapshot", format);
+}
+
+/** 'count' distinct leaf indices below 'leafCount', ascending (all of them if fewer). */
+inline std::vector<size_t> challengeLeaves(Rng& rng, size_t leafCount, size_t count) {
+    std::set<size_t> leaves;
+    while (leaves.size() < std::min(count, leafCount)) {
+        leaves.insert(static_cast<size_t>(rng.uniform(leafCount)));
+    }
+    return std::vector<size_t>(leaves.begin(), leaves.end());
+}
+
+} // namespace bench
+} // namespace rxrevoltchain
+
+#endif // RXREVOLTCHAIN_BENCH_DATASETS_HPP
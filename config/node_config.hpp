@@ -24,6 +24,18 @@ namespace config {
  *   - dataDirectory: Where to store chain data and WAL snapshots.
  *   - nodeName: A user-defined name or identifier for logs/peers.
  *   - maxConnections: A limit on how many inbound/outbound peers are allowed.
+ *   - p2pIoThreads: Number of I/O threads multiplexing all peer sockets.
+ *   - snapshotSyncTimeoutSeconds: Limit for copying the snapshot from bootstrap peers.
+ *   - snapshotSyncRoot / snapshotSyncQuorum: Which snapshot root that copy may have.
+ *   - deltaSnapshotMaxChain: Pin changed chunks only, up to this many cycles in a row.
+ *   - ingestBatchSeconds / ingestBatchDocuments: Merge submissions in micro-batches instead
+ *     of once per scheduler cycle.
+ *   - snapshotShards: Split the snapshot across this many SQLite files.
+ *   - signaturePolicy: Whether merges drop submissions without a valid signature.
+ *   - walFsyncPolicy / walFsyncIntervalMs: Durability of the document queue's write-ahead log.
+ *   - compressionCodec / compressionLevel / compressionDictionary: How snapshot payloads are
+ *     stored.
+ *   - logMode / logQueueCapacity / logOverflowPolicy: Synchronous or background logging.
  */
 struct NodeConfig {
     /**
@@ -32,11 +44,27 @@ struct NodeConfig {
      *   dataDirectory = "./rxrevolt_data"
      *   nodeName = "rxrevolt_node"
      *   maxConnections = 64
+     *   p2pIoThreads = 2
+     *   snapshotSyncTimeoutSeconds = 600
+     *   snapshotSyncRoot = "" (use a root snapshotSyncQuorum = 2 peers agree on)
+     *   deltaSnapshotMaxChain = 0 (always pin the full file)
+     *   ingestBatchSeconds = 0 (merge once per cycle), ingestBatchDocuments = 10000
+     *   snapshotShards = 1 (a single data.sqlite)
+     *   signaturePolicy = "off"
+     *   walFsyncPolicy = "always", walFsyncIntervalMs = 10
+     *   compressionCodec = "zlib", compressionLevel = 9, no dictionary
+     *   logMode = "sync", logQueueCapacity = 8192, logOverflowPolicy = "block"
      */
     NodeConfig()
         : p2pPort(30303), dataDirectory("./rxrevolt_data"), nodeName("rxrevolt_node"),
           maxConnections(64), ipfsEndpoint("http://127.0.0.1:5001"),
-          schedulerIntervalSeconds(86400), bootstrapPeers() {}
+          schedulerIntervalSeconds(86400), bootstrapPeers(), walFsyncPolicy("always"),
+          walFsyncIntervalMs(10), compressionCodec("zlib"), compressionLevel(9),
+          compressionDictionary(), p2pIoThreads(2),
+          snapshotSyncTimeoutSeconds(600), snapshotSyncRoot(), snapshotSyncQuorum(2),
+          deltaSnapshotMaxChain(0), ingestBatchSeconds(0),
+          ingestBatchDocuments(10000), snapshotShards(1), signaturePolicy("off"),
+          logMode("sync"), logQueueCapacity(8192), logOverflowPolicy("block") {}
 
     /// The TCP port to listen on for P2P connections (e.g., 30303).
     uint16_t p2pPort;
@@ -58,6 +86,71 @@ struct NodeConfig {
 
     /// Optional list of peer addresses (ip:port) to connect to on startup.
     std::vector<std::string> bootstrapPeers;
+
+    /// When the document queue WAL is fsynced: "always" (before each submission is
+    /// acknowledged), "interval" (every walFsyncIntervalMs) or "none" (left to the OS).
+    std::string walFsyncPolicy;
+
+    /// Background fsync period for walFsyncPolicy = "interval", in milliseconds.
+    uint32_t walFsyncIntervalMs;
+
+    /// Codec for document payloads written to the snapshot: "zlib" or "zstd" (falls back to
+    /// zlib when the build has no zstd support).
+    std::string compressionCodec;
+
+    /// Codec level: zlib 0-9, zstd 1-22.
+    int compressionLevel;
+
+    /// Optional path to a trained zstd dictionary (empty = none). Only used with "zstd".
+    std::string compressionDictionary;
+
+    /// Number of I/O threads (epoll loops) serving every P2P socket.
+    uint32_t p2pIoThreads;
+
+    /// How long a node without a data.sqlite may spend syncing it from its bootstrap peers
+    /// on startup, in seconds (0 = never sync, start empty).
+    uint32_t snapshotSyncTimeoutSeconds;
+
+    /// Merkle root (hex) of the snapshot that startup sync may fetch, e.g. from a trusted
+    /// announcement. Empty = the root at least snapshotSyncQuorum bootstrap peers serve;
+    /// without either the node starts empty.
+    std::string snapshotSyncRoot;
+
+    /// Number of bootstrap peers that must serve the same root when snapshotSyncRoot is
+    /// empty (at least 1).
+    uint32_t snapshotSyncQuorum;
+
+    /// Delta snapshots: how many cycles in a row may pin only the chunks changed since the
+    /// previous pin before a full file is pinned again (0 = always pin the full file).
+    uint32_t deltaSnapshotMaxChain;
+
+    /// Micro-batch ingestion: merge queued submissions into the live database every this
+    /// many seconds, and let the scheduler cycle only seal and pin the snapshot
+    /// (0 = merge everything once per scheduler cycle).
+    uint32_t ingestBatchSeconds;
+
+    /// With micro-batch ingestion, also merge as soon as this many submissions are queued.
+    uint32_t ingestBatchDocuments;
+
+    /// Number of SQLite shards (data.shard-<i>.sqlite) documents are partitioned across,
+    /// each merged and pinned on its own under a manifest CID (1 = a single data.sqlite).
+    /// Fixed once the data directory holds shards.
+    uint32_t snapshotShards;
+
+    /// "off" merges every submission; "require" verifies each one's ECDSA signature against
+    /// the "public_key" in its metadata and drops those that fail.
+    std::string signaturePolicy;
+
+    /// "sync" writes each log line before the call returns; "async" hands it to a
+    /// background writer thread through a ring buffer.
+    std::string logMode;
+
+    /// Number of records the async log ring buffer holds (rounded up to a power of two).
+    uint32_t logQueueCapacity;
+
+    /// What async logging does when the ring buffer is full: "block" the caller until
+    /// there is room, or "drop" the record (drops are counted and reported).
+    std::string logOverflowPolicy;
 };
 
 } // namespace config
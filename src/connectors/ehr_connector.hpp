@@ -1,8 +1,8 @@
 #ifndef RXREVOLTCHAIN_CONNECTORS_EHR_CONNECTOR_HPP
 #define RXREVOLTCHAIN_CONNECTORS_EHR_CONNECTOR_HPP
 
+#include "curl_handle_pool.hpp"
 #include <curl/curl.h>
-#include <mutex>
 #include <string>
 
 namespace rxrevoltchain {
@@ -14,11 +14,14 @@ namespace connectors {
  *
  * The connector is intentionally lightweight and only supports a basic
  * POST of JSON payloads. It can be extended with authentication headers,
- * batching or more advanced error handling as needed.
+ * batching or more advanced error handling as needed. Requests reuse handles
+ * (and their keep-alive connections) from the shared util::CurlHandlePool.
  */
 class EHRConnector {
   public:
-    explicit EHRConnector(const std::string& endpoint) : m_endpoint(endpoint) { initCurl(); }
+    explicit EHRConnector(const std::string& endpoint,
+                          util::CurlHandlePool& pool = util::CurlHandlePool::getInstance())
+        : m_endpoint(endpoint), m_pool(pool) {}
 
     /**
      * @brief Submit a JSON document to the remote endpoint.
@@ -31,11 +34,6 @@ class EHRConnector {
     }
 
   private:
-    void initCurl() {
-        static std::once_flag flag;
-        std::call_once(flag, []() { curl_global_init(CURL_GLOBAL_DEFAULT); });
-    }
-
     static size_t writeCallback(char* ptr, size_t size, size_t nmemb, void* userdata) {
         if (!userdata)
             return 0;
@@ -46,9 +44,10 @@ class EHRConnector {
     }
 
     bool httpPost(const std::string& url, const std::string& body, std::string& responseOut) {
-        CURL* curl = curl_easy_init();
-        if (!curl)
+        util::CurlHandlePool::Handle handle = m_pool.acquire();
+        if (!handle)
             return false;
+        CURL* curl = handle.get();
 
         struct curl_slist* headers = nullptr;
         headers = curl_slist_append(headers, "Content-Type: application/json");
@@ -56,18 +55,20 @@ class EHRConnector {
         curl_easy_setopt(curl, CURLOPT_POST, 1L);
         curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
         curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body.c_str());
-        curl_easy_setopt(curl, CURLOPT_TIMEOUT, 30L);
+        util::CurlHandlePool::StallWatch watch(30);
+        util::CurlHandlePool::applyStallTimeouts(curl, 10L, watch);
         curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCallback);
         curl_easy_setopt(curl, CURLOPT_WRITEDATA, &responseOut);
 
         CURLcode res = curl_easy_perform(curl);
+        curl_easy_reset(curl);
         curl_slist_free_all(headers);
-        curl_easy_cleanup(curl);
 
         return res == CURLE_OK;
     }
 
     std::string m_endpoint;
+    util::CurlHandlePool& m_pool;
 };
 
 } // namespace connectors
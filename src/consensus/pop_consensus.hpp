@@ -3,9 +3,15 @@
 
 #include "hashing.hpp"
 #include "ipfs_integration/merkle_proof.hpp"
+#include "ipfs_integration/merkle_tree_cache.hpp"
 #include "logger.hpp"
+#include "metrics.hpp"
 #include "pinner/proof_generator.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <filesystem>
 #include <mutex>
 #include <random>
@@ -42,12 +48,27 @@ namespace consensus {
     the current challenge round.
 
   Implementation details:
-  - Challenges consist of random offsets within the pinned file. Nodes must
-    provide Merkle proofs for those offsets matching the expected Merkle root.
-  - We keep a map of node -> response to check them in ValidateResponses().
+  - Challenges consist of distinct random leaf indices (4 KB merkle chunks) of the
+    pinned file. Nodes must provide Merkle proofs for exactly those leaves (each once,
+    in any order) matching the expected Merkle root.
+  - A response may be a per-leaf proof (MerkleProof::GenerateProof, v1/v2) or a v3
+    multi-proof (GenerateMultiProof), which shares the upper-level siblings. Nothing in
+    the tree answers challenges yet (PinnerNode's POP_REQUEST handling is a stub), so
+    both generators are API for responders; the verifier accepts either.
+  - CollectResponse never takes the mutex: responses are pushed onto a lock-free
+    inbox (a singly linked list swapped out whole by the validator), tagged with
+    the round they were collected in. Responses from an earlier round are dropped.
+  - ValidateResponses drains the inbox into a map of node -> response (the latest
+    response of a node wins) and verifies every response it has not judged yet on
+    the shared ThreadPool. The cheap root/format check runs before any hashing.
+  - Each round may have a deadline (SetRoundTimeout). Responses arriving after it
+    are refused, and WaitForResponses stops waiting for slow nodes when it passes.
   - Once validated, passing nodes go into a separate set or map for the current
     round, retrievable by GetPassingNodes().
-  - Thread-safety ensured via a mutex to protect shared state.
+  - A mutex protects the round state shared by IssueChallenges, ValidateResponses
+    and the getters.
+  - Exports rxrevolt_pop_* metrics (util::metrics): validation time, time since the
+    round was issued, and verified responses by result (pass, fail, late).
 */
 
 class PoPConsensus {
@@ -58,12 +79,34 @@ class PoPConsensus {
         std::vector<std::string> passingNodes;
         std::chrono::system_clock::time_point timestamp;
     };
+
+    // Counters for the current round
+    struct RoundStats {
+        size_t collected = 0; // responses accepted by CollectResponse
+        size_t late = 0;      // responses refused because the deadline had passed
+        size_t verified = 0;  // responses checked by ValidateResponses so far
+    };
+
     // Default constructor seeds RNG for additional randomness
     PoPConsensus() : m_useEncryption(false) {
         std::random_device rd;
         m_rng.seed(rd());
     }
 
+    ~PoPConsensus() { freeInbox(m_inbox.exchange(nullptr)); }
+
+    PoPConsensus(const PoPConsensus&) = delete;
+    PoPConsensus& operator=(const PoPConsensus&) = delete;
+
+    /**
+     * Time nodes get to respond after IssueChallenges; zero (the default) means no deadline.
+     * Applies to rounds issued after the call.
+     */
+    void SetRoundTimeout(std::chrono::milliseconds timeout) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_roundTimeout = timeout;
+    }
+
     // Creates random chunk requests for the pinned DB identified by cid.
     // Offsets are used to build a Merkle proof challenge based on filePath.
     void IssueChallenges(const std::string& cid, const std::string& filePath,
@@ -72,6 +115,23 @@ class PoPConsensus {
 
         m_useEncryption = useEncryption;
 
+        // Start a new round. Anything still in the inbox, or pushed before the round
+        // number moves on, belongs to the old one and is discarded.
+        freeInbox(m_inbox.exchange(nullptr, std::memory_order_acquire));
+        m_collected.store(0);
+        m_late.store(0, std::memory_order_relaxed);
+        m_verified = 0;
+        m_challengeNodeResponses.clear();
+        m_passingNodes.clear();
+        m_deadline.store(m_roundTimeout.count() > 0
+                             ? (std::chrono::steady_clock::now() + m_roundTimeout)
+                                   .time_since_epoch()
+                                   .count()
+                             : 0,
+                         std::memory_order_release);
+        m_roundStarted = std::chrono::steady_clock::now();
+        m_round.fetch_add(1, std::memory_order_acq_rel);
+
         // Log the new challenge issuance
         rxrevoltchain::util::logger::Logger::getInstance().info(
             "[PoPConsensus] Issuing challenges for CID: " + cid);
@@ -87,32 +147,29 @@ class PoPConsensus {
             return;
         }
 
-        // Pick random offsets with variable count for added unpredictability
+        // Pick random leaves with variable count for added unpredictability. Proofs address
+        // chunks by leaf index, so the challenge does too.
         rxrevoltchain::pinner::ProofGenerator generator;
         std::uniform_int_distribution<size_t> countDist(3, 6);
         size_t count = countDist(m_rng);
-        m_offsets = generator.GenerateRandomOffsets(fileSize, count);
+        m_offsets = generator.GenerateLeafIndices(
+            fileSize, count, rxrevoltchain::ipfs_integration::MerkleProof::DEFAULT_CHUNK_SIZE);
 
-        // Generate local proof to obtain the root for comparison
-        rxrevoltchain::ipfs_integration::MerkleProof mp;
-        std::vector<uint8_t> proof = mp.GenerateProof(filePath, m_offsets);
-        if (proof.empty()) {
+        // Obtain the expected root from the snapshot's merkle tree. The tree is cached per
+        // snapshot (see MerkleTreeCache), so only the first challenge hashes the file.
+        auto tree = m_treeCache->GetOrBuild(filePath, cid, m_proofFormat);
+        if (!tree) {
             rxrevoltchain::util::logger::Logger::getInstance().error(
-                "[PoPConsensus] Failed to generate local Merkle proof.");
+                "[PoPConsensus] Failed to obtain local Merkle tree.");
             return;
         }
-        m_currentChallengeRoot = extractRootFromProof(proof);
+        m_currentChallengeRoot = tree->root;
 
-        // Optionally encrypt the challenge proof to explore zero-knowledge style flows
+        // Optionally encrypt responses to explore zero-knowledge style flows
         if (m_useEncryption) {
             generateEncryptionKey();
-            xorBufferWithKey(proof);
         }
 
-        // Clear any old data
-        m_challengeNodeResponses.clear();
-        m_passingNodes.clear();
-
         // Store the current pinned CID if needed for further reference
         m_lastCID = cid;
 
@@ -122,22 +179,65 @@ class PoPConsensus {
 
     // Accepts a chunk response from a node. In reality, this would be
     // the chunk data or merkle proof for random offsets within the pinned DB.
-    void CollectResponse(const std::string& nodeID, const std::vector<uint8_t>& data) {
-        std::lock_guard<std::mutex> lock(m_mutex);
+    // Lock-free; returns false if the round's deadline has already passed.
+    bool CollectResponse(const std::string& nodeID, std::vector<uint8_t> data) {
+        const int64_t deadline = m_deadline.load(std::memory_order_acquire);
+        if (deadline != 0 &&
+            std::chrono::steady_clock::now().time_since_epoch().count() > deadline) {
+            m_late.fetch_add(1, std::memory_order_relaxed);
+            Metrics::get().late.inc();
+            rxrevoltchain::util::logger::Logger::getInstance().warn(
+                "[PoPConsensus] Late response from node " + nodeID + " refused.");
+            return false;
+        }
 
-        // Store the raw response from this node
-        m_challengeNodeResponses[nodeID] = data;
+        const size_t size = data.size();
+        auto* entry = new InboxEntry{nodeID, std::move(data),
+                                     m_round.load(std::memory_order_acquire), nullptr};
+        entry->next = m_inbox.load(std::memory_order_relaxed);
+        while (!m_inbox.compare_exchange_weak(entry->next, entry, std::memory_order_release,
+                                              std::memory_order_relaxed)) {
+        }
+        // Sequentially consistent with m_waiters so either the waiter sees the new count
+        // or we see the waiter
+        m_collected.fetch_add(1);
+        if (m_waiters.load() > 0) {
+            // Empty critical section orders the notify after a waiter's predicate check
+            { std::lock_guard<std::mutex> lock(m_waitMutex); }
+            m_waitCv.notify_all();
+        }
 
-        rxrevoltchain::util::logger::Logger::getInstance().info(
-            "[PoPConsensus] Collected response from node: " + nodeID +
-            " (data size = " + std::to_string(data.size()) + ")");
+        rxrevoltchain::util::logger::Logger::getInstance().info([&] {
+            return "[PoPConsensus] Collected response from node: " + nodeID +
+                   " (data size = " + std::to_string(size) + ")";
+        });
+        return true;
     }
 
-    // Runs all checks to confirm which nodes proved possession; returns true if all is valid.
-    // For demonstration, we treat any node whose response data (SHA-256) matches
-    // the ephemeral challenge's SHA-256 as valid.
+    // Blocks until 'expected' responses were collected this round or the round's deadline
+    // passes (without a deadline it waits for all of them). Returns the number collected.
+    size_t WaitForResponses(size_t expected) {
+        std::unique_lock<std::mutex> lock(m_waitMutex);
+        m_waiters.fetch_add(1);
+        auto ready = [&] { return m_collected.load() >= expected; };
+        const int64_t deadline = m_deadline.load(std::memory_order_acquire);
+        if (deadline == 0) {
+            m_waitCv.wait(lock, ready);
+        } else {
+            std::chrono::steady_clock::time_point until{
+                std::chrono::steady_clock::duration(deadline)};
+            m_waitCv.wait_until(lock, until, ready);
+        }
+        m_waiters.fetch_sub(1);
+        return m_collected.load();
+    }
+
+    // Runs all checks to confirm which nodes proved possession; returns true if any node passed.
+    // A node passes if its proof verifies and commits to the challenge's root and format.
     bool ValidateResponses() {
         std::lock_guard<std::mutex> lock(m_mutex);
+        Metrics& metrics = Metrics::get();
+        util::metrics::ScopedTimer timer(metrics.validateSeconds);
 
         if (m_currentChallengeRoot.empty()) {
             rxrevoltchain::util::logger::Logger::getInstance().error(
@@ -145,23 +245,53 @@ class PoPConsensus {
             return false;
         }
 
-        // Clear any old passing nodes
-        m_passingNodes.clear();
-
-        // Evaluate each node's response
-        for (const auto& pair : m_challengeNodeResponses) {
-            const std::string& nodeID = pair.first;
-            std::vector<uint8_t> response = pair.second;
-            if (m_useEncryption) {
-                xorBufferWithKey(response);
+        // Move this round's new responses out of the inbox (oldest first, so a node's
+        // latest response wins) and queue them for verification.
+        const uint64_t round = m_round.load(std::memory_order_acquire);
+        InboxEntry* head = m_inbox.exchange(nullptr, std::memory_order_acquire);
+        InboxEntry* oldestFirst = nullptr;
+        while (head) {
+            InboxEntry* next = head->next;
+            head->next = oldestFirst;
+            oldestFirst = head;
+            head = next;
+        }
+        for (InboxEntry* e = oldestFirst; e; e = e->next) {
+            if (e->round == round) {
+                NodeResponse& slot = m_challengeNodeResponses[e->nodeID];
+                slot.data = std::move(e->data);
+                slot.checked = false;
             }
-            rxrevoltchain::ipfs_integration::MerkleProof mp;
-            if (!mp.VerifyProof(response)) {
-                continue;
+        }
+        freeInbox(oldestFirst);
+
+        std::vector<std::pair<const std::string*, NodeResponse*>> pending;
+        for (auto& pair : m_challengeNodeResponses) {
+            if (!pair.second.checked) {
+                pending.emplace_back(&pair.first, &pair.second);
             }
-            std::string root = extractRootFromProof(response);
-            if (root == m_currentChallengeRoot) {
-                m_passingNodes.insert(nodeID);
+        }
+
+        // Each response is independent: verify them across the pool
+        rxrevoltchain::util::ThreadPool::getInstance().parallelFor(
+            pending.size(), 1, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    NodeResponse& r = *pending[i].second;
+                    r.passed = verifyResponse(r.data);
+                    r.checked = true;
+                }
+            });
+        m_verified += pending.size();
+        for (const auto& item : pending) {
+            (item.second->passed ? metrics.passed : metrics.failed).inc();
+        }
+        const auto sinceIssued = std::chrono::steady_clock::now() - m_roundStarted;
+        metrics.roundSeconds.set(std::chrono::duration<double>(sinceIssued).count());
+
+        m_passingNodes.clear();
+        for (const auto& pair : m_challengeNodeResponses) {
+            if (pair.second.passed) {
+                m_passingNodes.insert(pair.first);
             }
         }
 
@@ -197,12 +327,48 @@ class PoPConsensus {
         return result;
     }
 
-    /** Offsets used for the current challenge (for testing). */
+    /** Counters of the current round. */
+    RoundStats GetRoundStats() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        RoundStats stats;
+        stats.collected = m_collected.load(std::memory_order_acquire);
+        stats.late = m_late.load(std::memory_order_relaxed);
+        stats.verified = m_verified;
+        return stats;
+    }
+
+    /** Leaf indices challenged this round, ascending (for testing). */
     std::vector<size_t> GetCurrentOffsets() const {
         std::lock_guard<std::mutex> lock(m_mutex);
         return m_offsets;
     }
 
+    /**
+     * Tree/proof format used for new challenges. Responses must use the same format.
+     * Defaults to LegacyHex (v1) so rounds stay compatible with nodes that predate v2.
+     */
+    void SetProofFormat(rxrevoltchain::ipfs_integration::MerkleFormat format) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_proofFormat = format;
+    }
+
+    rxrevoltchain::ipfs_integration::MerkleFormat GetProofFormat() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_proofFormat;
+    }
+
+    /** Merkle tree cache used for challenges; shared with proof answering on this node. */
+    rxrevoltchain::ipfs_integration::MerkleTreeCache& GetTreeCache() { return *m_treeCache; }
+
+    /**
+     * Use 'cache' (shared with DailySnapshot and SnapshotSync) instead of this instance's
+     * own; nullptr switches back. Call before issuing challenges; 'cache' must outlive this.
+     */
+    void SetTreeCache(rxrevoltchain::ipfs_integration::MerkleTreeCache* cache) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_treeCache = cache ? cache : &m_ownTreeCache;
+    }
+
     /** Retrieve stored challenge history. */
     std::vector<ChallengeRecord> GetChallengeHistory() const {
         std::lock_guard<std::mutex> lock(m_mutex);
@@ -210,50 +376,56 @@ class PoPConsensus {
     }
 
   private:
-    // Helper to extract the merkle root from a proof blob
-    std::string extractRootFromProof(const std::vector<uint8_t>& proof) const {
-        size_t pos = 0;
-        auto readU32 = [&](uint32_t& val) -> bool {
-            if (pos + 4 > proof.size())
-                return false;
-            val = (static_cast<uint32_t>(proof[pos + 0]) << 24) |
-                  (static_cast<uint32_t>(proof[pos + 1]) << 16) |
-                  (static_cast<uint32_t>(proof[pos + 2]) << 8) |
-                  (static_cast<uint32_t>(proof[pos + 3]) << 0);
-            pos += 4;
-            return true;
-        };
-
-        uint32_t chunkSize = 0, totalChunks = 0, numOffsets = 0;
-        if (!readU32(chunkSize) || !readU32(totalChunks) || !readU32(numOffsets))
-            return {};
-
-        for (uint32_t i = 0; i < numOffsets; ++i) {
-            uint32_t idx = 0, len = 0, pathLen = 0;
-            if (!readU32(idx) || !readU32(len))
-                return {};
-            if (pos + len > proof.size())
-                return {};
-            pos += len;
-            if (!readU32(pathLen))
-                return {};
-            for (uint32_t p = 0; p < pathLen; ++p) {
-                uint32_t hlen = 0;
-                if (!readU32(hlen))
-                    return {};
-                if (pos + hlen > proof.size())
-                    return {};
-                pos += hlen;
-            }
+    struct InboxEntry {
+        std::string nodeID;
+        std::vector<uint8_t> data;
+        uint64_t round;
+        InboxEntry* next;
+    };
+
+    struct NodeResponse {
+        std::vector<uint8_t> data;
+        bool checked = false;
+        bool passed = false;
+    };
+
+    static void freeInbox(InboxEntry* e) {
+        while (e) {
+            InboxEntry* next = e->next;
+            delete e;
+            e = next;
         }
+    }
 
-        uint32_t rootLen = 0;
-        if (!readU32(rootLen))
-            return {};
-        if (pos + rootLen > proof.size())
-            return {};
-        std::string root((const char*)&proof[pos], rootLen);
-        return root;
+    // Checks one response against the current challenge. Called concurrently from pool
+    // threads while ValidateResponses holds m_mutex, so it only reads round state.
+    bool verifyResponse(std::vector<uint8_t>& response) const {
+        if (m_useEncryption) {
+            xorBufferWithKey(response);
+        }
+        // A root only compares equal within one tree format; reject before hashing
+        auto format = rxrevoltchain::ipfs_integration::MerkleFormat::LegacyHex;
+        std::string root = extractRootFromProof(response, &format);
+        if (format != m_proofFormat || root != m_currentChallengeRoot) {
+            return false;
+        }
+        // The proof must cover exactly the challenged leaves, not leaves of its choosing
+        std::vector<size_t> offsets;
+        if (!rxrevoltchain::ipfs_integration::MerkleProof::ExtractOffsets(response, offsets)) {
+            return false;
+        }
+        std::sort(offsets.begin(), offsets.end());
+        if (offsets != m_offsets) {
+            return false;
+        }
+        rxrevoltchain::ipfs_integration::MerkleProof mp;
+        return mp.VerifyProof(response);
+    }
+
+    // Helper to extract the merkle root (hex) and format from a v1 or v2 proof blob
+    std::string extractRootFromProof(const std::vector<uint8_t>& proof,
+                                     rxrevoltchain::ipfs_integration::MerkleFormat* format) const {
+        return rxrevoltchain::ipfs_integration::MerkleProof::ExtractRoot(proof, format);
     }
 
   private:
@@ -271,8 +443,60 @@ class PoPConsensus {
     // Expected Merkle root for the challenge
     std::string m_currentChallengeRoot;
 
-    // Node responses for this challenge
-    std::unordered_map<std::string, std::vector<uint8_t>> m_challengeNodeResponses;
+    // Merkle trees of challenged snapshots, persisted as '<file>.merkle'
+    rxrevoltchain::ipfs_integration::MerkleTreeCache m_ownTreeCache;
+    rxrevoltchain::ipfs_integration::MerkleTreeCache* m_treeCache = &m_ownTreeCache;
+
+    // Format of the challenge tree and of accepted proofs
+    rxrevoltchain::ipfs_integration::MerkleFormat m_proofFormat =
+        rxrevoltchain::ipfs_integration::MerkleFormat::LegacyHex;
+
+    // Shared by every PoPConsensus instance
+    struct Metrics {
+        util::metrics::Histogram& validateSeconds;
+        util::metrics::Gauge& roundSeconds;
+        util::metrics::Counter& passed;
+        util::metrics::Counter& failed;
+        util::metrics::Counter& late;
+
+        static Metrics& get() {
+            using util::metrics::Registry;
+            static const char* responses = "PoP responses by verification result.";
+            static Metrics metrics{
+                Registry::getInstance().histogram("rxrevolt_pop_validate_duration_seconds",
+                                                  "Time spent in ValidateResponses."),
+                Registry::getInstance().gauge(
+                    "rxrevolt_pop_round_seconds",
+                    "Seconds from IssueChallenges to the latest ValidateResponses."),
+                Registry::getInstance().counter("rxrevolt_pop_responses_total", responses,
+                                                "result=\"pass\""),
+                Registry::getInstance().counter("rxrevolt_pop_responses_total", responses,
+                                                "result=\"fail\""),
+                Registry::getInstance().counter("rxrevolt_pop_responses_total", responses,
+                                                "result=\"late\"")};
+            return metrics;
+        }
+    };
+
+    // Node responses for this challenge, moved out of the inbox by ValidateResponses
+    std::unordered_map<std::string, NodeResponse> m_challengeNodeResponses;
+    size_t m_verified = 0;
+
+    // Lock-free hand-off from CollectResponse, newest first
+    std::atomic<InboxEntry*> m_inbox{nullptr};
+    std::atomic<uint64_t> m_round{0};
+    std::atomic<size_t> m_collected{0};
+    std::atomic<size_t> m_late{0};
+
+    // Round deadline as steady_clock ticks, 0 if none
+    std::chrono::milliseconds m_roundTimeout{0};
+    std::atomic<int64_t> m_deadline{0};
+    std::chrono::steady_clock::time_point m_roundStarted;
+
+    // Only for WaitForResponses; CollectResponse touches it only when someone waits
+    std::mutex m_waitMutex;
+    std::condition_variable m_waitCv;
+    std::atomic<int> m_waiters{0};
 
     // The set of nodes that successfully validated
     std::unordered_set<std::string> m_passingNodes;
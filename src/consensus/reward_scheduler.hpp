@@ -2,14 +2,22 @@
 #define RXREVOLTCHAIN_REWARD_SCHEDULER_HPP
 
 #include "logger.hpp"
+#include "write_ahead_log.hpp"
+#include <algorithm>
+#include <cerrno>
 #include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
 #include <fstream>
+#include <iterator>
 #include <mutex>
 #include <sstream>
 #include <string>
+#include <unistd.h>
 #include <unordered_map>
-#include <unordered_set>
 #include <vector>
+#include <zlib.h>
 
 namespace rxrevoltchain {
 namespace consensus {
@@ -30,39 +38,70 @@ namespace consensus {
   "Fully functional" approach:
   1. Keeps track of a daily reward amount (SetBaseDailyReward).
   2. After PoP validation, RecordPassingNodes is called with the list of nodes that passed.
-     - Each passing node's "streak" or hosting record can be incremented or maintained.
-  3. When DistributeRewards is called, we split the tokens among passing nodes, possibly factoring
-  in streak or weight.
-     - For demonstration, we do a basic approach: each node who passed gets an equal share,
-       or a share proportional to their streak if you want a more advanced logic.
-  4. The daily minted tokens accumulate in a "current reward pool" each day until DistributeRewards
-  is called.
-     - Once distributed, you can reset it or let it accumulate further based on your logic.
+     Every call is one round (epoch): passing nodes gain one streak point, every other node
+     loses one (down to zero).
+  3. When DistributeRewards is called, the pool is split among all nodes in proportion to
+     their current streak.
+  4. The daily minted tokens accumulate in a "current reward pool" each round until
+     DistributeRewards is called, which empties it.
 
   Implementation notes:
-  - We store node streaks in an unordered_map. If a node passes PoP, we increment its streak; if it
-  fails, you could reduce or reset it in a more complex system. Here, we only track the passing
-  nodes each round.
-  - After distribution, the reward pool is set to 0 for the day (or remain if partial distribution
-  is desired).
+  - A round costs O(passing nodes), however many nodes are known:
+    - Decay is lazy. A node record keeps the epoch it last passed and the epoch its streak
+      runs out ('expiry'), so its streak in epoch e is max(0, expiry - e) without touching
+      it every round.
+    - The total streak is sum(expiry) - e * (nodes with expiry > e), kept up to date from a
+      count of nodes per expiry epoch.
+    - A distribution only records its rate per streak point (32.32 fixed point). A node's
+      balance is settled from the cumulative rates whenever it next passes or is queried;
+      a node with streak s at a distribution gets rate * s, rounded down.
+  - Persistence (when a storage file is given): the file holds a binary checkpoint and
+    '<file>.log' a core::WriteAheadLog with one record per RecordPassingNodes (the round
+    plus the passing nodes' new records) or DistributeRewards call. Once the log holds more
+    node records than there are nodes, a new checkpoint is written to '<file>.tmp' and
+    renamed over the file, and the log restarts. Replaying log records already contained
+    in the checkpoint changes nothing, so a crash between the rename and the log reset is
+    harmless. A text file from the previous format is converted on load.
+  - The default constructor keeps its state in memory only.
   - Thread-safety: We use a mutex to protect shared data structures.
+
+  Checkpoint format (integers little-endian):
+     1) 8 bytes: magic "RXRS" 0x00 0x00 0x00 0x01
+     2) 8 bytes: current epoch E, 8 bytes: reward pool
+     3) E + 1 rates (16 bytes each): the rate per streak point distributed in epochs 0..E
+     4) 8 bytes: node count, then per node: 2 bytes id length, the id, 8 bytes expiry,
+        8 bytes last passed epoch, 8 bytes balance settled up to that epoch
+     5) 4 bytes: CRC32 of everything before it
+  Log records: 1 byte type, then for a round (1) the epoch, the pool, a 4-byte node count
+  and that many node entries as above; for a distribution (2) the epoch, the epoch's rate
+  total so far and the pool.
 */
 
 class RewardScheduler {
   public:
+    // A checkpoint is never written for fewer log entries than this
+    static constexpr size_t CHECKPOINT_MIN_ENTRIES = 1024;
+
     /**
      * @brief Construct a new RewardScheduler.
-     * @param storageFile Path to the file used for persisting rewards.
+     * @param storageFile Path to the file used for persisting rewards; empty keeps the
+     *        state in memory only.
      */
-    explicit RewardScheduler(const std::string& storageFile = "reward_state.dat")
+    explicit RewardScheduler(const std::string& storageFile = "")
         : m_baseDailyReward(0), m_currentRewardPool(0), m_storageFile(storageFile) {
+        resetState();
         loadFromDisk();
     }
 
-    /** Set the path of the persistent storage file. */
+    RewardScheduler(const RewardScheduler&) = delete;
+    RewardScheduler& operator=(const RewardScheduler&) = delete;
+
+    /** Set the path of the persistent storage file and load the state kept there. */
     void SetStorageFile(const std::string& file) {
         std::lock_guard<std::mutex> lock(m_mutex);
+        m_log.Close();
         m_storageFile = file;
+        resetState();
         loadFromDisk();
     }
 
@@ -74,41 +113,52 @@ class RewardScheduler {
             "[RewardScheduler] Base daily reward set to: " + std::to_string(amount));
     }
 
-    // Tells the scheduler which nodes passed PoP and penalizes those that did not.
+    // Tells the scheduler which nodes passed PoP; all the others lose a streak point.
     void RecordPassingNodes(const std::vector<std::string>& nodeIDs) {
         std::lock_guard<std::mutex> lock(m_mutex);
 
         // Each time PoP passes, we add the daily reward to the "pool"
         // In a real system, you might track time-based issuance, but for simplicity
         // we just accumulate it every time new passing nodes are recorded.
+        advanceEpoch();
         m_currentRewardPool += m_baseDailyReward;
 
-        // Track nodes that passed in this round for later comparison
-        std::unordered_set<std::string> passing(nodeIDs.begin(), nodeIDs.end());
-
-        // Increment or maintain "streak" for these nodes
+        std::vector<const std::pair<const std::string, NodeRecord>*> touched;
+        touched.reserve(nodeIDs.size());
         for (const auto& node : nodeIDs) {
-            auto it = m_nodeStreaks.find(node);
-            if (it == m_nodeStreaks.end()) {
-                m_nodeStreaks[node] = 1; // new node starts with streak=1
-            } else {
-                it->second += 1; // increment existing streak
+            auto inserted = m_nodes.emplace(node, NodeRecord());
+            NodeRecord& rec = inserted.first->second;
+            if (rec.epoch != m_epoch) {
+                touched.push_back(&*inserted.first); // once per node, however often listed
             }
+            // Streak before this round; a node listed twice gains two points
+            const uint64_t before =
+                rec.epoch == m_epoch ? streakAt(rec, m_epoch) : streakAt(rec, m_epoch - 1);
+            NodeRecord updated = rec;
+            updated.balance += accrued(rec, m_epoch); // distributions of earlier epochs
+            updated.epoch = m_epoch;
+            updated.expiry = m_epoch + before + 1;
+            replaceNode(rec, updated);
         }
 
-        // Penalize nodes that previously had a streak but failed this round
-        for (auto& pair : m_nodeStreaks) {
-            if (passing.count(pair.first) == 0 && pair.second > 0) {
-                pair.second -= 1; // simple penalty
+        if (m_log.IsOpen()) {
+            std::vector<uint8_t> record;
+            record.push_back(ROUND_RECORD);
+            putU64(record, m_epoch);
+            putU64(record, m_currentRewardPool);
+            putU32(record, static_cast<uint32_t>(touched.size()));
+            for (const auto* node : touched) {
+                putNode(record, node->first, node->second);
             }
+            appendLog(record, touched.size());
         }
         rxrevoltchain::util::logger::Logger::getInstance().info(
             "[RewardScheduler] Recorded " + std::to_string(nodeIDs.size()) +
             " passing nodes. Current reward pool: " + std::to_string(m_currentRewardPool));
     }
 
-    // Splits the daily minted tokens among passing nodes, factoring in streak or reputation.
-    // Returns true if successful.
+    // Splits the pool among all nodes in proportion to their streak. Returns true if
+    // successful.
     bool DistributeRewards() {
         std::lock_guard<std::mutex> lock(m_mutex);
 
@@ -119,47 +169,30 @@ class RewardScheduler {
             return false;
         }
 
-        // We gather all nodes that have a streak > 0 (i.e., have passed at least once).
-        // This naive approach splits the reward pool proportionally to their streak.
-        uint64_t totalStreaks = 0;
-        for (const auto& pair : m_nodeStreaks) {
-            totalStreaks += pair.second;
-        }
-
+        const Wide totalStreaks = m_expirySum - Wide(m_epoch) * m_activeNodes;
         if (totalStreaks == 0) {
             rxrevoltchain::util::logger::Logger::getInstance().warn(
                 "[RewardScheduler] DistributeRewards found no valid streaks to reward.");
             return false;
         }
 
-        // Distribute the reward
-        // In a real system, you'd have wallet addresses for each node,
-        // or a ledger to credit their balances. Here, we'll just log the distribution.
-        for (const auto& pair : m_nodeStreaks) {
-            const std::string& nodeID = pair.first;
-            uint64_t nodeStreak = pair.second;
-            // fraction = nodeStreak / totalStreaks
-            // reward = fraction * m_currentRewardPool
-            double fraction = static_cast<double>(nodeStreak) / static_cast<double>(totalStreaks);
-            uint64_t nodeReward =
-                static_cast<uint64_t>(static_cast<double>(m_currentRewardPool) * fraction);
-
-            rxrevoltchain::util::logger::Logger::getInstance().info(
-                "[RewardScheduler] Node " + nodeID + " receives reward: " +
-                std::to_string(nodeReward) + " (streak=" + std::to_string(nodeStreak) + ")");
+        // Balances pick the rate up lazily (see accrued)
+        m_epochRate += (Wide(m_currentRewardPool) << RATE_FRACTION_BITS) / totalStreaks;
 
-            m_nodeBalances[nodeID] += nodeReward;
-        }
-
-        // Reset the pool after distribution
         rxrevoltchain::util::logger::Logger::getInstance().info(
             "[RewardScheduler] Distributed " + std::to_string(m_currentRewardPool) +
-            " tokens among " + std::to_string(m_nodeStreaks.size()) +
+            " tokens among " + std::to_string(m_activeNodes) +
             " node(s). Reward pool reset to 0.");
         m_currentRewardPool = 0;
 
-        saveToDisk();
-
+        if (m_log.IsOpen()) {
+            std::vector<uint8_t> record;
+            record.push_back(DISTRIBUTION_RECORD);
+            putU64(record, m_epoch);
+            putWide(record, m_epochRate);
+            putU64(record, m_currentRewardPool);
+            appendLog(record, 0);
+        }
         return true;
     }
 
@@ -172,55 +205,416 @@ class RewardScheduler {
     /** Get the current streak count for a node. */
     uint64_t GetNodeStreak(const std::string& nodeID) const {
         std::lock_guard<std::mutex> lock(m_mutex);
-        auto it = m_nodeStreaks.find(nodeID);
-        return it == m_nodeStreaks.end() ? 0 : it->second;
+        auto it = m_nodes.find(nodeID);
+        return it == m_nodes.end() ? 0 : streakAt(it->second, m_epoch);
     }
 
     /** Get the current token balance for a node address. */
     uint64_t GetBalance(const std::string& nodeID) const {
         std::lock_guard<std::mutex> lock(m_mutex);
-        auto it = m_nodeBalances.find(nodeID);
-        return it == m_nodeBalances.end() ? 0 : it->second;
+        auto it = m_nodes.find(nodeID);
+        return it == m_nodes.end() ? 0
+                                   : it->second.balance + accrued(it->second, m_epoch + 1);
+    }
+
+    /** Rounds recorded so far (RecordPassingNodes calls). */
+    uint64_t GetEpoch() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_epoch;
+    }
+
+    /** Number of nodes that ever passed. */
+    size_t NodeCount() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_nodes.size();
+    }
+
+    /** Write a checkpoint now and restart the log. False without a storage file. */
+    bool Checkpoint() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return !m_storageFile.empty() && writeCheckpoint();
     }
 
   private:
+    using Wide = unsigned __int128;
+
+    static constexpr unsigned RATE_FRACTION_BITS = 32;
+    static constexpr uint8_t ROUND_RECORD = 1;
+    static constexpr uint8_t DISTRIBUTION_RECORD = 2;
+    static constexpr char kMagic[8] = {'R', 'X', 'R', 'S', 0, 0, 0, 1};
+
+    struct NodeRecord {
+        uint64_t expiry = 0;  // first epoch in which the streak is zero
+        uint64_t epoch = 0;   // epoch the node last passed
+        uint64_t balance = 0; // settled for distributions before 'epoch'
+    };
+
+    // Sums over distributions: of their rates, and of rate * epoch
+    struct Cumulative {
+        Wide rate = 0;
+        Wide weighted = 0;
+    };
+
+    static uint64_t streakAt(const NodeRecord& rec, uint64_t epoch) {
+        return rec.expiry > epoch ? rec.expiry - epoch : 0;
+    }
+
+    // Sums over the distributions of epochs before 'epoch' (at most m_epoch + 1)
+    Cumulative cumulativeBefore(uint64_t epoch) const {
+        if (epoch <= m_epoch) {
+            return m_cumulative[epoch];
+        }
+        Cumulative c = m_cumulative[m_epoch];
+        c.rate += m_epochRate;
+        c.weighted += m_epochRate * m_epoch;
+        return c;
+    }
+
+    // Tokens 'rec' earned from distributions in [rec.epoch, until); its streak in epoch e
+    // is expiry - e until it expires
+    uint64_t accrued(const NodeRecord& rec, uint64_t until) const {
+        until = std::min(until, rec.expiry);
+        if (until <= rec.epoch) {
+            return 0;
+        }
+        const Cumulative to = cumulativeBefore(until);
+        const Cumulative from = cumulativeBefore(rec.epoch);
+        const Wide earned =
+            Wide(rec.expiry) * (to.rate - from.rate) - (to.weighted - from.weighted);
+        return static_cast<uint64_t>(earned >> RATE_FRACTION_BITS);
+    }
+
+    void trackExpiry(uint64_t expiry, bool add) {
+        if (expiry <= m_epoch) {
+            return;
+        }
+        if (add) {
+            ++m_expiring[expiry];
+            ++m_activeNodes;
+            m_expirySum += expiry;
+        } else {
+            if (--m_expiring[expiry] == 0) {
+                m_expiring.erase(expiry);
+            }
+            --m_activeNodes;
+            m_expirySum -= expiry;
+        }
+    }
+
+    void replaceNode(NodeRecord& rec, const NodeRecord& updated) {
+        trackExpiry(rec.expiry, false);
+        rec = updated;
+        trackExpiry(rec.expiry, true);
+    }
+
+    void advanceEpoch() {
+        m_cumulative.push_back(cumulativeBefore(m_epoch + 1));
+        ++m_epoch;
+        m_epochRate = 0;
+        auto it = m_expiring.find(m_epoch);
+        if (it != m_expiring.end()) {
+            m_activeNodes -= it->second;
+            m_expirySum -= Wide(m_epoch) * it->second;
+            m_expiring.erase(it);
+        }
+    }
+
+    void resetState() {
+        m_nodes.clear();
+        m_expiring.clear();
+        m_activeNodes = 0;
+        m_expirySum = 0;
+        m_epoch = 0;
+        m_epochRate = 0;
+        m_cumulative.assign(1, Cumulative());
+        m_currentRewardPool = 0;
+        m_logEntries = 0;
+    }
+
+    std::string logPath() const { return m_storageFile + ".log"; }
+
+    void appendLog(const std::vector<uint8_t>& record, size_t nodeEntries) {
+        if (!m_log.Append(record)) {
+            rxrevoltchain::util::logger::Logger::getInstance().error(
+                "[RewardScheduler] Could not append to " + logPath());
+            return;
+        }
+        m_logEntries += std::max<size_t>(1, nodeEntries);
+        if (m_logEntries > std::max(CHECKPOINT_MIN_ENTRIES, m_nodes.size())) {
+            writeCheckpoint();
+        }
+    }
+
+    // -- encoding --------------------------------------------------------------------
+
+    static void putU16(std::vector<uint8_t>& out, uint16_t v) {
+        out.push_back(static_cast<uint8_t>(v));
+        out.push_back(static_cast<uint8_t>(v >> 8));
+    }
+    static void putU32(std::vector<uint8_t>& out, uint32_t v) {
+        for (int i = 0; i < 4; ++i) {
+            out.push_back(static_cast<uint8_t>(v >> (8 * i)));
+        }
+    }
+    static void putU64(std::vector<uint8_t>& out, uint64_t v) {
+        for (int i = 0; i < 8; ++i) {
+            out.push_back(static_cast<uint8_t>(v >> (8 * i)));
+        }
+    }
+    static void putWide(std::vector<uint8_t>& out, Wide v) {
+        putU64(out, static_cast<uint64_t>(v));
+        putU64(out, static_cast<uint64_t>(v >> 64));
+    }
+    static void putNode(std::vector<uint8_t>& out, const std::string& id, const NodeRecord& rec) {
+        const uint16_t len = static_cast<uint16_t>(std::min<size_t>(id.size(), UINT16_MAX));
+        putU16(out, len);
+        out.insert(out.end(), id.begin(), id.begin() + len);
+        putU64(out, rec.expiry);
+        putU64(out, rec.epoch);
+        putU64(out, rec.balance);
+    }
+
+    // Bounds-checked little-endian reader; any overrun clears 'ok'
+    struct Reader {
+        const uint8_t* data;
+        size_t size;
+        size_t pos = 0;
+        bool ok = true;
+
+        uint64_t get(size_t bytes) {
+            if (!ok || size - pos < bytes) {
+                ok = false;
+                return 0;
+            }
+            uint64_t v = 0;
+            for (size_t i = 0; i < bytes; ++i) {
+                v |= uint64_t(data[pos + i]) << (8 * i);
+            }
+            pos += bytes;
+            return v;
+        }
+        Wide wide() {
+            const uint64_t lo = get(8);
+            return Wide(get(8)) << 64 | lo;
+        }
+        bool node(std::string& id, NodeRecord& rec) {
+            const size_t len = static_cast<size_t>(get(2));
+            if (!ok || size - pos < len) {
+                ok = false;
+                return false;
+            }
+            id.assign(reinterpret_cast<const char*>(data + pos), len);
+            pos += len;
+            rec.expiry = get(8);
+            rec.epoch = get(8);
+            rec.balance = get(8);
+            return ok;
+        }
+    };
+
+    // -- persistence -----------------------------------------------------------------
+
     bool loadFromDisk() {
-        m_nodeStreaks.clear();
-        m_nodeBalances.clear();
-        std::ifstream in(m_storageFile);
-        if (!in.is_open())
+        using namespace rxrevoltchain::util::logger;
+        if (m_storageFile.empty()) {
+            return true;
+        }
+        std::ifstream in(m_storageFile, std::ios::binary);
+        std::vector<uint8_t> content((std::istreambuf_iterator<char>(in)),
+                                     std::istreambuf_iterator<char>());
+        in.close();
+        const bool binary = content.size() >= sizeof(kMagic) &&
+                            std::memcmp(content.data(), kMagic, sizeof(kMagic)) == 0;
+        if (!content.empty() && !binary) {
+            // Text state from before the binary store: "<node> <streak> <balance>" lines
+            loadLegacy(std::string(content.begin(), content.end()));
+            return writeCheckpoint();
+        }
+        if (binary && !readCheckpoint(content)) {
+            Logger::getInstance().error("[RewardScheduler] Corrupt checkpoint in " +
+                                        m_storageFile + "; starting from an empty state.");
+            resetState();
+        }
+
+        std::vector<std::vector<uint8_t>> records;
+        if (!m_log.Open(logPath(), records) && !m_log.Create(logPath())) {
+            Logger::getInstance().error("[RewardScheduler] Cannot open " + logPath());
             return false;
+        }
+        for (const auto& record : records) {
+            if (!applyLogRecord(record)) {
+                Logger::getInstance().error("[RewardScheduler] Invalid record in " + logPath() +
+                                            "; ignoring it and the rest of the log.");
+                break;
+            }
+        }
+        m_logEntries = records.size();
+        Logger::getInstance().info("[RewardScheduler] Loaded " + std::to_string(m_nodes.size()) +
+                                   " node(s) at epoch " + std::to_string(m_epoch) + " from " +
+                                   m_storageFile + " (" + std::to_string(records.size()) +
+                                   " log record(s))");
+        return true;
+    }
 
+    void loadLegacy(const std::string& text) {
+        std::istringstream in(text);
         std::string nodeID;
         uint64_t streak = 0, balance = 0;
         while (in >> nodeID >> streak >> balance) {
-            m_nodeStreaks[nodeID] = streak;
-            m_nodeBalances[nodeID] = balance;
+            NodeRecord& rec = m_nodes[nodeID];
+            NodeRecord updated;
+            updated.expiry = streak;
+            updated.balance = balance;
+            replaceNode(rec, updated);
         }
-        return true;
+        rxrevoltchain::util::logger::Logger::getInstance().info(
+            "[RewardScheduler] Converted " + std::to_string(m_nodes.size()) +
+            " node(s) from the text format in " + m_storageFile);
+    }
+
+    bool readCheckpoint(const std::vector<uint8_t>& content) {
+        if (content.size() < sizeof(kMagic) + 4) {
+            return false;
+        }
+        const size_t body = content.size() - 4;
+        Reader crcReader{content.data() + body, 4};
+        const uLong crc = crc32(crc32(0L, Z_NULL, 0), content.data(), static_cast<uInt>(body));
+        if (static_cast<uint32_t>(crc) != crcReader.get(4)) {
+            return false;
+        }
+
+        Reader r{content.data(), body, sizeof(kMagic)};
+        const uint64_t epoch = r.get(8);
+        const uint64_t pool = r.get(8);
+        // Each epoch's rate takes 16 bytes; refuse counts the file cannot hold
+        if (!r.ok || epoch >= (body - r.pos) / 16) {
+            return false;
+        }
+        m_cumulative.assign(1, Cumulative());
+        for (uint64_t e = 0; e < epoch; ++e) {
+            const Wide rate = r.wide();
+            Cumulative next = m_cumulative.back();
+            next.rate += rate;
+            next.weighted += rate * e;
+            m_cumulative.push_back(next);
+        }
+        m_epoch = epoch;
+        m_epochRate = r.wide();
+        m_currentRewardPool = pool;
+
+        const uint64_t count = r.get(8);
+        std::string id;
+        NodeRecord rec;
+        for (uint64_t i = 0; r.ok && i < count; ++i) {
+            if (r.node(id, rec)) {
+                replaceNode(m_nodes[id], rec);
+            }
+        }
+        return r.ok && r.pos == body;
     }
 
-    bool saveToDisk() const {
-        std::ofstream out(m_storageFile, std::ios::trunc);
-        if (!out.is_open())
+    bool applyLogRecord(const std::vector<uint8_t>& record) {
+        Reader r{record.data(), record.size()};
+        const uint8_t type = static_cast<uint8_t>(r.get(1));
+        const uint64_t epoch = r.get(8);
+        if (!r.ok || epoch > m_epoch + 1) {
+            return false;
+        }
+        // Records older than the checkpoint are already part of it
+        const bool current = epoch + (type == ROUND_RECORD ? 1 : 0) > m_epoch;
+        if (type == ROUND_RECORD) {
+            const uint64_t pool = r.get(8);
+            const uint32_t count = static_cast<uint32_t>(r.get(4));
+            if (current && epoch == m_epoch + 1) {
+                advanceEpoch();
+            }
+            std::string id;
+            NodeRecord rec;
+            for (uint32_t i = 0; r.ok && i < count; ++i) {
+                if (r.node(id, rec) && current) {
+                    replaceNode(m_nodes[id], rec);
+                }
+            }
+            if (current && r.ok) {
+                m_currentRewardPool = pool;
+            }
+        } else if (type == DISTRIBUTION_RECORD) {
+            const Wide rate = r.wide();
+            const uint64_t pool = r.get(8);
+            if (epoch == m_epoch && r.ok) {
+                m_epochRate = rate;
+                m_currentRewardPool = pool;
+            }
+        } else {
             return false;
+        }
+        return r.ok;
+    }
 
-        for (const auto& pair : m_nodeStreaks) {
-            uint64_t balance = 0;
-            auto it = m_nodeBalances.find(pair.first);
-            if (it != m_nodeBalances.end())
-                balance = it->second;
-            out << pair.first << ' ' << pair.second << ' ' << balance << '\n';
+    bool writeCheckpoint() {
+        using namespace rxrevoltchain::util::logger;
+        std::vector<uint8_t> out(kMagic, kMagic + sizeof(kMagic));
+        putU64(out, m_epoch);
+        putU64(out, m_currentRewardPool);
+        for (uint64_t e = 0; e < m_epoch; ++e) {
+            putWide(out, m_cumulative[e + 1].rate - m_cumulative[e].rate);
+        }
+        putWide(out, m_epochRate);
+        putU64(out, m_nodes.size());
+        for (const auto& node : m_nodes) {
+            putNode(out, node.first, node.second);
+        }
+        putU32(out, static_cast<uint32_t>(
+                        crc32(crc32(0L, Z_NULL, 0), out.data(), static_cast<uInt>(out.size()))));
+
+        const std::string tmp = m_storageFile + ".tmp";
+        const int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        bool ok = fd >= 0;
+        for (size_t done = 0; ok && done < out.size();) {
+            const ssize_t n = ::write(fd, out.data() + done, out.size() - done);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            ok = n > 0;
+            done += ok ? static_cast<size_t>(n) : 0;
+        }
+        ok = ok && ::fdatasync(fd) == 0;
+        if (fd >= 0) {
+            ok = ::close(fd) == 0 && ok;
         }
+        ok = ok && std::rename(tmp.c_str(), m_storageFile.c_str()) == 0;
+        if (!ok) {
+            Logger::getInstance().error("[RewardScheduler] Could not write checkpoint " +
+                                        m_storageFile + ": " + std::strerror(errno));
+            std::remove(tmp.c_str());
+            return false;
+        }
+        // Everything in the log is in the checkpoint now
+        if (!m_log.Create(logPath())) {
+            Logger::getInstance().error("[RewardScheduler] Cannot reset " + logPath());
+        }
+        m_logEntries = 0;
         return true;
     }
 
     mutable std::mutex m_mutex;
     uint64_t m_baseDailyReward;   // how many tokens minted each cycle
     uint64_t m_currentRewardPool; // how many tokens are available for distribution
-    std::unordered_map<std::string, uint64_t> m_nodeStreaks;  // nodeID -> streak count
-    std::unordered_map<std::string, uint64_t> m_nodeBalances; // nodeID -> token balance
+    std::unordered_map<std::string, NodeRecord> m_nodes;
+
+    // Epochs and distributions; m_cumulative[e] covers the epochs before e
+    uint64_t m_epoch = 0;
+    Wide m_epochRate = 0; // rate per streak point distributed so far in m_epoch
+    std::vector<Cumulative> m_cumulative;
+
+    // Nodes whose streak is positive in m_epoch, and their expiries
+    std::unordered_map<uint64_t, uint64_t> m_expiring; // expiry epoch -> nodes
+    uint64_t m_activeNodes = 0;
+    Wide m_expirySum = 0;
+
     std::string m_storageFile;
+    rxrevoltchain::core::WriteAheadLog m_log;
+    size_t m_logEntries = 0; // node entries (or records) appended since the checkpoint
 };
 
 } // namespace consensus
@@ -1,6 +1,7 @@
 #ifndef RXREVOLTCHAIN_SNAPSHOT_VALIDATION_HPP
 #define RXREVOLTCHAIN_SNAPSHOT_VALIDATION_HPP
 
+#include <future>
 #include <string>
 #include <sqlite3.h>
 #include <stdexcept>
@@ -26,7 +27,8 @@ namespace consensus {
   1. Opens the .sqlite database file at dbFilePath.
   2. Runs a "PRAGMA integrity_check" to verify structural correctness.
   3. Optionally computes a SHA-256 hash of the .sqlite file to ensure consistency 
-     if you wish to store or compare it with a known reference.
+     if you wish to store or compare it with a known reference. The hash is computed on
+     a background thread while the integrity check runs, since both only read the file.
   4. Marks the snapshot valid or invalid based on checks.
   5. Allows external code to query whether the last validation attempt succeeded.
 */
@@ -59,6 +61,12 @@ public:
             return m_isValid;
         }
 
+        // Start hashing the file now; it only reads the file and overlaps with step 2
+        std::future<rxrevoltchain::util::hashing::Digest> fileHashTask = std::async(
+            std::launch::async, [dbFilePath]() {
+                return rxrevoltchain::util::hashing::sha256FileRaw(dbFilePath);
+            });
+
         // 2. Run PRAGMA integrity_check to verify structural consistency
         if (!runIntegrityCheck(db))
         {
@@ -72,7 +80,7 @@ public:
         //    In a real system, you might compare this with a stored or expected hash.
         try
         {
-            std::string fileHash = rxrevoltchain::util::hashing::sha256File(dbFilePath);
+            std::string fileHash = rxrevoltchain::util::hashing::toHex(fileHashTask.get());
             logger.info("[SnapshotValidation] Computed DB file hash (SHA-256): " + fileHash);
             // Example: We do not compare with a known reference here, 
             // but the system could store/compare as needed.
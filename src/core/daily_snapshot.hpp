@@ -1,24 +1,119 @@
 #ifndef RXREVOLTCHAIN_DAILY_SNAPSHOT_HPP
 #define RXREVOLTCHAIN_DAILY_SNAPSHOT_HPP
 
+#include "compression.hpp"
+#include "document_index.hpp"
 #include "document_queue.hpp"
+#include "hashing.hpp"
 #include "ipfs_pinner.hpp"
 #include "logger.hpp"
+#include "merkle_tree_cache.hpp"
+#include "metrics.hpp"
 #include "pinned_state.hpp"
 #include "privacy_manager.hpp"
+#include "signature_verifier.hpp"
+#include "snapshot_delta.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <functional>
 #include <iostream>
+#include <map>
 #include <mutex>
+#include <set>
 #include <sqlite3.h>
 #include <stdexcept>
 #include <string>
+#include <sys/stat.h>
 #include <vector>
-#include <zlib.h>
 
 namespace rxrevoltchain {
 namespace core {
 
+/*
+  DailySnapshot
+  --------------------------------
+  Merges queued submissions/removals into the snapshot .sqlite file and pins it.
+
+  Incremental merge engine:
+   - One SQLite connection is kept open across merge cycles (reopened only if the file is
+     replaced or removed underneath us) with WAL journaling, synchronous=NORMAL and a
+     larger page cache.
+   - The INSERT and DELETE statements are prepared once per connection and reset/rebound
+     for every transaction.
+   - Large queues are applied in bounded SQLite transactions of SetMergeChunkSize()
+     records, so a huge backlog neither holds one enormous write transaction nor pays a
+     commit per record.
+   - After each merge (and before pinning) the WAL is checkpointed into the main file, so
+     the single .sqlite file that gets pinned and hashed is always complete.
+
+  Removals:
+   - Every row stores content_hash = SHA-256 of the stored (redacted, uncompressed) payload.
+     signature and content_hash are indexed, so a removal is an index lookup, not a scan.
+   - A removal_request targets rows whose signature equals the request's signature and, if
+     its payload is a non-empty multiple of 32 bytes, rows whose content_hash equals any of
+     those 32-byte digests (so one request can take down many documents).
+   - Removal targets are collected in temp tables and resolved with one DELETE per batch.
+     The batch is flushed early if a later submission in the same chunk matches a pending
+     target, so queue order is preserved.
+   - Snapshots written before the column existed are migrated on open (PRAGMA user_version
+     SCHEMA_VERSION): the column and indexes are added and content_hash is backfilled.
+
+  Signatures (SetSignatureVerifier):
+   - When a SignatureVerifier is set, the fetched batch's submissions are verified in
+     parallel before anything else happens to them; invalid ones are dropped and logged.
+
+  Compression:
+   - Each chunk's submission payloads are redacted (one PrivacyManager::Scan pass each) and
+     then compressed, both in parallel on the shared ThreadPool *before* the SQLite write
+     transaction starts. The results are consumed in queue order, so row order and removal
+     ordering are unchanged.
+   - The two stages are pipelined: chunk N+1 is prepared by a ThreadPool task while chunk N
+     is inserted and committed, using two alternating sets of buffers. If no worker has
+     started that task when the writer needs it, the writer runs it (ThreadPool::submit),
+     so a merge running on a pool worker cannot deadlock.
+   - Every row records its codec (documents.codec, see util::compression::Codec). Rows from
+     older snapshots default to zlib, so readers handle mixed snapshots.
+   - With zstd, an optional trained dictionary (SetCompression / TrainCompressionDictionary)
+     is written to the dictionaries table keyed by its zstd dictionary ID, which every frame
+     also carries; the pinned file is therefore self-describing.
+
+  Query indexes (see DocumentIndex):
+   - Cost items (procedure code, provider, region, price) and full-text input are extracted
+     from each redacted payload on the ThreadPool alongside compression, and written in the
+     same transaction as the document row, so the indexes grow with every merge and are
+     never rebuilt. Removals drop index rows through triggers.
+   - Snapshots from before schema version 3 are indexed once, on open, by the migration.
+
+  Metrics (util::metrics):
+   - rxrevolt_merge_*: duration of each non-empty merge, documents merged, and the rate of
+     the latest merge in documents per second.
+   - rxrevolt_snapshot_pin_*: pin latency, bytes uploaded (full file or delta) and pins by
+     result.
+
+  Delta snapshots (SetDeltaMaxChain > 0):
+   - After each pin the file's merkle leaves are kept as '<db>.delta_base' (see
+     ipfs_integration::SnapshotDelta). The next pin diffs the file against them at 4KB
+     (= SQLite page) granularity and pins only a delta of the changed chunks that names the
+     previous CID; peers rebuild the file with SnapshotDelta::Apply.
+   - A full file is pinned instead when there is no base yet, when the chain of deltas would
+     exceed the limit, or when the delta is not clearly smaller (DELTA_MAX_RATIO).
+
+  Sealed snapshots (SetSealedFile):
+   - Merges rewrite the live file in place. SealSnapshot() copies it page for page into a
+     new file that replaces the sealed one, which is what gets pinned, diffed, served and
+     challenged until the next seal; readers of the previous seal are not disturbed.
+*/
+
 class DailySnapshot {
   public:
+    static constexpr size_t DEFAULT_MERGE_CHUNK = 10000;
+    static constexpr int SCHEMA_VERSION = 3;
+    // A delta larger than this fraction of the file is not worth a chain link
+    static constexpr double DELTA_MAX_RATIO = 0.5;
+
     // -------------------------------------------------------------------------
     // Constructor accepting the path or filename to the main .sqlite database
     // -------------------------------------------------------------------------
@@ -27,10 +122,16 @@ class DailySnapshot {
           m_pinnedState(nullptr), m_ipfsEndpoint("http://127.0.0.1:5001") // default IPFS endpoint
     {}
 
+    DailySnapshot(const DailySnapshot&) = delete;
+    DailySnapshot& operator=(const DailySnapshot&) = delete;
+
+    ~DailySnapshot() { CloseDatabase(); }
+
     // -------------------------------------------------------------------------
     // Reads from DocumentQueue, inserts new records or handles removals,
-    // then commits the DB.
-    // Returns true on success.
+    // committing every SetMergeChunkSize() records.
+    // Returns true on success. On failure the failing chunk is rolled back; earlier
+    // chunks stay committed.
     // -------------------------------------------------------------------------
     bool MergePendingDocuments() {
         using namespace rxrevoltchain::util::logger;
@@ -41,129 +142,223 @@ class DailySnapshot {
             return false;
         }
 
-        // Open or create the .sqlite database
-        sqlite3* db = nullptr;
-        if (!openDatabase(db)) {
+        // Open (or reuse) the .sqlite database, schema and statements
+        if (!ensureDatabase()) {
             logger.error("[DailySnapshot] Could not open database: " + m_dbFilePath);
             return false;
         }
 
-        // Create a simple table if it does not exist yet
-        if (!initDatabaseSchema(db)) {
-            logger.error("[DailySnapshot] Failed to initialize database schema.");
-            sqlite3_close(db);
+        // Fetch all transactions at once
+        std::vector<Transaction> transactions = m_docQueue->FetchAll();
+        return mergeFetched(transactions);
+    }
+
+    // -------------------------------------------------------------------------
+    // Merges an already fetched batch exactly like MergePendingDocuments does with the
+    // queue's contents (used by ShardedSnapshot, which partitions one fetch across shards).
+    // -------------------------------------------------------------------------
+    bool MergeTransactions(std::vector<Transaction> transactions) {
+        if (!ensureDatabase()) {
+            rxrevoltchain::util::logger::Logger::getInstance().error(
+                "[DailySnapshot] Could not open database: " + m_dbFilePath);
             return false;
         }
+        return mergeFetched(transactions);
+    }
 
-        // Fetch all transactions at once
-        std::vector<Transaction> transactions = m_docQueue->FetchAll();
-        if (transactions.empty()) {
-            logger.info("[DailySnapshot] No transactions to merge. DB remains unchanged.");
-            sqlite3_close(db);
+    // -------------------------------------------------------------------------
+    // Copies the live database into the sealed file (see SetSealedFile) with the SQLite
+    // backup API. Pages are copied one for one, so unchanged pages keep their bytes and
+    // delta snapshots of the sealed file stay small. The copy is written next to the
+    // sealed file and renamed over it, so a PoP round or a peer still reading the previous
+    // seal keeps its version. No-op without a sealed file.
+    // -------------------------------------------------------------------------
+    bool SealSnapshot() {
+        using namespace rxrevoltchain::util::logger;
+        Logger& logger = Logger::getInstance();
+        if (m_sealedFilePath.empty()) {
             return true;
         }
-
-        // Start a transaction
-        if (!beginTransaction(db)) {
-            logger.error("[DailySnapshot] Could not start transaction for DB merges.");
-            sqlite3_close(db);
+        if (!ensureDatabase()) {
+            logger.error("[DailySnapshot] Could not open database: " + m_dbFilePath);
             return false;
         }
+        checkpoint();
 
-        // Process each transaction
-        for (auto& tx : transactions) {
-            // If there's a PrivacyManager, attempt PII redaction
-            if (m_privacyManager) {
-                // We only do redaction for "document_submission" type payloads (example logic)
-                if (tx.GetType() == "document_submission") {
-                    std::vector<uint8_t> payload = tx.GetPayload();
-                    // Redact in-place
-                    if (!m_privacyManager->RedactPII(payload)) {
-                        logger.warn("[DailySnapshot] RedactPII returned false. Possibly suspicious "
-                                    "data remains.");
-                    }
-                    // Update the transaction's payload with the redacted data
-                    tx.SetPayload(payload);
-
-                    // Check if suspicious
-                    if (m_privacyManager->IsSuspicious(payload)) {
-                        logger.warn(
-                            "[DailySnapshot] PrivacyManager flagged transaction as suspicious.");
-                        // Depending on policy, you might skip insertion or mark it
-                    }
-                }
-            }
-
-            // Insert or remove data from the DB based on transaction type
-            if (tx.GetType() == "document_submission") {
-                if (!insertDocument(db, tx)) {
-                    logger.error("[DailySnapshot] Document insertion failed for a transaction.");
-                    rollbackTransaction(db);
-                    sqlite3_close(db);
-                    return false;
-                }
-            } else if (tx.GetType() == "removal_request") {
-                // This is a simplified approach: we remove matching documents by signature or
-                // metadata
-                if (!removeDocument(db, tx)) {
-                    logger.error("[DailySnapshot] Document removal request failed.");
-                    rollbackTransaction(db);
-                    sqlite3_close(db);
-                    return false;
-                }
-            } else {
-                logger.warn("[DailySnapshot] Unknown transaction type encountered: " +
-                            tx.GetType());
-                // Depending on policy, either skip or treat it as an error
+        const std::string tmpPath = m_sealedFilePath + ".tmp";
+        for (const char* suffix : {"", "-wal", "-shm", "-journal"}) {
+            std::remove((tmpPath + suffix).c_str());
+        }
+        sqlite3* sealed = nullptr;
+        bool ok = sqlite3_open(tmpPath.c_str(), &sealed) == SQLITE_OK;
+        if (ok) {
+            sqlite3_backup* backup = sqlite3_backup_init(sealed, "main", m_db, "main");
+            ok = backup && sqlite3_backup_step(backup, -1) == SQLITE_DONE;
+            if (backup) {
+                sqlite3_backup_finish(backup);
             }
         }
-
-        // Commit the DB changes
-        if (!commitTransaction(db)) {
-            logger.error("[DailySnapshot] Failed to commit transaction to DB.");
-            rollbackTransaction(db);
-            sqlite3_close(db);
-            return false;
+        if (!ok) {
+            logger.error("[DailySnapshot] Could not seal snapshot into " + m_sealedFilePath +
+                         ": " + std::string(sealed ? sqlite3_errmsg(sealed) : "out of memory"));
         }
-
-        logger.info("[DailySnapshot] Merged " + std::to_string(transactions.size()) +
-                    " transactions successfully.");
-        sqlite3_close(db);
-        return true;
+        // Closing the only connection folds its WAL into the file, which is then complete
+        sqlite3_close(sealed);
+        if (ok && std::rename(tmpPath.c_str(), m_sealedFilePath.c_str()) != 0) {
+            logger.error("[DailySnapshot] Could not replace " + m_sealedFilePath + ": " +
+                         std::strerror(errno));
+            ok = false;
+        }
+        if (!ok) {
+            std::remove(tmpPath.c_str());
+        }
+        return ok;
     }
 
     // -------------------------------------------------------------------------
-    // Calls IPFSPinner to pin the updated .sqlite; returns true if pin succeeded.
+    // Calls IPFSPinner to pin the updated .sqlite (or the sealed copy, see SetSealedFile);
+    // returns true if pin succeeded.
     // -------------------------------------------------------------------------
     bool PinCurrentSnapshot() {
         using namespace rxrevoltchain::util::logger;
         Logger& logger = Logger::getInstance();
 
+        // Make sure no committed pages are still only in the -wal file
+        checkpoint();
+
+        Metrics& metrics = Metrics::get();
+        util::metrics::ScopedTimer timer(metrics.pinSeconds);
         try {
-            // In a real system, you might keep a single IPFSPinner around,
-            // or manage it in a config. Here we create on demand:
+            // Cheap to create on demand: connections live in the shared curl handle pool
             ipfs_integration::IPFSPinner pinner(m_ipfsEndpoint);
 
-            std::string cid = pinner.PinSnapshot(m_dbFilePath);
-            if (cid.empty()) {
+            std::vector<uint8_t> delta;
+            const bool isDelta = PrepareDelta(delta);
+            std::string cid = isDelta ? pinner.PinData(pinnedFile() + ".delta", delta)
+                                      : pinner.PinSnapshot(pinnedFile());
+            // A delta names only the changes; PoP and peers need the CID of the whole file
+            const std::string fullCid =
+                isDelta && !cid.empty() ? pinner.HashSnapshot(pinnedFile()) : cid;
+            if (cid.empty() || fullCid.empty()) {
+                metrics.pinsFailed.inc();
                 logger.error("[DailySnapshot] IPFSPinner returned empty CID. Pinning failed.");
                 return false;
             }
+            uint64_t uploaded = delta.size();
+            struct stat st;
+            if (!isDelta && stat(pinnedFile().c_str(), &st) == 0) {
+                uploaded = static_cast<uint64_t>(st.st_size);
+            }
+            metrics.uploadBytes.inc(uploaded);
+            metrics.pinsOk.inc();
+            // Trees built while the file was pinned (delta, PoP prebuild) belong to this CID
+            m_treeCache->AdoptCid(pinnedFile(), fullCid);
 
-            logger.info("[DailySnapshot] Successfully pinned snapshot. CID: " + cid);
+            logger.info(std::string("[DailySnapshot] Successfully pinned ") +
+                        (isDelta ? "delta (" + std::to_string(delta.size()) +
+                                       " bytes, CID: " + cid + ")"
+                                 : std::string("snapshot")) +
+                        ". CID: " + fullCid);
+            // The next delta names this pin (the delta itself, so the chain can be walked)
+            if (m_maxDeltaChain > 0 && !RecordPinnedBase(cid, isDelta)) {
+                logger.warn("[DailySnapshot] Could not record the delta base; the next pin "
+                            "will be a full snapshot.");
+            }
 
             if (m_pinnedState) {
-                m_pinnedState->SetCurrentCID(cid);
-                m_pinnedState->SetLocalFilePath(m_dbFilePath);
+                m_pinnedState->SetCurrentCID(fullCid);
+                m_pinnedState->SetDeltaCID(isDelta ? cid : std::string());
+                m_pinnedState->SetLocalFilePath(pinnedFile());
             }
 
             return true;
         } catch (const std::exception& ex) {
+            metrics.pinsFailed.inc();
             logger.error(std::string("[DailySnapshot] PinCurrentSnapshot exception: ") + ex.what());
             return false;
         }
     }
 
+    // -------------------------------------------------------------------------
+    // Builds the delta of the current file against the last pinned base. Returns false
+    // (leave 'delta' unused, pin the full file) if delta mode is off, there is no usable
+    // base, the chain limit is reached or the delta would not be small enough.
+    // -------------------------------------------------------------------------
+    bool PrepareDelta(std::vector<uint8_t>& delta) {
+        using ipfs_integration::SnapshotDelta;
+        delta.clear();
+        if (m_maxDeltaChain == 0) {
+            return false;
+        }
+        checkpoint();
+        SnapshotDelta::BaseRecord base;
+        if (!SnapshotDelta::LoadBase(SnapshotDelta::BasePathFor(pinnedFile()), base) ||
+            base.depth + 1 > m_maxDeltaChain) {
+            return false;
+        }
+        auto tree = m_treeCache->GetOrBuildCurrent(pinnedFile());
+        if (!tree || !SnapshotDelta::Create(base, *tree, pinnedFile(), m_compression, delta) ||
+            delta.size() > tree->fileSize * DELTA_MAX_RATIO) {
+            delta.clear();
+            return false;
+        }
+        return true;
+    }
+
+    // -------------------------------------------------------------------------
+    // Remembers the current file, pinned as 'cid' (a delta or a full snapshot), as the base
+    // the next delta is diffed against.
+    // -------------------------------------------------------------------------
+    bool RecordPinnedBase(const std::string& cid, bool isDelta) {
+        using ipfs_integration::SnapshotDelta;
+        checkpoint();
+        auto tree = m_treeCache->GetOrBuildCurrent(pinnedFile());
+        if (!tree) {
+            return false;
+        }
+        const std::string path = SnapshotDelta::BasePathFor(pinnedFile());
+        SnapshotDelta::BaseRecord base;
+        uint32_t depth = 0;
+        if (isDelta && SnapshotDelta::LoadBase(path, base)) {
+            depth = base.depth + 1;
+        }
+        base.cid = cid;
+        base.depth = depth;
+        base.tree.format = tree->format;
+        base.tree.chunkSize = tree->chunkSize;
+        base.tree.fileSize = tree->fileSize;
+        base.tree.root = tree->root;
+        const size_t leaves = tree->LeafCount();
+        base.tree.nodes.assign(tree->nodes.begin(), tree->nodes.begin() + leaves * 32);
+        base.tree.levelOffsets = {0, leaves};
+        return SnapshotDelta::SaveBase(path, base);
+    }
+
+    // -------------------------------------------------------------------------
+    // Finalizes cached statements and closes the connection. The next merge reopens it.
+    // -------------------------------------------------------------------------
+    void CloseDatabase() {
+        if (m_insertStmt) {
+            sqlite3_finalize(m_insertStmt);
+            m_insertStmt = nullptr;
+        }
+        for (sqlite3_stmt** stmt : {&m_deleteStmt, &m_addSigTargetStmt, &m_addHashTargetStmt,
+                                    &m_clearSigTargetsStmt, &m_clearHashTargetsStmt}) {
+            if (*stmt) {
+                sqlite3_finalize(*stmt);
+                *stmt = nullptr;
+            }
+        }
+        m_index.Finalize();
+        m_pendingSignatures.clear();
+        m_pendingHashes.clear();
+        m_storedDictionaryId = 0;
+        if (m_db) {
+            sqlite3_close(m_db);
+            m_db = nullptr;
+        }
+    }
+
     // -------------------------------------------------------------------------
     // Registers the queue from which new submissions/removals are read
     // -------------------------------------------------------------------------
@@ -176,10 +371,394 @@ class DailySnapshot {
 
     void SetPinnedState(PinnedState* state) { m_pinnedState = state; }
 
+    // -------------------------------------------------------------------------
+    // Require valid signatures: each merge verifies its submissions in parallel and
+    // drops those that fail (nullptr = accept everything, the default).
+    // -------------------------------------------------------------------------
+    void SetSignatureVerifier(SignatureVerifier* verifier) { m_signatureVerifier = verifier; }
+
     // Optionally, if you want to change the IPFS endpoint for pinning:
     void SetIPFSEndpoint(const std::string& endpoint) { m_ipfsEndpoint = endpoint; }
 
+    // Maximum number of queued records applied per SQLite transaction (at least 1)
+    void SetMergeChunkSize(size_t records) { m_mergeChunkSize = std::max<size_t>(1, records); }
+
+    // Deltas pinned in a row before a full snapshot is pinned again (0 = always full)
+    void SetDeltaMaxChain(uint32_t links) { m_maxDeltaChain = links; }
+
+    // -------------------------------------------------------------------------
+    // Merkle tree cache for the delta base, normally the one PoPConsensus challenges
+    // from, so the pinned file is hashed once (nullptr = a cache of this snapshot's own).
+    // Must outlive the snapshot.
+    // -------------------------------------------------------------------------
+    void SetTreeCache(ipfs_integration::MerkleTreeCache* cache) {
+        m_treeCache = cache ? cache : &m_ownTreeCache;
+    }
+
+    // -------------------------------------------------------------------------
+    // Pin a sealed copy instead of the live file (empty = pin the live file). Merges
+    // rewrite the live file in place, so DailyScheduler always pins a sealed copy:
+    // SealSnapshot() replaces it, and PinCurrentSnapshot, the delta base and the pinned
+    // state then refer to the copy made by the last SealSnapshot().
+    // -------------------------------------------------------------------------
+    void SetSealedFile(const std::string& path) { m_sealedFilePath = path; }
+
+    // -------------------------------------------------------------------------
+    // Called on the merging thread once a merge has committed rows (also when a later
+    // chunk fails after earlier ones committed), e.g. to invalidate the
+    // HttpQueryServer record cache.
+    // -------------------------------------------------------------------------
+    void SetCommitListener(std::function<void()> listener) {
+        m_commitListener = std::move(listener);
+    }
+
+    // -------------------------------------------------------------------------
+    // Codec, level and optional zstd dictionary for payloads inserted from now on.
+    // Falls back to zlib (level capped at 9) if this build lacks the requested codec.
+    // Rows already stored keep the codec they were written with.
+    // -------------------------------------------------------------------------
+    void SetCompression(const util::compression::Options& options) {
+        using namespace util::compression;
+        m_compression = options;
+        if (!codecAvailable(m_compression.codec)) {
+            rxrevoltchain::util::logger::Logger::getInstance().warn(
+                std::string("[DailySnapshot] Codec ") + codecName(m_compression.codec) +
+                " is not available in this build; using zlib.");
+            m_compression.codec = Codec::Zlib;
+        }
+        if (m_compression.codec == Codec::Zlib) {
+            m_compression.level = std::max(0, std::min(9, m_compression.level));
+            m_compression.dictionary.reset();
+        }
+    }
+
+    const util::compression::Options& GetCompression() const { return m_compression; }
+
+    // -------------------------------------------------------------------------
+    // Trains a zstd dictionary from up to 'sampleCount' of the most recent stored payloads
+    // and switches new inserts to zstd with it. Returns false if zstd is unavailable or
+    // there are too few samples to train on; the current settings are kept then.
+    // -------------------------------------------------------------------------
+    bool TrainCompressionDictionary(size_t sampleCount = 1000, size_t capacity = 64 * 1024) {
+        using namespace util::compression;
+        if (!codecAvailable(Codec::Zstd) || !ensureDatabase()) {
+            return false;
+        }
+        sqlite3_stmt* stmt = nullptr;
+        if (sqlite3_prepare_v2(m_db,
+                               "SELECT payload, codec FROM documents ORDER BY id DESC LIMIT ?;",
+                               -1, &stmt, nullptr) != SQLITE_OK) {
+            return false;
+        }
+        sqlite3_bind_int64(stmt, 1, static_cast<sqlite3_int64>(sampleCount));
+        std::vector<std::vector<uint8_t>> samples;
+        std::vector<uint8_t> plain;
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            const uint8_t* blob = static_cast<const uint8_t*>(sqlite3_column_blob(stmt, 0));
+            const size_t len = static_cast<size_t>(sqlite3_column_bytes(stmt, 0));
+            const Codec codec = static_cast<Codec>(sqlite3_column_int(stmt, 1));
+            // Rows compressed against some other dictionary are skipped
+            if (decompress(codec, blob, len, plain, MAX_PAYLOAD_BYTES,
+                           m_compression.dictionary.get()) &&
+                !plain.empty()) {
+                samples.push_back(plain);
+            }
+        }
+        sqlite3_finalize(stmt);
+
+        std::shared_ptr<Dictionary> dict =
+            Dictionary::Train(samples, capacity, m_compression.level);
+        if (!dict) {
+            rxrevoltchain::util::logger::Logger::getInstance().warn(
+                "[DailySnapshot] Dictionary training failed (" + std::to_string(samples.size()) +
+                " samples).");
+            return false;
+        }
+        m_compression.codec = Codec::Zstd;
+        m_compression.dictionary = dict;
+        rxrevoltchain::util::logger::Logger::getInstance().info(
+            "[DailySnapshot] Trained a " + std::to_string(dict->bytes().size()) +
+            "-byte zstd dictionary (id " + std::to_string(dict->id()) + ") from " +
+            std::to_string(samples.size()) + " payloads.");
+        return true;
+    }
+
   private:
+    // Output of the redaction / compression stage for one chunk (see prepareChunk)
+    struct PreparedChunk {
+        std::vector<Transaction*> submissions;
+        std::vector<const std::vector<uint8_t>*> payloads;
+        std::vector<std::vector<uint8_t>> compressed; // one per submission, in queue order
+        std::vector<DocumentIndex::Entry> indexEntries;
+    };
+
+    // Shared by every DailySnapshot instance
+    struct Metrics {
+        util::metrics::Histogram& mergeSeconds;
+        util::metrics::Counter& mergedDocuments;
+        util::metrics::Gauge& mergeRate;
+        util::metrics::Histogram& pinSeconds;
+        util::metrics::Counter& uploadBytes;
+        util::metrics::Counter& pinsOk;
+        util::metrics::Counter& pinsFailed;
+
+        static Metrics& get() {
+            using util::metrics::Registry;
+            Registry& r = Registry::getInstance();
+            static const char* pins = "PinCurrentSnapshot calls by result.";
+            static Metrics metrics{
+                r.histogram("rxrevolt_merge_duration_seconds",
+                            "Time spent in MergePendingDocuments with documents to merge."),
+                r.counter("rxrevolt_merge_documents_total", "Documents merged into snapshots."),
+                r.gauge("rxrevolt_merge_documents_per_second",
+                        "Merge throughput of the latest MergePendingDocuments."),
+                r.histogram("rxrevolt_snapshot_pin_duration_seconds",
+                            "Time spent in PinCurrentSnapshot, upload included."),
+                r.counter("rxrevolt_snapshot_upload_bytes_total",
+                          "Bytes of full snapshots and deltas pinned to IPFS."),
+                r.counter("rxrevolt_snapshot_pins_total", pins, "result=\"ok\""),
+                r.counter("rxrevolt_snapshot_pins_total", pins, "result=\"failed\"")};
+            return metrics;
+        }
+    };
+
+    // -------------------------------------------------------------------------
+    // Helper: redact (if configured) the submissions in [start, end) and extract their
+    // index entries, then compress their payloads into 'chunk'; both stages run in
+    // parallel and keep queue order. Runs as a ThreadPool task (see MergePendingDocuments).
+    // -------------------------------------------------------------------------
+    bool prepareChunk(std::vector<Transaction>& transactions, size_t start, size_t end,
+                      PreparedChunk& chunk) const {
+        chunk.submissions.clear();
+        for (size_t i = start; i < end; ++i) {
+            if (transactions[i].GetType() == "document_submission") {
+                chunk.submissions.push_back(&transactions[i]);
+            }
+        }
+        chunk.indexEntries.resize(chunk.submissions.size());
+        util::ThreadPool::getInstance().parallelFor(
+            chunk.submissions.size(), 8, [this, &chunk](size_t begin, size_t last) {
+                for (size_t i = begin; i < last; ++i) {
+                    Transaction& tx = *chunk.submissions[i];
+                    redactTransaction(tx);
+                    chunk.indexEntries[i] = DocumentIndex::Extract(tx.GetPayload());
+                }
+            });
+        chunk.payloads.clear();
+        for (const Transaction* tx : chunk.submissions) {
+            chunk.payloads.push_back(&tx->GetPayload());
+        }
+        return util::compression::compressBatch(m_compression, chunk.payloads, chunk.compressed);
+    }
+
+    // -------------------------------------------------------------------------
+    // Helper: the body of MergePendingDocuments / MergeTransactions once the database is
+    // open: verify, then redact, compress and write the batch chunk by chunk
+    // -------------------------------------------------------------------------
+    bool mergeFetched(std::vector<Transaction>& transactions) {
+        using namespace rxrevoltchain::util::logger;
+        Logger& logger = Logger::getInstance();
+
+        // Forged submissions never reach insertDocument (checked before redaction)
+        if (m_signatureVerifier) {
+            dropUnverified(transactions);
+        }
+        if (transactions.empty()) {
+            logger.info("[DailySnapshot] No transactions to merge. DB remains unchanged.");
+            return true;
+        }
+        Metrics& metrics = Metrics::get();
+        util::metrics::ScopedTimer timer(metrics.mergeSeconds);
+
+        if (!storeDictionary()) {
+            logger.error("[DailySnapshot] Could not store the compression dictionary.");
+            return false;
+        }
+
+        // Two-stage pipeline: while chunk N is written, chunk N+1 is redacted, indexed and
+        // compressed on the ThreadPool. The stages alternate between the two m_chunks.
+        // submit() rather than enqueue(): a merge running on a pool worker (or with every
+        // worker busy) prepares the chunk itself instead of waiting for a free worker.
+        auto prepareAsync = [this, &transactions](size_t start, PreparedChunk& chunk) {
+            return util::ThreadPool::getInstance().submit([this, &transactions, start, &chunk] {
+                const size_t end = std::min(transactions.size(), start + m_mergeChunkSize);
+                return prepareChunk(transactions, start, end, chunk);
+            });
+        };
+        util::ThreadPool::TaskHandle<bool> next = prepareAsync(0, m_chunks[0]);
+        // Never return while the next chunk is being prepared: it works on 'transactions'
+        auto abort = [this, &next](bool committed) {
+            if (next.valid()) {
+                next.wait();
+            }
+            notifyCommitted(committed);
+            return false;
+        };
+
+        size_t chunkIndex = 0;
+        for (size_t start = 0; start < transactions.size(); start += m_mergeChunkSize) {
+            const size_t end = std::min(transactions.size(), start + m_mergeChunkSize);
+            PreparedChunk& chunk = m_chunks[chunkIndex++ % 2];
+
+            // Redaction and compression happened outside the write transaction
+            if (!next.get()) {
+                logger.error("[DailySnapshot] Payload compression failed.");
+                return abort(start > 0);
+            }
+            if (end < transactions.size()) {
+                next = prepareAsync(end, m_chunks[chunkIndex % 2]);
+            }
+
+            // Start a transaction for this chunk
+            if (!beginTransaction(m_db)) {
+                logger.error("[DailySnapshot] Could not start transaction for DB merges.");
+                return abort(start > 0);
+            }
+
+            size_t nextBlob = 0;
+            for (size_t i = start; i < end; ++i) {
+                if (!applyTransaction(transactions[i], chunk, nextBlob)) {
+                    clearPendingRemovals();
+                    rollbackTransaction(m_db);
+                    return abort(start > 0);
+                }
+            }
+            if (!flushRemovals()) {
+                logger.error("[DailySnapshot] Document removal request failed.");
+                clearPendingRemovals();
+                rollbackTransaction(m_db);
+                return abort(start > 0);
+            }
+
+            // Commit the chunk
+            if (!commitTransaction(m_db)) {
+                logger.error("[DailySnapshot] Failed to commit transaction to DB.");
+                rollbackTransaction(m_db);
+                return abort(start > 0);
+            }
+        }
+
+        checkpoint();
+        notifyCommitted(true);
+        const double seconds = timer.elapsedSeconds();
+        metrics.mergedDocuments.inc(transactions.size());
+        if (seconds > 0) {
+            metrics.mergeRate.set(static_cast<double>(transactions.size()) / seconds);
+        }
+        logger.info("[DailySnapshot] Merged " + std::to_string(transactions.size()) +
+                    " transactions successfully.");
+        return true;
+    }
+
+    // -------------------------------------------------------------------------
+    // Helper: verify every submission of a fetched batch and remove the ones whose
+    // signature does not check out, keeping queue order
+    // -------------------------------------------------------------------------
+    void dropUnverified(std::vector<Transaction>& transactions) const {
+        const std::vector<char> valid = m_signatureVerifier->VerifyBatch(transactions);
+        size_t kept = 0;
+        for (size_t i = 0; i < transactions.size(); ++i) {
+            if (valid[i]) {
+                if (kept != i) {
+                    transactions[kept] = std::move(transactions[i]);
+                }
+                ++kept;
+            }
+        }
+        if (kept != transactions.size()) {
+            util::logger::Logger::getInstance().warn(
+                "[DailySnapshot] Dropped " + std::to_string(transactions.size() - kept) +
+                " submission(s) with an invalid signature.");
+            transactions.resize(kept);
+        }
+    }
+
+    // -------------------------------------------------------------------------
+    // Helper: PII redaction of a submission's payload, in place (runs on ThreadPool workers)
+    // -------------------------------------------------------------------------
+    void redactTransaction(Transaction& tx) const {
+        // If there's a PrivacyManager, redact and check for suspicious content in one pass
+        if (m_privacyManager) {
+            // Redact in-place on the transaction's own buffer
+            const PrivacyManager::Report report = m_privacyManager->Scan(tx.MutablePayload());
+            if (report.suspicious) {
+                util::logger::Logger::getInstance().warn(
+                    "[DailySnapshot] PrivacyManager flagged transaction as suspicious.");
+                // Depending on policy, you might skip insertion or mark it
+            }
+        }
+    }
+
+    // -------------------------------------------------------------------------
+    // Helper: apply one prepared transaction. 'nextBlob' indexes the compressed payload
+    // of the next submission in 'chunk'.
+    // -------------------------------------------------------------------------
+    bool applyTransaction(const Transaction& tx, const PreparedChunk& chunk, size_t& nextBlob) {
+        using namespace rxrevoltchain::util::logger;
+        Logger& logger = Logger::getInstance();
+
+        // Insert or remove data from the DB based on transaction type
+        if (tx.GetType() == "document_submission") {
+            const size_t slot = nextBlob++;
+            const std::vector<uint8_t>& blob = chunk.compressed[slot];
+            const util::hashing::Digest contentHash = util::hashing::sha256Raw(tx.GetPayload());
+            if (matchesPendingRemoval(tx.GetSignature(), contentHash) && !flushRemovals()) {
+                logger.error("[DailySnapshot] Document removal request failed.");
+                return false;
+            }
+            if (!insertDocument(tx, contentHash, blob)) {
+                logger.error("[DailySnapshot] Document insertion failed for a transaction.");
+                return false;
+            }
+            if (!m_index.Insert(sqlite3_last_insert_rowid(m_db), tx.GetMetadata(),
+                                chunk.indexEntries[slot])) {
+                logger.error("[DailySnapshot] Indexing failed for a transaction: " +
+                             std::string(sqlite3_errmsg(m_db)));
+                return false;
+            }
+        } else if (tx.GetType() == "removal_request") {
+            // Targets are resolved in bulk by flushRemovals()
+            if (!queueRemoval(tx)) {
+                logger.error("[DailySnapshot] Document removal request failed.");
+                return false;
+            }
+        } else {
+            logger.warn("[DailySnapshot] Unknown transaction type encountered: " + tx.GetType());
+            // Depending on policy, either skip or treat it as an error
+        }
+        return true;
+    }
+
+    // -------------------------------------------------------------------------
+    // Helper: make sure m_db is open on the current m_dbFilePath, with pragmas,
+    // schema and cached statements. Reopens if the file was removed or replaced.
+    // -------------------------------------------------------------------------
+    bool ensureDatabase() {
+        struct stat st;
+        const bool exists = (::stat(m_dbFilePath.c_str(), &st) == 0);
+        if (m_db && exists && st.st_dev == m_dbDev && st.st_ino == m_dbIno) {
+            return true;
+        }
+        CloseDatabase();
+
+        if (!openDatabase(m_db)) {
+            CloseDatabase();
+            return false;
+        }
+        if (!configureConnection(m_db) || !initDatabaseSchema(m_db) || !migrateSchema(m_db) ||
+            !prepareStatements()) {
+            rxrevoltchain::util::logger::Logger::getInstance().error(
+                "[DailySnapshot] Failed to initialize database schema.");
+            CloseDatabase();
+            return false;
+        }
+        if (::stat(m_dbFilePath.c_str(), &st) == 0) {
+            m_dbDev = st.st_dev;
+            m_dbIno = st.st_ino;
+        }
+        return true;
+    }
+
     // -------------------------------------------------------------------------
     // Helper: open the SQLite database at m_dbFilePath, create if needed
     // -------------------------------------------------------------------------
@@ -188,6 +767,20 @@ class DailySnapshot {
         return (rc == SQLITE_OK && db != nullptr);
     }
 
+    // -------------------------------------------------------------------------
+    // Helper: connection pragmas for bulk merges. WAL + synchronous=NORMAL keeps
+    // commits crash-safe (a crash can only lose the last commits, never corrupt)
+    // while avoiding an fsync per commit.
+    // -------------------------------------------------------------------------
+    bool configureConnection(sqlite3* db) {
+        sqlite3_busy_timeout(db, 5000);
+        const char* pragmas = "PRAGMA journal_mode=WAL;"
+                              "PRAGMA synchronous=NORMAL;"
+                              "PRAGMA cache_size=-65536;" // 64 MiB
+                              "PRAGMA temp_store=MEMORY;";
+        return sqlite3_exec(db, pragmas, nullptr, nullptr, nullptr) == SQLITE_OK;
+    }
+
     // -------------------------------------------------------------------------
     // Helper: create minimal schema if needed
     // For demonstration, we store transactions in a "documents" table
@@ -198,8 +791,18 @@ class DailySnapshot {
                           " signature BLOB,"
                           " metadata TEXT,"
                           " payload BLOB,"
-                          " created_at DATETIME DEFAULT CURRENT_TIMESTAMP"
-                          ");";
+                          " created_at DATETIME DEFAULT CURRENT_TIMESTAMP,"
+                          " content_hash BLOB,"
+                          " codec INTEGER NOT NULL DEFAULT 0"
+                          ");"
+                          "CREATE TABLE IF NOT EXISTS dictionaries ("
+                          " id INTEGER PRIMARY KEY,"
+                          " data BLOB NOT NULL"
+                          ");"
+                          "CREATE TEMP TABLE IF NOT EXISTS removal_signatures ("
+                          " signature BLOB PRIMARY KEY) WITHOUT ROWID;"
+                          "CREATE TEMP TABLE IF NOT EXISTS removal_hashes ("
+                          " content_hash BLOB PRIMARY KEY) WITHOUT ROWID;";
 
         char* errMsg = nullptr;
         int rc = sqlite3_exec(db, ddl, nullptr, nullptr, &errMsg);
@@ -211,9 +814,239 @@ class DailySnapshot {
             }
             return false;
         }
+        return m_index.CreateSchema(db);
+    }
+
+    // -------------------------------------------------------------------------
+    // Helper: bring an existing snapshot up to SCHEMA_VERSION
+    //   0 -> 1: add content_hash (if the table predates it), index signature and
+    //           content_hash, backfill content_hash for existing rows.
+    //   1 -> 2: add codec (if the table predates it); existing rows are zlib (0).
+    //   2 -> 3: index existing rows (DocumentIndex tables are created by initDatabaseSchema).
+    // -------------------------------------------------------------------------
+    bool migrateSchema(sqlite3* db) {
+        using namespace rxrevoltchain::util::logger;
+        int version = 0;
+        sqlite3_stmt* stmt = nullptr;
+        if (sqlite3_prepare_v2(db, "PRAGMA user_version;", -1, &stmt, nullptr) != SQLITE_OK) {
+            return false;
+        }
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            version = sqlite3_column_int(stmt, 0);
+        }
+        sqlite3_finalize(stmt);
+        if (version >= SCHEMA_VERSION) {
+            return true;
+        }
+
+        if (!beginTransaction(db)) {
+            return false;
+        }
+        bool ok = true;
+        size_t backfilled = 0;
+        size_t indexed = 0;
+        if (version < 1) {
+            if (!hasColumn(db, "documents", "content_hash")) {
+                ok = sqlite3_exec(db, "ALTER TABLE documents ADD COLUMN content_hash BLOB;",
+                                  nullptr, nullptr, nullptr) == SQLITE_OK;
+            }
+            ok = ok && sqlite3_exec(db,
+                                    "CREATE INDEX IF NOT EXISTS idx_documents_signature"
+                                    " ON documents(signature);"
+                                    "CREATE INDEX IF NOT EXISTS idx_documents_content_hash"
+                                    " ON documents(content_hash);",
+                                    nullptr, nullptr, nullptr) == SQLITE_OK;
+            ok = ok && backfillContentHashes(db, backfilled);
+        }
+        if (version < 2 && !hasColumn(db, "documents", "codec")) {
+            ok = ok && sqlite3_exec(db,
+                                    "ALTER TABLE documents ADD COLUMN codec INTEGER NOT NULL"
+                                    " DEFAULT 0;",
+                                    nullptr, nullptr, nullptr) == SQLITE_OK;
+        }
+        if (version < 3) {
+            ok = ok && backfillIndex(db, indexed);
+        }
+        ok = ok && sqlite3_exec(db,
+                                ("PRAGMA user_version=" + std::to_string(SCHEMA_VERSION) + ";")
+                                    .c_str(),
+                                nullptr, nullptr, nullptr) == SQLITE_OK;
+        if (!ok || !commitTransaction(db)) {
+            Logger::getInstance().error("[DailySnapshot] Schema migration failed: " +
+                                        std::string(sqlite3_errmsg(db)));
+            rollbackTransaction(db);
+            return false;
+        }
+        Logger::getInstance().info("[DailySnapshot] Migrated schema from version " +
+                                   std::to_string(version) + " to " +
+                                   std::to_string(SCHEMA_VERSION) + " (content hashes for " +
+                                   std::to_string(backfilled) + " and index entries for " +
+                                   std::to_string(indexed) + " existing rows).");
         return true;
     }
 
+    static bool hasColumn(sqlite3* db, const std::string& table, const std::string& column) {
+        sqlite3_stmt* stmt = nullptr;
+        const std::string sql = "PRAGMA table_info(" + table + ");";
+        if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+            return false;
+        }
+        bool found = false;
+        while (!found && sqlite3_step(stmt) == SQLITE_ROW) {
+            const unsigned char* name = sqlite3_column_text(stmt, 1);
+            found = name && column == reinterpret_cast<const char*>(name);
+        }
+        sqlite3_finalize(stmt);
+        return found;
+    }
+
+    // Computes content_hash for rows stored before the column existed (all zlib)
+    bool backfillContentHashes(sqlite3* db, size_t& count) {
+        sqlite3_stmt* select = nullptr;
+        sqlite3_stmt* update = nullptr;
+        bool ok =
+            sqlite3_prepare_v2(db, "SELECT id, payload FROM documents WHERE content_hash IS NULL;",
+                               -1, &select, nullptr) == SQLITE_OK &&
+            sqlite3_prepare_v2(db, "UPDATE documents SET content_hash = ? WHERE id = ?;", -1,
+                               &update, nullptr) == SQLITE_OK;
+        std::vector<uint8_t> plain;
+        while (ok && sqlite3_step(select) == SQLITE_ROW) {
+            const uint8_t* blob = static_cast<const uint8_t*>(sqlite3_column_blob(select, 1));
+            const size_t len = static_cast<size_t>(sqlite3_column_bytes(select, 1));
+            if (!util::compression::decompress(util::compression::Codec::Zlib, blob, len, plain,
+                                               util::compression::MAX_PAYLOAD_BYTES)) {
+                continue; // unreadable payload: leave it unhashed
+            }
+            const util::hashing::Digest digest = util::hashing::sha256Raw(plain);
+            sqlite3_reset(update);
+            sqlite3_bind_blob(update, 1, digest.data(), static_cast<int>(digest.size()),
+                              SQLITE_TRANSIENT);
+            sqlite3_bind_int64(update, 2, sqlite3_column_int64(select, 0));
+            ok = (sqlite3_step(update) == SQLITE_DONE);
+            ++count;
+        }
+        sqlite3_finalize(select);
+        sqlite3_finalize(update);
+        return ok;
+    }
+
+    // Indexes rows stored before DocumentIndex existed, decoding each payload by its codec
+    bool backfillIndex(sqlite3* db, size_t& count) {
+        using namespace rxrevoltchain::util::compression;
+        sqlite3_stmt* select = nullptr;
+        sqlite3_stmt* dictionary = nullptr;
+        bool ok = m_index.Prepare(db) &&
+                  sqlite3_prepare_v2(db, "SELECT id, metadata, payload, codec FROM documents;",
+                                     -1, &select, nullptr) == SQLITE_OK &&
+                  sqlite3_prepare_v2(db, "SELECT data FROM dictionaries WHERE id = ?;", -1,
+                                     &dictionary, nullptr) == SQLITE_OK;
+        std::map<uint32_t, std::shared_ptr<Dictionary>> dictionaries;
+        std::vector<uint8_t> plain;
+        while (ok && sqlite3_step(select) == SQLITE_ROW) {
+            const unsigned char* meta = sqlite3_column_text(select, 1);
+            const uint8_t* blob = static_cast<const uint8_t*>(sqlite3_column_blob(select, 2));
+            const size_t len = static_cast<size_t>(sqlite3_column_bytes(select, 2));
+            const Codec codec = static_cast<Codec>(sqlite3_column_int(select, 3));
+            const uint32_t dictId = codec == Codec::Zstd ? frameDictionaryId(blob, len) : 0;
+            if (dictId != 0 && !dictionaries.count(dictId)) {
+                sqlite3_reset(dictionary);
+                sqlite3_bind_int64(dictionary, 1, static_cast<sqlite3_int64>(dictId));
+                std::shared_ptr<Dictionary>& dict = dictionaries[dictId];
+                if (sqlite3_step(dictionary) == SQLITE_ROW) {
+                    const uint8_t* data =
+                        static_cast<const uint8_t*>(sqlite3_column_blob(dictionary, 0));
+                    dict = Dictionary::FromBytes(std::vector<uint8_t>(
+                        data, data + sqlite3_column_bytes(dictionary, 0)));
+                }
+            }
+            const Dictionary* dict = dictId != 0 ? dictionaries[dictId].get() : nullptr;
+            if (!decompress(codec, blob, len, plain, MAX_PAYLOAD_BYTES, dict)) {
+                continue; // unreadable payload: leave it unindexed
+            }
+            ok = m_index.Insert(sqlite3_column_int64(select, 0),
+                                meta ? reinterpret_cast<const char*>(meta) : "",
+                                DocumentIndex::Extract(plain));
+            ++count;
+        }
+        sqlite3_finalize(select);
+        sqlite3_finalize(dictionary);
+        return ok;
+    }
+
+    // -------------------------------------------------------------------------
+    // Helper: prepare the statements reused by every merge on this connection
+    // -------------------------------------------------------------------------
+    bool prepareStatements() {
+        const char* insertSql =
+            "INSERT INTO documents (signature, metadata, payload, content_hash, codec)"
+            " VALUES (?, ?, ?, ?, ?);";
+        const char* deleteSql =
+            "DELETE FROM documents"
+            " WHERE signature IN (SELECT signature FROM temp.removal_signatures)"
+            " OR content_hash IN (SELECT content_hash FROM temp.removal_hashes);";
+        const char* addSigSql = "INSERT OR IGNORE INTO temp.removal_signatures VALUES (?);";
+        const char* addHashSql = "INSERT OR IGNORE INTO temp.removal_hashes VALUES (?);";
+        return sqlite3_prepare_v2(m_db, insertSql, -1, &m_insertStmt, nullptr) == SQLITE_OK &&
+               sqlite3_prepare_v2(m_db, deleteSql, -1, &m_deleteStmt, nullptr) == SQLITE_OK &&
+               sqlite3_prepare_v2(m_db, addSigSql, -1, &m_addSigTargetStmt, nullptr) ==
+                   SQLITE_OK &&
+               sqlite3_prepare_v2(m_db, addHashSql, -1, &m_addHashTargetStmt, nullptr) ==
+                   SQLITE_OK &&
+               sqlite3_prepare_v2(m_db, "DELETE FROM temp.removal_signatures;", -1,
+                                  &m_clearSigTargetsStmt, nullptr) == SQLITE_OK &&
+               sqlite3_prepare_v2(m_db, "DELETE FROM temp.removal_hashes;", -1,
+                                  &m_clearHashTargetsStmt, nullptr) == SQLITE_OK &&
+               m_index.Prepare(m_db);
+    }
+
+    // -------------------------------------------------------------------------
+    // Helper: record the current zstd dictionary in the snapshot, once per connection
+    // -------------------------------------------------------------------------
+    bool storeDictionary() {
+        const auto& dict = m_compression.dictionary;
+        if (!dict || m_compression.codec != util::compression::Codec::Zstd ||
+            m_storedDictionaryId == dict->id()) {
+            return true;
+        }
+        sqlite3_stmt* stmt = nullptr;
+        if (sqlite3_prepare_v2(m_db, "INSERT OR IGNORE INTO dictionaries (id, data) VALUES (?, ?);",
+                               -1, &stmt, nullptr) != SQLITE_OK) {
+            return false;
+        }
+        sqlite3_bind_int64(stmt, 1, static_cast<sqlite3_int64>(dict->id()));
+        sqlite3_bind_blob(stmt, 2, dict->bytes().data(), static_cast<int>(dict->bytes().size()),
+                          SQLITE_STATIC);
+        const bool ok = (sqlite3_step(stmt) == SQLITE_DONE);
+        sqlite3_finalize(stmt);
+        if (ok) {
+            m_storedDictionaryId = dict->id();
+        }
+        return ok;
+    }
+
+    // -------------------------------------------------------------------------
+    // Helper: fold the WAL back into the main database file
+    // -------------------------------------------------------------------------
+    void checkpoint() {
+        if (m_db && sqlite3_wal_checkpoint_v2(m_db, nullptr, SQLITE_CHECKPOINT_TRUNCATE, nullptr,
+                                              nullptr) != SQLITE_OK) {
+            rxrevoltchain::util::logger::Logger::getInstance().warn(
+                "[DailySnapshot] WAL checkpoint did not complete: " +
+                std::string(sqlite3_errmsg(m_db)));
+        }
+    }
+
+    // The file that gets pinned: the sealed copy if there is one, else the live database
+    const std::string& pinnedFile() const {
+        return m_sealedFilePath.empty() ? m_dbFilePath : m_sealedFilePath;
+    }
+
+    void notifyCommitted(bool committed) {
+        if (committed && m_commitListener) {
+            m_commitListener();
+        }
+    }
+
     // -------------------------------------------------------------------------
     // Helper: begin a transaction
     // -------------------------------------------------------------------------
@@ -239,92 +1072,174 @@ class DailySnapshot {
     }
 
     // -------------------------------------------------------------------------
-    // Helper: insert a new document into the DB
+    // Helper: insert a new document into the DB using the cached INSERT statement
     // -------------------------------------------------------------------------
-    bool insertDocument(sqlite3* db, const Transaction& tx) {
-        // Prepare statement
-        const char* sql = "INSERT INTO documents (signature, metadata, payload) VALUES (?, ?, ?);";
-        sqlite3_stmt* stmt = nullptr;
-        int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
-        if (rc != SQLITE_OK || !stmt) {
-            return false;
-        }
+    bool insertDocument(const Transaction& tx, const util::hashing::Digest& contentHash,
+                        const std::vector<uint8_t>& blob) {
+        sqlite3_stmt* stmt = m_insertStmt;
+        sqlite3_reset(stmt);
+        sqlite3_clear_bindings(stmt);
 
         // Bind params
         // signature -> BLOB
-        rc = sqlite3_bind_blob(stmt, 1, tx.GetSignature().data(),
-                               static_cast<int>(tx.GetSignature().size()), SQLITE_STATIC);
+        int rc = sqlite3_bind_blob(stmt, 1, tx.GetSignature().data(),
+                                   static_cast<int>(tx.GetSignature().size()), SQLITE_STATIC);
         if (rc != SQLITE_OK) {
-            sqlite3_finalize(stmt);
             return false;
         }
 
         // metadata -> TEXT
         rc = sqlite3_bind_text(stmt, 2, tx.GetMetadata().c_str(), -1, SQLITE_STATIC);
         if (rc != SQLITE_OK) {
-            sqlite3_finalize(stmt);
             return false;
         }
 
-        // payload -> BLOB (compressed)
-        std::vector<uint8_t> compressed;
-        uLongf outSize = compressBound(tx.GetPayload().size());
-        compressed.resize(outSize);
-        if (compress2(compressed.data(), &outSize, tx.GetPayload().data(), tx.GetPayload().size(),
-                      Z_BEST_COMPRESSION) != Z_OK) {
-            sqlite3_finalize(stmt);
+        // payload -> BLOB (already compressed by prepareChunk)
+        rc = sqlite3_bind_blob(stmt, 3, blob.data(), static_cast<int>(blob.size()),
+                               SQLITE_STATIC);
+        if (rc != SQLITE_OK) {
             return false;
         }
-        compressed.resize(outSize);
 
-        rc = sqlite3_bind_blob(stmt, 3, compressed.data(), static_cast<int>(compressed.size()),
+        // content_hash -> BLOB (SHA-256 of the stored payload, indexed for removals)
+        rc = sqlite3_bind_blob(stmt, 4, contentHash.data(), static_cast<int>(contentHash.size()),
                                SQLITE_STATIC);
         if (rc != SQLITE_OK) {
-            sqlite3_finalize(stmt);
+            return false;
+        }
+
+        // codec -> INTEGER (how the payload blob was compressed)
+        rc = sqlite3_bind_int(stmt, 5, static_cast<int>(m_compression.codec));
+        if (rc != SQLITE_OK) {
             return false;
         }
 
         // Execute
         rc = sqlite3_step(stmt);
-        sqlite3_finalize(stmt);
+        sqlite3_reset(stmt);
         return (rc == SQLITE_DONE);
     }
 
     // -------------------------------------------------------------------------
-    // Helper: remove a document from the DB (example approach)
-    // We assume the "signature" from the removal request identifies the record(s) to remove.
+    // Helper: record the targets of a removal request for the next flushRemovals()
+    // Targets are the request's signature plus any 32-byte content hashes in its payload.
     // -------------------------------------------------------------------------
-    bool removeDocument(sqlite3* db, const Transaction& tx) {
-        // In a real system, you'd have a more robust way to match which doc
-        // is being removed. For demonstration, we'll match on signature.
+    bool queueRemoval(const Transaction& tx) {
+        const std::vector<uint8_t>& sig = tx.GetSignature();
+        if (!sig.empty()) {
+            if (!bindAndStep(m_addSigTargetStmt, sig.data(), sig.size())) {
+                return false;
+            }
+            m_pendingSignatures.insert(sig);
+        }
 
-        const char* sql = "DELETE FROM documents WHERE signature = ?;";
-        sqlite3_stmt* stmt = nullptr;
-        int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
-        if (rc != SQLITE_OK || !stmt) {
-            return false;
+        const std::vector<uint8_t>& payload = tx.GetPayload();
+        if (!payload.empty() && payload.size() % 32 == 0) {
+            for (size_t off = 0; off < payload.size(); off += 32) {
+                if (!bindAndStep(m_addHashTargetStmt, payload.data() + off, 32)) {
+                    return false;
+                }
+                util::hashing::Digest hash;
+                std::memcpy(hash.data(), payload.data() + off, hash.size());
+                m_pendingHashes.insert(hash);
+            }
         }
+        return true;
+    }
 
-        rc = sqlite3_bind_blob(stmt, 1, tx.GetSignature().data(),
-                               static_cast<int>(tx.GetSignature().size()), SQLITE_STATIC);
-        if (rc != SQLITE_OK) {
-            sqlite3_finalize(stmt);
+    bool matchesPendingRemoval(const std::vector<uint8_t>& sig,
+                               const util::hashing::Digest& contentHash) const {
+        if (m_pendingSignatures.empty() && m_pendingHashes.empty()) {
             return false;
         }
+        return m_pendingSignatures.count(sig) || m_pendingHashes.count(contentHash);
+    }
 
-        rc = sqlite3_step(stmt);
-        sqlite3_finalize(stmt);
-
+    // -------------------------------------------------------------------------
+    // Helper: delete every row matching the queued removal targets in one statement
+    // (index lookups on signature / content_hash), then clear the targets.
+    // -------------------------------------------------------------------------
+    bool flushRemovals() {
+        if (m_pendingSignatures.empty() && m_pendingHashes.empty()) {
+            return true;
+        }
+        sqlite3_reset(m_deleteStmt);
+        const int rc = sqlite3_step(m_deleteStmt);
+        sqlite3_reset(m_deleteStmt);
+        clearPendingRemovals();
         // rc == SQLITE_DONE means success (even if it removed zero rows)
         return (rc == SQLITE_DONE);
     }
 
+    void clearPendingRemovals() {
+        for (sqlite3_stmt* stmt : {m_clearSigTargetsStmt, m_clearHashTargetsStmt}) {
+            if (stmt) {
+                sqlite3_reset(stmt);
+                sqlite3_step(stmt);
+                sqlite3_reset(stmt);
+            }
+        }
+        m_pendingSignatures.clear();
+        m_pendingHashes.clear();
+    }
+
+    static bool bindAndStep(sqlite3_stmt* stmt, const uint8_t* data, size_t len) {
+        sqlite3_reset(stmt);
+        if (sqlite3_bind_blob(stmt, 1, data, static_cast<int>(len), SQLITE_TRANSIENT) !=
+            SQLITE_OK) {
+            return false;
+        }
+        const int rc = sqlite3_step(stmt);
+        sqlite3_reset(stmt);
+        return rc == SQLITE_DONE;
+    }
+
   private:
     std::string m_dbFilePath;
+    std::string m_sealedFilePath; // see SetSealedFile
     DocumentQueue* m_docQueue;
     PrivacyManager* m_privacyManager;
     PinnedState* m_pinnedState;
     std::string m_ipfsEndpoint; // Where we'll pin the snapshot
+    size_t m_mergeChunkSize = DEFAULT_MERGE_CHUNK;
+    std::function<void()> m_commitListener;
+    SignatureVerifier* m_signatureVerifier = nullptr; // see SetSignatureVerifier
+
+    // Persistent connection state (see ensureDatabase)
+    sqlite3* m_db = nullptr;
+    sqlite3_stmt* m_insertStmt = nullptr;
+    sqlite3_stmt* m_deleteStmt = nullptr; // bulk DELETE against the temp target tables
+    sqlite3_stmt* m_addSigTargetStmt = nullptr;
+    sqlite3_stmt* m_addHashTargetStmt = nullptr;
+    sqlite3_stmt* m_clearSigTargetsStmt = nullptr;
+    sqlite3_stmt* m_clearHashTargetsStmt = nullptr;
+    dev_t m_dbDev = 0;
+    ino_t m_dbIno = 0;
+    uint32_t m_storedDictionaryId = 0; // dictionary already written on this connection
+    // Byte order by memcmp; std::less on vectors trips a GCC 12 -Wstringop-overread
+    struct BytesLess {
+        bool operator()(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b) const {
+            const size_t n = std::min(a.size(), b.size());
+            const int c = n ? std::memcmp(a.data(), b.data(), n) : 0;
+            return c < 0 || (c == 0 && a.size() < b.size());
+        }
+    };
+    // Removal targets not yet flushed
+    std::set<std::vector<uint8_t>, BytesLess> m_pendingSignatures;
+    std::set<util::hashing::Digest> m_pendingHashes;
+
+    // Compression stage (see prepareChunk); one chunk is written while the other is
+    // prepared, and the buffers are reused across chunks and merges
+    util::compression::Options m_compression;
+    PreparedChunk m_chunks[2];
+
+    // Query indexes, maintained on the same connection (see DocumentIndex)
+    DocumentIndex m_index;
+
+    // Delta snapshots (see PrepareDelta / RecordPinnedBase)
+    uint32_t m_maxDeltaChain = 0;
+    ipfs_integration::MerkleTreeCache m_ownTreeCache;
+    ipfs_integration::MerkleTreeCache* m_treeCache = &m_ownTreeCache;
 };
 
 } // namespace core
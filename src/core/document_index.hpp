@@ -0,0 +1,340 @@
+#ifndef RXREVOLTCHAIN_DOCUMENT_INDEX_HPP
+#define RXREVOLTCHAIN_DOCUMENT_INDEX_HPP
+
+#include "json_parser.hpp"
+#include "logger.hpp"
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <initializer_list>
+#include <sqlite3.h>
+#include <string>
+#include <vector>
+
+namespace rxrevoltchain {
+namespace core {
+
+/*
+  DocumentIndex
+  --------------------------------
+  Query indexes over the snapshot's documents, maintained by DailySnapshot as part of
+  every merge (in the same write transaction as the rows they describe).
+
+  Tables:
+   - cost_items(doc_id, procedure_code, description, provider, region, price): one row per
+     priced line of a cost document, indexed by procedure code (with price), provider and
+     region (with procedure code).
+   - documents_fts: FTS5 table keyed by documents.id over the metadata and every string
+     value of the payload. Skipped (with a warning) if this SQLite lacks FTS5; the field
+     index still works.
+   - AFTER DELETE triggers on documents drop a document's index rows, so removals need no
+     extra code and the indexes never have to be rebuilt.
+
+  Extraction (Extract(), thread-safe and independent of the connection, so DailySnapshot
+  runs it on the ThreadPool next to compression):
+   - The (already redacted) payload is parsed as JSON. Line items are the elements of the
+     first of ITEM_ARRAY_KEYS present; without one, a document that has a procedure code
+     or price at the top level is a single item.
+   - Each field takes the first key present from its alias list (see the *_KEYS arrays);
+     item-level provider/region override document-level ones. Prices may be JSON numbers
+     or strings such as "$1,250.00".
+   - Non-JSON payloads are full-text indexed as plain text unless they look binary.
+   - Full-text input per document is capped at MAX_TEXT_BYTES.
+*/
+
+class DocumentIndex {
+  public:
+    static constexpr size_t MAX_TEXT_BYTES = 64 * 1024;
+
+    struct CostItem {
+        std::string procedureCode;
+        std::string description;
+        std::string provider;
+        std::string region;
+        bool hasPrice = false;
+        double price = 0;
+    };
+
+    struct Entry {
+        std::vector<CostItem> items;
+        std::string text; // payload strings for the full-text index
+    };
+
+    DocumentIndex() = default;
+    DocumentIndex(const DocumentIndex&) = delete;
+    DocumentIndex& operator=(const DocumentIndex&) = delete;
+    ~DocumentIndex() { Finalize(); }
+
+    // -------------------------------------------------------------------------
+    // Creates the index tables, indexes and triggers if missing. Returns false only if the
+    // field index cannot be created; a missing FTS5 module just disables full-text search.
+    // -------------------------------------------------------------------------
+    bool CreateSchema(sqlite3* db) {
+        const char* ddl = "CREATE TABLE IF NOT EXISTS cost_items ("
+                          " doc_id INTEGER NOT NULL,"
+                          " procedure_code TEXT,"
+                          " description TEXT,"
+                          " provider TEXT,"
+                          " region TEXT,"
+                          " price REAL"
+                          ");"
+                          "CREATE INDEX IF NOT EXISTS idx_cost_items_doc ON cost_items(doc_id);"
+                          "CREATE INDEX IF NOT EXISTS idx_cost_items_procedure"
+                          " ON cost_items(procedure_code, price);"
+                          "CREATE INDEX IF NOT EXISTS idx_cost_items_provider"
+                          " ON cost_items(provider);"
+                          "CREATE INDEX IF NOT EXISTS idx_cost_items_region"
+                          " ON cost_items(region, procedure_code);"
+                          "CREATE TRIGGER IF NOT EXISTS documents_cost_items_delete"
+                          " AFTER DELETE ON documents BEGIN"
+                          " DELETE FROM cost_items WHERE doc_id = old.id; END;";
+        if (sqlite3_exec(db, ddl, nullptr, nullptr, nullptr) != SQLITE_OK) {
+            util::logger::Logger::getInstance().error("[DocumentIndex] Could not create the "
+                                                      "field index: " +
+                                                      std::string(sqlite3_errmsg(db)));
+            return false;
+        }
+        const char* fts = "CREATE VIRTUAL TABLE IF NOT EXISTS documents_fts"
+                          " USING fts5(metadata, body);"
+                          "CREATE TRIGGER IF NOT EXISTS documents_fts_delete"
+                          " AFTER DELETE ON documents BEGIN"
+                          " DELETE FROM documents_fts WHERE rowid = old.id; END;";
+        m_fullText = sqlite3_exec(db, fts, nullptr, nullptr, nullptr) == SQLITE_OK;
+        if (!m_fullText) {
+            util::logger::Logger::getInstance().warn(
+                "[DocumentIndex] FTS5 unavailable, full-text search disabled: " +
+                std::string(sqlite3_errmsg(db)));
+        }
+        return true;
+    }
+
+    // Prepares the insert statements on 'db' (after CreateSchema)
+    bool Prepare(sqlite3* db) {
+        Finalize();
+        const char* itemSql = "INSERT INTO cost_items (doc_id, procedure_code, description,"
+                              " provider, region, price) VALUES (?, ?, ?, ?, ?, ?);";
+        if (sqlite3_prepare_v2(db, itemSql, -1, &m_insertItem, nullptr) != SQLITE_OK) {
+            return false;
+        }
+        return !m_fullText ||
+               sqlite3_prepare_v2(db,
+                                  "INSERT INTO documents_fts (rowid, metadata, body)"
+                                  " VALUES (?, ?, ?);",
+                                  -1, &m_insertText, nullptr) == SQLITE_OK;
+    }
+
+    void Finalize() {
+        sqlite3_finalize(m_insertItem);
+        sqlite3_finalize(m_insertText);
+        m_insertItem = nullptr;
+        m_insertText = nullptr;
+    }
+
+    bool FullTextEnabled() const { return m_fullText; }
+
+    // Writes the index rows of document 'docId' (inside the caller's transaction)
+    bool Insert(int64_t docId, const std::string& metadata, const Entry& entry) {
+        for (const CostItem& item : entry.items) {
+            sqlite3_reset(m_insertItem);
+            sqlite3_bind_int64(m_insertItem, 1, static_cast<sqlite3_int64>(docId));
+            bindOptionalText(m_insertItem, 2, item.procedureCode);
+            bindOptionalText(m_insertItem, 3, item.description);
+            bindOptionalText(m_insertItem, 4, item.provider);
+            bindOptionalText(m_insertItem, 5, item.region);
+            if (item.hasPrice) {
+                sqlite3_bind_double(m_insertItem, 6, item.price);
+            } else {
+                sqlite3_bind_null(m_insertItem, 6);
+            }
+            const int rc = sqlite3_step(m_insertItem);
+            sqlite3_reset(m_insertItem);
+            if (rc != SQLITE_DONE) {
+                return false;
+            }
+        }
+        if (!m_insertText) {
+            return true;
+        }
+        sqlite3_reset(m_insertText);
+        sqlite3_bind_int64(m_insertText, 1, static_cast<sqlite3_int64>(docId));
+        sqlite3_bind_text(m_insertText, 2, metadata.data(), static_cast<int>(metadata.size()),
+                          SQLITE_STATIC);
+        sqlite3_bind_text(m_insertText, 3, entry.text.data(), static_cast<int>(entry.text.size()),
+                          SQLITE_STATIC);
+        const int rc = sqlite3_step(m_insertText);
+        sqlite3_reset(m_insertText);
+        return rc == SQLITE_DONE;
+    }
+
+    // -------------------------------------------------------------------------
+    // Pulls cost items and full-text input out of a (redacted, uncompressed) payload
+    // -------------------------------------------------------------------------
+    static Entry Extract(const std::vector<uint8_t>& payload) {
+        Entry entry;
+        util::JsonValue doc;
+        const std::string text(payload.begin(), payload.end());
+        if (!util::JsonStreamParser::parse(text, doc) || !doc.isObject()) {
+            if (!looksBinary(text)) {
+                entry.text = text.substr(0, MAX_TEXT_BYTES);
+            }
+            return entry;
+        }
+        collectText(doc, entry.text);
+
+        const std::string provider = firstString(doc, PROVIDER_KEYS);
+        const std::string region = firstString(doc, REGION_KEYS);
+        const util::JsonValue* items = nullptr;
+        for (const char* key : ITEM_ARRAY_KEYS) {
+            const util::JsonValue* value = doc.find(key);
+            if (value && value->isArray()) {
+                items = value;
+                break;
+            }
+        }
+        if (items) {
+            for (const util::JsonValue& value : items->items()) {
+                if (value.isObject()) {
+                    addItem(value, provider, region, entry.items);
+                }
+            }
+        } else if (!firstString(doc, CODE_KEYS).empty() || firstPrice(doc, nullptr)) {
+            addItem(doc, provider, region, entry.items);
+        }
+        return entry;
+    }
+
+  private:
+    static constexpr std::initializer_list<const char*> ITEM_ARRAY_KEYS = {
+        "items", "line_items", "procedures", "charges"};
+    static constexpr std::initializer_list<const char*> CODE_KEYS = {
+        "procedure_code", "cpt", "hcpcs", "billing_code", "code"};
+    static constexpr std::initializer_list<const char*> DESCRIPTION_KEYS = {
+        "description", "procedure", "name"};
+    static constexpr std::initializer_list<const char*> PROVIDER_KEYS = {
+        "provider", "provider_name", "facility"};
+    static constexpr std::initializer_list<const char*> REGION_KEYS = {"region", "state",
+                                                                      "location"};
+    static constexpr std::initializer_list<const char*> PRICE_KEYS = {
+        "price", "allowed", "negotiated_rate", "cash_price", "billed", "charge"};
+
+    static void addItem(const util::JsonValue& value, const std::string& provider,
+                        const std::string& region, std::vector<CostItem>& out) {
+        CostItem item;
+        item.procedureCode = firstString(value, CODE_KEYS);
+        item.description = firstString(value, DESCRIPTION_KEYS);
+        item.provider = firstString(value, PROVIDER_KEYS);
+        if (item.provider.empty()) {
+            item.provider = provider;
+        }
+        item.region = firstString(value, REGION_KEYS);
+        if (item.region.empty()) {
+            item.region = region;
+        }
+        item.hasPrice = firstPrice(value, &item.price);
+        out.push_back(std::move(item));
+    }
+
+    // Codes are often numeric in JSON ("cpt": 70551); they are stored as text either way
+    static std::string firstString(const util::JsonValue& object,
+                                   std::initializer_list<const char*> keys) {
+        for (const char* key : keys) {
+            const util::JsonValue* value = object.find(key);
+            if (!value) {
+                continue;
+            }
+            if (value->isString() && !value->asString().empty()) {
+                return value->asString();
+            }
+            if (value->isNumber() && std::isfinite(value->asNumber())) {
+                const double n = value->asNumber();
+                if (n == std::floor(n) && std::fabs(n) < 1e15) {
+                    return std::to_string(static_cast<long long>(n));
+                }
+            }
+        }
+        return "";
+    }
+
+    static bool firstPrice(const util::JsonValue& object, double* price) {
+        for (const char* key : PRICE_KEYS) {
+            const util::JsonValue* value = object.find(key);
+            double parsed = 0;
+            if (value && parsePrice(*value, parsed)) {
+                if (price) {
+                    *price = parsed;
+                }
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static bool parsePrice(const util::JsonValue& value, double& out) {
+        if (value.isNumber()) {
+            out = value.asNumber();
+            return std::isfinite(out);
+        }
+        if (!value.isString()) {
+            return false;
+        }
+        std::string digits;
+        for (char c : value.asString()) {
+            if (c != '$' && c != ',' && c != ' ') {
+                digits += c;
+            }
+        }
+        if (digits.empty()) {
+            return false;
+        }
+        char* end = nullptr;
+        out = std::strtod(digits.c_str(), &end);
+        return *end == '\0' && std::isfinite(out);
+    }
+
+    static void collectText(const util::JsonValue& value, std::string& out) {
+        if (out.size() >= MAX_TEXT_BYTES) {
+            return;
+        }
+        if (value.isString()) {
+            if (!out.empty()) {
+                out += ' ';
+            }
+            out += value.asString().substr(0, MAX_TEXT_BYTES - out.size());
+        } else if (value.isArray()) {
+            for (const util::JsonValue& item : value.items()) {
+                collectText(item, out);
+            }
+        } else if (value.isObject()) {
+            for (const auto& member : value.members()) {
+                collectText(member.second, out);
+            }
+        }
+    }
+
+    static bool looksBinary(const std::string& text) {
+        for (unsigned char c : text) {
+            if (c < 0x09 || (c > 0x0D && c < 0x20)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static void bindOptionalText(sqlite3_stmt* stmt, int index, const std::string& value) {
+        if (value.empty()) {
+            sqlite3_bind_null(stmt, index);
+        } else {
+            sqlite3_bind_text(stmt, index, value.data(), static_cast<int>(value.size()),
+                              SQLITE_STATIC);
+        }
+    }
+
+    bool m_fullText = false;
+    sqlite3_stmt* m_insertItem = nullptr;
+    sqlite3_stmt* m_insertText = nullptr;
+};
+
+} // namespace core
+} // namespace rxrevoltchain
+
+#endif // RXREVOLTCHAIN_DOCUMENT_INDEX_HPP
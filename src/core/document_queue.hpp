@@ -1,15 +1,40 @@
 #ifndef RXREVOLTCHAIN_DOCUMENT_QUEUE_HPP
 #define RXREVOLTCHAIN_DOCUMENT_QUEUE_HPP
 
+#include "logger.hpp"
+#include "metrics.hpp"
 #include "transaction.hpp"
+#include "write_ahead_log.hpp"
+#include <algorithm>
 #include <fstream>
+#include <functional>
 #include <mutex>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace rxrevoltchain {
 namespace core {
 
+/*
+  DocumentQueue
+  --------------------------------
+  In-memory queue of pending transactions, persisted through a WriteAheadLog so that
+  submissions survive a restart until FetchAll() hands them to the next snapshot.
+
+   - AddTransaction() encodes the record and queues it on the log under the queue lock,
+     then waits for the log's group commit *outside* that lock. Concurrent submitters thus
+     share one write/fdatasync instead of serializing on open-append-close per record.
+   - AddTransaction() returns once the record is durable according to the log's fsync
+     policy (see WriteAheadLog::FsyncPolicy and SetWalOptions()).
+   - Files written by the pre-WAL queue (bare length-prefixed fields, no header) are read
+     once and rewritten in the WAL format.
+   - The number of queued transactions across all queues is exported as the
+     rxrevolt_document_queue_depth gauge (util::metrics).
+   - SetDepthListener() lets a consumer (the scheduler's micro-batch ingestion) react as
+     soon as a batch worth of transactions is queued instead of polling.
+*/
+
 class DocumentQueue {
   public:
     explicit DocumentQueue(const std::string& storageFile = "document_queue.wal")
@@ -17,24 +42,63 @@ class DocumentQueue {
         loadFromDisk();
     }
 
+    ~DocumentQueue() { depthGauge().add(-static_cast<double>(m_transactions.size())); }
+
+    DocumentQueue(const DocumentQueue&) = delete;
+    DocumentQueue& operator=(const DocumentQueue&) = delete;
+
     void SetStorageFile(const std::string& file) {
         std::lock_guard<std::mutex> lock(m_mutex);
         m_storageFile = file;
         loadFromDisk();
     }
 
-    bool AddTransaction(const Transaction& tx) {
+    /**
+     * Set the fsync policy of the backing log. Reopens the log so the options apply.
+     */
+    void SetWalOptions(const WriteAheadLog::Options& options) {
         std::lock_guard<std::mutex> lock(m_mutex);
-        m_transactions.push_back(tx);
-        appendToFile(tx);
-        return true;
+        m_wal.SetOptions(options);
+        loadFromDisk();
     }
 
+    /**
+     * Queue a transaction and persist it.
+     * @return false if the record could not be written to the log. The transaction
+     *         stays queued in memory either way.
+     */
+    bool AddTransaction(const Transaction& tx) { return AddTransaction(Transaction(tx)); }
+
+    /**
+     * Move overload: the transaction's buffers are taken over by the queue, so the only
+     * copy made on submission is the WAL record.
+     */
+    bool AddTransaction(Transaction&& tx) {
+        std::vector<uint8_t> record = encodeTransaction(tx);
+        uint64_t ticket = 0;
+        bool queued = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_transactions.push_back(std::move(tx));
+            queued = m_wal.Enqueue(record, ticket);
+            if (m_depthListener && m_transactions.size() == m_listenDepth) {
+                m_depthListener();
+            }
+        }
+        depthGauge().add(1);
+        return queued && m_wal.Wait(ticket);
+    }
+
+    /**
+     * Hand every queued transaction to the caller and empty the queue and its log.
+     * The internal vector is swapped out, not copied.
+     */
     std::vector<Transaction> FetchAll() {
+        std::vector<Transaction> temp;
         std::lock_guard<std::mutex> lock(m_mutex);
-        std::vector<Transaction> temp = m_transactions;
-        m_transactions.clear();
-        truncateFile();
+        temp.swap(m_transactions);
+        m_wal.Reset();
+        depthGauge().add(-static_cast<double>(temp.size()));
         return temp;
     }
 
@@ -43,36 +107,135 @@ class DocumentQueue {
         return m_transactions.empty();
     }
 
+    size_t Size() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_transactions.size();
+    }
+
+    /**
+     * Call 'listener' whenever an AddTransaction brings the queue to 'depth' transactions.
+     * It runs under the queue lock, so it must be short and must not call back into the
+     * queue. Pass an empty listener to remove it.
+     */
+    void SetDepthListener(size_t depth, std::function<void()> listener) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_listenDepth = std::max<size_t>(1, depth);
+        m_depthListener = std::move(listener);
+    }
+
   private:
-    bool appendToFile(const Transaction& tx) {
-        std::ofstream out(m_storageFile, std::ios::binary | std::ios::app);
-        if (!out.is_open())
-            return false;
-
-        auto writeVec = [&](const std::vector<uint8_t>& vec) {
-            uint32_t len = static_cast<uint32_t>(vec.size());
-            out.write(reinterpret_cast<const char*>(&len), sizeof(len));
-            if (len)
-                out.write(reinterpret_cast<const char*>(vec.data()), len);
-        };
+    static util::metrics::Gauge& depthGauge() {
+        static util::metrics::Gauge& gauge = util::metrics::Registry::getInstance().gauge(
+            "rxrevolt_document_queue_depth", "Transactions waiting for the next merge.");
+        return gauge;
+    }
+
+    static void putU32(std::vector<uint8_t>& out, uint32_t v) {
+        for (int i = 0; i < 4; ++i) {
+            out.push_back(static_cast<uint8_t>(v >> (8 * i)));
+        }
+    }
 
-        auto writeString = [&](const std::string& s) {
-            uint32_t len = static_cast<uint32_t>(s.size());
-            out.write(reinterpret_cast<const char*>(&len), sizeof(len));
-            if (len)
-                out.write(s.data(), len);
+    static std::vector<uint8_t> encodeTransaction(const Transaction& tx) {
+        const std::string& type = tx.GetType();
+        const std::string& meta = tx.GetMetadata();
+        const std::vector<uint8_t>& sig = tx.GetSignature();
+        const std::vector<uint8_t>& payload = tx.GetPayload();
+
+        std::vector<uint8_t> out;
+        out.reserve(16 + type.size() + meta.size() + sig.size() + payload.size());
+        putU32(out, static_cast<uint32_t>(type.size()));
+        out.insert(out.end(), type.begin(), type.end());
+        putU32(out, static_cast<uint32_t>(meta.size()));
+        out.insert(out.end(), meta.begin(), meta.end());
+        putU32(out, static_cast<uint32_t>(sig.size()));
+        out.insert(out.end(), sig.begin(), sig.end());
+        putU32(out, static_cast<uint32_t>(payload.size()));
+        out.insert(out.end(), payload.begin(), payload.end());
+        return out;
+    }
+
+    static bool decodeTransaction(const std::vector<uint8_t>& rec, Transaction& tx) {
+        size_t pos = 0;
+        auto field = [&](const uint8_t*& data, uint32_t& len) -> bool {
+            if (pos + 4 > rec.size()) {
+                return false;
+            }
+            len = uint32_t(rec[pos]) | (uint32_t(rec[pos + 1]) << 8) |
+                  (uint32_t(rec[pos + 2]) << 16) | (uint32_t(rec[pos + 3]) << 24);
+            pos += 4;
+            if (len > rec.size() - pos) {
+                return false;
+            }
+            data = rec.data() + pos;
+            pos += len;
+            return true;
         };
 
-        writeString(tx.GetType());
-        writeString(tx.GetMetadata());
-        writeVec(tx.GetSignature());
-        writeVec(tx.GetPayload());
+        const uint8_t* p[4];
+        uint32_t n[4];
+        for (int i = 0; i < 4; ++i) {
+            if (!field(p[i], n[i])) {
+                return false;
+            }
+        }
+        tx.SetType(std::string(reinterpret_cast<const char*>(p[0]), n[0]));
+        tx.SetMetadata(std::string(reinterpret_cast<const char*>(p[1]), n[1]));
+        tx.SetSignature(std::vector<uint8_t>(p[2], p[2] + n[2]));
+        tx.SetPayload(std::vector<uint8_t>(p[3], p[3] + n[3]));
         return true;
     }
 
     void loadFromDisk() {
+        const size_t before = m_transactions.size();
+        loadRecords();
+        depthGauge().add(static_cast<double>(m_transactions.size()) -
+                         static_cast<double>(before));
+    }
+
+    void loadRecords() {
+        using namespace rxrevoltchain::util::logger;
         m_transactions.clear();
 
+        if (WriteAheadLog::IsLegacyFile(m_storageFile)) {
+            loadLegacyFile();
+            if (!m_wal.Create(m_storageFile)) {
+                Logger::getInstance().error("[DocumentQueue] Failed to migrate " +
+                                            m_storageFile);
+                return;
+            }
+            // Queue every record first so the migration lands in one group commit
+            uint64_t ticket = 0;
+            for (const auto& tx : m_transactions) {
+                m_wal.Enqueue(encodeTransaction(tx), ticket);
+            }
+            if (ticket) {
+                m_wal.Wait(ticket);
+            }
+            Logger::getInstance().info("[DocumentQueue] Migrated " +
+                                       std::to_string(m_transactions.size()) +
+                                       " queued records to the WAL format.");
+            return;
+        }
+
+        std::vector<std::vector<uint8_t>> records;
+        if (!m_wal.Open(m_storageFile, records)) {
+            Logger::getInstance().error("[DocumentQueue] Failed to open " + m_storageFile);
+            return;
+        }
+        for (const auto& rec : records) {
+            Transaction tx;
+            if (!decodeTransaction(rec, tx)) {
+                Logger::getInstance().warn("[DocumentQueue] Skipping malformed record in " +
+                                           m_storageFile);
+                continue;
+            }
+            m_transactions.push_back(std::move(tx));
+        }
+    }
+
+    // Reads the pre-WAL format: four native-endian length-prefixed fields per record.
+    void loadLegacyFile() {
         std::ifstream in(m_storageFile, std::ios::binary);
         if (!in.is_open())
             return;
@@ -110,23 +273,21 @@ class DocumentQueue {
             if (!readVec(payload))
                 break;
 
-            tx.SetType(type);
-            tx.SetMetadata(meta);
-            tx.SetSignature(sig);
-            tx.SetPayload(payload);
-            m_transactions.push_back(tx);
+            tx.SetType(std::move(type));
+            tx.SetMetadata(std::move(meta));
+            tx.SetSignature(std::move(sig));
+            tx.SetPayload(std::move(payload));
+            m_transactions.push_back(std::move(tx));
         }
     }
 
-    void truncateFile() {
-        std::ofstream out(m_storageFile, std::ios::binary | std::ios::trunc);
-        (void)out;
-    }
-
   private:
     mutable std::mutex m_mutex;
     std::vector<Transaction> m_transactions;
     std::string m_storageFile;
+    WriteAheadLog m_wal;
+    size_t m_listenDepth = 1;
+    std::function<void()> m_depthListener; // see SetDepthListener
 };
 
 } // namespace core
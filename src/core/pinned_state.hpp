@@ -5,6 +5,7 @@
 #include <mutex>
 #include <chrono>
 #include <atomic>
+#include <vector>
 #include "logger.hpp"
 
 namespace rxrevoltchain {
@@ -28,6 +29,11 @@ namespace core {
   - Stores the local file path of the pinned .sqlite database.
   - Thread-safe access via a mutex if multiple threads can update/read state.
   - Optionally logs state changes for debugging or auditing.
+  - The current CID always names the whole .sqlite file, so PoP challenges what a peer
+    actually holds. When the snapshot was published as a SnapshotDelta, GetDeltaCID() is
+    the CID of that delta; earlier links of the chain follow from each delta's base CID.
+  - With a sharded snapshot (see ShardedSnapshot) the CID and path name the root manifest,
+    and GetShards() lists each shard's own CID and local file.
 */
 
 class PinnedState
@@ -56,6 +62,21 @@ public:
         return m_currentCID;
     }
 
+    // Records the CID of the delta the current snapshot was published as; empty when
+    // it was pinned as a whole file
+    void SetDeltaCID(const std::string &cid)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_deltaCID = cid;
+    }
+
+    // Returns the current snapshot's delta CID (empty if it was pinned whole)
+    std::string GetDeltaCID() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_deltaCID;
+    }
+
     // Sets the local path of the pinned .sqlite file
     void SetLocalFilePath(const std::string &path)
     {
@@ -73,10 +94,34 @@ public:
         return m_localFilePath;
     }
 
+    // One pinned shard of a sharded snapshot
+    struct Shard
+    {
+        std::string cid;        // The shard file's CID
+        std::string path;
+        std::string deltaCid;   // The delta it was published as; empty if pinned whole
+    };
+
+    // Records the shards pinned under the current (manifest) CID; empty = single file
+    void SetShards(const std::vector<Shard> &shards)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_shards = shards;
+    }
+
+    // Returns a copy of the pinned shards (empty for a single-file snapshot)
+    std::vector<Shard> GetShards() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_shards;
+    }
+
 private:
     mutable std::mutex m_mutex;    // Protects all state below
     std::string        m_currentCID;
     std::string        m_localFilePath;
+    std::string        m_deltaCID;
+    std::vector<Shard> m_shards;
 };
 
 } // namespace core
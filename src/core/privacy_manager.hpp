@@ -1,11 +1,9 @@
 #ifndef RXREVOLTCHAIN_PRIVACY_MANAGER_HPP
 #define RXREVOLTCHAIN_PRIVACY_MANAGER_HPP
 
-#include <string>
+#include "pii_scanner.hpp"
+#include <cstdint>
 #include <vector>
-#include <regex>
-#include <algorithm>
-#include <cctype>
 
 namespace rxrevoltchain {
 namespace core {
@@ -22,82 +20,73 @@ namespace core {
     bool IsSuspicious(const std::vector<uint8_t> &documentData) const
 
   "Fully functional" approach:
-  - Uses basic pattern matching (via std::regex) to identify potential PII
-    and replace it with "[REDACTED]" in the data.
-  - Treats certain keywords or patterns as suspicious.
+  - Recognizes PII (SSNs, phone numbers, email addresses, card numbers; see
+    util::pii for the exact rules) and replaces it with "[REDACTED]" in the data.
+  - Treats certain keywords as suspicious.
   - In a real system, you might expand these rules significantly or rely on a dedicated NLP library.
 
   Implementation notes:
-  - We convert the raw binary data (documentData) to a string for pattern matching.
-  - For demonstration, we define naive patterns for PII (SSNs, phone numbers, etc.).
-  - We also define some basic "suspicious" checks for demonstration.
+  - Scan() finds PII and suspicious keywords in one pass over the raw bytes and redacts
+    in place; documents without PII are never copied or moved.
+  - SetPatterns() narrows the PII rules (util::pii::Pattern bits); keywords are always checked.
+  - Scan(), RedactPII() and IsSuspicious() keep no state between calls, so one instance
+    may serve several threads at once (DailySnapshot redacts a chunk in parallel).
 */
 
 class PrivacyManager
 {
 public:
+    // Outcome of Scan()
+    struct Report
+    {
+        size_t redactions = 0;   // PII matches replaced
+        bool suspicious = false; // a suspicious keyword was found (before redaction)
+    };
+
     // Default constructor
     PrivacyManager() = default;
 
+    // Selects the PII patterns to redact (default: all of them)
+    void SetPatterns(uint32_t patterns) { m_patterns = patterns & ~uint32_t(util::pii::Keywords); }
+
+    // Redacts documentData in-place and checks it for suspicious keywords, in one pass.
+    Report Scan(std::vector<uint8_t> &documentData) const
+    {
+        // Reused per thread; merges scan thousands of documents per chunk
+        thread_local util::pii::ScanResult result;
+        result.clear();
+        util::pii::scan(documentData.data(), documentData.size(),
+                        m_patterns | util::pii::Keywords, result);
+        util::pii::redact(documentData, result.matches);
+        Report report;
+        report.redactions = result.matches.size();
+        report.suspicious = result.suspicious;
+        return report;
+    }
+
     // Modifies documentData in-place to remove or obfuscate sensitive info.
     // Returns true if any changes were made (though returning false does not mean no PII existed).
     bool RedactPII(std::vector<uint8_t> &documentData)
     {
-        // Convert data to string for easier regex processing
-        std::string content(reinterpret_cast<const char*>(documentData.data()), documentData.size());
-        bool changed = false;
-
-        // Below are naive example patterns for demonstration. Expand as needed.
-        // 1) Possible US SSN pattern: ###-##-#### (not perfect)
-        static const std::regex ssnPattern(R"((\b\d{3}-\d{2}-\d{4}\b))");
-        // 2) Possible US phone number pattern: (###) ###-#### or ###-###-####
-        static const std::regex phonePattern(R"((\(\d{3}\)\s?\d{3}-\d{4}|\b\d{3}-\d{3}-\d{4}\b))");
-
-        // Replace occurrences with "[REDACTED]"
-        std::string newContent = std::regex_replace(content, ssnPattern, "[REDACTED]");
-        if (newContent != content)
-        {
-            changed = true;
-            content.swap(newContent);
-        }
-
-        newContent = std::regex_replace(content, phonePattern, "[REDACTED]");
-        if (newContent != content)
-        {
-            changed = true;
-            content.swap(newContent);
-        }
-
-        // Convert the possibly redacted string back to vector<uint8_t>
-        documentData.assign(content.begin(), content.end());
-        return changed;
+        thread_local util::pii::ScanResult result;
+        result.clear();
+        util::pii::scan(documentData.data(), documentData.size(), m_patterns, result);
+        util::pii::redact(documentData, result.matches);
+        return !result.matches.empty();
     }
 
     // Returns true if the content triggers red flags (e.g., possible malicious or illegal data).
     // This is purely illustrative—expand or refine for real usage.
     bool IsSuspicious(const std::vector<uint8_t> &documentData) const
     {
-        // Convert to a string for simple text scanning
-        std::string content(reinterpret_cast<const char*>(documentData.data()), documentData.size());
-
-        // Example: Mark as suspicious if it contains "virus" or "malware" (case-insensitive).
-        // In reality, you'd have a more robust approach or machine learning-based scanning.
-        auto toLower = [](unsigned char c){ return std::tolower(c); };
-        std::string lowerContent;
-        lowerContent.resize(content.size());
-        std::transform(content.begin(), content.end(), lowerContent.begin(), toLower);
-
-        // Check for simple keywords
-        if (lowerContent.find("virus") != std::string::npos) {
-            return true;
-        }
-        if (lowerContent.find("malware") != std::string::npos) {
-            return true;
-        }
-        // Could add more suspicious patterns as needed
-
-        return false;
+        // Example: "virus" or "malware" (case-insensitive); stops at the first keyword.
+        util::pii::ScanResult result;
+        util::pii::scan(documentData.data(), documentData.size(), util::pii::Keywords, result);
+        return result.suspicious;
     }
+
+private:
+    uint32_t m_patterns = util::pii::AllPatterns & ~uint32_t(util::pii::Keywords);
 };
 
 } // namespace core
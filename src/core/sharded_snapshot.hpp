@@ -0,0 +1,416 @@
+#ifndef RXREVOLTCHAIN_SHARDED_SNAPSHOT_HPP
+#define RXREVOLTCHAIN_SHARDED_SNAPSHOT_HPP
+
+#include "compression.hpp"
+#include "daily_snapshot.hpp"
+#include "document_queue.hpp"
+#include "hashing.hpp"
+#include "ipfs_pinner.hpp"
+#include "logger.hpp"
+#include "pinned_state.hpp"
+#include "privacy_manager.hpp"
+#include "signature_verifier.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <vector>
+
+namespace rxrevoltchain {
+namespace core {
+
+/*
+  ShardedSnapshot
+  --------------------------------
+  The snapshot split across N SQLite files ('<dir>/data.shard-<i>.sqlite'), each one a
+  DailySnapshot of its own, so merges, pins and PoP trees no longer funnel through one
+  SQLite writer and one monolithic IPFS object.
+
+  Partitioning:
+   - A submission goes to shard ShardOf(payload): the first 8 bytes of the SHA-256 of the
+     payload as submitted, modulo N. Documents get their row id only once merged, so the
+     content digest is their stable identity; every node routes a document the same way.
+   - Removal requests are handed to every shard: a signature or content hash may match
+     rows anywhere. Each shard keeps queue order among what it receives.
+   - The shard count is recorded in '<dir>/data.shards' on the first merge; merging with
+     another count fails, since documents would no longer be where ShardOf says. An
+     existing single-file data.sqlite is left untouched (there is no resharding).
+
+  Merging and pinning:
+   - One DocumentQueue fetch is partitioned and the shards merge their parts concurrently
+     (DailySnapshot::MergeTransactions), up to SetParallelism() at a time. Redaction,
+     compression and signature checks still run on the shared ThreadPool.
+   - Each shard is pinned on its own (full file or delta, see DailySnapshot) and keeps its
+     own delta base. The root manifest '<dir>/data.manifest.json' lists every shard's CID,
+     file name and size; it is pinned too and its CID is the snapshot's CID.
+   - The PinnedState set with SetPinnedState records the manifest CID and path plus the
+     shard list (PinnedState::GetShards), which PoP rounds sample from.
+   - A failing shard fails the whole call; the other shards keep what they committed, as
+     with the chunks of a single DailySnapshot merge.
+*/
+
+class ShardedSnapshot {
+  public:
+    static constexpr size_t MAX_SHARDS = 256;
+
+    // -------------------------------------------------------------------------
+    // 'shardCount' shards under 'directory' (clamped to [1, MAX_SHARDS])
+    // -------------------------------------------------------------------------
+    ShardedSnapshot(const std::string& directory, size_t shardCount)
+        : m_directory(directory),
+          m_parallelism(std::max<size_t>(1, std::thread::hardware_concurrency())) {
+        shardCount = std::max<size_t>(1, std::min(MAX_SHARDS, shardCount));
+        for (size_t i = 0; i < shardCount; ++i) {
+            m_shards.emplace_back(new DailySnapshot(ShardPath(directory, i)));
+            m_shardStates.emplace_back(new PinnedState());
+            m_shards.back()->SetPinnedState(m_shardStates.back().get());
+        }
+    }
+
+    ShardedSnapshot(const ShardedSnapshot&) = delete;
+    ShardedSnapshot& operator=(const ShardedSnapshot&) = delete;
+
+    static std::string ShardPath(const std::string& directory, size_t shard) {
+        return directory + "/data.shard-" + std::to_string(shard) + ".sqlite";
+    }
+
+    // The copy of a shard that is pinned when SetSealedFiles(true)
+    static std::string SealedShardPath(const std::string& directory, size_t shard) {
+        return directory + "/data.shard-" + std::to_string(shard) + ".sealed.sqlite";
+    }
+
+    static std::string ManifestPath(const std::string& directory) {
+        return directory + "/data.manifest.json";
+    }
+
+    static std::string LayoutPath(const std::string& directory) {
+        return directory + "/data.shards";
+    }
+
+    // Shard a submission with this payload belongs to
+    static size_t ShardOf(const std::vector<uint8_t>& payload, size_t shardCount) {
+        const util::hashing::Digest digest = util::hashing::sha256Raw(payload);
+        uint64_t value = 0;
+        for (size_t i = 0; i < 8; ++i) {
+            value = (value << 8) | digest[i];
+        }
+        return static_cast<size_t>(value % std::max<size_t>(1, shardCount));
+    }
+
+    // -------------------------------------------------------------------------
+    // Splits a fetched batch into one batch per shard: submissions by ShardOf, removal
+    // requests copied into all of them. Queue order is kept within each batch.
+    // -------------------------------------------------------------------------
+    static std::vector<std::vector<Transaction>> Partition(std::vector<Transaction> transactions,
+                                                           size_t shardCount) {
+        shardCount = std::max<size_t>(1, shardCount);
+        const size_t everyShard = shardCount; // target of removal requests
+        std::vector<size_t> target(transactions.size());
+        util::ThreadPool::getInstance().parallelFor(
+            transactions.size(), 64, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    const Transaction& tx = transactions[i];
+                    target[i] = tx.GetType() == "document_submission"
+                                    ? ShardOf(tx.GetPayload(), shardCount)
+                                    : everyShard;
+                }
+            });
+
+        std::vector<std::vector<Transaction>> parts(shardCount);
+        for (size_t i = 0; i < transactions.size(); ++i) {
+            if (target[i] != everyShard) {
+                parts[target[i]].push_back(std::move(transactions[i]));
+                continue;
+            }
+            for (size_t s = 0; s + 1 < shardCount; ++s) {
+                parts[s].push_back(transactions[i]);
+            }
+            parts[shardCount - 1].push_back(std::move(transactions[i]));
+        }
+        return parts;
+    }
+
+    size_t ShardCount() const { return m_shards.size(); }
+
+    // The DailySnapshot behind shard 'shard' (e.g. to train its compression dictionary)
+    DailySnapshot& Shard(size_t shard) { return *m_shards.at(shard); }
+
+    // -------------------------------------------------------------------------
+    // Fetches the queue once, partitions it and merges the shards concurrently.
+    // Returns false if the layout does not match or any shard's merge fails.
+    // -------------------------------------------------------------------------
+    bool MergePendingDocuments() {
+        using namespace rxrevoltchain::util::logger;
+        Logger& logger = Logger::getInstance();
+
+        if (!m_docQueue) {
+            logger.error("[ShardedSnapshot] MergePendingDocuments failed: No DocumentQueue set.");
+            return false;
+        }
+        if (!checkLayout()) {
+            return false;
+        }
+
+        std::vector<std::vector<Transaction>> parts =
+            Partition(m_docQueue->FetchAll(), m_shards.size());
+        return forEachShard([this, &parts, &logger](size_t shard) {
+            if (m_shards[shard]->MergeTransactions(std::move(parts[shard]))) {
+                return true;
+            }
+            logger.error("[ShardedSnapshot] Merge failed on shard " + std::to_string(shard) +
+                         ".");
+            return false;
+        });
+    }
+
+    // Seals every shard (see DailySnapshot::SealSnapshot); no-op unless SetSealedFiles(true)
+    bool SealSnapshot() {
+        return forEachShard([this](size_t shard) { return m_shards[shard]->SealSnapshot(); });
+    }
+
+    // -------------------------------------------------------------------------
+    // Pins every shard, then writes and pins the manifest naming their CIDs. The
+    // PinnedState (SetPinnedState) is only updated once all of it is pinned.
+    // -------------------------------------------------------------------------
+    bool PinCurrentSnapshot() {
+        using namespace rxrevoltchain::util::logger;
+        Logger& logger = Logger::getInstance();
+
+        std::vector<PinnedState::Shard> pins(m_shards.size());
+        const bool pinned = forEachShard([this, &pins](size_t shard) {
+            if (!m_shards[shard]->PinCurrentSnapshot()) {
+                return false;
+            }
+            pins[shard].cid = m_shardStates[shard]->GetCurrentCID();
+            pins[shard].path = m_shardStates[shard]->GetLocalFilePath();
+            pins[shard].deltaCid = m_shardStates[shard]->GetDeltaCID();
+            return true;
+        });
+        if (!pinned) {
+            logger.error("[ShardedSnapshot] Pinning a shard failed; the manifest is not updated.");
+            return false;
+        }
+
+        const std::string manifest = BuildManifest(pins);
+        const std::string manifestPath = ManifestPath(m_directory);
+        std::ofstream out(manifestPath, std::ios::binary | std::ios::trunc);
+        out << manifest;
+        out.close();
+        if (!out) {
+            logger.error("[ShardedSnapshot] Could not write " + manifestPath);
+            return false;
+        }
+
+        std::string cid;
+        try {
+            ipfs_integration::IPFSPinner pinner(m_ipfsEndpoint);
+            cid = pinner.PinData("data.manifest.json",
+                                 std::vector<uint8_t>(manifest.begin(), manifest.end()));
+        } catch (const std::exception& ex) {
+            logger.error(std::string("[ShardedSnapshot] Pinning the manifest threw: ") +
+                         ex.what());
+            return false;
+        }
+        if (cid.empty()) {
+            logger.error("[ShardedSnapshot] IPFSPinner returned empty CID for the manifest.");
+            return false;
+        }
+
+        logger.info("[ShardedSnapshot] Pinned " + std::to_string(pins.size()) +
+                    " shards under manifest CID: " + cid);
+        if (m_pinnedState) {
+            m_pinnedState->SetShards(pins);
+            m_pinnedState->SetCurrentCID(cid);
+            m_pinnedState->SetLocalFilePath(manifestPath);
+        }
+        return true;
+    }
+
+    // -------------------------------------------------------------------------
+    // Manifest JSON for pinned shards:
+    //   {"format":"rxrevolt-shards","version":1,"shards":[{"index":0,"cid":"...",
+    //    "file":"data.shard-0.sqlite","bytes":N},...]}
+    // "file" is the shard's live file name (ShardPath) even when a sealed copy was pinned.
+    // A shard published as a delta also lists "delta":"<cid>", the object actually stored.
+    // -------------------------------------------------------------------------
+    static std::string BuildManifest(const std::vector<PinnedState::Shard>& shards) {
+        std::string json = "{\"format\":\"rxrevolt-shards\",\"version\":1,\"shards\":[";
+        for (size_t i = 0; i < shards.size(); ++i) {
+            const std::string& path = shards[i].path;
+            struct stat st;
+            const uint64_t bytes =
+                stat(path.c_str(), &st) == 0 ? static_cast<uint64_t>(st.st_size) : 0;
+            json += (i ? ",{\"index\":" : "{\"index\":") + std::to_string(i) + ",\"cid\":\"" +
+                    shards[i].cid + "\",\"file\":\"data.shard-" + std::to_string(i) +
+                    ".sqlite\",\"bytes\":" + std::to_string(bytes) +
+                    (shards[i].deltaCid.empty() ? std::string()
+                                                : ",\"delta\":\"" + shards[i].deltaCid + "\"") +
+                    "}";
+        }
+        return json + "]}";
+    }
+
+    // Files that PinCurrentSnapshot pins (the sealed copies with SetSealedFiles(true))
+    std::vector<std::string> PinnedFiles() const {
+        std::vector<std::string> files;
+        for (size_t i = 0; i < m_shards.size(); ++i) {
+            files.push_back(m_sealed ? SealedShardPath(m_directory, i)
+                                     : ShardPath(m_directory, i));
+        }
+        return files;
+    }
+
+    // Live shard files, in shard order (what an HttpQueryServer over the shards opens)
+    std::vector<std::string> ShardFiles() const {
+        std::vector<std::string> files;
+        for (size_t i = 0; i < m_shards.size(); ++i) {
+            files.push_back(ShardPath(m_directory, i));
+        }
+        return files;
+    }
+
+    void SetDocumentQueue(DocumentQueue* queue) { m_docQueue = queue; }
+
+    // Receives the manifest CID and path and the shard list after each pin
+    void SetPinnedState(PinnedState* state) { m_pinnedState = state; }
+
+    void SetIPFSEndpoint(const std::string& endpoint) {
+        m_ipfsEndpoint = endpoint;
+        forAll([&endpoint](DailySnapshot& shard) { shard.SetIPFSEndpoint(endpoint); });
+    }
+
+    // Shards merged or pinned at the same time (at least 1; default: hardware threads)
+    void SetParallelism(size_t shards) { m_parallelism = std::max<size_t>(1, shards); }
+
+    // Seal every shard into SealedShardPath and pin those copies (DailyScheduler always does)
+    void SetSealedFiles(bool sealed) {
+        m_sealed = sealed;
+        for (size_t i = 0; i < m_shards.size(); ++i) {
+            m_shards[i]->SetSealedFile(sealed ? SealedShardPath(m_directory, i) : std::string());
+        }
+    }
+
+    // The settings below are applied to every shard (see the DailySnapshot setters)
+    void SetPrivacyManager(PrivacyManager* privacy) {
+        forAll([privacy](DailySnapshot& shard) { shard.SetPrivacyManager(privacy); });
+    }
+
+    void SetSignatureVerifier(SignatureVerifier* verifier) {
+        forAll([verifier](DailySnapshot& shard) { shard.SetSignatureVerifier(verifier); });
+    }
+
+    void SetMergeChunkSize(size_t records) {
+        forAll([records](DailySnapshot& shard) { shard.SetMergeChunkSize(records); });
+    }
+
+    void SetDeltaMaxChain(uint32_t links) {
+        forAll([links](DailySnapshot& shard) { shard.SetDeltaMaxChain(links); });
+    }
+
+    void SetCompression(const util::compression::Options& options) {
+        forAll([&options](DailySnapshot& shard) { shard.SetCompression(options); });
+    }
+
+    // Tree cache of every shard's delta base (see DailySnapshot::SetTreeCache)
+    void SetTreeCache(ipfs_integration::MerkleTreeCache* cache) {
+        forAll([cache](DailySnapshot& shard) { shard.SetTreeCache(cache); });
+    }
+
+    // Called on the merging shard's thread, so possibly from several threads at once
+    void SetCommitListener(std::function<void()> listener) {
+        forAll([&listener](DailySnapshot& shard) { shard.SetCommitListener(listener); });
+    }
+
+  private:
+    void forAll(const std::function<void(DailySnapshot&)>& apply) {
+        for (const auto& shard : m_shards) {
+            apply(*shard);
+        }
+    }
+
+    // -------------------------------------------------------------------------
+    // Helper: runs fn(shard) for every shard on up to m_parallelism threads (this one
+    // included); true if every call returned true
+    // -------------------------------------------------------------------------
+    bool forEachShard(const std::function<bool(size_t)>& fn) {
+        std::atomic<size_t> next{0};
+        std::atomic<bool> ok{true};
+        auto drain = [this, &fn, &next, &ok] {
+            for (size_t shard; (shard = next.fetch_add(1)) < m_shards.size();) {
+                if (!fn(shard)) {
+                    ok = false;
+                }
+            }
+        };
+        std::vector<std::future<void>> helpers;
+        for (size_t t = 1; t < std::min(m_parallelism, m_shards.size()); ++t) {
+            helpers.push_back(std::async(std::launch::async, drain));
+        }
+        drain();
+        for (auto& helper : helpers) {
+            helper.get();
+        }
+        return ok.load();
+    }
+
+    // -------------------------------------------------------------------------
+    // Helper: records the shard count on first use and refuses a directory that was
+    // sharded differently
+    // -------------------------------------------------------------------------
+    bool checkLayout() {
+        using namespace rxrevoltchain::util::logger;
+        Logger& logger = Logger::getInstance();
+        if (m_layoutChecked) {
+            return true;
+        }
+        const std::string layoutPath = LayoutPath(m_directory);
+        std::ifstream in(layoutPath);
+        size_t recorded = 0;
+        if (in >> recorded) {
+            if (recorded != m_shards.size()) {
+                logger.error("[ShardedSnapshot] " + m_directory + " holds " +
+                             std::to_string(recorded) + " shards, not " +
+                             std::to_string(m_shards.size()) + "; resharding is not supported.");
+                return false;
+            }
+        } else {
+            struct stat st;
+            if (stat((m_directory + "/data.sqlite").c_str(), &st) == 0) {
+                logger.warn("[ShardedSnapshot] " + m_directory + "/data.sqlite is not "
+                            "migrated into the shards.");
+            }
+            std::ofstream out(layoutPath, std::ios::trunc);
+            out << m_shards.size() << "\n";
+            out.close();
+            if (!out) {
+                logger.error("[ShardedSnapshot] Could not write " + layoutPath);
+                return false;
+            }
+        }
+        m_layoutChecked = true;
+        return true;
+    }
+
+  private:
+    std::string m_directory;
+    std::vector<std::unique_ptr<DailySnapshot>> m_shards;
+    std::vector<std::unique_ptr<PinnedState>> m_shardStates; // each shard's own pin
+    DocumentQueue* m_docQueue = nullptr;
+    PinnedState* m_pinnedState = nullptr;
+    std::string m_ipfsEndpoint = "http://127.0.0.1:5001";
+    size_t m_parallelism;
+    bool m_sealed = false;
+    bool m_layoutChecked = false;
+};
+
+} // namespace core
+} // namespace rxrevoltchain
+
+#endif // RXREVOLTCHAIN_SHARDED_SNAPSHOT_HPP
@@ -0,0 +1,176 @@
+#ifndef RXREVOLTCHAIN_SIGNATURE_VERIFIER_HPP
+#define RXREVOLTCHAIN_SIGNATURE_VERIFIER_HPP
+
+#include "json_parser.hpp"
+#include "lru_cache.hpp"
+#include "metrics.hpp"
+#include "thread_pool.hpp"
+#include "transaction.hpp"
+#include <functional>
+#include <memory>
+#include <openssl/evp.h>
+#include <string>
+#include <vector>
+
+namespace rxrevoltchain {
+namespace core {
+
+/*
+  SignatureVerifier
+  --------------------------------
+  Checks the ECDSA (secp256k1, SHA-256) signatures of submitted transactions in bulk.
+
+  - Each transaction's public key comes from a KeyResolver. The default one reads a
+    "public_key" member (130 hex digits, uncompressed point) from the JSON metadata.
+  - Parsed keys are kept in a util::LruCache keyed by the raw key bytes. Submitters
+    reuse a handful of keys, so a verification normally costs no DER parsing. Bytes that
+    are not a valid point are cached too, as a null key.
+  - Every thread keeps one EVP_MD_CTX and resets it per signature
+    (Transaction::VerifySignature(EVP_PKEY*, EVP_MD_CTX*)).
+  - VerifyBatch() splits a batch (e.g. a whole DocumentQueue::FetchAll) across the
+    shared ThreadPool. DailySnapshot uses it to drop forged submissions before
+    redaction, since the signature covers the payload as submitted.
+  - Exports rxrevolt_signature_* metrics (util::metrics): verifications by result and
+    key cache hits and misses.
+*/
+
+class SignatureVerifier {
+  public:
+    static constexpr size_t DEFAULT_KEY_CACHE = 4096;
+
+    // Sets 'publicKey' for 'tx'; false if the transaction names no key
+    using KeyResolver =
+        std::function<bool(const Transaction& tx, std::vector<uint8_t>& publicKey)>;
+
+    explicit SignatureVerifier(size_t keyCacheCapacity = DEFAULT_KEY_CACHE)
+        : m_keys(keyCacheCapacity), m_resolver(&SignatureVerifier::MetadataPublicKey) {}
+
+    SignatureVerifier(const SignatureVerifier&) = delete;
+    SignatureVerifier& operator=(const SignatureVerifier&) = delete;
+
+    // Replaces the default resolver (not thread-safe against running verifications)
+    void SetKeyResolver(KeyResolver resolver) { m_resolver = std::move(resolver); }
+
+    // Verify tx against the key its resolver names
+    bool Verify(const Transaction& tx) {
+        std::vector<uint8_t> publicKey;
+        if (!m_resolver || !m_resolver(tx, publicKey)) {
+            Metrics::get().rejected.inc();
+            return false;
+        }
+        return Verify(tx, publicKey);
+    }
+
+    // Verify tx against 'publicKey' (65-byte uncompressed secp256k1 point)
+    bool Verify(const Transaction& tx, const std::vector<uint8_t>& publicKey) {
+        Metrics& metrics = Metrics::get();
+        std::shared_ptr<EVP_PKEY> key = lookupKey(publicKey);
+        EVP_MD_CTX* ctx = threadContext();
+        const bool ok = key && ctx && tx.VerifySignature(key.get(), ctx);
+        (ok ? metrics.verified : metrics.rejected).inc();
+        return ok;
+    }
+
+    // Verifies batch[i] for every i in parallel; result[i] is 1 if its signature is valid.
+    // Only transactions of type 'type' are checked, the others are reported valid.
+    std::vector<char> VerifyBatch(const std::vector<Transaction>& batch,
+                                  const std::string& type = "document_submission") {
+        std::vector<char> valid(batch.size(), 1);
+        // ECDSA verification is ~50us, so small blocks already amortize the scheduling
+        util::ThreadPool::getInstance().parallelFor(
+            batch.size(), 16, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    if (batch[i].GetType() == type) {
+                        valid[i] = Verify(batch[i]) ? 1 : 0;
+                    }
+                }
+            });
+        return valid;
+    }
+
+    // Number of parsed (or rejected) keys currently cached
+    size_t CachedKeys() const { return m_keys.size(); }
+
+    // Default resolver: {"public_key": "04..."} in the transaction's JSON metadata
+    static bool MetadataPublicKey(const Transaction& tx, std::vector<uint8_t>& publicKey) {
+        util::JsonValue doc;
+        if (!util::JsonStreamParser::parse(tx.GetMetadata(), doc)) {
+            return false;
+        }
+        const util::JsonValue* hex = doc.find("public_key");
+        return hex && hex->isString() && decodeHex(hex->asString(), publicKey);
+    }
+
+  private:
+    // Shared by every SignatureVerifier instance
+    struct Metrics {
+        util::metrics::Counter& verified;
+        util::metrics::Counter& rejected;
+        util::metrics::Counter& keyHits;
+        util::metrics::Counter& keyMisses;
+
+        static Metrics& get() {
+            using util::metrics::Registry;
+            Registry& r = Registry::getInstance();
+            static const char* results = "Transaction signatures checked, by result.";
+            static const char* lookups = "Public key cache lookups, by result.";
+            static Metrics metrics{
+                r.counter("rxrevolt_signature_verifications_total", results, "result=\"ok\""),
+                r.counter("rxrevolt_signature_verifications_total", results,
+                          "result=\"rejected\""),
+                r.counter("rxrevolt_signature_key_cache_total", lookups, "result=\"hit\""),
+                r.counter("rxrevolt_signature_key_cache_total", lookups, "result=\"miss\"")};
+            return metrics;
+        }
+    };
+
+    std::shared_ptr<EVP_PKEY> lookupKey(const std::vector<uint8_t>& publicKey) {
+        const std::string id(publicKey.begin(), publicKey.end());
+        std::shared_ptr<EVP_PKEY> key;
+        if (m_keys.get(id, key)) {
+            Metrics::get().keyHits.inc();
+            return key;
+        }
+        Metrics::get().keyMisses.inc();
+        key.reset(Transaction::ParsePublicKey(publicKey), EVP_PKEY_free);
+        m_keys.put(id, key);
+        return key;
+    }
+
+    // One digest context per thread, reset before every use
+    static EVP_MD_CTX* threadContext() {
+        thread_local std::unique_ptr<EVP_MD_CTX, void (*)(EVP_MD_CTX*)> ctx(EVP_MD_CTX_new(),
+                                                                           EVP_MD_CTX_free);
+        return ctx.get();
+    }
+
+    static bool decodeHex(const std::string& hex, std::vector<uint8_t>& out) {
+        auto nibble = [](char c) {
+            return c >= '0' && c <= '9'   ? c - '0'
+                   : c >= 'a' && c <= 'f' ? c - 'a' + 10
+                   : c >= 'A' && c <= 'F' ? c - 'A' + 10
+                                          : -1;
+        };
+        if (hex.size() % 2 != 0) {
+            return false;
+        }
+        out.resize(hex.size() / 2);
+        for (size_t i = 0; i < out.size(); ++i) {
+            const int hi = nibble(hex[2 * i]);
+            const int lo = nibble(hex[2 * i + 1]);
+            if (hi < 0 || lo < 0) {
+                return false;
+            }
+            out[i] = static_cast<uint8_t>(hi << 4 | lo);
+        }
+        return true;
+    }
+
+    util::LruCache<std::string, std::shared_ptr<EVP_PKEY>> m_keys;
+    KeyResolver m_resolver;
+};
+
+} // namespace core
+} // namespace rxrevoltchain
+
+#endif // RXREVOLTCHAIN_SIGNATURE_VERIFIER_HPP
@@ -1,11 +1,14 @@
 #ifndef RXREVOLTCHAIN_TRANSACTION_HPP
 #define RXREVOLTCHAIN_TRANSACTION_HPP
 
+#include <algorithm>
 #include <string>
 #include <vector>
 #include <stdexcept>
+#include <utility>
 #include <openssl/evp.h>
 #include <openssl/sha.h>
+#include <openssl/x509.h>
 
 /*
   transaction.hpp
@@ -26,12 +29,24 @@
     const std::vector<uint8_t>& GetPayload() const
     bool VerifySignature(const std::vector<uint8_t> &publicKey) const
 
+  Move-aware additions:
+    Each setter also has an rvalue overload that takes ownership of the buffer, and
+    MutablePayload() exposes the payload for in-place edits (e.g. PII redaction), so a
+    document's bytes are allocated once on the way from submission to SQLite.
+
+  Verification with pre-parsed keys:
+    static EVP_PKEY* ParsePublicKey(const std::vector<uint8_t> &publicKey)
+    bool VerifySignature(EVP_PKEY *key, EVP_MD_CTX *ctx) const
+  let a caller (see SignatureVerifier) parse each key once and reuse one digest context
+  per thread instead of building both for every signature.
+
   Explanation:
    - We treat 'publicKey' as an uncompressed secp256k1 key of length 65 bytes:
        [0x04][32-byte X][32-byte Y].
      The signature must be in DER format for ECDSA.
-   - We create an EVP_PKEY via `EVP_PKEY_new_raw_public_key(EVP_PKEY_EC, ...)`,
-     skipping the 0x04 byte for the actual X+Y portion.
+   - The key is wrapped in a fixed SubjectPublicKeyInfo header (id-ecPublicKey,
+     secp256k1) and decoded with d2i_PUBKEY. (EVP_PKEY_new_raw_public_key only accepts
+     raw X25519/Ed25519-style keys, not EC points.)
    - Then use EVP_DigestVerifyInit/Update/Final to check the signature against
      SHA-256(payload).
 */
@@ -51,6 +66,11 @@ public:
         m_type = type;
     }
 
+    void SetType(std::string &&type)
+    {
+        m_type = std::move(type);
+    }
+
     // Returns the transaction type
     const std::string& GetType() const
     {
@@ -63,6 +83,11 @@ public:
         m_signature = signature;
     }
 
+    void SetSignature(std::vector<uint8_t> &&signature)
+    {
+        m_signature = std::move(signature);
+    }
+
     // Returns the signature
     const std::vector<uint8_t>& GetSignature() const
     {
@@ -75,6 +100,11 @@ public:
         m_metadata = metadata;
     }
 
+    void SetMetadata(std::string &&metadata)
+    {
+        m_metadata = std::move(metadata);
+    }
+
     // Returns the metadata
     const std::string& GetMetadata() const
     {
@@ -87,12 +117,23 @@ public:
         m_payload = data;
     }
 
+    void SetPayload(std::vector<uint8_t> &&data)
+    {
+        m_payload = std::move(data);
+    }
+
     // Returns the binary payload
     const std::vector<uint8_t>& GetPayload() const
     {
         return m_payload;
     }
 
+    // Returns the payload for in-place modification (avoids a copy-out/copy-back)
+    std::vector<uint8_t>& MutablePayload()
+    {
+        return m_payload;
+    }
+
     /*
       VerifySignature:
         - Uses EVP interface to verify an ECDSA signature over SHA-256(payload).
@@ -102,18 +143,8 @@ public:
     */
     bool VerifySignature(const std::vector<uint8_t> &publicKey) const
     {
-        // Sanity checks
-        if (publicKey.size() != 65 || publicKey[0] != 0x04)
-        {
-            return false; // Not a valid uncompressed secp256k1 key
-        }
-        if (m_signature.empty() || m_payload.empty())
-        {
-            return false; // No signature or nothing to verify
-        }
-
-        // Convert pubkey to an EVP_PKEY
-        EVP_PKEY* pkey = createEVPKeyFromPubkey(publicKey);
+        // Convert pubkey to an EVP_PKEY (nullptr if it is not an uncompressed secp256k1 key)
+        EVP_PKEY* pkey = ParsePublicKey(publicKey);
         if (!pkey)
         {
             return false;
@@ -121,66 +152,71 @@ public:
 
         // Initialize context for verification
         EVP_MD_CTX* ctx = EVP_MD_CTX_new();
-        if (!ctx)
+        const bool ok = ctx && VerifySignature(pkey, ctx);
+
+        // Clean up
+        EVP_MD_CTX_free(ctx);
+        EVP_PKEY_free(pkey);
+        return ok;
+    }
+
+    /*
+      VerifySignature (pre-parsed key):
+        - Same check as above with a key from ParsePublicKey and a caller-owned digest
+          context, which is reset first and may be reused for the next call.
+        - 'key' is only read, so one key may be shared by several threads at once.
+    */
+    bool VerifySignature(EVP_PKEY *key, EVP_MD_CTX *ctx) const
+    {
+        if (!key || !ctx || m_signature.empty() || m_payload.empty())
+        {
+            return false; // No signature or nothing to verify
+        }
+        if (EVP_MD_CTX_reset(ctx) != 1)
         {
-            EVP_PKEY_free(pkey);
             return false;
         }
 
-        // Setup for ECDSA with SHA-256
-        if (EVP_DigestVerifyInit(ctx, nullptr, EVP_sha256(), nullptr, pkey) != 1)
+        // Setup for ECDSA with SHA-256, feed in our payload and compare the signature
+        if (EVP_DigestVerifyInit(ctx, nullptr, EVP_sha256(), nullptr, key) != 1)
         {
-            EVP_MD_CTX_free(ctx);
-            EVP_PKEY_free(pkey);
             return false;
         }
-
-        // Feed in our payload
         if (EVP_DigestVerifyUpdate(ctx, m_payload.data(), m_payload.size()) != 1)
         {
-            EVP_MD_CTX_free(ctx);
-            EVP_PKEY_free(pkey);
             return false;
         }
-
-        // Final verification step: compare signature
         int rc = EVP_DigestVerifyFinal(ctx, m_signature.data(), m_signature.size());
 
-        // Clean up
-        EVP_MD_CTX_free(ctx);
-        EVP_PKEY_free(pkey);
-
         // rc == 1 => success
         return (rc == 1);
     }
 
-private:
     /*
-      createEVPKeyFromPubkey:
-        - Creates an EVP_PKEY* from a 65-byte uncompressed secp256k1 public key.
-        - We skip the first byte (0x04) and pass the remaining 64 bytes to
-          EVP_PKEY_new_raw_public_key(EVP_PKEY_EC, ...).
+      ParsePublicKey:
+        - Creates an EVP_PKEY* from a 65-byte uncompressed secp256k1 public key
+          ([0x04][X(32 bytes)][Y(32 bytes)]); the caller frees it with EVP_PKEY_free.
+        - Returns nullptr if the bytes are not a point on the curve.
     */
-    static EVP_PKEY* createEVPKeyFromPubkey(const std::vector<uint8_t> &pubKeyUncompressed)
+    static EVP_PKEY* ParsePublicKey(const std::vector<uint8_t> &pubKeyUncompressed)
     {
-        // Expect [0x04][X(32 bytes)][Y(32 bytes)] => 65 bytes total
         if (pubKeyUncompressed.size() != 65 || pubKeyUncompressed[0] != 0x04)
         {
-            return nullptr;
-        }
-
-        // The "raw" portion is X+Y = 64 bytes
-        const unsigned char* rawXY = pubKeyUncompressed.data() + 1;
-        size_t rawLen = 64;
-
-        EVP_PKEY* pkey = EVP_PKEY_new_raw_public_key(EVP_PKEY_EC, /*engine=*/nullptr,
-                                                     rawXY, rawLen);
-        if (!pkey)
-        {
-            return nullptr;
+            return nullptr; // Not a valid uncompressed secp256k1 key
         }
 
-        return pkey;
+        // DER SubjectPublicKeyInfo: SEQUENCE { SEQUENCE { id-ecPublicKey, secp256k1 },
+        // BIT STRING { 0x00 unused bits, point } }
+        static const unsigned char spkiHeader[] = {
+            0x30, 0x56, 0x30, 0x10, 0x06, 0x07, 0x2a, 0x86, 0x48, 0xce, 0x3d, 0x02,
+            0x01, 0x06, 0x05, 0x2b, 0x81, 0x04, 0x00, 0x0a, 0x03, 0x42, 0x00};
+        unsigned char der[sizeof(spkiHeader) + 65];
+        std::copy(spkiHeader, spkiHeader + sizeof(spkiHeader), der);
+        std::copy(pubKeyUncompressed.begin(), pubKeyUncompressed.end(),
+                  der + sizeof(spkiHeader));
+
+        const unsigned char* cursor = der;
+        return d2i_PUBKEY(nullptr, &cursor, static_cast<long>(sizeof(der)));
     }
 
 private:
@@ -0,0 +1,520 @@
+#ifndef RXREVOLTCHAIN_WRITE_AHEAD_LOG_HPP
+#define RXREVOLTCHAIN_WRITE_AHEAD_LOG_HPP
+
+#include "logger.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <mutex>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include <zlib.h>
+
+namespace rxrevoltchain {
+namespace core {
+
+/*
+  WriteAheadLog
+  --------------------------------
+  Append-only, crash-safe record log used by DocumentQueue.
+
+  "Fully functional" approach:
+   - One file descriptor stays open for the lifetime of the log; records are appended
+     with write(2), never through a reopened stream.
+   - Group commit: concurrent Append() callers queue their encoded records under a short
+     lock. The first caller to find no flush in progress becomes the leader, writes every
+     queued record with one write(2) (plus one fdatasync for FsyncPolicy::EveryRecord)
+     and wakes the followers whose records were in that batch. A burst of N submissions
+     therefore costs a handful of syscalls, not N open/write/close cycles.
+   - Fsync policy:
+       EveryRecord - Append returns once the record's batch is on stable storage.
+       IntervalMs  - Append returns once written to the OS; a background thread runs
+                     fdatasync every 'fsyncIntervalMs' while there is unsynced data.
+       None        - Append returns once written to the OS; durability is left to the OS.
+   - Each record carries a CRC32 so replay (Open) can detect a torn or corrupt tail. Replay
+     stops at the first bad record and truncates the file there, so later appends never
+     follow garbage.
+
+  File format (integers little-endian):
+     1) 8 bytes: magic "RXWAL" 0x00 0x00 0x01
+     2) Records, each:
+          - 4 bytes: payload length (uint32_t)
+          - 4 bytes: CRC32 over the 4 length bytes followed by the payload
+          - payload bytes
+   Files of at least 8 bytes without the magic (written before the WAL existed) are
+   reported by IsLegacyFile() so the owner can migrate them; see DocumentQueue. A shorter
+   file is a header torn by a crash: replay starts a fresh log if it is a prefix of the
+   magic and fails otherwise.
+
+  THREAD-SAFETY:
+   - All public methods are thread-safe. File I/O for a batch, and every fdatasync, runs
+     outside the lock that producers take to enqueue, so producers never wait on the
+     disk to queue a record.
+*/
+
+class WriteAheadLog {
+  public:
+    enum class FsyncPolicy { EveryRecord, IntervalMs, None };
+
+    struct Options {
+        FsyncPolicy policy = FsyncPolicy::EveryRecord;
+        uint32_t fsyncIntervalMs = 10; // used by FsyncPolicy::IntervalMs
+    };
+
+    WriteAheadLog() = default;
+    explicit WriteAheadLog(const Options& options) : m_options(options) {}
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+    ~WriteAheadLog() { Close(); }
+
+    /** Options take effect on the next Open()/Create(). */
+    void SetOptions(const Options& options) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_options = options;
+    }
+
+    /** True if 'path' holds at least a header's worth of bytes not starting with the magic. */
+    static bool IsLegacyFile(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+        char head[sizeof(kMagic)];
+        ssize_t n = ::read(fd, head, sizeof(head));
+        ::close(fd);
+        // Shorter files are torn headers; even the legacy format needs 16 bytes per record
+        return n == static_cast<ssize_t>(sizeof(kMagic)) &&
+               std::memcmp(head, kMagic, sizeof(kMagic)) != 0;
+    }
+
+    /**
+     * Open (or create) the log at 'path' and replay it into 'records'.
+     * A torn or corrupt tail is dropped and truncated away. A legacy file (see
+     * IsLegacyFile) is not touched and makes Open fail; use Create() to replace it.
+     * @return false on I/O errors or a legacy file.
+     */
+    bool Open(const std::string& path, std::vector<std::vector<uint8_t>>& records) {
+        using namespace rxrevoltchain::util::logger;
+        Close();
+        records.clear();
+        if (IsLegacyFile(path)) {
+            return false;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        int fd = ::open(path.c_str(), O_RDWR | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            Logger::getInstance().error("[WriteAheadLog] Cannot open " + path + ": " +
+                                        std::strerror(errno));
+            return false;
+        }
+
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            return false;
+        }
+        uint64_t goodEnd = 0;
+        if (st.st_size > 0 && st.st_size < static_cast<off_t>(sizeof(kMagic))) {
+            if (!isTornHeader(fd, static_cast<size_t>(st.st_size))) {
+                Logger::getInstance().error("[WriteAheadLog] Corrupt header in " + path);
+                ::close(fd);
+                return false;
+            }
+            Logger::getInstance().warn("[WriteAheadLog] Rewriting torn header of " + path);
+            if (::ftruncate(fd, 0) != 0) {
+                ::close(fd);
+                return false;
+            }
+            st.st_size = 0;
+        }
+        if (st.st_size == 0) {
+            if (!writeAll(fd, kMagic, sizeof(kMagic)) || ::fdatasync(fd) != 0) {
+                ::close(fd);
+                return false;
+            }
+            goodEnd = sizeof(kMagic);
+        } else if (!replay(fd, static_cast<uint64_t>(st.st_size), records, goodEnd)) {
+            ::close(fd);
+            return false;
+        }
+
+        if (goodEnd < static_cast<uint64_t>(st.st_size)) {
+            Logger::getInstance().warn("[WriteAheadLog] Dropping torn tail of " + path + " (" +
+                                       std::to_string(st.st_size - goodEnd) + " bytes)");
+            if (::ftruncate(fd, static_cast<off_t>(goodEnd)) != 0 || ::fdatasync(fd) != 0) {
+                ::close(fd);
+                return false;
+            }
+        }
+        startLocked(fd, path, goodEnd);
+        return true;
+    }
+
+    /** Create an empty log at 'path', replacing any existing file. */
+    bool Create(const std::string& path) {
+        Close();
+        std::unique_lock<std::mutex> lock(m_mutex);
+        int fd = ::open(path.c_str(), O_RDWR | O_APPEND | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            return false;
+        }
+        if (!writeAll(fd, kMagic, sizeof(kMagic)) || ::fdatasync(fd) != 0) {
+            ::close(fd);
+            return false;
+        }
+        startLocked(fd, path, sizeof(kMagic));
+        return true;
+    }
+
+    /** Flush outstanding records, stop the sync thread and close the file. */
+    void Close() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_fd < 0) {
+            return;
+        }
+        m_cv.wait(lock, [this] { return !m_flushing; });
+        if (!m_pending.empty()) {
+            flushLocked(lock);
+        }
+        m_closing = true;
+        m_syncCv.notify_all();
+        std::thread syncer = std::move(m_syncThread);
+        lock.unlock();
+        if (syncer.joinable()) {
+            syncer.join();
+        }
+        lock.lock();
+        m_cv.wait(lock, [this] { return m_syncers == 0; });
+        if (dirty()) {
+            ::fdatasync(m_fd);
+        }
+        ::close(m_fd);
+        m_fd = -1;
+        m_closing = false;
+    }
+
+    bool IsOpen() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_fd >= 0;
+    }
+
+    /**
+     * Queue a record and wait until it is durable per the fsync policy.
+     * @return false if the log is closed or the batch containing the record failed.
+     */
+    bool Append(const std::vector<uint8_t>& payload) {
+        uint64_t ticket = 0;
+        if (!Enqueue(payload, ticket)) {
+            return false;
+        }
+        return Wait(ticket);
+    }
+
+    /**
+     * Queue a record without waiting. Records are written in enqueue order.
+     * @param ticket Receives the value to pass to Wait().
+     */
+    bool Enqueue(const std::vector<uint8_t>& payload, uint64_t& ticket) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_fd < 0) {
+            return false;
+        }
+        encodeRecord(payload, m_pending);
+        ticket = ++m_lastTicket;
+        return true;
+    }
+
+    /**
+     * Block until the record with 'ticket' has been written (and synced for
+     * EveryRecord). The calling thread leads the next group commit if none is running.
+     */
+    bool Wait(uint64_t ticket) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (m_committedTicket < ticket) {
+            if (m_fd < 0) {
+                return false;
+            }
+            if (m_flushing) {
+                m_cv.wait(lock);
+                continue;
+            }
+            flushLocked(lock);
+        }
+        return ticket < m_failedFirst || ticket > m_failedLast;
+    }
+
+    /** Force an fdatasync of everything written so far. */
+    bool Sync() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_fd < 0) {
+            return false;
+        }
+        m_cv.wait(lock, [this] { return !m_flushing; });
+        if (!m_pending.empty()) {
+            flushLocked(lock);
+        }
+        return syncUnlocked(lock);
+    }
+
+    /**
+     * Discard every record, written or still queued, leaving an empty log. Waiters on
+     * discarded records are released with success: their records were consumed.
+     */
+    bool Reset() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_fd < 0) {
+            return false;
+        }
+        m_cv.wait(lock, [this] { return !m_flushing; });
+        m_pending.clear();
+        m_committedTicket = m_lastTicket;
+        m_cv.notify_all();
+        if (::ftruncate(m_fd, static_cast<off_t>(sizeof(kMagic))) != 0) {
+            return false;
+        }
+        m_size = sizeof(kMagic);
+        ++m_writeGen;
+        if (m_options.policy == FsyncPolicy::EveryRecord) {
+            return syncUnlocked(lock);
+        }
+        return true;
+    }
+
+    /** Number of write(2) batches issued since Open (for tests and metrics). */
+    uint64_t BatchCount() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_batches;
+    }
+
+  private:
+    static constexpr char kMagic[8] = {'R', 'X', 'W', 'A', 'L', 0, 0, 1};
+    static constexpr uint32_t kMaxRecord = 1u << 30;
+
+    static void putU32(std::vector<uint8_t>& out, uint32_t v) {
+        for (int i = 0; i < 4; ++i) {
+            out.push_back(static_cast<uint8_t>(v >> (8 * i)));
+        }
+    }
+
+    static uint32_t getU32(const uint8_t* p) {
+        return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) |
+               (uint32_t(p[3]) << 24);
+    }
+
+    static uint32_t recordCrc(const uint8_t* lenBytes, const uint8_t* data, uint32_t len) {
+        uLong crc = crc32(0L, Z_NULL, 0);
+        crc = crc32(crc, lenBytes, 4);
+        // zlib takes uInt lengths; records are capped at kMaxRecord
+        crc = crc32(crc, data, static_cast<uInt>(len));
+        return static_cast<uint32_t>(crc);
+    }
+
+    static void encodeRecord(const std::vector<uint8_t>& payload, std::vector<uint8_t>& out) {
+        const uint32_t len = static_cast<uint32_t>(payload.size());
+        size_t at = out.size();
+        out.reserve(at + 8 + payload.size());
+        putU32(out, len);
+        putU32(out, 0);
+        out.insert(out.end(), payload.begin(), payload.end());
+        uint32_t crc = recordCrc(&out[at], payload.data(), len);
+        for (int i = 0; i < 4; ++i) {
+            out[at + 4 + i] = static_cast<uint8_t>(crc >> (8 * i));
+        }
+    }
+
+    // True if the 'size' bytes of a file shorter than the header are a prefix of the magic
+    static bool isTornHeader(int fd, size_t size) {
+        char head[sizeof(kMagic)];
+        return ::pread(fd, head, size, 0) == static_cast<ssize_t>(size) &&
+               std::memcmp(head, kMagic, size) == 0;
+    }
+
+    static bool writeAll(int fd, const void* data, size_t len) {
+        const char* p = static_cast<const char*>(data);
+        while (len > 0) {
+            ssize_t n = ::write(fd, p, len);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            p += n;
+            len -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    // Reads records after the header; 'goodEnd' is the offset just past the last valid record.
+    static bool replay(int fd, uint64_t fileSize, std::vector<std::vector<uint8_t>>& records,
+                       uint64_t& goodEnd) {
+        std::vector<uint8_t> content(static_cast<size_t>(fileSize));
+        size_t got = 0;
+        while (got < content.size()) {
+            ssize_t n = ::pread(fd, content.data() + got, content.size() - got,
+                                static_cast<off_t>(got));
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                return false;
+            }
+            got += static_cast<size_t>(n);
+        }
+        if (content.size() < sizeof(kMagic) ||
+            std::memcmp(content.data(), kMagic, sizeof(kMagic)) != 0) {
+            return false;
+        }
+
+        size_t pos = sizeof(kMagic);
+        while (pos + 8 <= content.size()) {
+            uint32_t len = getU32(&content[pos]);
+            uint32_t crc = getU32(&content[pos + 4]);
+            if (len > kMaxRecord || pos + 8 + len > content.size()) {
+                break; // torn tail
+            }
+            const uint8_t* data = content.data() + pos + 8;
+            if (recordCrc(&content[pos], data, len) != crc) {
+                break; // corrupt or partially written record
+            }
+            records.emplace_back(data, data + len);
+            pos += 8 + len;
+        }
+        goodEnd = pos;
+        return true;
+    }
+
+    void startLocked(int fd, const std::string& path, uint64_t size) {
+        m_fd = fd;
+        m_path = path;
+        m_size = size;
+        m_pending.clear();
+        m_lastTicket = m_committedTicket = m_failedLast = 0;
+        m_failedFirst = 1;
+        m_batches = 0;
+        m_writeGen = m_syncedGen = 0;
+        if (m_options.policy == FsyncPolicy::IntervalMs) {
+            m_syncThread = std::thread([this] { syncLoop(); });
+        }
+    }
+
+    // Leader side of a group commit. Called with the lock held and m_flushing false;
+    // returns with the lock held.
+    void flushLocked(std::unique_lock<std::mutex>& lock) {
+        std::vector<uint8_t> batch;
+        batch.swap(m_pending);
+        const uint64_t from = m_committedTicket + 1;
+        const uint64_t upTo = m_lastTicket;
+        const uint64_t startSize = m_size;
+        const bool syncNow = (m_options.policy == FsyncPolicy::EveryRecord);
+        const int fd = m_fd;
+        m_flushing = true;
+        lock.unlock();
+
+        bool ok = writeAll(fd, batch.data(), batch.size());
+        if (ok && syncNow) {
+            ok = (::fdatasync(fd) == 0);
+        }
+        if (!ok) {
+            // Never leave a partial record behind for later batches to follow
+            if (::ftruncate(fd, static_cast<off_t>(startSize)) != 0) {
+                rxrevoltchain::util::logger::Logger::getInstance().error(
+                    "[WriteAheadLog] Failed to roll back partial batch in " + m_path);
+            }
+        }
+
+        lock.lock();
+        m_flushing = false;
+        ++m_batches;
+        if (ok) {
+            m_size = startSize + batch.size();
+            ++m_writeGen;
+            if (syncNow) {
+                // Only this leader writes, so the fdatasync covered everything before it
+                m_syncedGen = m_writeGen;
+            }
+        } else {
+            m_failedFirst = from;
+            m_failedLast = upTo;
+            rxrevoltchain::util::logger::Logger::getInstance().error(
+                "[WriteAheadLog] Write failed for " + m_path + ": " + std::strerror(errno));
+        }
+        m_committedTicket = upTo;
+        m_cv.notify_all();
+        if (dirty()) {
+            m_syncCv.notify_all();
+        }
+    }
+
+    bool dirty() const { return m_syncedGen < m_writeGen; }
+
+    // fdatasync of everything written so far. The lock is released for the call, so
+    // producers and group commits carry on meanwhile; Close() waits for it to finish.
+    // Called and returns with the lock held.
+    bool syncUnlocked(std::unique_lock<std::mutex>& lock) {
+        const uint64_t target = m_writeGen;
+        if (m_syncedGen >= target) {
+            return true;
+        }
+        const int fd = m_fd;
+        ++m_syncers;
+        lock.unlock();
+        const bool ok = (::fdatasync(fd) == 0);
+        lock.lock();
+        if (--m_syncers == 0) {
+            m_cv.notify_all();
+        }
+        if (ok) {
+            m_syncedGen = std::max(m_syncedGen, target);
+        }
+        return ok;
+    }
+
+    // Background fdatasync for FsyncPolicy::IntervalMs
+    void syncLoop() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        const auto interval = std::chrono::milliseconds(m_options.fsyncIntervalMs);
+        while (!m_closing) {
+            m_syncCv.wait(lock, [this] { return m_closing || dirty(); });
+            if (m_closing) {
+                break;
+            }
+            m_syncCv.wait_for(lock, interval, [this] { return m_closing; });
+            syncUnlocked(lock);
+        }
+    }
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;     // group-commit completion
+    std::condition_variable m_syncCv; // wakes the interval sync thread
+    Options m_options;
+    int m_fd = -1;
+    std::string m_path;
+    uint64_t m_size = 0;
+    std::vector<uint8_t> m_pending; // encoded records not yet written
+    uint64_t m_lastTicket = 0;      // ticket of the newest queued record
+    uint64_t m_committedTicket = 0; // all tickets <= this have been handled
+    uint64_t m_failedFirst = 1;     // ticket range of the most recent failed batch
+    uint64_t m_failedLast = 0;
+    uint64_t m_batches = 0;
+    uint64_t m_writeGen = 0;  // bumped by every write or truncate ...
+    uint64_t m_syncedGen = 0; // ... and the newest one known to be on stable storage
+    int m_syncers = 0;        // fdatasync calls running without the lock
+    bool m_flushing = false;
+    bool m_closing = false;
+    std::thread m_syncThread;
+};
+
+} // namespace core
+} // namespace rxrevoltchain
+
+#endif // RXREVOLTCHAIN_WRITE_AHEAD_LOG_HPP
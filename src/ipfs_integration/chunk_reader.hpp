@@ -0,0 +1,203 @@
+#ifndef RXREVOLTCHAIN_CHUNK_READER_HPP
+#define RXREVOLTCHAIN_CHUNK_READER_HPP
+
+#include "lru_cache.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <map>
+#include <memory>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace rxrevoltchain {
+namespace ipfs_integration {
+
+/*
+  MappedFile
+  --------------------------------
+  A read-only view of one version of a file: mmap'ed when possible (MADV_RANDOM, since
+  challenges touch a few scattered leaves), read with pread otherwise (e.g. an empty file,
+  or a file system without mmap support). The identity of the version it maps (device,
+  inode, size and modification time) is kept so callers can tell when the file changed.
+*/
+class MappedFile {
+  public:
+    // Null if 'path' cannot be opened
+    static std::shared_ptr<const MappedFile> Open(const std::string& path) {
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return nullptr;
+        }
+        std::shared_ptr<MappedFile> file(new MappedFile(fd));
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            return nullptr;
+        }
+        file->m_version = Version::of(st);
+        file->m_size = static_cast<size_t>(st.st_size);
+        if (file->m_size > 0) {
+            void* addr = ::mmap(nullptr, file->m_size, PROT_READ, MAP_SHARED, fd, 0);
+            if (addr != MAP_FAILED) {
+                ::madvise(addr, file->m_size, MADV_RANDOM);
+                file->m_data = static_cast<const uint8_t*>(addr);
+            }
+        }
+        return file;
+    }
+
+    ~MappedFile() {
+        if (m_data) {
+            ::munmap(const_cast<uint8_t*>(m_data), m_size);
+        }
+        ::close(m_fd);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    size_t Size() const { return m_size; }
+    bool IsMapped() const { return m_data != nullptr; }
+
+    // Copies up to 'length' bytes at 'offset' into 'out'; returns how many were copied
+    // (fewer near the end of the file, zero past it)
+    size_t Read(uint64_t offset, size_t length, uint8_t* out) const {
+        if (offset >= m_size) {
+            return 0;
+        }
+        length = std::min<uint64_t>(length, m_size - offset);
+        if (m_data) {
+            std::memcpy(out, m_data + offset, length);
+            return length;
+        }
+        size_t done = 0;
+        while (done < length) {
+            const ssize_t n = ::pread(m_fd, out + done, length - done,
+                                      static_cast<off_t>(offset + done));
+            if (n <= 0) {
+                break;
+            }
+            done += static_cast<size_t>(n);
+        }
+        return done;
+    }
+
+    // True if 'path' still names the version of the file this object maps
+    bool IsCurrent(const std::string& path) const {
+        struct stat st;
+        return ::stat(path.c_str(), &st) == 0 && Version::of(st) == m_version;
+    }
+
+  private:
+    struct Version {
+        uint64_t device = 0;
+        uint64_t inode = 0;
+        uint64_t size = 0;
+        int64_t mtimeNs = 0;
+
+        static Version of(const struct stat& st) {
+            return Version{static_cast<uint64_t>(st.st_dev), static_cast<uint64_t>(st.st_ino),
+                           static_cast<uint64_t>(st.st_size),
+                           static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 +
+                               st.st_mtim.tv_nsec};
+        }
+        bool operator==(const Version& o) const {
+            return device == o.device && inode == o.inode && size == o.size &&
+                   mtimeNs == o.mtimeNs;
+        }
+    };
+
+    explicit MappedFile(int fd) : m_fd(fd) {}
+
+    int m_fd;
+    const uint8_t* m_data = nullptr;
+    size_t m_size = 0;
+    Version m_version;
+};
+
+/*
+  ChunkReader
+  --------------------------------
+  Serves the challenged chunks of pinned snapshots out of shared MappedFiles, for
+  MerkleProof (proofs over a cached tree) and ProofGenerator.
+
+   - Map() keeps one mapping per path in an LRU cache and hands the same mapping to every
+     caller while the file is unchanged, so concurrent challenges on one snapshot share a
+     single mmap. A file that was rewritten or replaced is mapped again; readers still
+     holding the old mapping keep their version until they drop it.
+   - ReadChunks() checks the file once per batch (one stat) and then copies each requested
+     chunk straight out of the mapping: no stream, seek or read call per chunk.
+   - getInstance() is the process-wide reader; tests may create their own.
+
+  Pinned snapshots are replaced between merge cycles, not truncated while they are being
+  challenged. A file that shrinks under a live mapping would fault (SIGBUS) on access past
+  its new end, so files that are rewritten in place should not be read through here while
+  the write is in progress.
+*/
+class ChunkReader {
+  public:
+    static constexpr size_t DEFAULT_MAPPINGS = 16;
+
+    explicit ChunkReader(size_t maxMappings = DEFAULT_MAPPINGS) : m_files(maxMappings, 1) {}
+
+    ChunkReader(const ChunkReader&) = delete;
+    ChunkReader& operator=(const ChunkReader&) = delete;
+
+    static ChunkReader& getInstance() {
+        static ChunkReader instance;
+        return instance;
+    }
+
+    // Current version of 'path', mapping it if needed; null if it cannot be opened
+    std::shared_ptr<const MappedFile> Map(const std::string& path) {
+        std::shared_ptr<const MappedFile> file;
+        if (m_files.get(path, file) && file->IsCurrent(path)) {
+            return file;
+        }
+        file = MappedFile::Open(path);
+        if (file) {
+            m_files.put(path, file);
+        } else {
+            m_files.erase(path);
+        }
+        return file;
+    }
+
+    // Fills every entry of 'chunks' (chunk index -> bytes) with that chunk of 'path';
+    // chunks at or past the end of the file come back empty. False if the file cannot be
+    // opened.
+    bool ReadChunks(const std::string& path, size_t chunkSize,
+                    std::map<size_t, std::vector<uint8_t>>& chunks) {
+        if (chunks.empty()) {
+            return true;
+        }
+        std::shared_ptr<const MappedFile> file = Map(path);
+        if (!file) {
+            return false;
+        }
+        for (auto& entry : chunks) {
+            entry.second.resize(chunkSize);
+            entry.second.resize(file->Read(static_cast<uint64_t>(entry.first) * chunkSize,
+                                           chunkSize, entry.second.data()));
+        }
+        return true;
+    }
+
+    // Drops the cached mapping of 'path' (it is unmapped once no reader holds it)
+    void Release(const std::string& path) { m_files.erase(path); }
+
+    // Number of files currently mapped by this reader
+    size_t MappedFiles() const { return m_files.size(); }
+
+  private:
+    util::LruCache<std::string, std::shared_ptr<const MappedFile>> m_files;
+};
+
+} // namespace ipfs_integration
+} // namespace rxrevoltchain
+
+#endif // RXREVOLTCHAIN_CHUNK_READER_HPP
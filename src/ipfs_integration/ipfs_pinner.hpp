@@ -4,10 +4,14 @@
 #include <string>
 #include <stdexcept>
 #include <vector>
-#include <fstream>
-#include <sstream>
-#include <mutex>
+#include <memory>
+#include <unordered_map>
+#include <cstdio>
+#include <cstring>
+#include <sys/stat.h>
 #include <curl/curl.h>
+#include "curl_handle_pool.hpp"
+#include "json_parser.hpp"
 #include "logger.hpp"
 
 namespace rxrevoltchain {
@@ -28,10 +32,21 @@ namespace ipfs_integration {
   "Fully functional" approach:
    - Uses libcurl to make HTTP requests to the IPFS daemon API (default: http://127.0.0.1:5001).
    - PinSnapshot: sends the .sqlite file via /api/v0/add?pin=true, parses the resulting CID, and returns it.
+     The file is streamed from disk through a read callback, so it is never held in memory.
+   - PinData: same for an in-memory object (e.g. a SnapshotDelta), sent without copying it.
+   - HashSnapshot: same upload with only-hash=true, returning the file's CID without storing it.
    - UnpinSnapshot: calls /api/v0/pin/rm?arg=<cid>.
-   - VerifyPin: calls /api/v0/pin/ls?arg=<cid> and checks if the CID is listed in the “Keys” or similar JSON.
-   - Thread-safety: a global libcurl init is done once (see static initCurl). Each method uses a std::mutex if needed.
-   - Minimal JSON parsing is done by naive string matching or manual search. You can integrate a JSON library if you wish.
+   - VerifyPin: calls /api/v0/pin/ls?arg=<cid> and checks if the CID is listed in the “Keys” JSON object.
+   - VerifyPins: batch form returning a per-CID PinStatus. Up to SetBatchOptions' listThreshold
+     CIDs are queried concurrently through curl_multi (maxParallel requests in flight); larger
+     batches use one streaming /api/v0/pin/ls?stream=true listing of all pin types instead.
+     Responses are parsed with util::JsonStreamParser while they arrive.
+   - Connections: easy handles are leased from a util::CurlHandlePool (the process-wide one by
+     default), so consecutive calls reuse the keep-alive connection to the daemon.
+   - Timeouts: there is no total limit, since a multi-GB snapshot may legitimately take a long time.
+     A request fails if it cannot connect within the connect timeout, or if no data moves for the
+     stall timeout (see SetTimeouts).
+   - Thread-safety: the pool is thread-safe and each call leases its own handle.
 
    IMPORTANT:
    - You must link against libcurl (-lcurl) for this code to function.
@@ -42,13 +57,43 @@ namespace ipfs_integration {
 class IPFSPinner
 {
 public:
+    // Result of a pin check. Unknown means the daemon could not be asked or gave an
+    // unrecognised answer, which callers must not treat as "not pinned".
+    enum class PinStatus
+    {
+        Pinned,
+        NotPinned,
+        Unknown
+    };
+
     // -------------------------------------------------------------------------
     // Constructor: store the IPFS endpoint (e.g., "http://127.0.0.1:5001")
     // -------------------------------------------------------------------------
-    IPFSPinner(const std::string &ipfsEndpoint)
-        : m_endpoint(ipfsEndpoint)
+    IPFSPinner(const std::string &ipfsEndpoint,
+               util::CurlHandlePool &pool = util::CurlHandlePool::getInstance())
+        : m_endpoint(ipfsEndpoint), m_pool(pool)
+    {
+    }
+
+    // -------------------------------------------------------------------------
+    // Connect and stall limits in seconds; 0 disables the respective limit.
+    // Defaults: 10 s to connect, 60 s without progress.
+    // -------------------------------------------------------------------------
+    void SetTimeouts(long connectSeconds, long stallSeconds)
     {
-        initCurl();
+        m_connectTimeout = connectSeconds;
+        m_stallTimeout = stallSeconds;
+    }
+
+    // -------------------------------------------------------------------------
+    // VerifyPins tuning: requests in flight at once, and the batch size from which
+    // a single full pin listing is cheaper than one request per CID.
+    // Defaults: 8 and 64.
+    // -------------------------------------------------------------------------
+    void SetBatchOptions(size_t maxParallel, size_t listThreshold)
+    {
+        m_maxParallel = maxParallel > 0 ? maxParallel : 1;
+        m_listThreshold = listThreshold;
     }
 
     // -------------------------------------------------------------------------
@@ -59,37 +104,28 @@ public:
     {
         using namespace rxrevoltchain::util::logger;
         Logger::getInstance().info("[IPFSPinner] Pinning snapshot: " + dbFilePath);
+        return addFile(dbFilePath, "pin=true");
+    }
 
-        // Read file data into memory
-        std::vector<uint8_t> fileData;
-        if (!readFile(dbFilePath, fileData))
-        {
-            Logger::getInstance().error("[IPFSPinner] Failed to read file: " + dbFilePath);
-            return std::string();
-        }
-
-        // Prepare the URL for adding a file to IPFS with pin=true
-        std::string url = m_endpoint + "/api/v0/add?pin=true";
-
-        // Build a multipart/form-data request using libcurl
-        std::string response;
-        if (!multipartPost(url, "file", dbFilePath, fileData, response))
-        {
-            Logger::getInstance().error("[IPFSPinner] Failed to POST file to IPFS daemon.");
-            return std::string();
-        }
-
-        // Attempt to parse the "Hash" field from the IPFS response
-        // The response is typically JSON-ish lines like: {"Name":"data.sqlite","Hash":"Qm...","Size":"12345"}
-        std::string cid = parseValueFromResponse(response, "Hash");
-        if (cid.empty())
-        {
-            Logger::getInstance().error("[IPFSPinner] Could not extract CID from IPFS response: " + response);
-            return std::string();
-        }
+    // -------------------------------------------------------------------------
+    // Returns the CID the .sqlite file would get from PinSnapshot without storing or
+    // pinning it (only-hash), e.g. to name a file that was published as a delta.
+    // If something fails, returns an empty string.
+    // -------------------------------------------------------------------------
+    std::string HashSnapshot(const std::string &dbFilePath)
+    {
+        return addFile(dbFilePath, "only-hash=true&pin=false");
+    }
 
-        Logger::getInstance().info("[IPFSPinner] PinSnapshot success, CID: " + cid);
-        return cid;
+    // -------------------------------------------------------------------------
+    // Pins 'data' under the file name 'name', returns its CID or an empty string.
+    // -------------------------------------------------------------------------
+    std::string PinData(const std::string &name, const std::vector<uint8_t> &data)
+    {
+        UploadSource source;
+        source.data = data.data();
+        source.size = data.size();
+        return pinSource(name, source);
     }
 
     // -------------------------------------------------------------------------
@@ -129,64 +165,394 @@ public:
         using namespace rxrevoltchain::util::logger;
         Logger::getInstance().info("[IPFSPinner] Verifying pin for CID: " + cid);
 
-        // IPFS call: /api/v0/pin/ls?arg=<cid>
-        // If the CID is pinned, the response typically contains { "Keys": {"<cid>": {...}}}
-        std::string url = m_endpoint + "/api/v0/pin/ls?arg=" + cid;
+        PinStatus status = VerifyPins({cid})[cid];
+        if (status == PinStatus::Pinned)
+        {
+            Logger::getInstance().info("[IPFSPinner] CID appears to be pinned: " + cid);
+            return true;
+        }
+        if (status == PinStatus::NotPinned)
+        {
+            Logger::getInstance().warn("[IPFSPinner] CID not found in pin list: " + cid);
+        }
+        return false;
+    }
+
+    // -------------------------------------------------------------------------
+    // Checks many CIDs at once; every requested CID appears in the result.
+    // -------------------------------------------------------------------------
+    std::unordered_map<std::string, PinStatus> VerifyPins(const std::vector<std::string> &cids)
+    {
+        std::unordered_map<std::string, PinStatus> result;
+        for (const auto &cid : cids)
+        {
+            result.emplace(cid, PinStatus::Unknown);
+        }
+        if (result.empty())
+        {
+            return result;
+        }
+        if (result.size() >= m_listThreshold)
+        {
+            listPins(result);
+        }
+        else
+        {
+            queryPins(result);
+        }
+        return result;
+    }
+
+private:
+    // -------------------------------------------------------------------------
+    // Upload body for the multipart read callback: either an open file or a
+    // caller-owned buffer, read sequentially from 'offset'.
+    // -------------------------------------------------------------------------
+    struct UploadSource
+    {
+        FILE *file = nullptr;
+        const uint8_t *data = nullptr;
+        uint64_t size = 0;
+        uint64_t offset = 0;
+    };
+
+    // -------------------------------------------------------------------------
+    // Read callback for curl_mime_data_cb: copies the next bytes of the source
+    // -------------------------------------------------------------------------
+    static size_t readCallback(char *buffer, size_t size, size_t nitems, void *arg)
+    {
+        UploadSource &src = *static_cast<UploadSource*>(arg);
+        size_t want = size * nitems;
+        if (src.offset + want > src.size)
+        {
+            want = static_cast<size_t>(src.size - src.offset);
+        }
+        if (want == 0)
+        {
+            return 0;
+        }
+        size_t got = want;
+        if (src.file)
+        {
+            got = std::fread(buffer, 1, want, src.file);
+            if (got == 0)
+            {
+                return CURL_READFUNC_ABORT; // file shrank or read error
+            }
+        }
+        else
+        {
+            std::memcpy(buffer, src.data + src.offset, want);
+        }
+        src.offset += got;
+        return got;
+    }
+
+    // -------------------------------------------------------------------------
+    // Seek callback: libcurl rewinds the body if it has to resend it (e.g. after a redirect)
+    // -------------------------------------------------------------------------
+    static int seekCallback(void *arg, curl_off_t offset, int origin)
+    {
+        UploadSource &src = *static_cast<UploadSource*>(arg);
+        if (origin != SEEK_SET || offset < 0 || static_cast<uint64_t>(offset) > src.size)
+        {
+            return CURL_SEEKFUNC_CANTSEEK;
+        }
+        if (src.file && fseeko(src.file, static_cast<off_t>(offset), SEEK_SET) != 0)
+        {
+            return CURL_SEEKFUNC_FAIL;
+        }
+        src.offset = static_cast<uint64_t>(offset);
+        return CURL_SEEKFUNC_OK;
+    }
+
+    // -------------------------------------------------------------------------
+    // Applies the shared options (URL, limits, response capture) to a leased handle
+    // -------------------------------------------------------------------------
+    void prepareHandle(CURL *curl, const std::string &url, std::string &responseOut,
+                       util::CurlHandlePool::StallWatch &watch)
+    {
+        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+        util::CurlHandlePool::applyStallTimeouts(curl, m_connectTimeout, watch);
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCallback);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &responseOut);
+    }
+
+    // -------------------------------------------------------------------------
+    // Shared body of PinSnapshot/HashSnapshot: streams the file from disk instead of
+    // reading it into memory, passing 'query' on to /api/v0/add.
+    // -------------------------------------------------------------------------
+    std::string addFile(const std::string &dbFilePath, const std::string &query)
+    {
+        using namespace rxrevoltchain::util::logger;
+
+        UploadSource source;
+        struct stat st;
+        if (::stat(dbFilePath.c_str(), &st) != 0 || !S_ISREG(st.st_mode) ||
+            (source.file = std::fopen(dbFilePath.c_str(), "rb")) == nullptr)
+        {
+            Logger::getInstance().error("[IPFSPinner] Failed to read file: " + dbFilePath);
+            return std::string();
+        }
+        source.size = static_cast<uint64_t>(st.st_size);
+
+        std::string cid = pinSource(dbFilePath, source, query);
+        std::fclose(source.file);
+        return cid;
+    }
+
+    // -------------------------------------------------------------------------
+    // Shared body of all uploads: POST the source to /api/v0/add?<query>
+    // -------------------------------------------------------------------------
+    std::string pinSource(const std::string &name, UploadSource &source,
+                          const std::string &query = "pin=true")
+    {
+        using namespace rxrevoltchain::util::logger;
+
+        // Prepare the URL for adding a file to IPFS (pin=true unless only hashing)
+        std::string url = m_endpoint + "/api/v0/add?" + query;
+
+        // Build a multipart/form-data request using libcurl
         std::string response;
-        if (!httpGet(url, response))
+        if (!multipartPost(url, "file", name, source, response))
         {
-            Logger::getInstance().error("[IPFSPinner] Could not check pin status for CID: " + cid);
-            return false;
+            Logger::getInstance().error("[IPFSPinner] Failed to POST file to IPFS daemon.");
+            return std::string();
         }
 
-        // A naive check: see if "Keys" object includes the CID
-        // Example success: {"Keys":{"QmHash":{"Type":"recursive"}}}
-        if (response.find(cid) != std::string::npos)
+        // Attempt to parse the "Hash" field from the IPFS response
+        // The response is typically JSON-ish lines like: {"Name":"data.sqlite","Hash":"Qm...","Size":"12345"}
+        std::string cid = parseValueFromResponse(response, "Hash");
+        if (cid.empty())
         {
-            Logger::getInstance().info("[IPFSPinner] CID appears to be pinned: " + cid);
-            return true;
+            Logger::getInstance().error("[IPFSPinner] Could not extract CID from IPFS response: " + response);
+            return std::string();
         }
 
-        Logger::getInstance().warn("[IPFSPinner] CID not found in pin list. Response: " + response);
-        return false;
+        Logger::getInstance().info("[IPFSPinner] Add (" + query + ") success, CID: " + cid);
+        return cid;
     }
 
-private:
     // -------------------------------------------------------------------------
-    // Static initialization of libcurl for the entire process
+    // Response sink that feeds a JsonStreamParser directly from libcurl
+    // -------------------------------------------------------------------------
+    static size_t jsonWriteCallback(char *ptr, size_t size, size_t nmemb, void *userdata)
+    {
+        util::JsonStreamParser &parser = *static_cast<util::JsonStreamParser*>(userdata);
+        size_t total = size * nmemb;
+        // A syntax error aborts the transfer (CURLE_WRITE_ERROR)
+        return parser.feed(ptr, total) ? total : 0;
+    }
+
+    // -------------------------------------------------------------------------
+    // Maps one /pin/ls?arg=<cid> answer to a status. A pinned CID is listed under
+    // "Keys"; an unpinned one yields an error object whose message says so.
     // -------------------------------------------------------------------------
-    static void initCurl()
+    static PinStatus pinStatusFromResponse(const std::string &cid, const util::JsonValue &doc)
     {
-        static bool initialized = false;
-        static std::mutex initMutex;
-        std::lock_guard<std::mutex> lock(initMutex);
-        if (!initialized)
+        const util::JsonValue *keys = doc.find("Keys");
+        if (keys && keys->isObject())
+        {
+            return keys->find(cid) ? PinStatus::Pinned : PinStatus::NotPinned;
+        }
+        const util::JsonValue *message = doc.find("Message");
+        if (message && message->isString() &&
+            message->asString().find("not pinned") != std::string::npos)
         {
-            curl_global_init(CURL_GLOBAL_ALL);
-            initialized = true;
+            return PinStatus::NotPinned;
         }
+        return PinStatus::Unknown;
     }
 
     // -------------------------------------------------------------------------
-    // Helper: read an entire file into a byte vector
+    // Small batches: one pin/ls request per CID, run concurrently on a curl multi
+    // handle with at most m_maxParallel transfers in flight. A single CID is sent
+    // on the easy handle itself, which keeps using the pooled keep-alive connection
+    // (a multi handle has a connection cache of its own).
     // -------------------------------------------------------------------------
-    bool readFile(const std::string &filePath, std::vector<uint8_t> &buffer)
+    void queryPins(std::unordered_map<std::string, PinStatus> &result)
     {
-        std::ifstream ifs(filePath, std::ios::binary | std::ios::ate);
-        if (!ifs.is_open())
+        using namespace rxrevoltchain::util::logger;
+
+        struct Query
         {
-            return false;
+            explicit Query(const std::string &c, long stallSeconds)
+                : cid(c), watch(stallSeconds),
+                  parser([this](util::JsonValue &&v) { doc = std::move(v); })
+            {
+            }
+            std::string cid;
+            std::string url;
+            util::CurlHandlePool::Handle handle;
+            util::CurlHandlePool::StallWatch watch;
+            util::JsonValue doc;
+            util::JsonStreamParser parser;
+        };
+
+        auto setup = [this](Query &q) {
+            CURL *curl = q.handle.get();
+            q.url = m_endpoint + "/api/v0/pin/ls?arg=" + q.cid;
+            curl_easy_setopt(curl, CURLOPT_URL, q.url.c_str());
+            util::CurlHandlePool::applyStallTimeouts(curl, m_connectTimeout, q.watch);
+            curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, jsonWriteCallback);
+            curl_easy_setopt(curl, CURLOPT_WRITEDATA, &q.parser);
+            curl_easy_setopt(curl, CURLOPT_PRIVATE, &q);
+        };
+        auto complete = [&result](Query &q, CURLcode res) {
+            if (res == CURLE_OK && q.parser.finish())
+            {
+                result[q.cid] = pinStatusFromResponse(q.cid, q.doc);
+            }
+            else
+            {
+                Logger::getInstance().warn("[IPFSPinner] Pin check failed for CID: " + q.cid);
+            }
+        };
+
+        if (result.size() == 1)
+        {
+            Query q(result.begin()->first, m_stallTimeout);
+            q.handle = m_pool.acquire();
+            if (q.handle)
+            {
+                setup(q);
+                complete(q, curl_easy_perform(q.handle.get()));
+            }
+            return;
         }
-        std::streamsize size = ifs.tellg();
-        ifs.seekg(0, std::ios::beg);
 
-        buffer.resize(static_cast<size_t>(size));
-        if (!ifs.read(reinterpret_cast<char*>(buffer.data()), size))
+        CURLM *multi = curl_multi_init();
+        if (!multi)
         {
-            buffer.clear();
-            return false;
+            Logger::getInstance().error("[IPFSPinner] curl_multi_init failed.");
+            return;
         }
-        return true;
+        curl_multi_setopt(multi, CURLMOPT_MAX_HOST_CONNECTIONS, static_cast<long>(m_maxParallel));
+
+        std::vector<std::unique_ptr<Query>> queries;
+        queries.reserve(result.size());
+        for (const auto &entry : result)
+        {
+            queries.push_back(std::make_unique<Query>(entry.first, m_stallTimeout));
+        }
+
+        size_t next = 0;
+        size_t running = 0;
+        auto startNext = [&]() {
+            while (next < queries.size() && running < m_maxParallel)
+            {
+                Query &q = *queries[next++];
+                q.handle = m_pool.acquire();
+                if (!q.handle)
+                {
+                    continue; // stays Unknown
+                }
+                setup(q);
+                curl_multi_add_handle(multi, q.handle.get());
+                ++running;
+            }
+        };
+
+        startNext();
+        while (running > 0)
+        {
+            int active = 0;
+            if (curl_multi_perform(multi, &active) != CURLM_OK)
+            {
+                break;
+            }
+            int queued = 0;
+            while (CURLMsg *msg = curl_multi_info_read(multi, &queued))
+            {
+                if (msg->msg != CURLMSG_DONE)
+                {
+                    continue;
+                }
+                Query *q = nullptr;
+                curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, &q);
+                complete(*q, msg->data.result);
+                curl_multi_remove_handle(multi, msg->easy_handle);
+                q->handle = util::CurlHandlePool::Handle(); // back to the pool
+                --running;
+            }
+            startNext();
+            if (running > 0)
+            {
+                curl_multi_poll(multi, nullptr, 0, 1000, nullptr);
+            }
+        }
+
+        for (auto &q : queries)
+        {
+            if (q->handle)
+            {
+                curl_multi_remove_handle(multi, q->handle.get());
+            }
+        }
+        curl_multi_cleanup(multi);
+    }
+
+    // -------------------------------------------------------------------------
+    // Large batches: a single streaming listing of every pin, one {"Cid":..,"Type":..}
+    // object per line. Like the per-CID pin/ls it is not filtered by type, so a CID
+    // pinned directly or indirectly (inside a recursive pin) counts as pinned as well.
+    // -------------------------------------------------------------------------
+    void listPins(std::unordered_map<std::string, PinStatus> &result)
+    {
+        using namespace rxrevoltchain::util::logger;
+
+        util::CurlHandlePool::Handle handle = m_pool.acquire();
+        if (!handle)
+        {
+            return;
+        }
+        CURL *curl = handle.get();
+
+        size_t listed = 0;
+        util::JsonStreamParser parser([&](util::JsonValue &&v) {
+            ++listed;
+            const util::JsonValue *cid = v.find("Cid");
+            if (cid && cid->isString())
+            {
+                auto it = result.find(cid->asString());
+                if (it != result.end())
+                {
+                    it->second = PinStatus::Pinned;
+                }
+            }
+        });
+
+        std::string url = m_endpoint + "/api/v0/pin/ls?stream=true";
+        util::CurlHandlePool::StallWatch watch(m_stallTimeout);
+        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+        util::CurlHandlePool::applyStallTimeouts(curl, m_connectTimeout, watch);
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, jsonWriteCallback);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &parser);
+        curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
+
+        CURLcode res = curl_easy_perform(curl);
+        if (res != CURLE_OK || !parser.finish())
+        {
+            Logger::getInstance().error("[IPFSPinner] Pin listing failed: " +
+                                        (res != CURLE_OK ? std::string(curl_easy_strerror(res))
+                                                         : parser.error()));
+            for (auto &entry : result)
+            {
+                entry.second = PinStatus::Unknown;
+            }
+            return;
+        }
+
+        // The listing is complete, so anything not in it is not pinned
+        for (auto &entry : result)
+        {
+            if (entry.second != PinStatus::Pinned)
+            {
+                entry.second = PinStatus::NotPinned;
+            }
+        }
+        Logger::getInstance().info("[IPFSPinner] Checked " + std::to_string(result.size()) +
+                                   " CIDs against " + std::to_string(listed) + " listed pins.");
     }
 
     // -------------------------------------------------------------------------
@@ -195,14 +561,15 @@ private:
     bool multipartPost(const std::string &url,
                        const std::string &fieldName,
                        const std::string &filename,
-                       const std::vector<uint8_t> &fileData,
+                       UploadSource &source,
                        std::string &responseOut)
     {
-        CURL *curl = curl_easy_init();
-        if (!curl)
+        util::CurlHandlePool::Handle handle = m_pool.acquire();
+        if (!handle)
         {
             return false;
         }
+        CURL *curl = handle.get();
 
         struct curl_slist *headers = nullptr;
         headers = curl_slist_append(headers, "Expect:"); // disable Expect: 100-continue
@@ -213,26 +580,23 @@ private:
         curl_mimepart *field = curl_mime_addpart(form);
         curl_mime_name(field, fieldName.c_str());
         curl_mime_filename(field, filename.c_str());
-        curl_mime_data(field, reinterpret_cast<const char*>(fileData.data()), fileData.size());
+        curl_mime_data_cb(field, static_cast<curl_off_t>(source.size),
+                          readCallback, seekCallback, nullptr, &source);
 
         // Set the request
-        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+        util::CurlHandlePool::StallWatch watch(m_stallTimeout);
+        prepareHandle(curl, url, responseOut, watch);
         curl_easy_setopt(curl, CURLOPT_MIMEPOST, form);
         curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-        // Timeout or other options as desired
-        curl_easy_setopt(curl, CURLOPT_TIMEOUT, 60L);
-
-        // Capture response
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCallback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &responseOut);
 
         // Perform request
         CURLcode res = curl_easy_perform(curl);
 
-        // Clean up
+        // Clean up; the handle itself goes back to the pool with its connection.
+        // Options point at 'form' and 'headers', so reset it before freeing them.
+        curl_easy_reset(curl);
         curl_mime_free(form);
         curl_slist_free_all(headers);
-        curl_easy_cleanup(curl);
 
         if (res != CURLE_OK)
         {
@@ -249,17 +613,15 @@ private:
     // -------------------------------------------------------------------------
     bool httpGet(const std::string &url, std::string &responseOut)
     {
-        CURL *curl = curl_easy_init();
-        if (!curl) return false;
+        util::CurlHandlePool::Handle handle = m_pool.acquire();
+        if (!handle) return false;
+        CURL *curl = handle.get();
 
-        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-        curl_easy_setopt(curl, CURLOPT_TIMEOUT, 30L);
+        util::CurlHandlePool::StallWatch watch(m_stallTimeout);
+        prepareHandle(curl, url, responseOut, watch);
         curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCallback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &responseOut);
 
         CURLcode res = curl_easy_perform(curl);
-        curl_easy_cleanup(curl);
 
         if (res != CURLE_OK)
         {
@@ -309,6 +671,11 @@ private:
 
 private:
     std::string m_endpoint; // e.g. "http://127.0.0.1:5001"
+    util::CurlHandlePool &m_pool;
+    long m_connectTimeout = 10;
+    long m_stallTimeout = 60;
+    size_t m_maxParallel = 8;
+    size_t m_listThreshold = 64;
 };
 
 } // namespace ipfs_integration
@@ -1,12 +1,19 @@
 #ifndef RXREVOLTCHAIN_MERKLE_PROOF_HPP
 #define RXREVOLTCHAIN_MERKLE_PROOF_HPP
 
+#include "chunk_reader.hpp"
 #include "hashing.hpp"
 #include "logger.hpp"
+#include "read_ahead.hpp"
+#include "thread_pool.hpp"
 #include <algorithm>
+#include <array>
 #include <cmath>
 #include <cstdint>
+#include <cstring>
 #include <fstream>
+#include <functional>
+#include <map>
 #include <mutex>
 #include <stdexcept>
 #include <string>
@@ -34,10 +41,10 @@ namespace ipfs_integration {
    - Serializes this info into 'proofData', which can be transmitted or stored.
    - 'VerifyProof' re-creates the chunk hash(es), merges them up the tree with sibling hashes,
      and confirms the final computed root matches the root found in 'proofData'.
-   - This demonstration uses a simplistic format to store proof data. For a production system,
-     you may want a more compact or standardized approach (e.g., JSON or a bespoke binary format).
+   - Two tree/proof formats exist (see MerkleFormat). VerifyProof and ExtractRoot detect
+     the format from the proof itself.
 
-   Format of proofData (naive binary layout):
+   Format of proofData, v1 / MerkleFormat::LegacyHex (naive binary layout):
      1) 4 bytes: chunkSize (uint32_t)
      2) 4 bytes: totalChunks (uint32_t)
      3) 4 bytes: numberOfOffsets (uint32_t)
@@ -51,34 +58,130 @@ namespace ipfs_integration {
                siblingHashSize bytes: the sibling hash (hex string of SHA-256, 64 hex chars)
      5) 4 bytes: rootHashSize (uint32_t)
      6) rootHashSize bytes: the merkle root hash (hex string of SHA-256, 64 hex chars)
+     Parent nodes are SHA-256 over the two children's 64-char hex strings, back to back.
+
+   Format of proofData, v2 / MerkleFormat::Binary:
+     1) 4 bytes: magic "RXM2" (far above any plausible v1 chunkSize)
+     2) 4 bytes: chunkSize (uint32_t)
+     3) 4 bytes: totalChunks (uint32_t)
+     4) 4 bytes: numberOfOffsets (uint32_t)
+     5) For each offset:
+          - 4 bytes: offsetIndex (uint32_t)
+          - 4 bytes: chunkDataLength (uint32_t)
+          - chunkDataLength bytes: the actual chunk data
+          - 4 bytes: pathLength (number of sibling hashes, uint32_t)
+          - pathLength * 32 bytes: the raw SHA-256 sibling digests
+     6) 32 bytes: the raw merkle root digest
+     Parent nodes are SHA-256 over the 64 raw bytes of both children.
+
+   In both formats a leaf is SHA-256(chunk) and a node without a sibling (odd count at a
+   level) is promoted unchanged. All integers are big-endian.
+
+   Format of proofData, v3 / multi-proof (GenerateMultiProof), for a tree in either format:
+     1) 4 bytes: magic "RXM3"
+     2) 4 bytes: tree format (MerkleFormat value; decides how parents are hashed)
+     3) 4 bytes: chunkSize (uint32_t)
+     4) 4 bytes: totalChunks (uint32_t)
+     5) 4 bytes: numberOfOffsets (uint32_t)
+     6) For each offset, in strictly ascending order:
+          - 4 bytes: offsetIndex (uint32_t)
+          - 4 bytes: chunkDataLength (uint32_t)
+          - chunkDataLength bytes: the actual chunk data
+     7) 4 bytes: numberOfNodes (uint32_t)
+     8) numberOfNodes * 32 bytes: raw digests of every node the proven leaves cannot derive
+        themselves, each sent once, in the order a level-by-level bottom-up pass needs them
+     9) 32 bytes: the raw merkle root digest
+     Siblings shared by several offsets (all upper levels, typically) are not repeated, and
+     no digest is hex encoded, so a v3 proof for k offsets is much smaller than k v1 paths.
 
    NOTE:
-   - For large files, building a full in-memory merkle tree can be expensive.
-     This example is for demonstration. Real usage might stream chunk data and build partial trees.
+   - The file is streamed in READ_WINDOW_CHUNKS-sized windows; only the leaf digests
+     (32 bytes per 4KB chunk) and the challenged chunks stay resident, so peak
+     memory no longer scales with the full snapshot size.
+   - Leaves of a window are hashed on util::ThreadPool::getInstance() while the next
+     window is read by one reader thread per file (util::ReadAhead), and large levels
+     are reduced in parallel. Every node is written to its own fixed slot, so the root
+     does not depend on scheduling or pool size.
    - The offsets refer to chunk indices, not byte offsets. If the file is chunked as 4KB per chunk,
      offset i means the i-th chunk.
    - For actual PoP usage, you'd typically not store the entire chunk data in the proof,
      but possibly only a random portion. This is up to your design.
 
    DEPENDENCIES:
-   - Uses rxrevoltchain::util::Hashing for SHA-256.
-   - Reads file into memory for chunking (if large files, consider streaming).
+   - Uses rxrevoltchain::util::hashing raw digests (sha256Raw / sha256Batch); tree nodes
+     are never held as hex strings.
+   - Streams the file for chunking; it is never loaded into memory as a whole.
+   - Proofs over a pre-built tree read the challenged chunks through
+     ChunkReader::getInstance(), which maps each snapshot once for all callers.
 
    THREAD-SAFETY:
    - Each call is self-contained, so minimal concurrency concerns.
      A global or static mutex is used only if needed.
+   - Calls may run concurrently; they share the process-wide thread pool.
 */
 
+/** Raw SHA-256 digest of a merkle node. */
+using MerkleDigest = std::array<uint8_t, 32>;
+
+/** How parent nodes are derived, and which proof layout is produced. */
+enum class MerkleFormat : uint32_t {
+    LegacyHex = 1, ///< v1: parents hash the hex text of the children
+    Binary = 2     ///< v2: parents hash the raw 32-byte children
+};
+
+/*
+  MerkleTree
+  --------------------------------
+  Every level of a snapshot's merkle tree, as built by MerkleProof::BuildTree.
+  All node digests live in one contiguous buffer ('nodes', 32 bytes per node), level by
+  level starting with the leaves. levelOffsets[l] is the index of the first node of level
+  l and levelOffsets.back() is the total node count. The last level holds the root.
+*/
+struct MerkleTree {
+    MerkleFormat format = MerkleFormat::LegacyHex;
+    size_t chunkSize = 4096;
+    uint64_t fileSize = 0;
+    std::vector<uint8_t> nodes;
+    std::vector<uint64_t> levelOffsets;
+    std::string root; // lowercase hex of the root digest
+
+    size_t LeafCount() const { return levelOffsets.size() < 2 ? 0 : LevelSize(0); }
+    size_t LevelCount() const { return levelOffsets.empty() ? 0 : levelOffsets.size() - 1; }
+    size_t LevelSize(size_t level) const {
+        return static_cast<size_t>(levelOffsets[level + 1] - levelOffsets[level]);
+    }
+    const uint8_t* Node(size_t level, size_t index) const {
+        return nodes.data() + (levelOffsets[level] + index) * 32;
+    }
+    const uint8_t* RootDigest() const {
+        return levelOffsets.size() < 2 ? nullptr : Node(LevelCount() - 1, 0);
+    }
+};
+
 class MerkleProof {
   public:
+    // Size of a merkle leaf in bytes
+    static constexpr size_t DEFAULT_CHUNK_SIZE = 4096;
+    // Number of chunks read from disk per window while streaming a file
+    static constexpr size_t READ_WINDOW_CHUNKS = 256;
+    // Leaves hashed per thread-pool block
+    static constexpr size_t LEAF_GRAIN = 16;
+    // Parents computed per thread-pool block; smaller levels are reduced inline
+    static constexpr size_t PARENT_GRAIN = 1024;
+    // Leading bytes of a v2 proof
+    static constexpr uint32_t V2_MAGIC = 0x52584D32; // "RXM2"
+    // Leading bytes of a v3 multi-proof
+    static constexpr uint32_t V3_MAGIC = 0x52584D33; // "RXM3"
+
     // Default constructor
     MerkleProof() {}
 
     /*
       GenerateProof
       --------------------------------
-      1) Reads the entire file from 'filePath' into memory.
-      2) Splits it into 4KB chunks (or final chunk partial).
+      1) Streams the file from 'filePath' in fixed-size read windows.
+      2) Hashes each 4KB chunk (or final chunk partial) as it is read; only the
+         chunks named in 'offsets' are copied and kept.
       3) Builds a merkle tree of chunk hashes.
       4) For each offset in 'offsets', stores:
           - The chunk data itself,
@@ -87,92 +190,152 @@ class MerkleProof {
       6) Returns a std::vector<uint8_t> containing the serialized proof.
 
       If an offset is out of range (>= total chunks), we skip it or ignore it gracefully.
+      The default stays v1 (LegacyHex) so existing peers can verify the result.
     */
     std::vector<uint8_t> GenerateProof(const std::string& filePath,
-                                       const std::vector<size_t>& offsets) {
+                                       const std::vector<size_t>& offsets,
+                                       MerkleFormat format = MerkleFormat::LegacyHex) {
         using namespace rxrevoltchain::util::logger;
-        Logger::getInstance().info("[MerkleProof] Generating proof for file: " + filePath);
+        Logger::getInstance().info(
+            [&] { return "[MerkleProof] Generating proof for file: " + filePath; });
 
-        std::vector<uint8_t> fileData;
-        if (!readFile(filePath, fileData)) {
+        // Stream the file in fixed windows, hashing each 4KB leaf as it is read and
+        // keeping only the bytes of challenged chunks.
+        MerkleTree tree;
+        tree.format = format;
+        std::map<size_t, std::vector<uint8_t>> challenged;
+        for (auto off : offsets) {
+            challenged.emplace(off, std::vector<uint8_t>());
+        }
+        if (!streamLeaves(filePath, tree, challenged)) {
             Logger::getInstance().error("[MerkleProof] Failed to read file.");
             return {};
         }
 
-        // Chunk the file into 4KB blocks
-        const size_t CHUNK_SIZE = 4096;
-        std::vector<std::vector<uint8_t>> chunks;
-        chunkFile(fileData, CHUNK_SIZE, chunks);
-
         // Build the merkle tree for these chunk hashes
-        std::vector<std::string> leaves;
-        leaves.reserve(chunks.size());
-        for (auto& ch : chunks) {
-            // compute the hash of the chunk
-            std::string h = rxrevoltchain::util::hashing::sha256(ch);
-            leaves.push_back(h);
-        }
+        buildMerkleTree(tree);
 
-        std::string merkleRoot;
-        std::vector<std::vector<std::string>> treeLevels;
-        buildMerkleTree(leaves, treeLevels, merkleRoot);
+        return serializeProof(tree, offsets, challenged);
+    }
 
-        // Begin serialization of proofData
-        std::vector<uint8_t> proofData;
-        // 1) chunkSize
-        writeUint32(proofData, static_cast<uint32_t>(CHUNK_SIZE));
-        // 2) totalChunks
-        writeUint32(proofData, static_cast<uint32_t>(chunks.size()));
-        // 3) numberOfOffsets
-        uint32_t validOffsets = 0;
+    /*
+      GenerateProof (pre-built tree)
+      --------------------------------
+      Same output as above in the tree's own format, but takes the merkle tree of
+      'filePath' from the caller (e.g. from MerkleTreeCache). Only the challenged chunks are
+      read from disk, so the cost is O(k) chunk reads plus O(k log n) path lookups instead
+      of a full-file hash.
+    */
+    std::vector<uint8_t> GenerateProof(const std::string& filePath,
+                                       const std::vector<size_t>& offsets,
+                                       const MerkleTree& tree) {
+        using namespace rxrevoltchain::util::logger;
+        Logger::getInstance().info([&] {
+            return "[MerkleProof] Generating proof from cached tree for file: " + filePath;
+        });
+
+        std::map<size_t, std::vector<uint8_t>> challenged;
         for (auto off : offsets) {
-            if (off < chunks.size()) {
-                validOffsets++;
+            if (off < tree.LeafCount()) {
+                challenged.emplace(off, std::vector<uint8_t>());
             }
         }
-        writeUint32(proofData, validOffsets);
+        if (!readChunks(filePath, tree.chunkSize, challenged)) {
+            Logger::getInstance().error("[MerkleProof] Failed to read challenged chunks.");
+            return {};
+        }
 
-        // For each offset, store the chunk data + merkle path
+        return serializeProof(tree, offsets, challenged);
+    }
+
+    /*
+      GenerateMultiProof
+      --------------------------------
+      Builds a v3 multi-proof for 'offsets' over the caller's tree ('tree.format' decides
+      the parent hashing, so a LegacyHex tree yields the same root as a v1 proof). Offsets
+      may be given in any order; duplicates and out-of-range offsets are dropped. Only the
+      challenged chunks are read from disk.
+    */
+    std::vector<uint8_t> GenerateMultiProof(const std::string& filePath,
+                                            const std::vector<size_t>& offsets,
+                                            const MerkleTree& tree) {
+        using namespace rxrevoltchain::util::logger;
+        std::map<size_t, std::vector<uint8_t>> challenged;
         for (auto off : offsets) {
-            if (off >= chunks.size()) {
-                continue; // skip invalid
+            if (off < tree.LeafCount()) {
+                challenged.emplace(off, std::vector<uint8_t>());
             }
+        }
+        if (!readChunks(filePath, tree.chunkSize, challenged)) {
+            Logger::getInstance().error("[MerkleProof] Failed to read challenged chunks.");
+            return {};
+        }
+        return serializeMultiProof(tree, challenged);
+    }
 
-            // offsetIndex
-            writeUint32(proofData, static_cast<uint32_t>(off));
-
-            // chunkDataLength + chunkData
-            const auto& chunkData = chunks[off];
-            writeUint32(proofData, static_cast<uint32_t>(chunkData.size()));
-            proofData.insert(proofData.end(), chunkData.begin(), chunkData.end());
-
-            // Get the path for this chunk from the merkle tree
-            std::vector<std::string> path = getMerklePath(treeLevels, off);
-
-            // pathLength
-            writeUint32(proofData, static_cast<uint32_t>(path.size()));
-            for (auto& siblingHash : path) {
-                // Each sibling hash is 64 hex characters for SHA256
-                writeUint32(proofData, static_cast<uint32_t>(siblingHash.size()));
-                proofData.insert(proofData.end(), siblingHash.begin(), siblingHash.end());
-            }
+    /*
+      GenerateMultiProof (streaming)
+      --------------------------------
+      Same as above, hashing 'filePath' into a tree of the given format first.
+    */
+    std::vector<uint8_t> GenerateMultiProof(const std::string& filePath,
+                                            const std::vector<size_t>& offsets,
+                                            MerkleFormat format = MerkleFormat::LegacyHex) {
+        using namespace rxrevoltchain::util::logger;
+        MerkleTree tree;
+        tree.format = format;
+        std::map<size_t, std::vector<uint8_t>> challenged;
+        for (auto off : offsets) {
+            challenged.emplace(off, std::vector<uint8_t>());
+        }
+        if (!streamLeaves(filePath, tree, challenged)) {
+            Logger::getInstance().error("[MerkleProof] Failed to read file.");
+            return {};
         }
+        buildMerkleTree(tree);
+        for (auto it = challenged.begin(); it != challenged.end();) {
+            it = it->first < tree.LeafCount() ? std::next(it) : challenged.erase(it);
+        }
+        return serializeMultiProof(tree, challenged);
+    }
 
-        // Finally, store the root
-        // rootHashSize + rootHash
-        writeUint32(proofData, static_cast<uint32_t>(merkleRoot.size()));
-        proofData.insert(proofData.end(), merkleRoot.begin(), merkleRoot.end());
+    /*
+      BuildTree
+      --------------------------------
+      Streams 'filePath' and fills 'tree' with every level of the merkle tree in the
+      requested format, without keeping any chunk data. Returns false if the file cannot
+      be read.
+    */
+    bool BuildTree(const std::string& filePath, MerkleTree& tree,
+                   MerkleFormat format = MerkleFormat::LegacyHex) {
+        std::map<size_t, std::vector<uint8_t>> none;
+        tree = MerkleTree();
+        tree.format = format;
+        if (!streamLeaves(filePath, tree, none)) {
+            return false;
+        }
+        buildMerkleTree(tree);
+        return true;
+    }
 
-        Logger::getInstance().info("[MerkleProof] Proof generated successfully. Root: " +
-                                   merkleRoot);
-        return proofData;
+    /*
+      BuildTreeFromLeaves
+      --------------------------------
+      Builds the upper levels over leaf digests received from elsewhere (e.g. a snapshot
+      sync manifest). 'tree.nodes' must hold exactly the leaves, 32 bytes each, and
+      'tree.format' the format they were announced in; tree.root is set on return.
+    */
+    void BuildTreeFromLeaves(MerkleTree& tree) {
+        tree.nodes.resize(tree.nodes.size() / 32 * 32);
+        buildMerkleTree(tree);
     }
 
     /*
       VerifyProof
       --------------------------------
-      1) Parses the proofData for chunk size, total chunks, offsets, chunk data, sibling paths, and
-      root. 2) For each offset block:
+      1) Parses the proofData (v1 or v2) for chunk size, total chunks, offsets, chunk data,
+         sibling paths, and root.
+      2) For each offset block:
          - Recompute the chunk's SHA-256,
          - Climb up the merkle path with sibling hashes,
          - Arrive at a computed root.
@@ -183,6 +346,352 @@ class MerkleProof {
         using namespace rxrevoltchain::util::logger;
         Logger::getInstance().info("[MerkleProof] Verifying proof...");
 
+        if (isMultiProof(proofData)) {
+            return verifyMultiProof(proofData);
+        }
+
+        ParsedProof proof;
+        if (!parseProof(proofData, proof)) {
+            return false;
+        }
+        const bool legacy = (proof.format == MerkleFormat::LegacyHex);
+
+        // Now let's verify each offset's chunk data up to the root
+        for (auto& op : proof.offsets) {
+            // 1) compute hash of chunk data
+            MerkleDigest current;
+            rxrevoltchain::util::hashing::sha256Raw(op.chunkData, op.chunkLength, current.data());
+
+            // 2) climb up with sibling hashes. Level sizes are derived from totalChunks so
+            //    that an odd node promoted without a sibling still moves up one level.
+            if (op.offsetIndex >= proof.totalChunks) {
+                return false;
+            }
+            uint32_t idx = op.offsetIndex;
+            uint64_t levelSize = proof.totalChunks;
+            size_t pathPos = 0;
+
+            while (levelSize > 1) {
+                bool hasSibling = (idx % 2 == 1) || (idx + 1 < levelSize);
+                if (hasSibling) {
+                    if (pathPos >= op.path.size()) {
+                        return false;
+                    }
+                    const MerkleDigest& sib = op.path[pathPos++];
+                    // If idx is odd => sibling is to the left, we combine(siblingHash + currentHash)
+                    // If idx is even => sibling is to the right, combine(currentHash + siblingHash)
+                    if (idx % 2 == 1) {
+                        combineNodes(sib.data(), current.data(), current.data(), legacy);
+                    } else {
+                        combineNodes(current.data(), sib.data(), current.data(), legacy);
+                    }
+                }
+                // idx = idx / 2 to go up one level
+                idx >>= 1;
+                levelSize = (levelSize + 1) / 2;
+            }
+            if (pathPos != op.path.size()) {
+                return false;
+            }
+
+            if (current != proof.root) {
+                Logger::getInstance().warn(
+                    "[MerkleProof] Mismatch at offset " + std::to_string(op.offsetIndex) +
+                    ", computed root: " + toHex(current.data()) +
+                    " vs. stored root: " + toHex(proof.root.data()));
+                return false;
+            }
+        }
+
+        // If we pass all checks, it's good
+        Logger::getInstance().info([&] {
+            return "[MerkleProof] Proof verified successfully. Root: " + toHex(proof.root.data());
+        });
+        return true;
+    }
+
+    /*
+      ExtractRoot
+      --------------------------------
+      Returns the merkle root stored in a v1 or v2 proof as lowercase hex, and optionally
+      the proof's format. Returns an empty string if the proof cannot be parsed.
+    */
+    static std::string ExtractRoot(const std::vector<uint8_t>& proofData,
+                                   MerkleFormat* formatOut = nullptr) {
+        if (isMultiProof(proofData)) {
+            ParsedMultiProof multi;
+            if (!parseMultiProof(proofData, multi)) {
+                return {};
+            }
+            if (formatOut) {
+                *formatOut = multi.format;
+            }
+            return toHex(multi.root.data());
+        }
+        ParsedProof proof;
+        if (!parseProof(proofData, proof) || !proof.hasRoot) {
+            return {};
+        }
+        if (formatOut) {
+            *formatOut = proof.format;
+        }
+        return toHex(proof.root.data());
+    }
+
+    /*
+      ExtractOffsets
+      --------------------------------
+      Stores the leaf indices a v1, v2 or v3 proof covers in 'out', in proof order, so a
+      verifier can check that they are the ones it challenged. Returns false if the proof
+      cannot be parsed.
+    */
+    static bool ExtractOffsets(const std::vector<uint8_t>& proofData, std::vector<size_t>& out) {
+        out.clear();
+        if (isMultiProof(proofData)) {
+            ParsedMultiProof multi;
+            if (!parseMultiProof(proofData, multi)) {
+                return false;
+            }
+            for (const auto& leaf : multi.leaves) {
+                out.push_back(leaf.offsetIndex);
+            }
+            return true;
+        }
+        ParsedProof proof;
+        if (!parseProof(proofData, proof)) {
+            return false;
+        }
+        for (const auto& op : proof.offsets) {
+            out.push_back(op.offsetIndex);
+        }
+        return true;
+    }
+
+    /** Lowercase hex encoding of a 32-byte digest. */
+    static std::string toHex(const uint8_t* digest) {
+        return rxrevoltchain::util::hashing::toHex(digest, 32);
+    }
+
+    /** Decodes a 64-char hex digest into 32 bytes. Returns false on malformed input. */
+    static bool fromHex(const uint8_t* hex, size_t len, uint8_t* digest) {
+        if (len != 64) {
+            return false;
+        }
+        auto value = [](uint8_t c) -> int {
+            if (c >= '0' && c <= '9')
+                return c - '0';
+            if (c >= 'a' && c <= 'f')
+                return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F')
+                return c - 'A' + 10;
+            return -1;
+        };
+        for (size_t i = 0; i < 32; ++i) {
+            int hi = value(hex[2 * i]);
+            int lo = value(hex[2 * i + 1]);
+            if (hi < 0 || lo < 0) {
+                return false;
+            }
+            digest[i] = static_cast<uint8_t>((hi << 4) | lo);
+        }
+        return true;
+    }
+
+    /*
+      combineNodes:
+      - Computes the parent digest of (left, right) into 'out', which may alias either input.
+      - v1 hashes the two 64-char hex strings back to back, v2 hashes the 64 raw bytes.
+    */
+    static void combineNodes(const uint8_t* left, const uint8_t* right, uint8_t* out,
+                             bool legacy) {
+        uint8_t text[128];
+        if (legacy) {
+            hexPair(left, right, text);
+            rxrevoltchain::util::hashing::sha256Raw(text, 128, out);
+        } else {
+            std::memcpy(text, left, 32);
+            std::memcpy(text + 32, right, 32);
+            rxrevoltchain::util::hashing::sha256Raw(text, 64, out);
+        }
+    }
+
+    /** Writes the 128-byte v1 parent preimage: hex(left) followed by hex(right). */
+    static void hexPair(const uint8_t* left, const uint8_t* right, uint8_t* text) {
+        static const char digits[] = "0123456789abcdef";
+        for (size_t i = 0; i < 32; ++i) {
+            text[2 * i] = digits[left[i] >> 4];
+            text[2 * i + 1] = digits[left[i] & 0x0F];
+            text[64 + 2 * i] = digits[right[i] >> 4];
+            text[64 + 2 * i + 1] = digits[right[i] & 0x0F];
+        }
+    }
+
+  private:
+    // One challenged offset inside a parsed proof; chunk bytes point into the proof buffer
+    struct OffsetProof {
+        uint32_t offsetIndex = 0;
+        const uint8_t* chunkData = nullptr;
+        size_t chunkLength = 0;
+        std::vector<MerkleDigest> path; // sibling hashes
+    };
+
+    struct ParsedProof {
+        MerkleFormat format = MerkleFormat::LegacyHex;
+        uint32_t chunkSize = 0;
+        uint32_t totalChunks = 0;
+        std::vector<OffsetProof> offsets;
+        MerkleDigest root{};
+        bool hasRoot = false;
+    };
+
+    // A parsed v3 multi-proof; chunk bytes and node digests point into the proof buffer
+    struct ParsedMultiProof {
+        MerkleFormat format = MerkleFormat::LegacyHex;
+        uint32_t chunkSize = 0;
+        uint32_t totalChunks = 0;
+        std::vector<OffsetProof> leaves; // path unused; ascending offsetIndex
+        const uint8_t* nodes = nullptr;
+        size_t nodeCount = 0;
+        MerkleDigest root{};
+    };
+
+    static uint32_t peekU32(const std::vector<uint8_t>& buf, size_t pos) {
+        return (static_cast<uint32_t>(buf[pos]) << 24) |
+               (static_cast<uint32_t>(buf[pos + 1]) << 16) |
+               (static_cast<uint32_t>(buf[pos + 2]) << 8) | static_cast<uint32_t>(buf[pos + 3]);
+    }
+
+    static bool isMultiProof(const std::vector<uint8_t>& proofData) {
+        return proofData.size() >= 4 && peekU32(proofData, 0) == V3_MAGIC;
+    }
+
+    /*
+      parseMultiProof:
+      - Decodes the v3 layout. Offsets must be strictly ascending and inside the tree, and
+        the buffer must end right after the root.
+    */
+    static bool parseMultiProof(const std::vector<uint8_t>& proofData, ParsedMultiProof& out) {
+        size_t pos = 4;
+        auto readU32 = [&](uint32_t& val) -> bool {
+            if (pos + 4 > proofData.size())
+                return false;
+            val = peekU32(proofData, pos);
+            pos += 4;
+            return true;
+        };
+        uint32_t format = 0;
+        uint32_t numOffsets = 0;
+        if (!readU32(format) || !readU32(out.chunkSize) || !readU32(out.totalChunks) ||
+            !readU32(numOffsets)) {
+            return false;
+        }
+        if (format != static_cast<uint32_t>(MerkleFormat::LegacyHex) &&
+            format != static_cast<uint32_t>(MerkleFormat::Binary)) {
+            return false;
+        }
+        out.format = static_cast<MerkleFormat>(format);
+        if (numOffsets == 0 || numOffsets > proofData.size() / 8) {
+            return false;
+        }
+        out.leaves.resize(numOffsets);
+        for (uint32_t i = 0; i < numOffsets; ++i) {
+            OffsetProof& leaf = out.leaves[i];
+            uint32_t len = 0;
+            if (!readU32(leaf.offsetIndex) || !readU32(len) || pos + len > proofData.size()) {
+                return false;
+            }
+            if (leaf.offsetIndex >= out.totalChunks ||
+                (i > 0 && leaf.offsetIndex <= out.leaves[i - 1].offsetIndex)) {
+                return false;
+            }
+            leaf.chunkData = proofData.data() + pos;
+            leaf.chunkLength = len;
+            pos += len;
+        }
+        uint32_t numNodes = 0;
+        if (!readU32(numNodes) || numNodes > (proofData.size() - pos) / 32) {
+            return false;
+        }
+        out.nodes = proofData.data() + pos;
+        out.nodeCount = numNodes;
+        pos += size_t(numNodes) * 32;
+        if (pos + 32 != proofData.size()) {
+            return false;
+        }
+        std::memcpy(out.root.data(), proofData.data() + pos, 32);
+        return true;
+    }
+
+    /*
+      verifyMultiProof:
+      - Hashes the proven chunks, then climbs all of them together one level at a time.
+        At each level a known node is paired with its known right neighbour, or with the
+        next digest from the proof, or promoted when it is the odd last node. The proof is
+        valid only if this consumes every digest exactly and ends in the stored root.
+    */
+    static bool verifyMultiProof(const std::vector<uint8_t>& proofData) {
+        using namespace rxrevoltchain::util::logger;
+        ParsedMultiProof proof;
+        if (!parseMultiProof(proofData, proof)) {
+            return false;
+        }
+        const bool legacy = (proof.format == MerkleFormat::LegacyHex);
+
+        std::vector<std::pair<uint64_t, MerkleDigest>> level(proof.leaves.size());
+        for (size_t i = 0; i < proof.leaves.size(); ++i) {
+            level[i].first = proof.leaves[i].offsetIndex;
+            rxrevoltchain::util::hashing::sha256Raw(proof.leaves[i].chunkData,
+                                                    proof.leaves[i].chunkLength,
+                                                    level[i].second.data());
+        }
+
+        size_t used = 0;
+        uint64_t levelSize = proof.totalChunks;
+        std::vector<std::pair<uint64_t, MerkleDigest>> parents;
+        while (levelSize > 1) {
+            parents.clear();
+            for (size_t k = 0; k < level.size(); ++k) {
+                const uint64_t idx = level[k].first;
+                MerkleDigest parent = level[k].second;
+                if (idx % 2 == 0 && k + 1 < level.size() && level[k + 1].first == idx + 1) {
+                    combineNodes(parent.data(), level[++k].second.data(), parent.data(), legacy);
+                } else if (idx % 2 == 0 && idx + 1 >= levelSize) {
+                    // odd one out, promoted unchanged
+                } else {
+                    if (used == proof.nodeCount) {
+                        return false;
+                    }
+                    const uint8_t* sibling = proof.nodes + 32 * used++;
+                    if (idx % 2 == 0) {
+                        combineNodes(parent.data(), sibling, parent.data(), legacy);
+                    } else {
+                        combineNodes(sibling, parent.data(), parent.data(), legacy);
+                    }
+                }
+                parents.emplace_back(idx / 2, parent);
+            }
+            level.swap(parents);
+            levelSize = (levelSize + 1) / 2;
+        }
+
+        if (used != proof.nodeCount || level.size() != 1 || level[0].second != proof.root) {
+            Logger::getInstance().warn("[MerkleProof] Multi-proof does not reach its root.");
+            return false;
+        }
+        Logger::getInstance().info([&] {
+            return "[MerkleProof] Multi-proof verified for " +
+                   std::to_string(proof.leaves.size()) + " offsets. Root: " +
+                   toHex(proof.root.data());
+        });
+        return true;
+    }
+
+    /*
+      parseProof:
+      - Decodes a v1 or v2 proof into 'out'. v1 hex sibling/root hashes are decoded to raw
+        digests; a v1 proof with an empty root (empty file) parses with hasRoot = false.
+    */
+    static bool parseProof(const std::vector<uint8_t>& proofData, ParsedProof& out) {
         size_t readPos = 0;
         auto readU32 = [&](uint32_t& val) -> bool {
             if (readPos + 4 > proofData.size())
@@ -194,37 +703,43 @@ class MerkleProof {
             readPos += 4;
             return true;
         };
+        auto readDigest = [&](MerkleDigest& d) -> bool {
+            if (readPos + 32 > proofData.size())
+                return false;
+            std::memcpy(d.data(), &proofData[readPos], 32);
+            readPos += 32;
+            return true;
+        };
 
-        // 1) chunkSize
-        uint32_t chunkSize = 0;
-        if (!readU32(chunkSize)) {
+        // 1) chunkSize, or the v2 magic followed by chunkSize
+        uint32_t first = 0;
+        if (!readU32(first)) {
             return false;
         }
-
-        // 2) totalChunks
-        uint32_t totalChunks = 0;
-        if (!readU32(totalChunks)) {
-            return false;
+        if (first == V2_MAGIC) {
+            out.format = MerkleFormat::Binary;
+            if (!readU32(out.chunkSize)) {
+                return false;
+            }
+        } else {
+            out.format = MerkleFormat::LegacyHex;
+            out.chunkSize = first;
         }
+        const bool legacy = (out.format == MerkleFormat::LegacyHex);
 
-        // 3) numberOfOffsets
+        // 2) totalChunks, 3) numberOfOffsets
         uint32_t numOffsets = 0;
-        if (!readU32(numOffsets)) {
+        if (!readU32(out.totalChunks) || !readU32(numOffsets)) {
             return false;
         }
-
-        // We'll accumulate a list of "offset proofs"
-        struct OffsetProof {
-            uint32_t offsetIndex;
-            std::vector<uint8_t> chunkData;
-            std::vector<std::string> path; // sibling hashes
-        };
-
-        std::vector<OffsetProof> offsetProofs;
-        offsetProofs.reserve(numOffsets);
+        // Every offset block needs at least 12 bytes; reject absurd counts up front
+        if (numOffsets > proofData.size() / 12) {
+            return false;
+        }
+        out.offsets.reserve(numOffsets);
 
         for (uint32_t i = 0; i < numOffsets; i++) {
-            OffsetProof op{0, {}, {}};
+            OffsetProof op;
 
             // offsetIndex
             if (!readU32(op.offsetIndex)) {
@@ -239,16 +754,23 @@ class MerkleProof {
             if (readPos + cdl > proofData.size()) {
                 return false;
             }
-            op.chunkData.insert(op.chunkData.end(), proofData.begin() + readPos,
-                                proofData.begin() + readPos + cdl);
+            op.chunkData = proofData.data() + readPos;
+            op.chunkLength = cdl;
             readPos += cdl;
 
-            // pathLength
+            // pathLength (a 32-bit leaf index never needs more than 32 siblings)
             uint32_t pathLen = 0;
-            if (!readU32(pathLen)) {
+            if (!readU32(pathLen) || pathLen > 64) {
                 return false;
             }
+            op.path.resize(pathLen);
             for (uint32_t p = 0; p < pathLen; p++) {
+                if (!legacy) {
+                    if (!readDigest(op.path[p])) {
+                        return false;
+                    }
+                    continue;
+                }
                 uint32_t hashSize = 0;
                 if (!readU32(hashSize)) {
                     return false;
@@ -256,17 +778,21 @@ class MerkleProof {
                 if (readPos + hashSize > proofData.size()) {
                     return false;
                 }
-
                 // Sibling hash is ASCII hex
-                std::string sibling((const char*)&proofData[readPos], hashSize);
+                if (!fromHex(&proofData[readPos], hashSize, op.path[p].data())) {
+                    return false;
+                }
                 readPos += hashSize;
-                op.path.push_back(sibling);
             }
 
-            offsetProofs.push_back(std::move(op));
+            out.offsets.push_back(std::move(op));
         }
 
-        // Finally read the root
+        // Finally read the root. If there's leftover data, we ignore it.
+        if (!legacy) {
+            out.hasRoot = readDigest(out.root);
+            return out.hasRoot;
+        }
         uint32_t rootHashSize = 0;
         if (!readU32(rootHashSize)) {
             return false;
@@ -274,160 +800,316 @@ class MerkleProof {
         if (readPos + rootHashSize > proofData.size()) {
             return false;
         }
-        std::string merkleRoot((const char*)&proofData[readPos], rootHashSize);
-        readPos += rootHashSize;
+        if (rootHashSize == 0) {
+            // Empty file: no root, and nothing that could be verified against one
+            return out.offsets.empty();
+        }
+        if (!fromHex(&proofData[readPos], rootHashSize, out.root.data())) {
+            return false;
+        }
+        out.hasRoot = true;
+        return true;
+    }
 
-        // If there's leftover data, we ignore it or declare invalid
-        // (here we just ignore if it's extra)
-        // Now let's verify each offset's chunk data up to the root
-        for (auto& op : offsetProofs) {
-            // 1) compute hash of chunk data
-            std::string chunkHash = rxrevoltchain::util::hashing::sha256(op.chunkData);
+    /*
+      streamLeaves:
+      - Reads the file in windows of READ_WINDOW_CHUNKS * chunkSize bytes and appends the
+        raw SHA-256 of every chunk (last chunk may be smaller) to tree.nodes.
+      - The chunks of a window are hashed across the thread pool while a util::ReadAhead
+        (one thread for the whole file) fills the second window buffer.
+      - For every chunk index present as a key in 'challenged', stores a copy of that
+        chunk's bytes. All other chunk data is discarded once hashed, so peak memory is
+        one read window plus the leaf digests.
+    */
+    bool streamLeaves(const std::string& filePath, MerkleTree& tree,
+                      std::map<size_t, std::vector<uint8_t>>& challenged) {
+        std::ifstream ifs(filePath, std::ios::binary);
+        if (!ifs.is_open()) {
+            return false;
+        }
+        const size_t chunkSize = tree.chunkSize;
+        tree.fileSize = 0;
+        tree.nodes.clear();
 
-            // 2) climb up with sibling hashes
-            uint32_t idx = op.offsetIndex;
-            std::string currentHash = chunkHash;
-
-            for (auto& sib : op.path) {
-                bool isLeftSibling = (idx % 2 == 1);
-                // If idx is odd => sibling is to the left, we combine(siblingHash + currentHash)
-                // If idx is even => sibling is to the right, combine(currentHash + siblingHash)
-                // Then idx = idx / 2 to go up one level
-                if (isLeftSibling) {
-                    // siblingHash + currentHash
-                    std::vector<uint8_t> combined;
-                    combined.reserve(sib.size() + currentHash.size());
-                    combined.insert(combined.end(), sib.begin(), sib.end());
-                    combined.insert(combined.end(), currentHash.begin(), currentHash.end());
-                    currentHash = rxrevoltchain::util::hashing::sha256(combined);
-                } else {
-                    // currentHash + siblingHash
-                    std::vector<uint8_t> combined;
-                    combined.reserve(currentHash.size() + sib.size());
-                    combined.insert(combined.end(), currentHash.begin(), currentHash.end());
-                    combined.insert(combined.end(), sib.begin(), sib.end());
-                    currentHash = rxrevoltchain::util::hashing::sha256(combined);
+        // Double-buffered: the next window is read while the current one is hashed
+        std::vector<uint8_t> window;
+        rxrevoltchain::util::ReadAhead reader(ifs, chunkSize * READ_WINDOW_CHUNKS);
+        auto& pool = rxrevoltchain::util::ThreadPool::getInstance();
+        size_t firstChunk = 0;
+        size_t bytesRead = 0;
+        while ((bytesRead = reader.next(window)) > 0) {
+            tree.fileSize += bytesRead;
+
+            const size_t chunks = (bytesRead + chunkSize - 1) / chunkSize;
+            const size_t at = tree.nodes.size();
+            tree.nodes.resize(at + chunks * 32);
+            const uint8_t* in = window.data();
+            uint8_t* out = tree.nodes.data() + at;
+            pool.parallelFor(chunks, LEAF_GRAIN, [=](size_t begin, size_t end) {
+                // Only the last chunk of the file can be short; hash the full ones as a batch
+                size_t full = std::min(end, bytesRead / chunkSize);
+                if (full > begin) {
+                    rxrevoltchain::util::hashing::sha256Batch(in + begin * chunkSize, chunkSize,
+                                                              full - begin, out + begin * 32);
                 }
-                idx >>= 1;
-            }
+                for (size_t i = std::max(begin, full); i < end; ++i) {
+                    size_t pos = i * chunkSize;
+                    rxrevoltchain::util::hashing::sha256Raw(in + pos, bytesRead - pos,
+                                                            out + i * 32);
+                }
+            });
 
-            if (currentHash != merkleRoot) {
-                Logger::getInstance().warn(
-                    "[MerkleProof] Mismatch at offset " + std::to_string(op.offsetIndex) +
-                    ", computed root: " + currentHash + " vs. stored root: " + merkleRoot);
-                return false;
+            // Keep copies of the challenged chunks that fall into this window
+            for (auto it = challenged.lower_bound(firstChunk);
+                 it != challenged.end() && it->first < firstChunk + chunks; ++it) {
+                size_t pos = (it->first - firstChunk) * chunkSize;
+                size_t thisSize = std::min(chunkSize, bytesRead - pos);
+                it->second.assign(in + pos, in + pos + thisSize);
             }
+            firstChunk += chunks;
         }
+        return !reader.failed();
+    }
 
-        // If we pass all checks, it's good
-        Logger::getInstance().info("[MerkleProof] Proof verified successfully. Root: " +
-                                   merkleRoot);
-        return true;
+    /*
+      readChunks:
+      - Copies only the chunks whose indices are keys of 'chunks', out of the snapshot's
+        shared mapping (see ChunkReader).
+    */
+    bool readChunks(const std::string& filePath, size_t chunkSize,
+                    std::map<size_t, std::vector<uint8_t>>& chunks) {
+        return ChunkReader::getInstance().ReadChunks(filePath, chunkSize, chunks);
     }
 
-  private:
     /*
-      readFile:
-      - Reads entire file into memory
+      serializeProof:
+      - Writes the proof layout documented at the top of this file for 'offsets' in the
+        tree's format, taking sibling paths from 'tree' and chunk bytes from 'challenged'.
     */
-    bool readFile(const std::string& filePath, std::vector<uint8_t>& buffer) {
-        std::ifstream ifs(filePath, std::ios::binary | std::ios::ate);
-        if (!ifs.is_open()) {
-            return false;
+    std::vector<uint8_t> serializeProof(const MerkleTree& tree, const std::vector<size_t>& offsets,
+                                        std::map<size_t, std::vector<uint8_t>>& challenged) {
+        using namespace rxrevoltchain::util::logger;
+        const size_t totalChunks = tree.LeafCount();
+        const bool legacy = (tree.format == MerkleFormat::LegacyHex);
+
+        // Begin serialization of proofData
+        std::vector<uint8_t> proofData;
+        if (!legacy) {
+            writeUint32(proofData, V2_MAGIC);
+        }
+        // 1) chunkSize
+        writeUint32(proofData, static_cast<uint32_t>(tree.chunkSize));
+        // 2) totalChunks
+        writeUint32(proofData, static_cast<uint32_t>(totalChunks));
+        // 3) numberOfOffsets
+        uint32_t validOffsets = 0;
+        for (auto off : offsets) {
+            if (off < totalChunks) {
+                validOffsets++;
+            }
         }
-        std::streamsize size = ifs.tellg();
-        ifs.seekg(0, std::ios::beg);
+        writeUint32(proofData, validOffsets);
 
-        buffer.resize(static_cast<size_t>(size));
-        if (!ifs.read(reinterpret_cast<char*>(buffer.data()), size)) {
-            buffer.clear();
-            return false;
+        // For each offset, store the chunk data + merkle path
+        std::vector<const uint8_t*> path;
+        for (auto off : offsets) {
+            if (off >= totalChunks) {
+                continue; // skip invalid
+            }
+
+            // offsetIndex
+            writeUint32(proofData, static_cast<uint32_t>(off));
+
+            // chunkDataLength + chunkData
+            const auto& chunkData = challenged[off];
+            writeUint32(proofData, static_cast<uint32_t>(chunkData.size()));
+            proofData.insert(proofData.end(), chunkData.begin(), chunkData.end());
+
+            // Get the path for this chunk from the merkle tree
+            getMerklePath(tree, off, path);
+
+            // pathLength
+            writeUint32(proofData, static_cast<uint32_t>(path.size()));
+            for (const uint8_t* sibling : path) {
+                if (legacy) {
+                    // Each sibling hash is 64 hex characters for SHA256
+                    std::string hex = toHex(sibling);
+                    writeUint32(proofData, static_cast<uint32_t>(hex.size()));
+                    proofData.insert(proofData.end(), hex.begin(), hex.end());
+                } else {
+                    proofData.insert(proofData.end(), sibling, sibling + 32);
+                }
+            }
         }
-        return true;
+
+        // Finally, store the root
+        if (legacy) {
+            // rootHashSize + rootHash
+            writeUint32(proofData, static_cast<uint32_t>(tree.root.size()));
+            proofData.insert(proofData.end(), tree.root.begin(), tree.root.end());
+        } else {
+            MerkleDigest empty{};
+            const uint8_t* root = tree.RootDigest() ? tree.RootDigest() : empty.data();
+            proofData.insert(proofData.end(), root, root + 32);
+        }
+
+        Logger::getInstance().info(
+            [&] { return "[MerkleProof] Proof generated successfully. Root: " + tree.root; });
+        return proofData;
     }
 
     /*
-      chunkFile:
-      - Splits fileData into chunks of chunkSize bytes, last chunk may be smaller
+      serializeMultiProof:
+      - Writes the v3 layout for the chunk indices in 'challenged' (already within the
+        tree), emitting sibling digests in the order verifyMultiProof consumes them.
     */
-    void chunkFile(const std::vector<uint8_t>& fileData, size_t chunkSize,
-                   std::vector<std::vector<uint8_t>>& chunks) {
-        size_t totalSize = fileData.size();
-        size_t offset = 0;
-        while (offset < totalSize) {
-            size_t thisSize = std::min(chunkSize, totalSize - offset);
-            std::vector<uint8_t> chunk(fileData.begin() + offset,
-                                       fileData.begin() + offset + thisSize);
-            chunks.push_back(std::move(chunk));
-            offset += thisSize;
+    std::vector<uint8_t>
+    serializeMultiProof(const MerkleTree& tree,
+                        const std::map<size_t, std::vector<uint8_t>>& challenged) {
+        using namespace rxrevoltchain::util::logger;
+        std::vector<uint8_t> proofData;
+        if (challenged.empty() || !tree.RootDigest()) {
+            Logger::getInstance().error("[MerkleProof] Multi-proof needs at least one chunk.");
+            return proofData;
+        }
+        writeUint32(proofData, V3_MAGIC);
+        writeUint32(proofData, static_cast<uint32_t>(tree.format));
+        writeUint32(proofData, static_cast<uint32_t>(tree.chunkSize));
+        writeUint32(proofData, static_cast<uint32_t>(tree.LeafCount()));
+        writeUint32(proofData, static_cast<uint32_t>(challenged.size()));
+        std::vector<uint64_t> level;
+        for (const auto& entry : challenged) {
+            writeUint32(proofData, static_cast<uint32_t>(entry.first));
+            writeUint32(proofData, static_cast<uint32_t>(entry.second.size()));
+            proofData.insert(proofData.end(), entry.second.begin(), entry.second.end());
+            level.push_back(entry.first);
+        }
+
+        // Same walk as verifyMultiProof, recording the digests it will ask for
+        const size_t countPos = proofData.size();
+        writeUint32(proofData, 0);
+        uint32_t nodeCount = 0;
+        std::vector<uint64_t> parents;
+        for (size_t l = 0; l + 1 < tree.LevelCount(); ++l) {
+            const uint64_t levelSize = tree.LevelSize(l);
+            parents.clear();
+            for (size_t k = 0; k < level.size(); ++k) {
+                const uint64_t idx = level[k];
+                if (idx % 2 == 0 && k + 1 < level.size() && level[k + 1] == idx + 1) {
+                    ++k;
+                } else if (!(idx % 2 == 0 && idx + 1 >= levelSize)) {
+                    const uint8_t* sibling = tree.Node(l, idx ^ 1);
+                    proofData.insert(proofData.end(), sibling, sibling + 32);
+                    ++nodeCount;
+                }
+                parents.push_back(idx / 2);
+            }
+            level.swap(parents);
         }
+        for (int b = 0; b < 4; ++b) {
+            proofData[countPos + b] = static_cast<uint8_t>(nodeCount >> (24 - 8 * b));
+        }
+
+        const uint8_t* root = tree.RootDigest();
+        proofData.insert(proofData.end(), root, root + 32);
+        Logger::getInstance().info([&] {
+            return "[MerkleProof] Multi-proof generated for " + std::to_string(challenged.size()) +
+                   " offsets with " + std::to_string(nodeCount) + " nodes. Root: " + tree.root;
+        });
+        return proofData;
     }
 
     /*
       buildMerkleTree:
-      - Builds the merkle tree from a list of leaf hashes (hex-encoded).
-      - treeLevels[0] will be the list of leaves,
-      - treeLevels[1] the next level up, etc.,
-      - The final level has a single element: the root.
-      - merkleRoot is that single element in the final level.
+      - Builds the upper levels of the merkle tree on top of the leaf digests already in
+        tree.nodes, appending each parent level to the same flat buffer.
+      - Pairs are combined per tree.format; an odd node at the end of a level is promoted.
+      - Levels wider than PARENT_GRAIN parents are split across the thread pool.
+      - tree.root is set to the hex of the single node in the final level.
     */
-    void buildMerkleTree(const std::vector<std::string>& leaves,
-                         std::vector<std::vector<std::string>>& treeLevels,
-                         std::string& merkleRoot) {
-        treeLevels.clear();
-        if (leaves.empty()) {
-            merkleRoot.clear();
+    void buildMerkleTree(MerkleTree& tree) {
+        tree.levelOffsets.clear();
+        const uint64_t leafCount = tree.nodes.size() / 32;
+        if (leafCount == 0) {
+            tree.root.clear();
             return;
         }
+        const bool legacy = (tree.format == MerkleFormat::LegacyHex);
+
+        // A tree over n leaves has fewer than 2n nodes; reserve once so the buffer never moves
+        tree.nodes.reserve(static_cast<size_t>(2 * leafCount * 32));
+        tree.levelOffsets.push_back(0);
+        tree.levelOffsets.push_back(leafCount);
 
-        // The bottom level is the leaves
-        treeLevels.push_back(leaves);
         // While the last level has more than 1 node, compute the parent level
-        while (treeLevels.back().size() > 1) {
-            const auto& currentLevel = treeLevels.back();
-            std::vector<std::string> parentLevel;
-            for (size_t i = 0; i < currentLevel.size(); i += 2) {
-                if (i + 1 < currentLevel.size()) {
-                    // combine currentLevel[i] + currentLevel[i+1]
-                    std::vector<uint8_t> combined;
-                    combined.insert(combined.end(), currentLevel[i].begin(), currentLevel[i].end());
-                    combined.insert(combined.end(), currentLevel[i + 1].begin(),
-                                    currentLevel[i + 1].end());
-                    parentLevel.push_back(rxrevoltchain::util::hashing::sha256(combined));
-                } else {
+        while (tree.LevelSize(tree.LevelCount() - 1) > 1) {
+            const size_t level = tree.LevelCount() - 1;
+            const size_t count = tree.LevelSize(level);
+            const size_t parentCount = (count + 1) / 2;
+            const size_t parentStart = tree.nodes.size();
+            tree.nodes.resize(parentStart + parentCount * 32);
+
+            const uint8_t* child = tree.Node(level, 0);
+            uint8_t* parent = tree.nodes.data() + parentStart;
+            auto reduce = [=](size_t begin, size_t end) {
+                // Parents [begin, full) have two children and are hashed as one batch
+                size_t full = std::min(end, count / 2);
+                if (full > begin) {
+                    const size_t pairs = full - begin;
+                    if (legacy) {
+                        std::vector<uint8_t> text(pairs * 128);
+                        for (size_t p = 0; p < pairs; ++p) {
+                            const uint8_t* l = child + (begin + p) * 64;
+                            hexPair(l, l + 32, text.data() + p * 128);
+                        }
+                        rxrevoltchain::util::hashing::sha256Batch(text.data(), 128, pairs,
+                                                                  parent + begin * 32);
+                    } else {
+                        // Children of consecutive parents are adjacent 64-byte messages
+                        rxrevoltchain::util::hashing::sha256Batch(child + begin * 64, 64, pairs,
+                                                                  parent + begin * 32);
+                    }
+                }
+                if (end > full && full * 2 < count) {
                     // odd one out, just push it
-                    parentLevel.push_back(currentLevel[i]);
+                    std::memcpy(parent + full * 32, child + full * 64, 32);
                 }
+            };
+            if (parentCount > PARENT_GRAIN) {
+                rxrevoltchain::util::ThreadPool::getInstance().parallelFor(parentCount,
+                                                                           PARENT_GRAIN, reduce);
+            } else {
+                reduce(0, parentCount);
             }
-            treeLevels.push_back(std::move(parentLevel));
+            tree.levelOffsets.push_back(tree.levelOffsets.back() + parentCount);
         }
 
         // The root is the single element in the final level
-        merkleRoot = treeLevels.back()[0];
+        tree.root = toHex(tree.RootDigest());
     }
 
     /*
       getMerklePath:
-      - Given the treeLevels and a leaf index, collects the sibling hashes on the path to the root.
+      - Given the tree and a leaf index, collects pointers to the sibling digests on the
+        path to the root.
       - For example, if the leaf is at index i in level 0, we look at i ^ 1 to get the sibling,
         store that hash, then i >>= 1 to go up one level, etc.
       - We skip the actual node's hash, only store siblings' for the path.
       - The final level is the root, with no sibling if it's alone.
     */
-    std::vector<std::string> getMerklePath(const std::vector<std::vector<std::string>>& treeLevels,
-                                           size_t leafIndex) {
-        std::vector<std::string> path;
+    void getMerklePath(const MerkleTree& tree, size_t leafIndex,
+                       std::vector<const uint8_t*>& path) const {
+        path.clear();
         // We walk from level 0 up to top
         size_t idx = leafIndex;
-        for (size_t level = 0; level < treeLevels.size() - 1; level++) {
+        for (size_t level = 0; level + 1 < tree.LevelCount(); level++) {
             // sibling index is either idx+1 or idx-1 if idx is odd
             size_t sibling = (idx % 2 == 0) ? (idx + 1) : (idx - 1);
-            if (sibling < treeLevels[level].size()) {
-                path.push_back(treeLevels[level][sibling]);
+            if (sibling < tree.LevelSize(level)) {
+                path.push_back(tree.Node(level, sibling));
             }
             idx >>= 1; // move to the parent index
         }
-        return path;
     }
 
     /*
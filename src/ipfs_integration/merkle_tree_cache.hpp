@@ -0,0 +1,441 @@
+#ifndef RXREVOLTCHAIN_MERKLE_TREE_CACHE_HPP
+#define RXREVOLTCHAIN_MERKLE_TREE_CACHE_HPP
+
+#include "logger.hpp"
+#include "merkle_proof.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unistd.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace rxrevoltchain {
+namespace ipfs_integration {
+
+/*
+  MerkleTreeCache
+  --------------------------------
+  Keeps the merkle tree of a pinned snapshot so PoP challenges and POP_REQUEST answers
+  do not rehash the whole file. The tree changes only when the snapshot changes (once per
+  DailyScheduler merge cycle), so it is built once and then reused.
+
+  "Fully functional" approach:
+   - The tree is persisted next to the snapshot as '<filePath>.merkle'
+     (e.g. data.sqlite -> data.sqlite.merkle) and also kept in memory per file path and
+     format. The sidecar holds the most recently built format.
+   - One instance is meant to be shared by everything that needs a snapshot's tree
+     (DailySnapshot, PoPConsensus, SnapshotSync; see their SetTreeCache), so a file is
+     hashed once per change rather than once per user.
+   - Each cached tree is keyed by the snapshot's CID plus a file fingerprint (size and
+     modification time) and its MerkleFormat. A different CID or format, or a file that
+     changed on disk, invalidates the entry and triggers a rebuild.
+   - CIDs must match exactly; an empty CID only matches a tree cached without one. Trees
+     built before the pin returned a CID (GetOrBuildCurrent) get it through AdoptCid once
+     the pin completes, before PoP asks for them by CID.
+   - Once a tree is available, GenerateProof only reads the challenged chunks, so a
+     challenge costs O(k log n) path lookups instead of a full-file hash.
+
+  Sidecar format (all integers big-endian):
+     1) 4 bytes: magic "RXMT"
+     2) 4 bytes: cache version (uint32_t, currently 2; older sidecars are rebuilt)
+     3) 4 bytes: tree format (uint32_t, MerkleFormat)
+     4) 4 bytes: chunkSize (uint32_t)
+     5) 8 bytes: fileSize (uint64_t)
+     6) 8 bytes: file modification time (int64_t, nanoseconds since epoch)
+     7) 4 bytes: cidLength (uint32_t) followed by the CID bytes
+     8) 4 bytes: levelCount (uint32_t), then 4 bytes node count (uint32_t) per level
+     9) The flat node buffer of the tree: 32 raw bytes per node, leaves first.
+
+  THREAD-SAFETY:
+   - All public methods are thread-safe. Lookups and builds for one file path are
+     serialized by a per-path lock, so concurrent callers wait for a single build instead
+     of hashing the file again; other paths are not held up meanwhile.
+   - The sidecar is written to a temporary file with a name unique to the process and
+     call, then renamed, so writers in other instances or processes never interleave.
+*/
+
+class MerkleTreeCache {
+  public:
+    MerkleTreeCache() = default;
+
+    /** Path of the sidecar cache file for a snapshot. */
+    static std::string CachePathFor(const std::string& filePath) { return filePath + ".merkle"; }
+
+    /**
+     * Return the merkle tree for 'filePath', loading it from memory or the sidecar file
+     * if it is still valid for 'cid' and 'format', otherwise rebuilding and persisting it.
+     * @return nullptr if the snapshot cannot be read.
+     */
+    std::shared_ptr<const MerkleTree> GetOrBuild(const std::string& filePath,
+                                                 const std::string& cid,
+                                                 MerkleFormat format = MerkleFormat::LegacyHex) {
+        return lookup(filePath, &cid, format);
+    }
+
+    /**
+     * Return the tree of 'filePath' as it is on disk, whatever CID it is cached under; a
+     * tree built here has no CID until AdoptCid. For callers that do not know the CID
+     * (before the pin returns it, or serving the file to peers), never for PoP.
+     * @return nullptr if the snapshot cannot be read.
+     */
+    std::shared_ptr<const MerkleTree> GetOrBuildCurrent(
+        const std::string& filePath, MerkleFormat format = MerkleFormat::LegacyHex) {
+        return lookup(filePath, nullptr, format);
+    }
+
+    /**
+     * Record that 'filePath', as it is on disk now, was pinned as 'cid': the trees cached
+     * for it (every format, and the sidecar) are tagged with 'cid'. Call once the pin
+     * completes, before the file is challenged. Returns false if no tree was cached.
+     */
+    bool AdoptCid(const std::string& filePath, const std::string& cid) {
+        const std::shared_ptr<std::mutex> pathLock = lockFor(filePath);
+        std::lock_guard<std::mutex> building(*pathLock);
+
+        Fingerprint fp;
+        if (cid.empty() || !fingerprintFile(filePath, fp)) {
+            return false;
+        }
+        bool adopted = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (auto format : {MerkleFormat::LegacyHex, MerkleFormat::Binary}) {
+                auto it = m_entries.find(Key(filePath, format));
+                if (it != m_entries.end() && it->second.fp == fp) {
+                    it->second.cid = cid;
+                    adopted = true;
+                }
+            }
+        }
+        for (auto format : {MerkleFormat::LegacyHex, MerkleFormat::Binary}) {
+            Entry entry;
+            if (loadSidecar(filePath, fp, nullptr, format, entry)) {
+                if (entry.cid != cid) {
+                    entry.cid = cid;
+                    writeSidecar(filePath, entry);
+                }
+                adopted = true;
+                break; // the sidecar holds a single format
+            }
+        }
+        return adopted;
+    }
+
+    /**
+     * Build a proof for 'offsets' of 'filePath' using the cached tree.
+     * @return Serialized proof in 'format', or an empty vector on failure.
+     */
+    std::vector<uint8_t> GenerateProof(const std::string& filePath, const std::string& cid,
+                                       const std::vector<size_t>& offsets,
+                                       MerkleFormat format = MerkleFormat::LegacyHex) {
+        auto tree = GetOrBuild(filePath, cid, format);
+        if (!tree) {
+            return {};
+        }
+        MerkleProof mp;
+        return mp.GenerateProof(filePath, offsets, *tree);
+    }
+
+    /**
+     * Build a v3 multi-proof for 'offsets' of 'filePath' using the cached tree.
+     * @return Serialized multi-proof over a 'format' tree, or an empty vector on failure.
+     */
+    std::vector<uint8_t> GenerateMultiProof(const std::string& filePath, const std::string& cid,
+                                            const std::vector<size_t>& offsets,
+                                            MerkleFormat format = MerkleFormat::LegacyHex) {
+        auto tree = GetOrBuild(filePath, cid, format);
+        if (!tree) {
+            return {};
+        }
+        MerkleProof mp;
+        return mp.GenerateMultiProof(filePath, offsets, *tree);
+    }
+
+    /** Drop the cached tree for 'filePath' from memory and disk. */
+    void Invalidate(const std::string& filePath) {
+        const std::shared_ptr<std::mutex> pathLock = lockFor(filePath);
+        std::lock_guard<std::mutex> building(*pathLock);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (auto format : {MerkleFormat::LegacyHex, MerkleFormat::Binary}) {
+                m_entries.erase(Key(filePath, format));
+            }
+        }
+        std::remove(CachePathFor(filePath).c_str());
+    }
+
+  private:
+    static constexpr uint32_t CACHE_VERSION = 2;
+
+    using Key = std::pair<std::string, MerkleFormat>;
+
+    struct Fingerprint {
+        uint64_t size = 0;
+        int64_t mtimeNs = 0;
+
+        bool operator==(const Fingerprint& o) const {
+            return size == o.size && mtimeNs == o.mtimeNs;
+        }
+    };
+
+    struct Entry {
+        Fingerprint fp;
+        std::string cid;
+        std::shared_ptr<const MerkleTree> tree;
+    };
+
+    // 'requested' null: any CID (GetOrBuildCurrent). Otherwise the CIDs must be equal, so
+    // a tree cached without a CID never answers for a pinned one.
+    static bool cidMatches(const std::string& stored, const std::string* requested) {
+        return !requested || stored == *requested;
+    }
+
+    // GetOrBuild / GetOrBuildCurrent ('cid' null)
+    std::shared_ptr<const MerkleTree> lookup(const std::string& filePath, const std::string* cid,
+                                             MerkleFormat format) {
+        using namespace rxrevoltchain::util::logger;
+        const std::shared_ptr<std::mutex> pathLock = lockFor(filePath);
+        std::lock_guard<std::mutex> building(*pathLock);
+
+        Fingerprint fp;
+        if (!fingerprintFile(filePath, fp)) {
+            Logger::getInstance().error("[MerkleTreeCache] Cannot stat snapshot: " + filePath);
+            return nullptr;
+        }
+
+        const Key key(filePath, format);
+        Entry entry;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_entries.find(key);
+            if (it != m_entries.end() && it->second.fp == fp && cidMatches(it->second.cid, cid)) {
+                return it->second.tree;
+            }
+        }
+
+        if (loadSidecar(filePath, fp, cid, format, entry)) {
+            Logger::getInstance().info("[MerkleTreeCache] Loaded cached tree for " + filePath +
+                                       " (root " + entry.tree->root + ")");
+            store(key, entry);
+            return entry.tree;
+        }
+
+        Logger::getInstance().info("[MerkleTreeCache] Building merkle tree for " + filePath);
+        auto tree = std::make_shared<MerkleTree>();
+        MerkleProof mp;
+        if (!mp.BuildTree(filePath, *tree, format)) {
+            Logger::getInstance().error("[MerkleTreeCache] Failed to build tree for " + filePath);
+            return nullptr;
+        }
+
+        // The file may have changed while it was being hashed; only persist a tree that
+        // matches the fingerprint observed after the build.
+        Fingerprint after;
+        if (!fingerprintFile(filePath, after) || !(after == fp) || after.size != tree->fileSize) {
+            Logger::getInstance().warn("[MerkleTreeCache] Snapshot changed during build: " +
+                                       filePath);
+            return tree;
+        }
+
+        entry.fp = fp;
+        entry.cid = cid ? *cid : std::string();
+        entry.tree = tree;
+        store(key, entry);
+        if (!writeSidecar(filePath, entry)) {
+            Logger::getInstance().warn("[MerkleTreeCache] Could not persist tree cache for " +
+                                       filePath);
+        }
+        return tree;
+    }
+
+    // Lock serializing builds and sidecar writes for one file path
+    std::shared_ptr<std::mutex> lockFor(const std::string& filePath) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::shared_ptr<std::mutex>& pathLock = m_pathLocks[filePath];
+        if (!pathLock) {
+            pathLock = std::make_shared<std::mutex>();
+        }
+        return pathLock;
+    }
+
+    void store(const Key& key, const Entry& entry) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_entries[key] = entry;
+    }
+
+    static bool fingerprintFile(const std::string& filePath, Fingerprint& fp) {
+        std::error_code ec;
+        fp.size = std::filesystem::file_size(filePath, ec);
+        if (ec) {
+            return false;
+        }
+        auto mtime = std::filesystem::last_write_time(filePath, ec);
+        if (ec) {
+            return false;
+        }
+        fp.mtimeNs =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(mtime.time_since_epoch()).count();
+        return true;
+    }
+
+    static void writeU32(std::ostream& out, uint32_t v) {
+        unsigned char b[4] = {static_cast<unsigned char>(v >> 24),
+                              static_cast<unsigned char>(v >> 16),
+                              static_cast<unsigned char>(v >> 8), static_cast<unsigned char>(v)};
+        out.write(reinterpret_cast<const char*>(b), 4);
+    }
+
+    static void writeU64(std::ostream& out, uint64_t v) {
+        writeU32(out, static_cast<uint32_t>(v >> 32));
+        writeU32(out, static_cast<uint32_t>(v));
+    }
+
+    static bool readU32(std::istream& in, uint32_t& v) {
+        unsigned char b[4];
+        if (!in.read(reinterpret_cast<char*>(b), 4)) {
+            return false;
+        }
+        v = (uint32_t(b[0]) << 24) | (uint32_t(b[1]) << 16) | (uint32_t(b[2]) << 8) |
+            uint32_t(b[3]);
+        return true;
+    }
+
+    static bool readU64(std::istream& in, uint64_t& v) {
+        uint32_t hi = 0, lo = 0;
+        if (!readU32(in, hi) || !readU32(in, lo)) {
+            return false;
+        }
+        v = (uint64_t(hi) << 32) | lo;
+        return true;
+    }
+
+    bool writeSidecar(const std::string& filePath, const Entry& entry) const {
+        static std::atomic<uint64_t> writes{0};
+        const std::string finalPath = CachePathFor(filePath);
+        const std::string tmpPath = finalPath + ".tmp." + std::to_string(::getpid()) + "." +
+                                    std::to_string(++writes);
+        {
+            std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+            if (!out.is_open()) {
+                return false;
+            }
+            out.write("RXMT", 4);
+            writeU32(out, CACHE_VERSION);
+            writeU32(out, static_cast<uint32_t>(entry.tree->format));
+            writeU32(out, static_cast<uint32_t>(entry.tree->chunkSize));
+            writeU64(out, entry.fp.size);
+            writeU64(out, static_cast<uint64_t>(entry.fp.mtimeNs));
+            writeU32(out, static_cast<uint32_t>(entry.cid.size()));
+            out.write(entry.cid.data(), static_cast<std::streamsize>(entry.cid.size()));
+            const MerkleTree& tree = *entry.tree;
+            writeU32(out, static_cast<uint32_t>(tree.LevelCount()));
+            for (size_t level = 0; level < tree.LevelCount(); ++level) {
+                writeU32(out, static_cast<uint32_t>(tree.LevelSize(level)));
+            }
+            out.write(reinterpret_cast<const char*>(tree.nodes.data()),
+                      static_cast<std::streamsize>(tree.nodes.size()));
+            out.close();
+            if (!out.good()) {
+                std::remove(tmpPath.c_str());
+                return false;
+            }
+        }
+        std::error_code ec;
+        std::filesystem::rename(tmpPath, finalPath, ec);
+        if (ec) {
+            std::remove(tmpPath.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    bool loadSidecar(const std::string& filePath, const Fingerprint& fp, const std::string* cid,
+                     MerkleFormat format, Entry& entry) const {
+        std::ifstream in(CachePathFor(filePath), std::ios::binary);
+        if (!in.is_open()) {
+            return false;
+        }
+
+        char magic[4];
+        uint32_t version = 0, storedFormat = 0, chunkSize = 0, cidLen = 0, levelCount = 0;
+        uint64_t size = 0, mtime = 0;
+        if (!in.read(magic, 4) || std::string(magic, 4) != "RXMT" || !readU32(in, version) ||
+            version != CACHE_VERSION || !readU32(in, storedFormat) ||
+            storedFormat != static_cast<uint32_t>(format) || !readU32(in, chunkSize) ||
+            chunkSize == 0 || !readU64(in, size) ||
+            !readU64(in, mtime) || !readU32(in, cidLen) || cidLen > 4096) {
+            return false;
+        }
+        std::string storedCid(cidLen, '\0');
+        if (cidLen && !in.read(&storedCid[0], cidLen)) {
+            return false;
+        }
+
+        if (size != fp.size || static_cast<int64_t>(mtime) != fp.mtimeNs) {
+            return false; // snapshot changed since the tree was cached
+        }
+        if (!cidMatches(storedCid, cid)) {
+            return false; // different pinned snapshot
+        }
+
+        if (!readU32(in, levelCount) || levelCount > 64) {
+            return false;
+        }
+        // Level sizes must describe a well-formed tree over the file's chunks
+        auto tree = std::make_shared<MerkleTree>();
+        tree->format = format;
+        tree->chunkSize = chunkSize;
+        tree->fileSize = size;
+        const uint64_t expectedLeaves = (size + chunkSize - 1) / chunkSize;
+        uint64_t expected = expectedLeaves;
+        tree->levelOffsets.push_back(0);
+        for (uint32_t level = 0; level < levelCount; ++level) {
+            uint32_t count = 0;
+            bool pastRoot = (level > 0 && expected == 1 && tree->LevelSize(level - 1) == 1);
+            if (!readU32(in, count) || count != expected || pastRoot) {
+                return false;
+            }
+            tree->levelOffsets.push_back(tree->levelOffsets.back() + count);
+            expected = (expected + 1) / 2;
+        }
+        bool complete = (levelCount == 0) ? (expectedLeaves == 0)
+                                          : (tree->LevelSize(levelCount - 1) == 1);
+        if (!complete) {
+            return false;
+        }
+        tree->nodes.resize(static_cast<size_t>(tree->levelOffsets.back() * 32));
+        if (!tree->nodes.empty() &&
+            !in.read(reinterpret_cast<char*>(tree->nodes.data()),
+                     static_cast<std::streamsize>(tree->nodes.size()))) {
+            return false;
+        }
+        if (levelCount == 0) {
+            tree->levelOffsets.clear();
+        } else {
+            tree->root = MerkleProof::toHex(tree->RootDigest());
+        }
+
+        entry.fp = fp;
+        entry.cid = storedCid;
+        entry.tree = tree;
+        return true;
+    }
+
+    mutable std::mutex m_mutex; // guards the two maps, never held while hashing
+    std::map<Key, Entry> m_entries;
+    std::unordered_map<std::string, std::shared_ptr<std::mutex>> m_pathLocks;
+};
+
+} // namespace ipfs_integration
+} // namespace rxrevoltchain
+
+#endif // RXREVOLTCHAIN_MERKLE_TREE_CACHE_HPP
@@ -0,0 +1,378 @@
+#ifndef RXREVOLTCHAIN_SNAPSHOT_DELTA_HPP
+#define RXREVOLTCHAIN_SNAPSHOT_DELTA_HPP
+
+#include "compression.hpp"
+#include "logger.hpp"
+#include "merkle_proof.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace rxrevoltchain {
+namespace ipfs_integration {
+
+/*
+  SnapshotDelta
+  --------------------------------
+  Describes a snapshot as the chunks that changed since the previously pinned one, so a
+  daily cycle uploads (and IPFS stores) data proportional to the churn instead of the
+  whole .sqlite file.
+
+  "Fully functional" approach:
+   - Uses the MerkleProof chunking (4KB, equal to SQLite's default page size). Two
+     snapshots are diffed by comparing their leaf digests, so only the new file is read,
+     and only its changed chunks.
+   - The pinned base is remembered as a BaseRecord ('<db>.delta_base'): its CID, merkle
+     root, size, leaf digests and how many deltas it is from a full snapshot. The base file
+     itself does not have to be kept.
+   - Apply() rebuilds the new file from a local copy of the base: it checks the base root,
+     copies it, writes the changed chunks, truncates/extends to the new size and checks
+     the result against the new root before replacing the output.
+   - A delta whose base is itself a delta names it by CID; a peer resolves the chain back to
+     a full snapshot and applies the deltas in order. 'depth' bounds that chain.
+
+  Delta format (all integers big-endian, strings as [u32 length][bytes]):
+     1) 4 bytes: magic "RXD1", 4 bytes: version (1)
+     2) 4 bytes: chunkSize, 4 bytes: codec (util::compression::Codec), 4 bytes: depth
+     3) string: baseCid, string: baseRoot, 8 bytes: baseSize
+     4) string: newRoot, 8 bytes: newSize
+     5) 4 bytes: changedCount, then changedCount * 4 bytes: ascending chunk indices
+     6) 8 bytes: raw length, then the changed chunks back to back, compressed with codec
+   Roots are LegacyHex merkle roots, the same roots PoP and snapshot sync use.
+*/
+
+class SnapshotDelta {
+  public:
+    static constexpr uint32_t MAGIC = 0x52584431; // "RXD1"
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint32_t BASE_MAGIC = 0x52584442; // "RXDB"
+
+    struct Header {
+        uint32_t chunkSize = 0;
+        uint32_t codec = 0;
+        uint32_t depth = 0; // deltas between this one and a full snapshot, this one included
+        std::string baseCid;
+        std::string baseRoot;
+        uint64_t baseSize = 0;
+        std::string newRoot;
+        uint64_t newSize = 0;
+        std::vector<uint32_t> changed;
+    };
+
+    // The last pinned snapshot, as needed to diff the next one against it
+    struct BaseRecord {
+        std::string cid;
+        uint32_t depth = 0; // 0 = full snapshot
+        MerkleTree tree;    // leaves only
+    };
+
+    /** Path of the base record kept next to a snapshot. */
+    static std::string BasePathFor(const std::string& dbPath) { return dbPath + ".delta_base"; }
+
+    /** Chunks whose leaf differs between 'base' and 'current' (including appended ones). */
+    static std::vector<uint32_t> ChangedChunks(const MerkleTree& base, const MerkleTree& current) {
+        std::vector<uint32_t> changed;
+        const size_t baseLeaves = base.LeafCount();
+        const size_t leaves = current.LeafCount();
+        for (size_t i = 0; i < leaves; ++i) {
+            if (i >= baseLeaves || std::memcmp(base.Node(0, i), current.Node(0, i), 32) != 0) {
+                changed.push_back(static_cast<uint32_t>(i));
+            }
+        }
+        return changed;
+    }
+
+    /**
+     * Build the delta turning 'base' into 'filePath' (whose tree is 'current').
+     * @return false if the geometry differs or the changed chunks cannot be read.
+     */
+    static bool Create(const BaseRecord& base, const MerkleTree& current,
+                       const std::string& filePath,
+                       const rxrevoltchain::util::compression::Options& compression,
+                       std::vector<uint8_t>& out) {
+        using namespace rxrevoltchain::util::compression;
+        if (base.tree.chunkSize != current.chunkSize || base.tree.format != current.format ||
+            current.format != MerkleFormat::LegacyHex) {
+            return false;
+        }
+        Header h;
+        h.chunkSize = static_cast<uint32_t>(current.chunkSize);
+        h.codec = static_cast<uint32_t>(compression.codec);
+        h.depth = base.depth + 1;
+        h.baseCid = base.cid;
+        h.baseRoot = base.tree.root;
+        h.baseSize = base.tree.fileSize;
+        h.newRoot = current.root;
+        h.newSize = current.fileSize;
+        h.changed = ChangedChunks(base.tree, current);
+
+        // Read the changed chunks in ascending order with one forward pass
+        std::ifstream in(filePath, std::ios::binary);
+        if (!in) {
+            return false;
+        }
+        std::vector<uint8_t> raw;
+        for (uint32_t idx : h.changed) {
+            const uint64_t offset = uint64_t(idx) * h.chunkSize;
+            const size_t len = static_cast<size_t>(std::min<uint64_t>(h.chunkSize,
+                                                                      h.newSize - offset));
+            const size_t have = raw.size();
+            raw.resize(have + len);
+            in.seekg(static_cast<std::streamoff>(offset));
+            if (!in.read(reinterpret_cast<char*>(raw.data() + have),
+                         static_cast<std::streamsize>(len))) {
+                return false;
+            }
+        }
+        Options opts = compression;
+        opts.dictionary.reset(); // deltas must decode without the snapshot's dictionary
+        std::vector<uint8_t> packed;
+        if (!compress(opts, raw.data(), raw.size(), packed)) {
+            return false;
+        }
+
+        out.clear();
+        writeU32(out, MAGIC);
+        writeU32(out, VERSION);
+        writeU32(out, h.chunkSize);
+        writeU32(out, h.codec);
+        writeU32(out, h.depth);
+        writeString(out, h.baseCid);
+        writeString(out, h.baseRoot);
+        writeU64(out, h.baseSize);
+        writeString(out, h.newRoot);
+        writeU64(out, h.newSize);
+        writeU32(out, static_cast<uint32_t>(h.changed.size()));
+        for (uint32_t idx : h.changed) {
+            writeU32(out, idx);
+        }
+        writeU64(out, raw.size());
+        out.insert(out.end(), packed.begin(), packed.end());
+        return true;
+    }
+
+    /** Parse the header of a delta; 'bodyOffset' receives the start of the chunk data. */
+    static bool ReadHeader(const std::vector<uint8_t>& delta, Header& h,
+                           size_t* bodyOffset = nullptr) {
+        size_t pos = 0;
+        uint32_t magic = 0, version = 0, count = 0;
+        if (!readU32(delta, pos, magic) || magic != MAGIC || !readU32(delta, pos, version) ||
+            version != VERSION || !readU32(delta, pos, h.chunkSize) || h.chunkSize == 0 ||
+            !readU32(delta, pos, h.codec) || !readU32(delta, pos, h.depth) ||
+            !readString(delta, pos, h.baseCid) || !readString(delta, pos, h.baseRoot) ||
+            !readU64(delta, pos, h.baseSize) || !readString(delta, pos, h.newRoot) ||
+            !readU64(delta, pos, h.newSize) || !readU32(delta, pos, count) ||
+            (delta.size() - pos) / 4 < count) {
+            return false;
+        }
+        const uint64_t chunks = (h.newSize + h.chunkSize - 1) / h.chunkSize;
+        h.changed.resize(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            readU32(delta, pos, h.changed[i]);
+            if (h.changed[i] >= chunks || (i > 0 && h.changed[i] <= h.changed[i - 1])) {
+                return false;
+            }
+        }
+        if (bodyOffset) {
+            *bodyOffset = pos;
+        }
+        return true;
+    }
+
+    /**
+     * Rebuild the new snapshot from 'basePath' (the delta's base) into 'outPath'.
+     * Both the base and the result are checked against the roots in the delta; on any
+     * mismatch 'outPath' is left untouched and false is returned.
+     */
+    static bool Apply(const std::string& basePath, const std::vector<uint8_t>& delta,
+                      const std::string& outPath) {
+        using namespace rxrevoltchain::util::logger;
+        using namespace rxrevoltchain::util::compression;
+        Header h;
+        size_t body = 0;
+        if (!ReadHeader(delta, h, &body)) {
+            Logger::getInstance().error("[SnapshotDelta] Malformed delta.");
+            return false;
+        }
+
+        MerkleProof mp;
+        MerkleTree baseTree;
+        if (!mp.BuildTree(basePath, baseTree) || baseTree.chunkSize != h.chunkSize ||
+            baseTree.root != h.baseRoot || baseTree.fileSize != h.baseSize) {
+            Logger::getInstance().error("[SnapshotDelta] " + basePath +
+                                        " is not the base of this delta (" + h.baseCid + ").");
+            return false;
+        }
+
+        // The chunk data is exactly the changed chunks (the file's last chunk may be short).
+        // Check the declared length before decompressing, so a hostile delta cannot make
+        // the decoder allocate more than that.
+        const uint64_t lastChunk = (h.newSize - 1) / h.chunkSize;
+        uint64_t expectedLen = uint64_t(h.changed.size()) * h.chunkSize;
+        if (!h.changed.empty() && h.changed.back() == lastChunk) {
+            expectedLen -= lastChunk * h.chunkSize + h.chunkSize - h.newSize;
+        }
+        uint64_t rawLen = 0;
+        std::vector<uint8_t> raw;
+        if (!readU64(delta, body, rawLen) || rawLen != expectedLen) {
+            Logger::getInstance().error("[SnapshotDelta] Delta chunk data length does not match "
+                                        "its changed chunks.");
+            return false;
+        }
+        if (!decompress(static_cast<Codec>(h.codec), delta.data() + body, delta.size() - body,
+                        raw, static_cast<size_t>(rawLen)) ||
+            raw.size() != rawLen) {
+            Logger::getInstance().error("[SnapshotDelta] Cannot decode delta chunk data.");
+            return false;
+        }
+
+        const std::string tmp = outPath + ".tmp";
+        std::error_code ec;
+        std::filesystem::copy_file(basePath, tmp, std::filesystem::copy_options::overwrite_existing,
+                                   ec);
+        if (ec) {
+            Logger::getInstance().error("[SnapshotDelta] Cannot copy base to " + tmp);
+            return false;
+        }
+        std::filesystem::resize_file(tmp, h.newSize, ec);
+        bool ok = !ec;
+        if (ok) {
+            std::fstream out(tmp, std::ios::binary | std::ios::in | std::ios::out);
+            size_t pos = 0;
+            for (uint32_t idx : h.changed) {
+                const uint64_t offset = uint64_t(idx) * h.chunkSize;
+                const size_t len = static_cast<size_t>(std::min<uint64_t>(h.chunkSize,
+                                                                          h.newSize - offset));
+                if (raw.size() - pos < len) {
+                    ok = false;
+                    break;
+                }
+                out.seekp(static_cast<std::streamoff>(offset));
+                out.write(reinterpret_cast<const char*>(raw.data() + pos),
+                          static_cast<std::streamsize>(len));
+                pos += len;
+            }
+            ok = ok && pos == raw.size() && static_cast<bool>(out.flush());
+        }
+
+        MerkleTree result;
+        if (!ok || !mp.BuildTree(tmp, result) || result.root != h.newRoot) {
+            Logger::getInstance().error("[SnapshotDelta] Rebuilt snapshot does not match root " +
+                                        h.newRoot);
+            std::remove(tmp.c_str());
+            return false;
+        }
+        if (std::rename(tmp.c_str(), outPath.c_str()) != 0) {
+            std::remove(tmp.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    /** Persist the base record (written through a temporary file). */
+    static bool SaveBase(const std::string& path, const BaseRecord& base) {
+        std::vector<uint8_t> out;
+        writeU32(out, BASE_MAGIC);
+        writeU32(out, VERSION);
+        writeString(out, base.cid);
+        writeU32(out, base.depth);
+        writeU32(out, static_cast<uint32_t>(base.tree.chunkSize));
+        writeU64(out, base.tree.fileSize);
+        writeString(out, base.tree.root);
+        const size_t leaves = base.tree.LeafCount();
+        writeU32(out, static_cast<uint32_t>(leaves));
+        if (leaves) {
+            out.insert(out.end(), base.tree.Node(0, 0), base.tree.Node(0, 0) + leaves * 32);
+        }
+        const std::string tmp = path + ".tmp";
+        {
+            std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char*>(out.data()),
+                       static_cast<std::streamsize>(out.size()));
+            if (!file) {
+                return false;
+            }
+        }
+        return std::rename(tmp.c_str(), path.c_str()) == 0;
+    }
+
+    /** Load a base record; false if missing or malformed. */
+    static bool LoadBase(const std::string& path, BaseRecord& base) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            return false;
+        }
+        std::vector<uint8_t> in((std::istreambuf_iterator<char>(file)),
+                                std::istreambuf_iterator<char>());
+        size_t pos = 0;
+        uint32_t magic = 0, version = 0, chunkSize = 0, leaves = 0;
+        base = BaseRecord();
+        if (!readU32(in, pos, magic) || magic != BASE_MAGIC || !readU32(in, pos, version) ||
+            version != VERSION || !readString(in, pos, base.cid) ||
+            !readU32(in, pos, base.depth) || !readU32(in, pos, chunkSize) || chunkSize == 0 ||
+            !readU64(in, pos, base.tree.fileSize) || !readString(in, pos, base.tree.root) ||
+            !readU32(in, pos, leaves) || in.size() - pos != size_t(leaves) * 32) {
+            return false;
+        }
+        base.tree.format = MerkleFormat::LegacyHex;
+        base.tree.chunkSize = chunkSize;
+        base.tree.nodes.assign(in.begin() + pos, in.end());
+        base.tree.levelOffsets = {0, leaves};
+        return true;
+    }
+
+  private:
+    static void writeU32(std::vector<uint8_t>& out, uint32_t v) {
+        for (int shift = 24; shift >= 0; shift -= 8) {
+            out.push_back(static_cast<uint8_t>(v >> shift));
+        }
+    }
+
+    static void writeU64(std::vector<uint8_t>& out, uint64_t v) {
+        writeU32(out, static_cast<uint32_t>(v >> 32));
+        writeU32(out, static_cast<uint32_t>(v));
+    }
+
+    static void writeString(std::vector<uint8_t>& out, const std::string& s) {
+        writeU32(out, static_cast<uint32_t>(s.size()));
+        out.insert(out.end(), s.begin(), s.end());
+    }
+
+    static bool readU32(const std::vector<uint8_t>& in, size_t& pos, uint32_t& v) {
+        if (in.size() - pos < 4) {
+            return false;
+        }
+        v = (uint32_t(in[pos]) << 24) | (uint32_t(in[pos + 1]) << 16) |
+            (uint32_t(in[pos + 2]) << 8) | uint32_t(in[pos + 3]);
+        pos += 4;
+        return true;
+    }
+
+    static bool readU64(const std::vector<uint8_t>& in, size_t& pos, uint64_t& v) {
+        uint32_t hi = 0, lo = 0;
+        if (!readU32(in, pos, hi) || !readU32(in, pos, lo)) {
+            return false;
+        }
+        v = (uint64_t(hi) << 32) | lo;
+        return true;
+    }
+
+    static bool readString(const std::vector<uint8_t>& in, size_t& pos, std::string& s) {
+        uint32_t len = 0;
+        if (!readU32(in, pos, len) || in.size() - pos < len) {
+            return false;
+        }
+        s.assign(reinterpret_cast<const char*>(in.data() + pos), len);
+        pos += len;
+        return true;
+    }
+};
+
+} // namespace ipfs_integration
+} // namespace rxrevoltchain
+
+#endif // RXREVOLTCHAIN_SNAPSHOT_DELTA_HPP
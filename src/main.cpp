@@ -33,6 +33,13 @@ int main(int argc, char** argv) {
     // Actually load the config file
     configParser.loadFromFile(configPath);
 
+    if (nodeConfig.logMode == "async") {
+        rxrevoltchain::util::logger::Logger::getInstance().enableAsync(
+            nodeConfig.logQueueCapacity, nodeConfig.logOverflowPolicy == "drop"
+                                             ? rxrevoltchain::util::logger::OverflowPolicy::Drop
+                                             : rxrevoltchain::util::logger::OverflowPolicy::Block);
+    }
+
     // 2. Instantiate the PinnerNode with parsed config
     rxrevoltchain::pinner::PinnerNode pinnerNode;
     if (!pinnerNode.InitializeNode(nodeConfig)) {
@@ -43,6 +50,8 @@ int main(int argc, char** argv) {
 
     // Start P2P networking using the configured port
     rxrevoltchain::network::P2PNode p2pNode;
+    p2pNode.SetIoThreads(nodeConfig.p2pIoThreads);
+    p2pNode.SetMaxConnections(nodeConfig.maxConnections);
     if (!p2pNode.StartNetwork("0.0.0.0", nodeConfig.p2pPort)) {
         rxrevoltchain::util::logger::Logger::getInstance().error(
             "[main] Failed to start P2PNode on port " + std::to_string(nodeConfig.p2pPort));
@@ -98,5 +107,6 @@ int main(int argc, char** argv) {
 
     rxrevoltchain::util::logger::Logger::getInstance().info(
         "[main] RxRevoltChain application exiting.");
+    rxrevoltchain::util::logger::Logger::getInstance().disableAsync();
     return 0;
 }
@@ -0,0 +1,207 @@
+#ifndef RXREVOLTCHAIN_EVENT_LOOP_HPP
+#define RXREVOLTCHAIN_EVENT_LOOP_HPP
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace rxrevoltchain {
+namespace network {
+
+/*
+  EventLoop
+  --------------------------------
+  One epoll instance served by one thread. P2PNode runs a small fixed number of these and
+  spreads its sockets across them, instead of dedicating a thread to every peer.
+
+   - Add()/Modify()/Remove() register file descriptors with a handler that is called on the
+     loop thread with the ready epoll events (level-triggered).
+   - Post() queues a task for the loop thread. An eventfd wakes the loop, so tasks run
+     promptly even while no socket is ready.
+   - Handlers are looked up per event, so a handler removed earlier in the same batch of
+     events is never called.
+   - Stop() runs on any thread except the loop thread and joins it. Registered descriptors
+     are not closed; they belong to the caller.
+*/
+
+class EventLoop {
+  public:
+    using Handler = std::function<void(uint32_t events)>;
+
+    EventLoop() = default;
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    ~EventLoop() { Stop(); }
+
+    bool Start() {
+        if (m_running.load()) {
+            return true;
+        }
+        m_epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+        m_wakeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (m_epollFd < 0 || m_wakeFd < 0) {
+            closeFds();
+            return false;
+        }
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = m_wakeFd;
+        if (::epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_wakeFd, &ev) < 0) {
+            closeFds();
+            return false;
+        }
+        m_running = true;
+        m_thread = std::thread(&EventLoop::run, this);
+        return true;
+    }
+
+    void Stop() {
+        if (!m_running.exchange(false)) {
+            return;
+        }
+        wake();
+        if (m_thread.joinable()) {
+            m_thread.join();
+        }
+        closeFds();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_handlers.clear();
+        m_tasks.clear();
+    }
+
+    bool IsRunning() const { return m_running.load(); }
+
+    bool InLoopThread() const { return std::this_thread::get_id() == m_thread.get_id(); }
+
+    /** Register 'fd' for 'events' (EPOLLIN, EPOLLOUT, ...). */
+    bool Add(int fd, uint32_t events, Handler handler) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_handlers[fd] = std::make_shared<Handler>(std::move(handler));
+        }
+        epoll_event ev{};
+        ev.events = events;
+        ev.data.fd = fd;
+        if (::epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_handlers.erase(fd);
+            return false;
+        }
+        return true;
+    }
+
+    /** Change the event mask of a registered descriptor. */
+    bool Modify(int fd, uint32_t events) {
+        epoll_event ev{};
+        ev.events = events;
+        ev.data.fd = fd;
+        return ::epoll_ctl(m_epollFd, EPOLL_CTL_MOD, fd, &ev) == 0;
+    }
+
+    /** Unregister 'fd'; call before closing it. */
+    void Remove(int fd) {
+        ::epoll_ctl(m_epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_handlers.erase(fd);
+    }
+
+    /** Run 'task' on the loop thread. */
+    void Post(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_tasks.push_back(std::move(task));
+        }
+        wake();
+    }
+
+  private:
+    void run() {
+        epoll_event events[64];
+        while (m_running.load()) {
+            int n = ::epoll_wait(m_epollFd, events, 64, -1);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                break;
+            }
+            for (int i = 0; i < n; ++i) {
+                const int fd = events[i].data.fd;
+                if (fd == m_wakeFd) {
+                    uint64_t count = 0;
+                    while (::read(m_wakeFd, &count, sizeof(count)) > 0) {
+                    }
+                    runTasks();
+                    continue;
+                }
+                std::shared_ptr<Handler> handler;
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    auto it = m_handlers.find(fd);
+                    if (it != m_handlers.end()) {
+                        handler = it->second;
+                    }
+                }
+                if (handler) {
+                    (*handler)(events[i].events);
+                }
+            }
+        }
+        runTasks();
+    }
+
+    void runTasks() {
+        std::vector<std::function<void()>> tasks;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            tasks.swap(m_tasks);
+        }
+        for (auto& task : tasks) {
+            task();
+        }
+    }
+
+    void wake() {
+        if (m_wakeFd >= 0) {
+            uint64_t one = 1;
+            ssize_t ignored = ::write(m_wakeFd, &one, sizeof(one));
+            (void)ignored;
+        }
+    }
+
+    void closeFds() {
+        if (m_epollFd >= 0) {
+            ::close(m_epollFd);
+            m_epollFd = -1;
+        }
+        if (m_wakeFd >= 0) {
+            ::close(m_wakeFd);
+            m_wakeFd = -1;
+        }
+    }
+
+    int m_epollFd = -1;
+    int m_wakeFd = -1;
+    std::atomic<bool> m_running{false};
+    std::thread m_thread;
+    std::mutex m_mutex; // guards m_handlers and m_tasks
+    std::unordered_map<int, std::shared_ptr<Handler>> m_handlers;
+    std::vector<std::function<void()>> m_tasks;
+};
+
+} // namespace network
+} // namespace rxrevoltchain
+
+#endif // RXREVOLTCHAIN_EVENT_LOOP_HPP
@@ -1,151 +1,1151 @@
 #include "network/http_query_server.hpp"
+#include "util/json_parser.hpp"
+#include "util/logger.hpp"
+#include <algorithm>
 #include <arpa/inet.h>
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <poll.h>
 #include <sstream>
 
 namespace rxrevoltchain {
 namespace network {
 
-void HttpQueryServer::run() {
-    int server_fd = socket(AF_INET, SOCK_STREAM, 0);
-    if (server_fd < 0) {
-        m_running = false;
-        return;
+namespace {
+
+constexpr uint32_t CONNECTION_EVENTS = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+// How long a worker waits for a stalled client to drain its send buffer
+constexpr int SEND_TIMEOUT_MS = 5000;
+
+bool iequals(const std::string& a, const char* b) {
+    const size_t len = std::strlen(b);
+    if (a.size() != len)
+        return false;
+    for (size_t i = 0; i < len; ++i) {
+        if (std::tolower(static_cast<unsigned char>(a[i])) !=
+            std::tolower(static_cast<unsigned char>(b[i])))
+            return false;
+    }
+    return true;
+}
+
+std::string lowercase(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return text;
+}
+
+std::string trim(const std::string& text) {
+    const size_t begin = text.find_first_not_of(" \t");
+    if (begin == std::string::npos)
+        return "";
+    const size_t end = text.find_last_not_of(" \t");
+    return text.substr(begin, end - begin + 1);
+}
+
+// Value of query parameter 'name' in 'target', undecoded (see urlDecode)
+bool queryParam(const std::string& target, const char* name, std::string& value) {
+    const size_t query = target.find('?');
+    if (query == std::string::npos)
+        return false;
+    const size_t nameLen = std::strlen(name);
+    size_t pos = query + 1;
+    while (pos <= target.size()) {
+        size_t end = target.find('&', pos);
+        if (end == std::string::npos)
+            end = target.size();
+        if (end - pos > nameLen && target.compare(pos, nameLen, name) == 0 &&
+            target[pos + nameLen] == '=') {
+            value = target.substr(pos + nameLen + 1, end - pos - nameLen - 1);
+            return true;
+        }
+        pos = end + 1;
+    }
+    return false;
+}
+
+bool parseInt(const std::string& text, int64_t& value) {
+    if (text.empty())
+        return false;
+    errno = 0;
+    char* end = nullptr;
+    const long long parsed = std::strtoll(text.c_str(), &end, 10);
+    if (*end != '\0' || errno == ERANGE)
+        return false;
+    value = parsed;
+    return true;
+}
+
+// Decodes a query component (%XX escapes, '+' for space); false if an escape is malformed
+bool urlDecode(const std::string& text, std::string& out) {
+    out.clear();
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] == '+') {
+            out += ' ';
+        } else if (text[i] != '%') {
+            out += text[i];
+        } else if (i + 2 < text.size() &&
+                   std::isxdigit(static_cast<unsigned char>(text[i + 1])) &&
+                   std::isxdigit(static_cast<unsigned char>(text[i + 2]))) {
+            out += static_cast<char>(std::strtol(text.substr(i + 1, 2).c_str(), nullptr, 16));
+            i += 2;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool parseDouble(const std::string& text, double& value) {
+    if (text.empty())
+        return false;
+    char* end = nullptr;
+    value = std::strtod(text.c_str(), &end);
+    return *end == '\0' && std::isfinite(value);
+}
+
+// 'limit' parameter of a query endpoint: 'fallback' if absent, at most 'max'
+bool limitParam(const std::string& target, int64_t fallback, int64_t max, int64_t& limit) {
+    std::string value;
+    limit = fallback;
+    if (queryParam(target, "limit", value) && (!parseInt(value, limit) || limit < 0))
+        return false;
+    limit = std::min(limit, max);
+    return true;
+}
+
+std::string streamHead(bool raw, bool chunked, bool keepAlive) {
+    std::string head = "HTTP/1.1 200 OK\r\nContent-Type: ";
+    head += raw ? HttpQueryServer::RECORDS_RAW_TYPE : "application/json";
+    if (chunked)
+        head += "\r\nTransfer-Encoding: chunked";
+    head += keepAlive ? "\r\nConnection: keep-alive\r\n\r\n" : "\r\nConnection: close\r\n\r\n";
+    return head;
+}
+
+} // namespace
+
+bool HttpQueryServer::Start() {
+    using namespace rxrevoltchain::util::logger;
+    if (m_running.load())
+        return false;
+
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        Logger::getInstance().error("[HttpQueryServer] socket() failed: " +
+                                    std::string(strerror(errno)));
+        return false;
     }
     int opt = 1;
-    setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
 
     sockaddr_in addr{};
     addr.sin_family = AF_INET;
     addr.sin_port = htons(m_port);
     addr.sin_addr.s_addr = INADDR_ANY;
-    if (bind(server_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
-        close(server_fd);
-        m_running = false;
+    socklen_t addrLen = sizeof(addr);
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, SOMAXCONN) < 0 ||
+        getsockname(fd, (struct sockaddr*)&addr, &addrLen) < 0) {
+        Logger::getInstance().error("[HttpQueryServer] Could not listen on port " +
+                                    std::to_string(m_port) + ": " + strerror(errno));
+        close(fd);
+        return false;
+    }
+    if (!m_loop.Start()) {
+        close(fd);
+        return false;
+    }
+    m_listenFd = fd;
+    m_boundPort = ntohs(addr.sin_port);
+    for (const auto& shard : m_shards)
+        shard->pool.SetMaxConnections(m_workerCount);
+    // Baseline for the database watch, so a commit before the first tick is not missed
+    watchDatabase();
+    m_running = true;
+
+    for (size_t i = 0; i < m_workerCount; ++i)
+        m_workers.emplace_back(&HttpQueryServer::workerLoop, this);
+    m_ticker = std::thread(&HttpQueryServer::tickerLoop, this);
+    if (!m_loop.Add(m_listenFd, EPOLLIN, [this](uint32_t) { acceptConnections(); })) {
+        Stop();
+        return false;
+    }
+    Logger::getInstance().info("[HttpQueryServer] Listening on port " +
+                               std::to_string(m_boundPort.load()) + " with " +
+                               std::to_string(m_workerCount) + " workers.");
+    return true;
+}
+
+void HttpQueryServer::Stop() {
+    if (!m_running.exchange(false))
         return;
+    {
+        std::lock_guard<std::mutex> lock(m_tickMutex);
+    }
+    m_tickWake.notify_all();
+    if (m_ticker.joinable())
+        m_ticker.join();
+    {
+        std::lock_guard<std::mutex> lock(m_workMutex);
+    }
+    m_workReady.notify_all();
+    for (auto& worker : m_workers) {
+        if (worker.joinable())
+            worker.join();
+    }
+    m_workers.clear();
+    m_loop.Stop();
+
+    {
+        std::lock_guard<std::mutex> lock(m_workMutex);
+        m_ready.clear();
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_connMutex);
+        for (auto& entry : m_connections)
+            close(entry.first);
+        Metrics::get().connections.add(-static_cast<double>(m_connections.size()));
+        m_connections.clear();
+    }
+    close(m_listenFd);
+    m_listenFd = -1;
+    for (const auto& shard : m_shards)
+        closeWatcher(*shard);
+}
+
+// -----------------------------------------------------------------------------
+// Connections
+// -----------------------------------------------------------------------------
+
+void HttpQueryServer::acceptConnections() {
+    while (true) {
+        int fd = accept4(m_listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR)
+                continue;
+            return; // EAGAIN, or out of descriptors until a connection closes
+        }
+        std::lock_guard<std::mutex> lock(m_connMutex);
+        if (m_connections.size() >= MAX_CONNECTIONS) {
+            close(fd);
+            continue;
+        }
+        auto conn = std::make_shared<Connection>();
+        conn->fd = fd;
+        conn->lastActive = std::chrono::steady_clock::now();
+        m_connections[fd] = conn;
+        if (!m_loop.Add(fd, CONNECTION_EVENTS, [this, fd](uint32_t) { dispatch(fd); })) {
+            m_connections.erase(fd);
+            close(fd);
+            continue;
+        }
+        Metrics::get().connections.add(1);
     }
-    if (listen(server_fd, 4) < 0) {
-        close(server_fd);
-        m_running = false;
+}
+
+void HttpQueryServer::dispatch(int fd) {
+    std::shared_ptr<Connection> conn;
+    {
+        std::lock_guard<std::mutex> lock(m_connMutex);
+        auto it = m_connections.find(fd);
+        // A busy connection is re-armed by its worker, which catches this readiness then
+        if (it == m_connections.end() || it->second->busy)
+            return;
+        conn = it->second;
+        conn->busy = true;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_workMutex);
+        m_ready.push_back(std::move(conn));
+    }
+    m_workReady.notify_one();
+}
+
+void HttpQueryServer::workerLoop() {
+    while (true) {
+        std::shared_ptr<Connection> conn;
+        {
+            std::unique_lock<std::mutex> lock(m_workMutex);
+            m_workReady.wait(lock, [this]() { return !m_running.load() || !m_ready.empty(); });
+            if (!m_running.load())
+                return;
+            conn = std::move(m_ready.front());
+            m_ready.pop_front();
+        }
+        serve(conn);
+    }
+}
+
+void HttpQueryServer::serve(const std::shared_ptr<Connection>& conn) {
+    const bool open = readAvailable(*conn);
+    bool keepAlive = true;
+    Request request;
+    while (keepAlive) {
+        const ParseResult result = parseRequest(conn->input, request);
+        if (result == ParseResult::Incomplete) {
+            break;
+        }
+        if (result == ParseResult::Malformed) {
+            sendStatus(conn->fd, 400, "Bad Request", false);
+            keepAlive = false;
+        } else if (result == ParseResult::HeaderTooLarge) {
+            sendStatus(conn->fd, 431, "Request Header Fields Too Large", false);
+            keepAlive = false;
+        } else if (result == ParseResult::BodyTooLarge) {
+            sendStatus(conn->fd, 413, "Payload Too Large", false);
+            keepAlive = false;
+        } else {
+            keepAlive = request.keepAlive && m_running.load();
+            if (!respond(conn->fd, request, keepAlive))
+                keepAlive = false;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_connMutex);
+    if (!open || !keepAlive) {
+        closeConnectionLocked(conn->fd);
         return;
     }
+    // Re-arm under the lock so the idle sweep cannot close the socket in between
+    conn->busy = false;
+    conn->lastActive = std::chrono::steady_clock::now();
+    m_loop.Modify(conn->fd, CONNECTION_EVENTS);
+}
 
-    while (m_running.load()) {
-        int client = accept(server_fd, nullptr, nullptr);
-        if (client < 0) {
+bool HttpQueryServer::readAvailable(Connection& conn) {
+    char buffer[16 * 1024];
+    while (conn.input.size() <= MAX_HEADER_BYTES + MAX_BODY_BYTES) {
+        const ssize_t n = recv(conn.fd, buffer, sizeof(buffer), 0);
+        if (n > 0) {
+            conn.input.append(buffer, static_cast<size_t>(n));
             continue;
         }
-        handleClient(client);
-        close(client);
+        if (n < 0 && errno == EINTR)
+            continue;
+        // n == 0: the client closed its end; whatever it sent is still answered
+        return n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
     }
-    close(server_fd);
+    return true;
 }
 
-void HttpQueryServer::handleClient(int fd) {
-    char buffer[1024];
-    ssize_t n = recv(fd, buffer, sizeof(buffer) - 1, 0);
-    if (n <= 0)
+void HttpQueryServer::closeConnectionLocked(int fd) {
+    if (m_connections.erase(fd) == 0)
         return;
-    buffer[n] = '\0';
-    std::string req(buffer);
+    m_loop.Remove(fd);
+    close(fd);
+    Metrics::get().connections.add(-1);
+}
 
-    if (req.rfind("GET /metrics", 0) == 0) {
-        handleMetrics(fd);
-    } else if (req.rfind("GET /record/", 0) == 0) {
-        size_t pos = req.find(" ", 13); // after /record/
-        std::string idStr = req.substr(13, pos - 13);
-        int id = std::atoi(idStr.c_str());
-        handleRecord(fd, id);
-    } else {
-        send404(fd);
+void HttpQueryServer::closeIdleConnections() {
+    const auto deadline =
+        std::chrono::steady_clock::now() - std::chrono::milliseconds(m_keepAliveMs);
+    std::lock_guard<std::mutex> lock(m_connMutex);
+    std::vector<int> idle;
+    for (const auto& entry : m_connections) {
+        if (!entry.second->busy && entry.second->lastActive < deadline)
+            idle.push_back(entry.first);
     }
+    for (int fd : idle)
+        closeConnectionLocked(fd);
 }
 
-void HttpQueryServer::handleMetrics(int fd) {
-    int count = GetDocumentCount(m_dbPath);
-    std::stringstream ss;
-    ss << "{\"document_count\":" << (count >= 0 ? count : 0) << "}";
-    send200(fd, ss.str());
+// -----------------------------------------------------------------------------
+// Database watch
+// -----------------------------------------------------------------------------
+
+void HttpQueryServer::tickerLoop() {
+    std::unique_lock<std::mutex> lock(m_tickMutex);
+    while (m_running.load()) {
+        m_tickWake.wait_for(lock, WATCH_INTERVAL, [this]() { return !m_running.load(); });
+        if (!m_running.load())
+            break;
+        lock.unlock();
+        closeIdleConnections();
+        watchDatabase();
+        lock.lock();
+    }
 }
 
-void HttpQueryServer::handleRecord(int fd, int id) {
-    sqlite3* db = nullptr;
-    if (sqlite3_open_v2(m_dbPath.c_str(), &db, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK) {
-        send404(fd);
-        return;
+void HttpQueryServer::watchDatabase() {
+    for (const auto& shard : m_shards)
+        watchShard(*shard);
+}
+
+void HttpQueryServer::watchShard(Shard& shard) {
+    struct stat st;
+    const bool exists = stat(shard.path.c_str(), &st) == 0;
+    if (!exists || st.st_dev != shard.watchDev || st.st_ino != shard.watchIno) {
+        // Replaced or removed: statements prepared against the old file are useless
+        if (shard.watchDb || shard.watchIno != 0) {
+            shard.pool.Reopen();
+            {
+                std::lock_guard<std::mutex> lock(m_dictionaryMutex);
+                m_dictionaries.clear();
+            }
+            InvalidateCache();
+        }
+        closeWatcher(shard);
+        if (!exists)
+            return;
+        shard.watchDev = st.st_dev;
+        shard.watchIno = st.st_ino;
     }
-    sqlite3_stmt* stmt = nullptr;
-    const char* sql = "SELECT metadata, payload FROM documents WHERE id=?";
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        sqlite3_close(db);
-        send404(fd);
-        return;
+    if (!shard.watchDb) {
+        if (sqlite3_open_v2(shard.path.c_str(), &shard.watchDb,
+                            SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, nullptr) != SQLITE_OK ||
+            sqlite3_prepare_v2(shard.watchDb, "PRAGMA data_version", -1,
+                               &shard.dataVersionStmt, nullptr) != SQLITE_OK ||
+            sqlite3_prepare_v2(shard.watchDb, "PRAGMA schema_version", -1,
+                               &shard.schemaVersionStmt, nullptr) != SQLITE_OK) {
+            closeWatcher(shard);
+            return;
+        }
+    }
+
+    auto readPragma = [](sqlite3_stmt* stmt) {
+        int64_t value = -1;
+        if (sqlite3_step(stmt) == SQLITE_ROW)
+            value = sqlite3_column_int64(stmt, 0);
+        sqlite3_reset(stmt);
+        return value;
+    };
+    const int64_t dataVersion = readPragma(shard.dataVersionStmt);
+    const int64_t schemaVersion = readPragma(shard.schemaVersionStmt);
+    if (shard.schemaVersion >= 0 && schemaVersion != shard.schemaVersion) {
+        shard.pool.Reopen();
+        std::lock_guard<std::mutex> lock(m_dictionaryMutex);
+        m_dictionaries.clear();
+    }
+    if (shard.dataVersion >= 0 && dataVersion != shard.dataVersion)
+        InvalidateCache();
+    shard.dataVersion = dataVersion;
+    shard.schemaVersion = schemaVersion;
+}
+
+void HttpQueryServer::closeWatcher(Shard& shard) {
+    sqlite3_finalize(shard.dataVersionStmt);
+    sqlite3_finalize(shard.schemaVersionStmt);
+    sqlite3_close(shard.watchDb);
+    shard.dataVersionStmt = nullptr;
+    shard.schemaVersionStmt = nullptr;
+    shard.watchDb = nullptr;
+    shard.dataVersion = -1;
+    shard.schemaVersion = -1;
+}
+
+// -----------------------------------------------------------------------------
+// Requests
+// -----------------------------------------------------------------------------
+
+HttpQueryServer::ParseResult HttpQueryServer::parseRequest(std::string& buffer,
+                                                           Request& request) {
+    const size_t headerEnd = buffer.find("\r\n\r\n");
+    if (headerEnd == std::string::npos) {
+        return buffer.size() > MAX_HEADER_BYTES ? ParseResult::HeaderTooLarge
+                                                : ParseResult::Incomplete;
+    }
+    if (headerEnd > MAX_HEADER_BYTES)
+        return ParseResult::HeaderTooLarge;
+
+    size_t lineEnd = buffer.find("\r\n");
+    std::istringstream requestLine(buffer.substr(0, lineEnd));
+    std::string version;
+    if (!(requestLine >> request.method >> request.target >> version) ||
+        version.rfind("HTTP/1.", 0) != 0)
+        return ParseResult::Malformed;
+
+    std::string connection;
+    size_t contentLength = 0;
+    size_t pos = lineEnd + 2;
+    while (pos < headerEnd) {
+        lineEnd = buffer.find("\r\n", pos);
+        const std::string line = buffer.substr(pos, lineEnd - pos);
+        pos = lineEnd + 2;
+        const size_t colon = line.find(':');
+        if (colon == std::string::npos)
+            return ParseResult::Malformed;
+        const std::string name = line.substr(0, colon);
+        const std::string value = trim(line.substr(colon + 1));
+        if (iequals(name, "Connection")) {
+            connection = lowercase(value);
+        } else if (iequals(name, "Content-Length")) {
+            char* end = nullptr;
+            const unsigned long long length = std::strtoull(value.c_str(), &end, 10);
+            if (value.empty() || *end != '\0')
+                return ParseResult::Malformed;
+            if (length > MAX_BODY_BYTES)
+                return ParseResult::BodyTooLarge;
+            contentLength = static_cast<size_t>(length);
+        } else if (iequals(name, "Transfer-Encoding")) {
+            return ParseResult::Malformed; // bodies must come with a Content-Length
+        }
+    }
+
+    const size_t total = headerEnd + 4 + contentLength;
+    if (buffer.size() < total)
+        return ParseResult::Incomplete;
+    request.body.assign(buffer, headerEnd + 4, contentLength);
+    buffer.erase(0, total);
+
+    request.http10 = version == "HTTP/1.0";
+    if (request.http10)
+        request.keepAlive = connection.find("keep-alive") != std::string::npos;
+    else
+        request.keepAlive = connection.find("close") == std::string::npos;
+    return ParseResult::Ok;
+}
+
+bool HttpQueryServer::respond(int fd, const Request& request, bool keepAlive) {
+    Metrics::get().requests.inc();
+    const std::string path = request.target.substr(0, request.target.find('?'));
+    std::string rawFlag;
+    const bool raw = queryParam(request.target, "raw", rawFlag) && rawFlag == "1";
+
+    if (path == "/records") {
+        if (request.method == "GET")
+            return streamRange(fd, request, raw, keepAlive);
+        if (request.method == "POST")
+            return streamBatch(fd, request, raw, keepAlive);
+        return sendStatus(fd, 405, "Method Not Allowed", keepAlive);
     }
-    sqlite3_bind_int(stmt, 1, id);
-    int rc = sqlite3_step(stmt);
-    if (rc != SQLITE_ROW) {
-        sqlite3_finalize(stmt);
-        sqlite3_close(db);
-        send404(fd);
+    if (request.method != "GET")
+        return sendStatus(fd, 405, "Method Not Allowed", keepAlive);
+
+    if (path == "/costs")
+        return respondCosts(fd, request, keepAlive);
+    if (path == "/search")
+        return respondSearch(fd, request, keepAlive);
+    if (path == "/metrics")
+        return sendResponse(fd, "200 OK", "text/plain; version=0.0.4", RenderMetrics(),
+                            keepAlive);
+
+    static const std::string recordPrefix = "/record/";
+    int64_t id = 0;
+    if (path.rfind(recordPrefix, 0) == 0 && parseInt(path.substr(recordPrefix.size()), id) &&
+        id >= 0)
+        return respondRecord(fd, id, raw, keepAlive);
+    return sendStatus(fd, 404, "Not Found", keepAlive);
+}
+
+// Shard and row id behind a query id (see GlobalId); false if no shard holds it
+bool HttpQueryServer::locate(int64_t id, size_t& shard, int64_t& rowId) const {
+    if (id < 0)
+        return false;
+    // A single database takes every id as its row id
+    shard = m_shards.size() == 1 ? 0 : static_cast<size_t>(id >> SHARD_ID_BITS);
+    rowId = m_shards.size() == 1 ? id : id & SHARD_ROW_MASK;
+    return shard < m_shards.size();
+}
+
+bool HttpQueryServer::respondRecord(int fd, int64_t id, bool raw, bool keepAlive) {
+    if (!raw) {
+        std::shared_ptr<const std::string> body;
+        if (!recordBody(id, body))
+            return sendStatus(fd, 404, "Not Found", keepAlive);
+        return sendResponse(fd, "200 OK", "application/json", *body, keepAlive);
+    }
+
+    std::string meta;
+    std::vector<uint8_t> payload;
+    size_t shard = 0;
+    int64_t rowId = 0;
+    if (!locate(id, shard, rowId))
+        return sendStatus(fd, 404, "Not Found", keepAlive);
+    {
+        SqliteReadPool::Lease conn = m_shards[shard]->pool.Acquire();
+        SqliteReadPool::Connection* db = conn.operator->();
+        if (!conn || !db->record ||
+            !readRecord(db, rowId, meta, payload,
+                        [this, db](uint32_t dictId) { return cachedDictionary(db, dictId); }))
+            return sendStatus(fd, 404, "Not Found", keepAlive);
+    }
+    return sendResponse(fd, "200 OK", "application/octet-stream",
+                        std::string(payload.begin(), payload.end()), keepAlive);
+}
+
+// Buffers a streamed body and sends it in chunks of at least STREAM_CHUNK_BYTES
+// (HTTP/1.1 chunked transfer encoding) or as plain bytes up to connection close (HTTP/1.0).
+class HttpQueryServer::ChunkedWriter {
+  public:
+    ChunkedWriter(int fd, bool chunked) : m_fd(fd), m_chunked(chunked) {
+        m_buffer.reserve(STREAM_CHUNK_BYTES + 4096);
+    }
+
+    std::string& buffer() { return m_buffer; }
+
+    bool flushIfFull() { return m_buffer.size() < STREAM_CHUNK_BYTES || flush(); }
+
+    bool flush() {
+        if (m_buffer.empty())
+            return true;
+        bool ok;
+        if (m_chunked) {
+            char size[24];
+            std::snprintf(size, sizeof(size), "%zx\r\n", m_buffer.size());
+            m_buffer += "\r\n";
+            ok = sendAll(m_fd, size, m_buffer);
+        } else {
+            ok = sendAll(m_fd, std::string(), m_buffer);
+        }
+        m_buffer.clear();
+        return ok;
+    }
+
+    bool finish() { return flush() && (!m_chunked || sendAll(m_fd, "0\r\n\r\n", std::string())); }
+
+  private:
+    int m_fd;
+    bool m_chunked;
+    std::string m_buffer;
+};
+
+bool HttpQueryServer::streamRange(int fd, const Request& request, bool raw, bool keepAlive) {
+    int64_t from = 0;
+    int64_t to = INT64_MAX;
+    int64_t limit = DEFAULT_RECORDS_LIMIT;
+    std::string value;
+    if ((queryParam(request.target, "from", value) && !parseInt(value, from)) ||
+        (queryParam(request.target, "to", value) && !parseInt(value, to)) ||
+        (queryParam(request.target, "limit", value) && (!parseInt(value, limit) || limit < 0)))
+        return sendStatus(fd, 400, "Bad Request", keepAlive);
+    limit = std::min(limit, MAX_RECORDS_LIMIT);
+
+    // Ids are shard-major (see GlobalId), so the range is one slice of row ids per shard it
+    // covers, in shard order. A single database serves [from, to] as is.
+    struct Slice {
+        size_t shard;
+        int64_t from;
+        int64_t to;
+    };
+    std::vector<Slice> slices;
+    if (m_shards.size() == 1) {
+        slices.push_back({0, from, to});
+    } else if (from <= to && to >= 0) {
+        from = std::max<int64_t>(from, 0);
+        const size_t first = static_cast<size_t>(from >> SHARD_ID_BITS);
+        const size_t toShard = static_cast<size_t>(to >> SHARD_ID_BITS);
+        for (size_t shard = first; shard < m_shards.size() && shard <= toShard; ++shard)
+            slices.push_back({shard, shard == first ? from & SHARD_ROW_MASK : 0,
+                              shard == toShard ? to & SHARD_ROW_MASK : SHARD_ROW_MASK});
+    }
+
+    SqliteReadPool::Lease conn = m_shards[slices.empty() ? 0 : slices[0].shard]->pool.Acquire();
+    if (!conn || !conn->range)
+        return sendStatus(fd, 503, "Service Unavailable", keepAlive);
+
+    // HTTP/1.0 has no chunked encoding; the body then ends with the connection
+    const bool chunked = !request.http10;
+    keepAlive = keepAlive && chunked;
+    if (!sendAll(fd, streamHead(raw, chunked, keepAlive), std::string()))
+        return false;
+    ChunkedWriter writer(fd, chunked);
+    if (!raw)
+        writer.buffer() += '[';
+
+    int64_t sent = 0;
+    for (size_t i = 0; i < slices.size() && sent < limit; ++i) {
+        if (i > 0) {
+            conn = m_shards[slices[i].shard]->pool.Acquire();
+            if (!conn || !conn->range)
+                return false; // the missing terminator tells the client the body is incomplete
+        }
+        if (!streamRows(writer, slices[i].shard, conn.operator->(), slices[i].from,
+                        slices[i].to, limit, sent, raw))
+            return false;
+    }
+    if (!raw)
+        writer.buffer() += ']';
+    return writer.finish() && keepAlive;
+}
+
+// Streams the rows of one shard with row ids in [from, to] until 'limit' rows have been
+// sent in total; false if the read fails or the client is gone
+bool HttpQueryServer::streamRows(ChunkedWriter& writer, size_t shard,
+                                 SqliteReadPool::Connection* db, int64_t from, int64_t to,
+                                 int64_t limit, int64_t& sent, bool raw) {
+    auto dictionary = [this, db](uint32_t dictId) { return cachedDictionary(db, dictId); };
+    std::string meta;
+    std::vector<uint8_t> payload;
+    bool more = from <= to;
+    while (more && sent < limit) {
+        // One page per read transaction; the statement is reset before the page is sent
+        const int64_t page = std::min<int64_t>(STREAM_PAGE_ROWS, limit - sent);
+        sqlite3_stmt* stmt = db->range;
+        sqlite3_reset(stmt);
+        sqlite3_bind_int64(stmt, 1, from);
+        sqlite3_bind_int64(stmt, 2, to);
+        sqlite3_bind_int64(stmt, 3, page);
+        int64_t rows = 0;
+        bool reachedEnd = false;
+        int rc;
+        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+            const int64_t id = sqlite3_column_int64(stmt, 0);
+            if (!decodeRow(stmt, 1, meta, payload, dictionary)) {
+                rc = SQLITE_CORRUPT;
+                break;
+            }
+            appendRecord(writer.buffer(), GlobalId(shard, id), meta, payload, raw, sent == 0);
+            ++rows;
+            ++sent;
+            if (id >= to) {
+                reachedEnd = true; // also keeps 'id + 1' from overflowing
+                break;
+            }
+            from = id + 1;
+            if (writer.buffer().size() >= STREAM_CHUNK_BYTES) {
+                break; // ends the read transaction early; the next page resumes at 'from'
+            }
+        }
+        sqlite3_reset(stmt);
+        if (rc != SQLITE_ROW && rc != SQLITE_DONE) {
+            util::logger::Logger::getInstance().warn(
+                "[HttpQueryServer] /records aborted: " + std::string(sqlite3_errstr(rc)));
+            return false;
+        }
+        more = !reachedEnd && (rc == SQLITE_ROW || rows == page);
+        if (!writer.flushIfFull())
+            return false;
+    }
+    return true;
+}
+
+bool HttpQueryServer::streamBatch(int fd, const Request& request, bool raw, bool keepAlive) {
+    util::JsonValue ids;
+    if (!util::JsonStreamParser::parse(request.body, ids) || !ids.isArray() ||
+        ids.items().size() > MAX_BATCH_IDS)
+        return sendStatus(fd, 400, "Bad Request", keepAlive);
+    for (const util::JsonValue& id : ids.items()) {
+        // Integral and exactly representable as a double
+        if (!id.isNumber() || id.asNumber() != std::floor(id.asNumber()) ||
+            std::fabs(id.asNumber()) > 9007199254740992.0)
+            return sendStatus(fd, 400, "Bad Request", keepAlive);
+    }
+
+    // One connection per shard for the whole batch
+    std::vector<SqliteReadPool::Lease> conns;
+    for (const auto& shard : m_shards) {
+        conns.push_back(shard->pool.Acquire());
+        if (!conns.back() || !conns.back()->record)
+            return sendStatus(fd, 503, "Service Unavailable", keepAlive);
+    }
+
+    const bool chunked = !request.http10;
+    keepAlive = keepAlive && chunked;
+    if (!sendAll(fd, streamHead(raw, chunked, keepAlive), std::string()))
+        return false;
+    ChunkedWriter writer(fd, chunked);
+    if (!raw)
+        writer.buffer() += '[';
+    std::string meta;
+    std::vector<uint8_t> payload;
+    bool first = true;
+    for (const util::JsonValue& value : ids.items()) {
+        const int64_t id = static_cast<int64_t>(value.asNumber());
+        size_t shard = 0;
+        int64_t rowId = 0;
+        if (!locate(id, shard, rowId))
+            continue;
+        SqliteReadPool::Connection* db = conns[shard].operator->();
+        if (!readRecord(db, rowId, meta, payload,
+                        [this, db](uint32_t dictId) { return cachedDictionary(db, dictId); }))
+            continue;
+        appendRecord(writer.buffer(), id, meta, payload, raw, first);
+        first = false;
+        if (!writer.flushIfFull())
+            return false;
+    }
+    if (!raw)
+        writer.buffer() += ']';
+    return writer.finish() && keepAlive;
+}
+
+bool HttpQueryServer::respondCosts(int fd, const Request& request, bool keepAlive) {
+    // Each given filter adds its clause; the SQL text (one per combination) is prepared
+    // once per connection
+    static const std::pair<const char*, const char*> TEXT_FILTERS[] = {
+        {"procedure", " AND c.procedure_code = ?"},
+        {"provider", " AND c.provider = ?"},
+        {"region", " AND c.region = ?"},
+        {"q", " AND c.doc_id IN (SELECT rowid FROM documents_fts WHERE documents_fts MATCH ?)"}};
+    static const std::pair<const char*, const char*> PRICE_FILTERS[] = {
+        {"min_price", " AND c.price >= ?"}, {"max_price", " AND c.price <= ?"}};
+
+    std::string sql = "SELECT c.doc_id, c.procedure_code, c.description, c.provider, c.region,"
+                      " c.price, d.metadata FROM cost_items c JOIN documents d ON d.id = c.doc_id"
+                      " WHERE 1";
+    std::vector<std::string> texts;
+    std::vector<double> prices;
+    std::string value;
+    for (const auto& filter : TEXT_FILTERS) {
+        if (!queryParam(request.target, filter.first, value) || value.empty())
+            continue;
+        texts.emplace_back();
+        if (!urlDecode(value, texts.back()))
+            return sendStatus(fd, 400, "Bad Request", keepAlive);
+        sql += filter.second;
+    }
+    for (const auto& filter : PRICE_FILTERS) {
+        if (!queryParam(request.target, filter.first, value))
+            continue;
+        prices.push_back(0);
+        if (!parseDouble(value, prices.back()))
+            return sendStatus(fd, 400, "Bad Request", keepAlive);
+        sql += filter.second;
+    }
+    int64_t limit = 0;
+    if (!limitParam(request.target, DEFAULT_QUERY_LIMIT, MAX_QUERY_LIMIT, limit))
+        return sendStatus(fd, 400, "Bad Request", keepAlive);
+    sql += " ORDER BY c.price IS NULL, c.price, c.doc_id LIMIT ?";
+
+    // Each shard answers with its first 'limit' items, merged below in the same order
+    struct Item {
+        bool unpriced;
+        double price;
+        int64_t id;
+        std::string json;
+    };
+    std::vector<Item> items;
+    int rc = SQLITE_DONE;
+    for (size_t shard = 0; shard < m_shards.size() && rc == SQLITE_DONE; ++shard) {
+        SqliteReadPool::Lease conn = m_shards[shard]->pool.Acquire();
+        sqlite3_stmt* stmt = conn ? SqliteReadPool::Statement(conn.operator->(), sql) : nullptr;
+        if (!stmt)
+            return sendStatus(fd, 503, "Service Unavailable", keepAlive);
+        int index = 0;
+        for (const std::string& text : texts)
+            sqlite3_bind_text(stmt, ++index, text.data(), static_cast<int>(text.size()),
+                              SQLITE_TRANSIENT);
+        for (double price : prices)
+            sqlite3_bind_double(stmt, ++index, price);
+        sqlite3_bind_int64(stmt, ++index, limit);
+
+        std::string json;
+        auto appendText = [&json, stmt](const char* key, int column) {
+            json += ",\"";
+            json += key;
+            const unsigned char* text = sqlite3_column_text(stmt, column);
+            if (!text) {
+                json += "\":null";
+                return;
+            }
+            json += "\":\"";
+            appendJsonEscaped(json, reinterpret_cast<const char*>(text));
+            json += '"';
+        };
+        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+            const int64_t id = GlobalId(shard, sqlite3_column_int64(stmt, 0));
+            const bool unpriced = sqlite3_column_type(stmt, 5) == SQLITE_NULL;
+            const double price = unpriced ? 0 : sqlite3_column_double(stmt, 5);
+            json = "{\"id\":" + std::to_string(id);
+            appendText("procedure_code", 1);
+            appendText("description", 2);
+            appendText("provider", 3);
+            appendText("region", 4);
+            if (unpriced) {
+                json += ",\"price\":null";
+            } else {
+                char text[32];
+                std::snprintf(text, sizeof(text), ",\"price\":%.15g", price);
+                json += text;
+            }
+            appendText("metadata", 6);
+            json += '}';
+            items.push_back({unpriced, price, id, std::move(json)});
+        }
+        sqlite3_reset(stmt);
+    }
+    // SQLITE_ERROR at step time is a malformed FTS5 query
+    if (rc == SQLITE_ERROR)
+        return sendStatus(fd, 400, "Bad Request", keepAlive);
+    if (rc != SQLITE_DONE)
+        return sendStatus(fd, 503, "Service Unavailable", keepAlive);
+
+    std::sort(items.begin(), items.end(), [](const Item& a, const Item& b) {
+        if (a.unpriced != b.unpriced)
+            return b.unpriced;
+        if (a.price != b.price)
+            return a.price < b.price;
+        return a.id < b.id;
+    });
+    std::string body = "[";
+    for (size_t i = 0; i < items.size() && static_cast<int64_t>(i) < limit; ++i) {
+        if (i > 0)
+            body += ',';
+        body += items[i].json;
+    }
+    body += ']';
+    return sendResponse(fd, "200 OK", "application/json", body, keepAlive);
+}
+
+bool HttpQueryServer::respondSearch(int fd, const Request& request, bool keepAlive) {
+    std::string value;
+    std::string query;
+    int64_t limit = 0;
+    if (!queryParam(request.target, "q", value) || !urlDecode(value, query) || query.empty() ||
+        !limitParam(request.target, DEFAULT_QUERY_LIMIT, MAX_QUERY_LIMIT, limit))
+        return sendStatus(fd, 400, "Bad Request", keepAlive);
+
+    static const std::string sql =
+        "SELECT d.id, d.metadata, m.rank FROM (SELECT rowid, rank FROM documents_fts"
+        " WHERE documents_fts MATCH ? ORDER BY rank LIMIT ?) m"
+        " JOIN documents d ON d.id = m.rowid ORDER BY m.rank";
+    // Each shard's best 'limit' matches, merged by rank (stable: ties keep shard order)
+    struct Match {
+        double rank;
+        std::string json;
+    };
+    std::vector<Match> matches;
+    int rc = SQLITE_DONE;
+    for (size_t shard = 0; shard < m_shards.size() && rc == SQLITE_DONE; ++shard) {
+        SqliteReadPool::Lease conn = m_shards[shard]->pool.Acquire();
+        sqlite3_stmt* stmt = conn ? SqliteReadPool::Statement(conn.operator->(), sql) : nullptr;
+        if (!stmt)
+            return sendStatus(fd, 503, "Service Unavailable", keepAlive);
+        sqlite3_bind_text(stmt, 1, query.data(), static_cast<int>(query.size()),
+                          SQLITE_TRANSIENT);
+        sqlite3_bind_int64(stmt, 2, limit);
+        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+            std::string json = "{\"id\":";
+            json += std::to_string(GlobalId(shard, sqlite3_column_int64(stmt, 0)));
+            json += ",\"metadata\":\"";
+            const unsigned char* meta = sqlite3_column_text(stmt, 1);
+            appendJsonEscaped(json, meta ? reinterpret_cast<const char*>(meta) : "");
+            json += "\"}";
+            matches.push_back({sqlite3_column_double(stmt, 2), std::move(json)});
+        }
+        sqlite3_reset(stmt);
+    }
+    if (rc == SQLITE_ERROR)
+        return sendStatus(fd, 400, "Bad Request", keepAlive);
+    if (rc != SQLITE_DONE)
+        return sendStatus(fd, 503, "Service Unavailable", keepAlive);
+
+    std::stable_sort(matches.begin(), matches.end(),
+                     [](const Match& a, const Match& b) { return a.rank < b.rank; });
+    std::string body = "[";
+    for (size_t i = 0; i < matches.size() && static_cast<int64_t>(i) < limit; ++i) {
+        if (i > 0)
+            body += ',';
+        body += matches[i].json;
+    }
+    body += ']';
+    return sendResponse(fd, "200 OK", "application/json", body, keepAlive);
+}
+
+void HttpQueryServer::appendRecord(std::string& out, int64_t id, const std::string& metadata,
+                                   const std::vector<uint8_t>& payload, bool raw, bool first) {
+    if (raw) {
+        char header[16];
+        const uint64_t rawId = static_cast<uint64_t>(id);
+        const uint32_t metaLen = static_cast<uint32_t>(metadata.size());
+        const uint32_t payloadLen = static_cast<uint32_t>(payload.size());
+        for (int i = 0; i < 8; ++i)
+            header[i] = static_cast<char>(rawId >> (8 * i));
+        for (int i = 0; i < 4; ++i) {
+            header[8 + i] = static_cast<char>(metaLen >> (8 * i));
+            header[12 + i] = static_cast<char>(payloadLen >> (8 * i));
+        }
+        out.append(header, sizeof(header));
+        out += metadata;
+        out.append(reinterpret_cast<const char*>(payload.data()), payload.size());
         return;
     }
-    const unsigned char* meta = sqlite3_column_text(stmt, 0);
-    const void* blob = sqlite3_column_blob(stmt, 1);
-    int blobSize = sqlite3_column_bytes(stmt, 1);
-    std::vector<unsigned char> payload;
-    if (blob && blobSize > 0) {
-        const unsigned char* p = reinterpret_cast<const unsigned char*>(blob);
-        payload.assign(p, p + blobSize);
-    }
-    sqlite3_finalize(stmt);
-    sqlite3_close(db);
-
-    std::stringstream ss;
-    ss << "{\"metadata\":\"";
-    if (meta)
-        ss << meta;
-    ss << "\",\"payload\":\"" << b64Encode(payload) << "\"}";
-    send200(fd, ss.str());
-}
-
-void HttpQueryServer::send200(int fd, const std::string& body, const std::string& type) {
-    std::stringstream ss;
-    ss << "HTTP/1.1 200 OK\r\nContent-Type: " << type << "\r\nContent-Length: " << body.size()
-       << "\r\nConnection: close\r\n\r\n"
-       << body;
-    std::string resp = ss.str();
-    send(fd, resp.c_str(), resp.size(), 0);
-}
-
-void HttpQueryServer::send404(int fd) {
-    const char* body = "Not Found";
-    std::stringstream ss;
-    ss << "HTTP/1.1 404 Not Found\r\nContent-Length: " << strlen(body)
-       << "\r\nConnection: close\r\n\r\n"
-       << body;
-    std::string resp = ss.str();
-    send(fd, resp.c_str(), resp.size(), 0);
-}
-
-static const char b64_table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
-
-std::string HttpQueryServer::b64Encode(const std::vector<unsigned char>& data) {
-    std::string out;
-    size_t i = 0;
-    unsigned val = 0;
-    int valb = -6;
-    for (unsigned char c : data) {
-        val = (val << 8) + c;
-        valb += 8;
-        while (valb >= 0) {
-            out.push_back(b64_table[(val >> valb) & 0x3F]);
-            valb -= 6;
-        }
-    }
-    if (valb > -6)
-        out.push_back(b64_table[((val << 8) >> (valb + 8)) & 0x3F]);
-    while (out.size() % 4)
-        out.push_back('=');
-    return out;
+    if (!first)
+        out += ',';
+    out += "{\"id\":";
+    out += std::to_string(id);
+    out += ",\"metadata\":\"";
+    appendJsonEscaped(out, metadata);
+    out += "\",\"payload\":\"";
+    util::base64::append(out, payload.data(), payload.size());
+    out += "\"}";
+}
+
+bool HttpQueryServer::recordBody(int64_t id, std::shared_ptr<const std::string>& body) {
+    Metrics& metrics = Metrics::get();
+    // Read the generation first: a commit racing with this read makes the entry stale
+    const uint64_t generation = m_cacheGeneration.load();
+    CachedRecord cached;
+    if (m_recordCache.get(id, cached) && cached.generation == generation) {
+        ++m_cacheHits;
+        metrics.cacheHits.inc();
+        body = cached.body;
+        return true;
+    }
+    ++m_cacheMisses;
+    metrics.cacheMisses.inc();
+
+    std::string meta;
+    std::vector<uint8_t> payload;
+    size_t shard = 0;
+    int64_t rowId = 0;
+    if (!locate(id, shard, rowId))
+        return false;
+    {
+        SqliteReadPool::Lease conn = m_shards[shard]->pool.Acquire();
+        if (!conn || !conn->record)
+            return false;
+        SqliteReadPool::Connection* raw = conn.operator->();
+        if (!readRecord(raw, rowId, meta, payload,
+                        [this, raw](uint32_t dictId) { return cachedDictionary(raw, dictId); }))
+            return false;
+    }
+
+    std::string json;
+    json.reserve(meta.size() + util::base64::encodedSize(payload.size()) + 32);
+    json += "{\"metadata\":\"";
+    appendJsonEscaped(json, meta);
+    json += "\",\"payload\":\"";
+    util::base64::append(json, payload.data(), payload.size());
+    json += "\"}";
+    body = std::make_shared<const std::string>(std::move(json));
+    m_recordCache.put(id, CachedRecord{generation, body});
+    return true;
+}
+
+HttpQueryServer::DictionaryPtr HttpQueryServer::cachedDictionary(SqliteReadPool::Connection* conn,
+                                                                 uint32_t id) {
+    {
+        std::lock_guard<std::mutex> lock(m_dictionaryMutex);
+        auto it = m_dictionaries.find(id);
+        if (it != m_dictionaries.end())
+            return it->second;
+    }
+    DictionaryPtr dict = loadDictionary(conn->dictionary, id);
+    if (dict) {
+        std::lock_guard<std::mutex> lock(m_dictionaryMutex);
+        m_dictionaries.emplace(id, dict);
+    }
+    return dict;
+}
+
+int HttpQueryServer::countDocuments(Shard& shard) {
+    SqliteReadPool::Lease conn = shard.pool.Acquire();
+    if (!conn || !conn->count)
+        return -1;
+    int count = -1;
+    if (sqlite3_step(conn->count) == SQLITE_ROW)
+        count = sqlite3_column_int(conn->count, 0);
+    sqlite3_reset(conn->count);
+    return count;
+}
+
+std::string HttpQueryServer::RenderMetrics() {
+    static util::metrics::Gauge& documents = util::metrics::Registry::getInstance().gauge(
+        "rxrevolt_snapshot_documents", "Rows in the documents table of the served snapshot.");
+    {
+        std::lock_guard<std::mutex> lock(m_countMutex);
+        bool changed = false;
+        int total = 0;
+        for (const auto& shard : m_shards) {
+            struct stat st;
+            if (stat(shard->path.c_str(), &st) == 0 &&
+                (st.st_size != shard->countedSize || st.st_mtime != shard->countedMtime)) {
+                const int count = countDocuments(*shard);
+                shard->countedSize = st.st_size;
+                shard->countedMtime = st.st_mtime;
+                shard->count = count >= 0 ? count : 0;
+                changed = true;
+            }
+            total += shard->count;
+        }
+        if (changed)
+            documents.set(total);
+    }
+    return util::metrics::Registry::getInstance().renderPrometheus();
+}
+
+// -----------------------------------------------------------------------------
+// Responses
+// -----------------------------------------------------------------------------
+
+bool HttpQueryServer::sendStatus(int fd, int status, const char* reason, bool keepAlive) {
+    return sendResponse(fd, (std::to_string(status) + " " + reason).c_str(), "text/plain",
+                        reason, keepAlive);
+}
+
+bool HttpQueryServer::sendResponse(int fd, const char* status, const std::string& type,
+                                   const std::string& body, bool keepAlive) {
+    std::string head;
+    head.reserve(128);
+    head += "HTTP/1.1 ";
+    head += status;
+    head += "\r\nContent-Type: ";
+    head += type;
+    head += "\r\nContent-Length: ";
+    head += std::to_string(body.size());
+    head += keepAlive ? "\r\nConnection: keep-alive\r\n\r\n" : "\r\nConnection: close\r\n\r\n";
+    return sendAll(fd, head, body);
+}
+
+bool HttpQueryServer::sendAll(int fd, const std::string& head, const std::string& body) {
+    size_t sent = 0;
+    const size_t total = head.size() + body.size();
+    while (sent < total) {
+        iovec iov[2];
+        int count = 0;
+        if (sent < head.size()) {
+            iov[count].iov_base = const_cast<char*>(head.data() + sent);
+            iov[count++].iov_len = head.size() - sent;
+        }
+        const size_t bodySent = sent > head.size() ? sent - head.size() : 0;
+        if (bodySent < body.size()) {
+            iov[count].iov_base = const_cast<char*>(body.data() + bodySent);
+            iov[count++].iov_len = body.size() - bodySent;
+        }
+        msghdr msg{};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = count;
+        const ssize_t n = sendmsg(fd, &msg, MSG_NOSIGNAL);
+        if (n > 0) {
+            sent += static_cast<size_t>(n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            pollfd pfd{fd, POLLOUT, 0};
+            if (poll(&pfd, 1, SEND_TIMEOUT_MS) > 0 && !(pfd.revents & (POLLERR | POLLHUP)))
+                continue;
+        }
+        return false;
+    }
+    return true;
+}
+
+void HttpQueryServer::appendJsonEscaped(std::string& out, const std::string& text) {
+    static const char hex[] = "0123456789abcdef";
+    out.reserve(out.size() + text.size());
+    for (unsigned char c : text) {
+        switch (c) {
+        case '"':
+            out += "\\\"";
+            break;
+        case '\\':
+            out += "\\\\";
+            break;
+        case '\n':
+            out += "\\n";
+            break;
+        case '\r':
+            out += "\\r";
+            break;
+        case '\t':
+            out += "\\t";
+            break;
+        default:
+            if (c < 0x20) {
+                out += "\\u00";
+                out += hex[c >> 4];
+                out += hex[c & 0xF];
+            } else {
+                out += static_cast<char>(c);
+            }
+        }
+    }
 }
 
 } // namespace network
@@ -1,14 +1,27 @@
 #ifndef RXREVOLTCHAIN_HTTP_QUERY_SERVER_HPP
 #define RXREVOLTCHAIN_HTTP_QUERY_SERVER_HPP
 
+#include "event_loop.hpp"
+#include "sqlite_read_pool.hpp"
+#include "util/base64.hpp"
+#include "util/compression.hpp"
+#include "util/lru_cache.hpp"
+#include "util/metrics.hpp"
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <netinet/in.h>
 #include <sqlite3.h>
 #include <string>
 #include <sys/socket.h>
+#include <sys/stat.h>
 #include <thread>
 #include <unistd.h>
+#include <unordered_map>
 #include <vector>
 
 namespace rxrevoltchain {
@@ -17,41 +30,154 @@ namespace network {
 /*
   HttpQueryServer
   --------------------------------------------------------
-  A minimal read-only HTTP server exposing a couple of
+  A small read-only HTTP/1.1 server exposing a couple of
   endpoints for querying the pinned SQLite database.
 
   Endpoints:
-    GET /metrics        -> JSON document count
-    GET /record/<id>    -> JSON metadata and base64 payload
+    GET /metrics        -> every util::metrics series in Prometheus text format, plus
+                           rxrevolt_snapshot_documents (rows in the served database;
+                           only recounted when the file's size or mtime changes)
+    GET /record/<id>    -> JSON metadata and base64 payload (decompressed with the
+                           row's codec, see util::compression)
+    GET /records?from=&to=&limit=
+                        -> JSON array of {"id","metadata","payload"} for ids in
+                           [from, to] in id order, at most 'limit' (default
+                           DEFAULT_RECORDS_LIMIT, capped at MAX_RECORDS_LIMIT)
+    POST /records       -> the same array for a JSON array of ids in the body
+                           (at most MAX_BATCH_IDS), in request order; missing ids
+                           are left out
+    GET /costs?procedure=&provider=&region=&min_price=&max_price=&q=&limit=
+                        -> JSON array of cost items {"id","procedure_code",
+                           "description","provider","region","price","metadata"}
+                           matching every given filter, cheapest first (unpriced
+                           items last); 'q' restricts to documents matching an FTS5
+                           query. At most 'limit' (default DEFAULT_QUERY_LIMIT,
+                           capped at MAX_QUERY_LIMIT)
+    GET /search?q=&limit=
+                        -> JSON array of {"id","metadata"} for documents matching
+                           the FTS5 query 'q', best match first
 
-  This implementation is intentionally simple and should
-  not be used as a production-grade HTTP server.  It is
-  sufficient for basic testing and local usage.
+  /costs and /search are answered from the index tables DailySnapshot maintains at merge
+  time (see core::DocumentIndex), never by decompressing payloads. Query values are
+  URL-decoded; an invalid FTS5 query is a 400, a snapshot without the index a 503.
+
+  Raw mode (?raw=1) skips JSON and base64: /record/<id> answers with the payload bytes
+  (application/octet-stream), /records with RECORDS_RAW_TYPE frames, one per record, of
+  u64 id, u32 metadata length, u32 payload length (all little-endian), metadata, payload.
+
+  /records responses are streamed with chunked transfer encoding (HTTP/1.0 clients get
+  the body up to connection close) in chunks of STREAM_CHUNK_BYTES. Ranges are read in
+  pages of STREAM_PAGE_ROWS rows and the statement is reset before each page is sent, so
+  a slow client never holds a read transaction open against the merge's checkpoint.
+
+  Concurrency:
+   - One EventLoop thread owns the listening socket and every idle connection. Sockets are
+     armed EPOLLONESHOT, so a readable connection is handed to exactly one of
+     SetWorkerThreads() workers, which reads, answers every complete (pipelined) request
+     in its buffer and re-arms it.
+   - Connections are kept alive (HTTP/1.1 unless "Connection: close"; HTTP/1.0 only with
+     "Connection: keep-alive") and closed after SetKeepAliveTimeout() without a request.
+     Request headers are capped at MAX_HEADER_BYTES and bodies at MAX_BODY_BYTES.
+   - Records are read through a SqliteReadPool of read-only connections (one per worker)
+     with their statements prepared once.
+
+  Record cache:
+   - Encoded /record/<id> bodies are kept in an LRU of SetRecordCacheSize() entries, each
+     tagged with the cache generation it was read under. InvalidateCache() bumps the
+     generation and clears the cache, so a response read before a commit is never served
+     after it.
+   - PinnerNode::SetQueryServer() hooks InvalidateCache() to the scheduler's merges
+     (DailyScheduler::SetCommitListener, forwarded to each DailySnapshot or shard). Commits
+     from other processes are picked up as well: a watcher polls PRAGMA data_version every
+     WATCH_INTERVAL, and a replaced file (new inode) or a schema change also reopens the pool.
+
+  Sharded snapshots (core::ShardedSnapshot):
+   - Constructed with the shard files, the server keeps a read pool and a watcher per shard.
+     Ids are shard-major, GlobalId(shard, rowId) = shard << SHARD_ID_BITS | rowId, so shard
+     0 (and a single database) keeps its row ids and every id stays below 2^53.
+   - /record/<id> and POST /records go to the shard the id names. A /records range walks
+     the shards it covers in order, which is id order.
+   - /search and /costs ask every shard for 'limit' rows and merge them: /costs by price
+     and id exactly as one database would, /search by each shard's FTS5 rank (bm25 scored
+     with that shard's statistics, so ranks across shards are comparable, not identical).
+   - rxrevolt_snapshot_documents is the sum over the shards.
+
+  This is not meant to face the internet directly (no TLS, no auth); put it behind a
+  reverse proxy for anything beyond local dashboards and auditors.
 */
 class HttpQueryServer {
   public:
+    static constexpr size_t DEFAULT_WORKER_THREADS = 4;
+    static constexpr size_t DEFAULT_RECORD_CACHE = 1024;
+    static constexpr int DEFAULT_KEEP_ALIVE_MS = 5000;
+    static constexpr size_t MAX_HEADER_BYTES = 8 * 1024;
+    static constexpr size_t MAX_BODY_BYTES = 64 * 1024;
+    static constexpr size_t MAX_CONNECTIONS = 1024;
+    static constexpr std::chrono::milliseconds WATCH_INTERVAL{100};
+    static constexpr int64_t DEFAULT_RECORDS_LIMIT = 1000;
+    static constexpr int64_t MAX_RECORDS_LIMIT = 100000;
+    static constexpr size_t MAX_BATCH_IDS = 10000;
+    static constexpr int64_t DEFAULT_QUERY_LIMIT = 100;
+    static constexpr int64_t MAX_QUERY_LIMIT = 1000;
+    static constexpr size_t STREAM_CHUNK_BYTES = 64 * 1024;
+    static constexpr int STREAM_PAGE_ROWS = 256;
+    static constexpr const char* RECORDS_RAW_TYPE = "application/x-rxrevolt-records";
+    static constexpr int SHARD_ID_BITS = 40;
+    static constexpr int64_t SHARD_ROW_MASK = (int64_t(1) << SHARD_ID_BITS) - 1;
+
     HttpQueryServer(const std::string& dbPath, int port = 8080)
-        : m_dbPath(dbPath), m_port(port), m_running(false) {}
+        : HttpQueryServer(std::vector<std::string>{dbPath}, port) {}
+
+    /** Serves a sharded snapshot: 'shardPaths' (at least one) in shard order. */
+    HttpQueryServer(const std::vector<std::string>& shardPaths, int port = 8080)
+        : m_port(port), m_running(false), m_recordCache(DEFAULT_RECORD_CACHE) {
+        for (const std::string& path : shardPaths)
+            m_shards.emplace_back(new Shard(path));
+    }
+
+    HttpQueryServer(const HttpQueryServer&) = delete;
+    HttpQueryServer& operator=(const HttpQueryServer&) = delete;
 
     ~HttpQueryServer() { Stop(); }
 
-    bool Start() {
-        if (m_running.load())
-            return false;
-        m_running = true;
-        m_thread = std::thread([this]() { run(); });
-        return true;
+    /**
+     * Binds the port (0 picks an ephemeral one, see Port()) and starts serving.
+     * @return false if already running or the socket cannot be bound.
+     */
+    bool Start();
+
+    /** Closes the listener and every connection and joins all threads. */
+    void Stop();
+
+    bool IsRunning() const { return m_running.load(); }
+
+    /** Port actually bound by Start(). */
+    int Port() const { return m_boundPort.load(); }
+
+    // Settings below take effect on the next Start()
+    void SetWorkerThreads(size_t threads) { m_workerCount = threads ? threads : 1; }
+    void SetKeepAliveTimeout(int milliseconds) { m_keepAliveMs = milliseconds; }
+    void SetRecordCacheSize(size_t entries) { m_recordCache.setCapacity(entries); }
+
+    /** Drops every cached /record response; call after the snapshot commits. */
+    void InvalidateCache() {
+        m_cacheGeneration.fetch_add(1);
+        m_recordCache.clear();
     }
 
-    void Stop() {
-        if (!m_running.load())
-            return;
-        m_running = false;
-        if (m_thread.joinable())
-            m_thread.join();
+    /** Id the query endpoints use for row 'rowId' of shard 'shard'. */
+    static int64_t GlobalId(size_t shard, int64_t rowId) {
+        return (static_cast<int64_t>(shard) << SHARD_ID_BITS) | rowId;
     }
 
-    bool IsRunning() const { return m_running.load(); }
+    uint64_t RecordCacheHits() const { return m_cacheHits.load(); }
+    uint64_t RecordCacheMisses() const { return m_cacheMisses.load(); }
+
+    /**
+     * Body of GET /metrics. Refreshes the document count gauge first if the database
+     * changed since the last scrape.
+     */
+    std::string RenderMetrics();
 
     // Public utility for testing: returns total document count
     static int GetDocumentCount(const std::string& path) {
@@ -74,19 +200,213 @@ class HttpQueryServer {
         return count;
     }
 
+    /**
+     * Public utility for testing: loads one record and decompresses its payload according
+     * to the row's codec. zstd frames that reference a dictionary are decoded with the
+     * matching row of the snapshot's dictionaries table. Snapshots that predate the codec
+     * column are read as zlib.
+     * @return false if the record does not exist or its payload cannot be decompressed.
+     */
+    static bool LoadRecord(const std::string& path, int id, std::string& metadata,
+                           std::vector<uint8_t>& payload) {
+        SqliteReadPool pool(path, 1);
+        SqliteReadPool::Lease conn = pool.Acquire();
+        if (!conn || !conn->record) {
+            return false;
+        }
+        auto dictionary = [&conn](uint32_t dictId) {
+            return loadDictionary(conn->dictionary, dictId);
+        };
+        return readRecord(conn.operator->(), id, metadata, payload, dictionary);
+    }
+
   private:
-    void run();
-    void handleClient(int fd);
-    void handleMetrics(int fd);
-    void handleRecord(int fd, int id);
-    void send200(int fd, const std::string& body, const std::string& type = "application/json");
-    void send404(int fd);
-    static std::string b64Encode(const std::vector<unsigned char>& data);
-
-    std::string m_dbPath;
+    using DictionaryPtr = std::shared_ptr<util::compression::Dictionary>;
+
+    struct CachedRecord {
+        uint64_t generation = 0;
+        std::shared_ptr<const std::string> body;
+    };
+
+    // A keep-alive connection. 'busy' and 'lastActive' are guarded by m_connMutex; 'input'
+    // is only touched by the worker currently serving the connection.
+    struct Connection {
+        int fd = -1;
+        bool busy = false;
+        std::chrono::steady_clock::time_point lastActive;
+        std::string input;
+    };
+
+    // One database served; a sharded snapshot has several (see GlobalId)
+    struct Shard {
+        explicit Shard(const std::string& file) : path(file), pool(file, DEFAULT_WORKER_THREADS) {}
+
+        std::string path;
+        SqliteReadPool pool;
+        // Watcher state, ticker thread only
+        sqlite3* watchDb = nullptr;
+        sqlite3_stmt* dataVersionStmt = nullptr;
+        sqlite3_stmt* schemaVersionStmt = nullptr;
+        dev_t watchDev = 0;
+        ino_t watchIno = 0;
+        int64_t dataVersion = -1;
+        int64_t schemaVersion = -1;
+        // File state the shard's row count was last computed for (m_countMutex)
+        off_t countedSize = -1;
+        time_t countedMtime = 0;
+        int count = 0;
+    };
+
+    struct Request {
+        std::string method;
+        std::string target;
+        std::string body;
+        bool http10 = false;
+        bool keepAlive = false;
+    };
+
+    class ChunkedWriter;
+
+    enum class ParseResult { Incomplete, Ok, Malformed, HeaderTooLarge, BodyTooLarge };
+
+    // Decodes the current row of 'stmt' from column 'first' on (metadata, payload, codec),
+    // decompressing the payload. 'dictionary' resolves the zstd dictionary ID of a frame.
+    template <typename DictionaryLookup>
+    static bool decodeRow(sqlite3_stmt* stmt, int first, std::string& metadata,
+                          std::vector<uint8_t>& payload, DictionaryLookup&& dictionary) {
+        using namespace rxrevoltchain::util::compression;
+        const unsigned char* meta = sqlite3_column_text(stmt, first);
+        metadata = meta ? reinterpret_cast<const char*>(meta) : "";
+        const uint8_t* blob = static_cast<const uint8_t*>(sqlite3_column_blob(stmt, first + 1));
+        const size_t len = static_cast<size_t>(sqlite3_column_bytes(stmt, first + 1));
+        const Codec codec = static_cast<Codec>(sqlite3_column_int(stmt, first + 2));
+
+        DictionaryPtr dict;
+        const uint32_t dictId = codec == Codec::Zstd ? frameDictionaryId(blob, len) : 0;
+        if (dictId != 0) {
+            dict = dictionary(dictId);
+        }
+        return decompress(codec, blob, len, payload, MAX_PAYLOAD_BYTES, dict.get());
+    }
+
+    // Reads one record with the connection's prepared statement.
+    template <typename DictionaryLookup>
+    static bool readRecord(SqliteReadPool::Connection* conn, int64_t id, std::string& metadata,
+                           std::vector<uint8_t>& payload, DictionaryLookup&& dictionary) {
+        sqlite3_stmt* record = conn->record;
+        sqlite3_reset(record);
+        sqlite3_bind_int64(record, 1, static_cast<sqlite3_int64>(id));
+        const bool ok = sqlite3_step(record) == SQLITE_ROW &&
+                        decodeRow(record, 0, metadata, payload, dictionary);
+        // End the read transaction so the connection sees later commits
+        sqlite3_reset(record);
+        return ok;
+    }
+
+    static DictionaryPtr loadDictionary(sqlite3_stmt* stmt, uint32_t id) {
+        DictionaryPtr dict;
+        if (!stmt) {
+            return dict;
+        }
+        sqlite3_reset(stmt);
+        sqlite3_bind_int64(stmt, 1, static_cast<sqlite3_int64>(id));
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            const uint8_t* data = static_cast<const uint8_t*>(sqlite3_column_blob(stmt, 0));
+            const int size = sqlite3_column_bytes(stmt, 0);
+            dict = util::compression::Dictionary::FromBytes(
+                std::vector<uint8_t>(data, data + size));
+        }
+        sqlite3_reset(stmt);
+        return dict;
+    }
+
+    // Connection lifecycle (EventLoop thread and workers)
+    void acceptConnections();
+    void dispatch(int fd);
+    void workerLoop();
+    void serve(const std::shared_ptr<Connection>& conn);
+    bool readAvailable(Connection& conn);
+    void closeConnectionLocked(int fd);
+    void closeIdleConnections();
+
+    // Database watch (ticker thread)
+    void tickerLoop();
+    void watchDatabase();
+    void watchShard(Shard& shard);
+    static void closeWatcher(Shard& shard);
+
+    // Request handling
+    static ParseResult parseRequest(std::string& buffer, Request& request);
+    bool respond(int fd, const Request& request, bool keepAlive);
+    bool respondRecord(int fd, int64_t id, bool raw, bool keepAlive);
+    bool locate(int64_t id, size_t& shard, int64_t& rowId) const;
+    bool streamRange(int fd, const Request& request, bool raw, bool keepAlive);
+    bool streamRows(ChunkedWriter& writer, size_t shard, SqliteReadPool::Connection* db,
+                    int64_t from, int64_t to, int64_t limit, int64_t& sent, bool raw);
+    bool streamBatch(int fd, const Request& request, bool raw, bool keepAlive);
+    bool respondCosts(int fd, const Request& request, bool keepAlive);
+    bool respondSearch(int fd, const Request& request, bool keepAlive);
+    static void appendRecord(std::string& out, int64_t id, const std::string& metadata,
+                             const std::vector<uint8_t>& payload, bool raw, bool first);
+    bool recordBody(int64_t id, std::shared_ptr<const std::string>& body);
+    DictionaryPtr cachedDictionary(SqliteReadPool::Connection* conn, uint32_t id);
+    static int countDocuments(Shard& shard);
+    static bool sendStatus(int fd, int status, const char* reason, bool keepAlive);
+    static bool sendResponse(int fd, const char* status, const std::string& type,
+                             const std::string& body, bool keepAlive);
+    static bool sendAll(int fd, const std::string& head, const std::string& body);
+    static void appendJsonEscaped(std::string& out, const std::string& text);
+
+    // Shared by every HttpQueryServer instance
+    struct Metrics {
+        util::metrics::Counter& requests;
+        util::metrics::Counter& cacheHits;
+        util::metrics::Counter& cacheMisses;
+        util::metrics::Gauge& connections;
+
+        static Metrics& get() {
+            auto& registry = util::metrics::Registry::getInstance();
+            static Metrics metrics{
+                registry.counter("rxrevolt_http_requests_total", "HTTP requests answered."),
+                registry.counter("rxrevolt_http_record_cache_hits_total",
+                                 "GET /record responses served from the LRU cache."),
+                registry.counter("rxrevolt_http_record_cache_misses_total",
+                                 "GET /record responses read from the database."),
+                registry.gauge("rxrevolt_http_open_connections",
+                               "Open HTTP client connections.")};
+            return metrics;
+        }
+    };
+
+    std::vector<std::unique_ptr<Shard>> m_shards;
     int m_port;
     std::atomic_bool m_running;
-    std::thread m_thread;
+    std::atomic<int> m_boundPort{0};
+    int m_listenFd = -1;
+    size_t m_workerCount = DEFAULT_WORKER_THREADS;
+    int m_keepAliveMs = DEFAULT_KEEP_ALIVE_MS;
+
+    EventLoop m_loop;
+    std::vector<std::thread> m_workers;
+    std::mutex m_workMutex; // guards m_ready
+    std::condition_variable m_workReady;
+    std::deque<std::shared_ptr<Connection>> m_ready;
+
+    std::mutex m_connMutex; // guards m_connections and Connection::busy/lastActive
+    std::unordered_map<int, std::shared_ptr<Connection>> m_connections;
+
+    util::LruCache<int64_t, CachedRecord> m_recordCache;
+    std::atomic<uint64_t> m_cacheGeneration{0};
+    std::atomic<uint64_t> m_cacheHits{0};
+    std::atomic<uint64_t> m_cacheMisses{0};
+    std::mutex m_dictionaryMutex; // guards m_dictionaries
+    std::unordered_map<uint32_t, DictionaryPtr> m_dictionaries;
+
+    std::thread m_ticker;
+    std::mutex m_tickMutex;
+    std::condition_variable m_tickWake;
+
+    std::mutex m_countMutex; // guards the Shard count fields
 };
 
 } // namespace network
@@ -3,14 +3,19 @@
 
 #include <algorithm>
 #include <atomic>
+#include <cerrno>
+#include <chrono>
 #include <condition_variable>
 #include <cstring>
+#include <deque>
 #include <functional>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <stdexcept>
 #include <string>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 #ifdef _WIN32
@@ -30,6 +35,7 @@ inline bool initWinsock() {
 }
 #else
 #include <arpa/inet.h>
+#include <fcntl.h>
 #include <netinet/in.h>
 #include <sys/socket.h>
 #include <sys/types.h>
@@ -38,7 +44,9 @@ inline bool initWinsock() { return true; }
 static void closesocket(int sock) { ::close(sock); }
 #endif
 
+#include "event_loop.hpp"
 #include "logger.hpp"
+#include "metrics.hpp"
 #include "protocol_messages.hpp"
 
 namespace rxrevoltchain {
@@ -57,23 +65,64 @@ namespace network {
     bool BroadcastMessage(const ProtocolMessage &msg)
     void OnMessageReceived(const ProtocolMessage &msg)
 
-  "Fully functional" approach:
-  - We use blocking TCP sockets in a simple form to demonstrate P2P.
-  - A background thread listens on (bindAddress:port).
-  - For each incoming connection, we spawn a thread to read messages in a simple loop.
-  - We store each "peer" in a vector, so we can broadcast to them.
-  - On reading a message, we parse it into a ProtocolMessage and call OnMessageReceived.
-  - For actual production usage, consider advanced concurrency or a robust networking library
-    (e.g., Boost.Asio), message framing, encryption, etc. This demonstration is minimal.
+  Reactor transport:
+  - All sockets are non-blocking and multiplexed with epoll on a small, fixed number of
+    I/O threads (SetIoThreads(), default DEFAULT_IO_THREADS), one EventLoop each. Thread
+    count no longer grows with the number of peers.
+  - The listening socket lives on the first loop; accepted and outbound connections are
+    assigned to the loops round-robin. Inbound connections beyond SetMaxConnections()
+    are closed right after accept.
+  - Each peer keeps a receive buffer; frames are reassembled from whatever recv() returns,
+    so messages split across (or packed into) TCP segments are handled.
+  - Wire framing is unchanged: [u32 BE type length][type][u32 BE payload length][payload],
+    with the same 1000-byte type / 10 MiB payload limits.
+  - OnMessageReceived() runs on the I/O thread that read the frame, without m_mutex held.
+    Each message carries the peerId of its connection; SendToPeer() answers just that peer.
+    Peer ids are never reused, unlike socket descriptors.
+  - Snapshot sync transfers (SNAPSHOT_MANIFEST*, SNAPSHOT_CHUNK*) are passed to the
+    callback but not kept in GetMessages(), so bulk data does not pile up there.
+
+  Outbound queues:
+  - BroadcastMessage() serializes a message once into shared, reference-counted bytes and
+    appends the same buffer to every peer's outbound queue; nothing is copied per peer.
+    m_mutex is only held long enough to snapshot the peer list.
+  - A queue is written straight away when it was empty (one non-blocking send); whatever
+    the socket does not take is finished by the peer's I/O thread on EPOLLOUT.
+  - SetMaxPeerQueueBytes() is a soft limit: a burst may go over it. A peer is disconnected
+    and counted in SlowPeerCount() once it has stayed over the limit for longer than
+    SetSlowPeerGrace() (checked as frames are queued), or at once when its backlog would
+    pass HARD_LIMIT_FACTOR times the limit, so one stalled peer never holds up the others
+    and its memory stays bounded.
+  - Sockets are only closed on their I/O thread (or after the loops have stopped), so a
+    concurrent broadcast never touches a reused descriptor.
+
+  Metrics (util::metrics): bytes received and sent on peer sockets, and each connected
+  peer's unsent queue (rxrevolt_p2p_peer_queue_bytes), read when the registry is scraped.
 */
 
 class P2PNode {
   public:
+    static constexpr size_t DEFAULT_IO_THREADS = 2;
+    static constexpr size_t DEFAULT_MAX_PEER_QUEUE_BYTES = 16 * 1024 * 1024;
+    static constexpr size_t HARD_LIMIT_FACTOR = 4;
+    static constexpr int64_t DEFAULT_SLOW_PEER_GRACE_MS = 2000;
+
     // Default constructor
-    P2PNode() : m_listenSocket(-1), m_isRunning(false) { initWinsock(); }
+    P2PNode() : m_listenSocket(-1), m_isRunning(false) {
+        initWinsock();
+        m_queueCollector = util::metrics::Registry::getInstance().addCollector(
+            "rxrevolt_p2p_peer_queue_bytes", "Unsent bytes queued for each connected peer.",
+            [this](std::vector<util::metrics::Registry::Sample>& out) { collectQueues(out); });
+    }
 
     // Clean up if needed
-    ~P2PNode() { StopNetwork(); }
+    ~P2PNode() {
+        util::metrics::Registry::getInstance().removeCollector(m_queueCollector);
+        StopNetwork();
+    }
+
+    P2PNode(const P2PNode&) = delete;
+    P2PNode& operator=(const P2PNode&) = delete;
 
     /**
      * Set a callback that will be invoked whenever a message is received from
@@ -81,15 +130,65 @@ class P2PNode {
      * @param cb Callback taking a const ProtocolMessage&.
      */
     void SetMessageCallback(std::function<void(const ProtocolMessage&)> cb) {
-        std::lock_guard<std::mutex> lock(m_mutex);
+        std::lock_guard<std::mutex> lock(m_messageMutex);
         m_messageCallback = std::move(cb);
     }
 
+    /**
+     * Number of I/O threads serving all sockets; applies to the next StartNetwork().
+     */
+    void SetIoThreads(size_t threads) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_ioThreads = std::max<size_t>(1, threads);
+    }
+
+    /**
+     * Limit on connected peers (inbound + outbound, 0 = unlimited). Inbound connections
+     * beyond it are closed right away; outbound ConnectToPeer() calls are not refused.
+     */
+    void SetMaxConnections(size_t maxConnections) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_maxConnections = maxConnections;
+    }
+
+    /**
+     * Backpressure limit: bytes a peer may have queued but not yet accepted by its socket.
+     * A peer that stays over it for the slow-peer grace period, or whose backlog would pass
+     * HARD_LIMIT_FACTOR times it, is disconnected.
+     */
+    void SetMaxPeerQueueBytes(size_t bytes) { m_maxPeerQueueBytes = std::max<size_t>(1, bytes); }
+
+    /** How long a peer may stay over the queue limit before it is disconnected. */
+    void SetSlowPeerGrace(std::chrono::milliseconds grace) {
+        m_slowPeerGraceMs = std::max<int64_t>(0, grace.count());
+    }
+
+    /** Peers disconnected so far because their outbound queue hit the limit. */
+    uint64_t SlowPeerCount() const { return m_slowPeers.load(); }
+
+    /** Number of currently connected peers. */
+    size_t PeerCount() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_peers.size();
+    }
+
+    /** Ids of the currently connected peers, oldest connection first. */
+    std::vector<uint64_t> PeerIds() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::vector<uint64_t> ids;
+        ids.reserve(m_peersById.size());
+        for (const auto& entry : m_peersById) {
+            ids.push_back(entry.first);
+        }
+        std::sort(ids.begin(), ids.end());
+        return ids;
+    }
+
     /*
       bool StartNetwork(const std::string &bindAddress, uint16_t port)
       -----------------------------------------------------------------
-      - Opens a TCP socket on bindAddress:port
-      - Spawns a thread to accept incoming connections
+      - Opens a non-blocking TCP socket on bindAddress:port
+      - Starts the I/O threads; the first one accepts incoming connections
       - Returns true if successful
     */
     bool StartNetwork(const std::string& bindAddress, uint16_t port) {
@@ -129,15 +228,27 @@ class P2PNode {
         }
 
         // Listen
-        if (::listen(m_listenSocket, 5) < 0) {
+        if (::listen(m_listenSocket, SOMAXCONN) < 0 || !setNonBlocking(m_listenSocket)) {
             Logger::getInstance().error("[P2PNode] Failed to listen on socket.");
             closesocket(m_listenSocket);
             m_listenSocket = -1;
             return false;
         }
 
+        // Start the I/O threads
+        for (size_t i = 0; i < m_ioThreads; ++i) {
+            m_loops.emplace_back(new EventLoop());
+            if (!m_loops.back()->Start()) {
+                Logger::getInstance().error("[P2PNode] Failed to start I/O thread.");
+                m_loops.clear();
+                closesocket(m_listenSocket);
+                m_listenSocket = -1;
+                return false;
+            }
+        }
+
         m_isRunning = true;
-        m_acceptThread = std::thread(&P2PNode::acceptThreadRoutine, this);
+        m_loops.front()->Add(m_listenSocket, EPOLLIN, [this](uint32_t) { acceptReady(); });
 
         Logger::getInstance().info("[P2PNode] Started listening on " + bindAddress + ":" +
                                    std::to_string(port));
@@ -148,36 +259,44 @@ class P2PNode {
       bool StopNetwork()
       -----------------------------------------------------------------
       - Stops accepting new connections
+      - Joins the I/O threads
       - Closes existing peer connections
-      - Joins the accept thread
     */
     bool StopNetwork() {
         using namespace rxrevoltchain::util::logger;
-        std::lock_guard<std::mutex> lock(m_mutex);
-
-        if (!m_isRunning) {
-            Logger::getInstance().warn("[P2PNode] StopNetwork called but node is not running.");
-            return true;
+        std::vector<std::unique_ptr<EventLoop>> loops;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_isRunning) {
+                Logger::getInstance().warn(
+                    "[P2PNode] StopNetwork called but node is not running.");
+                return true;
+            }
+            m_isRunning = false;
+            loops.swap(m_loops);
         }
 
-        m_isRunning = false;
+        // Join the I/O threads without m_mutex: their handlers may need it to drop a peer
+        for (auto& loop : loops) {
+            loop->Stop();
+        }
 
-        // Close listening socket to break accept
+        std::lock_guard<std::mutex> lock(m_mutex);
         if (m_listenSocket >= 0) {
             closesocket(m_listenSocket);
             m_listenSocket = -1;
         }
 
-        // Join accept thread
-        if (m_acceptThread.joinable()) {
-            m_acceptThread.join();
-        }
-
-        // Close all peer sockets
-        for (auto& peer : m_peers) {
+        // Close all peer sockets; unsent queued frames are dropped
+        for (auto& entry : m_peers) {
+            Peer& peer = *entry.second;
+            std::lock_guard<std::mutex> sendLock(peer.sendMutex);
+            peer.closed = true;
+            peer.outbox.clear();
             closesocket(peer.sock);
         }
         m_peers.clear();
+        m_peersById.clear();
 
         Logger::getInstance().info("[P2PNode] Network stopped and all peer connections closed.");
         return true;
@@ -186,63 +305,68 @@ class P2PNode {
     /*
       bool BroadcastMessage(const ProtocolMessage &msg)
       -----------------------------------------------------------------
-      - Sends 'msg' to all connected peers
-      - Returns true if at least one peer was reached
-      - For demonstration, we do a naive length-prefix approach
-        to transmit ProtocolMessage over the socket.
+      - Queues 'msg' for all connected peers and returns without waiting for slow ones
+      - Returns true if it was queued for at least one peer
+      - The frame is the naive length-prefix encoding read by dispatchFrames().
     */
     bool BroadcastMessage(const ProtocolMessage& msg) {
         using namespace rxrevoltchain::util::logger;
-        std::lock_guard<std::mutex> lock(m_mutex);
-
-        if (!m_isRunning || m_peers.empty()) {
+        std::vector<std::shared_ptr<Peer>> peers;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_isRunning) {
+                peers.reserve(m_peers.size());
+                for (auto& entry : m_peers) {
+                    peers.push_back(entry.second);
+                }
+            }
+        }
+        if (peers.empty()) {
             Logger::getInstance().warn(
                 "[P2PNode] BroadcastMessage called but node not running or no peers.");
             return false;
         }
 
-        // Serialize ProtocolMessage:
-        // 1) type length (uint32_t), 2) type bytes,
-        // 3) payload length (uint32_t), 4) payload bytes
-        std::vector<uint8_t> buffer;
-        auto writeU32 = [&](uint32_t val) {
-            buffer.push_back((val >> 24) & 0xFF);
-            buffer.push_back((val >> 16) & 0xFF);
-            buffer.push_back((val >> 8) & 0xFF);
-            buffer.push_back(val & 0xFF);
-        };
-
-        writeU32((uint32_t)msg.type.size());
-        buffer.insert(buffer.end(), msg.type.begin(), msg.type.end());
-        writeU32((uint32_t)msg.payload.size());
-        buffer.insert(buffer.end(), msg.payload.begin(), msg.payload.end());
+        // Serialized once, shared by every peer's queue
+        const SharedBytes frame = serializeFrame(msg);
 
-        bool sentToAtLeastOne = false;
-        for (auto& peer : m_peers) {
-            if (peer.sock < 0)
-                continue;
-            ssize_t sent = ::send(peer.sock, (const char*)buffer.data(), (int)buffer.size(), 0);
-            if (sent == (ssize_t)buffer.size()) {
-                sentToAtLeastOne = true;
-            } else {
-                // Possibly log a warning or remove peer if send fails
-                Logger::getInstance().warn("[P2PNode] Broadcast send failed or partial for peer " +
-                                           peer.address);
+        size_t queued = 0;
+        for (const auto& peer : peers) {
+            if (enqueue(peer, frame)) {
+                ++queued;
             }
         }
 
-        if (!sentToAtLeastOne) {
+        if (queued == 0) {
             Logger::getInstance().warn("[P2PNode] BroadcastMessage failed to send to all peers.");
             return false;
         }
 
-        Logger::getInstance().info("[P2PNode] BroadcastMessage sent to " +
-                                   std::to_string(m_peers.size()) + " peers.");
+        Logger::getInstance().info([&] {
+            return "[P2PNode] BroadcastMessage queued for " + std::to_string(queued) + " peers.";
+        });
         return true;
     }
 
     /**
-     * Connect to a remote peer and start a receive thread if successful.
+     * Queue 'msg' for one peer only (e.g. a reply to a message from 'peerId').
+     * @return false if the peer is gone or was dropped for exceeding its queue limit.
+     */
+    bool SendToPeer(uint64_t peerId, const ProtocolMessage& msg) {
+        std::shared_ptr<Peer> peer;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_peersById.find(peerId);
+            if (!m_isRunning || it == m_peersById.end()) {
+                return false;
+            }
+            peer = it->second;
+        }
+        return enqueue(peer, serializeFrame(msg));
+    }
+
+    /**
+     * Connect to a remote peer and register it with an I/O thread if successful.
      * @param address IP address string of the peer
      * @param port Remote port
      * @return true on success
@@ -276,9 +400,10 @@ class P2PNode {
         }
 
         std::string addrStr = address + ":" + std::to_string(port);
-        m_peers.push_back(Peer{sock, addrStr});
-        m_peers.back().recvThread = std::thread(&P2PNode::peerReceiveRoutine, this,
-                                                m_peers.back().sock, m_peers.back().address);
+        if (!addPeer(sock, addrStr)) {
+            Logger::getInstance().error("[P2PNode] Failed to register peer " + addrStr);
+            return false;
+        }
 
         Logger::getInstance().info("[P2PNode] Connected to peer " + addrStr);
         return true;
@@ -297,15 +422,19 @@ class P2PNode {
         using rxrevoltchain::util::logger::Logger;
         Logger& logger = Logger::getInstance();
 
-        logger.info("[P2PNode] OnMessageReceived: type=" + msg.type +
-                    ", payloadLen=" + std::to_string(msg.payload.size()));
+        logger.info([&] {
+            return "[P2PNode] OnMessageReceived: type=" + msg.type +
+                   ", payloadLen=" + std::to_string(msg.payload.size());
+        });
 
         // Example: parse message types and handle them
         if (msg.type == "SNAPSHOT_ANNOUNCE") {
             // A node is announcing a new pinned .sqlite snapshot
             // We could store its CID in a local table, trigger validation, etc.
             logger.info("[P2PNode] Handling SNAPSHOT_ANNOUNCE message.");
-            // ... handle snapshot logic here ...
+            // The callback (PinnerNode) decides whether to fetch it via SnapshotSync
+        } else if (isBulkTransfer(msg.type)) {
+            // Snapshot sync traffic, handled by the callback's SnapshotSync
         } else if (msg.type == "POP_REQUEST") {
             // Another node is challenging us to prove we have pinned data.
             // We might need to read 'msg.payload' to get chunk offsets, then respond.
@@ -322,11 +451,18 @@ class P2PNode {
         }
 
         // Store the message for further processing
-        messages.push_back(msg);
+        std::function<void(const ProtocolMessage&)> callback;
+        {
+            std::lock_guard<std::mutex> lock(m_messageMutex);
+            if (!isBulkTransfer(msg.type)) {
+                messages.push_back(msg);
+            }
+            callback = m_messageCallback;
+        }
 
         // Invoke external callback if set
-        if (m_messageCallback) {
-            m_messageCallback(msg);
+        if (callback) {
+            callback(msg);
         }
     }
 
@@ -335,7 +471,7 @@ class P2PNode {
      * @return A vector of ProtocolMessage
      */
     std::vector<ProtocolMessage> GetMessages() const {
-        std::lock_guard<std::mutex> lock(m_mutex);
+        std::lock_guard<std::mutex> lock(m_messageMutex);
         return messages;
     }
 
@@ -343,28 +479,218 @@ class P2PNode {
     // Vector to hold messages from peers
     std::vector<ProtocolMessage> messages;
 
+    // Serialized frame shared by the queues of every peer it is broadcast to
+    using SharedBytes = std::shared_ptr<const std::vector<uint8_t>>;
+
     // Represents a connected peer
     struct Peer {
         int sock;
+        uint64_t id = 0; // never reused, unlike sock
         std::string address;
-        std::thread recvThread;
+        EventLoop* loop;
+        std::vector<uint8_t> inbox; // received bytes not yet framed (I/O thread only)
+
+        mutable std::mutex sendMutex; // guards the fields below
+        std::deque<SharedBytes> outbox;
+        size_t outOffset = 0;   // bytes of outbox.front() already sent
+        size_t queuedBytes = 0; // unsent bytes across outbox
+        bool overLimit = false;  // queuedBytes above the soft limit ...
+        std::chrono::steady_clock::time_point overLimitSince; // ... since then
+        bool writeArmed = false; // EPOLLOUT registered
+        bool closing = false;    // closePeerAsync() posted
+        bool closed = false;
+    };
+
+    static constexpr uint32_t PEER_EVENTS = EPOLLIN | EPOLLRDHUP;
+
+    // Shared by every P2PNode instance
+    struct Metrics {
+        util::metrics::Counter& received;
+        util::metrics::Counter& sent;
+
+        static Metrics& get() {
+            using util::metrics::Registry;
+            static Metrics metrics{
+                Registry::getInstance().counter("rxrevolt_p2p_received_bytes_total",
+                                                "Bytes read from peer sockets."),
+                Registry::getInstance().counter("rxrevolt_p2p_sent_bytes_total",
+                                                "Bytes written to peer sockets.")};
+            return metrics;
+        }
     };
 
-    // Accept incoming connections in a loop
-    void acceptThreadRoutine() {
+    // Scrape-time samples of every peer's outbound queue
+    void collectQueues(std::vector<util::metrics::Registry::Sample>& out) const {
+        using util::metrics::Registry;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (const auto& entry : m_peersById) {
+            const Peer& peer = *entry.second;
+            std::lock_guard<std::mutex> sendLock(peer.sendMutex);
+            out.emplace_back(Registry::label("peer", peer.address) + "," +
+                                 Registry::label("id", std::to_string(peer.id)),
+                             static_cast<double>(peer.queuedBytes));
+        }
+    }
+
+    static constexpr uint32_t MAX_TYPE_LEN = 1000;
+    static constexpr uint32_t MAX_PAYLOAD_LEN = 10 * 1024 * 1024;
+    static constexpr size_t RECV_CHUNK = 64 * 1024;
+
+    // Snapshot sync types; too large and too many to keep in 'messages'
+    static bool isBulkTransfer(const std::string& type) {
+        return type == SNAPSHOT_MANIFEST_REQUEST || type == SNAPSHOT_MANIFEST ||
+               type == SNAPSHOT_CHUNK_REQUEST || type == SNAPSHOT_CHUNK_RESPONSE;
+    }
+
+    // Frame layout read by dispatchFrames():
+    // 1) type length (uint32_t), 2) type bytes,
+    // 3) payload length (uint32_t), 4) payload bytes
+    static SharedBytes serializeFrame(const ProtocolMessage& msg) {
+        auto buffer = std::make_shared<std::vector<uint8_t>>();
+        buffer->reserve(8 + msg.type.size() + msg.payload.size());
+        auto writeU32 = [&](uint32_t val) {
+            buffer->push_back((val >> 24) & 0xFF);
+            buffer->push_back((val >> 16) & 0xFF);
+            buffer->push_back((val >> 8) & 0xFF);
+            buffer->push_back(val & 0xFF);
+        };
+
+        writeU32((uint32_t)msg.type.size());
+        buffer->insert(buffer->end(), msg.type.begin(), msg.type.end());
+        writeU32((uint32_t)msg.payload.size());
+        buffer->insert(buffer->end(), msg.payload.begin(), msg.payload.end());
+        return buffer;
+    }
+
+    static bool setNonBlocking(int sock) {
+        int flags = ::fcntl(sock, F_GETFL, 0);
+        return flags >= 0 && ::fcntl(sock, F_SETFL, flags | O_NONBLOCK) == 0;
+    }
+
+    // Appends a frame to the peer's queue and starts writing it. Returns false if the peer
+    // is gone or was disconnected for exceeding the queue limit. Any thread.
+    bool enqueue(const std::shared_ptr<Peer>& peer, const SharedBytes& frame) {
+        bool slow = false;
+        bool failed = false;
+        {
+            std::lock_guard<std::mutex> lock(peer->sendMutex);
+            if (peer->closed || peer->closing) {
+                return false;
+            }
+            const size_t limit = m_maxPeerQueueBytes;
+            const auto grace = std::chrono::milliseconds(m_slowPeerGraceMs.load());
+            if (peer->queuedBytes + frame->size() > limit * HARD_LIMIT_FACTOR ||
+                (peer->overLimit &&
+                 std::chrono::steady_clock::now() - peer->overLimitSince > grace)) {
+                slow = true;
+            } else {
+                const bool wasIdle = peer->outbox.empty();
+                peer->outbox.push_back(frame);
+                peer->queuedBytes += frame->size();
+                // Only the first frame of an idle queue is written from here; otherwise the
+                // I/O thread is already draining it
+                failed = wasIdle && !flushLocked(*peer);
+                trackBacklog(*peer);
+            }
+            if (slow || failed) {
+                // Posted under sendMutex: while the peer is not closed its loop is alive
+                peer->closing = true;
+                closePeerAsync(peer);
+            }
+        }
+        if (slow) {
+            ++m_slowPeers;
+            rxrevoltchain::util::logger::Logger::getInstance().warn(
+                "[P2PNode] Outbound queue limit exceeded, disconnecting slow peer " +
+                peer->address);
+        }
+        return !(slow || failed);
+    }
+
+    // Writes queued frames until the socket would block; arms or disarms EPOLLOUT to match.
+    // Returns false on a socket error. Caller holds peer.sendMutex.
+    bool flushLocked(Peer& peer) {
+        while (!peer.outbox.empty()) {
+            const std::vector<uint8_t>& front = *peer.outbox.front();
+            ssize_t sent = ::send(peer.sock, (const char*)front.data() + peer.outOffset,
+                                  front.size() - peer.outOffset, MSG_NOSIGNAL);
+            if (sent < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    break;
+                }
+                return false;
+            }
+            peer.outOffset += static_cast<size_t>(sent);
+            peer.queuedBytes -= static_cast<size_t>(sent);
+            Metrics::get().sent.inc(static_cast<uint64_t>(sent));
+            if (peer.outOffset == front.size()) {
+                peer.outbox.pop_front();
+                peer.outOffset = 0;
+            }
+        }
+        const bool wantWrite = !peer.outbox.empty();
+        if (wantWrite != peer.writeArmed) {
+            peer.writeArmed = wantWrite;
+            peer.loop->Modify(peer.sock, wantWrite ? (PEER_EVENTS | EPOLLOUT) : PEER_EVENTS);
+        }
+        trackBacklog(peer);
+        return true;
+    }
+
+    // Starts or ends the peer's time over the soft queue limit. Caller holds peer.sendMutex.
+    void trackBacklog(Peer& peer) const {
+        if (peer.queuedBytes <= m_maxPeerQueueBytes) {
+            peer.overLimit = false;
+        } else if (!peer.overLimit) {
+            peer.overLimit = true;
+            peer.overLimitSince = std::chrono::steady_clock::now();
+        }
+    }
+
+    // Makes 'sock' non-blocking and registers it with the next I/O thread (m_mutex held)
+    bool addPeer(int sock, const std::string& address) {
+        if (!setNonBlocking(sock) || m_loops.empty()) {
+            closesocket(sock);
+            return false;
+        }
+        auto peer = std::make_shared<Peer>();
+        peer->sock = sock;
+        peer->id = ++m_lastPeerId;
+        peer->address = address;
+        peer->loop = m_loops[m_nextLoop++ % m_loops.size()].get();
+        m_peers[sock] = peer;
+        m_peersById[peer->id] = peer;
+        if (!peer->loop->Add(sock, PEER_EVENTS,
+                             [this, peer](uint32_t events) { onPeerEvent(peer, events); })) {
+            m_peers.erase(sock);
+            m_peersById.erase(peer->id);
+            closesocket(sock);
+            return false;
+        }
+        return true;
+    }
+
+    // Accepts every pending connection on the (non-blocking) listening socket
+    void acceptReady() {
         using namespace rxrevoltchain::util::logger;
         Logger& logger = Logger::getInstance();
 
         while (m_isRunning) {
             sockaddr_in clientAddr;
             socklen_t clientLen = sizeof(clientAddr);
-            int clientSock = ::accept(m_listenSocket, (struct sockaddr*)&clientAddr, &clientLen);
+            int clientSock = ::accept4(m_listenSocket, (struct sockaddr*)&clientAddr, &clientLen,
+                                       SOCK_NONBLOCK | SOCK_CLOEXEC);
             if (clientSock < 0) {
-                // If we stopped, break
-                if (!m_isRunning)
-                    break;
-                logger.warn("[P2PNode] accept failed, continuing...");
-                continue;
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                    logger.warn("[P2PNode] accept failed, continuing...");
+                }
+                return;
             }
 
             // Convert IP to string
@@ -378,114 +704,164 @@ class P2PNode {
                 if (!m_isRunning) {
                     // Close immediately
                     closesocket(clientSock);
-                    break;
+                    return;
+                }
+                if (m_maxConnections && m_peers.size() >= m_maxConnections) {
+                    logger.warn("[P2PNode] Connection limit reached, rejecting " + addrStr);
+                    closesocket(clientSock);
+                    continue;
+                }
+                if (!addPeer(clientSock, addrStr)) {
+                    logger.warn("[P2PNode] Could not register connection from " + addrStr);
+                    continue;
                 }
-
-                // Add to peers
-                m_peers.push_back(Peer{clientSock, addrStr});
-                m_peers.back().recvThread =
-                    std::thread(&P2PNode::peerReceiveRoutine, this, m_peers.back().sock,
-                                m_peers.back().address);
             }
 
             logger.info("[P2PNode] Accepted new connection from: " + addrStr);
         }
     }
 
-    // Each peer has a thread that reads messages from the socket
-    void peerReceiveRoutine(int sock, std::string address) {
-        using namespace rxrevoltchain::util::logger;
-        Logger& logger = Logger::getInstance();
-
-        logger.info("[P2PNode] Starting recv thread for peer: " + address);
-
-        // We'll do a basic length-prefix approach:
-        // read: 4 bytes -> typeLen, read typeLen -> type,
-        // then 4 bytes -> payloadLen, read payloadLen -> payload
-        auto readExact = [&](void* buf, size_t len) -> bool {
-            uint8_t* p = (uint8_t*)buf;
-            size_t remain = len;
-            while (remain > 0 && m_isRunning) {
-                ssize_t ret = ::recv(sock, (char*)p, (int)remain, 0);
-                if (ret <= 0) {
-                    return false;
-                }
-                p += ret;
-                remain -= ret;
+    // I/O thread: continue queued writes, drain the socket into the peer's buffer and
+    // dispatch complete frames
+    void onPeerEvent(const std::shared_ptr<Peer>& peer, uint32_t events) {
+        bool open = true;
+        if (events & EPOLLOUT) {
+            std::lock_guard<std::mutex> lock(peer->sendMutex);
+            open = !peer->closed && flushLocked(*peer);
+        }
+        if (!open) {
+            closePeer(peer);
+            return;
+        }
+        if (!(events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))) {
+            return;
+        }
+        // Bounded number of reads per wakeup keeps one busy peer from starving the others
+        for (int i = 0; i < 16; ++i) {
+            const size_t have = peer->inbox.size();
+            peer->inbox.resize(have + RECV_CHUNK);
+            ssize_t ret = ::recv(peer->sock, (char*)peer->inbox.data() + have, RECV_CHUNK, 0);
+            peer->inbox.resize(have + (ret > 0 ? static_cast<size_t>(ret) : 0));
+            if (ret > 0) {
+                Metrics::get().received.inc(static_cast<uint64_t>(ret));
+                continue;
             }
-            return (remain == 0);
-        };
+            if (ret < 0 && errno == EINTR) {
+                continue;
+            }
+            open = (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK));
+            break;
+        }
+        if (!dispatchFrames(*peer)) {
+            open = false;
+        }
+        if (!open || (events & (EPOLLERR | EPOLLHUP))) {
+            closePeer(peer);
+        }
+    }
 
-        while (m_isRunning) {
-            uint32_t typeLenNet = 0, payloadLenNet = 0;
-            if (!readExact(&typeLenNet, 4))
-                break;
-            uint32_t typeLen = ntohl(typeLenNet); // convert big-endian if needed
-            if (typeLen > 1000) {
+    static uint32_t readU32(const uint8_t* p) {
+        return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) |
+               uint32_t(p[3]);
+    }
+
+    // Parses every complete frame in the peer's buffer. Returns false on a framing violation.
+    bool dispatchFrames(Peer& peer) {
+        using namespace rxrevoltchain::util::logger;
+        std::vector<uint8_t>& buf = peer.inbox;
+        size_t pos = 0;
+        bool ok = true;
+        while (buf.size() - pos >= 4) {
+            const uint32_t typeLen = readU32(buf.data() + pos);
+            if (typeLen > MAX_TYPE_LEN) {
                 // sanity check
-                logger.warn("[P2PNode] typeLen is suspiciously large, closing peer: " + address);
+                Logger::getInstance().warn(
+                    "[P2PNode] typeLen is suspiciously large, closing peer: " + peer.address);
+                ok = false;
                 break;
             }
-            // read type
-            std::vector<uint8_t> typeBuf(typeLen);
-            if (!readExact(typeBuf.data(), typeLen))
-                break;
-            std::string msgType((char*)typeBuf.data(), typeBuf.size());
-
-            // read payloadLen
-            if (!readExact(&payloadLenNet, 4))
+            if (buf.size() - pos < 8 + size_t(typeLen)) {
                 break;
-            uint32_t payloadLen = ntohl(payloadLenNet);
-            if (payloadLen > 10 * 1024 * 1024) {
+            }
+            const uint32_t payloadLen = readU32(buf.data() + pos + 4 + typeLen);
+            if (payloadLen > MAX_PAYLOAD_LEN) {
                 // sanity check, 10MB limit
-                logger.warn("[P2PNode] payloadLen is too large, closing peer: " + address);
+                Logger::getInstance().warn("[P2PNode] payloadLen is too large, closing peer: " +
+                                           peer.address);
+                ok = false;
                 break;
             }
-
-            std::vector<uint8_t> payload(payloadLen);
-            if (!readExact(payload.data(), payloadLen))
+            const size_t frameLen = 8 + size_t(typeLen) + payloadLen;
+            if (buf.size() - pos < frameLen) {
                 break;
+            }
 
             // Construct ProtocolMessage
+            const uint8_t* type = buf.data() + pos + 4;
+            const uint8_t* payload = type + typeLen + 4;
             ProtocolMessage msg;
-            msg.type = msgType;
-            msg.payload = std::move(payload);
+            msg.type.assign((const char*)type, typeLen);
+            msg.payload.assign(payload, payload + payloadLen);
+            msg.peerId = peer.id;
+            pos += frameLen;
 
             // Call OnMessageReceived
             OnMessageReceived(msg);
         }
+        buf.erase(buf.begin(), buf.begin() + pos);
+        return ok;
+    }
 
-        // peer is closing
-        logger.info("[P2PNode] Closing recv thread for peer: " + address);
-        closesocket(sock);
+    // Closes a peer from a thread other than its I/O thread
+    void closePeerAsync(const std::shared_ptr<Peer>& peer) {
+        peer->loop->Post([this, peer]() { closePeer(peer); });
+    }
 
-        // remove from peer list
+    // Unregisters and closes a peer (its I/O thread only)
+    void closePeer(const std::shared_ptr<Peer>& peer) {
         {
             std::lock_guard<std::mutex> lock(m_mutex);
-            auto it = std::find_if(m_peers.begin(), m_peers.end(),
-                                   [&](const Peer& p) { return p.sock == sock; });
-            if (it != m_peers.end()) {
-                it->sock = -1;
-                if (it->recvThread.joinable() &&
-                    std::this_thread::get_id() != it->recvThread.get_id()) {
-                    it->recvThread.join();
-                }
-                m_peers.erase(it);
+            auto it = m_peers.find(peer->sock);
+            if (it == m_peers.end() || it->second != peer) {
+                return;
             }
+            std::lock_guard<std::mutex> sendLock(peer->sendMutex);
+            peer->closed = true;
+            peer->outbox.clear();
+            peer->queuedBytes = 0;
+            peer->overLimit = false;
+            peer->loop->Remove(peer->sock);
+            closesocket(peer->sock);
+            m_peers.erase(it);
+            m_peersById.erase(peer->id);
         }
+        rxrevoltchain::util::logger::Logger::getInstance().info(
+            "[P2PNode] Closed connection to peer: " + peer->address);
     }
 
   private:
-    mutable std::mutex m_mutex;
+    mutable std::mutex m_mutex; // guards m_peers, m_loops and the settings below
     std::atomic<bool> m_isRunning;
     int m_listenSocket;
-    std::thread m_acceptThread;
+    size_t m_ioThreads = DEFAULT_IO_THREADS;
+    size_t m_maxConnections = 0;
+    std::atomic<size_t> m_maxPeerQueueBytes{DEFAULT_MAX_PEER_QUEUE_BYTES};
+    std::atomic<int64_t> m_slowPeerGraceMs{DEFAULT_SLOW_PEER_GRACE_MS};
+    std::atomic<uint64_t> m_slowPeers{0};
+    size_t m_queueCollector = 0;
+    std::vector<std::unique_ptr<EventLoop>> m_loops;
+    size_t m_nextLoop = 0;
+    uint64_t m_lastPeerId = 0;
+
+    // Guards 'messages' and the callback; never held while calling out
+    mutable std::mutex m_messageMutex;
 
     // Optional callback invoked when a message is received
     std::function<void(const ProtocolMessage&)> m_messageCallback;
 
-    // Store the connected peers
-    std::vector<Peer> m_peers;
+    // Store the connected peers, keyed by socket and by peer id
+    std::map<int, std::shared_ptr<Peer>> m_peers;
+    std::unordered_map<uint64_t, std::shared_ptr<Peer>> m_peersById;
 };
 
 } // namespace network
@@ -4,6 +4,7 @@
 #include <string>
 #include <vector>
 #include <cstdint>
+#include <cstddef>
 
 namespace rxrevoltchain {
 namespace network {
@@ -23,12 +24,100 @@ namespace network {
        Holds random chunk offsets, etc.
    - struct PoPResponse
        Contains the node’s chunk data or merkle proof.
+   - struct SnapshotManifestRequest / SnapshotManifest
+       Snapshot sync: a page of the merkle leaves of a node's current data.sqlite.
+   - struct SnapshotChunkRequest / SnapshotChunkResponse
+       Snapshot sync: a contiguous range of 4KB chunks of that file.
 
   "Fully functional" approach:
    - These structs hold fields used in network communication.
    - You can integrate serialization/deserialization as needed in other parts of the code.
+   - The snapshot sync structs (and SnapshotAnnounce) have Encode()/Decode() for their
+     binary payloads: big-endian integers, strings as [u32 length][bytes]. Decode() returns
+     false on truncated or oversized input.
 */
 
+// Message types of the snapshot sync protocol (served and fetched by SnapshotSync)
+inline constexpr const char* SNAPSHOT_MANIFEST_REQUEST = "SNAPSHOT_MANIFEST_REQUEST";
+inline constexpr const char* SNAPSHOT_MANIFEST = "SNAPSHOT_MANIFEST";
+inline constexpr const char* SNAPSHOT_CHUNK_REQUEST = "SNAPSHOT_CHUNK_REQUEST";
+inline constexpr const char* SNAPSHOT_CHUNK_RESPONSE = "SNAPSHOT_CHUNK_RESPONSE";
+
+namespace wire {
+
+inline void putU32(std::vector<uint8_t>& out, uint32_t v)
+{
+    out.push_back(static_cast<uint8_t>(v >> 24));
+    out.push_back(static_cast<uint8_t>(v >> 16));
+    out.push_back(static_cast<uint8_t>(v >> 8));
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+inline void putU64(std::vector<uint8_t>& out, uint64_t v)
+{
+    putU32(out, static_cast<uint32_t>(v >> 32));
+    putU32(out, static_cast<uint32_t>(v));
+}
+
+inline void putString(std::vector<uint8_t>& out, const std::string& s)
+{
+    putU32(out, static_cast<uint32_t>(s.size()));
+    out.insert(out.end(), s.begin(), s.end());
+}
+
+// Bounds-checked cursor over a received payload
+struct Reader
+{
+    const std::vector<uint8_t>& buf;
+    size_t pos = 0;
+
+    bool u32(uint32_t& v)
+    {
+        if (buf.size() - pos < 4) {
+            return false;
+        }
+        v = (uint32_t(buf[pos]) << 24) | (uint32_t(buf[pos + 1]) << 16) |
+            (uint32_t(buf[pos + 2]) << 8) | uint32_t(buf[pos + 3]);
+        pos += 4;
+        return true;
+    }
+
+    bool u64(uint64_t& v)
+    {
+        uint32_t hi = 0, lo = 0;
+        if (!u32(hi) || !u32(lo)) {
+            return false;
+        }
+        v = (uint64_t(hi) << 32) | lo;
+        return true;
+    }
+
+    bool bytes(size_t len, std::vector<uint8_t>& out)
+    {
+        if (buf.size() - pos < len) {
+            return false;
+        }
+        out.assign(buf.begin() + pos, buf.begin() + pos + len);
+        pos += len;
+        return true;
+    }
+
+    bool string(std::string& s)
+    {
+        uint32_t len = 0;
+        if (!u32(len) || buf.size() - pos < len) {
+            return false;
+        }
+        s.assign(reinterpret_cast<const char*>(buf.data() + pos), len);
+        pos += len;
+        return true;
+    }
+
+    bool done() const { return pos == buf.size(); }
+};
+
+} // namespace wire
+
 struct ProtocolMessage
 {
     // A short string describing the message type
@@ -38,6 +127,10 @@ struct ProtocolMessage
     // The raw serialized data payload for this message.
     // Could be JSON, binary, or another format.
     std::vector<uint8_t> payload;
+
+    // Connection the message arrived on (set by P2PNode, 0 for locally built messages).
+    // Replies go back through P2PNode::SendToPeer(peerId, ...).
+    uint64_t peerId = 0;
 };
 
 struct SnapshotAnnounce
@@ -47,6 +140,139 @@ struct SnapshotAnnounce
 
     // Optional file hash (e.g., a separate SHA-256 of the .sqlite) for additional validation.
     std::string dbFileHash;
+
+    // Merkle root (hex, MerkleFormat::LegacyHex) of the snapshot, as served by snapshot sync.
+    std::string merkleRoot;
+
+    // Wire form: "cid" or "cid\nmerkleRoot". Older nodes send (and read) the bare CID.
+    std::vector<uint8_t> Encode() const
+    {
+        std::string text = merkleRoot.empty() ? cid : cid + "\n" + merkleRoot;
+        return std::vector<uint8_t>(text.begin(), text.end());
+    }
+
+    bool Decode(const std::vector<uint8_t>& payload)
+    {
+        std::string text(payload.begin(), payload.end());
+        auto nl = text.find('\n');
+        cid = text.substr(0, nl);
+        merkleRoot = (nl == std::string::npos) ? std::string() : text.substr(nl + 1);
+        return !cid.empty();
+    }
+};
+
+struct SnapshotManifestRequest
+{
+    // Root being synced; empty asks for the responder's current snapshot.
+    std::string root;
+    uint32_t firstLeaf = 0;
+    uint32_t maxLeaves = 0;
+
+    std::vector<uint8_t> Encode() const
+    {
+        std::vector<uint8_t> out;
+        out.reserve(12 + root.size());
+        wire::putString(out, root);
+        wire::putU32(out, firstLeaf);
+        wire::putU32(out, maxLeaves);
+        return out;
+    }
+
+    bool Decode(const std::vector<uint8_t>& payload)
+    {
+        wire::Reader in{payload};
+        return in.string(root) && in.u32(firstLeaf) && in.u32(maxLeaves) && in.done();
+    }
+};
+
+struct SnapshotManifest
+{
+    // Root of the described snapshot; empty if the responder does not have it.
+    std::string root;
+    uint32_t format = 0; // MerkleFormat of the tree
+    uint32_t chunkSize = 0;
+    uint64_t fileSize = 0;
+    uint32_t totalLeaves = 0;
+    uint32_t firstLeaf = 0;
+    // Leaf digests [firstLeaf, firstLeaf + leaves.size() / 32), 32 raw bytes each
+    std::vector<uint8_t> leaves;
+
+    std::vector<uint8_t> Encode() const
+    {
+        std::vector<uint8_t> out;
+        out.reserve(36 + root.size() + leaves.size());
+        wire::putString(out, root);
+        wire::putU32(out, format);
+        wire::putU32(out, chunkSize);
+        wire::putU64(out, fileSize);
+        wire::putU32(out, totalLeaves);
+        wire::putU32(out, firstLeaf);
+        wire::putU32(out, static_cast<uint32_t>(leaves.size() / 32));
+        out.insert(out.end(), leaves.begin(), leaves.end());
+        return out;
+    }
+
+    bool Decode(const std::vector<uint8_t>& payload)
+    {
+        wire::Reader in{payload};
+        uint32_t count = 0;
+        return in.string(root) && in.u32(format) && in.u32(chunkSize) && in.u64(fileSize) &&
+               in.u32(totalLeaves) && in.u32(firstLeaf) && in.u32(count) &&
+               in.bytes(size_t(count) * 32, leaves) && in.done();
+    }
+};
+
+struct SnapshotChunkRequest
+{
+    std::string root;
+    uint32_t firstChunk = 0;
+    uint32_t count = 0;
+
+    std::vector<uint8_t> Encode() const
+    {
+        std::vector<uint8_t> out;
+        out.reserve(12 + root.size());
+        wire::putString(out, root);
+        wire::putU32(out, firstChunk);
+        wire::putU32(out, count);
+        return out;
+    }
+
+    bool Decode(const std::vector<uint8_t>& payload)
+    {
+        wire::Reader in{payload};
+        return in.string(root) && in.u32(firstChunk) && in.u32(count) && in.done();
+    }
+};
+
+struct SnapshotChunkResponse
+{
+    std::string root;
+    uint32_t firstChunk = 0;
+    // Chunks in 'data'; 0 means the responder no longer serves 'root'
+    uint32_t count = 0;
+    // The chunks back to back (only the file's last chunk may be short)
+    std::vector<uint8_t> data;
+
+    std::vector<uint8_t> Encode() const
+    {
+        std::vector<uint8_t> out;
+        out.reserve(16 + root.size() + data.size());
+        wire::putString(out, root);
+        wire::putU32(out, firstChunk);
+        wire::putU32(out, count);
+        wire::putU32(out, static_cast<uint32_t>(data.size()));
+        out.insert(out.end(), data.begin(), data.end());
+        return out;
+    }
+
+    bool Decode(const std::vector<uint8_t>& payload)
+    {
+        wire::Reader in{payload};
+        uint32_t len = 0;
+        return in.string(root) && in.u32(firstChunk) && in.u32(count) && in.u32(len) &&
+               in.bytes(len, data) && in.done();
+    }
 };
 
 struct PoPRequest
@@ -6,6 +6,7 @@
 #include "upgrade_manager.hpp"
 #include <mutex>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace rxrevoltchain {
@@ -118,11 +119,10 @@ class ServiceManager {
             // Fake minimal parse: we assume the entire payload is the "metadata"
             rxrevoltchain::core::Transaction tx;
             tx.SetType("document_submission");
-            std::string meta((const char*)req.payload.data(), req.payload.size());
-            tx.SetMetadata(meta);
+            tx.SetMetadata(std::string((const char*)req.payload.data(), req.payload.size()));
 
             // Add to queue
-            bool added = m_documentQueue->AddTransaction(tx);
+            bool added = m_documentQueue->AddTransaction(std::move(tx));
             if (added) {
                 return Response(true, "Document added successfully.");
             } else {
@@ -136,10 +136,9 @@ class ServiceManager {
 
             rxrevoltchain::core::Transaction tx;
             tx.SetType("removal_request");
-            std::string meta((const char*)req.payload.data(), req.payload.size());
-            tx.SetMetadata(meta);
+            tx.SetMetadata(std::string((const char*)req.payload.data(), req.payload.size()));
 
-            bool added = m_documentQueue->AddTransaction(tx);
+            bool added = m_documentQueue->AddTransaction(std::move(tx));
             if (added) {
                 return Response(true, "Removal request queued successfully.");
             } else {
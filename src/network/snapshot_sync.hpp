@@ -0,0 +1,955 @@
+#ifndef RXREVOLTCHAIN_SNAPSHOT_SYNC_HPP
+#define RXREVOLTCHAIN_SNAPSHOT_SYNC_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "hashing.hpp"
+#include "logger.hpp"
+#include "merkle_tree_cache.hpp"
+#include "protocol_messages.hpp"
+#include "thread_pool.hpp"
+
+namespace rxrevoltchain {
+namespace network {
+
+/*
+  SnapshotSync
+  --------------------------------
+  Chunked, resumable transfer of a node's current data.sqlite between pinner nodes over
+  P2PNode, so a new node catches up at link speed instead of through a full IPFS fetch.
+
+  Serving (SetServedFile):
+   - SNAPSHOT_MANIFEST_REQUEST is answered with a page of the snapshot's merkle leaves, plus
+     root, file size and chunk size. The tree is the LegacyHex tree PoP challenges use, taken
+     from a MerkleTreeCache, so the announced root is the PoP root.
+   - SNAPSHOT_CHUNK_REQUEST is answered with up to MAX_RANGE_CHUNKS consecutive 4KB chunks;
+     manifest pages and chunk ranges both stay well below P2PNode's 10 MiB frame limit.
+   - A request for a root other than the current one gets an empty answer; a request
+     without a root gets the current one.
+   - Requests are served on a worker thread of this class, so disk reads and a first tree
+     build never stall a P2P I/O thread.
+
+  Fetching (Fetch):
+   0) The root to fetch must be known in advance: from configuration or consensus, or as
+      the root a quorum of peers reports (AgreedRoot). A peer's own claim is never enough.
+   1) Manifest pages are pulled from the first peer that has the root. The first page must
+      describe a file no larger than Options::maxFileSize, cut into chunks of
+      MIN_CHUNK_SIZE..MAX_CHUNK_SIZE with one leaf per chunk; later pages must follow in
+      order without passing that leaf count, so a peer cannot make the manifest (or the
+      destination file) grow past what it announced. The leaves are only accepted if the
+      merkle root rebuilt from them equals the requested root.
+   2) Missing chunks are split into ranges of Options::rangeChunks and requested from all
+      peers in parallel, at most Options::windowPerPeer ranges in flight per peer.
+   3) Every chunk is hashed and compared with its leaf before it is written to
+      '<dest>.part'. Bad chunks are requested again from any peer; a peer that keeps
+      sending them, times out or no longer has the root is dropped.
+   4) '<dest>.sync' records the root and a bitmap of written chunks. A later Fetch of the
+      same root re-hashes those chunks locally and only requests the rest.
+   5) The completed '<dest>.part' is fsynced and renamed to 'dest'.
+
+  Sidecar format (integers big-endian):
+     1) 4 bytes magic "RXSS", 4 bytes version (1)
+     2) 4 bytes root length, then the root hex
+     3) 8 bytes fileSize, 4 bytes chunkSize
+     4) 4 bytes bitmap length, then ceil(chunks / 8) bytes: bit i set = chunk i written
+
+  THREAD-SAFETY:
+   - HandleMessage() may be called from any thread (normally the P2P I/O threads).
+   - One Fetch() runs at a time; Cancel() may be called from any thread.
+*/
+
+class SnapshotSync {
+  public:
+    // Sends one message to one peer (normally P2PNode::SendToPeer)
+    using SendFn = std::function<bool(uint64_t peerId, const ProtocolMessage& msg)>;
+
+    static constexpr uint32_t MAX_RANGE_CHUNKS = 256;     // 1 MiB of 4KB chunks
+    static constexpr uint32_t MAX_MANIFEST_LEAVES = 65536; // 2 MiB of digests
+    static constexpr uint32_t MIN_CHUNK_SIZE = 4096;
+    static constexpr uint32_t MAX_CHUNK_SIZE = 1024 * 1024;
+    static constexpr size_t MAX_PENDING_REQUESTS = 1024;  // served requests queued, per node
+    static constexpr int MAX_PEER_FAILURES = 2;
+    static constexpr uint32_t SIDECAR_MAGIC = 0x52585353; // "RXSS"
+    static constexpr uint32_t SIDECAR_VERSION = 1;
+
+    struct Options {
+        uint32_t rangeChunks = 64; // chunks per request (capped at MAX_RANGE_CHUNKS)
+        size_t windowPerPeer = 4;  // ranges in flight per peer
+        std::chrono::milliseconds requestTimeout{10000};
+        std::chrono::milliseconds timeout{600000}; // whole Fetch()
+        // Largest snapshot a peer may announce; bounds the manifest (32 bytes per chunk)
+        // and the space reserved for '<dest>.part'
+        uint64_t maxFileSize = uint64_t(64) << 30;
+    };
+
+    struct Stats {
+        uint64_t fetchedChunks = 0;  // verified chunks received from peers
+        uint64_t resumedChunks = 0;  // chunks kept from an interrupted fetch
+        uint64_t rejectedChunks = 0; // chunks that did not match their leaf
+        uint64_t retriedRanges = 0;  // ranges requested again after a timeout or drop
+    };
+
+    explicit SnapshotSync(SendFn send) : m_send(std::move(send)) {}
+
+    SnapshotSync(const SnapshotSync&) = delete;
+    SnapshotSync& operator=(const SnapshotSync&) = delete;
+
+    ~SnapshotSync() {
+        Cancel();
+        {
+            std::lock_guard<std::mutex> lock(m_serveMutex);
+            m_stopWorker = true;
+        }
+        m_serveCv.notify_all();
+        if (m_worker.joinable()) {
+            m_worker.join();
+        }
+    }
+
+    void SetOptions(const Options& options) {
+        std::lock_guard<std::mutex> lock(m_fetchMutex);
+        m_options = options;
+        m_options.rangeChunks = std::min(std::max<uint32_t>(1, options.rangeChunks),
+                                         MAX_RANGE_CHUNKS);
+        m_options.windowPerPeer = std::max<size_t>(1, options.windowPerPeer);
+    }
+
+    Options GetOptions() const {
+        std::lock_guard<std::mutex> lock(m_fetchMutex);
+        return m_options;
+    }
+
+    /**
+     * Take served trees from 'cache', normally the node's PoPConsensus cache, so the
+     * snapshot is not hashed a second time (nullptr = a cache of this instance's own).
+     * 'cache' must outlive this instance.
+     */
+    void SetTreeCache(rxrevoltchain::ipfs_integration::MerkleTreeCache* cache) {
+        std::lock_guard<std::mutex> lock(m_serveMutex);
+        m_treeCache = cache ? cache : &m_ownTreeCache;
+    }
+
+    /** Serve 'path' (the node's data.sqlite) to peers; starts the serving thread. */
+    void SetServedFile(const std::string& path) {
+        std::lock_guard<std::mutex> lock(m_serveMutex);
+        m_servedFile = path;
+        if (!m_worker.joinable()) {
+            m_worker = std::thread(&SnapshotSync::serveLoop, this);
+        }
+    }
+
+    /** Merkle root of the served file (builds its tree if needed); empty if unreadable. */
+    std::string ServedRoot() {
+        auto tree = servedTree();
+        return tree ? tree->root : std::string();
+    }
+
+    /**
+     * Route a received message. Returns true if it belongs to the sync protocol (and was
+     * queued for serving or for the running Fetch()), false for any other type.
+     */
+    bool HandleMessage(const ProtocolMessage& msg) {
+        if (msg.type == SNAPSHOT_MANIFEST_REQUEST || msg.type == SNAPSHOT_CHUNK_REQUEST) {
+            std::lock_guard<std::mutex> lock(m_serveMutex);
+            if (!m_servedFile.empty() && m_serveQueue.size() < MAX_PENDING_REQUESTS) {
+                m_serveQueue.push_back(msg);
+                m_serveCv.notify_one();
+            }
+            return true;
+        }
+        if (msg.type == SNAPSHOT_MANIFEST || msg.type == SNAPSHOT_CHUNK_RESPONSE) {
+            std::lock_guard<std::mutex> lock(m_fetchMutex);
+            if (m_fetching) {
+                m_responses.push_back(msg);
+                m_fetchCv.notify_one();
+            }
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * Ask every peer in 'peers' for the root it currently serves and return the one at
+     * least 'quorum' of them agree on (empty if none does within Options::requestTimeout).
+     * A bootstrapping node without a configured root passes the result to Fetch(), so a
+     * single peer cannot pick the snapshot it receives.
+     */
+    std::string AgreedRoot(const std::vector<uint64_t>& peers, size_t quorum) {
+        using namespace rxrevoltchain::util::logger;
+        Options opts;
+        {
+            std::lock_guard<std::mutex> lock(m_fetchMutex);
+            if (m_fetching) {
+                Logger::getInstance().warn("[SnapshotSync] AgreedRoot called during a Fetch.");
+                return std::string();
+            }
+            m_fetching = true;
+            m_cancel = false;
+            m_responses.clear();
+            opts = m_options;
+        }
+
+        SnapshotManifestRequest req;
+        req.maxLeaves = 1; // only the root matters
+        ProtocolMessage msg;
+        msg.type = SNAPSHOT_MANIFEST_REQUEST;
+        msg.payload = req.Encode();
+        std::set<uint64_t> pending;
+        for (uint64_t peer : peers) {
+            if (m_send(peer, msg)) {
+                pending.insert(peer);
+            }
+        }
+
+        // Each peer gets one vote, the first manifest it sends
+        const size_t needed = std::max<size_t>(1, quorum);
+        std::map<std::string, size_t> votes;
+        std::string agreed;
+        const auto until = std::chrono::steady_clock::now() + opts.requestTimeout;
+        while (agreed.empty() && !pending.empty() && !cancelled() &&
+               std::chrono::steady_clock::now() < until) {
+            for (const auto& reply : takeResponses(until)) {
+                SnapshotManifest page;
+                if (reply.type != SNAPSHOT_MANIFEST || pending.erase(reply.peerId) == 0 ||
+                    !page.Decode(reply.payload) || page.root.empty()) {
+                    continue;
+                }
+                if (++votes[page.root] >= needed) {
+                    agreed = page.root;
+                    break;
+                }
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_fetchMutex);
+            m_fetching = false;
+            m_responses.clear();
+        }
+        if (agreed.empty()) {
+            Logger::getInstance().warn("[SnapshotSync] No snapshot root is served by " +
+                                       std::to_string(needed) + " of " +
+                                       std::to_string(peers.size()) + " peers.");
+        }
+        return agreed;
+    }
+
+    /**
+     * Download the snapshot with merkle root 'root' from 'peers' into 'destPath'. The root
+     * must come from a trusted source (configuration, consensus or AgreedRoot()); an empty
+     * one is refused. The root fetched is also stored in 'fetchedRoot'. Blocks until the
+     * file is complete, the timeout passes, every peer failed or Cancel() is called.
+     * @return true once 'destPath' holds the verified snapshot.
+     */
+    bool Fetch(const std::vector<uint64_t>& peers, const std::string& root,
+               const std::string& destPath, std::string* fetchedRoot = nullptr) {
+        using namespace rxrevoltchain::util::logger;
+        if (root.empty()) {
+            Logger::getInstance().error("[SnapshotSync] Refusing to fetch without an expected "
+                                        "root.");
+            return false;
+        }
+        Options opts;
+        {
+            std::lock_guard<std::mutex> lock(m_fetchMutex);
+            if (m_fetching) {
+                Logger::getInstance().warn("[SnapshotSync] Fetch called while one is running.");
+                return false;
+            }
+            m_fetching = true;
+            m_cancel = false;
+            m_responses.clear();
+            m_stats = Stats();
+            opts = m_options;
+        }
+        m_verified = 0;
+
+        Job job;
+        job.partPath = destPath + ".part";
+        job.sidecarPath = destPath + ".sync";
+        job.deadline = std::chrono::steady_clock::now() + opts.timeout;
+
+        bool ok = fetchManifest(peers, root, opts, job) && openPart(job) &&
+                  fetchChunks(peers, opts, job) && finish(destPath, job);
+        if (job.fd >= 0) {
+            ::close(job.fd);
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_fetchMutex);
+            m_fetching = false;
+            m_responses.clear();
+            m_stats = job.stats;
+        }
+
+        if (ok) {
+            if (fetchedRoot) {
+                *fetchedRoot = job.root;
+            }
+            Logger::getInstance().info(
+                "[SnapshotSync] Fetched snapshot " + job.root + " into " + destPath + " (" +
+                std::to_string(job.stats.fetchedChunks) + " chunks fetched, " +
+                std::to_string(job.stats.resumedChunks) + " resumed, " +
+                std::to_string(job.stats.rejectedChunks) + " rejected).");
+        } else {
+            Logger::getInstance().warn("[SnapshotSync] Fetch into " + destPath +
+                                       " did not complete; it can be resumed.");
+        }
+        return ok;
+    }
+
+    /** Stop a running Fetch(); its progress stays on disk for the next attempt. */
+    void Cancel() {
+        std::lock_guard<std::mutex> lock(m_fetchMutex);
+        if (m_fetching) {
+            m_cancel = true;
+            m_fetchCv.notify_all();
+        }
+    }
+
+    /** Chunks of the current (or last) Fetch() verified so far, resumed ones included. */
+    uint64_t VerifiedChunks() const { return m_verified.load(); }
+
+    /** Counters of the last completed or aborted Fetch(). */
+    Stats LastStats() const {
+        std::lock_guard<std::mutex> lock(m_fetchMutex);
+        return m_stats;
+    }
+
+  private:
+    struct Range {
+        uint32_t first = 0;
+        uint32_t count = 0;
+    };
+
+    struct InFlight {
+        uint64_t peer = 0;
+        Range range;
+        std::chrono::steady_clock::time_point deadline;
+    };
+
+    // State of one Fetch()
+    struct Job {
+        std::string root;
+        rxrevoltchain::ipfs_integration::MerkleTree tree; // leaves = level 0
+        uint32_t chunks = 0;
+        std::vector<uint8_t> bitmap;
+        std::string partPath;
+        std::string sidecarPath;
+        int fd = -1;
+        std::chrono::steady_clock::time_point deadline;
+        Stats stats;
+    };
+
+    static bool isSet(const std::vector<uint8_t>& bitmap, uint32_t i) {
+        return (bitmap[i / 8] >> (i % 8)) & 1;
+    }
+
+    static size_t chunkLength(const Job& job, uint32_t i) {
+        const uint64_t offset = uint64_t(i) * job.tree.chunkSize;
+        return static_cast<size_t>(std::min<uint64_t>(job.tree.chunkSize,
+                                                      job.tree.fileSize - offset));
+    }
+
+    // Full pread/pwrite; false on error or EOF
+    static bool readAt(int fd, uint8_t* data, size_t len, uint64_t offset) {
+        while (len > 0) {
+            ssize_t n = ::pread(fd, data, len, static_cast<off_t>(offset));
+            if (n <= 0) {
+                if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            data += n;
+            len -= static_cast<size_t>(n);
+            offset += static_cast<uint64_t>(n);
+        }
+        return true;
+    }
+
+    static bool writeAt(int fd, const uint8_t* data, size_t len, uint64_t offset) {
+        while (len > 0) {
+            ssize_t n = ::pwrite(fd, data, len, static_cast<off_t>(offset));
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            data += n;
+            len -= static_cast<size_t>(n);
+            offset += static_cast<uint64_t>(n);
+        }
+        return true;
+    }
+
+    bool cancelled() {
+        std::lock_guard<std::mutex> lock(m_fetchMutex);
+        return m_cancel;
+    }
+
+    // Waits until a response arrives, the fetch is cancelled or 'until' passes, and takes
+    // every response received so far (possibly none)
+    std::deque<ProtocolMessage> takeResponses(std::chrono::steady_clock::time_point until) {
+        std::unique_lock<std::mutex> lock(m_fetchMutex);
+        m_fetchCv.wait_until(lock, until, [this] { return m_cancel || !m_responses.empty(); });
+        std::deque<ProtocolMessage> out;
+        out.swap(m_responses);
+        return out;
+    }
+
+    // ---------------------------
+    // Fetching
+    // ---------------------------
+    bool fetchManifest(const std::vector<uint64_t>& peers, const std::string& root,
+                       const Options& opts, Job& job) {
+        using namespace rxrevoltchain::util::logger;
+        for (uint64_t peer : peers) {
+            if (cancelled() || std::chrono::steady_clock::now() >= job.deadline) {
+                return false;
+            }
+            if (fetchManifestFrom(peer, root, opts, job)) {
+                return true;
+            }
+            Logger::getInstance().warn("[SnapshotSync] Peer " + std::to_string(peer) +
+                                       " did not provide a valid manifest.");
+        }
+        Logger::getInstance().error("[SnapshotSync] No peer provided a valid manifest.");
+        return false;
+    }
+
+    bool fetchManifestFrom(uint64_t peer, const std::string& root, const Options& opts,
+                           Job& job) {
+        using namespace rxrevoltchain::ipfs_integration;
+        SnapshotManifestRequest req;
+        req.root = root;
+        req.maxLeaves = MAX_MANIFEST_LEAVES;
+        SnapshotManifest head;
+        std::vector<uint8_t> leaves;
+        bool first = true;
+        while (first || leaves.size() / 32 < head.totalLeaves) {
+            req.firstLeaf = static_cast<uint32_t>(leaves.size() / 32);
+            ProtocolMessage msg;
+            msg.type = SNAPSHOT_MANIFEST_REQUEST;
+            msg.payload = req.Encode();
+            SnapshotManifest page;
+            if (!m_send(peer, msg) || !awaitManifest(peer, opts, job, page)) {
+                return false;
+            }
+            if (page.root != root || page.firstLeaf != req.firstLeaf) {
+                return false;
+            }
+            if (first) {
+                // Checked before anything is allocated for the announced size
+                if (!validGeometry(page, opts.maxFileSize)) {
+                    rxrevoltchain::util::logger::Logger::getInstance().warn(
+                        "[SnapshotSync] Manifest of peer " + std::to_string(peer) +
+                        " announces an invalid or oversized snapshot.");
+                    return false;
+                }
+                head = page;
+                first = false;
+                leaves.reserve(size_t(head.totalLeaves) * 32);
+            } else if (page.totalLeaves != head.totalLeaves) {
+                return false;
+            }
+            const size_t count = page.leaves.size() / 32;
+            if (count == 0 || count > req.maxLeaves ||
+                uint64_t(req.firstLeaf) + count > head.totalLeaves) {
+                return false; // no progress, or more leaves than announced
+            }
+            leaves.insert(leaves.end(), page.leaves.begin(), page.leaves.end());
+        }
+
+        // The leaves must hash to the root
+        MerkleTree tree;
+        tree.format = static_cast<MerkleFormat>(head.format);
+        tree.chunkSize = head.chunkSize;
+        tree.fileSize = head.fileSize;
+        tree.nodes = std::move(leaves);
+        MerkleProof().BuildTreeFromLeaves(tree);
+        if (tree.root.empty() || tree.root != head.root) {
+            rxrevoltchain::util::logger::Logger::getInstance().warn(
+                "[SnapshotSync] Manifest leaves do not hash to the announced root " + head.root);
+            return false;
+        }
+        job.root = head.root;
+        job.chunks = head.totalLeaves;
+        job.tree = std::move(tree);
+        return true;
+    }
+
+    // One leaf per chunk of a file within the size caps, in a known tree format
+    static bool validGeometry(const SnapshotManifest& head, uint64_t maxFileSize) {
+        using rxrevoltchain::ipfs_integration::MerkleFormat;
+        if (head.chunkSize < MIN_CHUNK_SIZE || head.chunkSize > MAX_CHUNK_SIZE ||
+            head.fileSize > maxFileSize ||
+            (head.format != uint32_t(MerkleFormat::LegacyHex) &&
+             head.format != uint32_t(MerkleFormat::Binary))) {
+            return false;
+        }
+        return (head.fileSize + head.chunkSize - 1) / head.chunkSize == head.totalLeaves;
+    }
+
+    bool awaitManifest(uint64_t peer, const Options& opts, Job& job, SnapshotManifest& page) {
+        const auto until =
+            std::min(job.deadline, std::chrono::steady_clock::now() + opts.requestTimeout);
+        while (!cancelled() && std::chrono::steady_clock::now() < until) {
+            for (const auto& msg : takeResponses(until)) {
+                if (msg.type == SNAPSHOT_MANIFEST && msg.peerId == peer) {
+                    return page.Decode(msg.payload);
+                }
+            }
+        }
+        return false;
+    }
+
+    // Opens '<dest>.part' and keeps the chunks a previous attempt verified and recorded
+    bool openPart(Job& job) {
+        using namespace rxrevoltchain::util::logger;
+        job.bitmap.assign((job.chunks + 7) / 8, 0);
+        job.fd = ::open(job.partPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (job.fd < 0) {
+            Logger::getInstance().error("[SnapshotSync] Cannot open " + job.partPath);
+            return false;
+        }
+
+        std::vector<uint8_t> recorded;
+        if (loadSidecar(job, recorded)) {
+            // The bitmap may be newer than the data that reached the disk: re-hash
+            std::vector<char> good(job.chunks, 0);
+            rxrevoltchain::util::ThreadPool::getInstance().parallelFor(
+                job.chunks, 256, [&](size_t begin, size_t end) {
+                    std::vector<uint8_t> buf(job.tree.chunkSize);
+                    uint8_t digest[32];
+                    for (size_t i = begin; i < end; ++i) {
+                        const uint32_t c = static_cast<uint32_t>(i);
+                        const size_t len = chunkLength(job, c);
+                        if (!isSet(recorded, c) ||
+                            !readAt(job.fd, buf.data(), len, uint64_t(c) * job.tree.chunkSize)) {
+                            continue;
+                        }
+                        rxrevoltchain::util::hashing::sha256Raw(buf.data(), len, digest);
+                        good[i] = std::memcmp(digest, job.tree.Node(0, c), 32) == 0;
+                    }
+                });
+            for (uint32_t i = 0; i < job.chunks; ++i) {
+                if (good[i]) {
+                    job.bitmap[i / 8] |= uint8_t(1u << (i % 8));
+                    ++job.stats.resumedChunks;
+                }
+            }
+            m_verified = job.stats.resumedChunks;
+            Logger::getInstance().info("[SnapshotSync] Resuming " + job.partPath + " with " +
+                                       std::to_string(job.stats.resumedChunks) + "/" +
+                                       std::to_string(job.chunks) + " chunks.");
+        }
+
+        if (::ftruncate(job.fd, static_cast<off_t>(job.tree.fileSize)) != 0) {
+            Logger::getInstance().error("[SnapshotSync] Cannot size " + job.partPath);
+            return false;
+        }
+        return writeSidecar(job);
+    }
+
+    bool loadSidecar(const Job& job, std::vector<uint8_t>& bitmap) const {
+        std::ifstream in(job.sidecarPath, std::ios::binary);
+        if (!in) {
+            return false;
+        }
+        std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(in)),
+                                   std::istreambuf_iterator<char>());
+        wire::Reader r{bytes};
+        uint32_t magic = 0, version = 0, chunkSize = 0, bitmapLen = 0;
+        uint64_t fileSize = 0;
+        std::string root;
+        return r.u32(magic) && magic == SIDECAR_MAGIC && r.u32(version) &&
+               version == SIDECAR_VERSION && r.string(root) && root == job.root &&
+               r.u64(fileSize) && fileSize == job.tree.fileSize && r.u32(chunkSize) &&
+               chunkSize == job.tree.chunkSize && r.u32(bitmapLen) &&
+               bitmapLen == job.bitmap.size() && r.bytes(bitmapLen, bitmap) && r.done();
+    }
+
+    // Rewrites the sidecar through a temporary file, so a crash leaves the old or new one
+    bool writeSidecar(const Job& job) const {
+        std::vector<uint8_t> out;
+        wire::putU32(out, SIDECAR_MAGIC);
+        wire::putU32(out, SIDECAR_VERSION);
+        wire::putString(out, job.root);
+        wire::putU64(out, job.tree.fileSize);
+        wire::putU32(out, static_cast<uint32_t>(job.tree.chunkSize));
+        wire::putU32(out, static_cast<uint32_t>(job.bitmap.size()));
+        out.insert(out.end(), job.bitmap.begin(), job.bitmap.end());
+
+        const std::string tmp = job.sidecarPath + ".tmp";
+        {
+            std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char*>(out.data()),
+                       static_cast<std::streamsize>(out.size()));
+            if (!file) {
+                return false;
+            }
+        }
+        return std::rename(tmp.c_str(), job.sidecarPath.c_str()) == 0;
+    }
+
+    bool fetchChunks(const std::vector<uint64_t>& peers, const Options& opts, Job& job) {
+        using namespace rxrevoltchain::util::logger;
+        using Clock = std::chrono::steady_clock;
+
+        // Missing chunks as ranges of at most rangeChunks
+        std::deque<Range> pending;
+        for (uint32_t i = 0; i < job.chunks;) {
+            if (isSet(job.bitmap, i)) {
+                ++i;
+                continue;
+            }
+            const uint32_t first = i;
+            while (i < job.chunks && !isSet(job.bitmap, i) && i - first < opts.rangeChunks) {
+                ++i;
+            }
+            pending.push_back({first, i - first});
+        }
+
+        std::map<uint64_t, int> failures; // live peers and their failed requests
+        for (uint64_t peer : peers) {
+            failures[peer] = 0;
+        }
+        std::vector<InFlight> inflight;
+        auto dropPeer = [&](uint64_t peer) {
+            failures.erase(peer);
+            for (auto it = inflight.begin(); it != inflight.end();) {
+                if (it->peer == peer) {
+                    pending.push_front(it->range);
+                    ++job.stats.retriedRanges;
+                    it = inflight.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            Logger::getInstance().warn("[SnapshotSync] Dropping peer " + std::to_string(peer) +
+                                       " from the sync.");
+        };
+        auto strike = [&](uint64_t peer) {
+            auto it = failures.find(peer);
+            if (it != failures.end() && ++it->second >= MAX_PEER_FAILURES) {
+                dropPeer(peer);
+            }
+        };
+
+        auto lastPersist = Clock::now();
+        while (!pending.empty() || !inflight.empty()) {
+            if (cancelled() || Clock::now() >= job.deadline) {
+                writeSidecar(job);
+                return false;
+            }
+
+            // 1) Fill every live peer's window
+            std::vector<uint64_t> unreachable;
+            for (const auto& entry : failures) {
+                size_t busy = 0;
+                for (const auto& f : inflight) {
+                    busy += (f.peer == entry.first);
+                }
+                while (busy < opts.windowPerPeer && !pending.empty()) {
+                    const Range range = pending.front();
+                    SnapshotChunkRequest req;
+                    req.root = job.root;
+                    req.firstChunk = range.first;
+                    req.count = range.count;
+                    ProtocolMessage msg;
+                    msg.type = SNAPSHOT_CHUNK_REQUEST;
+                    msg.payload = req.Encode();
+                    if (!m_send(entry.first, msg)) {
+                        unreachable.push_back(entry.first);
+                        break;
+                    }
+                    pending.pop_front();
+                    inflight.push_back({entry.first, range, Clock::now() + opts.requestTimeout});
+                    ++busy;
+                }
+            }
+            for (uint64_t peer : unreachable) {
+                dropPeer(peer);
+            }
+            if (failures.empty()) {
+                Logger::getInstance().error("[SnapshotSync] No peers left to sync from.");
+                writeSidecar(job);
+                return false;
+            }
+
+            // 2) Verify and store whatever arrived before the earliest request deadline
+            auto until = job.deadline;
+            for (const auto& f : inflight) {
+                until = std::min(until, f.deadline);
+            }
+            for (const auto& msg : takeResponses(until)) {
+                SnapshotChunkResponse resp;
+                if (msg.type != SNAPSHOT_CHUNK_RESPONSE || !resp.Decode(msg.payload)) {
+                    continue;
+                }
+                auto f = std::find_if(inflight.begin(), inflight.end(), [&](const InFlight& x) {
+                    return x.peer == msg.peerId && x.range.first == resp.firstChunk;
+                });
+                if (f == inflight.end()) {
+                    continue; // late answer to a request already given to another peer
+                }
+                const Range range = f->range;
+                inflight.erase(f);
+                if (resp.root != job.root || resp.count == 0 || resp.count > range.count) {
+                    pending.push_front(range);
+                    ++job.stats.retriedRanges;
+                    dropPeer(msg.peerId);
+                    continue;
+                }
+                if (resp.count < range.count) {
+                    pending.push_front({range.first + resp.count, range.count - resp.count});
+                }
+                if (!storeChunks(job, resp, pending)) {
+                    strike(msg.peerId);
+                }
+            }
+
+            // 3) Requests that timed out go back to the queue
+            std::vector<uint64_t> late;
+            const auto now = Clock::now();
+            for (auto it = inflight.begin(); it != inflight.end();) {
+                if (it->deadline <= now) {
+                    pending.push_front(it->range);
+                    ++job.stats.retriedRanges;
+                    late.push_back(it->peer);
+                    it = inflight.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            for (uint64_t peer : late) {
+                strike(peer);
+            }
+
+            if (now - lastPersist >= std::chrono::milliseconds(500)) {
+                writeSidecar(job);
+                lastPersist = now;
+            }
+        }
+        return true;
+    }
+
+    // Writes the chunks of 'resp' that match their leaves; mismatching ones are queued again.
+    // Returns false if any chunk was rejected.
+    bool storeChunks(Job& job, const SnapshotChunkResponse& resp, std::deque<Range>& pending) {
+        const uint32_t first = resp.firstChunk;
+        size_t total = 0;
+        for (uint32_t i = 0; i < resp.count; ++i) {
+            total += chunkLength(job, first + i);
+        }
+        if (resp.data.size() != total) {
+            pending.push_front({first, resp.count});
+            job.stats.rejectedChunks += resp.count;
+            return false;
+        }
+
+        // Only the file's last chunk can be short; the others are hashed as one batch
+        const size_t chunkSize = job.tree.chunkSize;
+        const bool shortTail = chunkLength(job, first + resp.count - 1) != chunkSize;
+        const uint32_t full = resp.count - (shortTail ? 1 : 0);
+        std::vector<uint8_t> digests(size_t(resp.count) * 32);
+        rxrevoltchain::util::hashing::sha256Batch(resp.data.data(), chunkSize, full,
+                                                  digests.data());
+        if (shortTail) {
+            rxrevoltchain::util::hashing::sha256Raw(resp.data.data() + size_t(full) * chunkSize,
+                                                    total - size_t(full) * chunkSize,
+                                                    digests.data() + size_t(full) * 32);
+        }
+
+        bool allGood = true;
+        for (uint32_t i = 0; i < resp.count; ++i) {
+            const uint32_t c = first + i;
+            if (isSet(job.bitmap, c)) {
+                continue;
+            }
+            const size_t len = chunkLength(job, c);
+            if (std::memcmp(digests.data() + size_t(i) * 32, job.tree.Node(0, c), 32) != 0) {
+                if (!pending.empty() && pending.back().first + pending.back().count == c) {
+                    ++pending.back().count; // extend the previous rejected run
+                } else {
+                    pending.push_back({c, 1});
+                }
+                ++job.stats.rejectedChunks;
+                allGood = false;
+                continue;
+            }
+            if (!writeAt(job.fd, resp.data.data() + size_t(i) * chunkSize, len,
+                         uint64_t(c) * chunkSize)) {
+                pending.push_back({c, 1});
+                continue;
+            }
+            job.bitmap[c / 8] |= uint8_t(1u << (c % 8));
+            ++job.stats.fetchedChunks;
+            ++m_verified;
+        }
+        return allGood;
+    }
+
+    bool finish(const std::string& destPath, Job& job) {
+        using namespace rxrevoltchain::util::logger;
+        if (::fsync(job.fd) != 0) {
+            Logger::getInstance().error("[SnapshotSync] fsync failed for " + job.partPath);
+            return false;
+        }
+        ::close(job.fd);
+        job.fd = -1;
+        if (std::rename(job.partPath.c_str(), destPath.c_str()) != 0) {
+            Logger::getInstance().error("[SnapshotSync] Cannot move " + job.partPath + " to " +
+                                        destPath);
+            return false;
+        }
+        std::remove(job.sidecarPath.c_str());
+        return true;
+    }
+
+    // ---------------------------
+    // Serving
+    // ---------------------------
+    std::shared_ptr<const rxrevoltchain::ipfs_integration::MerkleTree> servedTree() {
+        using rxrevoltchain::ipfs_integration::MerkleFormat;
+        std::string file;
+        rxrevoltchain::ipfs_integration::MerkleTreeCache* cache = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(m_serveMutex);
+            file = m_servedFile;
+            cache = m_treeCache;
+        }
+        if (file.empty()) {
+            return nullptr;
+        }
+        return cache->GetOrBuildCurrent(file, MerkleFormat::LegacyHex);
+    }
+
+    void serveLoop() {
+        while (true) {
+            ProtocolMessage msg;
+            {
+                std::unique_lock<std::mutex> lock(m_serveMutex);
+                m_serveCv.wait(lock, [this] { return m_stopWorker || !m_serveQueue.empty(); });
+                if (m_stopWorker) {
+                    return;
+                }
+                msg = std::move(m_serveQueue.front());
+                m_serveQueue.pop_front();
+            }
+            ProtocolMessage reply = msg.type == SNAPSHOT_MANIFEST_REQUEST ? serveManifest(msg)
+                                                                          : serveChunks(msg);
+            m_send(msg.peerId, reply);
+        }
+    }
+
+    ProtocolMessage serveManifest(const ProtocolMessage& msg) {
+        SnapshotManifestRequest req;
+        SnapshotManifest out;
+        std::shared_ptr<const rxrevoltchain::ipfs_integration::MerkleTree> tree;
+        if (req.Decode(msg.payload) && (tree = servedTree()) && tree->LeafCount() > 0 &&
+            (req.root.empty() || req.root == tree->root)) {
+            const uint32_t total = static_cast<uint32_t>(tree->LeafCount());
+            out.root = tree->root;
+            out.format = static_cast<uint32_t>(tree->format);
+            out.chunkSize = static_cast<uint32_t>(tree->chunkSize);
+            out.fileSize = tree->fileSize;
+            out.totalLeaves = total;
+            out.firstLeaf = std::min(req.firstLeaf, total);
+            const uint32_t limit = req.maxLeaves ? std::min(req.maxLeaves, MAX_MANIFEST_LEAVES)
+                                                 : MAX_MANIFEST_LEAVES;
+            const uint32_t count = std::min(total - out.firstLeaf, limit);
+            const uint8_t* leaves = tree->Node(0, out.firstLeaf);
+            out.leaves.assign(leaves, leaves + size_t(count) * 32);
+        }
+        ProtocolMessage reply;
+        reply.type = SNAPSHOT_MANIFEST;
+        reply.payload = out.Encode();
+        return reply;
+    }
+
+    ProtocolMessage serveChunks(const ProtocolMessage& msg) {
+        SnapshotChunkRequest req;
+        SnapshotChunkResponse out;
+        if (req.Decode(msg.payload)) {
+            out.root = req.root;
+            out.firstChunk = req.firstChunk;
+            auto tree = servedTree();
+            if (tree && req.root == tree->root && req.firstChunk < tree->LeafCount()) {
+                const uint32_t count = std::min<uint32_t>(
+                    {req.count, MAX_RANGE_CHUNKS,
+                     static_cast<uint32_t>(tree->LeafCount() - req.firstChunk)});
+                const uint64_t offset = uint64_t(req.firstChunk) * tree->chunkSize;
+                const size_t len = static_cast<size_t>(
+                    std::min<uint64_t>(uint64_t(count) * tree->chunkSize, tree->fileSize - offset));
+                std::string file;
+                {
+                    std::lock_guard<std::mutex> lock(m_serveMutex);
+                    file = m_servedFile;
+                }
+                // The file may change after the tree lookup; the fetcher checks every chunk
+                int fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+                out.data.resize(len);
+                if (fd >= 0 && readAt(fd, out.data.data(), len, offset)) {
+                    out.count = count;
+                } else {
+                    out.data.clear();
+                }
+                if (fd >= 0) {
+                    ::close(fd);
+                }
+            }
+        }
+        ProtocolMessage reply;
+        reply.type = SNAPSHOT_CHUNK_RESPONSE;
+        reply.payload = out.Encode();
+        return reply;
+    }
+
+  private:
+    SendFn m_send;
+
+    // Serving side
+    std::mutex m_serveMutex; // guards m_servedFile, m_serveQueue, m_stopWorker, m_treeCache
+    std::condition_variable m_serveCv;
+    std::string m_servedFile;
+    std::deque<ProtocolMessage> m_serveQueue;
+    bool m_stopWorker = false;
+    std::thread m_worker;
+    rxrevoltchain::ipfs_integration::MerkleTreeCache m_ownTreeCache;
+    rxrevoltchain::ipfs_integration::MerkleTreeCache* m_treeCache = &m_ownTreeCache;
+
+    // Fetching side
+    mutable std::mutex m_fetchMutex; // guards the fields below
+    std::condition_variable m_fetchCv;
+    Options m_options;
+    bool m_fetching = false;
+    bool m_cancel = false;
+    std::deque<ProtocolMessage> m_responses;
+    Stats m_stats;
+    std::atomic<uint64_t> m_verified{0};
+};
+
+} // namespace network
+} // namespace rxrevoltchain
+
+#endif // RXREVOLTCHAIN_SNAPSHOT_SYNC_HPP
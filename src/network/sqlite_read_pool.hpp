@@ -0,0 +1,258 @@
+#ifndef RXREVOLTCHAIN_SQLITE_READ_POOL_HPP
+#define RXREVOLTCHAIN_SQLITE_READ_POOL_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <sqlite3.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace rxrevoltchain {
+namespace network {
+
+/*
+  SqliteReadPool
+  --------------------------------
+  A bounded pool of read-only SQLite connections to one snapshot file, each with the
+  statements HttpQueryServer needs prepared once per connection.
+
+   - Acquire() hands out an idle connection, opens a new one while fewer than
+     maxConnections exist, and otherwise blocks until one is released. The returned Lease
+     gives the connection back when it goes out of scope.
+   - Connections are opened SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX: a connection is only
+     ever used by the thread holding its lease. Every statement is reset after use, so no
+     read transaction outlives a request and commits from the writer are visible to the
+     next one.
+   - Reopen() retires every connection (idle ones now, leased ones on release). Call it when
+     the file is replaced or its schema changes; prepared statements are bound to both.
+   - Statements for a table that does not exist yet are left null and prepared again on the
+     next Acquire().
+   - Queries built per request (a fixed set of shapes, e.g. one per combination of filters)
+     go through Statement(), which prepares each distinct SQL text once per connection.
+*/
+
+class SqliteReadPool {
+  public:
+    static constexpr int BUSY_TIMEOUT_MS = 1000;
+
+    struct Connection {
+        sqlite3* db = nullptr;
+        sqlite3_stmt* record = nullptr;     // metadata, payload, codec WHERE id=?
+        sqlite3_stmt* range = nullptr;      // id, metadata, payload, codec; id in [?, ?], LIMIT ?
+        sqlite3_stmt* dictionary = nullptr; // data FROM dictionaries WHERE id=?
+        sqlite3_stmt* count = nullptr;      // COUNT(*) FROM documents
+        std::unordered_map<std::string, sqlite3_stmt*> queries; // see Statement()
+        uint64_t generation = 0;
+    };
+
+    class Lease {
+      public:
+        Lease() = default;
+        Lease(SqliteReadPool* pool, Connection* conn) : m_pool(pool), m_conn(conn) {}
+        Lease(Lease&& other) noexcept : m_pool(other.m_pool), m_conn(other.m_conn) {
+            other.m_conn = nullptr;
+        }
+        Lease& operator=(Lease&& other) noexcept {
+            if (this != &other) {
+                reset();
+                m_pool = other.m_pool;
+                m_conn = other.m_conn;
+                other.m_conn = nullptr;
+            }
+            return *this;
+        }
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        ~Lease() { reset(); }
+
+        explicit operator bool() const { return m_conn != nullptr; }
+        Connection* operator->() const { return m_conn; }
+
+        void reset() {
+            if (m_conn) {
+                m_pool->release(m_conn);
+                m_conn = nullptr;
+            }
+        }
+
+      private:
+        SqliteReadPool* m_pool = nullptr;
+        Connection* m_conn = nullptr;
+    };
+
+    SqliteReadPool(const std::string& path, size_t maxConnections)
+        : m_path(path), m_maxConnections(maxConnections ? maxConnections : 1) {}
+
+    SqliteReadPool(const SqliteReadPool&) = delete;
+    SqliteReadPool& operator=(const SqliteReadPool&) = delete;
+
+    // Every lease must have been returned by now
+    ~SqliteReadPool() {
+        for (Connection* conn : m_idle) {
+            closeConnection(conn);
+        }
+    }
+
+    /** Upper bound on open connections; takes effect as connections are acquired. */
+    void SetMaxConnections(size_t maxConnections) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_maxConnections = maxConnections ? maxConnections : 1;
+        m_available.notify_all();
+    }
+
+    /** Returns an empty lease if the database cannot be opened. */
+    Lease Acquire() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_available.wait(lock, [this]() { return !m_idle.empty() || m_open < m_maxConnections; });
+        Connection* conn = nullptr;
+        if (!m_idle.empty()) {
+            conn = m_idle.back();
+            m_idle.pop_back();
+        } else {
+            ++m_open;
+        }
+        const uint64_t generation = m_generation;
+        lock.unlock();
+
+        if (conn && conn->generation != generation) {
+            closeConnection(conn);
+            conn = nullptr;
+        }
+        if (!conn) {
+            conn = openConnection(generation);
+        } else {
+            prepareStatements(conn);
+        }
+        if (!conn) {
+            lock.lock();
+            --m_open;
+            m_available.notify_one();
+            return Lease();
+        }
+        return Lease(this, conn);
+    }
+
+    /** Retire every connection so the next Acquire() opens the file afresh. */
+    void Reopen() {
+        std::vector<Connection*> retired;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ++m_generation;
+            retired.swap(m_idle);
+            m_open -= retired.size();
+            m_available.notify_all();
+        }
+        for (Connection* conn : retired) {
+            closeConnection(conn);
+        }
+    }
+
+    /** Connections currently open (idle or leased). */
+    size_t Size() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_open;
+    }
+
+    /**
+     * Statement for 'sql' on 'conn', prepared on first use. Returns null (and caches
+     * nothing) if it does not compile, e.g. because a table does not exist yet.
+     */
+    static sqlite3_stmt* Statement(Connection* conn, const std::string& sql) {
+        auto it = conn->queries.find(sql);
+        if (it != conn->queries.end()) {
+            return it->second;
+        }
+        sqlite3_stmt* stmt = nullptr;
+        if (sqlite3_prepare_v2(conn->db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+            sqlite3_finalize(stmt);
+            return nullptr;
+        }
+        conn->queries.emplace(sql, stmt);
+        return stmt;
+    }
+
+  private:
+    void release(Connection* conn) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (conn->generation == m_generation) {
+            m_idle.push_back(conn);
+            m_available.notify_one();
+            return;
+        }
+        --m_open;
+        m_available.notify_one();
+        lock.unlock();
+        closeConnection(conn);
+    }
+
+    Connection* openConnection(uint64_t generation) {
+        sqlite3* db = nullptr;
+        if (sqlite3_open_v2(m_path.c_str(), &db, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX,
+                            nullptr) != SQLITE_OK) {
+            sqlite3_close(db);
+            return nullptr;
+        }
+        sqlite3_busy_timeout(db, BUSY_TIMEOUT_MS);
+        Connection* conn = new Connection();
+        conn->db = db;
+        conn->generation = generation;
+        prepareStatements(conn);
+        return conn;
+    }
+
+    static void prepareStatements(Connection* conn) {
+        // Snapshots that predate the codec column are read as zlib (codec 0)
+        if (!conn->record &&
+            sqlite3_prepare_v2(conn->db,
+                               "SELECT metadata, payload, codec FROM documents WHERE id=?", -1,
+                               &conn->record, nullptr) != SQLITE_OK) {
+            sqlite3_prepare_v2(conn->db, "SELECT metadata, payload, 0 FROM documents WHERE id=?",
+                               -1, &conn->record, nullptr);
+        }
+        if (!conn->range &&
+            sqlite3_prepare_v2(conn->db,
+                               "SELECT id, metadata, payload, codec FROM documents "
+                               "WHERE id >= ? AND id <= ? ORDER BY id LIMIT ?",
+                               -1, &conn->range, nullptr) != SQLITE_OK) {
+            sqlite3_prepare_v2(conn->db,
+                               "SELECT id, metadata, payload, 0 FROM documents "
+                               "WHERE id >= ? AND id <= ? ORDER BY id LIMIT ?",
+                               -1, &conn->range, nullptr);
+        }
+        if (!conn->dictionary) {
+            sqlite3_prepare_v2(conn->db, "SELECT data FROM dictionaries WHERE id=?", -1,
+                               &conn->dictionary, nullptr);
+        }
+        if (!conn->count) {
+            sqlite3_prepare_v2(conn->db, "SELECT COUNT(*) FROM documents", -1, &conn->count,
+                               nullptr);
+        }
+    }
+
+    static void closeConnection(Connection* conn) {
+        sqlite3_finalize(conn->record);
+        sqlite3_finalize(conn->range);
+        sqlite3_finalize(conn->dictionary);
+        sqlite3_finalize(conn->count);
+        for (auto& query : conn->queries) {
+            sqlite3_finalize(query.second);
+        }
+        sqlite3_close(conn->db);
+        delete conn;
+    }
+
+    std::string m_path;
+    size_t m_maxConnections;
+    mutable std::mutex m_mutex; // guards everything below
+    std::condition_variable m_available;
+    std::vector<Connection*> m_idle;
+    size_t m_open = 0;
+    uint64_t m_generation = 0;
+};
+
+} // namespace network
+} // namespace rxrevoltchain
+
+#endif // RXREVOLTCHAIN_SQLITE_READ_POOL_HPP
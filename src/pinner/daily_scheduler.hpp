@@ -1,33 +1,89 @@
 #ifndef RXREVOLTCHAIN_DAILY_SCHEDULER_HPP
 #define RXREVOLTCHAIN_DAILY_SCHEDULER_HPP
 
+#include "compression.hpp"
 #include "daily_snapshot.hpp"
 #include "document_queue.hpp"
 #include "hashing.hpp"
 #include "logger.hpp"
+#include "merkle_tree_cache.hpp"
 #include "pinned_state.hpp"
 #include "pop_consensus.hpp"
 #include "privacy_manager.hpp"
 #include "reward_scheduler.hpp"
+#include "sharded_snapshot.hpp"
+#include "signature_verifier.hpp"
 #include "snapshot_validation.hpp"
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
+#include <functional>
+#include <future>
 #include <iostream>
+#include <memory>
 #include <mutex>
+#include <random>
 #include <stdexcept>
 #include <string>
+#include <sys/stat.h>
 #include <thread>
+#include <vector>
 
 namespace rxrevoltchain {
 namespace pinner {
 
+/*
+  DailyScheduler
+  --------------------------------
+  Runs the periodic merge cycle (merge the DocumentQueue into the snapshot, pin it,
+  validate it) and the proof-of-pinning round with its reward distribution.
+
+  Implementation notes:
+  - m_mutex only guards the settings. A cycle copies them when it starts and runs without
+    the lock, so the setters and StopScheduling never wait for a cycle; StopScheduling then
+    joins the thread, which exits as soon as the running cycle is over.
+  - m_cycleMutex serializes the loop's cycles with RunMergeCycle / RunPoPCheck.
+  - A cycle is a staged pipeline:
+      1) The PoP round for the snapshot pinned by the previous cycle is opened first (the
+         challenge tree comes from the merkle tree cache). Nodes answer while the rest of
+         the cycle runs.
+      2) MergePendingDocuments prepares chunk N+1 (redaction, compression) while chunk N is
+         inserted (see DailySnapshot).
+      3) The live data.sqlite is sealed into a new SealedSnapshotPath() file that replaces
+         the previous one (DailySnapshot::SealSnapshot). Merges rewrite the live file in
+         place, so it is never pinned or challenged itself; the previous seal, which the
+         open round challenges, is only unlinked, never modified.
+      4) Nothing writes to the new seal until the next cycle, so the IPFS pin,
+         SnapshotValidation and the merkle tree for the next PoP round all read it at the
+         same time.
+      5) The PoP round is closed: responses are validated and rewards distributed.
+  - The CID recorded in GetPinnedState() is the one returned by the pin.
+
+  Micro-batch ingestion (SetMicroBatch):
+  - A second thread merges the queue into the live data.sqlite every batch interval, or
+    as soon as the queue holds a batch of documents (DocumentQueue::SetDepthListener), so
+    new documents are queryable within seconds and the queue stays small.
+  - The scheduled cycle then merges what is left and seals, pins and challenges as above.
+  - Batches share m_cycleMutex with the cycles, so they pause while a cycle runs.
+
+  Sharded snapshots (SetShardCount > 1):
+  - Merges go through a core::ShardedSnapshot instead: the shards merge and pin in
+    parallel, and the pinned CID is that of the shard manifest.
+  - Every shard is sealed like data.sqlite (ShardedSnapshot::SealedShardPath); the sealed
+    copies are validated and get their PoP merkle trees while they are pinned.
+  - Each PoP round challenges one shard, picked with probability proportional to its file
+    size, so over the rounds every 4 KB leaf of the data is equally likely to be asked for.
+*/
+
 class DailyScheduler {
   public:
     DailyScheduler()
         : m_isRunning(false), m_interval(std::chrono::seconds(86400)) // Default 24h
           ,
-          m_dataDirectory("/var/lib/rxrevoltchain"), m_ipfsEndpoint("http://127.0.0.1:5001") {}
+          m_dataDirectory("/var/lib/rxrevoltchain"), m_ipfsEndpoint("http://127.0.0.1:5001") {
+        m_consensus.SetTreeCache(&m_treeCache);
+    }
 
     // Sets how frequently merges should occur
     void ConfigureInterval(std::chrono::seconds interval) {
@@ -45,23 +101,107 @@ class DailyScheduler {
         m_ipfsEndpoint = endpoint;
     }
 
-    // Starts the scheduling loop in a background thread
-    bool StartScheduling() {
+    // Payload compression used by the snapshot merges (codec, level, optional dictionary)
+    void SetCompression(const rxrevoltchain::util::compression::Options& options) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_compression = options;
+    }
+
+    // Deltas pinned in a row before a full snapshot (0 = pin the full file every cycle)
+    void SetDeltaMaxChain(uint32_t links) {
         std::lock_guard<std::mutex> lock(m_mutex);
+        m_deltaMaxChain = links;
+    }
 
-        if (m_isRunning) {
-            // Already running
-            rxrevoltchain::util::logger::Logger::getInstance().warn(
-                "[DailyScheduler] StartScheduling called but scheduler is already running.");
-            return true;
+    // Queue merged by every cycle (not owned); without one, cycles skip the merge
+    void SetDocumentQueue(rxrevoltchain::core::DocumentQueue* queue) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_docQueue = queue;
+    }
+
+    // Verifier merges check submissions with (not owned; nullptr = no signature checks)
+    void SetSignatureVerifier(rxrevoltchain::core::SignatureVerifier* verifier) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_signatureVerifier = verifier;
+    }
+
+    // Called on the merging thread whenever a cycle or batch commits rows, e.g. with
+    // HttpQueryServer::InvalidateCache (see PinnerNode::SetQueryServer)
+    void SetCommitListener(std::function<void()> listener) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_commitListener = std::move(listener);
+    }
+
+    // Micro-batch ingestion: merge the queue every 'interval' or once it holds
+    // 'maxDocuments', and only seal and pin in the scheduled cycle (zero interval = off,
+    // the cycle merges everything).
+    // Takes effect at the next StartScheduling.
+    void SetMicroBatch(std::chrono::milliseconds interval, size_t maxDocuments) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_batchInterval = interval;
+        m_batchDocuments = std::max<size_t>(1, maxDocuments);
+    }
+
+    // Number of SQLite shards the snapshot is split into (0 or 1 = the single data.sqlite).
+    // The count is fixed once a data directory has been merged into (see ShardedSnapshot).
+    void SetShardCount(size_t shards) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_shardCount = shards;
+    }
+
+    // Merkle trees of the pinned files, shared by the PoP rounds and the snapshots' delta
+    // bases; hand it to SnapshotSync too so a new snapshot is hashed once per format
+    rxrevoltchain::ipfs_integration::MerkleTreeCache& GetTreeCache() { return m_treeCache; }
+
+    // The copy of data.sqlite that every cycle seals, pins and challenges
+    static std::string SealedSnapshotPath(const std::string& dataDirectory) {
+        return dataDirectory + "/data.sealed.sqlite";
+    }
+
+    // CID and path of the latest pinned snapshot
+    rxrevoltchain::core::PinnedState& GetPinnedState() { return m_pinnedState; }
+
+    // Consensus that runs the PoP rounds (nodes' responses are collected here)
+    rxrevoltchain::consensus::PoPConsensus& GetConsensus() { return m_consensus; }
+
+    // Starts the scheduling loop (and the micro-batch loop, if enabled) in background threads
+    bool StartScheduling() {
+        rxrevoltchain::core::DocumentQueue* batchQueue = nullptr;
+        size_t batchDocuments = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            if (m_isRunning) {
+                // Already running
+                rxrevoltchain::util::logger::Logger::getInstance().warn(
+                    "[DailyScheduler] StartScheduling called but scheduler is already running.");
+                return true;
+            }
+
+            // Begin
+            m_isRunning = true;
+            m_batchFull = false;
+            m_schedulerThread = std::thread(&DailyScheduler::schedulerLoop, this);
+            if (m_batchInterval.count() > 0 && m_docQueue) {
+                batchQueue = m_docQueue;
+                batchDocuments = m_batchDocuments;
+                m_ingestThread = std::thread(&DailyScheduler::ingestLoop, this);
+            }
         }
 
-        // Begin
-        m_isRunning = true;
-        m_schedulerThread = std::thread(&DailyScheduler::schedulerLoop, this);
+        // The listener takes m_mutex under the queue's lock, so register it without m_mutex
+        if (batchQueue) {
+            batchQueue->SetDepthListener(batchDocuments, [this] {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_batchFull = true;
+                m_cv.notify_all();
+            });
+            m_listenedQueue = batchQueue;
+        }
 
         rxrevoltchain::util::logger::Logger::getInstance().info(
-            "[DailyScheduler] Scheduling thread started.");
+            std::string("[DailyScheduler] Scheduling thread started") +
+            (batchQueue ? " with micro-batch ingestion." : "."));
         return true;
     }
 
@@ -78,9 +218,16 @@ class DailyScheduler {
             m_cv.notify_all();
         }
 
+        if (m_listenedQueue) {
+            m_listenedQueue->SetDepthListener(0, nullptr);
+            m_listenedQueue = nullptr;
+        }
         if (m_schedulerThread.joinable()) {
             m_schedulerThread.join();
         }
+        if (m_ingestThread.joinable()) {
+            m_ingestThread.join();
+        }
 
         rxrevoltchain::util::logger::Logger::getInstance().info(
             "[DailyScheduler] Scheduling thread stopped.");
@@ -88,65 +235,184 @@ class DailyScheduler {
     }
 
     // Manually triggers a merge cycle (for testing or forced merges)
-    void RunMergeCycle() { performMerge(); }
+    void RunMergeCycle() {
+        std::lock_guard<std::mutex> cycle(m_cycleMutex);
+        performMerge(loadSettings());
+    }
 
     // Manually triggers a proof-of-pinning challenge sequence
-    void RunPoPCheck() { performPoP(); }
+    void RunPoPCheck() {
+        std::lock_guard<std::mutex> cycle(m_cycleMutex);
+        if (openPoPRound()) {
+            closePoPRound(loadSettings());
+        }
+    }
 
   private:
+    // Settings a cycle runs with, copied under m_mutex when it starts
+    struct Settings {
+        std::string dataDirectory;
+        std::string ipfsEndpoint;
+        rxrevoltchain::util::compression::Options compression;
+        uint32_t deltaMaxChain = 0;
+        rxrevoltchain::core::DocumentQueue* docQueue = nullptr;
+        rxrevoltchain::core::SignatureVerifier* signatureVerifier = nullptr;
+        std::function<void()> commitListener;
+        size_t shards = 0; // > 1: sharded layout (see SetShardCount)
+    };
+
+    Settings loadSettings() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Settings settings;
+        settings.dataDirectory = m_dataDirectory;
+        settings.ipfsEndpoint = m_ipfsEndpoint;
+        settings.compression = m_compression;
+        settings.deltaMaxChain = m_deltaMaxChain;
+        settings.docQueue = m_docQueue;
+        settings.signatureVerifier = m_signatureVerifier;
+        settings.commitListener = m_commitListener;
+        settings.shards = m_shardCount;
+        return settings;
+    }
+
     // The main loop that periodically does merges and PoP checks
     void schedulerLoop() {
         rxrevoltchain::util::logger::Logger::getInstance().info(
             "[DailyScheduler] Entering main scheduling loop.");
 
-        while (true) {
-            {
-                std::unique_lock<std::mutex> lock(m_mutex);
-                if (!m_isRunning) {
-                    break;
-                }
+        while (m_isRunning) {
+            // Perform the daily tasks, without holding m_mutex
+            runCycle();
 
-                // Perform the daily tasks
-                performMerge();
-                performPoP();
+            // Wait until next interval or until stopped
+            std::unique_lock<std::mutex> lock(m_mutex);
+            const auto nextWake = std::chrono::steady_clock::now() + m_interval;
+            m_cv.wait_until(lock, nextWake, [this] { return !m_isRunning; });
+        }
 
-                // Wait until next interval or until stopped
-                auto nextWake = std::chrono::steady_clock::now() + m_interval;
-                m_cv.wait_until(lock, nextWake, [this] { return !m_isRunning; });
-                if (!m_isRunning) {
-                    break;
-                }
+        rxrevoltchain::util::logger::Logger::getInstance().info(
+            "[DailyScheduler] Exiting main scheduling loop.");
+    }
+
+    // Merges the queue into the live snapshot every batch interval, or sooner once the
+    // queue holds a full batch
+    void ingestLoop() {
+        rxrevoltchain::util::logger::Logger::getInstance().info(
+            "[DailyScheduler] Entering micro-batch ingestion loop.");
+
+        while (m_isRunning) {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                const auto nextBatch = std::chrono::steady_clock::now() + m_batchInterval;
+                m_cv.wait_until(lock, nextBatch, [this] { return !m_isRunning || m_batchFull; });
+                m_batchFull = false;
+            }
+            if (m_isRunning) {
+                mergeBatch();
             }
         }
 
         rxrevoltchain::util::logger::Logger::getInstance().info(
-            "[DailyScheduler] Exiting main scheduling loop.");
+            "[DailyScheduler] Exiting micro-batch ingestion loop.");
+    }
+
+    void mergeBatch() {
+        std::lock_guard<std::mutex> cycle(m_cycleMutex);
+        const Settings settings = loadSettings();
+        if (!settings.docQueue || settings.docQueue->IsEmpty()) {
+            return;
+        }
+        const bool merged = settings.shards > 1
+                                ? openShards(settings).MergePendingDocuments()
+                                : openSnapshot(settings).MergePendingDocuments();
+        if (!merged) {
+            rxrevoltchain::util::logger::Logger::getInstance().error(
+                "[DailyScheduler] Micro-batch merge failed!");
+        }
+    }
+
+    // One scheduled cycle: PoP on the previous snapshot around the merge and pin of the new one
+    void runCycle() {
+        std::lock_guard<std::mutex> cycle(m_cycleMutex);
+        const Settings settings = loadSettings();
+
+        const bool popRound = openPoPRound();
+        performMerge(settings);
+        if (popRound) {
+            closePoPRound(settings);
+        }
+    }
+
+    // The DailySnapshot for the current settings; reused (with its open connection)
+    // across cycles and batches
+    rxrevoltchain::core::DailySnapshot& openSnapshot(const Settings& settings) {
+        const std::string dbPath = settings.dataDirectory + "/data.sqlite";
+        if (!m_snapshot || m_snapshotPath != dbPath) {
+            m_snapshot.reset(new rxrevoltchain::core::DailySnapshot(dbPath));
+            m_snapshotPath = dbPath;
+        }
+        rxrevoltchain::core::DailySnapshot& snapshot = *m_snapshot;
+        configureSnapshot(snapshot, settings);
+        snapshot.SetSealedFile(SealedSnapshotPath(settings.dataDirectory));
+        return snapshot;
+    }
+
+    // The ShardedSnapshot for the current settings, reused like openSnapshot's
+    rxrevoltchain::core::ShardedSnapshot& openShards(const Settings& settings) {
+        if (!m_shards || m_shardsDirectory != settings.dataDirectory ||
+            m_shards->ShardCount() != settings.shards) {
+            m_shards.reset(
+                new rxrevoltchain::core::ShardedSnapshot(settings.dataDirectory, settings.shards));
+            m_shardsDirectory = settings.dataDirectory;
+        }
+        rxrevoltchain::core::ShardedSnapshot& shards = *m_shards;
+        configureSnapshot(shards, settings);
+        shards.SetSealedFiles(true);
+        return shards;
+    }
+
+    // Settings shared by DailySnapshot and ShardedSnapshot
+    template <typename Snapshot>
+    void configureSnapshot(Snapshot& snapshot, const Settings& settings) {
+        snapshot.SetDocumentQueue(settings.docQueue);
+        snapshot.SetIPFSEndpoint(settings.ipfsEndpoint);
+        snapshot.SetCompression(settings.compression);
+        snapshot.SetDeltaMaxChain(settings.deltaMaxChain);
+
+        // Integrate a PrivacyManager so PII is stripped automatically
+        snapshot.SetPrivacyManager(&m_privacy);
+        // The pin records its CID and the file path here
+        snapshot.SetPinnedState(&m_pinnedState);
+        snapshot.SetSignatureVerifier(settings.signatureVerifier);
+        snapshot.SetCommitListener(settings.commitListener);
+        snapshot.SetTreeCache(&m_treeCache);
     }
 
     // ---------------------------
     // Actual Merge Logic
     // ---------------------------
-    void performMerge() {
-        // Example: We assume there's a globally accessible DocumentQueue,
-        // PinnedState, and a config for the DB path. In real usage, you'd
-        // supply these objects to DailyScheduler or retrieve them from
-        // appropriate singletons / managers.
-
-        static rxrevoltchain::core::DocumentQueue g_docQueue;  // For demonstration
-        static rxrevoltchain::core::PinnedState g_pinnedState; // For demonstration
-        static rxrevoltchain::util::logger::Logger& logger =
+    void performMerge(const Settings& settings) {
+        rxrevoltchain::util::logger::Logger& logger =
             rxrevoltchain::util::logger::Logger::getInstance();
 
-        const std::string dbPath = m_dataDirectory + "/data.sqlite";
+        if (!settings.docQueue) {
+            logger.warn("[DailyScheduler] No DocumentQueue set; skipping the merge.");
+            return;
+        }
 
-        // Prepare a DailySnapshot for this cycle
-        rxrevoltchain::core::DailySnapshot snapshot(dbPath);
-        snapshot.SetDocumentQueue(&g_docQueue);
-        snapshot.SetIPFSEndpoint(m_ipfsEndpoint);
+        if (settings.shards > 1) {
+            rxrevoltchain::core::ShardedSnapshot& shards = openShards(settings);
+            mergeAndPin(shards, shards.PinnedFiles());
+            return;
+        }
+        mergeAndPin(openSnapshot(settings), {SealedSnapshotPath(settings.dataDirectory)});
+    }
 
-        // Integrate a PrivacyManager so PII is stripped automatically
-        static rxrevoltchain::core::PrivacyManager g_privacy;
-        snapshot.SetPrivacyManager(&g_privacy);
+    // Merges, seals and pins 'snapshot', whose pinned (sealed) files are 'files'
+    template <typename Snapshot>
+    void mergeAndPin(Snapshot& snapshot, const std::vector<std::string>& files) {
+        rxrevoltchain::util::logger::Logger& logger =
+            rxrevoltchain::util::logger::Logger::getInstance();
 
         // Do the actual merge
         logger.info("[DailyScheduler] Starting MergePendingDocuments()");
@@ -154,77 +420,138 @@ class DailyScheduler {
             logger.error("[DailyScheduler] MergePendingDocuments failed!");
             return;
         }
-
-        // Pin the new snapshot
-        logger.info("[DailyScheduler] Pinning current snapshot...");
-        if (!snapshot.PinCurrentSnapshot()) {
-            logger.error("[DailyScheduler] PinCurrentSnapshot failed!");
+        // The live file is rewritten by every merge; pin a sealed copy of it
+        if (!snapshot.SealSnapshot()) {
+            logger.error("[DailyScheduler] SealSnapshot failed!");
             return;
         }
 
-        // Suppose snapshot updated an internal IPFS CID in pinned_state
-        // We'll track it in the global pinned state
-        // (Pretend snapshot or pinned_state logic sets this properly.)
-        const std::string pinnedCID = "QmSomeIPFSCID12345";
-        g_pinnedState.SetCurrentCID(pinnedCID);
-        g_pinnedState.SetLocalFilePath(dbPath);
+        // The seal left the pinned file complete and nothing writes to it until
+        // the next cycle: validate it and build the merkle tree for the next PoP round
+        // while it is being pinned. A delta pin needs the same tree; m_treeCache builds it
+        // once and the other caller waits for it.
+        std::future<bool> validation = std::async(std::launch::async, [this, files] {
+            for (const std::string& file : files) {
+                if (!m_validator.ValidateNewSnapshot(file) || !m_validator.IsSnapshotValid()) {
+                    return false;
+                }
+            }
+            return true;
+        });
+        std::future<void> popTree = std::async(std::launch::async, [this, files] {
+            for (const std::string& file : files) {
+                m_consensus.GetTreeCache().GetOrBuildCurrent(file, m_consensus.GetProofFormat());
+            }
+        });
+
+        logger.info("[DailyScheduler] Pinning current snapshot...");
+        const bool pinned = snapshot.PinCurrentSnapshot();
+        const bool valid = validation.get();
+        popTree.wait();
 
-        // Optionally validate the new snapshot
-        static rxrevoltchain::consensus::SnapshotValidation validator;
-        if (!validator.ValidateNewSnapshot(dbPath)) {
-            logger.error("[DailyScheduler] SnapshotValidation failed!");
+        if (!pinned) {
+            logger.error("[DailyScheduler] PinCurrentSnapshot failed!");
             return;
         }
-        if (!validator.IsSnapshotValid()) {
-            logger.error("[DailyScheduler] Snapshot is invalid despite attempts!");
+        // The PoP tree was built before the CID was known; tag it before it is challenged
+        adoptPinnedCids();
+        if (!valid) {
+            logger.error("[DailyScheduler] SnapshotValidation failed!");
             return;
         }
 
         logger.info("[DailyScheduler] Merge cycle complete. Snapshot pinned & validated.");
     }
 
+    // Records the pinned CIDs on the cached trees of the files they were pinned from
+    void adoptPinnedCids() {
+        const std::vector<rxrevoltchain::core::PinnedState::Shard> shards =
+            m_pinnedState.GetShards();
+        if (shards.empty()) {
+            m_treeCache.AdoptCid(m_pinnedState.GetLocalFilePath(), m_pinnedState.GetCurrentCID());
+        }
+        for (const auto& shard : shards) {
+            m_treeCache.AdoptCid(shard.path, shard.cid);
+        }
+    }
+
     // ---------------------------
     // Actual PoP Logic
     // ---------------------------
-    void performPoP() {
-        // Illustrative example of a real PoP flow:
-        static rxrevoltchain::consensus::PoPConsensus g_consensus;
-        static rxrevoltchain::consensus::RewardScheduler g_rewardScheduler;
-        static rxrevoltchain::util::logger::Logger& logger =
+
+    // Issues challenges for the pinned snapshot; false if nothing has been pinned yet
+    bool openPoPRound() {
+        rxrevoltchain::util::logger::Logger& logger =
             rxrevoltchain::util::logger::Logger::getInstance();
-        static rxrevoltchain::core::PinnedState g_pinnedState;
 
-        // Issue challenges based on the pinned CID
-        const std::string cidForPoP = g_pinnedState.GetCurrentCID();
+        // Only this thread (under m_cycleMutex) updates the pinned state, so copies are stable
+        std::string cidForPoP = m_pinnedState.GetCurrentCID();
         if (cidForPoP.empty()) {
             logger.warn("[DailyScheduler] No pinned CID to issue PoP challenges.");
-            return;
+            return false;
         }
 
-        const std::string filePath = g_pinnedState.GetLocalFilePath();
+        std::string filePath = m_pinnedState.GetLocalFilePath();
+        const std::vector<rxrevoltchain::core::PinnedState::Shard> shards =
+            m_pinnedState.GetShards();
+        if (!shards.empty()) {
+            const size_t shard = pickShard(shards);
+            cidForPoP = shards[shard].cid;
+            filePath = shards[shard].path;
+            logger.info("[DailyScheduler] Challenging shard " + std::to_string(shard) + " of " +
+                        std::to_string(shards.size()) + ".");
+        }
 
         logger.info("[DailyScheduler] Issuing PoP challenges for CID: " + cidForPoP);
-        g_consensus.IssueChallenges(cidForPoP, filePath);
+        m_consensus.IssueChallenges(cidForPoP, filePath);
+        return true;
+    }
+
+    // A shard drawn with probability proportional to its file size (uniform if all are empty)
+    size_t pickShard(const std::vector<rxrevoltchain::core::PinnedState::Shard>& shards) {
+        std::vector<double> weights;
+        double total = 0;
+        for (const auto& shard : shards) {
+            struct stat st;
+            weights.push_back(stat(shard.path.c_str(), &st) == 0 ? st.st_size : 0.0);
+            total += weights.back();
+        }
+        if (total <= 0) {
+            std::fill(weights.begin(), weights.end(), 1.0);
+        }
+        std::discrete_distribution<size_t> pick(weights.begin(), weights.end());
+        return pick(m_shardRng);
+    }
+
+    // Validates the responses collected since openPoPRound and distributes the rewards
+    void closePoPRound(const Settings& settings) {
+        rxrevoltchain::util::logger::Logger& logger =
+            rxrevoltchain::util::logger::Logger::getInstance();
 
         // Ensure reward scheduler uses persistent storage
-        g_rewardScheduler.SetStorageFile(m_dataDirectory + "/rewards.dat");
+        const std::string rewardsFile = settings.dataDirectory + "/rewards.dat";
+        if (!m_rewardScheduler) {
+            m_rewardScheduler.reset(new rxrevoltchain::consensus::RewardScheduler(rewardsFile));
+        } else if (m_rewardsFile != rewardsFile) {
+            m_rewardScheduler->SetStorageFile(rewardsFile);
+        }
+        m_rewardsFile = rewardsFile;
 
-        // ... in a real system, nodes respond over P2P. We'll simulate a local check:
-        // e.g. g_consensus.CollectResponse("Node123", someData);
+        // ... in a real system, nodes respond over P2P (GetConsensus().CollectResponse).
 
         // Validate
-        if (!g_consensus.ValidateResponses()) {
+        if (!m_consensus.ValidateResponses()) {
             logger.warn("[DailyScheduler] PoP ValidateResponses found failures!");
         }
 
         // See which nodes passed
-        auto passingNodes = g_consensus.GetPassingNodes();
+        auto passingNodes = m_consensus.GetPassingNodes();
         logger.info("[DailyScheduler] Passing nodes count = " +
                     std::to_string(passingNodes.size()));
 
         // Distribute rewards
-        g_rewardScheduler.RecordPassingNodes(passingNodes);
-        if (!g_rewardScheduler.DistributeRewards()) {
+        m_rewardScheduler->RecordPassingNodes(passingNodes);
+        if (!m_rewardScheduler->DistributeRewards()) {
             logger.error("[DailyScheduler] Reward distribution failed!");
         } else {
             logger.info("[DailyScheduler] Rewards distributed successfully.");
@@ -237,8 +564,34 @@ class DailyScheduler {
     std::string m_dataDirectory;
     std::string m_ipfsEndpoint;
     std::thread m_schedulerThread;
-    std::mutex m_mutex;
+    std::thread m_ingestThread; // micro-batch merges (see SetMicroBatch)
+    std::mutex m_mutex;      // settings only (see loadSettings)
+    std::mutex m_cycleMutex; // one merge / PoP cycle at a time
     std::condition_variable m_cv;
+    rxrevoltchain::ipfs_integration::MerkleTreeCache m_treeCache; // outlives its users below
+    std::unique_ptr<rxrevoltchain::core::DailySnapshot> m_snapshot; // kept open between merges
+    std::string m_snapshotPath;
+    std::unique_ptr<rxrevoltchain::core::ShardedSnapshot> m_shards; // with SetShardCount > 1
+    std::string m_shardsDirectory;
+    size_t m_shardCount = 0;
+    rxrevoltchain::util::compression::Options m_compression;
+    uint32_t m_deltaMaxChain = 0;
+    rxrevoltchain::core::DocumentQueue* m_docQueue = nullptr;
+    rxrevoltchain::core::SignatureVerifier* m_signatureVerifier = nullptr;
+    std::function<void()> m_commitListener;
+    std::chrono::milliseconds m_batchInterval{0};
+    size_t m_batchDocuments = 10000;
+    bool m_batchFull = false; // the queue reached m_batchDocuments (guarded by m_mutex)
+    rxrevoltchain::core::DocumentQueue* m_listenedQueue = nullptr; // set between Start/Stop
+
+    // Cycle state, only touched under m_cycleMutex
+    rxrevoltchain::core::PrivacyManager m_privacy;
+    rxrevoltchain::core::PinnedState m_pinnedState;
+    rxrevoltchain::consensus::SnapshotValidation m_validator;
+    rxrevoltchain::consensus::PoPConsensus m_consensus;
+    std::mt19937_64 m_shardRng{std::random_device{}()}; // see pickShard
+    std::unique_ptr<rxrevoltchain::consensus::RewardScheduler> m_rewardScheduler; // on first use
+    std::string m_rewardsFile;
 };
 
 } // namespace pinner
@@ -1,28 +1,44 @@
 #ifndef RXREVOLTCHAIN_PINNER_NODE_HPP
 #define RXREVOLTCHAIN_PINNER_NODE_HPP
 
+#include "compression.hpp"
 #include "config/node_config.hpp"
 #include "daily_scheduler.hpp"
 #include "document_queue.hpp"
+#include "network/http_query_server.hpp"
 #include "network/p2p_node.hpp"
 #include "network/protocol_messages.hpp"
 #include "network/service_manager.hpp"
+#include "network/snapshot_sync.hpp"
 #include "network/upgrade_manager.hpp"
 #include "pinner/content_moderation.hpp"
+#include "signature_verifier.hpp"
 #include "transaction.hpp"
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
 #include <mutex>
 #include <stdexcept>
 #include <string>
 #include <thread>
+#include <vector>
 
 namespace rxrevoltchain {
 namespace pinner {
 
 class PinnerNode {
   public:
+    PinnerNode() = default;
+    PinnerNode(const PinnerNode&) = delete;
+    PinnerNode& operator=(const PinnerNode&) = delete;
+
+    // Stops the event loop, scheduler and networking while every member still exists:
+    // P2P I/O threads call into m_snapshotSync, which is destroyed before m_p2pNode
+    ~PinnerNode() { StopEventLoop(); }
+
     // Applies configuration to the node and its submodules
     bool InitializeNode(const rxrevoltchain::config::NodeConfig& config) {
         std::lock_guard<std::mutex> lock(m_nodeMutex);
@@ -33,11 +49,30 @@ class PinnerNode {
         m_scheduler.ConfigureInterval(std::chrono::seconds(m_config.schedulerIntervalSeconds));
         m_scheduler.SetDataDirectory(m_config.dataDirectory);
         m_scheduler.SetIPFSEndpoint(m_config.ipfsEndpoint);
+        m_scheduler.SetCompression(compressionOptions());
+        m_scheduler.SetDeltaMaxChain(m_config.deltaSnapshotMaxChain);
+        m_scheduler.SetMicroBatch(std::chrono::seconds(m_config.ingestBatchSeconds),
+                                  m_config.ingestBatchDocuments);
+        m_scheduler.SetShardCount(m_config.snapshotShards);
+        m_scheduler.SetSignatureVerifier(
+            m_config.signaturePolicy == "require" ? &m_signatureVerifier : nullptr);
+        // Serve snapshot sync from the trees the PoP rounds and delta pins already built
+        m_snapshotSync.SetTreeCache(&m_scheduler.GetTreeCache());
 
         // Configure persistent storage for the DocumentQueue
         std::string queueFile = m_config.dataDirectory + "/document_queue.wal";
         m_docQueue.SetStorageFile(queueFile);
 
+        rxrevoltchain::core::WriteAheadLog::Options walOptions;
+        if (m_config.walFsyncPolicy == "interval") {
+            walOptions.policy = rxrevoltchain::core::WriteAheadLog::FsyncPolicy::IntervalMs;
+        } else if (m_config.walFsyncPolicy == "none") {
+            walOptions.policy = rxrevoltchain::core::WriteAheadLog::FsyncPolicy::None;
+        }
+        walOptions.fsyncIntervalMs = m_config.walFsyncIntervalMs;
+        m_docQueue.SetWalOptions(walOptions);
+        m_scheduler.SetDocumentQueue(&m_docQueue);
+
         // Register subsystems with the ServiceManager
         m_serviceManager.RegisterDocumentQueue(&m_docQueue);
         m_serviceManager.RegisterContentModeration(&m_contentModeration);
@@ -67,15 +102,19 @@ class PinnerNode {
         }
 
         m_isNodeRunning = true;
-        // Start scheduler (if not already started)
-        m_scheduler.StartScheduling();
+        const std::string dbPath = m_config.dataDirectory + "/data.sqlite";
 
         // Start P2P networking if enabled
         if (m_config.p2pPort != 0) {
+            // Merges rewrite the live file in place; peers get the pinned, sealed copy
+            m_snapshotSync.SetServedFile(
+                DailyScheduler::SealedSnapshotPath(m_config.dataDirectory));
             m_p2pNode.SetMessageCallback(
                 [this](const rxrevoltchain::network::ProtocolMessage& msg) {
                     this->HandleP2PMessage(msg);
                 });
+            m_p2pNode.SetIoThreads(m_config.p2pIoThreads);
+            m_p2pNode.SetMaxConnections(m_config.maxConnections);
             m_p2pNode.StartNetwork("0.0.0.0", m_config.p2pPort);
 
             // Connect to configured peers for discovery
@@ -89,8 +128,34 @@ class PinnerNode {
                 }
                 m_p2pNode.ConnectToPeer(addr, port);
             }
+
+            // A node without a snapshot copies the current one from its bootstrap peers
+            // before the first merge would create an empty database. Snapshot sync copies a
+            // single file; a sharded node gets its shards from IPFS (see the manifest).
+            if (m_config.snapshotShards <= 1 && !std::filesystem::exists(dbPath) &&
+                m_config.snapshotSyncTimeoutSeconds > 0 && m_p2pNode.PeerCount() > 0) {
+                auto options = m_snapshotSync.GetOptions();
+                options.timeout = std::chrono::seconds(m_config.snapshotSyncTimeoutSeconds);
+                m_snapshotSync.SetOptions(options);
+                // Only a configured root, or one a quorum of peers agrees on, is fetched
+                const std::vector<uint64_t> peers = m_p2pNode.PeerIds();
+                std::string root = m_config.snapshotSyncRoot;
+                if (root.empty()) {
+                    root = m_snapshotSync.AgreedRoot(peers, m_config.snapshotSyncQuorum);
+                }
+                if (root.empty()) {
+                    rxrevoltchain::util::logger::Logger::getInstance().warn(
+                        "[PinnerNode] No trusted snapshot root; starting without a snapshot.");
+                } else if (m_snapshotSync.Fetch(peers, root, dbPath)) {
+                    rxrevoltchain::util::logger::Logger::getInstance().info(
+                        "[PinnerNode] Bootstrapped snapshot " + root + " from peers.");
+                }
+            }
         }
 
+        // Start scheduler (if not already started)
+        m_scheduler.StartScheduling();
+
         // Launch a dedicated thread to simulate an event loop for the node
         m_eventLoopThread = std::thread(&PinnerNode::eventLoopRoutine, this);
     }
@@ -135,21 +200,73 @@ class PinnerNode {
     // Returns a reference to the scheduler for fine-grained control, if needed
     DailyScheduler& GetScheduler() { return m_scheduler; }
 
+    // Query server over this node's snapshot (not owned; nullptr detaches it). Every merge
+    // that commits rows drops the server's cached /record responses.
+    void SetQueryServer(rxrevoltchain::network::HttpQueryServer* server) {
+        if (server) {
+            m_scheduler.SetCommitListener([server]() { server->InvalidateCache(); });
+        } else {
+            m_scheduler.SetCommitListener(nullptr);
+        }
+    }
+
     // Access to the ServiceManager for governance RPCs
     rxrevoltchain::network::ServiceManager& GetServiceManager() { return m_serviceManager; }
 
-    // Broadcast a snapshot announcement to peers
+    // Broadcast a snapshot announcement to peers, with the merkle root they can sync
     void AnnounceSnapshot(const std::string& cid) {
+        rxrevoltchain::network::SnapshotAnnounce announce;
+        announce.cid = cid;
+        announce.merkleRoot = m_snapshotSync.ServedRoot();
         rxrevoltchain::network::ProtocolMessage msg;
         msg.type = "SNAPSHOT_ANNOUNCE";
-        msg.payload.assign(cid.begin(), cid.end());
+        msg.payload = announce.Encode();
         m_p2pNode.BroadcastMessage(msg);
     }
 
+    // Snapshot sync endpoint (serves data.sqlite and fetches peers' snapshots)
+    rxrevoltchain::network::SnapshotSync& GetSnapshotSync() { return m_snapshotSync; }
+
+    // Latest merkle root announced by a peer (empty until one is received)
+    std::string GetAnnouncedRoot() const {
+        std::lock_guard<std::mutex> lock(m_announceMutex);
+        return m_announcedRoot;
+    }
+
   private:
+    // Maps the compression* config keys to codec options, loading the dictionary file if set
+    rxrevoltchain::util::compression::Options compressionOptions() const {
+        using namespace rxrevoltchain::util::compression;
+        Options options;
+        parseCodec(m_config.compressionCodec, options.codec);
+        options.level = m_config.compressionLevel;
+        if (options.codec == Codec::Zstd && !m_config.compressionDictionary.empty()) {
+            std::ifstream in(m_config.compressionDictionary, std::ios::binary);
+            std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(in)),
+                                       std::istreambuf_iterator<char>());
+            options.dictionary = Dictionary::FromBytes(std::move(bytes), options.level);
+            if (!options.dictionary) {
+                rxrevoltchain::util::logger::Logger::getInstance().warn(
+                    "[PinnerNode] Could not load compression dictionary " +
+                    m_config.compressionDictionary + "; compressing without one.");
+            }
+        }
+        return options;
+    }
+
     // Callback from P2PNode when a message arrives
     void HandleP2PMessage(const rxrevoltchain::network::ProtocolMessage& msg) {
-        if (msg.type == "POP_REQUEST") {
+        if (m_snapshotSync.HandleMessage(msg)) {
+            return;
+        }
+        if (msg.type == "SNAPSHOT_ANNOUNCE") {
+            // Remember the root; the live database is not swapped underneath the scheduler
+            rxrevoltchain::network::SnapshotAnnounce announce;
+            if (announce.Decode(msg.payload) && !announce.merkleRoot.empty()) {
+                std::lock_guard<std::mutex> lock(m_announceMutex);
+                m_announcedRoot = announce.merkleRoot;
+            }
+        } else if (msg.type == "POP_REQUEST") {
             // Placeholder: in a real node we'd generate proof and reply
         } else if (msg.type == "POP_RESPONSE") {
             // Validate responses here
@@ -189,12 +306,22 @@ class PinnerNode {
 
     // Core subsystems
     rxrevoltchain::core::DocumentQueue m_docQueue;
+    rxrevoltchain::core::SignatureVerifier m_signatureVerifier;
     DailyScheduler m_scheduler;
     rxrevoltchain::config::NodeConfig m_config;
     rxrevoltchain::network::P2PNode m_p2pNode;
     rxrevoltchain::network::ServiceManager m_serviceManager;
     rxrevoltchain::pinner::ContentModeration m_contentModeration;
     rxrevoltchain::network::UpgradeManager m_upgradeManager;
+
+    // Sends through m_p2pNode, which therefore outlives it (members are destroyed in
+    // reverse order); the destructor stops networking before either is destroyed
+    rxrevoltchain::network::SnapshotSync m_snapshotSync{
+        [this](uint64_t peerId, const rxrevoltchain::network::ProtocolMessage& msg) {
+            return m_p2pNode.SendToPeer(peerId, msg);
+        }};
+    mutable std::mutex m_announceMutex;
+    std::string m_announcedRoot;
 };
 
 } // namespace pinner
@@ -1,15 +1,17 @@
 #ifndef RXREVOLTCHAIN_PROOF_GENERATOR_HPP
 #define RXREVOLTCHAIN_PROOF_GENERATOR_HPP
 
+#include "ipfs_integration/chunk_reader.hpp"
+#include "ipfs_integration/merkle_proof.hpp"
 #include <vector>
 #include <string>
 #include <random>
-#include <fstream>
 #include <algorithm>
 #include <stdexcept>
 #include <cstdint>
 #include <ctime>
 #include <mutex>
+#include <unordered_set>
 
 namespace rxrevoltchain {
 namespace pinner {
@@ -28,13 +30,18 @@ namespace pinner {
 
   "Fully functional" approach:
    - GenerateRandomOffsets: returns 'count' random positions in [0..fileSize-1] (or up to fileSize - chunkSize, depending on usage).
+   - GenerateLeafIndices: returns distinct, sorted merkle leaf indices, which is what
+     PoPConsensus challenges and MerkleProof proves (leaf i covers the bytes
+     [i * chunkSize, (i + 1) * chunkSize)).
    - ExtractChunks: for each offset, reads 'chunkSize' bytes from 'filePath' (or less if near EOF).
    - CompareChunks: basic equality check between two byte vectors.
 
    Notes:
-   - For large files, you may want more advanced chunking or streaming logic.
+   - Chunks are copied out of the file's shared read-only mapping
+     (ipfs_integration::ChunkReader), so answering many challenges on the same snapshot
+     maps it once and costs one memcpy per chunk instead of a stream, seek and read.
    - This demonstration uses std::mt19937 for random generation.
-   - Make sure to seed or handle concurrency as needed if random offsets are called frequently.
+   - The random engine is guarded by a mutex, so one generator may serve several threads.
 */
 
 class ProofGenerator
@@ -51,10 +58,8 @@ public:
     /*
       GenerateRandomOffsets
       --------------------------------
-      - Returns 'count' random positions within [0..fileSize-1].
-      - If you want chunk-based logic, you could ensure offsets align to chunk boundaries
-        or reduce the upper bound (e.g., fileSize - chunkSize).
-      - For demonstration, we simply pick random positions in [0..fileSize-1].
+      - Returns 'count' random byte positions within [0..fileSize-1].
+      - These are not aligned to merkle leaves; use GenerateLeafIndices for PoP challenges.
     */
     std::vector<size_t> GenerateRandomOffsets(size_t fileSize, size_t count)
     {
@@ -67,6 +72,7 @@ public:
 
         std::vector<size_t> offsets;
         offsets.reserve(count);
+        std::lock_guard<std::mutex> lock(m_rngMutex);
         for (size_t i = 0; i < count; i++)
         {
             offsets.push_back(dist(m_rng));
@@ -74,15 +80,61 @@ public:
         return offsets;
     }
 
+    /*
+      GenerateLeafIndices
+      --------------------------------
+      - Picks 'count' distinct leaf indices of a file of 'fileSize' bytes split into
+        'chunkSize' leaves (the last one may be partial), in ascending order.
+      - If the file has no more than 'count' leaves, every leaf is returned.
+      - Sorted indices let the chunk reads and a multi-proof walk the file front to back.
+    */
+    std::vector<size_t> GenerateLeafIndices(
+        size_t fileSize, size_t count,
+        size_t chunkSize = ipfs_integration::MerkleProof::DEFAULT_CHUNK_SIZE)
+    {
+        if (fileSize == 0 || count == 0 || chunkSize == 0)
+        {
+            return {};
+        }
+        const size_t leaves = (fileSize + chunkSize - 1) / chunkSize;
+
+        std::vector<size_t> indices;
+        if (count >= leaves)
+        {
+            indices.resize(leaves);
+            for (size_t i = 0; i < leaves; i++)
+            {
+                indices[i] = i;
+            }
+            return indices;
+        }
+
+        // Floyd's sampling: 'count' distinct values without touching every leaf
+        std::unordered_set<size_t> picked;
+        {
+            std::lock_guard<std::mutex> lock(m_rngMutex);
+            for (size_t j = leaves - count; j < leaves; j++)
+            {
+                const size_t t = std::uniform_int_distribution<size_t>(0, j)(m_rng);
+                picked.insert(picked.count(t) ? j : t);
+            }
+        }
+        indices.assign(picked.begin(), picked.end());
+        std::sort(indices.begin(), indices.end());
+        return indices;
+    }
+
     /*
       ExtractChunks
       --------------------------------
       - For each offset in 'offsets', reads 'chunkSize' bytes (or until EOF) from the file.
       - Concatenates all extracted data in a single buffer (some PoP schemes might store them separately).
       - Returns the combined buffer.
+      - Offsets are byte positions; pass index * chunkSize to extract merkle leaves.
+      - Offsets at or past EOF contribute nothing.
 
-      If you want them separate, you could store each chunk in a structure or return a vector<vector<uint8_t>>.
-      But the spec says a single std::vector<uint8_t>, so we’ll just append them.
+      The bytes come straight from the file's shared mapping into the result, which is sized
+      once up front.
     */
     std::vector<uint8_t> ExtractChunks(const std::string &filePath,
                                        const std::vector<size_t> &offsets,
@@ -94,32 +146,19 @@ public:
             return allChunks; // empty
         }
 
-        std::ifstream ifs(filePath, std::ios::binary);
-        if (!ifs.is_open())
+        auto file = ipfs_integration::ChunkReader::getInstance().Map(filePath);
+        if (!file)
         {
             throw std::runtime_error("ProofGenerator::ExtractChunks - Failed to open file: " + filePath);
         }
 
+        allChunks.resize(offsets.size() * chunkSize);
+        size_t used = 0;
         for (auto off : offsets)
         {
-            // Seek to 'off'
-            ifs.seekg(static_cast<std::streamoff>(off), std::ios::beg);
-            if (!ifs.good())
-            {
-                // Seek may fail if 'off' is beyond EOF
-                continue;
-            }
-
-            // Read chunkSize bytes (or less if near EOF)
-            std::vector<uint8_t> chunk(chunkSize, 0);
-            ifs.read(reinterpret_cast<char*>(chunk.data()), chunkSize);
-            size_t bytesRead = static_cast<size_t>(ifs.gcount());
-            chunk.resize(bytesRead);
-
-            // Append to allChunks
-            allChunks.insert(allChunks.end(), chunk.begin(), chunk.end());
+            used += file->Read(off, chunkSize, allChunks.data() + used);
         }
-
+        allChunks.resize(used);
         return allChunks;
     }
 
@@ -141,6 +180,7 @@ public:
 
 private:
     // We keep a random engine for generating offsets
+    std::mutex m_rngMutex;
     std::mt19937_64 m_rng;
 };
 
@@ -0,0 +1,214 @@
+#ifndef RXREVOLTCHAIN_UTIL_BASE64_HPP
+#define RXREVOLTCHAIN_UTIL_BASE64_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <immintrin.h>
+#define RXREVOLTCHAIN_BASE64_X86 1
+#else
+#define RXREVOLTCHAIN_BASE64_X86 0
+#endif
+
+/**
+ * @file base64.hpp
+ * @brief Standard (RFC 4648, padded) base64 encoding for HTTP responses.
+ *
+ * DESIGN:
+ *   - encode() writes into a caller-provided buffer of encodedSize(len) bytes, so a
+ *     response can be encoded straight into its output string without an intermediate copy.
+ *   - The SSSE3 kernel turns 12 input bytes into 16 characters per step: one pshufb gathers
+ *     the 3-byte groups, two 16-bit multiplies move the four 6-bit fields of each group into
+ *     separate bytes, and a second pshufb maps each value range to its ASCII offset. The
+ *     scalar loop (one table lookup per character) handles the tail and CPUs without SSSE3.
+ *   - The kernel is compiled with a function-level target attribute, so the rest of the
+ *     project needs no special compiler flags. The backend is picked once from the CPU
+ *     features; setBackend() overrides it (benchmarks, tests).
+ *
+ * USAGE:
+ *   @code
+ *   using namespace rxrevoltchain::util;
+ *   std::string text = base64::encode(bytes.data(), bytes.size());
+ *   base64::append(json, payload.data(), payload.size());
+ *   @endcode
+ */
+
+namespace rxrevoltchain {
+namespace util {
+namespace base64 {
+
+/** Implementations available for encode(). */
+enum class Backend
+{
+    Scalar = 0, ///< Table lookup per character; always available
+    Ssse3 = 1   ///< 16 characters per step with SSSE3 shuffles
+};
+
+namespace detail {
+
+static constexpr char kAlphabet[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/** Encode 'len' bytes, padding the final group; returns characters written. */
+inline size_t encodeScalar(const uint8_t *in, size_t len, char *out)
+{
+    char *p = out;
+    size_t i = 0;
+    for (; i + 3 <= len; i += 3) {
+        const uint32_t v = (uint32_t(in[i]) << 16) | (uint32_t(in[i + 1]) << 8) | in[i + 2];
+        p[0] = kAlphabet[v >> 18];
+        p[1] = kAlphabet[(v >> 12) & 0x3F];
+        p[2] = kAlphabet[(v >> 6) & 0x3F];
+        p[3] = kAlphabet[v & 0x3F];
+        p += 4;
+    }
+    if (i < len) {
+        const bool two = i + 1 < len;
+        const uint32_t v = (uint32_t(in[i]) << 16) | (two ? uint32_t(in[i + 1]) << 8 : 0);
+        p[0] = kAlphabet[v >> 18];
+        p[1] = kAlphabet[(v >> 12) & 0x3F];
+        p[2] = two ? kAlphabet[(v >> 6) & 0x3F] : '=';
+        p[3] = '=';
+        p += 4;
+    }
+    return static_cast<size_t>(p - out);
+}
+
+#if RXREVOLTCHAIN_BASE64_X86
+
+inline bool cpuHasSsse3()
+{
+    unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+    return __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_SSSE3);
+}
+
+/**
+ * @brief Encode all whole 12-byte steps that can be loaded as 16 bytes; the rest (at
+ *        least four input bytes, unless the input is shorter than 16) is left to the
+ *        scalar loop.
+ * @return Input bytes consumed; 4/3 as many characters were written.
+ */
+__attribute__((target("ssse3"))) inline size_t encodeSsse3(const uint8_t *in, size_t len,
+                                                           char *out)
+{
+    // Bytes (1,0,2,1) of each 3-byte group, so every 32-bit lane holds one group
+    const __m128i gather = _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+    const __m128i maskAc = _mm_set1_epi32(0x0FC0FC00);
+    const __m128i shiftAc = _mm_set1_epi32(0x04000040);
+    const __m128i maskBd = _mm_set1_epi32(0x003F03F0);
+    const __m128i shiftBd = _mm_set1_epi32(0x01000010);
+    // ASCII offset per value range, indexed by the range code computed below
+    const __m128i offsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                          '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                          '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+    size_t i = 0;
+    char *p = out;
+    for (; i + 16 <= len; i += 12, p += 16) {
+        __m128i v = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i)),
+                                     gather);
+        // Split each group into four 6-bit values, one per byte
+        const __m128i ac = _mm_mulhi_epu16(_mm_and_si128(v, maskAc), shiftAc);
+        const __m128i bd = _mm_mullo_epi16(_mm_and_si128(v, maskBd), shiftBd);
+        const __m128i values = _mm_or_si128(ac, bd);
+        // Range code: 0 for 26..51, 1..10 for digits, 11 '+', 12 '/', 13 for 0..25
+        __m128i code = _mm_subs_epu8(values, _mm_set1_epi8(51));
+        const __m128i upper = _mm_cmpgt_epi8(_mm_set1_epi8(26), values);
+        code = _mm_or_si128(code, _mm_and_si128(upper, _mm_set1_epi8(13)));
+        const __m128i ascii = _mm_add_epi8(values, _mm_shuffle_epi8(offsets, code));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(p), ascii);
+    }
+    return i;
+}
+
+#else // !RXREVOLTCHAIN_BASE64_X86
+
+inline bool cpuHasSsse3() { return false; }
+
+#endif
+
+} // namespace detail
+
+/** True if 'backend' can run on this CPU. */
+inline bool backendAvailable(Backend backend)
+{
+    static const bool ssse3 = detail::cpuHasSsse3();
+    return backend == Backend::Ssse3 ? ssse3 : true;
+}
+
+namespace detail {
+
+inline std::atomic<int> &activeBackendSlot()
+{
+    static std::atomic<int> slot(static_cast<int>(
+        backendAvailable(Backend::Ssse3) ? Backend::Ssse3 : Backend::Scalar));
+    return slot;
+}
+
+} // namespace detail
+
+/** Backend currently used by encode(). */
+inline Backend backend()
+{
+    return static_cast<Backend>(detail::activeBackendSlot().load(std::memory_order_relaxed));
+}
+
+/**
+ * @brief Select the backend for encode().
+ * @return false (and no change) if the backend is not supported on this CPU.
+ */
+inline bool setBackend(Backend backend)
+{
+    if (!backendAvailable(backend)) {
+        return false;
+    }
+    detail::activeBackendSlot().store(static_cast<int>(backend), std::memory_order_relaxed);
+    return true;
+}
+
+/** Characters needed for 'len' input bytes, padding included. */
+inline size_t encodedSize(size_t len)
+{
+    return (len + 2) / 3 * 4;
+}
+
+/**
+ * @brief Encode 'len' bytes into 'out', which must hold encodedSize(len) characters.
+ * @return Characters written (always encodedSize(len)).
+ */
+inline size_t encode(const uint8_t *in, size_t len, char *out)
+{
+    size_t consumed = 0;
+#if RXREVOLTCHAIN_BASE64_X86
+    if (backend() == Backend::Ssse3) {
+        consumed = detail::encodeSsse3(in, len, out);
+    }
+#endif
+    const size_t written = consumed / 3 * 4;
+    return written + detail::encodeScalar(in + consumed, len - consumed, out + written);
+}
+
+/** Append the encoding of 'len' bytes to 'out'. */
+inline void append(std::string &out, const uint8_t *in, size_t len)
+{
+    const size_t start = out.size();
+    out.resize(start + encodedSize(len));
+    encode(in, len, &out[start]);
+}
+
+/** The encoding of 'len' bytes as a new string. */
+inline std::string encode(const uint8_t *in, size_t len)
+{
+    std::string out;
+    append(out, in, len);
+    return out;
+}
+
+} // namespace base64
+} // namespace util
+} // namespace rxrevoltchain
+
+#endif // RXREVOLTCHAIN_UTIL_BASE64_HPP
@@ -0,0 +1,349 @@
+#ifndef RXREVOLTCHAIN_UTIL_COMPRESSION_HPP
+#define RXREVOLTCHAIN_UTIL_COMPRESSION_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+#include <zlib.h>
+#include "thread_pool.hpp"
+
+#ifdef RXREVOLT_HAVE_ZSTD
+#include <zdict.h>
+#include <zstd.h>
+#endif
+
+/**
+ * @file compression.hpp
+ * @brief Payload codecs for documents stored in the snapshot database.
+ *
+ * DESIGN:
+ *   - Two codecs, identified by the integer stored in the documents.codec column:
+ *       Zlib (0) - zlib stream; the format every snapshot used before the column existed.
+ *       Zstd (1) - zstd frame, optionally compressed against a dictionary. The frame header
+ *                  carries the dictionary ID, so readers find the dictionary without a
+ *                  separate column.
+ *   - zstd support is compiled in when CMake finds libzstd (RXREVOLT_HAVE_ZSTD). Without
+ *     it, Zstd is reported unavailable and compress/decompress for it fail cleanly.
+ *   - Dictionary holds a trained zstd dictionary plus its pre-digested compression and
+ *     decompression forms, shared read-only between threads.
+ *   - compressBatch() compresses many payloads on the shared ThreadPool; outputs keep the
+ *     input order, so callers can insert them sequentially afterwards.
+ *
+ * USAGE:
+ *   @code
+ *   using namespace rxrevoltchain::util::compression;
+ *   Options opts;
+ *   opts.codec = Codec::Zstd;
+ *   opts.dictionary = Dictionary::Train(samples, 64 * 1024);
+ *   std::vector<uint8_t> packed, plain;
+ *   compress(opts, data.data(), data.size(), packed);
+ *   decompress(Codec::Zstd, packed.data(), packed.size(), plain, MAX_PAYLOAD_BYTES,
+ *              opts.dictionary.get());
+ *   @endcode
+ */
+
+namespace rxrevoltchain {
+namespace util {
+namespace compression {
+
+/** Codec tag stored per row; values are persisted, never renumber them. */
+enum class Codec : int
+{
+    Zlib = 0,
+    Zstd = 1
+};
+
+inline const char* codecName(Codec codec)
+{
+    return codec == Codec::Zstd ? "zstd" : "zlib";
+}
+
+/** Parses "zlib" / "zstd"; returns false for anything else. */
+inline bool parseCodec(const std::string& name, Codec& codec)
+{
+    if (name == "zlib") {
+        codec = Codec::Zlib;
+        return true;
+    }
+    if (name == "zstd") {
+        codec = Codec::Zstd;
+        return true;
+    }
+    return false;
+}
+
+/** True if this build can compress and decompress with 'codec'. */
+inline bool codecAvailable(Codec codec)
+{
+#ifdef RXREVOLT_HAVE_ZSTD
+    (void)codec;
+    return true;
+#else
+    return codec == Codec::Zlib;
+#endif
+}
+
+/**
+ * @class Dictionary
+ * @brief A zstd dictionary (raw bytes + ID) with cached digested forms.
+ */
+class Dictionary
+{
+public:
+    /**
+     * @brief Wrap raw dictionary bytes (e.g. loaded from disk or the snapshot).
+     * @return nullptr if zstd is unavailable or the bytes are not a usable dictionary.
+     */
+    static std::shared_ptr<Dictionary> FromBytes(std::vector<uint8_t> bytes, int level = 19)
+    {
+#ifdef RXREVOLT_HAVE_ZSTD
+        if (bytes.empty()) {
+            return nullptr;
+        }
+        std::shared_ptr<Dictionary> dict(new Dictionary());
+        dict->bytes_ = std::move(bytes);
+        dict->id_ = ZDICT_getDictID(dict->bytes_.data(), dict->bytes_.size());
+        dict->level_ = level;
+        dict->cdict_ = ZSTD_createCDict(dict->bytes_.data(), dict->bytes_.size(), level);
+        dict->ddict_ = ZSTD_createDDict(dict->bytes_.data(), dict->bytes_.size());
+        if (!dict->cdict_ || !dict->ddict_) {
+            return nullptr;
+        }
+        return dict;
+#else
+        (void)bytes;
+        (void)level;
+        return nullptr;
+#endif
+    }
+
+    /**
+     * @brief Train a dictionary from sample payloads (ZDICT_trainFromBuffer).
+     * @param capacity Maximum dictionary size in bytes (e.g. 64 KiB).
+     * @return nullptr if zstd is unavailable or training failed (e.g. too few samples).
+     */
+    static std::shared_ptr<Dictionary> Train(const std::vector<std::vector<uint8_t>>& samples,
+                                             size_t capacity, int level = 19)
+    {
+#ifdef RXREVOLT_HAVE_ZSTD
+        std::vector<uint8_t> joined;
+        std::vector<size_t> sizes;
+        sizes.reserve(samples.size());
+        for (const auto& sample : samples) {
+            joined.insert(joined.end(), sample.begin(), sample.end());
+            sizes.push_back(sample.size());
+        }
+        std::vector<uint8_t> dict(capacity);
+        size_t size = ZDICT_trainFromBuffer(dict.data(), dict.size(), joined.data(), sizes.data(),
+                                            static_cast<unsigned>(sizes.size()));
+        if (ZDICT_isError(size)) {
+            return nullptr;
+        }
+        dict.resize(size);
+        return FromBytes(std::move(dict), level);
+#else
+        (void)samples;
+        (void)capacity;
+        (void)level;
+        return nullptr;
+#endif
+    }
+
+    ~Dictionary()
+    {
+#ifdef RXREVOLT_HAVE_ZSTD
+        ZSTD_freeCDict(cdict_);
+        ZSTD_freeDDict(ddict_);
+#endif
+    }
+
+    Dictionary(const Dictionary&) = delete;
+    Dictionary& operator=(const Dictionary&) = delete;
+
+    /** zstd dictionary ID, as written into frame headers. */
+    uint32_t id() const { return id_; }
+
+    /** Compression level the dictionary was digested for. */
+    int level() const { return level_; }
+
+    const std::vector<uint8_t>& bytes() const { return bytes_; }
+
+#ifdef RXREVOLT_HAVE_ZSTD
+    const ZSTD_CDict* cdict() const { return cdict_; }
+    const ZSTD_DDict* ddict() const { return ddict_; }
+#endif
+
+private:
+    Dictionary() = default;
+
+    std::vector<uint8_t> bytes_;
+    uint32_t id_ = 0;
+    int level_ = 0;
+#ifdef RXREVOLT_HAVE_ZSTD
+    ZSTD_CDict* cdict_ = nullptr;
+    ZSTD_DDict* ddict_ = nullptr;
+#endif
+};
+
+/** Compression settings; cheap to copy (the dictionary is shared). */
+struct Options
+{
+    Codec codec = Codec::Zlib;
+    int level = 9; ///< zlib 0-9, zstd 1-22; ignored when a dictionary is set (its level wins)
+    std::shared_ptr<const Dictionary> dictionary; ///< zstd only
+};
+
+/**
+ * @brief Compress 'len' bytes into 'out' (resized to the compressed size).
+ * @return false on codec errors or if the codec is unavailable in this build.
+ */
+inline bool compress(const Options& opts, const uint8_t* data, size_t len,
+                     std::vector<uint8_t>& out)
+{
+    if (opts.codec == Codec::Zlib) {
+        uLongf outSize = compressBound(static_cast<uLong>(len));
+        out.resize(outSize);
+        if (compress2(out.data(), &outSize, data, static_cast<uLong>(len), opts.level) != Z_OK) {
+            return false;
+        }
+        out.resize(outSize);
+        return true;
+    }
+#ifdef RXREVOLT_HAVE_ZSTD
+    // One context per thread, reused across calls
+    thread_local std::unique_ptr<ZSTD_CCtx, size_t (*)(ZSTD_CCtx*)> cctx(ZSTD_createCCtx(),
+                                                                        ZSTD_freeCCtx);
+    out.resize(ZSTD_compressBound(len));
+    size_t n = opts.dictionary
+                   ? ZSTD_compress_usingCDict(cctx.get(), out.data(), out.size(), data, len,
+                                              opts.dictionary->cdict())
+                   : ZSTD_compressCCtx(cctx.get(), out.data(), out.size(), data, len, opts.level);
+    if (ZSTD_isError(n)) {
+        return false;
+    }
+    out.resize(n);
+    return true;
+#else
+    return false;
+#endif
+}
+
+/** Dictionary ID referenced by a zstd frame (0 = none or not a zstd frame). */
+inline uint32_t frameDictionaryId(const uint8_t* data, size_t len)
+{
+#ifdef RXREVOLT_HAVE_ZSTD
+    return ZSTD_getDictID_fromFrame(data, len);
+#else
+    (void)data;
+    (void)len;
+    return 0;
+#endif
+}
+
+/**
+ * Limit callers pass to decompress() for a stored document payload. Submissions arrive in
+ * P2P frames of at most 10 MiB, so genuine payloads stay well below it.
+ */
+constexpr size_t MAX_PAYLOAD_BYTES = size_t(64) << 20;
+
+/**
+ * @brief Decompress a payload stored with 'codec' into 'out'.
+ * @param maxOutput Largest decompressed size accepted. Compressed input may come from
+ *        peers, so neither the zstd frame header nor the zlib stream is trusted to bound
+ *        the allocation; decoding fails as soon as the output would exceed this.
+ * @param dict Dictionary for zstd frames that reference one (must match its ID).
+ * @return false on corrupt input, output above 'maxOutput', a missing/mismatched
+ *         dictionary or an unavailable codec.
+ */
+inline bool decompress(Codec codec, const uint8_t* data, size_t len, std::vector<uint8_t>& out,
+                       size_t maxOutput, const Dictionary* dict = nullptr)
+{
+    out.clear();
+    if (len == 0) {
+        return true;
+    }
+    if (codec == Codec::Zlib) {
+        if (len > std::numeric_limits<uInt>::max()) {
+            return false;
+        }
+        z_stream zs{};
+        if (inflateInit(&zs) != Z_OK) {
+            return false;
+        }
+        zs.next_in = const_cast<Bytef*>(data);
+        zs.avail_in = static_cast<uInt>(len);
+        int rc = Z_OK;
+        // Room for one byte past the limit tells a stream of exactly maxOutput bytes from
+        // a longer one
+        while (rc == Z_OK && out.size() <= maxOutput) {
+            const size_t have = out.size();
+            const size_t grow = std::min<size_t>({std::max<size_t>(len * 4, 4096),
+                                                  maxOutput - have + 1, size_t(1) << 30});
+            out.resize(have + grow);
+            zs.next_out = out.data() + have;
+            zs.avail_out = static_cast<uInt>(grow);
+            rc = inflate(&zs, Z_NO_FLUSH);
+            out.resize(out.size() - zs.avail_out);
+        }
+        inflateEnd(&zs);
+        return rc == Z_STREAM_END && out.size() <= maxOutput;
+    }
+#ifdef RXREVOLT_HAVE_ZSTD
+    const uint32_t wanted = ZSTD_getDictID_fromFrame(data, len);
+    if (wanted != 0 && (!dict || dict->id() != wanted)) {
+        return false;
+    }
+    thread_local std::unique_ptr<ZSTD_DCtx, size_t (*)(ZSTD_DCtx*)> dctx(ZSTD_createDCtx(),
+                                                                        ZSTD_freeDCtx);
+    // The declared size comes from the (untrusted) frame header; the decoder never writes
+    // past out.size(), so a frame that lies about it fails instead of overflowing
+    unsigned long long size = ZSTD_getFrameContentSize(data, len);
+    if (size == ZSTD_CONTENTSIZE_ERROR || size == ZSTD_CONTENTSIZE_UNKNOWN || size > maxOutput) {
+        return false;
+    }
+    out.resize(static_cast<size_t>(size));
+    size_t n = wanted ? ZSTD_decompress_usingDDict(dctx.get(), out.data(), out.size(), data, len,
+                                                   dict->ddict())
+                      : ZSTD_decompressDCtx(dctx.get(), out.data(), out.size(), data, len);
+    if (ZSTD_isError(n)) {
+        return false;
+    }
+    out.resize(n);
+    return true;
+#else
+    (void)maxOutput;
+    (void)dict;
+    return false;
+#endif
+}
+
+/**
+ * @brief Compress every input in parallel on the shared ThreadPool.
+ * @param inputs  Payloads to compress (pointers must stay valid for the call).
+ * @param outputs Resized to inputs.size(); outputs[i] is the compressed inputs[i].
+ * @return false if any payload failed to compress.
+ */
+inline bool compressBatch(const Options& opts,
+                          const std::vector<const std::vector<uint8_t>*>& inputs,
+                          std::vector<std::vector<uint8_t>>& outputs)
+{
+    outputs.resize(inputs.size());
+    std::vector<char> ok(inputs.size(), 1);
+    // Small grain: a document is already a sizeable unit of work
+    ThreadPool::getInstance().parallelFor(inputs.size(), 8, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const std::vector<uint8_t>& in = *inputs[i];
+            ok[i] = compress(opts, in.data(), in.size(), outputs[i]) ? 1 : 0;
+        }
+    });
+    return std::all_of(ok.begin(), ok.end(), [](char v) { return v != 0; });
+}
+
+} // namespace compression
+} // namespace util
+} // namespace rxrevoltchain
+
+#endif // RXREVOLTCHAIN_UTIL_COMPRESSION_HPP
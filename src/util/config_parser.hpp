@@ -136,6 +136,100 @@ class ConfigParser {
             rxrevoltchain::util::logger::debug(
                 "ConfigParser: schedulerIntervalSeconds set to " +
                 std::to_string(nodeConfig_.schedulerIntervalSeconds));
+        } else if (key == "walFsyncPolicy") {
+            if (val != "always" && val != "interval" && val != "none") {
+                throw std::runtime_error(
+                    "ConfigParser: walFsyncPolicy must be always, interval or none, got '" + val +
+                    "'");
+            }
+            nodeConfig_.walFsyncPolicy = val;
+            rxrevoltchain::util::logger::debug("ConfigParser: walFsyncPolicy set to " + val);
+        } else if (key == "walFsyncIntervalMs") {
+            nodeConfig_.walFsyncIntervalMs = static_cast<uint32_t>(parseUInt(val));
+            rxrevoltchain::util::logger::debug("ConfigParser: walFsyncIntervalMs set to " +
+                                               std::to_string(nodeConfig_.walFsyncIntervalMs));
+        } else if (key == "p2pIoThreads") {
+            nodeConfig_.p2pIoThreads = static_cast<uint32_t>(parseUInt(val));
+            rxrevoltchain::util::logger::debug("ConfigParser: p2pIoThreads set to " +
+                                               std::to_string(nodeConfig_.p2pIoThreads));
+        } else if (key == "snapshotSyncTimeoutSeconds") {
+            nodeConfig_.snapshotSyncTimeoutSeconds = static_cast<uint32_t>(parseUInt(val));
+            rxrevoltchain::util::logger::debug(
+                "ConfigParser: snapshotSyncTimeoutSeconds set to " +
+                std::to_string(nodeConfig_.snapshotSyncTimeoutSeconds));
+        } else if (key == "snapshotSyncRoot") {
+            nodeConfig_.snapshotSyncRoot = val;
+            rxrevoltchain::util::logger::debug("ConfigParser: snapshotSyncRoot set to " + val);
+        } else if (key == "snapshotSyncQuorum") {
+            const uint64_t quorum = parseUInt(val);
+            if (quorum < 1) {
+                throw std::runtime_error(
+                    "ConfigParser: snapshotSyncQuorum must be at least 1, got '" + val + "'");
+            }
+            nodeConfig_.snapshotSyncQuorum = static_cast<uint32_t>(quorum);
+            rxrevoltchain::util::logger::debug("ConfigParser: snapshotSyncQuorum set to " +
+                                               std::to_string(nodeConfig_.snapshotSyncQuorum));
+        } else if (key == "deltaSnapshotMaxChain") {
+            nodeConfig_.deltaSnapshotMaxChain = static_cast<uint32_t>(parseUInt(val));
+            rxrevoltchain::util::logger::debug("ConfigParser: deltaSnapshotMaxChain set to " +
+                                               std::to_string(nodeConfig_.deltaSnapshotMaxChain));
+        } else if (key == "ingestBatchSeconds") {
+            nodeConfig_.ingestBatchSeconds = static_cast<uint32_t>(parseUInt(val));
+            rxrevoltchain::util::logger::debug("ConfigParser: ingestBatchSeconds set to " +
+                                               std::to_string(nodeConfig_.ingestBatchSeconds));
+        } else if (key == "ingestBatchDocuments") {
+            nodeConfig_.ingestBatchDocuments = static_cast<uint32_t>(parseUInt(val));
+            rxrevoltchain::util::logger::debug("ConfigParser: ingestBatchDocuments set to " +
+                                               std::to_string(nodeConfig_.ingestBatchDocuments));
+        } else if (key == "snapshotShards") {
+            const uint64_t shards = parseUInt(val);
+            if (shards < 1 || shards > 256) {
+                throw std::runtime_error(
+                    "ConfigParser: snapshotShards must be between 1 and 256, got '" + val + "'");
+            }
+            nodeConfig_.snapshotShards = static_cast<uint32_t>(shards);
+            rxrevoltchain::util::logger::debug("ConfigParser: snapshotShards set to " +
+                                               std::to_string(nodeConfig_.snapshotShards));
+        } else if (key == "signaturePolicy") {
+            if (val != "off" && val != "require") {
+                throw std::runtime_error(
+                    "ConfigParser: signaturePolicy must be off or require, got '" + val + "'");
+            }
+            nodeConfig_.signaturePolicy = val;
+            rxrevoltchain::util::logger::debug("ConfigParser: signaturePolicy set to " + val);
+        } else if (key == "compressionCodec") {
+            if (val != "zlib" && val != "zstd") {
+                throw std::runtime_error(
+                    "ConfigParser: compressionCodec must be zlib or zstd, got '" + val + "'");
+            }
+            nodeConfig_.compressionCodec = val;
+            rxrevoltchain::util::logger::debug("ConfigParser: compressionCodec set to " + val);
+        } else if (key == "compressionLevel") {
+            nodeConfig_.compressionLevel = static_cast<int>(parseUInt(val));
+            rxrevoltchain::util::logger::debug("ConfigParser: compressionLevel set to " +
+                                               std::to_string(nodeConfig_.compressionLevel));
+        } else if (key == "compressionDictionary") {
+            nodeConfig_.compressionDictionary = val;
+            rxrevoltchain::util::logger::debug("ConfigParser: compressionDictionary set to " +
+                                               val);
+        } else if (key == "logMode") {
+            if (val != "sync" && val != "async") {
+                throw std::runtime_error("ConfigParser: logMode must be sync or async, got '" +
+                                         val + "'");
+            }
+            nodeConfig_.logMode = val;
+            rxrevoltchain::util::logger::debug("ConfigParser: logMode set to " + val);
+        } else if (key == "logQueueCapacity") {
+            nodeConfig_.logQueueCapacity = static_cast<uint32_t>(parseUInt(val));
+            rxrevoltchain::util::logger::debug("ConfigParser: logQueueCapacity set to " +
+                                               std::to_string(nodeConfig_.logQueueCapacity));
+        } else if (key == "logOverflowPolicy") {
+            if (val != "block" && val != "drop") {
+                throw std::runtime_error(
+                    "ConfigParser: logOverflowPolicy must be block or drop, got '" + val + "'");
+            }
+            nodeConfig_.logOverflowPolicy = val;
+            rxrevoltchain::util::logger::debug("ConfigParser: logOverflowPolicy set to " + val);
         } else {
             rxrevoltchain::util::logger::warn("ConfigParser: Unrecognized key '" + key +
                                               "' with value '" + val + "'");
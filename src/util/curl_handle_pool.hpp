@@ -0,0 +1,240 @@
+#ifndef RXREVOLTCHAIN_UTIL_CURL_HANDLE_POOL_HPP
+#define RXREVOLTCHAIN_UTIL_CURL_HANDLE_POOL_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+#include <curl/curl.h>
+
+/**
+ * @file curl_handle_pool.hpp
+ * @brief A small pool of reusable libcurl easy handles.
+ *
+ * An easy handle keeps its connection cache across transfers, so reusing one keeps
+ * keep-alive connections to the IPFS daemon (or an EHR endpoint) open instead of paying
+ * a TCP handshake per request. Handles are reset with curl_easy_reset() when they come
+ * back, which clears all options but keeps live connections and the DNS cache.
+ *
+ * Usage Example:
+ *  @code
+ *    auto handle = rxrevoltchain::util::CurlHandlePool::getInstance().acquire();
+ *    if (handle) {
+ *        curl_easy_setopt(handle.get(), CURLOPT_URL, url.c_str());
+ *        CurlHandlePool::StallWatch watch(60);
+ *        CurlHandlePool::applyStallTimeouts(handle.get(), 10, watch);
+ *        curl_easy_perform(handle.get());
+ *    } // handle goes back to the pool here
+ *  @endcode
+ */
+
+namespace rxrevoltchain {
+namespace util {
+
+/**
+ * @class CurlHandlePool
+ * @brief Thread-safe free list of CURL easy handles.
+ *
+ * - acquire() hands out an idle handle or creates a new one.
+ * - The returned Handle puts it back on destruction; at most maxIdle handles are kept.
+ * - getInstance() returns the process-wide pool shared by IPFSPinner and EHRConnector.
+ */
+class CurlHandlePool
+{
+public:
+    /**
+     * @brief Move-only lease of one easy handle; returns it to the pool when destroyed.
+     */
+    class Handle
+    {
+    public:
+        Handle() = default;
+        Handle(CurlHandlePool* pool, CURL* curl)
+            : pool_(pool), curl_(curl)
+        {
+        }
+        Handle(Handle&& other) noexcept
+            : pool_(other.pool_), curl_(other.curl_)
+        {
+            other.curl_ = nullptr;
+        }
+        Handle& operator=(Handle&& other) noexcept
+        {
+            if (this != &other) {
+                release();
+                pool_ = other.pool_;
+                curl_ = other.curl_;
+                other.curl_ = nullptr;
+            }
+            return *this;
+        }
+        Handle(const Handle&) = delete;
+        Handle& operator=(const Handle&) = delete;
+        ~Handle()
+        {
+            release();
+        }
+
+        CURL* get() const
+        {
+            return curl_;
+        }
+        explicit operator bool() const
+        {
+            return curl_ != nullptr;
+        }
+
+    private:
+        void release()
+        {
+            if (curl_) {
+                pool_->giveBack(curl_);
+                curl_ = nullptr;
+            }
+        }
+
+        CurlHandlePool* pool_ = nullptr;
+        CURL* curl_ = nullptr;
+    };
+
+    /**
+     * @brief Construct a pool that keeps up to maxIdle handles around between requests.
+     */
+    explicit CurlHandlePool(size_t maxIdle = 8)
+        : maxIdle_(maxIdle)
+    {
+        static std::once_flag flag;
+        std::call_once(flag, []() { curl_global_init(CURL_GLOBAL_ALL); });
+    }
+
+    ~CurlHandlePool()
+    {
+        for (CURL* curl : idle_) {
+            curl_easy_cleanup(curl);
+        }
+    }
+
+    CurlHandlePool(const CurlHandlePool&) = delete;
+    CurlHandlePool& operator=(const CurlHandlePool&) = delete;
+
+    /**
+     * @brief Process-wide pool for all outbound HTTP in the node.
+     */
+    static CurlHandlePool& getInstance()
+    {
+        static CurlHandlePool instance;
+        return instance;
+    }
+
+    /**
+     * @brief Lease a handle with default options. Evaluates to false if libcurl
+     *        could not create one.
+     */
+    Handle acquire()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!idle_.empty()) {
+                CURL* curl = idle_.back();
+                idle_.pop_back();
+                return Handle(this, curl);
+            }
+            ++created_;
+        }
+        return Handle(this, curl_easy_init());
+    }
+
+    /**
+     * @brief Number of handles created so far (reused handles are not counted again).
+     */
+    size_t createdCount() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return created_;
+    }
+
+    /**
+     * @brief Number of handles currently waiting in the pool.
+     */
+    size_t idleCount() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return idle_.size();
+    }
+
+    /**
+     * @brief Per-transfer progress state for applyStallTimeouts(). Must outlive the
+     *        curl_easy_perform() call it is attached to.
+     */
+    struct StallWatch
+    {
+        explicit StallWatch(long seconds)
+            : stallSeconds(seconds), lastMove(std::chrono::steady_clock::now())
+        {
+        }
+
+        long stallSeconds;
+        curl_off_t lastBytes = 0;
+        std::chrono::steady_clock::time_point lastMove;
+    };
+
+    /**
+     * @brief Replace a fixed total timeout by progress-based limits.
+     *
+     * The connection must be established within connectSeconds, after which the
+     * transfer may take as long as it needs, but is aborted once no byte has moved in
+     * either direction for watch.stallSeconds (CURLE_ABORTED_BY_CALLBACK). A zero value
+     * leaves that limit unset. CURLOPT_LOW_SPEED_TIME is not used because libcurl
+     * averages its speed over several seconds, which delays the abort well beyond the
+     * configured time.
+     */
+    static void applyStallTimeouts(CURL* curl, long connectSeconds, StallWatch& watch)
+    {
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT, 0L);
+        curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, connectSeconds);
+        curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+        if (watch.stallSeconds > 0) {
+            curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, progressCallback);
+            curl_easy_setopt(curl, CURLOPT_XFERINFODATA, &watch);
+            curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+        }
+    }
+
+private:
+    // libcurl calls this at least about once per second, even while nothing moves
+    static int progressCallback(void* arg, curl_off_t, curl_off_t dlnow, curl_off_t,
+                                curl_off_t ulnow)
+    {
+        StallWatch& watch = *static_cast<StallWatch*>(arg);
+        const auto now = std::chrono::steady_clock::now();
+        if (dlnow + ulnow != watch.lastBytes) {
+            watch.lastBytes = dlnow + ulnow;
+            watch.lastMove = now;
+            return 0;
+        }
+        return now - watch.lastMove >= std::chrono::seconds(watch.stallSeconds) ? 1 : 0;
+    }
+
+    void giveBack(CURL* curl)
+    {
+        curl_easy_reset(curl);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (idle_.size() < maxIdle_) {
+                idle_.push_back(curl);
+                return;
+            }
+        }
+        curl_easy_cleanup(curl);
+    }
+
+    const size_t maxIdle_;
+    mutable std::mutex mutex_;
+    std::vector<CURL*> idle_;
+    size_t created_ = 0;
+};
+
+} // namespace util
+} // namespace rxrevoltchain
+
+#endif // RXREVOLTCHAIN_UTIL_CURL_HANDLE_POOL_HPP
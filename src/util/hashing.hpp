@@ -1,13 +1,17 @@
 #ifndef RXREVOLTCHAIN_UTIL_HASHING_HPP
 #define RXREVOLTCHAIN_UTIL_HASHING_HPP
 
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
 #include <string>
 #include <stdexcept>
 #include <vector>
-#include <sstream>
-#include <iomanip>
 #include <openssl/evp.h>
 #include <openssl/sha.h>
+#include "read_ahead.hpp"
+#include "sha256_simd.hpp"
 
 /**
  * @file hashing.hpp
@@ -19,6 +23,12 @@
  *
  * DESIGN:
  *   - We implement a standard SHA-256 function that returns a lowercase hex-encoded string.
+ *   - sha256Raw / sha256Batch return raw 32-byte digests for hot paths (merkle trees,
+ *     proof verification) that never need the hex text.
+ *   - sha256Batch hashes many equal-sized chunks. It runs on one of three backends,
+ *     chosen once at startup from the CPU features: SHA-NI (one message at a time in
+ *     hardware), AVX2 (eight messages per instruction stream) or OpenSSL EVP.
+ *     setSha256Backend() overrides the choice (benchmarks, tests).
  *   - Additional hashing routines (e.g. SHA-1, double-SHA) can be added if needed.
  *
  * USAGE:
@@ -28,6 +38,9 @@
  *
  *   std::string hashVal = sha256("Hello World");
  *   // hashVal is a 64-hex-character string of the SHA-256 digest.
+ *
+ *   Digest d = sha256Raw(data.data(), data.size());
+ *   sha256Batch(chunks, 4096, count, out); // out receives count * 32 bytes
  *   @endcode
  */
 
@@ -35,6 +48,152 @@ namespace rxrevoltchain {
 namespace util {
 namespace hashing {
 
+/** A raw SHA-256 digest. */
+using Digest = std::array<uint8_t, 32>;
+
+/** Implementations available for sha256Raw / sha256Batch. */
+enum class Sha256Backend
+{
+    OpenSSL = 0, ///< OpenSSL one-shot SHA256(); always available
+    ShaNi = 1,   ///< x86 SHA extensions
+    Avx2 = 2     ///< 8-way multi-buffer AVX2 for batches; single messages use OpenSSL
+};
+
+/** Human-readable backend name, e.g. for benchmark output. */
+inline const char* sha256BackendName(Sha256Backend backend)
+{
+    switch (backend) {
+    case Sha256Backend::ShaNi:
+        return "sha-ni";
+    case Sha256Backend::Avx2:
+        return "avx2-x8";
+    default:
+        return "openssl";
+    }
+}
+
+/** True if 'backend' can run on this CPU. */
+inline bool sha256BackendAvailable(Sha256Backend backend)
+{
+    static const bool shaNi = detail::cpuHasShaNi();
+    static const bool avx2 = detail::cpuHasAvx2();
+    switch (backend) {
+    case Sha256Backend::ShaNi:
+        return shaNi;
+    case Sha256Backend::Avx2:
+        return avx2;
+    default:
+        return true;
+    }
+}
+
+namespace detail {
+
+inline std::atomic<int>& activeBackendSlot()
+{
+    // Preference order: SHA-NI, then AVX2 multi-buffer, then OpenSSL
+    static std::atomic<int> slot(static_cast<int>(
+        sha256BackendAvailable(Sha256Backend::ShaNi)  ? Sha256Backend::ShaNi
+        : sha256BackendAvailable(Sha256Backend::Avx2) ? Sha256Backend::Avx2
+                                                      : Sha256Backend::OpenSSL));
+    return slot;
+}
+
+} // namespace detail
+
+/** Backend currently used by sha256Raw / sha256Batch. */
+inline Sha256Backend sha256Backend()
+{
+    return static_cast<Sha256Backend>(detail::activeBackendSlot().load(std::memory_order_relaxed));
+}
+
+/**
+ * @brief Select the backend for sha256Raw / sha256Batch.
+ * @return false (and no change) if the backend is not supported on this CPU.
+ */
+inline bool setSha256Backend(Sha256Backend backend)
+{
+    if (!sha256BackendAvailable(backend)) {
+        return false;
+    }
+    detail::activeBackendSlot().store(static_cast<int>(backend), std::memory_order_relaxed);
+    return true;
+}
+
+/**
+ * @brief Lowercase hex encoding of 'len' bytes, using a lookup table.
+ */
+inline std::string toHex(const uint8_t *data, size_t len)
+{
+    static const char digits[] = "0123456789abcdef";
+    std::string hex(len * 2, '0');
+    for (size_t i = 0; i < len; ++i) {
+        hex[2 * i] = digits[data[i] >> 4];
+        hex[2 * i + 1] = digits[data[i] & 0x0F];
+    }
+    return hex;
+}
+
+/** Lowercase hex encoding of a digest. */
+inline std::string toHex(const Digest &digest)
+{
+    return toHex(digest.data(), digest.size());
+}
+
+/**
+ * @brief SHA-256 of 'len' bytes at 'data', written as 32 raw bytes to 'out'.
+ * @throw std::runtime_error if OpenSSL fails somehow.
+ */
+inline void sha256Raw(const uint8_t *data, size_t len, uint8_t *out)
+{
+#if RXREVOLTCHAIN_SHA256_X86
+    if (sha256Backend() == Sha256Backend::ShaNi) {
+        detail::sha256ShaNi(data, len, out);
+        return;
+    }
+#endif
+    if (!SHA256(data, len, out)) {
+        throw std::runtime_error("hashing::sha256Raw: SHA256 computation failed.");
+    }
+}
+
+/** SHA-256 of 'len' bytes at 'data' as a raw digest. */
+inline Digest sha256Raw(const uint8_t *data, size_t len)
+{
+    Digest d;
+    sha256Raw(data, len, d.data());
+    return d;
+}
+
+/** SHA-256 of 'input' as a raw digest. */
+inline Digest sha256Raw(const std::vector<uint8_t> &input)
+{
+    return sha256Raw(input.data(), input.size());
+}
+
+/**
+ * @brief Hash 'count' consecutive chunks of 'chunkSize' bytes each.
+ * @param data Start of the first chunk; chunk i starts at data + i * chunkSize.
+ * @param out Receives count * 32 bytes: the digest of chunk i at out + i * 32.
+ *
+ * With the AVX2 backend, chunks are hashed eight at a time and any remainder one at a
+ * time. The output is identical for every backend.
+ */
+inline void sha256Batch(const uint8_t *data, size_t chunkSize, size_t count, uint8_t *out)
+{
+    size_t i = 0;
+#if RXREVOLTCHAIN_SHA256_X86
+    if (sha256Backend() == Sha256Backend::Avx2) {
+        for (; i + 8 <= count; i += 8) {
+            detail::sha256x8Avx2(data + i * chunkSize, chunkSize, chunkSize, out + i * 32);
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        sha256Raw(data + i * chunkSize, chunkSize, out + i * 32);
+    }
+}
+
 /**
  * @brief Compute a SHA-256 hash of the input string, return as lowercase hex.
  * @param input The data to be hashed.
@@ -43,33 +202,22 @@ namespace hashing {
  */
 inline std::string sha256(const std::vector<uint8_t> &input)
 {
-    // Prepare an array for the raw digest (32 bytes = 256 bits)
-    unsigned char hash[SHA256_DIGEST_LENGTH];
-    // Compute the SHA-256 digest
-    if (!SHA256(reinterpret_cast<const unsigned char*>(input.data()),
-                input.size(),
-                hash))
-    {
-        throw std::runtime_error("hashing::sha256: SHA256 computation failed.");
-    }
-
-    // Convert the raw bytes to lowercase hex
-    std::ostringstream oss;
-    oss << std::hex << std::setfill('0');
-    for (int i = 0; i < SHA256_DIGEST_LENGTH; ++i) {
-        oss << std::setw(2) << static_cast<unsigned>(hash[i]);
-    }
-    return oss.str();
+    // Compute the raw digest (32 bytes = 256 bits) and convert it to lowercase hex
+    return toHex(sha256Raw(input));
 }
 
 /**
- * @brief Compute a SHA-256 hash of the input file, return as lowercase hex.
+ * @brief Compute a SHA-256 hash of the input file as a raw digest.
  * @param filePath The path to the file to be hashed.
- * @return A 64-character hex string representing the SHA-256 digest.
+ * @return The 32-byte SHA-256 digest.
  * @throw std::runtime_error if the file cannot be opened or if OpenSSL fails somehow.
  * @note This function reads the file in chunks to avoid loading the entire file into memory.
+ *       A plain SHA-256 stream is inherently sequential, so instead of splitting the hash the
+ *       next 1 MiB block is read on a background thread while the current one is digested.
+ *       The stream goes through EVP, which already uses the CPU's SHA extensions for large
+ *       updates; the sha256Batch backends pay off for many small messages instead.
  */
-inline std::string sha256File(const std::string &filePath)
+inline Digest sha256FileRaw(const std::string &filePath)
 {
     // Open the file for reading in binary mode
     std::ifstream ifs(filePath, std::ios::binary);
@@ -89,31 +237,46 @@ inline std::string sha256File(const std::string &filePath)
         throw std::runtime_error("hashing::sha256File: EVP_DigestInit_ex failed.");
     }
 
-    // Read the file in chunks and update the hash context
-    char buffer[4096];
-    while (ifs.read(buffer, sizeof(buffer)) || ifs.gcount())
+    // Read the file in 1 MiB blocks and update the hash context. One reader thread for
+    // the whole file fills the next block while the current one is hashed.
+    bool readFailed = false;
     {
-        if (EVP_DigestUpdate(mdctx, buffer, ifs.gcount()) != 1) {
-            EVP_MD_CTX_free(mdctx);
-            throw std::runtime_error("hashing::sha256File: EVP_DigestUpdate failed.");
+        ReadAhead reader(ifs, 1 << 20);
+        std::vector<uint8_t> current;
+        size_t bytesRead = 0;
+        while ((bytesRead = reader.next(current)) > 0)
+        {
+            if (EVP_DigestUpdate(mdctx, current.data(), bytesRead) != 1) {
+                EVP_MD_CTX_free(mdctx);
+                throw std::runtime_error("hashing::sha256File: EVP_DigestUpdate failed.");
+            }
         }
+        readFailed = reader.failed();
+    }
+    if (readFailed) {
+        EVP_MD_CTX_free(mdctx);
+        throw std::runtime_error("hashing::sha256File: Read error on file: " + filePath);
     }
 
-    // Finalize the hash and convert to hex
-    unsigned char hash[SHA256_DIGEST_LENGTH];
-    if (EVP_DigestFinal_ex(mdctx, hash, nullptr) != 1) {
+    // Finalize the hash
+    Digest hash;
+    if (EVP_DigestFinal_ex(mdctx, hash.data(), nullptr) != 1) {
         EVP_MD_CTX_free(mdctx);
         throw std::runtime_error("hashing::sha256File: EVP_DigestFinal_ex failed.");
     }
     EVP_MD_CTX_free(mdctx);
+    return hash;
+}
 
-    std::ostringstream oss;
-    oss << std::hex << std::setfill('0');
-    for (int i = 0; i < SHA256_DIGEST_LENGTH; ++i)
-    {
-        oss << std::setw(2) << static_cast<unsigned>(hash[i]);
-    }
-    return oss.str();
+/**
+ * @brief Compute a SHA-256 hash of the input file, return as lowercase hex.
+ * @param filePath The path to the file to be hashed.
+ * @return A 64-character hex string representing the SHA-256 digest.
+ * @throw std::runtime_error if the file cannot be opened or if OpenSSL fails somehow.
+ */
+inline std::string sha256File(const std::string &filePath)
+{
+    return toHex(sha256FileRaw(filePath));
 }
 
 /**
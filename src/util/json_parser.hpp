@@ -0,0 +1,545 @@
+#ifndef RXREVOLTCHAIN_UTIL_JSON_PARSER_HPP
+#define RXREVOLTCHAIN_UTIL_JSON_PARSER_HPP
+
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @file json_parser.hpp
+ * @brief A small incremental (push) JSON parser.
+ *
+ * Input can be fed in arbitrary pieces, e.g. straight from a libcurl write callback, and
+ * every complete top-level value is handed to a callback as soon as its last byte
+ * arrives. Several top-level values may follow each other (separated by whitespace),
+ * which covers newline-delimited streams such as IPFS `pin/ls?stream=true`.
+ *
+ * Usage Example:
+ *  @code
+ *    rxrevoltchain::util::JsonStreamParser parser([](rxrevoltchain::util::JsonValue&& v) {
+ *        if (const auto* cid = v.find("Cid")) use(cid->asString());
+ *    });
+ *    parser.feed(chunk, len);            // as often as needed
+ *    bool ok = parser.finish();          // false on syntax error or truncated input
+ *
+ *    rxrevoltchain::util::JsonValue doc;
+ *    bool valid = rxrevoltchain::util::JsonStreamParser::parse(text, doc);
+ *  @endcode
+ */
+
+namespace rxrevoltchain {
+namespace util {
+
+/**
+ * @class JsonValue
+ * @brief A parsed JSON value. Object members keep their document order.
+ */
+class JsonValue
+{
+public:
+    enum class Type { Null, Bool, Number, String, Array, Object };
+
+    JsonValue() = default;
+
+    Type type() const { return type_; }
+    bool isNull() const { return type_ == Type::Null; }
+    bool isBool() const { return type_ == Type::Bool; }
+    bool isNumber() const { return type_ == Type::Number; }
+    bool isString() const { return type_ == Type::String; }
+    bool isArray() const { return type_ == Type::Array; }
+    bool isObject() const { return type_ == Type::Object; }
+
+    bool asBool() const { return bool_; }
+    double asNumber() const { return number_; }
+    const std::string& asString() const { return string_; }
+    const std::vector<JsonValue>& items() const { return items_; }
+    const std::vector<std::pair<std::string, JsonValue>>& members() const { return members_; }
+
+    /**
+     * @brief Member lookup for objects; nullptr if absent or not an object.
+     */
+    const JsonValue* find(const std::string& key) const
+    {
+        for (const auto& member : members_) {
+            if (member.first == key) {
+                return &member.second;
+            }
+        }
+        return nullptr;
+    }
+
+    static JsonValue makeBool(bool b)
+    {
+        JsonValue v;
+        v.type_ = Type::Bool;
+        v.bool_ = b;
+        return v;
+    }
+    static JsonValue makeNumber(double n)
+    {
+        JsonValue v;
+        v.type_ = Type::Number;
+        v.number_ = n;
+        return v;
+    }
+    static JsonValue makeString(std::string s)
+    {
+        JsonValue v;
+        v.type_ = Type::String;
+        v.string_ = std::move(s);
+        return v;
+    }
+    static JsonValue makeArray()
+    {
+        JsonValue v;
+        v.type_ = Type::Array;
+        return v;
+    }
+    static JsonValue makeObject()
+    {
+        JsonValue v;
+        v.type_ = Type::Object;
+        return v;
+    }
+
+private:
+    friend class JsonStreamParser;
+
+    Type type_ = Type::Null;
+    bool bool_ = false;
+    double number_ = 0.0;
+    std::string string_;
+    std::vector<JsonValue> items_;
+    std::vector<std::pair<std::string, JsonValue>> members_;
+};
+
+/**
+ * @class JsonStreamParser
+ * @brief Character-driven state machine that builds JsonValue trees incrementally.
+ *
+ * - feed() may split the input anywhere, including inside strings, escapes and numbers.
+ * - Only the document currently being parsed is held in memory.
+ * - Nesting deeper than maxDepth is a syntax error, so hostile input cannot exhaust
+ *   the stack of a later recursive consumer.
+ * - After the first error every further feed() returns false; see error().
+ */
+class JsonStreamParser
+{
+public:
+    using ValueCallback = std::function<void(JsonValue&&)>;
+
+    explicit JsonStreamParser(ValueCallback onValue, size_t maxDepth = 64)
+        : onValue_(std::move(onValue)), maxDepth_(maxDepth)
+    {
+    }
+
+    /**
+     * @brief Parse the next piece of input. Returns false once the input is invalid.
+     */
+    bool feed(const char* data, size_t len)
+    {
+        for (size_t i = 0; i < len && error_.empty(); ++i) {
+            // A number or literal ends at the first byte that cannot belong to it;
+            // that byte is then handled again in the following state.
+            while (!consume(data[i]) && error_.empty()) {
+            }
+        }
+        return error_.empty();
+    }
+
+    bool feed(const std::string& text)
+    {
+        return feed(text.data(), text.size());
+    }
+
+    /**
+     * @brief Signal end of input. Returns true if everything fed so far formed complete
+     *        values (a trailing top-level number or literal is emitted here).
+     */
+    bool finish()
+    {
+        if (error_.empty() && stack_.empty() && (state_ == State::Number ||
+                                                 state_ == State::Literal)) {
+            consume(' ');
+        }
+        if (error_.empty() && (!stack_.empty() || state_ != State::Value)) {
+            error_ = "unexpected end of input";
+        }
+        return error_.empty();
+    }
+
+    bool failed() const { return !error_.empty(); }
+    const std::string& error() const { return error_; }
+
+    /**
+     * @brief Number of top-level values emitted so far.
+     */
+    size_t valueCount() const { return emitted_; }
+
+    /**
+     * @brief Parse a complete document holding exactly one value.
+     */
+    static bool parse(const std::string& text, JsonValue& out)
+    {
+        size_t count = 0;
+        JsonStreamParser parser([&](JsonValue&& v) {
+            out = std::move(v);
+            ++count;
+        });
+        return parser.feed(text) && parser.finish() && count == 1;
+    }
+
+private:
+    enum class State {
+        Value,          // expecting any value
+        ArrayFirst,     // after '[': a value or ']'
+        ObjectFirst,    // after '{': a key or '}'
+        ObjectKey,      // after ',' in an object: a key
+        Colon,          // after a key
+        AfterValue,     // inside a container: ',' or the closing bracket
+        String,
+        Number,
+        Literal
+    };
+
+    static bool isSpace(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    bool fail(const std::string& what)
+    {
+        error_ = what;
+        return true;
+    }
+
+    // Returns false if 'c' was not consumed and must be offered again.
+    bool consume(char c)
+    {
+        switch (state_) {
+        case State::Value:
+            if (isSpace(c)) {
+                return true;
+            }
+            return beginValue(c);
+
+        case State::ArrayFirst:
+            if (isSpace(c)) {
+                return true;
+            }
+            if (c == ']') {
+                closeContainer();
+                return true;
+            }
+            return beginValue(c);
+
+        case State::ObjectFirst:
+        case State::ObjectKey:
+            if (isSpace(c)) {
+                return true;
+            }
+            if (c == '}' && state_ == State::ObjectFirst) {
+                closeContainer();
+                return true;
+            }
+            if (c != '"') {
+                return fail("expected object key");
+            }
+            beginString(true);
+            return true;
+
+        case State::Colon:
+            if (isSpace(c)) {
+                return true;
+            }
+            if (c != ':') {
+                return fail("expected ':'");
+            }
+            state_ = State::Value;
+            return true;
+
+        case State::AfterValue:
+            if (isSpace(c)) {
+                return true;
+            }
+            if (c == ',') {
+                state_ = stack_.back().isArray() ? State::Value : State::ObjectKey;
+            } else if ((c == ']' && stack_.back().isArray()) ||
+                       (c == '}' && stack_.back().isObject())) {
+                closeContainer();
+            } else {
+                return fail("expected ',' or closing bracket");
+            }
+            return true;
+
+        case State::String:
+            stringChar(c);
+            return true;
+
+        case State::Number:
+            if ((c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' ||
+                c == 'E') {
+                token_ += c;
+                return true;
+            }
+            endNumber();
+            return false;
+
+        case State::Literal:
+            if (c >= 'a' && c <= 'z') {
+                token_ += c;
+                return true;
+            }
+            endLiteral();
+            return false;
+        }
+        return true;
+    }
+
+    bool beginValue(char c)
+    {
+        if (c == '{' || c == '[') {
+            if (stack_.size() >= maxDepth_) {
+                return fail("nesting too deep");
+            }
+            stack_.push_back(c == '{' ? JsonValue::makeObject() : JsonValue::makeArray());
+            keys_.emplace_back();
+            state_ = c == '{' ? State::ObjectFirst : State::ArrayFirst;
+        } else if (c == '"') {
+            beginString(false);
+        } else if (c == '-' || (c >= '0' && c <= '9')) {
+            token_.assign(1, c);
+            state_ = State::Number;
+        } else if (c == 't' || c == 'f' || c == 'n') {
+            token_.assign(1, c);
+            state_ = State::Literal;
+        } else {
+            return fail(std::string("unexpected character '") + c + "'");
+        }
+        return true;
+    }
+
+    void beginString(bool isKey)
+    {
+        stringIsKey_ = isKey;
+        escape_ = false;
+        unicodeDigits_ = -1;
+        highSurrogate_ = 0;
+        token_.clear();
+        state_ = State::String;
+    }
+
+    void stringChar(char c)
+    {
+        if (unicodeDigits_ >= 0) {
+            int digit = (c >= '0' && c <= '9')   ? c - '0'
+                        : (c >= 'a' && c <= 'f') ? c - 'a' + 10
+                        : (c >= 'A' && c <= 'F') ? c - 'A' + 10
+                                                 : -1;
+            if (digit < 0) {
+                fail("invalid \\u escape");
+                return;
+            }
+            codeUnit_ = (codeUnit_ << 4) | static_cast<uint32_t>(digit);
+            if (++unicodeDigits_ == 4) {
+                unicodeDigits_ = -1;
+                appendCodeUnit(codeUnit_);
+            }
+            return;
+        }
+        if (escape_) {
+            escape_ = false;
+            if (highSurrogate_ != 0 && c != 'u') {
+                fail("unpaired surrogate");
+                return;
+            }
+            switch (c) {
+            case '"': token_ += '"'; break;
+            case '\\': token_ += '\\'; break;
+            case '/': token_ += '/'; break;
+            case 'b': token_ += '\b'; break;
+            case 'f': token_ += '\f'; break;
+            case 'n': token_ += '\n'; break;
+            case 'r': token_ += '\r'; break;
+            case 't': token_ += '\t'; break;
+            case 'u':
+                unicodeDigits_ = 0;
+                codeUnit_ = 0;
+                return;
+            default:
+                fail("invalid escape");
+                return;
+            }
+            return;
+        }
+        if (c == '\\') {
+            escape_ = true;
+            return;
+        }
+        if (highSurrogate_ != 0) {
+            fail("unpaired surrogate");
+            return;
+        }
+        if (c == '"') {
+            if (stringIsKey_) {
+                keys_.back() = std::move(token_);
+                token_.clear();
+                state_ = State::Colon;
+            } else {
+                emit(JsonValue::makeString(std::move(token_)));
+                token_.clear();
+            }
+            return;
+        }
+        if (static_cast<unsigned char>(c) < 0x20) {
+            fail("control character in string");
+            return;
+        }
+        token_ += c;
+    }
+
+    void appendCodeUnit(uint32_t unit)
+    {
+        if (unit >= 0xD800 && unit <= 0xDBFF) {
+            if (highSurrogate_ != 0) {
+                fail("unpaired surrogate");
+                return;
+            }
+            highSurrogate_ = unit;
+            return;
+        }
+        uint32_t cp = unit;
+        if (unit >= 0xDC00 && unit <= 0xDFFF) {
+            if (highSurrogate_ == 0) {
+                fail("unpaired surrogate");
+                return;
+            }
+            cp = 0x10000 + ((highSurrogate_ - 0xD800) << 10) + (unit - 0xDC00);
+        } else if (highSurrogate_ != 0) {
+            fail("unpaired surrogate");
+            return;
+        }
+        highSurrogate_ = 0;
+        if (cp < 0x80) {
+            token_ += static_cast<char>(cp);
+        } else if (cp < 0x800) {
+            token_ += static_cast<char>(0xC0 | (cp >> 6));
+            token_ += static_cast<char>(0x80 | (cp & 0x3F));
+        } else if (cp < 0x10000) {
+            token_ += static_cast<char>(0xE0 | (cp >> 12));
+            token_ += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            token_ += static_cast<char>(0x80 | (cp & 0x3F));
+        } else {
+            token_ += static_cast<char>(0xF0 | (cp >> 18));
+            token_ += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+            token_ += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            token_ += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+    }
+
+    // JSON number grammar: -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+    static bool validNumber(const std::string& t)
+    {
+        size_t i = 0;
+        auto digits = [&]() {
+            size_t start = i;
+            while (i < t.size() && t[i] >= '0' && t[i] <= '9') {
+                ++i;
+            }
+            return i > start;
+        };
+        if (i < t.size() && t[i] == '-') {
+            ++i;
+        }
+        if (i < t.size() && t[i] == '0') {
+            ++i;
+        } else if (!digits()) {
+            return false;
+        }
+        if (i < t.size() && t[i] == '.') {
+            ++i;
+            if (!digits()) {
+                return false;
+            }
+        }
+        if (i < t.size() && (t[i] == 'e' || t[i] == 'E')) {
+            ++i;
+            if (i < t.size() && (t[i] == '+' || t[i] == '-')) {
+                ++i;
+            }
+            if (!digits()) {
+                return false;
+            }
+        }
+        return i == t.size();
+    }
+
+    void endNumber()
+    {
+        if (!validNumber(token_)) {
+            fail("invalid number '" + token_ + "'");
+            return;
+        }
+        emit(JsonValue::makeNumber(std::strtod(token_.c_str(), nullptr)));
+    }
+
+    void endLiteral()
+    {
+        if (token_ == "true" || token_ == "false") {
+            emit(JsonValue::makeBool(token_ == "true"));
+        } else if (token_ == "null") {
+            emit(JsonValue());
+        } else {
+            fail("invalid literal '" + token_ + "'");
+        }
+    }
+
+    void closeContainer()
+    {
+        JsonValue done = std::move(stack_.back());
+        stack_.pop_back();
+        keys_.pop_back();
+        emit(std::move(done));
+    }
+
+    void emit(JsonValue&& v)
+    {
+        if (stack_.empty()) {
+            state_ = State::Value;
+            ++emitted_;
+            if (onValue_) {
+                onValue_(std::move(v));
+            }
+            return;
+        }
+        JsonValue& parent = stack_.back();
+        if (parent.isArray()) {
+            parent.items_.push_back(std::move(v));
+        } else {
+            parent.members_.emplace_back(std::move(keys_.back()), std::move(v));
+        }
+        state_ = State::AfterValue;
+    }
+
+    ValueCallback onValue_;
+    const size_t maxDepth_;
+    State state_ = State::Value;
+    std::vector<JsonValue> stack_;  // open containers, innermost last
+    std::vector<std::string> keys_; // pending member key for each open container
+    std::string token_;             // string, number or literal being accumulated
+    bool stringIsKey_ = false;
+    bool escape_ = false;
+    int unicodeDigits_ = -1;        // hex digits read of a \u escape, -1 if none
+    uint32_t codeUnit_ = 0;
+    uint32_t highSurrogate_ = 0;
+    size_t emitted_ = 0;
+    std::string error_;
+};
+
+} // namespace util
+} // namespace rxrevoltchain
+
+#endif // RXREVOLTCHAIN_UTIL_JSON_PARSER_HPP
@@ -1,15 +1,19 @@
 #ifndef RXREVOLTCHAIN_UTIL_LOGGER_HPP
 #define RXREVOLTCHAIN_UTIL_LOGGER_HPP
 
+#include <atomic>
+#include <condition_variable>
 #include <iostream>
 #include <fstream>
-#include <sstream>
 #include <string>
 #include <mutex>
 #include <memory>
-#include <iomanip>
 #include <chrono>
 #include <ctime>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 /**
  * @file logger.hpp
@@ -19,6 +23,11 @@
  *   - Logger::getInstance().info("Info message");
  *   - logger::debug("Debug message");
  *   - logger::enableFileOutput("logs.txt");
+ *   - logger::enableAsync(); // hand records to a background writer thread
+ *
+ * On hot paths, pass a callable instead of a string; it is only invoked when the level
+ * is enabled, so a filtered message costs one atomic load:
+ *   - Logger::getInstance().debug([&] { return "[P2PNode] got " + msg.type; });
  */
 
 namespace rxrevoltchain {
@@ -36,14 +45,27 @@ enum class LogLevel {
     CRITICAL
 };
 
+/**
+ * @brief What an async producer does when the ring buffer is full.
+ */
+enum class OverflowPolicy {
+    Block, // wait for the writer thread to make room (nothing is lost)
+    Drop   // discard the record (below ERROR); the writer reports how many were dropped
+};
+
 /**
  * @brief A singleton logger class that supports:
  *  - Thread-safe logging
  *  - Various log levels
  *  - Optional file output
+ *  - Optional asynchronous mode: callers push records into a bounded MPSC ring buffer
+ *    and a background thread formats and writes them in batches
  */
 class Logger {
 public:
+    /// Default number of records the async ring buffer holds.
+    static constexpr size_t DEFAULT_QUEUE_CAPACITY = 8192;
+
     /**
      * @brief Get the global Logger instance.
      */
@@ -59,8 +81,7 @@ public:
      */
     void setLogLevel(LogLevel level)
     {
-        std::lock_guard<std::mutex> lock(mutex_);
-        logLevel_ = level;
+        logLevel_.store(static_cast<int>(level), std::memory_order_relaxed);
     }
 
     /**
@@ -68,8 +89,15 @@ public:
      */
     LogLevel getLogLevel() const
     {
-        std::lock_guard<std::mutex> lock(mutex_);
-        return logLevel_;
+        return static_cast<LogLevel>(logLevel_.load(std::memory_order_relaxed));
+    }
+
+    /**
+     * @brief True if a message at 'level' would be written.
+     */
+    bool isEnabled(LogLevel level) const
+    {
+        return static_cast<int>(level) >= logLevel_.load(std::memory_order_relaxed);
     }
 
     /**
@@ -103,12 +131,96 @@ public:
         }
     }
 
+    /**
+     * @brief Switch to asynchronous logging.
+     *
+     * Log calls then only move the message into a ring buffer and return; a background
+     * thread writes batches to the console and file. The buffer is allocated on the first
+     * call, so 'capacity' (rounded up to a power of two) cannot change afterwards.
+     * ERROR and CRITICAL records are never dropped and are written before the call returns.
+     * @return false if the writer thread could not be started.
+     */
+    bool enableAsync(size_t capacity = DEFAULT_QUEUE_CAPACITY,
+                     OverflowPolicy policy = OverflowPolicy::Block)
+    {
+        std::lock_guard<std::mutex> control(controlMutex_);
+        policy_.store(policy, std::memory_order_relaxed);
+        if (writer_.joinable()) {
+            return true;
+        }
+        if (!ring_) {
+            ring_ = std::make_unique<Ring>(capacity);
+        }
+        stopWriter_.store(false);
+        try {
+            writer_ = std::thread([this]() { writerLoop(); });
+        } catch (const std::exception&) {
+            std::cerr << "[Logger] Failed to start the async writer thread." << std::endl;
+            return false;
+        }
+        async_.store(true);
+        return true;
+    }
+
+    /**
+     * @brief Return to synchronous logging after writing everything still queued.
+     */
+    void disableAsync()
+    {
+        std::lock_guard<std::mutex> control(controlMutex_);
+        if (!writer_.joinable()) {
+            return;
+        }
+        async_.store(false);
+        // Producers that saw async_ == true finish their push before the writer stops
+        while (producers_.load() != 0) {
+            std::this_thread::yield();
+        }
+        stopWriter_.store(true);
+        wakeWriter();
+        writer_.join();
+    }
+
+    /**
+     * @brief True while log records go through the background writer.
+     */
+    bool isAsync() const
+    {
+        return async_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Block until every record queued so far has been written.
+     */
+    void flush()
+    {
+        if (!async_.load()) {
+            return;
+        }
+        const uint64_t target = ring_->tail.load();
+        std::unique_lock<std::mutex> lock(wakeMutex_);
+        while (writtenUpTo_ < target && !stopWriter_.load()) {
+            flushWaiters_++;
+            idleWriterCv_.notify_one();
+            flushedCv_.wait_for(lock, std::chrono::milliseconds(50));
+            flushWaiters_--;
+        }
+    }
+
+    /**
+     * @brief Number of records discarded under OverflowPolicy::Drop so far.
+     */
+    uint64_t droppedCount() const
+    {
+        return droppedTotal_.load(std::memory_order_relaxed);
+    }
+
     /**
      * @brief Log a DEBUG message.
      */
     void debug(const std::string &msg)
     {
-        log(LogLevel::DEBUG, "DEBUG", msg);
+        log(LogLevel::DEBUG, msg);
     }
 
     /**
@@ -116,7 +228,7 @@ public:
      */
     void info(const std::string &msg)
     {
-        log(LogLevel::INFO, "INFO", msg);
+        log(LogLevel::INFO, msg);
     }
 
     /**
@@ -124,7 +236,7 @@ public:
      */
     void warn(const std::string &msg)
     {
-        log(LogLevel::WARN, "WARN", msg);
+        log(LogLevel::WARN, msg);
     }
 
     /**
@@ -132,7 +244,7 @@ public:
      */
     void error(const std::string &msg)
     {
-        log(LogLevel::ERROR, "ERROR", msg);
+        log(LogLevel::ERROR, msg);
     }
 
     /**
@@ -140,67 +252,330 @@ public:
      */
     void critical(const std::string &msg)
     {
-        log(LogLevel::CRITICAL, "CRITICAL", msg);
+        log(LogLevel::CRITICAL, msg);
+    }
+
+    /**
+     * @brief Lazy variants: 'make' returns the message and runs only if the level is on.
+     */
+    template <typename F, typename = std::enable_if_t<std::is_invocable_v<F&>>>
+    void debug(F&& make)
+    {
+        logLazy(LogLevel::DEBUG, make);
+    }
+
+    template <typename F, typename = std::enable_if_t<std::is_invocable_v<F&>>>
+    void info(F&& make)
+    {
+        logLazy(LogLevel::INFO, make);
+    }
+
+    template <typename F, typename = std::enable_if_t<std::is_invocable_v<F&>>>
+    void warn(F&& make)
+    {
+        logLazy(LogLevel::WARN, make);
     }
 
 private:
+    /**
+     * One queued log line. 'sequence' follows the bounded MPMC queue scheme: a slot is
+     * free for ticket t when sequence == t and holds the record for t when it is t + 1.
+     */
+    struct Slot {
+        std::atomic<uint64_t> sequence{0};
+        LogLevel level = LogLevel::INFO;
+        std::chrono::system_clock::time_point time;
+        std::string msg;
+    };
+
+    struct Ring {
+        explicit Ring(size_t requested)
+        {
+            size_t cap = 2;
+            while (cap < requested) {
+                cap <<= 1;
+            }
+            mask = cap - 1;
+            slots.reset(new Slot[cap]);
+            for (size_t i = 0; i < cap; ++i) {
+                slots[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        size_t mask = 0;
+        std::unique_ptr<Slot[]> slots;
+        alignas(64) std::atomic<uint64_t> tail{0}; // next ticket handed to a producer
+        alignas(64) uint64_t head = 0;             // next ticket the writer reads
+    };
+
     // Private constructor for singleton
     Logger()
-        : logLevel_(LogLevel::INFO)
+        : logLevel_(static_cast<int>(LogLevel::INFO))
+    {
+    }
+
+    ~Logger()
     {
+        disableAsync();
     }
 
     // Non-copyable, non-assignable
     Logger(const Logger&) = delete;
     Logger& operator=(const Logger&) = delete;
 
+    template <typename F>
+    void logLazy(LogLevel level, F& make)
+    {
+        if (isEnabled(level)) {
+            write(level, std::string(make()));
+        }
+    }
+
     /**
-     * @brief Core logging function that writes to console and optionally to a file.
+     * @brief Core logging function: filters by level before touching any shared state.
      */
-    void log(LogLevel level, const std::string &levelName, const std::string &msg)
+    void log(LogLevel level, const std::string &msg)
     {
-        std::lock_guard<std::mutex> lock(mutex_);
-        if (level < logLevel_) {
+        if (isEnabled(level)) {
+            write(level, std::string(msg));
+        }
+    }
+
+    void write(LogLevel level, std::string msg)
+    {
+        const auto now = std::chrono::system_clock::now();
+        producers_.fetch_add(1);
+        if (async_.load()) {
+            push(level, now, std::move(msg));
+            producers_.fetch_sub(1);
+            if (level >= LogLevel::ERROR) {
+                flush();
+            }
             return;
         }
+        producers_.fetch_sub(1);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        line_.clear();
+        appendLine(line_, level, now, msg, cachedSecond_, cachedStamp_);
+        emit(line_);
+    }
+
+    /**
+     * @brief Enqueue a record, waiting for room or dropping it as the policy says.
+     */
+    void push(LogLevel level, std::chrono::system_clock::time_point time, std::string&& msg)
+    {
+        Ring& ring = *ring_;
+        uint64_t ticket = ring.tail.load(std::memory_order_relaxed);
+        Slot* slot = nullptr;
+        for (unsigned spins = 0;;) {
+            slot = &ring.slots[ticket & ring.mask];
+            const uint64_t seq = slot->sequence.load(std::memory_order_acquire);
+            if (seq == ticket) {
+                if (ring.tail.compare_exchange_weak(ticket, ticket + 1,
+                                                    std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (seq < ticket) {
+                // Full: the writer has not released this slot from the previous lap yet
+                if (level < LogLevel::ERROR &&
+                    policy_.load(std::memory_order_relaxed) == OverflowPolicy::Drop) {
+                    dropped_.fetch_add(1, std::memory_order_relaxed);
+                    droppedTotal_.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                wakeWriter();
+                if (++spins < 64) {
+                    std::this_thread::yield();
+                } else {
+                    std::this_thread::sleep_for(std::chrono::microseconds(200));
+                }
+                ticket = ring.tail.load(std::memory_order_relaxed);
+            } else {
+                ticket = ring.tail.load(std::memory_order_relaxed);
+            }
+        }
+        slot->level = level;
+        slot->time = time;
+        slot->msg = std::move(msg);
+        // seq_cst pairs with the writer storing writerIdle_ before its last look at the ring
+        slot->sequence.store(ticket + 1);
+        if (writerIdle_.load()) {
+            wakeWriter();
+        }
+    }
+
+    void wakeWriter()
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+        idleWriterCv_.notify_one();
+    }
+
+    /**
+     * @brief Background thread: drains the ring in batches, one console and file write each.
+     */
+    void writerLoop()
+    {
+        Ring& ring = *ring_;
+        std::string batch;
+        std::time_t second = -1;
+        std::string stamp;
+        for (;;) {
+            batch.clear();
+            size_t count = 0;
+            for (;;) {
+                Slot& slot = ring.slots[ring.head & ring.mask];
+                if (slot.sequence.load(std::memory_order_acquire) != ring.head + 1) {
+                    break;
+                }
+                appendLine(batch, slot.level, slot.time, slot.msg, second, stamp);
+                slot.msg.clear();
+                slot.sequence.store(ring.head + ring.mask + 1, std::memory_order_release);
+                ++ring.head;
+                if (++count == 1024) {
+                    break;
+                }
+            }
+            const uint64_t dropped = dropped_.exchange(0, std::memory_order_relaxed);
+            if (dropped != 0) {
+                appendLine(batch, LogLevel::WARN, std::chrono::system_clock::now(),
+                           "[Logger] Dropped " + std::to_string(dropped) +
+                               " messages, queue full.",
+                           second, stamp);
+            }
+            if (!batch.empty()) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                emit(batch);
+            }
+
+            std::unique_lock<std::mutex> lock(wakeMutex_);
+            writtenUpTo_ = ring.head;
+            if (flushWaiters_ > 0) {
+                flushedCv_.notify_all();
+            }
+            if (count == 1024) {
+                continue;
+            }
+            const Slot& next = ring.slots[ring.head & ring.mask];
+            if (next.sequence.load(std::memory_order_acquire) == ring.head + 1) {
+                continue;
+            }
+            if (stopWriter_.load()) {
+                return;
+            }
+            // Producers check writerIdle_ after publishing, so either they see it set or
+            // the recheck below sees their record
+            writerIdle_.store(true);
+            if (next.sequence.load() != ring.head + 1 &&
+                dropped_.load() == 0 && !stopWriter_.load()) {
+                idleWriterCv_.wait_for(lock, std::chrono::milliseconds(500));
+            }
+            writerIdle_.store(false);
+        }
+    }
 
-        // Build timestamp
-        auto now = std::chrono::system_clock::now();
-        auto time_t_now = std::chrono::system_clock::to_time_t(now);
-        std::tm tm_buf{};
+    /**
+     * @brief Format one line as "[YYYY-mm-dd HH:MM:SS][LEVEL] msg\n", coloring errors red.
+     *        The timestamp text is reused while the second does not change.
+     */
+    static void appendLine(std::string& out, LogLevel level,
+                           std::chrono::system_clock::time_point time, const std::string& msg,
+                           std::time_t& cachedSecond, std::string& cachedStamp)
+    {
+        const std::time_t secs = std::chrono::system_clock::to_time_t(time);
+        if (secs != cachedSecond) {
+            std::tm tm_buf{};
 #ifdef _WIN32
-        localtime_s(&tm_buf, &time_t_now);
+            localtime_s(&tm_buf, &secs);
 #else
-        localtime_r(&time_t_now, &tm_buf);
+            localtime_r(&secs, &tm_buf);
 #endif
-        std::ostringstream timestamp;
-        timestamp << std::put_time(&tm_buf, "%Y-%m-%d %H:%M:%S");
-
-        // Construct log line
-        std::ostringstream line;
-        line << "[" << timestamp.str() << "][" << levelName << "] " << msg << std::endl;
-
-        std::string colorBegin = "";
-        std::string colorReset = "";
-        // If it is an error, make it red
-        if (level == LogLevel::ERROR || level == LogLevel::CRITICAL) {
-            colorBegin = "\033[1;31m";
-            colorReset = "\033[0m";
-        }
-        // Console output
-        std::cout << colorBegin << line.str() << colorReset;
-        std::cout.flush();
+            char buf[32];
+            const size_t len = std::strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tm_buf);
+            cachedStamp.assign(buf, len);
+            cachedSecond = secs;
+        }
+        const bool red = (level == LogLevel::ERROR || level == LogLevel::CRITICAL);
+        if (red) {
+            out += "\033[1;31m";
+        }
+        out += '[';
+        out += cachedStamp;
+        out += "][";
+        out += levelName(level);
+        out += "] ";
+        out += msg;
+        out += '\n';
+        if (red) {
+            out += "\033[0m";
+        }
+    }
 
-        // File output if enabled
+    static const char* levelName(LogLevel level)
+    {
+        switch (level) {
+        case LogLevel::DEBUG:
+            return "DEBUG";
+        case LogLevel::INFO:
+            return "INFO";
+        case LogLevel::WARN:
+            return "WARN";
+        case LogLevel::ERROR:
+            return "ERROR";
+        default:
+            return "CRITICAL";
+        }
+    }
+
+    /**
+     * @brief Write formatted text to the console and the log file. Caller holds mutex_.
+     */
+    void emit(const std::string& text)
+    {
+        std::cout << text;
+        std::cout.flush();
         if (fileStream_) {
-            (*fileStream_) << line.str();
+            // Color codes only make sense on a terminal
+            std::string plain;
+            plain.reserve(text.size());
+            for (size_t pos = 0; pos < text.size();) {
+                if (text[pos] == '\033') {
+                    const size_t end = text.find('m', pos);
+                    pos = (end == std::string::npos) ? text.size() : end + 1;
+                    continue;
+                }
+                plain += text[pos++];
+            }
+            (*fileStream_) << plain;
             fileStream_->flush();
         }
     }
 
-    mutable std::mutex mutex_;
-    LogLevel logLevel_;
+    std::mutex mutex_; // guards the output streams
+    std::atomic<int> logLevel_;
     std::unique_ptr<std::ofstream> fileStream_;
+    // Line buffer and timestamp cache for synchronous writes, guarded by mutex_
+    std::string line_;
+    std::time_t cachedSecond_ = -1;
+    std::string cachedStamp_;
+
+    std::mutex controlMutex_; // serializes enableAsync/disableAsync
+    std::unique_ptr<Ring> ring_;
+    std::thread writer_;
+    std::atomic<bool> async_{false};
+    std::atomic<bool> stopWriter_{false};
+    std::atomic<bool> writerIdle_{false};
+    std::atomic<OverflowPolicy> policy_{OverflowPolicy::Block};
+    std::atomic<uint32_t> producers_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> droppedTotal_{0};
+
+    std::mutex wakeMutex_; // pairs with the two condition variables below
+    std::condition_variable idleWriterCv_;
+    std::condition_variable flushedCv_;
+    uint64_t writtenUpTo_ = 0;
+    int flushWaiters_ = 0;
 };
 
 // ----------------------------------------------------------------------------
@@ -221,6 +596,17 @@ inline void disableFileOutput()
     Logger::getInstance().disableFileOutput();
 }
 
+inline bool enableAsync(size_t capacity = Logger::DEFAULT_QUEUE_CAPACITY,
+                        OverflowPolicy policy = OverflowPolicy::Block)
+{
+    return Logger::getInstance().enableAsync(capacity, policy);
+}
+
+inline void disableAsync()
+{
+    Logger::getInstance().disableAsync();
+}
+
 inline void debug(const std::string &msg)
 {
     Logger::getInstance().debug(msg);
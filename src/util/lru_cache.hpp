@@ -0,0 +1,173 @@
+#ifndef RXREVOLTCHAIN_UTIL_LRU_CACHE_HPP
+#define RXREVOLTCHAIN_UTIL_LRU_CACHE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @file lru_cache.hpp
+ * @brief A thread-safe, sharded least-recently-used cache.
+ *
+ * Keys are spread over independently locked shards, so concurrent readers of different
+ * keys rarely contend; each shard evicts its own least recently used entry once it holds
+ * capacity / shards entries.
+ *
+ * Usage Example:
+ *  @code
+ *    rxrevoltchain::util::LruCache<int, std::string> cache(1024);
+ *    cache.put(7, "seven");
+ *    std::string value;
+ *    if (cache.get(7, value)) { ... }
+ *  @endcode
+ */
+
+namespace rxrevoltchain {
+namespace util {
+
+/**
+ * @class LruCache
+ * @brief Fixed-capacity key/value cache. Values are copied in and out, so large values
+ *        are best stored behind a shared_ptr.
+ */
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class LruCache
+{
+public:
+    /**
+     * @brief Construct a cache for about 'capacity' entries. A capacity of zero disables
+     *        the cache (put() is a no-op, get() always misses).
+     */
+    explicit LruCache(size_t capacity, size_t shards = 8)
+        : shards_(std::max<size_t>(1, shards))
+    {
+        setCapacity(capacity);
+    }
+
+    LruCache(const LruCache&) = delete;
+    LruCache& operator=(const LruCache&) = delete;
+
+    /**
+     * @brief Change the capacity; shrinking evicts least recently used entries.
+     */
+    void setCapacity(size_t capacity)
+    {
+        const size_t count = shards_.size();
+        const size_t perShard = capacity == 0 ? 0 : (capacity + count - 1) / count;
+        for (auto& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.capacity = perShard;
+            shard.trim();
+        }
+    }
+
+    /**
+     * @brief Copy the value for 'key' into 'out' and mark it most recently used.
+     */
+    bool get(const Key& key, Value& out)
+    {
+        Shard& shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.index.find(key);
+        if (it == shard.index.end()) {
+            return false;
+        }
+        shard.order.splice(shard.order.begin(), shard.order, it->second);
+        out = it->second->second;
+        return true;
+    }
+
+    /**
+     * @brief Insert or replace the value for 'key'.
+     */
+    void put(const Key& key, Value value)
+    {
+        Shard& shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (shard.capacity == 0) {
+            return;
+        }
+        auto it = shard.index.find(key);
+        if (it != shard.index.end()) {
+            it->second->second = std::move(value);
+            shard.order.splice(shard.order.begin(), shard.order, it->second);
+            return;
+        }
+        shard.order.emplace_front(key, std::move(value));
+        shard.index.emplace(key, shard.order.begin());
+        shard.trim();
+    }
+
+    /**
+     * @brief Remove 'key' if present.
+     */
+    void erase(const Key& key)
+    {
+        Shard& shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.index.find(key);
+        if (it != shard.index.end()) {
+            shard.order.erase(it->second);
+            shard.index.erase(it);
+        }
+    }
+
+    /**
+     * @brief Drop every entry.
+     */
+    void clear()
+    {
+        for (auto& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.index.clear();
+            shard.order.clear();
+        }
+    }
+
+    size_t size() const
+    {
+        size_t total = 0;
+        for (const auto& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            total += shard.index.size();
+        }
+        return total;
+    }
+
+private:
+    struct Shard
+    {
+        using Entry = std::pair<Key, Value>;
+
+        void trim()
+        {
+            while (index.size() > capacity) {
+                index.erase(order.back().first);
+                order.pop_back();
+            }
+        }
+
+        mutable std::mutex mutex;
+        size_t capacity = 0;
+        std::list<Entry> order; // most recently used first
+        std::unordered_map<Key, typename std::list<Entry>::iterator, Hash> index;
+    };
+
+    Shard& shardFor(const Key& key)
+    {
+        return shards_[Hash()(key) % shards_.size()];
+    }
+
+    std::vector<Shard> shards_;
+};
+
+} // namespace util
+} // namespace rxrevoltchain
+
+#endif // RXREVOLTCHAIN_UTIL_LRU_CACHE_HPP
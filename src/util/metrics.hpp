@@ -0,0 +1,493 @@
+#ifndef RXREVOLTCHAIN_UTIL_METRICS_HPP
+#define RXREVOLTCHAIN_UTIL_METRICS_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @file metrics.hpp
+ * @brief In-process counters, gauges and histograms exported in Prometheus text format.
+ *
+ * Updates are a single relaxed atomic add on a per-thread shard, so instrumenting a hot
+ * path costs about as much as an uncontended increment; the shards are only summed when
+ * the registry is scraped (HttpQueryServer's GET /metrics).
+ *
+ * Usage Example:
+ *  @code
+ *    using namespace rxrevoltchain::util::metrics;
+ *    static Counter& bytes = Registry::getInstance().counter(
+ *        "rxrevolt_p2p_received_bytes_total", "Bytes read from peer sockets.");
+ *    bytes.inc(n);
+ *
+ *    static Histogram& took = Registry::getInstance().histogram(
+ *        "rxrevolt_merge_duration_seconds", "Time spent merging documents.");
+ *    ScopedTimer timer(took); // observes the elapsed seconds when it goes out of scope
+ *
+ *    std::string text = Registry::getInstance().renderPrometheus();
+ *  @endcode
+ */
+
+namespace rxrevoltchain {
+namespace util {
+namespace metrics {
+
+/// Number of shards per counter or histogram; threads are spread over them round robin.
+constexpr size_t SHARDS = 16;
+
+/**
+ * @brief Index of the calling thread's shard, fixed for the lifetime of the thread.
+ */
+inline size_t shardIndex()
+{
+    static std::atomic<size_t> next{0};
+    thread_local const size_t index = next.fetch_add(1, std::memory_order_relaxed) % SHARDS;
+    return index;
+}
+
+/**
+ * @brief Add to an atomic double stored as its bit pattern.
+ */
+inline void atomicAddDouble(std::atomic<uint64_t>& bits, double delta)
+{
+    uint64_t expected = bits.load(std::memory_order_relaxed);
+    for (;;) {
+        double value;
+        std::memcpy(&value, &expected, sizeof(value));
+        value += delta;
+        uint64_t desired;
+        std::memcpy(&desired, &value, sizeof(desired));
+        if (bits.compare_exchange_weak(expected, desired, std::memory_order_relaxed)) {
+            return;
+        }
+    }
+}
+
+inline double bitsToDouble(uint64_t bits)
+{
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+/**
+ * @class Counter
+ * @brief Monotonically increasing count, sharded to avoid cache-line contention.
+ */
+class Counter
+{
+public:
+    void inc(uint64_t n = 1)
+    {
+        shards_[shardIndex()].value.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    uint64_t value() const
+    {
+        uint64_t sum = 0;
+        for (const auto& shard : shards_) {
+            sum += shard.value.load(std::memory_order_relaxed);
+        }
+        return sum;
+    }
+
+private:
+    struct alignas(64) Shard
+    {
+        std::atomic<uint64_t> value{0};
+    };
+    std::array<Shard, SHARDS> shards_;
+};
+
+/**
+ * @class Gauge
+ * @brief A value that can go up and down (queue depth, rate of the last run).
+ */
+class Gauge
+{
+public:
+    void set(double value)
+    {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        bits_.store(bits, std::memory_order_relaxed);
+    }
+
+    void add(double delta)
+    {
+        atomicAddDouble(bits_, delta);
+    }
+
+    double value() const
+    {
+        return bitsToDouble(bits_.load(std::memory_order_relaxed));
+    }
+
+private:
+    std::atomic<uint64_t> bits_{0}; // 0 is the bit pattern of 0.0
+};
+
+/**
+ * @class Histogram
+ * @brief Distribution over fixed upper bounds, with sum and count (Prometheus histogram).
+ */
+class Histogram
+{
+public:
+    /// Default bounds in seconds, from 1 ms to 5 minutes.
+    static std::vector<double> defaultBounds()
+    {
+        return {0.001, 0.005, 0.01, 0.05, 0.1, 0.5, 1, 5, 10, 30, 60, 300};
+    }
+
+    explicit Histogram(std::vector<double> bounds = defaultBounds())
+        : bounds_(std::move(bounds))
+    {
+        for (auto& shard : shards_) {
+            shard.buckets.reset(new std::atomic<uint64_t>[bounds_.size() + 1]);
+            for (size_t i = 0; i <= bounds_.size(); ++i) {
+                shard.buckets[i].store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void observe(double value)
+    {
+        size_t bucket = 0;
+        while (bucket < bounds_.size() && value > bounds_[bucket]) {
+            ++bucket;
+        }
+        Shard& shard = shards_[shardIndex()];
+        shard.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+        atomicAddDouble(shard.sum, value);
+    }
+
+    const std::vector<double>& bounds() const
+    {
+        return bounds_;
+    }
+
+    /**
+     * @brief Per-bucket counts (not cumulative; the last entry is +Inf) and the sum.
+     */
+    void snapshot(std::vector<uint64_t>& counts, double& sum) const
+    {
+        counts.assign(bounds_.size() + 1, 0);
+        sum = 0;
+        for (const auto& shard : shards_) {
+            for (size_t i = 0; i <= bounds_.size(); ++i) {
+                counts[i] += shard.buckets[i].load(std::memory_order_relaxed);
+            }
+            sum += bitsToDouble(shard.sum.load(std::memory_order_relaxed));
+        }
+    }
+
+    uint64_t count() const
+    {
+        std::vector<uint64_t> counts;
+        double sum = 0;
+        snapshot(counts, sum);
+        uint64_t total = 0;
+        for (uint64_t c : counts) {
+            total += c;
+        }
+        return total;
+    }
+
+private:
+    struct alignas(64) Shard
+    {
+        std::unique_ptr<std::atomic<uint64_t>[]> buckets;
+        std::atomic<uint64_t> sum{0};
+    };
+    const std::vector<double> bounds_;
+    std::array<Shard, SHARDS> shards_;
+};
+
+/**
+ * @class ScopedTimer
+ * @brief Observes the seconds between construction and destruction into a histogram.
+ */
+class ScopedTimer
+{
+public:
+    explicit ScopedTimer(Histogram& histogram)
+        : histogram_(histogram), start_(std::chrono::steady_clock::now())
+    {
+    }
+
+    ~ScopedTimer()
+    {
+        histogram_.observe(elapsedSeconds());
+    }
+
+    double elapsedSeconds() const
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    Histogram& histogram_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * @class Registry
+ * @brief Owns all metrics by name and label set and renders them for a scrape.
+ *
+ * - counter()/gauge()/histogram() return the existing metric for (name, labels) or create
+ *   it; references stay valid for the registry's lifetime, so callers cache them.
+ * - Labels are given preformatted, e.g. "result=\"pass\"".
+ * - addCollector() registers a callback that reports gauge values at scrape time, for
+ *   state that is cheaper to read on demand than to track (per-peer queue depth). It
+ *   runs without the registry lock held, but must not call removeCollector() itself.
+ */
+class Registry
+{
+public:
+    /// One value reported by a collector: label set and value.
+    using Sample = std::pair<std::string, double>;
+    using Collector = std::function<void(std::vector<Sample>&)>;
+
+    Registry() = default;
+    Registry(const Registry&) = delete;
+    Registry& operator=(const Registry&) = delete;
+
+    /**
+     * @brief Process-wide registry exported by the node.
+     */
+    static Registry& getInstance()
+    {
+        static Registry instance;
+        return instance;
+    }
+
+    Counter& counter(const std::string& name, const std::string& help,
+                     const std::string& labels = "")
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Family& family = familyLocked(name, help, "counter");
+        auto& entry = family.series[labels];
+        if (!entry.counter) {
+            entry.counter = std::make_unique<Counter>();
+        }
+        return *entry.counter;
+    }
+
+    Gauge& gauge(const std::string& name, const std::string& help,
+                 const std::string& labels = "")
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Family& family = familyLocked(name, help, "gauge");
+        auto& entry = family.series[labels];
+        if (!entry.gauge) {
+            entry.gauge = std::make_unique<Gauge>();
+        }
+        return *entry.gauge;
+    }
+
+    Histogram& histogram(const std::string& name, const std::string& help,
+                         const std::vector<double>& bounds = Histogram::defaultBounds(),
+                         const std::string& labels = "")
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Family& family = familyLocked(name, help, "histogram");
+        auto& entry = family.series[labels];
+        if (!entry.histogram) {
+            entry.histogram = std::make_unique<Histogram>(bounds);
+        }
+        return *entry.histogram;
+    }
+
+    /**
+     * @brief Register a scrape-time gauge family. Returns an id for removeCollector().
+     */
+    size_t addCollector(const std::string& name, const std::string& help, Collector collect)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            familyLocked(name, help, "gauge");
+        }
+        std::lock_guard<std::mutex> lock(collectorMutex_);
+        const size_t id = ++lastCollectorId_;
+        collectors_[id] = CollectorEntry{name, std::move(collect)};
+        return id;
+    }
+
+    /**
+     * @brief Unregister a collector; once this returns it is no longer called.
+     */
+    void removeCollector(size_t id)
+    {
+        std::lock_guard<std::mutex> lock(collectorMutex_);
+        collectors_.erase(id);
+    }
+
+    /**
+     * @brief All metrics in the Prometheus text exposition format (version 0.0.4).
+     */
+    std::string renderPrometheus() const
+    {
+        // Collectors may take their owner's locks, so they do not run under mutex_
+        std::map<std::string, std::vector<Sample>> collected;
+        {
+            std::lock_guard<std::mutex> lock(collectorMutex_);
+            for (const auto& entry : collectors_) {
+                entry.second.collect(collected[entry.second.name]);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::string out;
+        for (const auto& item : families_) {
+            const std::string& name = item.first;
+            const Family& family = item.second;
+            auto samples = collected.find(name);
+            if (family.series.empty() && samples == collected.end()) {
+                continue;
+            }
+            out += "# HELP " + name + " " + family.help + "\n";
+            out += "# TYPE " + name + " " + family.type + "\n";
+            for (const auto& series : family.series) {
+                const std::string& labels = series.first;
+                if (series.second.counter) {
+                    appendSample(out, name, labels, double(series.second.counter->value()));
+                } else if (series.second.gauge) {
+                    appendSample(out, name, labels, series.second.gauge->value());
+                } else if (series.second.histogram) {
+                    appendHistogram(out, name, labels, *series.second.histogram);
+                }
+            }
+            if (samples != collected.end()) {
+                for (const auto& sample : samples->second) {
+                    appendSample(out, name, sample.first, sample.second);
+                }
+            }
+        }
+        return out;
+    }
+
+    /**
+     * @brief Format a Prometheus label value, escaping backslash, quote and newline.
+     */
+    static std::string label(const std::string& key, const std::string& value)
+    {
+        std::string out = key + "=\"";
+        for (char c : value) {
+            if (c == '\\' || c == '"') {
+                out += '\\';
+                out += c;
+            } else if (c == '\n') {
+                out += "\\n";
+            } else {
+                out += c;
+            }
+        }
+        out += '"';
+        return out;
+    }
+
+private:
+    struct Series
+    {
+        std::unique_ptr<Counter> counter;
+        std::unique_ptr<Gauge> gauge;
+        std::unique_ptr<Histogram> histogram;
+    };
+
+    struct Family
+    {
+        std::string help;
+        std::string type;
+        std::map<std::string, Series> series;
+    };
+
+    struct CollectorEntry
+    {
+        std::string name;
+        Collector collect;
+    };
+
+    // The first registration of a name fixes its help text and type
+    Family& familyLocked(const std::string& name, const std::string& help, const char* type)
+    {
+        Family& family = families_[name];
+        if (family.type.empty()) {
+            family.help = help;
+            family.type = type;
+        }
+        return family;
+    }
+
+    static std::string formatValue(double value)
+    {
+        if (std::isnan(value)) {
+            return "NaN";
+        }
+        if (std::isinf(value)) {
+            return value > 0 ? "+Inf" : "-Inf";
+        }
+        if (value == std::floor(value) && std::fabs(value) < 1e15) {
+            return std::to_string(static_cast<long long>(value));
+        }
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "%.9g", value);
+        return buf;
+    }
+
+    static void appendSample(std::string& out, const std::string& name,
+                             const std::string& labels, double value)
+    {
+        out += name;
+        if (!labels.empty()) {
+            out += "{" + labels + "}";
+        }
+        out += " " + formatValue(value) + "\n";
+    }
+
+    static void appendHistogram(std::string& out, const std::string& name,
+                                const std::string& labels, const Histogram& histogram)
+    {
+        std::vector<uint64_t> counts;
+        double sum = 0;
+        histogram.snapshot(counts, sum);
+        const std::string prefix = labels.empty() ? "" : labels + ",";
+        uint64_t cumulative = 0;
+        for (size_t i = 0; i < counts.size(); ++i) {
+            cumulative += counts[i];
+            const std::string le = i < histogram.bounds().size()
+                                       ? formatValue(histogram.bounds()[i])
+                                       : std::string("+Inf");
+            appendSample(out, name + "_bucket", prefix + "le=\"" + le + "\"",
+                         double(cumulative));
+        }
+        appendSample(out, name + "_sum", labels, sum);
+        appendSample(out, name + "_count", labels, double(cumulative));
+    }
+
+    mutable std::mutex mutex_; // guards families_
+    std::map<std::string, Family> families_;
+    mutable std::mutex collectorMutex_; // held while collectors run
+    std::map<size_t, CollectorEntry> collectors_;
+    size_t lastCollectorId_ = 0;
+};
+
+} // namespace metrics
+} // namespace util
+} // namespace rxrevoltchain
+
+#endif // RXREVOLTCHAIN_UTIL_METRICS_HPP
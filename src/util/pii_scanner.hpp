@@ -0,0 +1,546 @@
+#ifndef RXREVOLTCHAIN_UTIL_PII_SCANNER_HPP
+#define RXREVOLTCHAIN_UTIL_PII_SCANNER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <immintrin.h>
+#define RXREVOLTCHAIN_PII_X86 1
+#else
+#define RXREVOLTCHAIN_PII_X86 0
+#endif
+
+/**
+ * @file pii_scanner.hpp
+ * @brief Single-pass recognizer for PII patterns and suspicious keywords in raw bytes.
+ *
+ * PATTERNS (word boundaries as in regex \b, word characters [A-Za-z0-9_]):
+ *   - Ssn:        \b ddd-dd-dddd \b
+ *   - Phone:      (ddd) ddd-dddd with at most one whitespace after ')', or
+ *                 \b ddd-ddd-dddd \b
+ *   - Email:      local@domain, local part [A-Za-z0-9._%+-]+, at least two domain labels
+ *                 and an alphabetic top-level label of two or more letters
+ *   - CardNumber: \b 13 to 19 digits, optionally grouped by single spaces or dashes \b,
+ *                 starting with 2-6 (the card network prefixes) and passing the Luhn check
+ *   - Keywords:   "virus" or "malware" anywhere, case-insensitive (sets ScanResult::suspicious)
+ *
+ * DESIGN:
+ *   - scan() makes one forward pass. Only bytes that can start a pattern are examined: a
+ *     digit, '(' or '@', or the first two letters of a keyword. The AVX2 prefilter tests 32
+ *     bytes per step for those (keywords by their first two letters, so ordinary text rarely
+ *     stops the scan); the recognizers themselves are small hand-written matchers.
+ *   - At a digit, Ssn is tried before Phone before CardNumber, and matches never overlap.
+ *     For Ssn and Phone this gives the same result as running the patterns' regexes one
+ *     after another.
+ *   - redact() replaces the matches inside the caller's vector, moving each byte at most
+ *     once; only a mix of growing and shrinking replacements needs a scratch copy.
+ *   - The kernel is compiled with a function-level target attribute and picked once from the
+ *     CPU features; setBackend() overrides it (benchmarks, tests).
+ *
+ * USAGE:
+ *   @code
+ *   using namespace rxrevoltchain::util;
+ *   pii::ScanResult result;
+ *   pii::scan(doc.data(), doc.size(), pii::AllPatterns, result);
+ *   pii::redact(doc, result.matches);
+ *   @endcode
+ */
+
+namespace rxrevoltchain {
+namespace util {
+namespace pii {
+
+/** Implementations of the candidate prefilter. */
+enum class Backend
+{
+    Scalar = 0, ///< Table lookup per byte; always available
+    Avx2 = 1    ///< 32 bytes per step
+};
+
+/** Pattern selection for scan(); combine with '|'. */
+enum Pattern : uint32_t
+{
+    Ssn = 1u << 0,
+    Phone = 1u << 1,
+    Email = 1u << 2,
+    CardNumber = 1u << 3,
+    Keywords = 1u << 4,
+    AllPatterns = Ssn | Phone | Email | CardNumber | Keywords
+};
+
+/** Byte range [begin, end) of one match. */
+struct Match
+{
+    size_t begin;
+    size_t end;
+};
+
+struct ScanResult
+{
+    std::vector<Match> matches; ///< In order, non-overlapping
+    bool suspicious = false;    ///< A keyword was found
+
+    void clear()
+    {
+        matches.clear();
+        suspicious = false;
+    }
+};
+
+namespace detail {
+
+// Lowercase; the prefilter relies on the first two letters of each being distinct pairs
+static constexpr const char *kKeywords[] = {"virus", "malware"};
+
+enum CandidateFlag : uint8_t
+{
+    kPatternStart = 1, ///< digit, '(' or '@'
+    kKeywordStart = 2  ///< first letter of a keyword, either case
+};
+
+struct CandidateTable
+{
+    uint8_t flags[256];
+
+    constexpr CandidateTable() : flags()
+    {
+        for (int c = '0'; c <= '9'; ++c) {
+            flags[c] = kPatternStart;
+        }
+        flags[static_cast<uint8_t>('(')] = kPatternStart;
+        flags[static_cast<uint8_t>('@')] = kPatternStart;
+        for (const char *keyword : kKeywords) {
+            const uint8_t first = static_cast<uint8_t>(keyword[0]);
+            flags[first] |= kKeywordStart;
+            flags[first & ~0x20] |= kKeywordStart;
+        }
+    }
+};
+
+static constexpr CandidateTable kCandidates{};
+
+inline bool isDigit(uint8_t c)
+{
+    return static_cast<unsigned>(c - '0') < 10u;
+}
+
+inline bool isAlpha(uint8_t c)
+{
+    return static_cast<unsigned>((c | 0x20) - 'a') < 26u;
+}
+
+inline bool isWord(uint8_t c)
+{
+    return isDigit(c) || isAlpha(c) || c == '_';
+}
+
+inline bool isSpace(uint8_t c)
+{
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+inline bool isEmailLocal(uint8_t c)
+{
+    return isDigit(c) || isAlpha(c) || c == '.' || c == '_' || c == '%' || c == '+' ||
+           c == '-';
+}
+
+inline bool isDomainChar(uint8_t c)
+{
+    return isDigit(c) || isAlpha(c) || c == '-';
+}
+
+/** Next offset >= pos whose candidate flags intersect 'mask', or len. */
+inline size_t nextCandidateScalar(const uint8_t *data, size_t len, size_t pos, uint8_t mask)
+{
+    while (pos < len && !(kCandidates.flags[data[pos]] & mask)) {
+        ++pos;
+    }
+    return pos;
+}
+
+#if RXREVOLTCHAIN_PII_X86
+
+/** True if the CPU implements AVX2 and the OS saves the YMM registers. */
+inline bool cpuHasAvx2()
+{
+    unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & bit_OSXSAVE) || !(ecx & bit_AVX)) {
+        return false;
+    }
+    unsigned int xcr0Lo = 0, xcr0Hi = 0;
+    __asm__("xgetbv" : "=a"(xcr0Lo), "=d"(xcr0Hi) : "c"(0));
+    if ((xcr0Lo & 0x6) != 0x6) {
+        return false;
+    }
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+    return (ebx & bit_AVX2) != 0;
+}
+
+/**
+ * @brief nextCandidateScalar() 32 bytes at a time. Keywords are matched by their first two
+ *        letters (so the step loads one byte ahead); the scalar loop finishes the tail.
+ */
+__attribute__((target("avx2"))) inline size_t nextCandidateAvx2(const uint8_t *data,
+                                                                 size_t len, size_t pos,
+                                                                 uint8_t mask)
+{
+    const bool patterns = (mask & kPatternStart) != 0;
+    const bool keywords = (mask & kKeywordStart) != 0;
+    const __m256i belowZero = _mm256_set1_epi8('0' - 1);
+    const __m256i aboveNine = _mm256_set1_epi8('9' + 1);
+    const __m256i paren = _mm256_set1_epi8('(');
+    const __m256i at = _mm256_set1_epi8('@');
+    const __m256i lower = _mm256_set1_epi8(0x20);
+    for (; pos + 33 <= len; pos += 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + pos));
+        __m256i hits = _mm256_setzero_si256();
+        if (patterns) {
+            // Signed compares: bytes >= 0x80 are negative and never count as digits
+            hits = _mm256_and_si256(_mm256_cmpgt_epi8(v, belowZero),
+                                    _mm256_cmpgt_epi8(aboveNine, v));
+            hits = _mm256_or_si256(hits, _mm256_or_si256(_mm256_cmpeq_epi8(v, paren),
+                                                         _mm256_cmpeq_epi8(v, at)));
+        }
+        if (keywords) {
+            const __m256i first = _mm256_or_si256(v, lower);
+            const __m256i second = _mm256_or_si256(
+                _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + pos + 1)), lower);
+            for (const char *keyword : kKeywords) {
+                hits = _mm256_or_si256(
+                    hits, _mm256_and_si256(_mm256_cmpeq_epi8(first, _mm256_set1_epi8(keyword[0])),
+                                           _mm256_cmpeq_epi8(second,
+                                                             _mm256_set1_epi8(keyword[1]))));
+            }
+        }
+        const uint32_t bits = static_cast<uint32_t>(_mm256_movemask_epi8(hits));
+        if (bits != 0) {
+            return pos + static_cast<size_t>(__builtin_ctz(bits));
+        }
+    }
+    return nextCandidateScalar(data, len, pos, mask);
+}
+
+#else // !RXREVOLTCHAIN_PII_X86
+
+inline bool cpuHasAvx2() { return false; }
+
+#endif
+
+/** End of 'groups' digit groups joined by '-' starting at pos, or 0. */
+inline size_t matchDigitGroups(const uint8_t *data, size_t len, size_t pos,
+                               std::initializer_list<int> groups)
+{
+    bool first = true;
+    for (int count : groups) {
+        if (!first) {
+            if (pos >= len || data[pos] != '-') {
+                return 0;
+            }
+            ++pos;
+        }
+        first = false;
+        for (int i = 0; i < count; ++i, ++pos) {
+            if (pos >= len || !isDigit(data[pos])) {
+                return 0;
+            }
+        }
+    }
+    return pos;
+}
+
+inline bool luhnValid(const uint8_t *digits, size_t count)
+{
+    unsigned sum = 0;
+    for (size_t i = 0; i < count; ++i) {
+        unsigned d = digits[count - 1 - i];
+        if (i % 2 == 1) {
+            d *= 2;
+            if (d > 9) {
+                d -= 9;
+            }
+        }
+        sum += d;
+    }
+    return sum % 10 == 0;
+}
+
+/** Longest card number starting at digit 'pos' (a word boundary), or 0. */
+inline size_t matchCardNumber(const uint8_t *data, size_t len, size_t pos)
+{
+    if (data[pos] < '2' || data[pos] > '6') {
+        return 0;
+    }
+    uint8_t digits[19];
+    size_t count = 0;
+    size_t best = 0;
+    size_t p = pos;
+    while (p < len && isDigit(data[p])) {
+        if (count == sizeof(digits)) {
+            return best; // longer runs continue past the boundary a match needs
+        }
+        digits[count++] = static_cast<uint8_t>(data[p++] - '0');
+        if (p < len && isDigit(data[p])) {
+            continue;
+        }
+        // End of a digit group: a candidate end if a word boundary follows
+        if (count >= 13 && (p == len || !isWord(data[p])) && luhnValid(digits, count)) {
+            best = p;
+        }
+        if (p + 1 < len && (data[p] == ' ' || data[p] == '-') && isDigit(data[p + 1])) {
+            ++p;
+        }
+    }
+    return best;
+}
+
+/** End of "(ddd) ddd-dddd" at pos (ddd) with at most one whitespace after ')', or 0. */
+inline size_t matchParenPhone(const uint8_t *data, size_t len, size_t pos)
+{
+    size_t p = matchDigitGroups(data, len, pos + 1, {3});
+    if (p == 0 || p >= len || data[p] != ')') {
+        return 0;
+    }
+    ++p;
+    if (p < len && isSpace(data[p])) {
+        ++p;
+    }
+    return matchDigitGroups(data, len, p, {3, 4});
+}
+
+/** End of the domain of an address whose '@' is at pos, or 0. */
+inline size_t matchEmailDomain(const uint8_t *data, size_t len, size_t pos)
+{
+    size_t p = pos + 1;
+    size_t labels = 0;
+    size_t end = 0;
+    while (p < len && isDomainChar(data[p])) {
+        const size_t labelStart = p;
+        bool alpha = true;
+        while (p < len && isDomainChar(data[p])) {
+            alpha = alpha && isAlpha(data[p]);
+            ++p;
+        }
+        if (++labels >= 2 && alpha && p - labelStart >= 2) {
+            end = p;
+        }
+        if (p + 1 < len && data[p] == '.' && isDomainChar(data[p + 1])) {
+            ++p;
+        } else {
+            break;
+        }
+    }
+    return end;
+}
+
+inline bool matchKeyword(const uint8_t *data, size_t len, size_t pos)
+{
+    for (const char *keyword : kKeywords) {
+        const size_t n = std::strlen(keyword);
+        if (len - pos < n) {
+            continue;
+        }
+        size_t i = 0;
+        while (i < n && (data[pos + i] | 0x20) == static_cast<uint8_t>(keyword[i])) {
+            ++i;
+        }
+        if (i == n) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace detail
+
+/** True if 'backend' can run on this CPU. */
+inline bool backendAvailable(Backend backend)
+{
+    static const bool avx2 = detail::cpuHasAvx2();
+    return backend == Backend::Avx2 ? avx2 : true;
+}
+
+namespace detail {
+
+inline std::atomic<int> &activeBackendSlot()
+{
+    static std::atomic<int> slot(
+        static_cast<int>(backendAvailable(Backend::Avx2) ? Backend::Avx2 : Backend::Scalar));
+    return slot;
+}
+
+} // namespace detail
+
+/** Backend currently used by scan(). */
+inline Backend backend()
+{
+    return static_cast<Backend>(detail::activeBackendSlot().load(std::memory_order_relaxed));
+}
+
+/**
+ * @brief Select the backend for scan().
+ * @return false (and no change) if the backend is not supported on this CPU.
+ */
+inline bool setBackend(Backend backend)
+{
+    if (!backendAvailable(backend)) {
+        return false;
+    }
+    detail::activeBackendSlot().store(static_cast<int>(backend), std::memory_order_relaxed);
+    return true;
+}
+
+/**
+ * @brief Find the selected patterns in 'len' bytes; matches are appended to out.matches.
+ *        A scan for Keywords alone stops at the first keyword.
+ */
+inline void scan(const uint8_t *data, size_t len, uint32_t patterns, ScanResult &out)
+{
+    using namespace detail;
+    const bool digitPatterns = (patterns & (Ssn | Phone | CardNumber)) != 0;
+    const bool emails = (patterns & Email) != 0;
+    uint8_t mask = (patterns & ~uint32_t(Keywords)) ? kPatternStart : 0;
+    if ((patterns & Keywords) && !out.suspicious) {
+        mask |= kKeywordStart;
+    }
+#if RXREVOLTCHAIN_PII_X86
+    const bool avx2 = backend() == Backend::Avx2;
+#endif
+    size_t floor = out.matches.empty() ? 0 : out.matches.back().end; // end of the last match
+    size_t pos = 0;
+    while (mask != 0) {
+#if RXREVOLTCHAIN_PII_X86
+        pos = avx2 ? nextCandidateAvx2(data, len, pos, mask)
+                   : nextCandidateScalar(data, len, pos, mask);
+#else
+        pos = nextCandidateScalar(data, len, pos, mask);
+#endif
+        if (pos >= len) {
+            return;
+        }
+        const uint8_t c = data[pos];
+        size_t begin = pos;
+        size_t end = 0;
+        if (isDigit(c)) {
+            if (digitPatterns && (pos == 0 || !isWord(data[pos - 1]))) {
+                if (patterns & Ssn) {
+                    end = matchDigitGroups(data, len, pos, {3, 2, 4});
+                    end = (end == len || (end && !isWord(data[end]))) ? end : 0;
+                }
+                if (!end && (patterns & Phone)) {
+                    end = matchDigitGroups(data, len, pos, {3, 3, 4});
+                    end = (end == len || (end && !isWord(data[end]))) ? end : 0;
+                }
+                if (!end && (patterns & CardNumber)) {
+                    end = matchCardNumber(data, len, pos);
+                }
+            }
+            if (!end) {
+                // No digit pattern starts inside a run of digits
+                while (pos < len && isDigit(data[pos])) {
+                    ++pos;
+                }
+                continue;
+            }
+        } else if (c == '(') {
+            end = (patterns & Phone) ? matchParenPhone(data, len, pos) : 0;
+        } else if (c == '@') {
+            if (emails && pos > floor && isEmailLocal(data[pos - 1])) {
+                end = matchEmailDomain(data, len, pos);
+                while (end && begin > floor && isEmailLocal(data[begin - 1])) {
+                    --begin;
+                }
+            }
+        } else if ((mask & kKeywordStart) && matchKeyword(data, len, pos)) {
+            out.suspicious = true;
+            mask &= ~kKeywordStart;
+            if (patterns == Keywords) {
+                return;
+            }
+        }
+        if (end) {
+            out.matches.push_back(Match{begin, end});
+            floor = pos = end;
+        } else {
+            ++pos;
+        }
+    }
+}
+
+/**
+ * @brief Replace every match in 'data' with 'replacement', in place.
+ * @param matches In order and non-overlapping, as produced by scan().
+ */
+inline void redact(std::vector<uint8_t> &data, const std::vector<Match> &matches,
+                   const char *replacement = "[REDACTED]")
+{
+    if (matches.empty()) {
+        return;
+    }
+    const size_t rlen = std::strlen(replacement);
+    // Running size change after each match decides the direction bytes can move in place
+    bool neverGrows = true;
+    bool neverShrinks = true;
+    long long delta = 0;
+    for (const Match &m : matches) {
+        delta += static_cast<long long>(rlen) - static_cast<long long>(m.end - m.begin);
+        neverGrows = neverGrows && delta <= 0;
+        neverShrinks = neverShrinks && delta >= 0;
+    }
+    const size_t oldSize = data.size();
+    const size_t newSize = static_cast<size_t>(static_cast<long long>(oldSize) + delta);
+
+    if (neverGrows) {
+        // Front to back: every byte moves left (or stays)
+        uint8_t *p = data.data();
+        size_t w = matches.front().begin;
+        for (size_t i = 0; i < matches.size(); ++i) {
+            std::memcpy(p + w, replacement, rlen);
+            w += rlen;
+            const size_t from = matches[i].end;
+            const size_t to = i + 1 < matches.size() ? matches[i + 1].begin : oldSize;
+            std::memmove(p + w, p + from, to - from);
+            w += to - from;
+        }
+        data.resize(newSize);
+    } else if (neverShrinks) {
+        // Back to front: every byte moves right (or stays)
+        data.resize(newSize);
+        uint8_t *p = data.data();
+        size_t w = newSize;
+        size_t r = oldSize;
+        for (size_t i = matches.size(); i-- > 0;) {
+            const size_t tail = r - matches[i].end;
+            w -= tail;
+            std::memmove(p + w, p + matches[i].end, tail);
+            w -= rlen;
+            std::memcpy(p + w, replacement, rlen);
+            r = matches[i].begin;
+        }
+    } else {
+        std::vector<uint8_t> out;
+        out.reserve(newSize);
+        size_t r = 0;
+        for (const Match &m : matches) {
+            out.insert(out.end(), data.begin() + r, data.begin() + m.begin);
+            out.insert(out.end(), replacement, replacement + rlen);
+            r = m.end;
+        }
+        out.insert(out.end(), data.begin() + r, data.end());
+        data.swap(out);
+    }
+}
+
+} // namespace pii
+} // namespace util
+} // namespace rxrevoltchain
+
+#endif // RXREVOLTCHAIN_UTIL_PII_SCANNER_HPP
@@ -0,0 +1,136 @@
+#ifndef RXREVOLTCHAIN_UTIL_READ_AHEAD_HPP
+#define RXREVOLTCHAIN_UTIL_READ_AHEAD_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @file read_ahead.hpp
+ * @brief Double-buffered sequential reads on one helper thread per stream.
+ *
+ * The helper thread stays one block ahead of the consumer, so the next block is read
+ * while the current one is processed. Buffers change hands by swapping, so nothing is
+ * copied, and one thread serves the whole stream instead of one per block.
+ *
+ * Usage Example:
+ *  @code
+ *    std::ifstream in(path, std::ios::binary);
+ *    rxrevoltchain::util::ReadAhead reader(in, 1 << 20);
+ *    std::vector<uint8_t> block;
+ *    size_t n = 0;
+ *    while ((n = reader.next(block)) > 0) { consume(block.data(), n); }
+ *    if (reader.failed()) { ... }
+ *  @endcode
+ */
+
+namespace rxrevoltchain {
+namespace util {
+
+/**
+ * @class ReadAhead
+ * @brief Reads 'in' in blocks of 'blockBytes' on a dedicated thread. The stream must not
+ *        be touched by anyone else until the ReadAhead is destroyed.
+ */
+class ReadAhead
+{
+public:
+    ReadAhead(std::istream& in, size_t blockBytes)
+        : in_(in), blockBytes_(blockBytes), thread_([this] { readLoop(); })
+    {
+    }
+
+    /**
+     * @brief Stops and joins the reader thread (also when the consumer is not done yet).
+     */
+    ~ReadAhead()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        condVar_.notify_all();
+        thread_.join();
+    }
+
+    ReadAhead(const ReadAhead&) = delete;
+    ReadAhead& operator=(const ReadAhead&) = delete;
+
+    /**
+     * @brief Swap the next block into 'buf' and return its length; 0 once the stream ended.
+     *        'buf' may be resized; only the first returned bytes are valid.
+     */
+    size_t next(std::vector<uint8_t>& buf)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        condVar_.wait(lock, [this] { return full_ || done_; });
+        if (!full_) {
+            return 0;
+        }
+        buf.swap(ahead_);
+        full_ = false;
+        condVar_.notify_all();
+        return aheadBytes_;
+    }
+
+    /**
+     * @brief True if reading stopped on an I/O error rather than at the end of the stream.
+     */
+    bool failed()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return bad_;
+    }
+
+private:
+    void readLoop()
+    {
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                condVar_.wait(lock, [this] { return stop_ || !full_; });
+                if (stop_) {
+                    return;
+                }
+            }
+            // ahead_ belongs to this thread until full_ is set again
+            ahead_.resize(blockBytes_);
+            in_.read(reinterpret_cast<char*>(ahead_.data()),
+                     static_cast<std::streamsize>(ahead_.size()));
+            const size_t n = static_cast<size_t>(in_.gcount());
+            const bool end = n == 0 || !in_.good();
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                aheadBytes_ = n;
+                full_ = n > 0;
+                done_ = end;
+                bad_ = in_.bad();
+            }
+            condVar_.notify_all();
+            if (end) {
+                return;
+            }
+        }
+    }
+
+    std::istream& in_;          ///< Only read on thread_
+    const size_t blockBytes_;
+    std::mutex mutex_;          ///< Guards the fields below and hands ahead_ over
+    std::condition_variable condVar_;
+    std::vector<uint8_t> ahead_;
+    size_t aheadBytes_ = 0;
+    bool full_ = false;         ///< ahead_ holds a block the consumer has not taken
+    bool done_ = false;         ///< The reader thread has stopped
+    bool bad_ = false;
+    bool stop_ = false;
+    std::thread thread_;        ///< Last, so it starts once the fields above exist
+};
+
+} // namespace util
+} // namespace rxrevoltchain
+
+#endif // RXREVOLTCHAIN_UTIL_READ_AHEAD_HPP
@@ -0,0 +1,343 @@
+#ifndef RXREVOLTCHAIN_UTIL_SHA256_SIMD_HPP
+#define RXREVOLTCHAIN_UTIL_SHA256_SIMD_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <immintrin.h>
+#define RXREVOLTCHAIN_SHA256_X86 1
+#else
+#define RXREVOLTCHAIN_SHA256_X86 0
+#endif
+
+/**
+ * @file sha256_simd.hpp
+ * @brief SHA-256 compression kernels used by hashing.hpp.
+ *
+ * DESIGN:
+ *   - compressShaNi: one message, using the x86 SHA extensions (SHA-NI).
+ *   - compress8Avx2: eight independent messages of equal length at once, one message per
+ *     32-bit lane of the AVX2 registers ("multi-buffer" hashing).
+ *   - Both are compiled with function-level target attributes, so the rest of the project
+ *     needs no special compiler flags. Callers must check cpuHasShaNi() / cpuHasAvx2()
+ *     before calling them; hashing.hpp does this once at startup.
+ *   - Only the compression functions and the SHA-256 padding live here. Hex encoding,
+ *     backend selection and OpenSSL fallbacks are in hashing.hpp.
+ */
+
+namespace rxrevoltchain {
+namespace util {
+namespace hashing {
+namespace detail {
+
+/** SHA-256 round constants (FIPS 180-4, section 4.2.2). */
+alignas(64) static constexpr uint32_t kSha256K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4,
+    0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe,
+    0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f,
+    0x4a7484aa, 0x5cb0a9dc, 0x76f988da, 0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+    0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc,
+    0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070, 0x19a4c116,
+    0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7,
+    0xc67178f2};
+
+/** Initial hash value H(0). */
+static constexpr uint32_t kSha256Init[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                            0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+
+/**
+ * @brief Build the final padded block(s) of a message of 'totalLen' bytes.
+ * @param tail The last (totalLen % 64) bytes of the message.
+ * @param out Buffer of at least 128 bytes.
+ * @return Number of padding blocks written (1 or 2).
+ */
+inline size_t sha256PadTail(const uint8_t* tail, size_t totalLen, uint8_t* out) {
+    const size_t rem = totalLen % 64;
+    const size_t blocks = (rem < 56) ? 1 : 2;
+    std::memset(out, 0, blocks * 64);
+    if (rem) {
+        std::memcpy(out, tail, rem);
+    }
+    out[rem] = 0x80;
+    const uint64_t bits = static_cast<uint64_t>(totalLen) * 8;
+    for (size_t i = 0; i < 8; ++i) {
+        out[blocks * 64 - 1 - i] = static_cast<uint8_t>(bits >> (8 * i));
+    }
+    return blocks;
+}
+
+/** Write eight state words as a big-endian 32-byte digest. */
+inline void sha256StoreDigest(const uint32_t state[8], uint8_t* out) {
+    for (size_t i = 0; i < 8; ++i) {
+        out[4 * i + 0] = static_cast<uint8_t>(state[i] >> 24);
+        out[4 * i + 1] = static_cast<uint8_t>(state[i] >> 16);
+        out[4 * i + 2] = static_cast<uint8_t>(state[i] >> 8);
+        out[4 * i + 3] = static_cast<uint8_t>(state[i]);
+    }
+}
+
+#if RXREVOLTCHAIN_SHA256_X86
+
+/** True if the CPU implements the SHA extensions and SSE4.1. */
+inline bool cpuHasShaNi() {
+    unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & bit_SSE4_1) || !(ecx & bit_SSSE3)) {
+        return false;
+    }
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+    return (ebx & (1u << 29)) != 0;
+}
+
+/** True if the CPU implements AVX2 and the OS saves the YMM registers. */
+inline bool cpuHasAvx2() {
+    unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & bit_OSXSAVE) || !(ecx & bit_AVX)) {
+        return false;
+    }
+    unsigned int xcr0Lo = 0, xcr0Hi = 0;
+    __asm__("xgetbv" : "=a"(xcr0Lo), "=d"(xcr0Hi) : "c"(0));
+    if ((xcr0Lo & 0x6) != 0x6) {
+        return false;
+    }
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+    return (ebx & bit_AVX2) != 0;
+}
+
+/**
+ * @brief Process 'blocks' consecutive 64-byte blocks of one message with SHA-NI.
+ * @param state The eight working state words, updated in place.
+ */
+__attribute__((target("sha,sse4.1,ssse3"))) inline void
+compressShaNi(uint32_t state[8], const uint8_t* data, size_t blocks) {
+    const __m128i byteSwap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    // SHA-NI keeps the state as ABEF / CDGH
+    __m128i tmp = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&state[0]));
+    __m128i state1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&state[4]));
+    tmp = _mm_shuffle_epi32(tmp, 0xB1);             // CDAB
+    state1 = _mm_shuffle_epi32(state1, 0x1B);       // EFGH
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8); // ABEF
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);    // CDGH
+
+    for (; blocks > 0; --blocks, data += 64) {
+        const __m128i abefSave = state0;
+        const __m128i cdghSave = state1;
+
+        __m128i w[4];
+        for (int i = 0; i < 4; ++i) {
+            w[i] = _mm_shuffle_epi8(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16 * i)), byteSwap);
+        }
+
+        // 16 groups of four rounds; the schedule for group g + 4 reuses slot g % 4
+        for (int g = 0; g < 16; ++g) {
+            __m128i msg = _mm_add_epi32(
+                w[g & 3], _mm_load_si128(reinterpret_cast<const __m128i*>(&kSha256K[4 * g])));
+            state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+            msg = _mm_shuffle_epi32(msg, 0x0E);
+            state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+
+            if (g < 12) {
+                __m128i next = _mm_sha256msg1_epu32(w[g & 3], w[(g + 1) & 3]);
+                next = _mm_add_epi32(next, _mm_alignr_epi8(w[(g + 3) & 3], w[(g + 2) & 3], 4));
+                w[g & 3] = _mm_sha256msg2_epu32(next, w[(g + 3) & 3]);
+            }
+        }
+
+        state0 = _mm_add_epi32(state0, abefSave);
+        state1 = _mm_add_epi32(state1, cdghSave);
+    }
+
+    tmp = _mm_shuffle_epi32(state0, 0x1B);        // FEBA
+    state1 = _mm_shuffle_epi32(state1, 0xB1);     // DCHG
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0);  // DCBA
+    state1 = _mm_alignr_epi8(state1, tmp, 8);     // HGFE
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&state[0]), state0);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&state[4]), state1);
+}
+
+/** One-shot SHA-256 of a message using SHA-NI. */
+__attribute__((target("sha,sse4.1,ssse3"))) inline void sha256ShaNi(const uint8_t* data,
+                                                                    size_t len, uint8_t* out) {
+    uint32_t state[8];
+    std::memcpy(state, kSha256Init, sizeof(state));
+    const size_t full = len / 64;
+    compressShaNi(state, data, full);
+    uint8_t tail[128];
+    size_t tailBlocks = sha256PadTail(data + full * 64, len, tail);
+    compressShaNi(state, tail, tailBlocks);
+    sha256StoreDigest(state, out);
+}
+
+#define RXREVOLTCHAIN_AVX2_TARGET __attribute__((target("avx2")))
+
+RXREVOLTCHAIN_AVX2_TARGET inline __m256i avx2Rotr(__m256i x, int n) {
+    return _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - n));
+}
+
+/** Transpose eight rows of eight 32-bit words in place. */
+RXREVOLTCHAIN_AVX2_TARGET inline void avx2Transpose8(__m256i r[8]) {
+    __m256i t0 = _mm256_unpacklo_epi32(r[0], r[1]);
+    __m256i t1 = _mm256_unpackhi_epi32(r[0], r[1]);
+    __m256i t2 = _mm256_unpacklo_epi32(r[2], r[3]);
+    __m256i t3 = _mm256_unpackhi_epi32(r[2], r[3]);
+    __m256i t4 = _mm256_unpacklo_epi32(r[4], r[5]);
+    __m256i t5 = _mm256_unpackhi_epi32(r[4], r[5]);
+    __m256i t6 = _mm256_unpacklo_epi32(r[6], r[7]);
+    __m256i t7 = _mm256_unpackhi_epi32(r[6], r[7]);
+    __m256i u0 = _mm256_unpacklo_epi64(t0, t2);
+    __m256i u1 = _mm256_unpackhi_epi64(t0, t2);
+    __m256i u2 = _mm256_unpacklo_epi64(t1, t3);
+    __m256i u3 = _mm256_unpackhi_epi64(t1, t3);
+    __m256i u4 = _mm256_unpacklo_epi64(t4, t6);
+    __m256i u5 = _mm256_unpackhi_epi64(t4, t6);
+    __m256i u6 = _mm256_unpacklo_epi64(t5, t7);
+    __m256i u7 = _mm256_unpackhi_epi64(t5, t7);
+    r[0] = _mm256_permute2x128_si256(u0, u4, 0x20);
+    r[1] = _mm256_permute2x128_si256(u1, u5, 0x20);
+    r[2] = _mm256_permute2x128_si256(u2, u6, 0x20);
+    r[3] = _mm256_permute2x128_si256(u3, u7, 0x20);
+    r[4] = _mm256_permute2x128_si256(u0, u4, 0x31);
+    r[5] = _mm256_permute2x128_si256(u1, u5, 0x31);
+    r[6] = _mm256_permute2x128_si256(u2, u6, 0x31);
+    r[7] = _mm256_permute2x128_si256(u3, u7, 0x31);
+}
+
+/**
+ * @brief Process 'blocks' 64-byte blocks of eight messages at once with AVX2.
+ * @param state state[j] holds working word j of all eight messages (lane i = message i).
+ * @param lanes Pointer to the first block of each message.
+ */
+RXREVOLTCHAIN_AVX2_TARGET inline void compress8Avx2(__m256i state[8], const uint8_t* const lanes[8],
+                                                    size_t blocks) {
+    const __m256i byteSwap =
+        _mm256_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3, 12, 13, 14, 15, 8,
+                        9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+
+    for (size_t b = 0; b < blocks; ++b) {
+        // Load message words: w[t] holds word t of every lane
+        __m256i w[16];
+        for (int half = 0; half < 2; ++half) {
+            __m256i rows[8];
+            for (int i = 0; i < 8; ++i) {
+                rows[i] = _mm256_shuffle_epi8(
+                    _mm256_loadu_si256(
+                        reinterpret_cast<const __m256i*>(lanes[i] + b * 64 + half * 32)),
+                    byteSwap);
+            }
+            avx2Transpose8(rows);
+            for (int i = 0; i < 8; ++i) {
+                w[half * 8 + i] = rows[i];
+            }
+        }
+
+        __m256i a = state[0], bb = state[1], c = state[2], d = state[3];
+        __m256i e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int t = 0; t < 64; ++t) {
+            __m256i wt;
+            if (t < 16) {
+                wt = w[t];
+            } else {
+                __m256i w15 = w[(t - 15) & 15];
+                __m256i w2 = w[(t - 2) & 15];
+                __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(avx2Rotr(w15, 7), avx2Rotr(w15, 18)),
+                                              _mm256_srli_epi32(w15, 3));
+                __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(avx2Rotr(w2, 17), avx2Rotr(w2, 19)),
+                                              _mm256_srli_epi32(w2, 10));
+                wt = _mm256_add_epi32(_mm256_add_epi32(w[t & 15], s0),
+                                      _mm256_add_epi32(w[(t - 7) & 15], s1));
+                w[t & 15] = wt;
+            }
+
+            __m256i bigS1 = _mm256_xor_si256(_mm256_xor_si256(avx2Rotr(e, 6), avx2Rotr(e, 11)),
+                                             avx2Rotr(e, 25));
+            __m256i ch = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+            __m256i t1 = _mm256_add_epi32(
+                _mm256_add_epi32(_mm256_add_epi32(h, bigS1), _mm256_add_epi32(ch, wt)),
+                _mm256_set1_epi32(static_cast<int>(kSha256K[t])));
+            __m256i bigS0 = _mm256_xor_si256(_mm256_xor_si256(avx2Rotr(a, 2), avx2Rotr(a, 13)),
+                                             avx2Rotr(a, 22));
+            __m256i maj = _mm256_or_si256(_mm256_and_si256(a, bb),
+                                          _mm256_and_si256(c, _mm256_or_si256(a, bb)));
+            __m256i t2 = _mm256_add_epi32(bigS0, maj);
+            h = g;
+            g = f;
+            f = e;
+            e = _mm256_add_epi32(d, t1);
+            d = c;
+            c = bb;
+            bb = a;
+            a = _mm256_add_epi32(t1, t2);
+        }
+
+        state[0] = _mm256_add_epi32(state[0], a);
+        state[1] = _mm256_add_epi32(state[1], bb);
+        state[2] = _mm256_add_epi32(state[2], c);
+        state[3] = _mm256_add_epi32(state[3], d);
+        state[4] = _mm256_add_epi32(state[4], e);
+        state[5] = _mm256_add_epi32(state[5], f);
+        state[6] = _mm256_add_epi32(state[6], g);
+        state[7] = _mm256_add_epi32(state[7], h);
+    }
+}
+
+/**
+ * @brief SHA-256 of eight messages of 'len' bytes each, message i at data + i * stride.
+ * @param out Receives eight consecutive 32-byte digests.
+ */
+RXREVOLTCHAIN_AVX2_TARGET inline void sha256x8Avx2(const uint8_t* data, size_t stride, size_t len,
+                                                   uint8_t* out) {
+    __m256i state[8];
+    for (int j = 0; j < 8; ++j) {
+        state[j] = _mm256_set1_epi32(static_cast<int>(kSha256Init[j]));
+    }
+
+    const uint8_t* lanes[8];
+    for (int i = 0; i < 8; ++i) {
+        lanes[i] = data + i * stride;
+    }
+    const size_t full = len / 64;
+    compress8Avx2(state, lanes, full);
+
+    // All messages have the same length, so they share the same padding layout
+    alignas(32) uint8_t tails[8][128];
+    size_t tailBlocks = 0;
+    for (int i = 0; i < 8; ++i) {
+        tailBlocks = sha256PadTail(lanes[i] + full * 64, len, tails[i]);
+        lanes[i] = tails[i];
+    }
+    compress8Avx2(state, lanes, tailBlocks);
+
+    // state[j] lane i is word j of digest i; transpose to one row per digest
+    avx2Transpose8(state);
+    alignas(32) uint32_t words[8];
+    for (int i = 0; i < 8; ++i) {
+        _mm256_store_si256(reinterpret_cast<__m256i*>(words), state[i]);
+        sha256StoreDigest(words, out + 32 * i);
+    }
+}
+
+#undef RXREVOLTCHAIN_AVX2_TARGET
+
+#else // !RXREVOLTCHAIN_SHA256_X86
+
+inline bool cpuHasShaNi() { return false; }
+inline bool cpuHasAvx2() { return false; }
+
+#endif
+
+} // namespace detail
+} // namespace hashing
+} // namespace util
+} // namespace rxrevoltchain
+
+#endif // RXREVOLTCHAIN_UTIL_SHA256_SIMD_HPP
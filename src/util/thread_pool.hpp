@@ -1,6 +1,10 @@
 #ifndef RXREVOLTCHAIN_UTIL_THREAD_POOL_HPP
 #define RXREVOLTCHAIN_UTIL_THREAD_POOL_HPP
 
+#include <algorithm>
+#include <exception>
+#include <memory>
+#include <stdexcept>
 #include <vector>
 #include <queue>
 #include <future>
@@ -21,6 +25,10 @@
  *    auto result = pool.enqueue([](int x) { return x*x; }, 10);
  *    // do other work...
  *    std::cout << "Result: " << result.get() << std::endl;
+ *
+ *    // Data-parallel loop on the process-wide pool; the caller takes part in the work
+ *    rxrevoltchain::util::ThreadPool::getInstance().parallelFor(n, 64,
+ *        [&](size_t begin, size_t end) { for (size_t i = begin; i < end; ++i) work(i); });
  *  @endcode
  */
 
@@ -33,6 +41,9 @@ namespace util {
  *
  * - Constructor spawns a given number of worker threads.
  * - enqueue(...) can be used to schedule tasks for asynchronous execution.
+ * - submit(...) does the same for tasks that may be waited on from inside the pool.
+ * - parallelFor(...) splits an index range across the workers and the calling thread.
+ * - getInstance() returns a process-wide pool sized to the hardware concurrency.
  * - Destructor gracefully shuts down the pool, waiting for all tasks to finish.
  */
 class ThreadPool
@@ -137,6 +148,191 @@ public:
         return res;
     }
 
+    /**
+     * @class TaskHandle
+     * @brief Result of submit(). Waiting on it never depends on a free worker: a task no
+     *        worker has started yet is run by the waiting thread itself.
+     */
+    template<typename R>
+    class TaskHandle
+    {
+    public:
+        TaskHandle() = default;
+
+        /**
+         * @brief True until get() has been called (like std::future::valid).
+         */
+        bool valid() const
+        {
+            return state_ != nullptr;
+        }
+
+        /**
+         * @brief Returns once the task has finished, running it here if it was still queued.
+         */
+        void wait()
+        {
+            if (!state_->claimed.exchange(true)) {
+                state_->task();
+            }
+            state_->future.wait();
+        }
+
+        /**
+         * @brief wait(), then return the task's result or rethrow its exception.
+         */
+        R get()
+        {
+            wait();
+            std::shared_ptr<State> state = std::move(state_);
+            return state->future.get();
+        }
+
+    private:
+        friend class ThreadPool;
+
+        struct State
+        {
+            std::atomic<bool> claimed{false}; ///< Set by whoever runs the task
+            std::packaged_task<R()> task;
+            std::future<R> future;
+        };
+        std::shared_ptr<State> state_;
+    };
+
+    /**
+     * @brief Like enqueue(), but the returned handle runs the task on the waiting thread if
+     *        no worker has picked it up yet. Use it for work that is waited on from inside
+     *        a pool task, where enqueue() could deadlock once every worker is waiting.
+     * @param f The callable to execute, without arguments.
+     * @return A TaskHandle for the callable's result.
+     */
+    template<typename F>
+    auto submit(F&& f) -> TaskHandle<typename std::invoke_result<F>::type>
+    {
+        using return_type = typename std::invoke_result<F>::type;
+        TaskHandle<return_type> handle;
+        handle.state_ = std::make_shared<typename TaskHandle<return_type>::State>();
+        handle.state_->task = std::packaged_task<return_type()>(std::forward<F>(f));
+        handle.state_->future = handle.state_->task.get_future();
+        {
+            std::unique_lock<std::mutex> lock(queueMutex_);
+            if (!stop_) {
+                auto state = handle.state_;
+                taskQueue_.emplace([state]() {
+                    if (!state->claimed.exchange(true)) {
+                        state->task();
+                    }
+                });
+            }
+        }
+        condVar_.notify_one();
+        return handle;
+    }
+
+    /**
+     * @brief Process-wide pool shared by CPU-bound helpers (hashing, merkle construction).
+     *        Created on first use with one worker per hardware thread.
+     */
+    static ThreadPool& getInstance()
+    {
+        static ThreadPool instance;
+        return instance;
+    }
+
+    /**
+     * @brief Number of worker threads in the pool.
+     */
+    size_t size() const
+    {
+        return workers_.size();
+    }
+
+    /**
+     * @brief Run fn(begin, end) over [0, count) in blocks of at most 'grain' indices.
+     *
+     * Blocks are claimed from a shared atomic counter by up to size() helper tasks and by
+     * the calling thread itself, which keeps claiming until every block is taken. The call
+     * returns once all claimed blocks have finished, not when the helpers have run, so it
+     * cannot deadlock when invoked from inside a pool task while all workers are busy.
+     * The first exception thrown by fn is rethrown in the caller.
+     *
+     * @param count Number of indices.
+     * @param grain Indices per block (values below 1 are treated as 1).
+     * @param fn Callable invoked as fn(size_t begin, size_t end); must be thread-safe.
+     */
+    template<typename F>
+    void parallelFor(size_t count, size_t grain, F&& fn)
+    {
+        if (count == 0) {
+            return;
+        }
+        grain = std::max<size_t>(1, grain);
+        const size_t blocks = (count + grain - 1) / grain;
+        if (blocks == 1 || workers_.empty()) {
+            fn(0, count);
+            return;
+        }
+
+        struct LoopState {
+            std::atomic<size_t> next{0};
+            size_t finished = 0;
+            std::exception_ptr error;
+            std::mutex mutex;
+            std::condition_variable done;
+        };
+        auto state = std::make_shared<LoopState>();
+        auto body = std::make_shared<std::function<void(size_t, size_t)>>(
+            [&fn](size_t b, size_t e) { fn(b, e); });
+
+        // Claims blocks until none remain; shared by helpers and the caller
+        auto drain = [state, body, count, grain, blocks]() {
+            size_t ran = 0;
+            std::exception_ptr error;
+            for (size_t block; (block = state->next.fetch_add(1)) < blocks; ++ran) {
+                if (error) {
+                    continue; // still account for the block so the caller is released
+                }
+                size_t begin = block * grain;
+                try {
+                    (*body)(begin, std::min(count, begin + grain));
+                } catch (...) {
+                    error = std::current_exception();
+                }
+            }
+            if (ran == 0) {
+                return;
+            }
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->finished += ran;
+            if (error && !state->error) {
+                state->error = error;
+            }
+            if (state->finished == blocks) {
+                state->done.notify_all();
+            }
+        };
+
+        const size_t helpers = std::min(workers_.size(), blocks - 1);
+        {
+            std::unique_lock<std::mutex> lock(queueMutex_);
+            if (!stop_) {
+                for (size_t i = 0; i < helpers; ++i) {
+                    taskQueue_.emplace(drain);
+                }
+            }
+        }
+        condVar_.notify_all();
+
+        drain();
+
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->done.wait(lock, [&] { return state->finished == blocks; });
+        if (state->error) {
+            std::rethrow_exception(state->error);
+        }
+    }
+
 private:
     std::vector<std::thread> workers_;               ///< The pool of worker threads
     std::queue<std::function<void()>> taskQueue_;    ///< Task queue
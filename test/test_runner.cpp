@@ -16,11 +16,22 @@ int main(int argc, char** argv) {
 // A collection of unit tests for RxRevoltChain components.
 // Demonstrates a simple multi-node simulated network test as well.
 
+#include <arpa/inet.h>
 #include <atomic>
 #include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
 #include <gtest/gtest.h>
+#include <map>
+#include <memory>
+#include <random>
+#include <regex>
+#include <set>
 #include <sqlite3.h>
 #include <string>
+#include <sys/stat.h>
 #include <thread>
 #include <vector>
 #include <zlib.h>
@@ -30,15 +41,32 @@ int main(int argc, char** argv) {
 #include "config/node_config.hpp"
 #include "connectors/ehr_connector.hpp"
 #include "core/daily_snapshot.hpp"
+#include "core/document_index.hpp"
 #include "core/document_queue.hpp"
 #include "core/privacy_manager.hpp"
+#include "core/sharded_snapshot.hpp"
+#include "core/signature_verifier.hpp"
 #include "core/transaction.hpp"
+#include "core/write_ahead_log.hpp"
+#include "ipfs_integration/ipfs_pinner.hpp"
+#include "ipfs_integration/merkle_proof.hpp"
+#include "ipfs_integration/merkle_tree_cache.hpp"
+#include "ipfs_integration/snapshot_delta.hpp"
 #include "network/http_query_server.hpp"
 #include "network/p2p_node.hpp"
 #include "network/protocol_messages.hpp"
+#include "network/snapshot_sync.hpp"
 #include "pinner/daily_scheduler.hpp"
 #include "pinner/pinner_node.hpp"
+#include "pinner/proof_generator.hpp"
+#include "util/base64.hpp"
+#include "util/compression.hpp"
+#include "util/curl_handle_pool.hpp"
+#include "util/hashing.hpp"
+#include "util/json_parser.hpp"
 #include "util/logger.hpp"
+#include "util/pii_scanner.hpp"
+#include "util/thread_pool.hpp"
 
 namespace {
 
@@ -71,6 +99,106 @@ TEST(TransactionTest, BasicUsage) {
     EXPECT_EQ(tx.GetSignature().size(), (size_t)5);
 }
 
+// The payload buffer handed to the queue is the same one FetchAll returns and the
+// privacy manager redacts: no copies on the hot path.
+TEST(TransactionTest, MoveThroughQueueWithoutCopies) {
+    const std::string file = "test_queue_move.wal";
+    std::remove(file.c_str());
+    rxrevoltchain::core::DocumentQueue queue(file);
+
+    std::string text = "patient ssn 123-45-6789 on file";
+    std::vector<uint8_t> payload(text.begin(), text.end());
+    const uint8_t* buffer = payload.data();
+
+    rxrevoltchain::core::Transaction tx;
+    tx.SetType("document_submission");
+    tx.SetPayload(std::move(payload));
+    EXPECT_EQ(tx.GetPayload().data(), buffer);
+    ASSERT_TRUE(queue.AddTransaction(std::move(tx)));
+
+    auto all = queue.FetchAll();
+    ASSERT_EQ(all.size(), (size_t)1);
+    EXPECT_EQ(all[0].GetPayload().data(), buffer);
+
+    rxrevoltchain::core::PrivacyManager privacy;
+    std::vector<uint8_t> clean = {'n', 'o', ' ', 'p', 'i', 'i'};
+    const uint8_t* cleanBuffer = clean.data();
+    EXPECT_FALSE(privacy.RedactPII(clean));
+    EXPECT_EQ(clean.data(), cleanBuffer);
+    EXPECT_TRUE(privacy.RedactPII(all[0].MutablePayload()));
+    std::string redacted(all[0].GetPayload().begin(), all[0].GetPayload().end());
+    EXPECT_EQ(redacted, "patient ssn [REDACTED] on file");
+    EXPECT_TRUE(privacy.IsSuspicious({'a', 'V', 'i', 'R', 'u', 's'}));
+    EXPECT_FALSE(privacy.IsSuspicious(clean));
+    std::remove(file.c_str());
+}
+
+// The single-pass scanner matches the old regex rules for SSNs and phone numbers on
+// every backend, and recognizes the newer patterns and keywords
+TEST(PrivacyManagerTest, SinglePassScanner) {
+    namespace pii = rxrevoltchain::util::pii;
+    rxrevoltchain::core::PrivacyManager privacy;
+    auto redact = [&privacy](const std::string& text) {
+        std::vector<uint8_t> data(text.begin(), text.end());
+        privacy.RedactPII(data);
+        return std::string(data.begin(), data.end());
+    };
+    // Reference: the regexes RedactPII used to apply, one after the other
+    auto reference = [](const std::string& text) {
+        static const std::regex ssn(R"((\b\d{3}-\d{2}-\d{4}\b))");
+        static const std::regex phone(R"((\(\d{3}\)\s?\d{3}-\d{4}|\b\d{3}-\d{3}-\d{4}\b))");
+        return std::regex_replace(std::regex_replace(text, ssn, "[REDACTED]"), phone,
+                                  "[REDACTED]");
+    };
+    const pii::Backend previous = pii::backend();
+    for (auto backend : {pii::Backend::Scalar, pii::Backend::Avx2}) {
+        if (!pii::setBackend(backend))
+            continue;
+        EXPECT_EQ(redact("ssn 123-45-6789, tel (555) 123-4567 or 555-123-4567."),
+                  "ssn [REDACTED], tel [REDACTED] or [REDACTED].");
+        EXPECT_EQ(redact("id a123-45-6789 and 123-45-67890 stay"),
+                  "id a123-45-6789 and 123-45-67890 stay");
+        EXPECT_EQ(redact("mail Jane.Doe+rx@mail.example.org now"), "mail [REDACTED] now");
+        EXPECT_EQ(redact("a@b.co"), "[REDACTED]"); // grows in place
+        EXPECT_EQ(redact("user@localhost 1@2.34"), "user@localhost 1@2.34");
+        EXPECT_EQ(redact("card 4111 1111 1111 1111 exp"), "card [REDACTED] exp");
+        EXPECT_EQ(redact("card 4111-1111-1111-1112 x"), "card 4111-1111-1111-1112 x");
+        EXPECT_EQ(redact("ts 1700000000000"), "ts 1700000000000"); // not a card prefix
+
+        // Keywords anywhere, including across the vector step boundary and at the very end
+        for (size_t at = 0; at + 5 <= 80; ++at) {
+            std::string doc(80, 'v');
+            doc.replace(at, 5, "ViRuS");
+            std::vector<uint8_t> bytes(doc.begin(), doc.end());
+            EXPECT_TRUE(privacy.IsSuspicious(bytes)) << at;
+            EXPECT_TRUE(privacy.Scan(bytes).suspicious) << at;
+        }
+        std::vector<uint8_t> clean(100, 'm');
+        EXPECT_FALSE(privacy.IsSuspicious(clean));
+
+        // Randomized equivalence with the regexes on digit-heavy text
+        privacy.SetPatterns(pii::Ssn | pii::Phone);
+        std::mt19937 rng(7);
+        const std::string alphabet = "0123456789012345678901234567890123456789--() x";
+        for (int round = 0; round < 3000; ++round) {
+            std::string sample(1 + rng() % 90, ' ');
+            for (char& c : sample)
+                c = alphabet[rng() % alphabet.size()];
+            ASSERT_EQ(redact(sample), reference(sample)) << sample;
+        }
+        privacy.SetPatterns(pii::AllPatterns);
+    }
+    pii::setBackend(previous);
+
+    // Scan() redacts and reports keywords in the same pass
+    std::string doc = "malware sample from 555-123-4567";
+    std::vector<uint8_t> bytes(doc.begin(), doc.end());
+    const auto report = privacy.Scan(bytes);
+    EXPECT_TRUE(report.suspicious);
+    EXPECT_EQ(report.redactions, (size_t)1);
+    EXPECT_EQ(std::string(bytes.begin(), bytes.end()), "malware sample from [REDACTED]");
+}
+
 // Basic test: DocumentQueue
 TEST(DocumentQueueTest, AddAndFetch) {
     const std::string file = "test_queue.wal";
@@ -118,6 +246,120 @@ TEST(DocumentQueueTest, PersistReload) {
     std::remove(file.c_str());
 }
 
+TEST(DocumentQueueTest, WalGroupCommitTornTailAndMigration) {
+    const std::string file = "test_queue_wal.wal";
+    std::remove(file.c_str());
+
+    // Concurrent producers share group commits; every acknowledged record survives
+    {
+        rxrevoltchain::core::DocumentQueue q(file);
+        std::vector<std::thread> producers;
+        std::atomic<int> failures{0};
+        for (int t = 0; t < 4; ++t) {
+            producers.emplace_back([&, t] {
+                for (int i = 0; i < 50; ++i) {
+                    auto tx = makeTransaction("document_submission",
+                                              std::to_string(t) + ":" + std::to_string(i),
+                                              {static_cast<uint8_t>(i)});
+                    if (!q.AddTransaction(tx)) {
+                        ++failures;
+                    }
+                }
+            });
+        }
+        for (auto& th : producers) {
+            th.join();
+        }
+        EXPECT_EQ(failures.load(), 0);
+    }
+
+    // Simulate a crash mid-write: a record header promising more bytes than exist
+    {
+        FILE* f = std::fopen(file.c_str(), "ab");
+        ASSERT_NE(f, nullptr);
+        const uint8_t torn[] = {100, 0, 0, 0, 0xde, 0xad, 0xbe, 0xef, 'p', 'a', 'r'};
+        std::fwrite(torn, 1, sizeof(torn), f);
+        std::fclose(f);
+    }
+    {
+        rxrevoltchain::core::DocumentQueue q(file);
+        // The torn tail was truncated, so new appends follow valid data
+        ASSERT_TRUE(q.AddTransaction(makeTransaction("document_submission", "after", {0x02})));
+    }
+    {
+        rxrevoltchain::core::DocumentQueue q(file);
+        auto all = q.FetchAll();
+        ASSERT_EQ(all.size(), (size_t)201);
+        EXPECT_EQ(all.back().GetMetadata(), "after");
+    }
+
+    // A file in the pre-WAL format is read and rewritten with the WAL header
+    {
+        std::ofstream out(file, std::ios::binary | std::ios::trunc);
+        auto writeField = [&](const std::string& s) {
+            uint32_t len = static_cast<uint32_t>(s.size());
+            out.write(reinterpret_cast<const char*>(&len), sizeof(len));
+            out.write(s.data(), len);
+        };
+        writeField("document_submission");
+        writeField("legacy");
+        writeField("");
+        writeField("x");
+    }
+    EXPECT_TRUE(rxrevoltchain::core::WriteAheadLog::IsLegacyFile(file));
+    {
+        rxrevoltchain::core::DocumentQueue q(file);
+        EXPECT_FALSE(q.IsEmpty());
+    }
+    EXPECT_FALSE(rxrevoltchain::core::WriteAheadLog::IsLegacyFile(file));
+    rxrevoltchain::core::DocumentQueue migrated(file);
+    auto all = migrated.FetchAll();
+    ASSERT_EQ(all.size(), (size_t)1);
+    EXPECT_EQ(all[0].GetMetadata(), "legacy");
+    EXPECT_EQ(all[0].GetPayload(), std::vector<uint8_t>({'x'}));
+    std::remove(file.c_str());
+}
+
+// A header torn by a crash restarts the log instead of passing for the legacy format;
+// interval-synced appends replay after Sync() and reopen
+TEST(WriteAheadLogTest, TornHeaderAndIntervalSync) {
+    using rxrevoltchain::core::WriteAheadLog;
+    const std::string file = "test_wal_header.wal";
+    auto writeRaw = [&](const std::string& bytes) {
+        std::ofstream out(file, std::ios::binary | std::ios::trunc);
+        out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    };
+    std::vector<std::vector<uint8_t>> records;
+
+    writeRaw(std::string("RXW", 3));
+    EXPECT_FALSE(WriteAheadLog::IsLegacyFile(file));
+    WriteAheadLog::Options options;
+    options.policy = WriteAheadLog::FsyncPolicy::IntervalMs;
+    options.fsyncIntervalMs = 1;
+    {
+        WriteAheadLog wal(options);
+        ASSERT_TRUE(wal.Open(file, records));
+        EXPECT_TRUE(records.empty());
+        for (uint8_t i = 0; i < 20; ++i) {
+            ASSERT_TRUE(wal.Append({i, i}));
+        }
+        EXPECT_TRUE(wal.Sync());
+    }
+    {
+        WriteAheadLog wal(options);
+        ASSERT_TRUE(wal.Open(file, records));
+        ASSERT_EQ(records.size(), (size_t)20);
+        EXPECT_EQ(records.back(), std::vector<uint8_t>({19, 19}));
+    }
+
+    // Short bytes that are not a prefix of the magic are corrupt, not legacy
+    writeRaw("junk");
+    EXPECT_FALSE(WriteAheadLog::IsLegacyFile(file));
+    WriteAheadLog wal;
+    EXPECT_FALSE(wal.Open(file, records));
+    std::remove(file.c_str());
+}
+
 // This test simulates P2P communication without opening real sockets. Starting
 // network listeners may fail in restricted environments, so we call
 // `OnMessageReceived` directly to verify message handling.
@@ -138,6 +380,333 @@ TEST(P2PNodeTest, MultiNodeCommunication) {
     EXPECT_EQ(messages[0].payload.size(), (size_t)2);
 }
 
+// Many peers are served by the fixed set of I/O threads, and frames are reassembled no
+// matter how TCP splits or coalesces them
+TEST(P2PNodeTest, ReactorManyPeersFixedThreads) {
+    auto threadCount = [] {
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while (std::getline(status, line)) {
+            if (line.rfind("Threads:", 0) == 0) {
+                return std::stoi(line.substr(8));
+            }
+        }
+        return -1;
+    };
+    auto waitFor = [](const std::function<bool()>& done) {
+        for (int i = 0; i < 500 && !done(); ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return done();
+    };
+    auto frame = [](const std::string& type, const std::string& payload) {
+        std::vector<uint8_t> out;
+        for (const std::string* field : {&type, &payload}) {
+            uint32_t len = htonl(static_cast<uint32_t>(field->size()));
+            const uint8_t* p = reinterpret_cast<const uint8_t*>(&len);
+            out.insert(out.end(), p, p + 4);
+            out.insert(out.end(), field->begin(), field->end());
+        }
+        return out;
+    };
+    const uint16_t port = 39411;
+    auto connectRaw = [port]() {
+        int sock = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+        if (::connect(sock, (sockaddr*)&addr, sizeof(addr)) < 0) {
+            ::close(sock);
+            return -1;
+        }
+        return sock;
+    };
+
+    rxrevoltchain::network::P2PNode node;
+    node.SetIoThreads(2);
+    if (!node.StartNetwork("127.0.0.1", port)) {
+        GTEST_SKIP() << "cannot listen on 127.0.0.1:" << port;
+    }
+    const int threadsBefore = threadCount();
+
+    const int kPeers = 100;
+    std::vector<int> clients;
+    for (int i = 0; i < kPeers; ++i) {
+        int sock = connectRaw();
+        ASSERT_GE(sock, 0);
+        clients.push_back(sock);
+        auto bytes = frame("PEER_HELLO", std::to_string(i));
+        ASSERT_EQ(::send(sock, bytes.data(), bytes.size(), 0), (ssize_t)bytes.size());
+    }
+    // One frame trickled in byte by byte, then two frames in a single send
+    auto split = frame("SNAPSHOT_ANNOUNCE", "QmSplit");
+    for (uint8_t b : split) {
+        ASSERT_EQ(::send(clients[0], &b, 1, 0), 1);
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    auto packed = frame("POP_REQUEST", "a");
+    auto second = frame("POP_RESPONSE", std::string(100000, 'z'));
+    packed.insert(packed.end(), second.begin(), second.end());
+    ASSERT_EQ(::send(clients[1], packed.data(), packed.size(), 0), (ssize_t)packed.size());
+
+    EXPECT_TRUE(waitFor([&] { return node.GetMessages().size() == kPeers + 3; }));
+    EXPECT_EQ(node.PeerCount(), (size_t)kPeers);
+    EXPECT_EQ(threadCount(), threadsBefore); // no thread per peer
+    size_t hellos = 0;
+    bool sawSplit = false, sawLarge = false;
+    for (const auto& msg : node.GetMessages()) {
+        hellos += msg.type == "PEER_HELLO";
+        sawSplit |= msg.type == "SNAPSHOT_ANNOUNCE" &&
+                    std::string(msg.payload.begin(), msg.payload.end()) == "QmSplit";
+        sawLarge |= msg.type == "POP_RESPONSE" && msg.payload.size() == 100000;
+    }
+    EXPECT_EQ(hellos, (size_t)kPeers);
+    EXPECT_TRUE(sawSplit);
+    EXPECT_TRUE(sawLarge);
+
+    // Broadcasts still reach raw peers with the unchanged framing
+    rxrevoltchain::network::ProtocolMessage out;
+    out.type = "SNAPSHOT_ANNOUNCE";
+    out.payload = {'c', 'i', 'd'};
+    ASSERT_TRUE(node.BroadcastMessage(out));
+    auto expected = frame("SNAPSHOT_ANNOUNCE", "cid");
+    std::vector<uint8_t> got(expected.size());
+    ASSERT_EQ(::recv(clients[5], got.data(), got.size(), MSG_WAITALL), (ssize_t)got.size());
+    EXPECT_EQ(got, expected);
+
+    // Closed and misbehaving peers are dropped
+    ::close(clients[2]);
+    auto bogus = frame(std::string(2000, 't'), "");
+    ::send(clients[3], bogus.data(), bogus.size(), 0);
+    EXPECT_TRUE(waitFor([&] { return node.PeerCount() == kPeers - 2; }));
+
+    // Inbound connection limit
+    node.SetMaxConnections(kPeers - 2);
+    int rejected = connectRaw();
+    ASSERT_GE(rejected, 0);
+    char byte;
+    EXPECT_EQ(::recv(rejected, &byte, 1, 0), 0);
+    ::close(rejected);
+
+    for (int sock : clients) {
+        ::close(sock);
+    }
+    EXPECT_TRUE(node.StopNetwork());
+    EXPECT_EQ(node.PeerCount(), (size_t)0);
+}
+
+// A peer that stops reading is disconnected once it stays over the queue limit, while
+// bursts above the limit reach a peer that keeps reading and never block the caller
+TEST(P2PNodeTest, SlowPeerBackpressure) {
+    const uint16_t port = 39412;
+    rxrevoltchain::network::P2PNode node;
+    node.SetMaxPeerQueueBytes(256 * 1024);
+    node.SetSlowPeerGrace(std::chrono::milliseconds(200));
+    if (!node.StartNetwork("127.0.0.1", port)) {
+        GTEST_SKIP() << "cannot listen on 127.0.0.1:" << port;
+    }
+    auto connectRaw = [port](int rcvbuf) {
+        int sock = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (rcvbuf > 0) {
+            setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+        }
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+        EXPECT_EQ(::connect(sock, (sockaddr*)&addr, sizeof(addr)), 0);
+        return sock;
+    };
+    int stalled = connectRaw(4096); // never reads
+    int fast = connectRaw(0);
+    std::atomic<size_t> received{0};
+    std::thread reader([&] {
+        std::vector<char> buf(1 << 16);
+        ssize_t n;
+        while ((n = ::recv(fast, buf.data(), buf.size(), 0)) > 0) {
+            received += static_cast<size_t>(n);
+        }
+    });
+    for (int i = 0; i < 200 && node.PeerCount() < 2; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT_EQ(node.PeerCount(), (size_t)2);
+
+    rxrevoltchain::network::ProtocolMessage msg;
+    msg.type = "POP_RESPONSE";
+    msg.payload.assign(64 * 1024, 0xAB);
+    const size_t frameSize = 8 + msg.type.size() + msg.payload.size();
+    // Bursts of 512 KiB: over the soft limit, under the hard one. The fast peer drains
+    // each burst before the next, so it is never over the limit when a frame is queued
+    const int kBursts = 25;
+    const int kBurst = 8;
+    std::chrono::steady_clock::duration broadcasting{};
+    for (int burst = 1; burst <= kBursts; ++burst) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < kBurst; ++i) {
+            EXPECT_TRUE(node.BroadcastMessage(msg));
+        }
+        broadcasting += std::chrono::steady_clock::now() - start;
+        for (int i = 0; i < 500 && received.load() < burst * kBurst * frameSize; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        ASSERT_EQ(received.load(), burst * kBurst * frameSize);
+    }
+    EXPECT_LT(broadcasting, std::chrono::seconds(2)); // the stalled peer never blocks the caller
+    EXPECT_EQ(node.SlowPeerCount(), (uint64_t)1);
+    EXPECT_EQ(node.PeerCount(), (size_t)1);
+
+    EXPECT_TRUE(node.StopNetwork());
+    reader.join();
+    ::close(fast);
+    ::close(stalled);
+}
+
+// Snapshot sync: interrupted fetch resumes, bad manifests/chunks from one peer are rejected
+TEST(SnapshotSyncTest, ResumableMultiPeerFetch) {
+    using namespace rxrevoltchain::network;
+    const std::string source = "sync_source.sqlite";
+    const std::string dest = "sync_dest.sqlite";
+    std::vector<uint8_t> content(256 * 4096 + 100); // short last chunk
+    for (size_t i = 0; i < content.size(); ++i) {
+        content[i] = static_cast<uint8_t>((i * 2654435761u) >> 13);
+    }
+    {
+        std::ofstream out(source, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(content.data()), content.size());
+    }
+    std::remove(dest.c_str());
+    std::remove((dest + ".part").c_str());
+    std::remove((dest + ".sync").c_str());
+    const uint32_t chunks = 257;
+
+    // Honest server; while 'stall' is set it ignores requests from chunk 128 on
+    P2PNode serverNode;
+    SnapshotSync server(
+        [&](uint64_t peer, const ProtocolMessage& m) { return serverNode.SendToPeer(peer, m); });
+    server.SetServedFile(source);
+    std::atomic<bool> stall{true};
+    serverNode.SetMessageCallback([&](const ProtocolMessage& msg) {
+        SnapshotChunkRequest req;
+        if (stall && msg.type == SNAPSHOT_CHUNK_REQUEST && req.Decode(msg.payload) &&
+            req.firstChunk >= 128) {
+            return;
+        }
+        server.HandleMessage(msg);
+    });
+
+    // Lying server: claims every root, serves zero leaves and zero chunks. With 'inflate'
+    // set it announces far more leaves than its file size needs (1) or a 1 TiB file (2)
+    P2PNode liarNode;
+    std::atomic<int> inflate{0};
+    std::atomic<int> manifestRequests{0};
+    liarNode.SetMessageCallback([&](const ProtocolMessage& msg) {
+        ProtocolMessage reply;
+        if (msg.type == SNAPSHOT_MANIFEST_REQUEST) {
+            ++manifestRequests;
+            SnapshotManifestRequest req;
+            req.Decode(msg.payload);
+            SnapshotManifest m;
+            m.root = req.root;
+            m.format = 1;
+            m.chunkSize = 4096;
+            m.fileSize = inflate == 2 ? uint64_t(1) << 40 : content.size();
+            m.totalLeaves = inflate == 0 ? chunks : inflate == 1 ? 0xFFFFFFF0u : 1u << 28;
+            m.firstLeaf = req.firstLeaf;
+            m.leaves.assign(size_t(std::min(req.maxLeaves, chunks)) * 32, 0);
+            reply.type = SNAPSHOT_MANIFEST;
+            reply.payload = m.Encode();
+        } else if (msg.type == SNAPSHOT_CHUNK_REQUEST) {
+            SnapshotChunkRequest req;
+            req.Decode(msg.payload);
+            SnapshotChunkResponse r;
+            r.root = req.root;
+            r.firstChunk = req.firstChunk;
+            r.count = req.count;
+            r.data.assign(size_t(req.count) * 4096, 0);
+            reply.type = SNAPSHOT_CHUNK_RESPONSE;
+            reply.payload = r.Encode();
+        } else {
+            return;
+        }
+        liarNode.SendToPeer(msg.peerId, reply);
+    });
+
+    P2PNode clientNode;
+    SnapshotSync client(
+        [&](uint64_t peer, const ProtocolMessage& m) { return clientNode.SendToPeer(peer, m); });
+    clientNode.SetMessageCallback([&](const ProtocolMessage& msg) { client.HandleMessage(msg); });
+    if (!serverNode.StartNetwork("127.0.0.1", 39413) ||
+        !liarNode.StartNetwork("127.0.0.1", 39414) ||
+        !clientNode.StartNetwork("127.0.0.1", 39415)) {
+        GTEST_SKIP() << "cannot listen on 127.0.0.1:39413-39415";
+    }
+    ASSERT_TRUE(clientNode.ConnectToPeer("127.0.0.1", 39413));
+    ASSERT_TRUE(clientNode.ConnectToPeer("127.0.0.1", 39414));
+    const std::vector<uint64_t> ids = clientNode.PeerIds();
+    ASSERT_EQ(ids.size(), (size_t)2);
+    const uint64_t honest = ids[0], liar = ids[1];
+    SnapshotSync::Options opts;
+    opts.rangeChunks = 16;
+    opts.windowPerPeer = 2;
+    client.SetOptions(opts);
+
+    // 0) Without an expected root nothing is fetched. The liar echoes whatever root it is
+    //    asked for, so it never backs one; the honest peer alone is no quorum of two
+    EXPECT_FALSE(client.Fetch({honest}, "", dest));
+    EXPECT_EQ(client.AgreedRoot({liar, honest}, 2), "");
+    const std::string agreed = client.AgreedRoot({liar, honest}, 1);
+    EXPECT_EQ(agreed, server.ServedRoot());
+
+    // 1) Bootstrap (the agreed root) from the honest peer; interrupted halfway
+    std::string root;
+    bool ok = true;
+    std::thread fetch([&] { ok = client.Fetch({honest}, agreed, dest, &root); });
+    for (int i = 0; i < 500 && client.VerifiedChunks() < 128; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(client.VerifiedChunks(), (uint64_t)128);
+    client.Cancel();
+    fetch.join();
+    EXPECT_FALSE(ok);
+    EXPECT_TRUE(std::ifstream(dest + ".sync").good());
+
+    // 2) Resume from both peers; the liar's manifest and chunks must be rejected
+    stall = false;
+    const std::string expectedRoot = server.ServedRoot();
+    ASSERT_FALSE(expectedRoot.empty());
+    ASSERT_TRUE(client.Fetch({liar, honest}, expectedRoot, dest, &root));
+    EXPECT_EQ(root, expectedRoot);
+    auto stats = client.LastStats();
+    EXPECT_EQ(stats.resumedChunks, (uint64_t)128);
+    EXPECT_EQ(stats.fetchedChunks, (uint64_t)(chunks - 128));
+    EXPECT_GT(stats.rejectedChunks, (uint64_t)0);
+
+    std::ifstream in(dest, std::ios::binary);
+    std::vector<uint8_t> copy((std::istreambuf_iterator<char>(in)),
+                              std::istreambuf_iterator<char>());
+    EXPECT_TRUE(copy == content);
+    EXPECT_FALSE(std::ifstream(dest + ".sync").good());
+    EXPECT_FALSE(std::ifstream(dest + ".part").good());
+
+    // 3) Inflated manifests are refused on their first page, before any allocation
+    for (int mode : {1, 2}) {
+        inflate = mode;
+        manifestRequests = 0;
+        EXPECT_FALSE(client.Fetch({liar}, expectedRoot, "sync_bogus.sqlite"));
+        EXPECT_EQ(manifestRequests.load(), 1);
+        EXPECT_FALSE(std::ifstream("sync_bogus.sqlite.part").good());
+    }
+
+    clientNode.StopNetwork();
+    liarNode.StopNetwork();
+    serverNode.StopNetwork();
+    std::remove(source.c_str());
+    std::remove((source + ".merkle").c_str());
+    std::remove(dest.c_str());
+}
+
 // Test: PinnerNode + DailyScheduler integration
 TEST(PinnerNodeTest, NodeLifecycle) {
     rxrevoltchain::pinner::PinnerNode node;
@@ -163,6 +732,120 @@ TEST(DailySchedulerTest, StartStop) {
     EXPECT_TRUE(sched.StopScheduling());
 }
 
+// secp256k1 key pair for the signature tests; 'publicKey' is the uncompressed point
+EVP_PKEY* makeSigningKey(std::vector<uint8_t>& publicKey) {
+    EVP_PKEY* key = EVP_EC_gen("secp256k1");
+    unsigned char* der = nullptr;
+    const int len = key ? i2d_PUBKEY(key, &der) : 0;
+    publicKey.assign(der + len - 65, der + len); // the SPKI ends with the point
+    OPENSSL_free(der);
+    return key;
+}
+
+rxrevoltchain::core::Transaction makeSignedTransaction(EVP_PKEY* key,
+                                                       const std::vector<uint8_t>& publicKey,
+                                                       const std::vector<uint8_t>& payload) {
+    auto tx = makeTransaction("document_submission",
+                              "{\"public_key\":\"" +
+                                  rxrevoltchain::util::hashing::toHex(publicKey.data(),
+                                                                      publicKey.size()) +
+                                  "\"}",
+                              payload);
+    EVP_MD_CTX* ctx = EVP_MD_CTX_new();
+    size_t len = 0;
+    std::vector<uint8_t> signature;
+    if (EVP_DigestSignInit(ctx, nullptr, EVP_sha256(), nullptr, key) == 1 &&
+        EVP_DigestSign(ctx, nullptr, &len, payload.data(), payload.size()) == 1) {
+        signature.resize(len);
+        EVP_DigestSign(ctx, signature.data(), &len, payload.data(), payload.size());
+        signature.resize(len);
+    }
+    EVP_MD_CTX_free(ctx);
+    tx.SetSignature(std::move(signature));
+    return tx;
+}
+
+// Cached keys and per-thread contexts give the same verdicts as the one-shot path, and
+// merges drop forged submissions before they are stored
+TEST(SignatureVerifierTest, BatchVerificationAndMerge) {
+    std::vector<std::vector<uint8_t>> publicKeys(3);
+    std::vector<EVP_PKEY*> keys;
+    for (auto& pub : publicKeys) {
+        keys.push_back(makeSigningKey(pub));
+        ASSERT_NE(keys.back(), nullptr);
+        ASSERT_EQ(pub.size(), (size_t)65);
+        ASSERT_EQ(pub[0], 0x04);
+    }
+
+    std::vector<rxrevoltchain::core::Transaction> batch;
+    std::vector<char> expected;
+    for (int i = 0; i < 300; ++i) {
+        const size_t k = i % keys.size();
+        auto tx = makeSignedTransaction(keys[k], publicKeys[k], {uint8_t(i), uint8_t(i >> 8)});
+        bool valid = true;
+        if (i % 7 == 3) {
+            tx.MutablePayload()[0] ^= 0x01; // tampered after signing
+            valid = false;
+        } else if (i % 11 == 5) {
+            tx.SetMetadata("not json"); // no key named
+            valid = false;
+        } else if (i % 13 == 6) {
+            tx.SetMetadata("{\"public_key\":\"04" + std::string(128, 'f') + "\"}"); // off-curve
+            valid = false;
+        } else if (i % 17 == 8) {
+            const std::vector<uint8_t>& other = publicKeys[(k + 1) % keys.size()];
+            tx.SetMetadata("{\"public_key\":\"" +
+                           rxrevoltchain::util::hashing::toHex(other.data(), other.size()) +
+                           "\"}"); // someone else's key
+            valid = false;
+        }
+        if (valid) {
+            EXPECT_TRUE(tx.VerifySignature(publicKeys[k])) << i;
+        }
+        batch.push_back(std::move(tx));
+        expected.push_back(valid ? 1 : 0);
+    }
+    batch.push_back(makeTransaction("removal_request", "", {})); // not a submission
+    expected.push_back(1);
+
+    rxrevoltchain::core::SignatureVerifier verifier;
+    EXPECT_EQ(verifier.VerifyBatch(batch), expected);
+    EXPECT_EQ(verifier.VerifyBatch(batch), expected); // second pass, all keys cached
+    EXPECT_EQ(verifier.CachedKeys(), keys.size() + 1); // + the off-curve point
+    EXPECT_FALSE(batch[0].VerifySignature(std::vector<uint8_t>(65, 0x04)));
+
+    const std::string wal = "sig_merge.wal";
+    const std::string db = "sig_merge.sqlite";
+    std::remove(wal.c_str());
+    std::remove(db.c_str());
+    {
+        rxrevoltchain::core::DocumentQueue queue(wal);
+        for (size_t i = 0; i < 40; ++i) {
+            queue.AddTransaction(batch[i]);
+        }
+        rxrevoltchain::core::DailySnapshot snapshot(db);
+        snapshot.SetDocumentQueue(&queue);
+        snapshot.SetSignatureVerifier(&verifier);
+        snapshot.SetMergeChunkSize(8);
+        ASSERT_TRUE(snapshot.MergePendingDocuments());
+        snapshot.CloseDatabase();
+    }
+    sqlite3* sdb = nullptr;
+    ASSERT_EQ(sqlite3_open(db.c_str(), &sdb), SQLITE_OK);
+    sqlite3_stmt* stmt = nullptr;
+    sqlite3_prepare_v2(sdb, "SELECT COUNT(*) FROM documents", -1, &stmt, nullptr);
+    ASSERT_EQ(sqlite3_step(stmt), SQLITE_ROW);
+    EXPECT_EQ(sqlite3_column_int(stmt, 0), std::count(expected.begin(), expected.begin() + 40, 1));
+    sqlite3_finalize(stmt);
+    sqlite3_close(sdb);
+
+    for (EVP_PKEY* key : keys) {
+        EVP_PKEY_free(key);
+    }
+    std::remove(wal.c_str());
+    std::remove(db.c_str());
+}
+
 // Ensure that DailySnapshot integrates PrivacyManager and strips PII
 TEST(DailySnapshotTest, PrivacyRedaction) {
     const std::string wal = "snap_privacy.wal";
@@ -248,6 +931,401 @@ TEST(DailySnapshotTest, RemovalRequest) {
     std::remove(db.c_str());
 }
 
+// Chunked merges over one persistent WAL-mode connection, checkpointed after each merge
+TEST(DailySnapshotTest, ChunkedIncrementalMerge) {
+    const std::string wal = "snap_chunked.wal";
+    const std::string db = "snap_chunked.sqlite";
+    std::remove(wal.c_str());
+    std::remove(db.c_str());
+
+    auto countRows = [&db]() {
+        sqlite3* sdb = nullptr;
+        EXPECT_EQ(sqlite3_open_v2(db.c_str(), &sdb, SQLITE_OPEN_READONLY, nullptr), SQLITE_OK);
+        sqlite3_stmt* stmt = nullptr;
+        sqlite3_prepare_v2(sdb, "SELECT COUNT(*) FROM documents", -1, &stmt, nullptr);
+        int count = (sqlite3_step(stmt) == SQLITE_ROW) ? sqlite3_column_int(stmt, 0) : -1;
+        sqlite3_finalize(stmt);
+        sqlite3_close(sdb);
+        return count;
+    };
+
+    rxrevoltchain::core::DocumentQueue queue(wal);
+    rxrevoltchain::core::DailySnapshot snapshot(db);
+    snapshot.SetDocumentQueue(&queue);
+    snapshot.SetMergeChunkSize(7);
+
+    for (int i = 0; i < 50; ++i) {
+        auto tx = makeTransaction("document_submission", "doc" + std::to_string(i),
+                                  {static_cast<uint8_t>(i)});
+        tx.SetSignature({static_cast<uint8_t>(i)});
+        queue.AddTransaction(std::move(tx));
+    }
+    ASSERT_TRUE(snapshot.MergePendingDocuments());
+    EXPECT_EQ(countRows(), 50);
+
+    // Everything committed is in the main file: the -wal was truncated by the checkpoint
+    struct stat st;
+    if (::stat((db + "-wal").c_str(), &st) == 0) {
+        EXPECT_EQ(st.st_size, 0);
+    }
+
+    // Second cycle on the same connection: more inserts plus a removal
+    for (int i = 50; i < 60; ++i) {
+        queue.AddTransaction(makeTransaction("document_submission", "doc", {0x01}));
+    }
+    auto remTx = makeTransaction("removal_request", "", {});
+    remTx.SetSignature({3});
+    queue.AddTransaction(remTx);
+    ASSERT_TRUE(snapshot.MergePendingDocuments());
+    EXPECT_EQ(countRows(), 59);
+
+    // A merge on the only shared-pool worker not held up prepares its chunks itself
+    auto& pool = rxrevoltchain::util::ThreadPool::getInstance();
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    std::vector<std::future<void>> blockers;
+    for (size_t i = 1; i < pool.size(); ++i) {
+        blockers.push_back(pool.enqueue([released] { released.wait(); }));
+    }
+    for (int i = 0; i < 20; ++i) {
+        queue.AddTransaction(makeTransaction("document_submission", "pooled", {0x03}));
+    }
+    auto merged = pool.enqueue([&snapshot] { return snapshot.MergePendingDocuments(); });
+    EXPECT_EQ(merged.wait_for(std::chrono::seconds(30)), std::future_status::ready);
+    release.set_value();
+    EXPECT_TRUE(merged.get());
+    EXPECT_EQ(countRows(), 79);
+
+    // Removing the file underneath the snapshot makes it reopen a fresh one
+    std::remove(db.c_str());
+    queue.AddTransaction(makeTransaction("document_submission", "fresh", {0x02}));
+    ASSERT_TRUE(snapshot.MergePendingDocuments());
+    EXPECT_EQ(countRows(), 1);
+
+    snapshot.CloseDatabase();
+    std::remove(wal.c_str());
+    std::remove(db.c_str());
+}
+
+// Pre-index snapshots are migrated; removals resolve signature/content-hash targets in bulk
+TEST(DailySnapshotTest, IndexedBatchRemovalAndMigration) {
+    const std::string wal = "snap_index.wal";
+    const std::string db = "snap_index.sqlite";
+    std::remove(wal.c_str());
+    std::remove(db.c_str());
+
+    // A snapshot in the original schema: no content_hash column, no indexes
+    const std::vector<std::string> bodies = {"alpha bill", "beta bill", "gamma bill"};
+    {
+        sqlite3* sdb = nullptr;
+        ASSERT_EQ(sqlite3_open(db.c_str(), &sdb), SQLITE_OK);
+        ASSERT_EQ(sqlite3_exec(sdb,
+                               "CREATE TABLE documents (id INTEGER PRIMARY KEY AUTOINCREMENT,"
+                               " signature BLOB, metadata TEXT, payload BLOB,"
+                               " created_at DATETIME DEFAULT CURRENT_TIMESTAMP);",
+                               nullptr, nullptr, nullptr),
+                  SQLITE_OK);
+        sqlite3_stmt* ins = nullptr;
+        sqlite3_prepare_v2(sdb,
+                           "INSERT INTO documents (signature, metadata, payload) VALUES (?,'',?)",
+                           -1, &ins, nullptr);
+        for (size_t i = 0; i < bodies.size(); ++i) {
+            uLongf outSize = compressBound(bodies[i].size());
+            std::vector<uint8_t> comp(outSize);
+            compress2(comp.data(), &outSize, (const Bytef*)bodies[i].data(), bodies[i].size(), 9);
+            uint8_t sig = static_cast<uint8_t>(10 + i);
+            sqlite3_reset(ins);
+            sqlite3_bind_blob(ins, 1, &sig, 1, SQLITE_TRANSIENT);
+            sqlite3_bind_blob(ins, 2, comp.data(), (int)outSize, SQLITE_TRANSIENT);
+            ASSERT_EQ(sqlite3_step(ins), SQLITE_DONE);
+        }
+        sqlite3_finalize(ins);
+        sqlite3_close(sdb);
+    }
+
+    rxrevoltchain::core::DocumentQueue queue(wal);
+    // One request removes "alpha" and "gamma" by content hash
+    std::vector<uint8_t> targets;
+    for (const std::string* body : {&bodies[0], &bodies[2]}) {
+        auto digest = rxrevoltchain::util::hashing::sha256Raw(
+            reinterpret_cast<const uint8_t*>(body->data()), body->size());
+        targets.insert(targets.end(), digest.begin(), digest.end());
+    }
+    auto byHash = makeTransaction("removal_request", "", targets);
+    byHash.SetSignature({});
+    queue.AddTransaction(byHash);
+    // Removal by signature, followed by a resubmission with the same signature
+    auto bySig = makeTransaction("removal_request", "", {});
+    bySig.SetSignature({11});
+    queue.AddTransaction(bySig);
+    auto resubmit = makeTransaction("document_submission", "resubmitted", {'n', 'e', 'w'});
+    resubmit.SetSignature({11});
+    queue.AddTransaction(resubmit);
+
+    rxrevoltchain::core::DailySnapshot snapshot(db);
+    snapshot.SetDocumentQueue(&queue);
+    ASSERT_TRUE(snapshot.MergePendingDocuments());
+    snapshot.CloseDatabase();
+
+    sqlite3* sdb = nullptr;
+    ASSERT_EQ(sqlite3_open(db.c_str(), &sdb), SQLITE_OK);
+    auto scalar = [sdb](const char* sql) {
+        sqlite3_stmt* stmt = nullptr;
+        sqlite3_prepare_v2(sdb, sql, -1, &stmt, nullptr);
+        std::string value;
+        if (sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_text(stmt, 0)) {
+            value = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+        }
+        sqlite3_finalize(stmt);
+        return value;
+    };
+    EXPECT_EQ(scalar("PRAGMA user_version"),
+              std::to_string(rxrevoltchain::core::DailySnapshot::SCHEMA_VERSION));
+    EXPECT_EQ(scalar("SELECT COUNT(*) FROM documents WHERE codec = 0"), "1");
+    EXPECT_EQ(scalar("SELECT COUNT(*) FROM sqlite_master WHERE name IN"
+                     " ('idx_documents_signature','idx_documents_content_hash')"),
+              "2");
+    EXPECT_EQ(scalar("SELECT COUNT(*) FROM documents"), "1");
+    EXPECT_EQ(scalar("SELECT metadata FROM documents"), "resubmitted");
+    EXPECT_EQ(scalar("SELECT COUNT(*) FROM documents WHERE length(content_hash) = 32"), "1");
+    sqlite3_close(sdb);
+
+    std::remove(wal.c_str());
+    std::remove(db.c_str());
+}
+
+// Chunks are compressed in parallel but inserted in queue order; zstd (plain and with a
+// trained dictionary) and zlib rows coexist and are all readable through the query server
+TEST(DailySnapshotTest, ParallelCompressionCodecs) {
+    namespace compression = rxrevoltchain::util::compression;
+    const std::string wal = "snap_codec.wal";
+    const std::string db = "snap_codec.sqlite";
+    std::remove(wal.c_str());
+    std::remove(db.c_str());
+
+    auto body = [](int i) {
+        std::string s = "{\"provider\":\"General Hospital\",\"procedure\":\"MRI\",\"rows\":[";
+        for (int r = 0; r < 8; ++r) {
+            s += "{\"code\":\"7055" + std::to_string(r) + "\",\"cost\":" +
+                 std::to_string(1000 + i * 7 + r) + "},";
+        }
+        return s + "]}";
+    };
+    rxrevoltchain::core::DocumentQueue queue(wal);
+    rxrevoltchain::core::DailySnapshot snapshot(db);
+    snapshot.SetDocumentQueue(&queue);
+    snapshot.SetMergeChunkSize(16);
+    int next = 0;
+    auto submit = [&](int count) {
+        for (int n = 0; n < count; ++n, ++next) {
+            std::string b = body(next);
+            queue.AddTransaction(makeTransaction("document_submission", std::to_string(next),
+                                                 std::vector<uint8_t>(b.begin(), b.end())));
+        }
+        ASSERT_TRUE(snapshot.MergePendingDocuments());
+    };
+
+    submit(60); // zlib
+    compression::Options zstd;
+    zstd.codec = compression::Codec::Zstd;
+    zstd.level = 3;
+    snapshot.SetCompression(zstd);
+    const bool haveZstd = compression::codecAvailable(compression::Codec::Zstd);
+    EXPECT_EQ(snapshot.GetCompression().codec,
+              haveZstd ? compression::Codec::Zstd : compression::Codec::Zlib);
+    submit(60);
+    EXPECT_EQ(snapshot.TrainCompressionDictionary(120, 4096), haveZstd);
+    submit(60);
+    snapshot.CloseDatabase();
+
+    sqlite3* sdb = nullptr;
+    ASSERT_EQ(sqlite3_open(db.c_str(), &sdb), SQLITE_OK);
+    auto scalar = [sdb](const char* sql) {
+        sqlite3_stmt* stmt = nullptr;
+        sqlite3_prepare_v2(sdb, sql, -1, &stmt, nullptr);
+        std::string value;
+        if (sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_text(stmt, 0)) {
+            value = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+        }
+        sqlite3_finalize(stmt);
+        return value;
+    };
+    // Row order matches queue order across parallel chunks
+    EXPECT_EQ(scalar("SELECT COUNT(*) FROM documents WHERE CAST(metadata AS INTEGER) != id - 1"),
+              "0");
+    EXPECT_EQ(scalar("SELECT COUNT(*) FROM documents WHERE codec = 1"), haveZstd ? "120" : "0");
+    EXPECT_EQ(scalar("SELECT COUNT(*) FROM dictionaries"), haveZstd ? "1" : "0");
+    sqlite3_close(sdb);
+
+    for (int id : {1, 60, 61, 120, 121, 180}) {
+        std::string meta;
+        std::vector<uint8_t> payload;
+        ASSERT_TRUE(rxrevoltchain::network::HttpQueryServer::LoadRecord(db, id, meta, payload))
+            << "record " << id;
+        EXPECT_EQ(meta, std::to_string(id - 1));
+        EXPECT_EQ(std::string(payload.begin(), payload.end()), body(id - 1));
+    }
+
+    // Without the dictionary a dictionary-compressed frame is rejected, not misread
+    if (haveZstd) {
+        std::string b = body(0);
+        compression::Options withDict = snapshot.GetCompression();
+        std::vector<uint8_t> packed, plain;
+        ASSERT_TRUE(compression::compress(withDict, (const uint8_t*)b.data(), b.size(), packed));
+        EXPECT_FALSE(compression::decompress(compression::Codec::Zstd, packed.data(),
+                                             packed.size(), plain, b.size()));
+        ASSERT_TRUE(compression::decompress(compression::Codec::Zstd, packed.data(),
+                                            packed.size(), plain, b.size(),
+                                            withDict.dictionary.get()));
+        EXPECT_EQ(std::string(plain.begin(), plain.end()), b);
+        // A frame whose content exceeds the limit is refused before anything is allocated
+        EXPECT_FALSE(compression::decompress(compression::Codec::Zstd, packed.data(),
+                                             packed.size(), plain, b.size() - 1,
+                                             withDict.dictionary.get()));
+    }
+
+    std::remove(wal.c_str());
+    std::remove(db.c_str());
+}
+
+// decompress stops at the caller's limit instead of trusting the input to bound its size
+TEST(CompressionTest, DecompressHonoursOutputLimit) {
+    namespace compression = rxrevoltchain::util::compression;
+    const std::vector<uint8_t> zeros(8 << 20, 0); // compresses about 1000:1
+    std::vector<uint8_t> packed, plain;
+    ASSERT_TRUE(compression::compress(compression::Options(), zeros.data(), zeros.size(), packed));
+    ASSERT_LT(packed.size(), (size_t)(64 << 10));
+
+    EXPECT_FALSE(compression::decompress(compression::Codec::Zlib, packed.data(), packed.size(),
+                                         plain, 1 << 20));
+    EXPECT_LE(plain.capacity(), (size_t)(2 << 20));
+    EXPECT_FALSE(compression::decompress(compression::Codec::Zlib, packed.data(), packed.size(),
+                                         plain, zeros.size() - 1));
+    ASSERT_TRUE(compression::decompress(compression::Codec::Zlib, packed.data(), packed.size(),
+                                        plain, zeros.size()));
+    EXPECT_EQ(plain, zeros);
+
+    // zstd checks the frame's declared content size against the limit before allocating
+    if (compression::codecAvailable(compression::Codec::Zstd)) {
+        compression::Options zstd;
+        zstd.codec = compression::Codec::Zstd;
+        zstd.level = 3;
+        ASSERT_TRUE(compression::compress(zstd, zeros.data(), zeros.size(), packed));
+        EXPECT_FALSE(compression::decompress(compression::Codec::Zstd, packed.data(),
+                                             packed.size(), plain, zeros.size() - 1));
+        EXPECT_TRUE(plain.empty());
+        ASSERT_TRUE(compression::decompress(compression::Codec::Zstd, packed.data(),
+                                            packed.size(), plain, zeros.size()));
+        EXPECT_EQ(plain, zeros);
+    }
+}
+
+// Delta snapshots: a second pin carries only the changed chunks and rebuilds the file exactly
+TEST(DailySnapshotTest, DeltaSnapshotRoundTrip) {
+    using rxrevoltchain::ipfs_integration::SnapshotDelta;
+    const std::string wal = "snap_delta.wal";
+    const std::string db = "snap_delta.sqlite";
+    const std::string baseCopy = "snap_delta_base.sqlite";
+    const std::string rebuilt = "snap_delta_rebuilt.sqlite";
+    for (const auto& f : {wal, db, baseCopy, rebuilt, SnapshotDelta::BasePathFor(db)}) {
+        std::remove(f.c_str());
+    }
+    auto readAll = [](const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        return std::vector<uint8_t>((std::istreambuf_iterator<char>(in)),
+                                    std::istreambuf_iterator<char>());
+    };
+
+    rxrevoltchain::core::DocumentQueue queue(wal);
+    rxrevoltchain::core::DailySnapshot snapshot(db);
+    snapshot.SetDocumentQueue(&queue);
+    snapshot.SetDeltaMaxChain(2);
+    int next = 0;
+    auto submit = [&](int count) {
+        for (int n = 0; n < count; ++n, ++next) {
+            std::vector<uint8_t> body(600);
+            for (size_t b = 0; b < body.size(); ++b) {
+                body[b] = static_cast<uint8_t>((next * 131 + b * 7919) >> 3);
+            }
+            queue.AddTransaction(
+                makeTransaction("document_submission", "doc" + std::to_string(next), body));
+        }
+        ASSERT_TRUE(snapshot.MergePendingDocuments());
+    };
+
+    // No base yet: the first pin is a full snapshot
+    submit(2000);
+    std::vector<uint8_t> delta;
+    EXPECT_FALSE(snapshot.PrepareDelta(delta));
+    ASSERT_TRUE(snapshot.RecordPinnedBase("QmFullSnapshot", false));
+    {
+        std::ifstream src(db, std::ios::binary);
+        std::ofstream dst(baseCopy, std::ios::binary);
+        dst << src.rdbuf();
+    }
+
+    // A small day produces a small delta that references the previous CID
+    submit(20);
+    ASSERT_TRUE(snapshot.PrepareDelta(delta));
+    const std::vector<uint8_t> current = readAll(db);
+    SnapshotDelta::Header header;
+    ASSERT_TRUE(SnapshotDelta::ReadHeader(delta, header));
+    EXPECT_EQ(header.baseCid, "QmFullSnapshot");
+    EXPECT_EQ(header.depth, 1u);
+    EXPECT_EQ(header.newSize, current.size());
+    EXPECT_LT(header.changed.size(), current.size() / 4096 / 4);
+    EXPECT_LT(delta.size(), current.size() / 4);
+
+    ASSERT_TRUE(SnapshotDelta::Apply(baseCopy, delta, rebuilt));
+    EXPECT_TRUE(readAll(rebuilt) == current);
+
+    // A corrupted delta or the wrong base is refused
+    std::vector<uint8_t> bad = delta;
+    bad.back() ^= 0x5A;
+    EXPECT_FALSE(SnapshotDelta::Apply(baseCopy, bad, rebuilt + ".bad"));
+    EXPECT_FALSE(SnapshotDelta::Apply(rebuilt, delta, rebuilt + ".bad"));
+
+    // Chunk data is bounded by the changed chunks: a larger declared length is refused
+    // before decoding, and data that inflates past the declared length is cut off
+    size_t body = 0;
+    ASSERT_TRUE(SnapshotDelta::ReadHeader(delta, header, &body));
+    uint64_t rawLen = 0;
+    for (size_t i = 0; i < 8; ++i)
+        rawLen = (rawLen << 8) | delta[body + i];
+    std::vector<uint8_t> lying(delta.begin(), delta.begin() + body);
+    for (int shift = 56; shift >= 0; shift -= 8)
+        lying.push_back(static_cast<uint8_t>((uint64_t(1) << 40) >> shift));
+    lying.insert(lying.end(), delta.begin() + body + 8, delta.end());
+    EXPECT_FALSE(SnapshotDelta::Apply(baseCopy, lying, rebuilt + ".bad"));
+    rxrevoltchain::util::compression::Options codec;
+    codec.codec = static_cast<rxrevoltchain::util::compression::Codec>(header.codec);
+    const std::vector<uint8_t> zeros(rawLen * 64, 0);
+    std::vector<uint8_t> packed;
+    ASSERT_TRUE(rxrevoltchain::util::compression::compress(codec, zeros.data(), zeros.size(),
+                                                           packed));
+    std::vector<uint8_t> bomb(delta.begin(), delta.begin() + body + 8);
+    bomb.insert(bomb.end(), packed.begin(), packed.end());
+    EXPECT_FALSE(SnapshotDelta::Apply(baseCopy, bomb, rebuilt + ".bad"));
+    EXPECT_FALSE(std::filesystem::exists(rebuilt + ".bad"));
+
+    // The chain limit forces a full snapshot again
+    ASSERT_TRUE(snapshot.RecordPinnedBase("QmDelta1", true));
+    submit(5);
+    ASSERT_TRUE(snapshot.PrepareDelta(delta));
+    ASSERT_TRUE(SnapshotDelta::ReadHeader(delta, header));
+    EXPECT_EQ(header.baseCid, "QmDelta1");
+    EXPECT_EQ(header.depth, 2u);
+    ASSERT_TRUE(snapshot.RecordPinnedBase("QmDelta2", true));
+    submit(5);
+    EXPECT_FALSE(snapshot.PrepareDelta(delta));
+
+    snapshot.CloseDatabase();
+    for (const auto& f : {wal, db, baseCopy, rebuilt, SnapshotDelta::BasePathFor(db),
+                          db + ".merkle"}) {
+        std::remove(f.c_str());
+    }
+}
+
 TEST(PoPConsensusTest, MerkleProofFlow) {
     const std::string file = "pop_test.txt";
     {
@@ -273,6 +1351,717 @@ TEST(PoPConsensusTest, MerkleProofFlow) {
     ASSERT_EQ(history[0].passingNodes.size(), (size_t)1);
 
     std::remove(file.c_str());
+    std::remove((file + ".merkle").c_str());
+}
+
+// Responses are collected lock-free from many threads while validation runs, and a
+// round deadline refuses stragglers instead of waiting for them
+TEST(PoPConsensusTest, ConcurrentCollectionAndDeadline) {
+    const std::string file = "pop_concurrent.bin";
+    const std::string other = "pop_concurrent_other.bin";
+    for (const auto& name : {file, other}) {
+        std::ofstream ofs(name, std::ios::binary);
+        for (int i = 0; i < 20000; ++i) {
+            ofs << (name == file ? i : i * 3) << ',';
+        }
+    }
+
+    rxrevoltchain::consensus::PoPConsensus pop;
+    pop.IssueChallenges("cidStale", file);
+    pop.CollectResponse("stale", {1, 2, 3});
+    pop.IssueChallenges("cidConcurrent", file);
+    rxrevoltchain::ipfs_integration::MerkleProof mp;
+    const auto good = mp.GenerateProof(file, pop.GetCurrentOffsets());
+    const auto wrongRoot = mp.GenerateProof(other, {0, 100});
+    auto corrupt = good;
+    corrupt[corrupt.size() / 2] ^= 0x01;
+
+    const int kThreads = 6;
+    const int kPerThread = 40;
+    std::atomic<bool> collecting{true};
+    std::vector<std::thread> nodes;
+    for (int t = 0; t < kThreads; ++t) {
+        nodes.emplace_back([&, t] {
+            for (int i = 0; i < kPerThread; ++i) {
+                const int n = t * kPerThread + i;
+                const auto& data = n % 4 == 0 ? good : n % 4 == 1 ? wrongRoot
+                                                : n % 4 == 2 ? corrupt
+                                                             : good;
+                EXPECT_TRUE(pop.CollectResponse("node" + std::to_string(n), data));
+            }
+        });
+    }
+    // Validation may run while responses keep arriving
+    std::thread validator([&] {
+        while (collecting.load()) {
+            pop.ValidateResponses();
+        }
+    });
+    EXPECT_EQ(pop.WaitForResponses(kThreads * kPerThread), (size_t)(kThreads * kPerThread));
+    for (auto& t : nodes) {
+        t.join();
+    }
+    collecting = false;
+    validator.join();
+
+    EXPECT_TRUE(pop.ValidateResponses());
+    auto passing = pop.GetPassingNodes();
+    EXPECT_EQ(passing.size(), (size_t)(kThreads * kPerThread / 2));
+    for (const auto& node : passing) {
+        const int n = std::stoi(node.substr(4));
+        EXPECT_TRUE(n % 4 == 0 || n % 4 == 3) << node;
+    }
+    auto stats = pop.GetRoundStats();
+    EXPECT_EQ(stats.collected, (size_t)(kThreads * kPerThread));
+    EXPECT_EQ(stats.late, 0u);
+    // Each response is verified once, however often ValidateResponses ran
+    EXPECT_EQ(stats.verified, (size_t)(kThreads * kPerThread));
+
+    // A node's latest response replaces its earlier one
+    pop.CollectResponse("node1", good);
+    pop.CollectResponse("node0", corrupt);
+    ASSERT_TRUE(pop.ValidateResponses());
+    passing = pop.GetPassingNodes();
+    EXPECT_EQ(passing.size(), (size_t)(kThreads * kPerThread / 2));
+    EXPECT_NE(std::find(passing.begin(), passing.end(), "node1"), passing.end());
+    EXPECT_EQ(std::find(passing.begin(), passing.end(), "node0"), passing.end());
+
+    // With a deadline, WaitForResponses gives up on slow nodes and late answers are refused
+    pop.SetRoundTimeout(std::chrono::milliseconds(150));
+    pop.IssueChallenges("cidDeadline", file);
+    const auto proof = mp.GenerateProof(file, pop.GetCurrentOffsets());
+    EXPECT_TRUE(pop.CollectResponse("fast", proof));
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(pop.WaitForResponses(3), 1u);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(2));
+    EXPECT_FALSE(pop.CollectResponse("slow", proof));
+    ASSERT_TRUE(pop.ValidateResponses());
+    passing = pop.GetPassingNodes();
+    ASSERT_EQ(passing.size(), 1u);
+    EXPECT_EQ(passing[0], "fast");
+    EXPECT_EQ(pop.GetRoundStats().late, 1u);
+
+    for (const auto& name : {file, other}) {
+        std::remove(name.c_str());
+        std::remove((name + ".merkle").c_str());
+    }
+}
+
+// Proof generation streams the file in windows; offsets on either side of a window
+// boundary and the partial final chunk must still verify.
+TEST(MerkleProofTest, StreamsAcrossReadWindows) {
+    using rxrevoltchain::ipfs_integration::MerkleProof;
+    const std::string file = "merkle_stream.bin";
+    const size_t chunk = MerkleProof::DEFAULT_CHUNK_SIZE;
+    const size_t total = chunk * (3 * MerkleProof::READ_WINDOW_CHUNKS + 44) + 100;
+    std::vector<uint8_t> contents(total);
+    for (size_t i = 0; i < total; ++i)
+        contents[i] = static_cast<uint8_t>((i * 131) ^ (i >> 12));
+    {
+        std::ofstream ofs(file, std::ios::binary);
+        ofs.write(reinterpret_cast<const char*>(contents.data()), contents.size());
+    }
+
+    const size_t last = total / chunk;
+    std::vector<size_t> offsets = {0, MerkleProof::READ_WINDOW_CHUNKS - 1,
+                                   MerkleProof::READ_WINDOW_CHUNKS, last, last + 1};
+    MerkleProof mp;
+    auto proof = mp.GenerateProof(file, offsets);
+    ASSERT_FALSE(proof.empty());
+    EXPECT_TRUE(mp.VerifyProof(proof));
+
+    // Header: chunkSize, totalChunks, count of in-range offsets (last + 1 is skipped)
+    auto readU32 = [&](size_t pos) {
+        return (uint32_t(proof[pos]) << 24) | (uint32_t(proof[pos + 1]) << 16) |
+               (uint32_t(proof[pos + 2]) << 8) | uint32_t(proof[pos + 3]);
+    };
+    EXPECT_EQ(readU32(0), (uint32_t)chunk);
+    EXPECT_EQ(readU32(4), (uint32_t)(last + 1));
+    EXPECT_EQ(readU32(8), (uint32_t)4);
+
+    // The first entry carries the raw bytes of chunk 0
+    EXPECT_EQ(readU32(12), (uint32_t)0);
+    ASSERT_EQ(readU32(16), (uint32_t)chunk);
+    EXPECT_TRUE(std::equal(contents.begin(), contents.begin() + chunk, proof.begin() + 20));
+
+    // Tampering with chunk data must break verification
+    proof[20] ^= 0xFF;
+    EXPECT_FALSE(mp.VerifyProof(proof));
+
+    // A file ending exactly on a window boundary reports every window and no extra chunk
+    {
+        std::ofstream ofs(file, std::ios::binary | std::ios::trunc);
+        ofs.write(reinterpret_cast<const char*>(contents.data()),
+                  2 * MerkleProof::READ_WINDOW_CHUNKS * chunk);
+    }
+    const size_t edge = 2 * MerkleProof::READ_WINDOW_CHUNKS - 1;
+    proof = mp.GenerateProof(file, {0, edge});
+    ASSERT_FALSE(proof.empty());
+    EXPECT_TRUE(mp.VerifyProof(proof));
+    EXPECT_EQ(readU32(4), (uint32_t)(edge + 1));
+    EXPECT_EQ(readU32(8), (uint32_t)2);
+
+    std::remove(file.c_str());
+}
+
+// The tree cache persists next to the snapshot, serves proofs without rehashing and is
+// invalidated when the CID or the file changes.
+TEST(MerkleTreeCacheTest, PersistAndInvalidate) {
+    using rxrevoltchain::ipfs_integration::MerkleProof;
+    using rxrevoltchain::ipfs_integration::MerkleTreeCache;
+    const std::string file = "merkle_cache.bin";
+    const std::string sidecar = MerkleTreeCache::CachePathFor(file);
+    std::remove(sidecar.c_str());
+    {
+        std::ofstream ofs(file, std::ios::binary);
+        for (int i = 0; i < 5 * 4096 + 17; ++i)
+            ofs.put(static_cast<char>(i % 251));
+    }
+
+    std::vector<size_t> offsets = {0, 2, 5};
+    MerkleProof mp;
+    auto direct = mp.GenerateProof(file, offsets);
+
+    std::string root;
+    {
+        MerkleTreeCache cache;
+        auto tree = cache.GetOrBuild(file, "cidA");
+        ASSERT_TRUE(tree != nullptr);
+        EXPECT_EQ(tree->LeafCount(), (size_t)6);
+        root = tree->root;
+        // Proofs from the cached tree are identical to a freshly built one
+        EXPECT_EQ(cache.GenerateProof(file, "cidA", offsets), direct);
+    }
+    std::ifstream check(sidecar, std::ios::binary);
+    EXPECT_TRUE(check.is_open());
+    check.close();
+
+    // A new cache instance loads the persisted tree for the same CID and file
+    MerkleTreeCache reloaded;
+    auto fromDisk = reloaded.GetOrBuild(file, "cidA");
+    ASSERT_TRUE(fromDisk != nullptr);
+    EXPECT_EQ(fromDisk->root, root);
+    auto proof = reloaded.GenerateProof(file, "cidA", offsets);
+    EXPECT_TRUE(mp.VerifyProof(proof));
+
+    // CIDs must match exactly: a tree built before the pin only answers for its CID once
+    // AdoptCid tags it, and a tagged tree never answers for another CID
+    MerkleTreeCache prePin;
+    std::remove(sidecar.c_str());
+    auto untagged = prePin.GetOrBuildCurrent(file);
+    ASSERT_TRUE(untagged != nullptr);
+    EXPECT_EQ(prePin.GetOrBuild(file, ""), untagged);
+    EXPECT_TRUE(prePin.AdoptCid(file, "cidC"));
+    EXPECT_EQ(prePin.GetOrBuild(file, "cidC"), untagged);
+    EXPECT_EQ(prePin.GetOrBuildCurrent(file), untagged);
+    EXPECT_NE(MerkleTreeCache().GetOrBuild(file, "cidC"), nullptr); // tagged sidecar
+    auto other = prePin.GetOrBuild(file, "cidA");
+    ASSERT_TRUE(other != nullptr);
+    EXPECT_NE(other, untagged);
+    EXPECT_EQ(other->root, untagged->root);
+
+    // Appending to the snapshot changes its fingerprint and forces a rebuild
+    {
+        std::ofstream ofs(file, std::ios::binary | std::ios::app);
+        ofs << "more data";
+    }
+    auto rebuilt = reloaded.GetOrBuild(file, "cidB");
+    ASSERT_TRUE(rebuilt != nullptr);
+    EXPECT_NE(rebuilt->root, root);
+    EXPECT_TRUE(mp.VerifyProof(reloaded.GenerateProof(file, "cidB", offsets)));
+
+    std::remove(file.c_str());
+    std::remove(sidecar.c_str());
+}
+
+// Concurrent lookups of one file share a single build, per-format trees coexist, and
+// two caches writing the same sidecar at once never leave a torn or temporary file
+TEST(MerkleTreeCacheTest, ConcurrentBuildsAndSharedSidecar) {
+    using rxrevoltchain::ipfs_integration::MerkleFormat;
+    using rxrevoltchain::ipfs_integration::MerkleTree;
+    using rxrevoltchain::ipfs_integration::MerkleTreeCache;
+    const std::string file = "merkle_shared.bin";
+    const std::string sidecar = MerkleTreeCache::CachePathFor(file);
+    std::remove(sidecar.c_str());
+    {
+        std::ofstream ofs(file, std::ios::binary);
+        for (int i = 0; i < 64 * 4096 + 5; ++i)
+            ofs.put(static_cast<char>(i * 31 % 241));
+    }
+
+    MerkleTreeCache shared, other;
+    std::vector<std::shared_ptr<const MerkleTree>> trees(4), others(4);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < trees.size(); ++t) {
+        threads.emplace_back([&, t] { trees[t] = shared.GetOrBuild(file, ""); });
+        threads.emplace_back([&, t] { others[t] = other.GetOrBuild(file, ""); });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+    for (size_t t = 0; t < trees.size(); ++t) {
+        ASSERT_TRUE(trees[t] != nullptr && others[t] != nullptr);
+        EXPECT_EQ(trees[t], trees[0]); // one build, handed to every waiter
+        EXPECT_EQ(others[t]->root, trees[0]->root);
+    }
+
+    // A second format does not evict the first
+    auto binary = shared.GetOrBuild(file, "", MerkleFormat::Binary);
+    ASSERT_TRUE(binary != nullptr);
+    EXPECT_EQ(shared.GetOrBuild(file, ""), trees[0]);
+
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(".", ec)) {
+        EXPECT_EQ(entry.path().filename().string().rfind(sidecar + ".tmp", 0),
+                  std::string::npos);
+    }
+    MerkleTreeCache reloaded;
+    auto fromDisk = reloaded.GetOrBuild(file, "", MerkleFormat::Binary);
+    ASSERT_TRUE(fromDisk != nullptr);
+    EXPECT_EQ(fromDisk->root, binary->root);
+
+    std::remove(file.c_str());
+    std::remove(sidecar.c_str());
+}
+
+// Challenges pick distinct leaf indices, and chunk reads share one mapping per snapshot
+// version: concurrent readers get the same mapping, a rewritten file gets a new one
+TEST(ProofGeneratorTest, LeafAlignedChallengesAndSharedMappings) {
+    using rxrevoltchain::ipfs_integration::ChunkReader;
+    using rxrevoltchain::ipfs_integration::MerkleProof;
+    const std::string file = "proof_chunks.bin";
+    std::string content;
+    for (int i = 0; i < 10 * 4096 + 100; ++i)
+        content.push_back(static_cast<char>(i * 7 % 253));
+    {
+        std::ofstream ofs(file, std::ios::binary);
+        ofs << content;
+    }
+
+    rxrevoltchain::pinner::ProofGenerator generator;
+    for (int round = 0; round < 50; ++round) {
+        auto leaves = generator.GenerateLeafIndices(content.size(), 5);
+        ASSERT_EQ(leaves.size(), (size_t)5);
+        EXPECT_TRUE(std::is_sorted(leaves.begin(), leaves.end()));
+        EXPECT_EQ(std::adjacent_find(leaves.begin(), leaves.end()), leaves.end());
+        EXPECT_LT(leaves.back(), (size_t)11);
+    }
+    EXPECT_EQ(generator.GenerateLeafIndices(content.size(), 50).size(), (size_t)11);
+    EXPECT_EQ(generator.GenerateLeafIndices(31, 4), std::vector<size_t>{0});
+    EXPECT_TRUE(generator.GenerateLeafIndices(0, 4).empty());
+
+    // Byte offsets, including a partial chunk at the end and one past EOF
+    const std::vector<size_t> offsets = {0, 3 * 4096, 5, content.size() - 10, content.size()};
+    std::string expected;
+    for (size_t off : offsets) {
+        expected += content.substr(std::min(off, content.size()), 4096);
+    }
+    auto extracted = generator.ExtractChunks(file, offsets, 4096);
+    EXPECT_EQ(std::string(extracted.begin(), extracted.end()), expected);
+    EXPECT_THROW(generator.ExtractChunks("missing_proof_chunks.bin", {0}, 16), std::runtime_error);
+
+    ChunkReader reader;
+    std::vector<std::shared_ptr<const rxrevoltchain::ipfs_integration::MappedFile>> maps(4);
+    std::vector<std::thread> threads;
+    for (auto& map : maps) {
+        threads.emplace_back([&] { map = reader.Map(file); });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    auto first = reader.Map(file);
+    ASSERT_TRUE(first != nullptr);
+    EXPECT_TRUE(first->IsMapped());
+    EXPECT_EQ(reader.Map(file), first);
+    EXPECT_EQ(reader.MappedFiles(), (size_t)1);
+
+    // Replace the file: the old mapping keeps the old bytes, new reads see the new file
+    std::string replaced(2 * 4096, 'z');
+    {
+        std::ofstream ofs(file + ".new", std::ios::binary);
+        ofs << replaced;
+    }
+    std::rename((file + ".new").c_str(), file.c_str());
+    std::map<size_t, std::vector<uint8_t>> chunks{{0, {}}, {1, {}}, {2, {}}};
+    ASSERT_TRUE(reader.ReadChunks(file, 4096, chunks));
+    EXPECT_EQ(chunks[0], std::vector<uint8_t>(4096, 'z'));
+    EXPECT_EQ(chunks[1], std::vector<uint8_t>(4096, 'z'));
+    EXPECT_TRUE(chunks[2].empty());
+    EXPECT_NE(reader.Map(file), first);
+    std::vector<uint8_t> old(4096);
+    ASSERT_EQ(first->Read(0, old.size(), old.data()), (size_t)4096);
+    EXPECT_EQ(std::string(old.begin(), old.end()), content.substr(0, 4096));
+
+    // Empty files are readable without a mapping
+    { std::ofstream ofs(file, std::ios::binary | std::ios::trunc); }
+    auto empty = reader.Map(file);
+    ASSERT_TRUE(empty != nullptr);
+    EXPECT_EQ(empty->Size(), (size_t)0);
+    EXPECT_FALSE(empty->IsMapped());
+    reader.Release(file);
+    EXPECT_EQ(reader.MappedFiles(), (size_t)0);
+
+    // PoP challenges only name leaves the file has, so every one is proven
+    {
+        std::ofstream ofs(file, std::ios::binary | std::ios::trunc);
+        ofs << content;
+    }
+    rxrevoltchain::consensus::PoPConsensus pop;
+    pop.IssueChallenges("cidChunks", file);
+    const auto challenged = pop.GetCurrentOffsets();
+    ASSERT_GE(challenged.size(), (size_t)3);
+    EXPECT_LT(challenged.back(), (size_t)11);
+    auto tree = pop.GetTreeCache().GetOrBuild(file, "cidChunks");
+    ASSERT_TRUE(tree != nullptr);
+    MerkleProof mp;
+    auto proof = mp.GenerateProof(file, challenged, *tree);
+    EXPECT_EQ(proof, mp.GenerateProof(file, challenged));
+    pop.CollectResponse("node1", proof);
+    EXPECT_TRUE(pop.ValidateResponses());
+
+    std::remove(file.c_str());
+    std::remove(rxrevoltchain::ipfs_integration::MerkleTreeCache::CachePathFor(file).c_str());
+}
+
+// v2 proofs carry raw 32-byte digests, verify alongside v1 and are rejected by a round that
+// expects the other format.
+TEST(MerkleProofTest, BinaryFormatV2) {
+    using rxrevoltchain::ipfs_integration::MerkleFormat;
+    using rxrevoltchain::ipfs_integration::MerkleProof;
+    using rxrevoltchain::ipfs_integration::MerkleTree;
+    const std::string file = "merkle_v2.bin";
+    {
+        std::ofstream ofs(file, std::ios::binary);
+        for (int i = 0; i < 7 * 4096 + 5; ++i)
+            ofs.put(static_cast<char>((i * 7) % 253));
+    }
+
+    MerkleProof mp;
+    std::vector<size_t> offsets = {0, 3, 7};
+    auto v1 = mp.GenerateProof(file, offsets);
+    auto v2 = mp.GenerateProof(file, offsets, MerkleFormat::Binary);
+    EXPECT_TRUE(mp.VerifyProof(v1));
+    EXPECT_TRUE(mp.VerifyProof(v2));
+    EXPECT_LT(v2.size(), v1.size());
+    EXPECT_EQ(std::string(v2.begin(), v2.begin() + 4), "RXM2");
+
+    // The legacy tree still matches the original hex-string construction
+    MerkleTree legacy;
+    ASSERT_TRUE(mp.BuildTree(file, legacy));
+    EXPECT_EQ(legacy.LeafCount(), (size_t)8);
+    EXPECT_EQ(legacy.nodes.size(), (size_t)(8 + 4 + 2 + 1) * 32);
+    std::string l0 = MerkleProof::toHex(legacy.Node(1, 0));
+    std::string l1 = MerkleProof::toHex(legacy.Node(1, 1));
+    std::vector<uint8_t> both(l0.begin(), l0.end());
+    both.insert(both.end(), l1.begin(), l1.end());
+    EXPECT_EQ(MerkleProof::toHex(legacy.Node(2, 0)), rxrevoltchain::util::hashing::sha256(both));
+
+    MerkleTree binary;
+    ASSERT_TRUE(mp.BuildTree(file, binary, MerkleFormat::Binary));
+    EXPECT_NE(binary.root, legacy.root);
+
+    MerkleFormat format = MerkleFormat::LegacyHex;
+    EXPECT_EQ(MerkleProof::ExtractRoot(v1, &format), legacy.root);
+    EXPECT_EQ(format, MerkleFormat::LegacyHex);
+    EXPECT_EQ(MerkleProof::ExtractRoot(v2, &format), binary.root);
+    EXPECT_EQ(format, MerkleFormat::Binary);
+
+    v2[v2.size() - 1] ^= 0x01;
+    EXPECT_FALSE(mp.VerifyProof(v2));
+
+    // A v2 challenge round accepts v2 proofs only
+    using rxrevoltchain::ipfs_integration::MerkleTreeCache;
+    const std::string sidecar = MerkleTreeCache::CachePathFor(file);
+    rxrevoltchain::consensus::PoPConsensus pop;
+    pop.SetProofFormat(MerkleFormat::Binary);
+    pop.IssueChallenges("cidV2", file);
+    pop.CollectResponse("v1node", v1);
+    pop.CollectResponse("v2node", mp.GenerateProof(file, pop.GetCurrentOffsets(), binary));
+    EXPECT_TRUE(pop.ValidateResponses());
+    auto passing = pop.GetPassingNodes();
+    ASSERT_EQ(passing.size(), (size_t)1);
+    EXPECT_EQ(passing[0], "v2node");
+
+    std::remove(file.c_str());
+    std::remove(sidecar.c_str());
+}
+
+// A v3 multi-proof sends every shared sibling once, in binary, and is checked in one
+// bottom-up pass; it reaches the same root as v1 on a legacy tree
+TEST(MerkleProofTest, CompactMultiProofV3) {
+    using rxrevoltchain::ipfs_integration::MerkleFormat;
+    using rxrevoltchain::ipfs_integration::MerkleProof;
+    using rxrevoltchain::ipfs_integration::MerkleTree;
+    using rxrevoltchain::ipfs_integration::MerkleTreeCache;
+    const std::string file = "merkle_v3.bin";
+    const size_t chunk = MerkleProof::DEFAULT_CHUNK_SIZE;
+    {
+        std::ofstream ofs(file, std::ios::binary);
+        for (size_t i = 0; i < 300 * chunk + 77; ++i)
+            ofs.put(static_cast<char>((i * 13) ^ (i >> 9)));
+    }
+
+    MerkleProof mp;
+    MerkleTree legacy;
+    ASSERT_TRUE(mp.BuildTree(file, legacy));
+    ASSERT_EQ(legacy.LeafCount(), (size_t)301);
+
+    // Unsorted, duplicated and out-of-range offsets; 300 is the odd, promoted last leaf
+    std::vector<size_t> offsets = {250, 3, 2, 300, 151, 3, 64, 999};
+    auto v1 = mp.GenerateProof(file, offsets);
+    auto v3 = mp.GenerateMultiProof(file, offsets, legacy);
+    ASSERT_FALSE(v3.empty());
+    EXPECT_EQ(std::string(v3.begin(), v3.begin() + 4), "RXM3");
+    EXPECT_TRUE(mp.VerifyProof(v1));
+    EXPECT_TRUE(mp.VerifyProof(v3));
+    EXPECT_EQ(mp.GenerateMultiProof(file, offsets), v3);
+
+    // Compare the overhead beyond the chunk bytes both formats must carry
+    const size_t chunkBytes = 5 * chunk + 77;
+    EXPECT_LT((v3.size() - chunkBytes) * 4, v1.size() - chunkBytes);
+
+    MerkleFormat format = MerkleFormat::Binary;
+    EXPECT_EQ(MerkleProof::ExtractRoot(v3, &format), legacy.root);
+    EXPECT_EQ(format, MerkleFormat::LegacyHex);
+
+    auto binary = mp.GenerateMultiProof(file, offsets, MerkleFormat::Binary);
+    EXPECT_TRUE(mp.VerifyProof(binary));
+    MerkleTree binaryTree;
+    ASSERT_TRUE(mp.BuildTree(file, binaryTree, MerkleFormat::Binary));
+    EXPECT_EQ(MerkleProof::ExtractRoot(binary, &format), binaryTree.root);
+    EXPECT_EQ(format, MerkleFormat::Binary);
+
+    // Any change to chunk data, a node, the root or the node count is rejected
+    auto single = mp.GenerateMultiProof(file, {0});
+    EXPECT_TRUE(mp.VerifyProof(single));
+    for (size_t pos : {size_t(28), v3.size() - 40, v3.size() - 1}) {
+        auto bad = v3;
+        bad[pos] ^= 0x01;
+        EXPECT_FALSE(mp.VerifyProof(bad)) << pos;
+    }
+    auto extra = v3;
+    extra.insert(extra.end() - 32, 32, 0x00);
+    EXPECT_FALSE(mp.VerifyProof(extra));
+    EXPECT_FALSE(mp.VerifyProof(std::vector<uint8_t>(v3.begin(), v3.begin() + 20)));
+
+    // PoP accepts multi-proofs without any change to its round logic, but only for the
+    // challenged leaves: a valid proof of other leaves (or of a subset) fails
+    rxrevoltchain::consensus::PoPConsensus pop;
+    pop.IssueChallenges("cidV3", file);
+    MerkleTreeCache cache;
+    const auto challenged = pop.GetCurrentOffsets();
+    pop.CollectResponse("v3node", cache.GenerateMultiProof(file, "cidV3", challenged));
+    pop.CollectResponse("chosen", cache.GenerateMultiProof(file, "cidV3", {0, 1, 2}));
+    pop.CollectResponse("subset", cache.GenerateMultiProof(
+                                      file, "cidV3", {challenged.begin(), challenged.end() - 1}));
+    pop.CollectResponse("subsetV1", mp.GenerateProof(file, {challenged.front()}));
+    EXPECT_TRUE(pop.ValidateResponses());
+    EXPECT_EQ(pop.GetPassingNodes(), std::vector<std::string>{"v3node"});
+
+    std::remove(file.c_str());
+    std::remove(MerkleTreeCache::CachePathFor(file).c_str());
+}
+
+// parallelFor visits every index exactly once, works when nested inside a pool task and
+// rethrows worker exceptions; a merkle tree built on the shared pool stays deterministic.
+TEST(ThreadPoolTest, ParallelForAndDeterministicMerkle) {
+    rxrevoltchain::util::ThreadPool pool(3);
+    std::vector<std::atomic<int>> hits(10007);
+    pool.parallelFor(hits.size(), 64, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            hits[i]++;
+    });
+    for (auto& h : hits)
+        ASSERT_EQ(h.load(), 1);
+
+    // A single-worker pool whose only worker runs the outer loop must not deadlock
+    rxrevoltchain::util::ThreadPool single(1);
+    std::atomic<size_t> inner{0};
+    auto nested = single.enqueue([&]() {
+        single.parallelFor(100, 10, [&](size_t b, size_t e) { inner += e - b; });
+    });
+    nested.get();
+    EXPECT_EQ(inner.load(), (size_t)100);
+
+    // Nor must a task that waits on a submit()ted one; the waiter runs it instead
+    auto outer = single.enqueue([&single]() {
+        auto task = single.submit([] { return 7; });
+        return task.get();
+    });
+    ASSERT_EQ(outer.wait_for(std::chrono::seconds(30)), std::future_status::ready);
+    EXPECT_EQ(outer.get(), 7);
+    auto failing = pool.submit([]() -> int { throw std::runtime_error("task"); });
+    EXPECT_THROW(failing.get(), std::runtime_error);
+    EXPECT_FALSE(failing.valid());
+
+    EXPECT_THROW(pool.parallelFor(100, 1,
+                                  [](size_t b, size_t) {
+                                      if (b == 42)
+                                          throw std::runtime_error("boom");
+                                  }),
+                 std::runtime_error);
+
+    using rxrevoltchain::ipfs_integration::MerkleFormat;
+    using rxrevoltchain::ipfs_integration::MerkleProof;
+    using rxrevoltchain::ipfs_integration::MerkleTree;
+    const std::string file = "merkle_parallel.bin";
+    const size_t chunks = 2 * MerkleProof::PARENT_GRAIN + 3 * MerkleProof::READ_WINDOW_CHUNKS + 1;
+    {
+        std::ofstream ofs(file, std::ios::binary);
+        for (size_t i = 0; i < chunks * MerkleProof::DEFAULT_CHUNK_SIZE; ++i)
+            ofs.put(static_cast<char>((i * 2654435761u) >> 13));
+    }
+    MerkleProof mp;
+    for (auto format : {MerkleFormat::LegacyHex, MerkleFormat::Binary}) {
+        MerkleTree a, b;
+        ASSERT_TRUE(mp.BuildTree(file, a, format));
+        ASSERT_TRUE(mp.BuildTree(file, b, format));
+        EXPECT_EQ(a.LeafCount(), chunks);
+        EXPECT_EQ(a.nodes, b.nodes);
+        EXPECT_TRUE(mp.VerifyProof(mp.GenerateProof(file, {0, chunks / 2, chunks - 1}, a)));
+    }
+    // Proofs streamed straight from the file carry the same root as the built tree
+    MerkleTree legacy;
+    ASSERT_TRUE(mp.BuildTree(file, legacy));
+    EXPECT_EQ(MerkleProof::ExtractRoot(mp.GenerateProof(file, {1})), legacy.root);
+    std::remove(file.c_str());
+}
+
+// Async logging keeps every record from concurrent producers in per-thread order, and
+// filtered lazy messages are never formatted
+TEST(LoggerTest, AsyncRingBufferAndLevelFilter) {
+    using namespace rxrevoltchain::util::logger;
+    Logger& log = Logger::getInstance();
+    const std::string file = "logger_async.log";
+    log.enableFileOutput(file);
+
+    int formatted = 0;
+    log.setLogLevel(LogLevel::WARN);
+    log.info([&] {
+        ++formatted;
+        return std::string("[LoggerTest] filtered");
+    });
+    EXPECT_EQ(formatted, 0);
+    log.setLogLevel(LogLevel::INFO);
+
+    ASSERT_TRUE(log.enableAsync(64, OverflowPolicy::Block));
+    EXPECT_TRUE(log.isAsync());
+    const int threads = 4;
+    const int perThread = 250;
+    std::vector<std::thread> producers;
+    for (int t = 0; t < threads; ++t) {
+        producers.emplace_back([&log, t]() {
+            for (int i = 0; i < perThread; ++i) {
+                log.info("[LoggerTest] block t" + std::to_string(t) + " i" + std::to_string(i));
+            }
+        });
+    }
+    for (auto& th : producers)
+        th.join();
+
+    // Under Drop a full buffer discards records instead of blocking; all are accounted for
+    ASSERT_TRUE(log.enableAsync(64, OverflowPolicy::Drop));
+    const uint64_t droppedBefore = log.droppedCount();
+    const int burst = 3000;
+    for (int i = 0; i < burst; ++i) {
+        log.info("[LoggerTest] drop i" + std::to_string(i));
+    }
+    log.error("[LoggerTest] error written before returning");
+    const uint64_t dropped = log.droppedCount() - droppedBefore;
+    log.disableAsync();
+    EXPECT_FALSE(log.isAsync());
+    log.disableFileOutput();
+
+    std::ifstream in(file);
+    std::string line;
+    std::vector<int> next(threads, 0);
+    int blockLines = 0;
+    int dropLines = 0;
+    bool inOrder = true;
+    bool sawDropReport = false;
+    bool sawError = false;
+    while (std::getline(in, line)) {
+        EXPECT_EQ(line.find('\033'), std::string::npos);
+        auto pos = line.find("[LoggerTest] block t");
+        if (pos != std::string::npos) {
+            int t = 0;
+            int i = 0;
+            ASSERT_EQ(std::sscanf(line.c_str() + pos, "[LoggerTest] block t%d i%d", &t, &i), 2);
+            inOrder = inOrder && (i == next[t]);
+            next[t] = i + 1;
+            ++blockLines;
+        } else if (line.find("[LoggerTest] drop i") != std::string::npos) {
+            ++dropLines;
+        } else if (line.find("[Logger] Dropped") != std::string::npos) {
+            sawDropReport = true;
+        } else if (line.find("[ERROR] [LoggerTest] error written") != std::string::npos) {
+            sawError = true;
+        }
+    }
+    EXPECT_EQ(blockLines, threads * perThread);
+    EXPECT_TRUE(inOrder);
+    EXPECT_EQ(dropLines + dropped, (uint64_t)burst);
+    EXPECT_EQ(sawDropReport, dropped > 0);
+    EXPECT_TRUE(sawError);
+
+    std::remove(file.c_str());
+}
+
+// Every available SHA-256 backend produces the same digests as OpenSSL, for single messages
+// and batches, across padding boundaries and batch sizes that leave a remainder.
+TEST(HashingTest, BackendsMatchOpenSSL) {
+    namespace h = rxrevoltchain::util::hashing;
+    const h::Sha256Backend original = h::sha256Backend();
+
+    std::vector<uint8_t> abc = {'a', 'b', 'c'};
+    EXPECT_EQ(h::sha256(abc), "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+
+    std::vector<uint8_t> data(17 * 4100);
+    for (size_t i = 0; i < data.size(); ++i)
+        data[i] = static_cast<uint8_t>(i * 31 + (i >> 7));
+
+    for (auto backend :
+         {h::Sha256Backend::OpenSSL, h::Sha256Backend::ShaNi, h::Sha256Backend::Avx2}) {
+        if (!h::setSha256Backend(backend))
+            continue;
+        SCOPED_TRACE(h::sha256BackendName(backend));
+        for (size_t len : {0, 1, 55, 56, 63, 64, 65, 119, 120, 128, 1000, 4096, 4100}) {
+            for (size_t count : {1, 7, 8, 9, 17}) {
+                std::vector<uint8_t> out(count * 32);
+                h::sha256Batch(data.data(), len, count, out.data());
+                for (size_t i = 0; i < count; ++i) {
+                    uint8_t expected[32];
+                    SHA256(data.data() + i * len, len, expected);
+                    ASSERT_EQ(std::memcmp(out.data() + i * 32, expected, 32), 0)
+                        << "len " << len << " count " << count << " index " << i;
+                }
+            }
+            uint8_t expected[32];
+            SHA256(data.data(), len, expected);
+            h::Digest single = h::sha256Raw(data.data(), len);
+            EXPECT_EQ(std::memcmp(single.data(), expected, 32), 0) << "len " << len;
+        }
+    }
+    h::setSha256Backend(original);
+}
+
+// sha256File streams through its read-ahead blocks: several blocks, an exact multiple of
+// the block size and an empty file all hash like the bytes in memory
+TEST(HashingTest, FileDigestAcrossReadBlocks) {
+    namespace h = rxrevoltchain::util::hashing;
+    const std::string file = "hash_blocks.bin";
+    std::vector<uint8_t> data((3 << 20) + 123);
+    for (size_t i = 0; i < data.size(); ++i)
+        data[i] = static_cast<uint8_t>(i * 131 + (i >> 11));
+    for (size_t len : {data.size(), size_t(2) << 20, size_t(0)}) {
+        {
+            std::ofstream ofs(file, std::ios::binary | std::ios::trunc);
+            ofs.write(reinterpret_cast<const char*>(data.data()), len);
+        }
+        EXPECT_EQ(h::sha256File(file), h::toHex(h::sha256Raw(data.data(), len))) << len;
+    }
+    std::remove(file.c_str());
+    EXPECT_THROW(h::sha256File(file), std::runtime_error);
 }
 
 TEST(ServiceManagerTest, ContentModerationFlow) {
@@ -332,6 +2121,477 @@ TEST(HttpQueryServerTest, DocumentCount) {
     std::remove(db.c_str());
 }
 
+// Several requests share one keep-alive connection, clients are served concurrently and
+// repeated /record reads come from the cache until a DailySnapshot commit invalidates it
+TEST(HttpQueryServerTest, KeepAliveWorkersAndRecordCache) {
+    const std::string wal = "query_cache.wal";
+    const std::string db = "query_cache.sqlite";
+    std::remove(wal.c_str());
+    std::remove(db.c_str());
+
+    rxrevoltchain::core::DocumentQueue queue(wal);
+    rxrevoltchain::core::DailySnapshot snapshot(db);
+    snapshot.SetDocumentQueue(&queue);
+    ASSERT_TRUE(queue.AddTransaction(makeTransaction("document_submission", "first \"doc\"", {1})));
+    ASSERT_TRUE(snapshot.MergePendingDocuments());
+
+    rxrevoltchain::network::HttpQueryServer server(db, 0);
+    server.SetWorkerThreads(3);
+    server.SetKeepAliveTimeout(60000);
+    snapshot.SetCommitListener([&server]() { server.InvalidateCache(); });
+    ASSERT_TRUE(server.Start());
+    ASSERT_GT(server.Port(), 0);
+
+    auto connectClient = [&server]() {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(server.Port()));
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        EXPECT_EQ(connect(fd, (sockaddr*)&addr, sizeof(addr)), 0);
+        return fd;
+    };
+    // Reads 'count' responses and returns their bodies ("" after EOF)
+    auto readResponses = [](int fd, size_t count) {
+        std::vector<std::string> bodies;
+        std::string buffer;
+        char chunk[4096];
+        while (bodies.size() < count) {
+            const size_t headerEnd = buffer.find("\r\n\r\n");
+            const size_t lengthPos = buffer.find("Content-Length: ");
+            if (headerEnd != std::string::npos && lengthPos < headerEnd) {
+                const size_t length = std::stoul(buffer.substr(lengthPos + 16));
+                if (buffer.size() >= headerEnd + 4 + length) {
+                    bodies.push_back(buffer.substr(0, headerEnd + 4 + length));
+                    buffer.erase(0, headerEnd + 4 + length);
+                    continue;
+                }
+            }
+            const ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+            if (n <= 0)
+                break;
+            buffer.append(chunk, static_cast<size_t>(n));
+        }
+        return bodies;
+    };
+    auto get = [](const std::string& path, const char* connection = "keep-alive") {
+        return "GET " + path + " HTTP/1.1\r\nHost: test\r\nConnection: " + connection +
+               "\r\n\r\n";
+    };
+
+    // Three pipelined requests on one connection, all answered on it
+    int fd = connectClient();
+    const std::string pipelined = get("/record/1") + get("/record/1") + get("/nope");
+    ASSERT_EQ(send(fd, pipelined.data(), pipelined.size(), 0), (ssize_t)pipelined.size());
+    std::vector<std::string> responses = readResponses(fd, 3);
+    ASSERT_EQ(responses.size(), (size_t)3);
+    EXPECT_EQ(responses[0].rfind("HTTP/1.1 200 OK", 0), (size_t)0);
+    EXPECT_NE(responses[0].find("Connection: keep-alive"), std::string::npos);
+    EXPECT_NE(responses[0].find("{\"metadata\":\"first \\\"doc\\\"\",\"payload\":\"AQ==\"}"),
+              std::string::npos);
+    EXPECT_EQ(responses[1].substr(responses[1].find("\r\n\r\n")),
+              responses[0].substr(responses[0].find("\r\n\r\n")));
+    EXPECT_EQ(responses[2].rfind("HTTP/1.1 404 Not Found", 0), (size_t)0);
+    EXPECT_EQ(server.RecordCacheMisses(), (uint64_t)1);
+    EXPECT_EQ(server.RecordCacheHits(), (uint64_t)1);
+
+    // Concurrent clients, each with its own keep-alive connection
+    std::vector<std::thread> clients;
+    std::atomic<int> ok{0};
+    for (int c = 0; c < 4; ++c) {
+        clients.emplace_back([&]() {
+            int client = connectClient();
+            for (int i = 0; i < 5; ++i) {
+                const std::string request = get("/record/1");
+                send(client, request.data(), request.size(), 0);
+                std::vector<std::string> r = readResponses(client, 1);
+                if (r.size() == 1 && r[0].rfind("HTTP/1.1 200 OK", 0) == 0)
+                    ++ok;
+            }
+            close(client);
+        });
+    }
+    for (auto& t : clients)
+        t.join();
+    EXPECT_EQ(ok.load(), 20);
+    EXPECT_EQ(server.RecordCacheMisses(), (uint64_t)1);
+
+    // A commit invalidates the cache; the next read sees the new rows
+    ASSERT_TRUE(queue.AddTransaction(makeTransaction("document_submission", "second", {2})));
+    ASSERT_TRUE(snapshot.MergePendingDocuments());
+    const std::string again = get("/record/1") + get("/record/2", "close");
+    ASSERT_EQ(send(fd, again.data(), again.size(), 0), (ssize_t)again.size());
+    responses = readResponses(fd, 3);
+    ASSERT_EQ(responses.size(), (size_t)2); // the server closed after "Connection: close"
+    EXPECT_EQ(server.RecordCacheMisses(), (uint64_t)3);
+    EXPECT_NE(responses[1].find("\"metadata\":\"second\""), std::string::npos);
+    EXPECT_NE(responses[1].find("Connection: close"), std::string::npos);
+    close(fd);
+
+    // A write from another connection is noticed through PRAGMA data_version
+    sqlite3* writer = nullptr;
+    ASSERT_EQ(sqlite3_open(db.c_str(), &writer), SQLITE_OK);
+    ASSERT_EQ(sqlite3_exec(writer, "UPDATE documents SET metadata='edited' WHERE id=1", nullptr,
+                           nullptr, nullptr),
+              SQLITE_OK);
+    sqlite3_close(writer);
+    bool edited = false;
+    for (int attempt = 0; attempt < 50 && !edited; ++attempt) {
+        int client = connectClient();
+        const std::string request = get("/record/1", "close");
+        send(client, request.data(), request.size(), 0);
+        std::vector<std::string> r = readResponses(client, 1);
+        edited = r.size() == 1 && r[0].find("\"metadata\":\"edited\"") != std::string::npos;
+        close(client);
+        if (!edited)
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    EXPECT_TRUE(edited);
+
+    const auto stopStarted = std::chrono::steady_clock::now();
+    server.Stop();
+    EXPECT_LT(std::chrono::steady_clock::now() - stopStarted, std::chrono::seconds(2));
+    EXPECT_FALSE(server.IsRunning());
+    snapshot.CloseDatabase();
+    std::remove(wal.c_str());
+    std::remove(db.c_str());
+    std::remove((db + "-wal").c_str());
+    std::remove((db + "-shm").c_str());
+}
+
+// Sends one request with "Connection: close" and returns everything the server wrote
+static std::string httpExchange(int port, const std::string& request) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    std::string response;
+    if (connect(fd, (sockaddr*)&addr, sizeof(addr)) == 0 &&
+        send(fd, request.data(), request.size(), 0) == (ssize_t)request.size()) {
+        char chunk[4096];
+        ssize_t n;
+        while ((n = recv(fd, chunk, sizeof(chunk), 0)) > 0)
+            response.append(chunk, static_cast<size_t>(n));
+    }
+    close(fd);
+    return response;
+}
+
+// Body of a chunked response; empty if the terminating chunk is missing
+static std::string dechunk(const std::string& response) {
+    size_t pos = response.find("\r\n\r\n") + 4;
+    std::string body;
+    while (pos < response.size()) {
+        const size_t lineEnd = response.find("\r\n", pos);
+        const size_t size = std::stoul(response.substr(pos, lineEnd - pos), nullptr, 16);
+        if (size == 0)
+            return body;
+        body += response.substr(lineEnd + 2, size);
+        pos = lineEnd + 2 + size + 2;
+    }
+    return "";
+}
+
+// /records streams id ranges and id batches as chunked JSON or raw frames
+TEST(HttpQueryServerTest, StreamedRangeBatchAndRaw) {
+    const std::string wal = "query_stream.wal";
+    const std::string db = "query_stream.sqlite";
+    std::remove(wal.c_str());
+    std::remove(db.c_str());
+    {
+        rxrevoltchain::core::DocumentQueue queue(wal);
+        rxrevoltchain::core::DailySnapshot snapshot(db);
+        snapshot.SetDocumentQueue(&queue);
+        for (int i = 0; i < 600; ++i) {
+            std::vector<uint8_t> payload(40 + i % 7, static_cast<uint8_t>(i));
+            ASSERT_TRUE(queue.AddTransaction(
+                makeTransaction("document_submission", "m" + std::to_string(i), payload)));
+        }
+        ASSERT_TRUE(snapshot.MergePendingDocuments());
+    }
+
+    rxrevoltchain::network::HttpQueryServer server(db, 0);
+    ASSERT_TRUE(server.Start());
+    const int port = server.Port();
+    auto expected = [](int id, bool first) {
+        std::vector<uint8_t> payload(40 + (id - 1) % 7, static_cast<uint8_t>(id - 1));
+        return std::string(first ? "" : ",") + "{\"id\":" + std::to_string(id) +
+               ",\"metadata\":\"m" + std::to_string(id - 1) + "\",\"payload\":\"" +
+               rxrevoltchain::util::base64::encode(payload.data(), payload.size()) + "\"}";
+    };
+
+    // A range spanning several read pages
+    std::string response = httpExchange(
+        port, "GET /records?from=2&to=550&limit=500 HTTP/1.1\r\nConnection: close\r\n\r\n");
+    EXPECT_NE(response.find("Transfer-Encoding: chunked"), std::string::npos);
+    std::string want = "[";
+    for (int id = 2; id < 502; ++id)
+        want += expected(id, id == 2);
+    want += "]";
+    EXPECT_EQ(dechunk(response), want);
+
+    // 'to' bounds the range; an empty range is an empty array
+    response = httpExchange(port, "GET /records?from=599&to=700 HTTP/1.1\r\nConnection: "
+                                  "close\r\n\r\n");
+    EXPECT_EQ(dechunk(response), "[" + expected(599, true) + expected(600, false) + "]");
+    response = httpExchange(port, "GET /records?from=9000 HTTP/1.1\r\nConnection: close\r\n\r\n");
+    EXPECT_EQ(dechunk(response), "[]");
+    response = httpExchange(port, "GET /records?limit=x HTTP/1.1\r\nConnection: close\r\n\r\n");
+    EXPECT_EQ(response.rfind("HTTP/1.1 400", 0), (size_t)0);
+
+    // Batch by ids, in request order, skipping unknown ids
+    const std::string ids = "[7, 3, 12345, 600]";
+    response = httpExchange(port, "POST /records HTTP/1.1\r\nConnection: close\r\n"
+                                  "Content-Length: " +
+                                      std::to_string(ids.size()) + "\r\n\r\n" + ids);
+    EXPECT_EQ(dechunk(response),
+              "[" + expected(7, true) + expected(3, false) + expected(600, false) + "]");
+
+    // Raw frames: u64 id, u32 metadata length, u32 payload length, metadata, payload
+    response = httpExchange(port, "GET /records?from=10&limit=2&raw=1 HTTP/1.0\r\n\r\n");
+    EXPECT_NE(response.find("Content-Type: application/x-rxrevolt-records"), std::string::npos);
+    EXPECT_EQ(response.find("Transfer-Encoding"), std::string::npos);
+    std::string frames = response.substr(response.find("\r\n\r\n") + 4);
+    for (int id : {10, 11}) {
+        ASSERT_GE(frames.size(), (size_t)16);
+        uint64_t frameId = 0;
+        uint32_t metaLen = 0, payloadLen = 0;
+        std::memcpy(&frameId, frames.data(), 8);
+        std::memcpy(&metaLen, frames.data() + 8, 4);
+        std::memcpy(&payloadLen, frames.data() + 12, 4);
+        EXPECT_EQ(frameId, (uint64_t)id);
+        EXPECT_EQ(frames.substr(16, metaLen), "m" + std::to_string(id - 1));
+        EXPECT_EQ(frames.substr(16 + metaLen, payloadLen),
+                  std::string(40 + (id - 1) % 7, static_cast<char>(id - 1)));
+        frames.erase(0, 16 + metaLen + payloadLen);
+    }
+    EXPECT_TRUE(frames.empty());
+
+    response = httpExchange(port, "GET /record/5?raw=1 HTTP/1.1\r\nConnection: close\r\n\r\n");
+    EXPECT_NE(response.find("Content-Type: application/octet-stream"), std::string::npos);
+    EXPECT_EQ(response.substr(response.find("\r\n\r\n") + 4), std::string(44, '\x04'));
+
+    server.Stop();
+    std::remove(wal.c_str());
+    std::remove(db.c_str());
+    std::remove((db + "-wal").c_str());
+    std::remove((db + "-shm").c_str());
+}
+
+// Merges maintain the cost-item and full-text indexes behind /costs and /search
+TEST(HttpQueryServerTest, CostAndFullTextQueries) {
+    using rxrevoltchain::core::DocumentIndex;
+    const std::string wal = "query_index.wal";
+    const std::string db = "query_index.sqlite";
+    std::remove(wal.c_str());
+    std::remove(db.c_str());
+
+    auto bytes = [](const std::string& text) {
+        return std::vector<uint8_t>(text.begin(), text.end());
+    };
+    const std::vector<uint8_t> mri = bytes(
+        R"({"provider":"St. Mary","region":"OH","items":[)"
+        R"({"cpt":70551,"description":"MRI brain","price":"$1,250.00"},)"
+        R"({"procedure_code":"80053","description":"Metabolic panel","negotiated_rate":42.5}]})");
+    const std::vector<uint8_t> clinic = bytes(
+        R"({"facility":"Valley Clinic","state":"PA","procedure_code":"70551","cash_price":900,)"
+        R"("notes":"walk-in imaging"})");
+
+    const DocumentIndex::Entry entry = DocumentIndex::Extract(mri);
+    ASSERT_EQ(entry.items.size(), (size_t)2);
+    EXPECT_EQ(entry.items[0].procedureCode, "70551");
+    EXPECT_EQ(entry.items[0].provider, "St. Mary");
+    EXPECT_EQ(entry.items[0].region, "OH");
+    EXPECT_DOUBLE_EQ(entry.items[0].price, 1250.0);
+    EXPECT_DOUBLE_EQ(entry.items[1].price, 42.5);
+    EXPECT_NE(entry.text.find("MRI brain"), std::string::npos);
+    EXPECT_TRUE(DocumentIndex::Extract(bytes("plain text note")).items.empty());
+    EXPECT_EQ(DocumentIndex::Extract(bytes("plain text note")).text, "plain text note");
+
+    rxrevoltchain::core::DocumentQueue queue(wal);
+    rxrevoltchain::core::DailySnapshot snapshot(db);
+    snapshot.SetDocumentQueue(&queue);
+    ASSERT_TRUE(queue.AddTransaction(makeTransaction("document_submission", "mri", mri)));
+    ASSERT_TRUE(queue.AddTransaction(makeTransaction("document_submission", "clinic", clinic)));
+    ASSERT_TRUE(queue.AddTransaction(
+        makeTransaction("document_submission", "note", bytes("follow-up imaging call"))));
+    ASSERT_TRUE(snapshot.MergePendingDocuments());
+
+    rxrevoltchain::network::HttpQueryServer server(db, 0);
+    snapshot.SetCommitListener([&server]() { server.InvalidateCache(); });
+    ASSERT_TRUE(server.Start());
+    auto get = [&server](const std::string& target) {
+        const std::string response =
+            httpExchange(server.Port(), "GET " + target + " HTTP/1.1\r\nConnection: close\r\n\r\n");
+        const size_t body = response.find("\r\n\r\n");
+        return response.substr(0, 12) +
+               (body == std::string::npos ? "" : response.substr(body + 4));
+    };
+
+    // Cheapest first across providers
+    EXPECT_EQ(get("/costs?procedure=70551"),
+              "HTTP/1.1 200"
+              R"([{"id":2,"procedure_code":"70551","description":null,"provider":"Valley Clinic",)"
+              R"("region":"PA","price":900,"metadata":"clinic"},)"
+              R"({"id":1,"procedure_code":"70551","description":"MRI brain",)"
+              R"("provider":"St. Mary","region":"OH","price":1250,"metadata":"mri"}])");
+    EXPECT_EQ(get("/costs?provider=St.+Mary&max_price=100"),
+              "HTTP/1.1 200"
+              R"([{"id":1,"procedure_code":"80053","description":"Metabolic panel",)"
+              R"("provider":"St. Mary","region":"OH","price":42.5,"metadata":"mri"}])");
+    EXPECT_EQ(get("/costs?region=PA&q=walk"), get("/costs?procedure=70551&max_price=1000"));
+    EXPECT_EQ(get("/costs?min_price=abc").substr(0, 12), "HTTP/1.1 400");
+
+    // Full text covers payload strings of JSON and plain-text documents
+    EXPECT_EQ(get("/search?q=imaging&limit=10").substr(0, 12), "HTTP/1.1 200");
+    EXPECT_NE(get("/search?q=imaging").find(R"({"id":2,"metadata":"clinic"})"), std::string::npos);
+    EXPECT_NE(get("/search?q=imaging").find(R"({"id":3,"metadata":"note"})"), std::string::npos);
+    EXPECT_EQ(get("/search?q=%22MRI%20brain%22"), R"(HTTP/1.1 200[{"id":1,"metadata":"mri"}])");
+    EXPECT_EQ(get("/search?q=AND+OR").substr(0, 12), "HTTP/1.1 400");
+    EXPECT_EQ(get("/search").substr(0, 12), "HTTP/1.1 400");
+
+    // A removal drops the document's index rows in the same merge
+    const auto hash = rxrevoltchain::util::hashing::sha256Raw(clinic);
+    auto removal =
+        makeTransaction("removal_request", "", std::vector<uint8_t>(hash.begin(), hash.end()));
+    removal.SetSignature({0x01}); // target by content hash only
+    ASSERT_TRUE(queue.AddTransaction(removal));
+    ASSERT_TRUE(snapshot.MergePendingDocuments());
+    EXPECT_EQ(get("/costs?procedure=70551&limit=5"),
+              "HTTP/1.1 200"
+              R"([{"id":1,"procedure_code":"70551","description":"MRI brain",)"
+              R"("provider":"St. Mary","region":"OH","price":1250,"metadata":"mri"}])");
+    EXPECT_EQ(get("/search?q=walk"), "HTTP/1.1 200[]");
+    server.Stop();
+
+    // Snapshots from before the index are indexed once when opened
+    snapshot.CloseDatabase();
+    sqlite3* raw = nullptr;
+    ASSERT_EQ(sqlite3_open(db.c_str(), &raw), SQLITE_OK);
+    ASSERT_EQ(sqlite3_exec(raw,
+                           "DROP TABLE cost_items; DROP TABLE documents_fts;"
+                           " PRAGMA user_version=2;",
+                           nullptr, nullptr, nullptr),
+              SQLITE_OK);
+    sqlite3_close(raw);
+    ASSERT_TRUE(queue.AddTransaction(
+        makeTransaction("document_submission", "late", bytes(R"({"cpt":"99213","price":75})"))));
+    ASSERT_TRUE(snapshot.MergePendingDocuments());
+    ASSERT_TRUE(server.Start());
+    const std::string all = get("/costs");
+    EXPECT_NE(all.find(R"("procedure_code":"99213")"), std::string::npos);
+    EXPECT_NE(all.find(R"("procedure_code":"80053")"), std::string::npos);
+    EXPECT_NE(get("/search?q=brain").find(R"("id":1)"), std::string::npos);
+
+    server.Stop();
+    snapshot.CloseDatabase();
+    std::remove(wal.c_str());
+    std::remove(db.c_str());
+    std::remove((db + "-wal").c_str());
+    std::remove((db + "-shm").c_str());
+}
+
+// The SSSE3 encoder matches the scalar one for every length and byte value
+TEST(Base64Test, VectorizedMatchesScalar) {
+    namespace base64 = rxrevoltchain::util::base64;
+    EXPECT_EQ(base64::encode(reinterpret_cast<const uint8_t*>("foobar"), 6), "Zm9vYmFy");
+    EXPECT_EQ(base64::encode(reinterpret_cast<const uint8_t*>("foob"), 4), "Zm9vYg==");
+    EXPECT_EQ(base64::encode(reinterpret_cast<const uint8_t*>("fooba"), 5), "Zm9vYmE=");
+    if (!base64::backendAvailable(base64::Backend::Ssse3)) {
+        GTEST_SKIP() << "SSSE3 not available";
+    }
+    std::vector<uint8_t> data(3 * 256 + 100);
+    for (size_t i = 0; i < data.size(); ++i)
+        data[i] = static_cast<uint8_t>(i < 768 ? i / 3 : i * 151 + 7);
+    const base64::Backend previous = base64::backend();
+    for (size_t len = 0; len <= data.size(); len += (len < 64 ? 1 : 37)) {
+        base64::setBackend(base64::Backend::Scalar);
+        const std::string scalar = base64::encode(data.data(), len);
+        base64::setBackend(base64::Backend::Ssse3);
+        ASSERT_EQ(base64::encode(data.data(), len), scalar) << "length " << len;
+    }
+    base64::setBackend(previous);
+}
+
+// Sharded counters sum every thread's increments; the registry renders counters, gauges,
+// histograms and scrape-time collectors in Prometheus text format
+TEST(MetricsTest, ShardedCountersAndPrometheusText) {
+    using namespace rxrevoltchain::util::metrics;
+    Registry registry;
+    Counter& hits = registry.counter("test_hits_total", "Hits.", "kind=\"a\"");
+    EXPECT_EQ(&registry.counter("test_hits_total", "Hits.", "kind=\"a\""), &hits);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&hits]() {
+            for (int i = 0; i < 10000; ++i)
+                hits.inc();
+        });
+    }
+    for (auto& th : threads)
+        th.join();
+    EXPECT_EQ(hits.value(), (uint64_t)40000);
+
+    registry.gauge("test_depth", "Depth.").set(2.5);
+    Histogram& latency = registry.histogram("test_latency_seconds", "Latency.", {0.1, 1});
+    for (double v : {0.05, 0.5, 0.7, 3.0})
+        latency.observe(v);
+    EXPECT_EQ(latency.count(), (uint64_t)4);
+
+    size_t collector = registry.addCollector("test_peer_bytes", "Per peer.", [](auto& out) {
+        out.emplace_back(Registry::label("peer", "a\"b"), 7);
+    });
+
+    const std::string text = registry.renderPrometheus();
+    auto has = [&](const std::string& line) { return text.find(line + "\n") != std::string::npos; };
+    EXPECT_TRUE(has("# TYPE test_hits_total counter"));
+    EXPECT_TRUE(has("test_hits_total{kind=\"a\"} 40000"));
+    EXPECT_TRUE(has("# TYPE test_depth gauge"));
+    EXPECT_TRUE(has("test_depth 2.5"));
+    EXPECT_TRUE(has("# TYPE test_latency_seconds histogram"));
+    EXPECT_TRUE(has("test_latency_seconds_bucket{le=\"0.1\"} 1"));
+    EXPECT_TRUE(has("test_latency_seconds_bucket{le=\"1\"} 3"));
+    EXPECT_TRUE(has("test_latency_seconds_bucket{le=\"+Inf\"} 4"));
+    EXPECT_TRUE(has("test_latency_seconds_sum 4.25"));
+    EXPECT_TRUE(has("test_latency_seconds_count 4"));
+    EXPECT_TRUE(has("test_peer_bytes{peer=\"a\\\"b\"} 7"));
+
+    registry.removeCollector(collector);
+    EXPECT_EQ(registry.renderPrometheus().find("test_peer_bytes"), std::string::npos);
+
+    // The node-wide registry tracks the document queue and the served snapshot
+    Registry& global = Registry::getInstance();
+    Gauge& depth = global.gauge("rxrevolt_document_queue_depth", "");
+    const std::string wal = "metrics_queue.wal";
+    std::remove(wal.c_str());
+    {
+        rxrevoltchain::core::DocumentQueue queue(wal);
+        const double before = depth.value();
+        ASSERT_TRUE(queue.AddTransaction(makeTransaction("document_submission", "m", {1})));
+        ASSERT_TRUE(queue.AddTransaction(makeTransaction("document_submission", "m", {2})));
+        EXPECT_EQ(depth.value(), before + 2);
+        queue.FetchAll();
+        EXPECT_EQ(depth.value(), before);
+    }
+    std::remove(wal.c_str());
+
+    const std::string db = "metrics_query.sqlite";
+    std::remove(db.c_str());
+    sqlite3* h = nullptr;
+    ASSERT_EQ(sqlite3_open(db.c_str(), &h), SQLITE_OK);
+    ASSERT_EQ(sqlite3_exec(h,
+                           "CREATE TABLE documents (id INTEGER PRIMARY KEY, metadata TEXT, "
+                           "payload BLOB); INSERT INTO documents (metadata) VALUES ('a'), ('b');",
+                           nullptr, nullptr, nullptr),
+              SQLITE_OK);
+    sqlite3_close(h);
+    rxrevoltchain::network::HttpQueryServer server(db, 0);
+    const std::string scraped = server.RenderMetrics();
+    EXPECT_NE(scraped.find("\nrxrevolt_snapshot_documents 2\n"), std::string::npos);
+    EXPECT_NE(scraped.find("# TYPE rxrevolt_document_queue_depth gauge"), std::string::npos);
+    std::remove(db.c_str());
+}
+
 TEST(RewardSchedulerTest, StreakPenalty) {
     rxrevoltchain::consensus::RewardScheduler rs;
     rs.SetBaseDailyReward(100);
@@ -346,6 +2606,113 @@ TEST(RewardSchedulerTest, StreakPenalty) {
     EXPECT_EQ(rs.GetNodeStreak("node1"), (uint64_t)1);
 }
 
+// Lazy decay and settlement give the streaks and balances of the per-round walk over every
+// node (up to one token of rounding per distribution), and survive a reload from the
+// checkpoint plus log, including a torn log tail and the old text format
+TEST(RewardSchedulerTest, LazyDecayMatchesEagerAndPersists) {
+    using rxrevoltchain::consensus::RewardScheduler;
+    const std::string file = "reward_store_test.dat";
+    auto cleanup = [&] {
+        for (const auto& f : {file, file + ".log", file + ".tmp"}) {
+            std::remove(f.c_str());
+        }
+    };
+    cleanup();
+
+    std::map<std::string, uint64_t> streaks, balances; // eager reference
+    uint64_t pool = 0;
+    size_t distributions = 0;
+    RewardScheduler memory;
+    auto persisted = std::make_unique<RewardScheduler>(file);
+    memory.SetBaseDailyReward(1000);
+    persisted->SetBaseDailyReward(1000);
+
+    std::mt19937 rng(29);
+    for (int round = 0; round < 300; ++round) {
+        std::vector<std::string> passing;
+        for (int n = 0; n < 400; ++n) {
+            if (rng() % 4 == 0) {
+                passing.push_back("node" + std::to_string(n));
+            }
+        }
+        const std::set<std::string> passed(passing.begin(), passing.end());
+        for (auto& s : streaks) {
+            if (!passed.count(s.first) && s.second > 0) {
+                --s.second;
+            }
+        }
+        for (const auto& id : passing) {
+            ++streaks[id];
+        }
+        pool += 1000;
+        memory.RecordPassingNodes(passing);
+        persisted->RecordPassingNodes(passing);
+
+        if (round % 3 != 1) {
+            uint64_t total = 0;
+            for (const auto& s : streaks) {
+                total += s.second;
+            }
+            for (const auto& s : streaks) {
+                balances[s.first] += static_cast<uint64_t>(double(pool) * s.second / total);
+            }
+            pool = 0;
+            ++distributions;
+            EXPECT_TRUE(memory.DistributeRewards());
+            EXPECT_TRUE(persisted->DistributeRewards());
+        }
+        if (round == 150) {
+            // Restart, with half a record at the end of the log
+            persisted.reset();
+            std::ofstream(file + ".log", std::ios::binary | std::ios::app).write("\x10\0\0", 3);
+            persisted = std::make_unique<RewardScheduler>(file);
+            persisted->SetBaseDailyReward(1000);
+        }
+    }
+    EXPECT_EQ(memory.GetEpoch(), (uint64_t)300);
+    EXPECT_EQ(memory.NodeCount(), streaks.size());
+    EXPECT_EQ(memory.GetCurrentRewardPool(), pool);
+    for (const auto& s : streaks) {
+        EXPECT_EQ(memory.GetNodeStreak(s.first), s.second) << s.first;
+        const uint64_t lazy = memory.GetBalance(s.first);
+        EXPECT_GE(lazy, balances[s.first]) << s.first;
+        EXPECT_LE(lazy, balances[s.first] + distributions) << s.first;
+    }
+
+    // Reloading from disk gives exactly the in-memory state
+    persisted.reset();
+    RewardScheduler reloaded(file);
+    EXPECT_EQ(reloaded.GetEpoch(), memory.GetEpoch());
+    EXPECT_EQ(reloaded.GetCurrentRewardPool(), memory.GetCurrentRewardPool());
+    for (const auto& s : streaks) {
+        EXPECT_EQ(reloaded.GetNodeStreak(s.first), s.second);
+        EXPECT_EQ(reloaded.GetBalance(s.first), memory.GetBalance(s.first));
+    }
+    ASSERT_TRUE(reloaded.Checkpoint());
+    RewardScheduler fromCheckpoint(file);
+    EXPECT_EQ(fromCheckpoint.GetBalance("node7"), memory.GetBalance("node7"));
+    EXPECT_EQ(fromCheckpoint.GetNodeStreak("node7"), memory.GetNodeStreak("node7"));
+
+    // The previous text format is converted on load
+    cleanup();
+    std::ofstream(file) << "legacyA 3 40\nlegacyB 0 7\n";
+    {
+        RewardScheduler legacy(file);
+        EXPECT_EQ(legacy.GetNodeStreak("legacyA"), (uint64_t)3);
+        EXPECT_EQ(legacy.GetBalance("legacyA"), (uint64_t)40);
+        EXPECT_EQ(legacy.GetBalance("legacyB"), (uint64_t)7);
+        legacy.RecordPassingNodes({"legacyB"});
+        EXPECT_EQ(legacy.GetNodeStreak("legacyA"), (uint64_t)2);
+        EXPECT_EQ(legacy.GetNodeStreak("legacyB"), (uint64_t)1);
+    }
+    std::ifstream converted(file, std::ios::binary);
+    std::string magic(4, '\0');
+    converted.read(&magic[0], 4);
+    EXPECT_EQ(magic, "RXRS");
+    EXPECT_EQ(RewardScheduler(file).GetNodeStreak("legacyB"), (uint64_t)1);
+    cleanup();
+}
+
 // Integration test that exercises PoP consensus with the reward scheduler.
 // Two nodes respond to a challenge and rewards are split between them.
 TEST(IntegrationTest, MultiNodeRewardDistribution) {
@@ -377,6 +2744,707 @@ TEST(IntegrationTest, MultiNodeRewardDistribution) {
     EXPECT_EQ(sched.GetBalance("nodeB"), (uint64_t)50);
 
     std::remove(file.c_str());
+    std::remove((file + ".merkle").c_str());
+}
+
+// Minimal HTTP/1.1 server for the IPFS client tests. Each connection is served until the
+// client closes it; the handler sees the request head and body and returns the reply,
+// or a reply with answer=false to read the request but never respond (close=true ends
+// the connection after replying).
+class StubHttpServer {
+  public:
+    struct Reply {
+        int status = 200;
+        std::string body;
+        bool answer = true;
+        bool close = false; // send "Connection: close" and hang up after the reply
+    };
+    using Handler = std::function<Reply(const std::string& head, const std::string& body)>;
+
+    StubHttpServer(uint16_t port, Handler handler) : m_handler(std::move(handler)) {
+        m_listener = ::socket(AF_INET, SOCK_STREAM, 0);
+        int yes = 1;
+        ::setsockopt(m_listener, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+        if (::bind(m_listener, (sockaddr*)&addr, sizeof(addr)) < 0 ||
+            ::listen(m_listener, 16) < 0) {
+            ::close(m_listener);
+            m_listener = -1;
+            return;
+        }
+        m_acceptor = std::thread([this] { acceptLoop(); });
+    }
+    ~StubHttpServer() { Stop(); }
+
+    bool Listening() const { return m_listener >= 0; }
+    int Accepted() const { return m_accepted.load(); }
+    int MaxInFlight() const { return m_maxInFlight.load(); }
+
+    void Stop() {
+        if (m_listener < 0) {
+            return;
+        }
+        ::shutdown(m_listener, SHUT_RDWR); // wakes the acceptor
+        m_acceptor.join();
+        ::close(m_listener);
+        m_listener = -1;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto& t : m_connections) {
+            t.join();
+        }
+    }
+
+  private:
+    void acceptLoop() {
+        for (;;) {
+            int conn = ::accept(m_listener, nullptr, nullptr);
+            if (conn < 0) {
+                return;
+            }
+            ++m_accepted;
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_connections.emplace_back([this, conn] {
+                serve(conn);
+                ::close(conn);
+            });
+        }
+    }
+
+    void serve(int conn) {
+        timeval tv{5, 0};
+        ::setsockopt(conn, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        std::string buf;
+        char chunk[65536];
+        auto fill = [&](size_t want) {
+            while (buf.size() < want) {
+                ssize_t n = ::recv(conn, chunk, sizeof(chunk), 0);
+                if (n <= 0) {
+                    return false;
+                }
+                buf.append(chunk, n);
+            }
+            return true;
+        };
+        for (;;) {
+            size_t headerEnd;
+            while ((headerEnd = buf.find("\r\n\r\n")) == std::string::npos) {
+                if (!fill(buf.size() + 1)) {
+                    return;
+                }
+            }
+            std::string head = buf.substr(0, headerEnd);
+            std::string lower = head;
+            std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+            size_t length = 0;
+            size_t cl = lower.find("content-length:");
+            if (cl != std::string::npos) {
+                length = std::stoul(head.substr(cl + 15));
+            }
+            if (!fill(headerEnd + 4 + length)) {
+                return;
+            }
+            std::string body = buf.substr(headerEnd + 4, length);
+            buf.erase(0, headerEnd + 4 + length);
+
+            int now = ++m_inFlight;
+            for (int seen = m_maxInFlight.load(); now > seen;) {
+                m_maxInFlight.compare_exchange_weak(seen, now);
+            }
+            Reply reply = m_handler(head, body);
+            --m_inFlight;
+            if (!reply.answer) {
+                while (::recv(conn, chunk, sizeof(chunk), 0) > 0) {
+                }
+                return;
+            }
+            std::string out = "HTTP/1.1 " + std::to_string(reply.status) +
+                              " Stub\r\nContent-Type: application/json\r\nContent-Length: " +
+                              std::to_string(reply.body.size()) +
+                              (reply.close ? "\r\nConnection: close" : "") + "\r\n\r\n" +
+                              reply.body;
+            ::send(conn, out.data(), out.size(), MSG_NOSIGNAL);
+            if (reply.close) {
+                return;
+            }
+        }
+    }
+
+    Handler m_handler;
+    int m_listener = -1;
+    std::thread m_acceptor;
+    std::mutex m_mutex;
+    std::vector<std::thread> m_connections;
+    std::atomic<int> m_accepted{0};
+    std::atomic<int> m_inFlight{0};
+    std::atomic<int> m_maxInFlight{0};
+};
+
+// Uploads are streamed from disk over one pooled keep-alive connection; stalls abort
+TEST(IPFSPinnerTest, StreamingUploadReusesConnection) {
+    const uint16_t port = 39416;
+    std::mutex bodyMutex;
+    std::vector<std::string> bodies;
+    StubHttpServer server(port, [&](const std::string& head, const std::string& body) {
+        {
+            std::lock_guard<std::mutex> lock(bodyMutex);
+            bodies.push_back(body);
+        }
+        StubHttpServer::Reply reply;
+        reply.answer = head.find(" /stall") == std::string::npos;
+        reply.body = head.find("/pin/ls") != std::string::npos
+                         ? "{\"Keys\":{\"QmStub\":{\"Type\":\"recursive\"}}}"
+                         : "{\"Name\":\"f\",\"Hash\":\"QmStub\",\"Size\":\"1\"}";
+        return reply;
+    });
+    if (!server.Listening()) {
+        GTEST_SKIP() << "cannot listen on 127.0.0.1:" << port;
+    }
+
+    const std::string file = "ipfs_stream_test.bin";
+    std::string content(6 * 1024 * 1024 + 123, '\0');
+    for (size_t i = 0; i < content.size(); ++i) {
+        content[i] = static_cast<char>((i * 2654435761u) >> 13);
+    }
+    {
+        std::ofstream out(file, std::ios::binary);
+        out.write(content.data(), content.size());
+    }
+
+    auto ownedPool = std::make_unique<rxrevoltchain::util::CurlHandlePool>(4);
+    rxrevoltchain::util::CurlHandlePool& pool = *ownedPool;
+    const std::string endpoint = "http://127.0.0.1:" + std::to_string(port);
+    {
+        rxrevoltchain::ipfs_integration::IPFSPinner pinner(endpoint, pool);
+        EXPECT_EQ(pinner.PinSnapshot(file), "QmStub");
+        const std::vector<uint8_t> small = {'d', 'e', 'l', 't', 'a'};
+        EXPECT_EQ(pinner.PinData("snap.delta", small), "QmStub");
+        EXPECT_TRUE(pinner.VerifyPin("QmStub"));
+        EXPECT_EQ(pinner.PinSnapshot("does_not_exist.sqlite"), "");
+    }
+    {
+        std::lock_guard<std::mutex> lock(bodyMutex);
+        ASSERT_EQ(bodies.size(), 3u);
+        EXPECT_NE(bodies[0].find(content), std::string::npos);
+        EXPECT_NE(bodies[1].find("delta"), std::string::npos);
+    }
+    EXPECT_EQ(pool.createdCount(), 1u);
+    EXPECT_EQ(pool.idleCount(), 1u);
+    EXPECT_EQ(server.Accepted(), 1);
+
+    // No total timeout, but a request that stops making progress is abandoned
+    {
+        rxrevoltchain::ipfs_integration::IPFSPinner pinner(endpoint + "/stall", pool);
+        pinner.SetTimeouts(2, 1);
+        auto start = std::chrono::steady_clock::now();
+        EXPECT_EQ(pinner.PinSnapshot(file), "");
+        EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+    }
+
+    ownedPool.reset(); // closes the kept-alive connection
+    server.Stop();
+    std::remove(file.c_str());
+}
+
+// Batch pin checks: concurrent per-CID queries for small sets, one streamed listing for
+// large ones, both parsed as JSON rather than by substring search
+TEST(IPFSPinnerTest, BatchVerifyPins) {
+    using Status = rxrevoltchain::ipfs_integration::IPFSPinner::PinStatus;
+    const uint16_t port = 39417;
+    auto isPinned = [](const std::string& cid) {
+        return cid.size() > 6 && (cid.back() - '0') % 2 == 0;
+    };
+    std::atomic<int> listings{0};
+    std::atomic<bool> typeFiltered{false};
+    StubHttpServer server(port, [&](const std::string& head, const std::string&) {
+        StubHttpServer::Reply reply;
+        std::string target = head.substr(head.find(' ') + 1);
+        target = target.substr(0, target.find(' '));
+        if (target.find("stream=true") != std::string::npos) {
+            ++listings;
+            // The listing must not be narrowed to one pin type
+            typeFiltered = typeFiltered || target.find("type=") != std::string::npos;
+            // Every even CID, plus CIDs outside the batch, one object per line, pinned
+            // recursively, directly or as part of another pin
+            static const char* types[] = {"recursive", "direct", "indirect"};
+            for (int i = 0; i < 4000; ++i) {
+                std::string cid = "QmPin" + std::to_string(i);
+                if (isPinned(cid)) {
+                    reply.body += "{\"Cid\":\"" + cid + "\",\"Type\":\"" + types[i % 3] +
+                                  "\"}\n";
+                }
+            }
+            return reply;
+        }
+        std::string cid = target.substr(target.find("arg=") + 4);
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+        if (cid == "QmGarbage") {
+            reply.body = "{\"Keys\": [unterminated";
+        } else if (cid == "QmInvalid") {
+            reply.status = 500;
+            reply.body = "{\"Message\":\"invalid path \\\"QmInvalid\\\"\",\"Code\":0}";
+        } else if (isPinned(cid)) {
+            reply.body = "{\"Keys\":{\"" + cid + "\":{\"Type\":\"recursive\"}}}";
+        } else {
+            reply.status = 500;
+            reply.body = "{\"Message\":\"path '" + cid + "' is not pinned\",\"Code\":0," +
+                         "\"Type\":\"error\"}";
+        }
+        return reply;
+    });
+    if (!server.Listening()) {
+        GTEST_SKIP() << "cannot listen on 127.0.0.1:" << port;
+    }
+
+    auto pool = std::make_unique<rxrevoltchain::util::CurlHandlePool>(8);
+    {
+        rxrevoltchain::ipfs_integration::IPFSPinner pinner(
+            "http://127.0.0.1:" + std::to_string(port), *pool);
+        pinner.SetBatchOptions(4, 64);
+
+        std::vector<std::string> few = {"QmPin10", "QmPin11", "QmPin12", "QmPin13",
+                                        "QmPin14", "QmPin15", "QmGarbage", "QmInvalid"};
+        auto status = pinner.VerifyPins(few);
+        ASSERT_EQ(status.size(), few.size());
+        EXPECT_EQ(status["QmPin10"], Status::Pinned);
+        EXPECT_EQ(status["QmPin11"], Status::NotPinned);
+        EXPECT_EQ(status["QmPin14"], Status::Pinned);
+        EXPECT_EQ(status["QmPin15"], Status::NotPinned);
+        EXPECT_EQ(status["QmGarbage"], Status::Unknown);
+        EXPECT_EQ(status["QmInvalid"], Status::Unknown);
+        EXPECT_GT(server.MaxInFlight(), 1);
+        EXPECT_LE(server.MaxInFlight(), 4);
+        EXPECT_EQ(listings.load(), 0);
+
+        std::vector<std::string> many;
+        for (int i = 0; i < 500; ++i) {
+            many.push_back("QmPin" + std::to_string(i * 7));
+        }
+        status = pinner.VerifyPins(many);
+        EXPECT_EQ(listings.load(), 1);
+        EXPECT_FALSE(typeFiltered.load());
+        ASSERT_EQ(status.size(), many.size());
+        for (const auto& cid : many) {
+            EXPECT_EQ(status[cid], isPinned(cid) ? Status::Pinned : Status::NotPinned) << cid;
+        }
+        EXPECT_TRUE(pinner.VerifyPins({}).empty());
+    }
+    pool.reset();
+    server.Stop();
+}
+
+// A snapshot pinned as a delta keeps the whole file's CID current (PoP challenges it) and
+// records the delta separately; the next delta names the delta as its base
+TEST(DailySnapshotTest, DeltaPinRecordsFullCid) {
+    using rxrevoltchain::ipfs_integration::SnapshotDelta;
+    const uint16_t port = 39420;
+    std::atomic<int> uploads{0};
+    StubHttpServer server(port, [&](const std::string& head, const std::string&) {
+        StubHttpServer::Reply reply;
+        reply.close = true; // DailySnapshot pins through the shared curl pool
+        const int n = ++uploads;
+        const bool onlyHash = head.find("only-hash=true") != std::string::npos;
+        reply.body = std::string("{\"Name\":\"f\",\"Hash\":\"") +
+                     (onlyHash ? "QmWhole" : "QmPin") + std::to_string(n) + "\"}";
+        return reply;
+    });
+    if (!server.Listening()) {
+        GTEST_SKIP() << "cannot listen on 127.0.0.1:" << port;
+    }
+
+    const std::string wal = "delta_pin.wal";
+    const std::string db = "delta_pin.sqlite";
+    for (const auto& f : {wal, db, SnapshotDelta::BasePathFor(db), db + ".merkle"}) {
+        std::remove(f.c_str());
+    }
+    rxrevoltchain::core::DocumentQueue queue(wal);
+    rxrevoltchain::core::PinnedState state;
+    rxrevoltchain::core::DailySnapshot snapshot(db);
+    snapshot.SetDocumentQueue(&queue);
+    snapshot.SetPinnedState(&state);
+    snapshot.SetIPFSEndpoint("http://127.0.0.1:" + std::to_string(port));
+    snapshot.SetDeltaMaxChain(2);
+    int next = 0;
+    auto submit = [&](int count) {
+        for (int n = 0; n < count; ++n, ++next) {
+            std::vector<uint8_t> body(600);
+            for (size_t b = 0; b < body.size(); ++b) {
+                body[b] = static_cast<uint8_t>((next * 131 + b * 7919) >> 3);
+            }
+            queue.AddTransaction(
+                makeTransaction("document_submission", "doc" + std::to_string(next), body));
+        }
+        ASSERT_TRUE(snapshot.MergePendingDocuments());
+    };
+
+    // The first pin uploads the whole file
+    submit(2000);
+    ASSERT_TRUE(snapshot.PinCurrentSnapshot());
+    EXPECT_EQ(state.GetCurrentCID(), "QmPin1");
+    EXPECT_EQ(state.GetDeltaCID(), "");
+
+    // The second is a delta: its CID is recorded apart from the file's own CID
+    submit(20);
+    ASSERT_TRUE(snapshot.PinCurrentSnapshot());
+    EXPECT_EQ(uploads.load(), 3);
+    EXPECT_EQ(state.GetDeltaCID(), "QmPin2");
+    EXPECT_EQ(state.GetCurrentCID(), "QmWhole3");
+    EXPECT_EQ(state.GetLocalFilePath(), db);
+    SnapshotDelta::BaseRecord base;
+    ASSERT_TRUE(SnapshotDelta::LoadBase(SnapshotDelta::BasePathFor(db), base));
+    EXPECT_EQ(base.cid, "QmPin2");
+    EXPECT_EQ(base.depth, 1u);
+
+    snapshot.CloseDatabase();
+    for (const auto& f : {wal, db, SnapshotDelta::BasePathFor(db), db + ".merkle"}) {
+        std::remove(f.c_str());
+    }
+}
+
+// A cycle holds no lock the setters need; the pin, validation and next PoP tree overlap,
+// the recorded CID is the pinned one and the following cycle challenges it
+TEST(DailySchedulerTest, PipelinedCycle) {
+    const uint16_t port = 39418;
+    std::atomic<bool> release{false};
+    std::atomic<int> uploads{0};
+    StubHttpServer server(port, [&](const std::string& head, const std::string&) {
+        StubHttpServer::Reply reply;
+        reply.close = true; // the scheduler pins through the shared curl pool
+        if (head.find("/api/v0/add") != std::string::npos) {
+            const int n = ++uploads;
+            // Hold the first upload so the test can act while the cycle is mid-pin
+            for (int i = 0; n == 1 && !release && i < 1000; ++i) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            reply.body = "{\"Name\":\"f\",\"Hash\":\"QmCycle" + std::to_string(n) + "\"}";
+        } else {
+            reply.body = "{}";
+        }
+        return reply;
+    });
+    if (!server.Listening()) {
+        GTEST_SKIP() << "cannot listen on 127.0.0.1:" << port;
+    }
+
+    const std::string dir = "sched_cycle_test";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    const std::string db = dir + "/data.sqlite";
+    const std::string endpoint = "http://127.0.0.1:" + std::to_string(port);
+    auto countRows = [&db]() {
+        sqlite3* sdb = nullptr;
+        EXPECT_EQ(sqlite3_open_v2(db.c_str(), &sdb, SQLITE_OPEN_READONLY, nullptr), SQLITE_OK);
+        sqlite3_stmt* stmt = nullptr;
+        sqlite3_prepare_v2(sdb, "SELECT COUNT(*) FROM documents", -1, &stmt, nullptr);
+        int count = (sqlite3_step(stmt) == SQLITE_ROW) ? sqlite3_column_int(stmt, 0) : -1;
+        sqlite3_finalize(stmt);
+        sqlite3_close(sdb);
+        return count;
+    };
+
+    rxrevoltchain::core::DocumentQueue queue(dir + "/queue.wal");
+    for (int i = 0; i < 25; ++i) {
+        const std::string text = "SSN 123-45-678" + std::to_string(i % 10);
+        queue.AddTransaction(makeTransaction("document_submission", "doc" + std::to_string(i),
+                                             std::vector<uint8_t>(text.begin(), text.end())));
+    }
+
+    rxrevoltchain::pinner::DailyScheduler sched;
+    sched.ConfigureInterval(std::chrono::hours(1));
+    sched.SetDataDirectory(dir);
+    sched.SetIPFSEndpoint(endpoint);
+    sched.SetDocumentQueue(&queue);
+    ASSERT_TRUE(sched.StartScheduling());
+
+    for (int i = 0; uploads == 0 && i < 1000; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT_EQ(uploads.load(), 1);
+    const auto start = std::chrono::steady_clock::now();
+    sched.ConfigureInterval(std::chrono::hours(1));
+    sched.SetIPFSEndpoint(endpoint);
+    sched.SetDeltaMaxChain(0);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(500));
+    release = true;
+    EXPECT_TRUE(sched.StopScheduling());
+
+    EXPECT_EQ(sched.GetPinnedState().GetCurrentCID(), "QmCycle1");
+    // The live file is merged into; the sealed copy is what gets pinned and challenged
+    const std::string sealed = rxrevoltchain::pinner::DailyScheduler::SealedSnapshotPath(dir);
+    EXPECT_EQ(sched.GetPinnedState().GetLocalFilePath(), sealed);
+    EXPECT_EQ(countRows(), 25);
+    // The tree for the next PoP round was built during the pin
+    EXPECT_TRUE(std::filesystem::exists(
+        rxrevoltchain::ipfs_integration::MerkleTreeCache::CachePathFor(sealed)));
+    struct stat firstSeal;
+    ASSERT_EQ(stat(sealed.c_str(), &firstSeal), 0);
+
+    // Second cycle: the round challenges QmCycle1 while QmCycle2 is merged and pinned
+    for (int i = 0; i < 10; ++i) {
+        queue.AddTransaction(makeTransaction("document_submission", "more", {uint8_t(i)}));
+    }
+    ASSERT_TRUE(sched.StartScheduling());
+    for (int i = 0; uploads < 2 && i < 1000; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_TRUE(sched.StopScheduling());
+    EXPECT_EQ(sched.GetPinnedState().GetCurrentCID(), "QmCycle2");
+    EXPECT_EQ(countRows(), 35);
+    auto history = sched.GetConsensus().GetChallengeHistory();
+    ASSERT_FALSE(history.empty());
+    EXPECT_EQ(history.back().cid, "QmCycle1");
+    // The second seal replaced the file the round challenged instead of rewriting it
+    struct stat secondSeal;
+    ASSERT_EQ(stat(sealed.c_str(), &secondSeal), 0);
+    EXPECT_NE(secondSeal.st_ino, firstSeal.st_ino);
+    EXPECT_FALSE(std::filesystem::exists(sealed + ".tmp"));
+
+    server.Stop();
+    std::filesystem::remove_all(dir);
+}
+
+// Micro-batches reach the live file by size or time; the cycle pins a sealed copy
+TEST(DailySchedulerTest, MicroBatchIngestion) {
+    const std::string dir = "sched_batch_test";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    const std::string live = dir + "/data.sqlite";
+    const std::string sealed = rxrevoltchain::pinner::DailyScheduler::SealedSnapshotPath(dir);
+    auto countRows = [](const std::string& db) {
+        sqlite3* sdb = nullptr;
+        if (sqlite3_open_v2(db.c_str(), &sdb, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK) {
+            sqlite3_close(sdb);
+            return -1;
+        }
+        sqlite3_stmt* stmt = nullptr;
+        sqlite3_prepare_v2(sdb, "SELECT COUNT(*) FROM documents", -1, &stmt, nullptr);
+        int count = (sqlite3_step(stmt) == SQLITE_ROW) ? sqlite3_column_int(stmt, 0) : -1;
+        sqlite3_finalize(stmt);
+        sqlite3_close(sdb);
+        return count;
+    };
+    auto waitForRows = [&](int rows, std::chrono::milliseconds limit) {
+        const auto deadline = std::chrono::steady_clock::now() + limit;
+        while (countRows(live) != rows && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        return countRows(live) == rows;
+    };
+
+    rxrevoltchain::core::DocumentQueue queue(dir + "/queue.wal");
+    rxrevoltchain::pinner::DailyScheduler sched;
+    sched.ConfigureInterval(std::chrono::hours(1));
+    sched.SetDataDirectory(dir);
+    sched.SetIPFSEndpoint("http://127.0.0.1:1"); // pins fail fast; sealing happens first
+    sched.SetDocumentQueue(&queue);
+    sched.SetMicroBatch(std::chrono::seconds(30), 5);
+    std::atomic<int> commits{0}; // what PinnerNode::SetQueryServer hooks the cache to
+    sched.SetCommitListener([&commits]() { ++commits; });
+    ASSERT_TRUE(sched.StartScheduling());
+    std::this_thread::sleep_for(std::chrono::milliseconds(100)); // first (empty) cycle
+    EXPECT_EQ(commits.load(), 0);
+
+    // A full batch is merged right away, long before the 30 s interval
+    for (int i = 0; i < 5; ++i) {
+        queue.AddTransaction(makeTransaction("document_submission", "b", {uint8_t(i)}));
+    }
+    EXPECT_TRUE(waitForRows(5, std::chrono::seconds(5)));
+    EXPECT_TRUE(queue.IsEmpty());
+    EXPECT_GE(commits.load(), 1);
+    EXPECT_EQ(countRows(sealed), 0); // sealed by the first cycle, before any batch
+    EXPECT_TRUE(sched.StopScheduling());
+
+    // A partial batch waits for the interval
+    sched.SetMicroBatch(std::chrono::milliseconds(50), 5);
+    ASSERT_TRUE(sched.StartScheduling());
+    std::this_thread::sleep_for(std::chrono::milliseconds(100)); // past the cycle's merge
+    for (int i = 0; i < 2; ++i) {
+        queue.AddTransaction(makeTransaction("document_submission", "t", {uint8_t(i)}));
+    }
+    EXPECT_TRUE(waitForRows(7, std::chrono::seconds(5)));
+    EXPECT_TRUE(sched.StopScheduling());
+
+    // The cycle merges the rest and seals the live file into the copy it pins
+    queue.AddTransaction(makeTransaction("document_submission", "last", {0x10}));
+    sched.RunMergeCycle();
+    EXPECT_EQ(countRows(live), 8);
+    EXPECT_EQ(countRows(sealed), 8);
+    EXPECT_FALSE(std::filesystem::exists(sealed + "-wal") &&
+                 std::filesystem::file_size(sealed + "-wal") > 0);
+
+    std::filesystem::remove_all(dir);
+}
+
+// Sharded layout: partitioned merge, per-shard pins under a manifest, PoP on a shard and
+// queries routed or gathered across the shards
+TEST(ShardedSnapshotTest, PartitionPinChallengeAndQuery) {
+    using rxrevoltchain::core::ShardedSnapshot;
+    using rxrevoltchain::network::HttpQueryServer;
+    const uint16_t port = 39419;
+    std::atomic<int> uploads{0};
+    StubHttpServer ipfs(port, [&](const std::string& head, const std::string&) {
+        StubHttpServer::Reply reply;
+        reply.close = true;
+        reply.body = head.find("/api/v0/add") != std::string::npos
+                         ? "{\"Name\":\"f\",\"Hash\":\"QmShard" + std::to_string(++uploads) + "\"}"
+                         : "{}";
+        return reply;
+    });
+    if (!ipfs.Listening()) {
+        GTEST_SKIP() << "cannot listen on 127.0.0.1:" << port;
+    }
+
+    const std::string dir = "sharded_snapshot_test";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    auto bytes = [](const std::string& text) {
+        return std::vector<uint8_t>(text.begin(), text.end());
+    };
+    rxrevoltchain::core::DocumentQueue queue(dir + "/queue.wal");
+    std::vector<size_t> perShard(4, 0);
+    for (int i = 0; i < 40; ++i) {
+        const auto payload = bytes("visit " + std::to_string(i) + (i == 7 ? " imaging" : ""));
+        ++perShard[ShardedSnapshot::ShardOf(payload, 4)];
+        queue.AddTransaction(makeTransaction("document_submission", "d" + std::to_string(i),
+                                             payload));
+    }
+    // The removal reaches every shard; only the one holding the document changes
+    const auto hash = rxrevoltchain::util::hashing::sha256Raw(bytes("visit 3"));
+    auto removal =
+        makeTransaction("removal_request", "", std::vector<uint8_t>(hash.begin(), hash.end()));
+    removal.SetSignature({0x01});
+    queue.AddTransaction(removal);
+    --perShard[ShardedSnapshot::ShardOf(bytes("visit 3"), 4)];
+
+    rxrevoltchain::pinner::DailyScheduler sched;
+    sched.SetDataDirectory(dir);
+    sched.SetIPFSEndpoint("http://127.0.0.1:" + std::to_string(port));
+    sched.SetDocumentQueue(&queue);
+    sched.SetShardCount(4);
+    sched.RunMergeCycle();
+
+    std::vector<std::string> files;
+    for (size_t s = 0; s < 4; ++s) {
+        files.push_back(ShardedSnapshot::ShardPath(dir, s));
+        EXPECT_EQ(HttpQueryServer::GetDocumentCount(files.back()), (int)perShard[s]);
+    }
+    EXPECT_FALSE(std::filesystem::exists(dir + "/data.sqlite"));
+
+    // Four shard pins, then the manifest naming them, whose CID is the snapshot's
+    const auto shards = sched.GetPinnedState().GetShards();
+    ASSERT_EQ(shards.size(), (size_t)4);
+    EXPECT_EQ(uploads.load(), 5);
+    EXPECT_EQ(sched.GetPinnedState().GetCurrentCID(), "QmShard5");
+    EXPECT_EQ(sched.GetPinnedState().GetLocalFilePath(), ShardedSnapshot::ManifestPath(dir));
+    std::ifstream in(ShardedSnapshot::ManifestPath(dir));
+    const std::string manifest((std::istreambuf_iterator<char>(in)),
+                               std::istreambuf_iterator<char>());
+    for (size_t s = 0; s < 4; ++s) {
+        EXPECT_EQ(shards[s].path, ShardedSnapshot::SealedShardPath(dir, s));
+        EXPECT_NE(manifest.find("\"cid\":\"" + shards[s].cid + "\",\"file\":\"data.shard-" +
+                                std::to_string(s) + ".sqlite\""),
+                  std::string::npos);
+    }
+
+    // A PoP round challenges one of the shards with its own CID and file
+    sched.RunPoPCheck();
+    const auto history = sched.GetConsensus().GetChallengeHistory();
+    ASSERT_FALSE(history.empty());
+    EXPECT_NE(history.back().cid.find("QmShard"), std::string::npos);
+    EXPECT_NE(history.back().cid, "QmShard5");
+
+    // The shard count is fixed once the directory holds shards
+    {
+        rxrevoltchain::core::DocumentQueue other(dir + "/other.wal");
+        ShardedSnapshot resharded(dir, 3);
+        resharded.SetDocumentQueue(&other);
+        EXPECT_FALSE(resharded.MergePendingDocuments());
+    }
+
+    HttpQueryServer server(files, 0);
+    ASSERT_TRUE(server.Start());
+    auto get = [&server](const std::string& target) {
+        const std::string response =
+            httpExchange(server.Port(), "GET " + target + " HTTP/1.1\r\nConnection: close\r\n\r\n");
+        return response;
+    };
+    // Ranges walk the shards in order: ids are shard-major and strictly increasing
+    const std::string range = dechunk(get("/records?limit=1000"));
+    std::vector<int64_t> ids;
+    for (size_t pos = 0; (pos = range.find("{\"id\":", pos)) != std::string::npos; pos += 6) {
+        ids.push_back(std::stoll(range.substr(pos + 6)));
+    }
+    ASSERT_EQ(ids.size(), (size_t)39);
+    EXPECT_TRUE(std::is_sorted(ids.begin(), ids.end()));
+    EXPECT_EQ(std::adjacent_find(ids.begin(), ids.end()), ids.end());
+    const size_t imagingShard = ShardedSnapshot::ShardOf(bytes("visit 7 imaging"), 4);
+    const std::string second = dechunk(
+        get("/records?from=" + std::to_string(HttpQueryServer::GlobalId(imagingShard, 0)) +
+            "&to=" + std::to_string(HttpQueryServer::GlobalId(imagingShard, 1000))));
+    EXPECT_EQ(std::count(second.begin(), second.end(), '{'), (long)perShard[imagingShard]);
+
+    // Scatter-gather search, then routing the returned id back to its shard
+    const std::string search = get("/search?q=imaging");
+    const size_t idPos = search.find("[{\"id\":");
+    ASSERT_NE(idPos, std::string::npos);
+    const int64_t id = std::stoll(search.substr(idPos + 7));
+    EXPECT_EQ(id >> HttpQueryServer::SHARD_ID_BITS, (int64_t)imagingShard);
+    EXPECT_NE(search.find("\"metadata\":\"d7\""), std::string::npos);
+    const std::string record = get("/record/" + std::to_string(id));
+    const auto expected = bytes("visit 7 imaging");
+    EXPECT_NE(record.find(rxrevoltchain::util::base64::encode(expected.data(), expected.size())),
+              std::string::npos);
+    EXPECT_EQ(get("/record/" + std::to_string(HttpQueryServer::GlobalId(9, 1))).substr(0, 12),
+              "HTTP/1.1 404");
+    EXPECT_NE(server.RenderMetrics().find("\nrxrevolt_snapshot_documents 39\n"), std::string::npos);
+
+    server.Stop();
+    ipfs.Stop();
+    std::filesystem::remove_all(dir);
+}
+
+// The incremental parser gives the same result however the input is split
+TEST(JsonParserTest, IncrementalFeed) {
+    using rxrevoltchain::util::JsonStreamParser;
+    using rxrevoltchain::util::JsonValue;
+    const std::string text = "{\"Keys\":{\"Qm1\":{\"Type\":\"recursive\"}},\"n\":[-1.5e3,0,42],"
+                             "\"s\":\"a\\\"b\\\\c\\n\\u00e9\\ud83d\\ude00\",\"t\":true,"
+                             "\"f\":false,\"z\":null,\"e\":{},\"a\":[]}\n"
+                             "{\"Cid\":\"Qm2\"} 7";
+    for (size_t step : {text.size(), size_t(1), size_t(3), size_t(7)}) {
+        std::vector<JsonValue> values;
+        JsonStreamParser parser([&](JsonValue&& v) { values.push_back(std::move(v)); });
+        for (size_t i = 0; i < text.size(); i += step) {
+            ASSERT_TRUE(parser.feed(text.data() + i, std::min(step, text.size() - i)));
+        }
+        ASSERT_TRUE(parser.finish()) << parser.error();
+        ASSERT_EQ(values.size(), 3u);
+        const JsonValue& doc = values[0];
+        ASSERT_TRUE(doc.isObject());
+        EXPECT_EQ(doc.find("Keys")->find("Qm1")->find("Type")->asString(), "recursive");
+        ASSERT_EQ(doc.find("n")->items().size(), 3u);
+        EXPECT_DOUBLE_EQ(doc.find("n")->items()[0].asNumber(), -1500.0);
+        EXPECT_DOUBLE_EQ(doc.find("n")->items()[2].asNumber(), 42.0);
+        EXPECT_EQ(doc.find("s")->asString(), "a\"b\\c\n\xc3\xa9\xf0\x9f\x98\x80");
+        EXPECT_TRUE(doc.find("t")->asBool());
+        EXPECT_FALSE(doc.find("f")->asBool());
+        EXPECT_TRUE(doc.find("z")->isNull());
+        EXPECT_TRUE(doc.find("e")->isObject());
+        EXPECT_TRUE(doc.find("a")->isArray());
+        EXPECT_EQ(doc.find("missing"), nullptr);
+        EXPECT_EQ(values[1].find("Cid")->asString(), "Qm2");
+        EXPECT_DOUBLE_EQ(values[2].asNumber(), 7.0);
+    }
+
+    JsonValue out;
+    EXPECT_TRUE(JsonStreamParser::parse("[1, {\"k\": \"v\"}]", out));
+    for (const char* bad : {"{\"a\" 1}", "[1,]", "{\"a\":1", "01", "tru", "\"\\x\"",
+                            "\"\\ud83d\"", "[1] [2]", "\"a\nb\""}) {
+        EXPECT_FALSE(JsonStreamParser::parse(bad, out)) << bad;
+    }
+    EXPECT_FALSE(JsonStreamParser::parse(std::string(100, '[') + std::string(100, ']'), out));
 }
 
 TEST(EHRConnectorTest, SubmitFailsWithoutEndpoint) {